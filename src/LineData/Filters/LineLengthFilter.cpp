@@ -37,7 +37,7 @@ void LineLengthFilter::onDataLoaded(LineDataPtr lineDataIn) {
     maxTrajectoryLength = 0.0f;
     trajectoryLengths.clear();
 
-    lineDataIn->iterateOverTrajectories([this](const Trajectory& trajectory) {
+    lineDataIn->iterateOverTrajectories([this](const TrajectoryView& trajectory) {
         int n = int(trajectory.positions.size());
 
         float trajectoryLength = 0.0f;
@@ -62,7 +62,7 @@ void LineLengthFilter::filterData(LineDataPtr lineDataIn) {
     }
 
     size_t trajectoryIdx = 0;
-    lineDataIn->filterTrajectories([&trajectoryIdx, this](const Trajectory& trajectory) -> bool {
+    lineDataIn->filterTrajectories([&trajectoryIdx, this](const TrajectoryView& trajectory) -> bool {
         float trajectoryLength = trajectoryLengths.at(trajectoryIdx++);
         return trajectoryLength < trajectoryFilteringThresholdMin || trajectoryLength > trajectoryFilteringThresholdMax;
     });
@@ -43,7 +43,7 @@ void MaxLineAttributeFilter::onDataLoaded(LineDataPtr lineDataIn) {
     selectedAttributeIdx = lineDataIn->getSelectedAttributeIndex();
 
     if (!lineDataIn->getAttributeNames().empty()) {
-        lineDataIn->iterateOverTrajectories([this, lineDataIn](const Trajectory& trajectory) {
+        lineDataIn->iterateOverTrajectories([this, lineDataIn](const TrajectoryView& trajectory) {
             int n = int(trajectory.positions.size());
             int attributeIdx = lineDataIn->getSelectedAttributeIndex();
             attributeIdx = std::min(attributeIdx, int(lineDataIn->getNumAttributes()) - 1);
@@ -80,7 +80,7 @@ void MaxLineAttributeFilter::filterData(LineDataPtr lineDataIn) {
     }
 
     size_t trajectoryIdx = 0;
-    lineDataIn->filterTrajectories([this, &trajectoryIdx, lineDataIn](const Trajectory& trajectory) -> bool {
+    lineDataIn->filterTrajectories([this, &trajectoryIdx, lineDataIn](const TrajectoryView& trajectory) -> bool {
         float attributeValue = maxTrajectoryAttributes.at(trajectoryIdx++);
         return attributeValue < trajectoryFilteringThresholdMin || attributeValue > trajectoryFilteringThresholdMax;
     });
@@ -0,0 +1,420 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#ifdef USE_TBB
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+#include <Utils/Parallel/Reduction.hpp>
+#endif
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include <Utils/File/Logfile.hpp>
+
+#include "BrickedGrid.hpp"
+
+/**
+ * Per-thread cache of the most recently used brick of each field slot. This avoids locking the LRU cache mutex for
+ * consecutive samples in the same brick (which is the common case when tracing lines).
+ * The entries do not own the bricks: a brick is freed as soon as it was evicted from the LRU cache (or its grid was
+ * destroyed) and no sampling call uses it anymore, which expires the weak reference of all threads at once.
+ */
+struct BrickLookupEntry {
+    uint64_t gridId = 0;
+    uint64_t brickKey = std::numeric_limits<uint64_t>::max();
+    std::weak_ptr<const std::vector<float>> brick;
+};
+static const int NUM_BRICK_LOOKUP_ENTRIES = 8;
+static thread_local BrickLookupEntry brickLookupCache[NUM_BRICK_LOOKUP_ENTRIES];
+static std::atomic<uint64_t> gridIdCounter{1};
+
+BrickedGrid::BrickedGrid(int brickSize, size_t cacheMemoryBudget)
+        : gridId(gridIdCounter++), brickSize(std::max(brickSize, 1)), brickPointsPerAxis(std::max(brickSize, 1) + 2),
+          cacheMemoryBudget(cacheMemoryBudget) {
+}
+
+BrickedGrid::~BrickedGrid() = default;
+
+bool BrickedGrid::openRawFile(
+        const std::string& filename, int _xs, int _ys, int _zs, int _numChannels,
+        float _dx, float _dy, float _dz, size_t headerSize) {
+    xs = _xs;
+    ys = _ys;
+    zs = _zs;
+    numChannels = _numChannels;
+    dx = _dx;
+    dy = _dy;
+    dz = _dz;
+    bxs = (xs - 1) / brickSize + 1;
+    bys = (ys - 1) / brickSize + 1;
+    bzs = (zs - 1) / brickSize + 1;
+
+    if (!sourceFile.open(filename)) {
+        return false;
+    }
+    size_t numEntries = size_t(xs) * size_t(ys) * size_t(zs) * size_t(numChannels);
+    if (sourceFile.getSize() != headerSize + numEntries * sizeof(float)) {
+        sgl::Logfile::get()->writeError(
+                "Error in BrickedGrid::openRawFile: Inconsistent size of the file \"" + filename + "\".");
+        sourceFile.close();
+        return false;
+    }
+    sourceData = sourceFile.getPointer<float>(headerSize, numEntries);
+    return sourceData != nullptr;
+}
+
+void BrickedGrid::setHelicityNormalization(bool _normalizeVelocity, bool _normalizeVorticity) {
+    normalizeVelocity = _normalizeVelocity;
+    normalizeVorticity = _normalizeVorticity;
+}
+
+int BrickedGrid::addField(const std::string& name, BrickedFieldType type, int channel) {
+    Field field;
+    field.name = name;
+    field.type = type;
+    field.channel = channel;
+    field.numComponents =
+            type == BrickedFieldType::CHANNEL_VECTOR || type == BrickedFieldType::VORTICITY ? 3 : 1;
+    int channelsNeeded = type == BrickedFieldType::CHANNEL_SCALAR ? channel + 1 : (
+            type == BrickedFieldType::CHANNEL_VECTOR ? channel + 3 : 3);
+    if (channelsNeeded > numChannels) {
+        sgl::Logfile::get()->throwError(
+                "Error in BrickedGrid::addField: The field \"" + name + "\" uses more channels than available.");
+    }
+    fields.push_back(field);
+    return int(fields.size()) - 1;
+}
+
+size_t BrickedGrid::getCacheMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return cacheMemoryUsage;
+}
+
+void BrickedGrid::setCacheMemoryBudget(size_t budget) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheMemoryBudget = budget;
+    evictBricks();
+}
+
+void BrickedGrid::evictBricks() const {
+    // Bricks still referenced by other threads stay alive until they are released.
+    while (cacheMemoryUsage > cacheMemoryBudget && lruList.size() > 1) {
+        auto evictIt = cache.find(lruList.back());
+        cacheMemoryUsage -= evictIt->second.brick->size() * sizeof(float);
+        cache.erase(evictIt);
+        lruList.pop_back();
+        numBrickEvictions++;
+    }
+}
+
+/**
+ * Same finite differences as in computeVorticityField (GridLoader.cpp).
+ */
+glm::vec3 BrickedGrid::computeVorticity(int x, int y, int z) const {
+    int left = x > 0 ? -1 : 0;
+    int right = x < xs - 1 ? 1 : 0;
+    int down = y > 0 ? -1 : 0;
+    int up = y < ys - 1 ? 1 : 0;
+    int back = z > 0 ? -1 : 0;
+    int front = z < zs - 1 ? 1 : 0;
+    float dVzdy = (getSourcePoint(x, y + up, z)[2] - getSourcePoint(x, y + down, z)[2]) / (dy * float(up - down));
+    float dVydz = (getSourcePoint(x, y, z + front)[1] - getSourcePoint(x, y, z + back)[1]) / (dz * float(front - back));
+    float dVxdz = (getSourcePoint(x, y, z + front)[0] - getSourcePoint(x, y, z + back)[0]) / (dz * float(front - back));
+    float dVzdx = (getSourcePoint(x + right, y, z)[2] - getSourcePoint(x + left, y, z)[2]) / (dx * float(right - left));
+    float dVydx = (getSourcePoint(x + right, y, z)[1] - getSourcePoint(x + left, y, z)[1]) / (dx * float(right - left));
+    float dVxdy = (getSourcePoint(x, y + up, z)[0] - getSourcePoint(x, y + down, z)[0]) / (dy * float(up - down));
+    return { dVzdy - dVydz, dVxdz - dVzdx, dVydx - dVxdy };
+}
+
+void BrickedGrid::computeBrick(const Field& field, int bx, int by, int bz, Brick& brick) const {
+    const int P = brickPointsPerAxis;
+    const int numComponents = field.numComponents;
+    brick.resize(size_t(P) * size_t(P) * size_t(P) * size_t(numComponents), 0.0f);
+    for (int lz = 0; lz < P; lz++) {
+        int z = bz * brickSize - 1 + lz;
+        if (z < 0 || z >= zs) {
+            continue;
+        }
+        for (int ly = 0; ly < P; ly++) {
+            int y = by * brickSize - 1 + ly;
+            if (y < 0 || y >= ys) {
+                continue;
+            }
+            for (int lx = 0; lx < P; lx++) {
+                int x = bx * brickSize - 1 + lx;
+                if (x < 0 || x >= xs) {
+                    continue;
+                }
+                float* out = brick.data() + (size_t(lx) + size_t(ly) * size_t(P) + size_t(lz) * size_t(P * P))
+                        * size_t(numComponents);
+                const float* point = getSourcePoint(x, y, z);
+                if (field.type == BrickedFieldType::CHANNEL_VECTOR) {
+                    out[0] = point[field.channel];
+                    out[1] = point[field.channel + 1];
+                    out[2] = point[field.channel + 2];
+                } else if (field.type == BrickedFieldType::CHANNEL_SCALAR) {
+                    out[0] = point[field.channel];
+                } else if (field.type == BrickedFieldType::VELOCITY_MAGNITUDE) {
+                    out[0] = std::sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+                } else {
+                    glm::vec3 vorticity = computeVorticity(x, y, z);
+                    if (field.type == BrickedFieldType::VORTICITY) {
+                        out[0] = vorticity.x;
+                        out[1] = vorticity.y;
+                        out[2] = vorticity.z;
+                    } else if (field.type == BrickedFieldType::VORTICITY_MAGNITUDE) {
+                        out[0] = std::sqrt(
+                                vorticity.x * vorticity.x + vorticity.y * vorticity.y + vorticity.z * vorticity.z);
+                    } else {
+                        // Same as computeHelicityFieldNormalized (GridLoader.cpp).
+                        glm::vec3 velocity(point[0], point[1], point[2]);
+                        if (normalizeVelocity) {
+                            float velocityMagnitude = std::sqrt(
+                                    velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z);
+                            if (velocityMagnitude > 1e-6) {
+                                velocity /= velocityMagnitude;
+                            }
+                        }
+                        if (normalizeVorticity) {
+                            float vorticityMagnitude = std::sqrt(
+                                    vorticity.x * vorticity.x + vorticity.y * vorticity.y + vorticity.z * vorticity.z);
+                            if (vorticityMagnitude > 1e-6) {
+                                vorticity /= vorticityMagnitude;
+                            }
+                        }
+                        out[0] = velocity.x * vorticity.x + velocity.y * vorticity.y + velocity.z * vorticity.z;
+                    }
+                }
+            }
+        }
+    }
+}
+
+BrickedGrid::BrickPtr BrickedGrid::getBrick(int fieldIdx, int bx, int by, int bz) const {
+    uint64_t brickKey =
+            uint64_t(fieldIdx) * uint64_t(bxs) * uint64_t(bys) * uint64_t(bzs)
+            + uint64_t(bx) + uint64_t(by) * uint64_t(bxs) + uint64_t(bz) * uint64_t(bxs) * uint64_t(bys);
+
+    BrickLookupEntry& lookupEntry = brickLookupCache[fieldIdx % NUM_BRICK_LOOKUP_ENTRIES];
+    BrickPtr brickPtr;
+    if (lookupEntry.gridId == gridId && lookupEntry.brickKey == brickKey) {
+        brickPtr = lookupEntry.brick.lock();
+        if (brickPtr) {
+            return brickPtr;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(brickKey);
+        if (it != cache.end()) {
+            lruList.splice(lruList.begin(), lruList, it->second.lruIterator);
+            brickPtr = it->second.brick;
+        }
+    }
+
+    if (!brickPtr) {
+        // Compute the brick outside of the lock so that multiple threads can load bricks in parallel.
+        auto brick = std::make_shared<Brick>();
+        computeBrick(fields.at(fieldIdx), bx, by, bz, *brick);
+        numBrickLoads++;
+        size_t brickMemory = brick->size() * sizeof(float);
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(brickKey);
+        if (it != cache.end()) {
+            // Another thread was faster.
+            lruList.splice(lruList.begin(), lruList, it->second.lruIterator);
+            brickPtr = it->second.brick;
+        } else {
+            brickPtr = brick;
+            lruList.push_front(brickKey);
+            cache.insert(std::make_pair(brickKey, CacheEntry{ brickPtr, lruList.begin() }));
+            cacheMemoryUsage += brickMemory;
+            evictBricks();
+        }
+    }
+
+    lookupEntry.gridId = gridId;
+    lookupEntry.brickKey = brickKey;
+    lookupEntry.brick = brickPtr;
+    return brickPtr;
+}
+
+BrickedGrid::BrickPtr BrickedGrid::getCellData(int fieldIdx, int x, int y, int z, size_t& cellOffset) const {
+    if (x < -1 || y < -1 || z < -1 || x >= xs || y >= ys || z >= zs) {
+        return nullptr;
+    }
+    int bx = x < 0 ? 0 : std::min(x / brickSize, bxs - 1);
+    int by = y < 0 ? 0 : std::min(y / brickSize, bys - 1);
+    int bz = z < 0 ? 0 : std::min(z / brickSize, bzs - 1);
+    int lx = x - bx * brickSize + 1;
+    int ly = y - by * brickSize + 1;
+    int lz = z - bz * brickSize + 1;
+    cellOffset =
+            (size_t(lx) + size_t(ly) * size_t(brickPointsPerAxis)
+             + size_t(lz) * size_t(brickPointsPerAxis) * size_t(brickPointsPerAxis))
+            * size_t(fields[fieldIdx].numComponents);
+    return getBrick(fieldIdx, bx, by, bz);
+}
+
+/**
+ * Truncates the grid position like glm::ivec3(gridPositionFloat). NaN and very large values map to a cell outside of
+ * the grid.
+ */
+template<class T>
+static inline int truncateGridPosition(T gridPosition) {
+    if (!(gridPosition > T(-2)) || !(gridPosition < T(std::numeric_limits<int>::max() / 2))) {
+        return -2;
+    }
+    return int(gridPosition);
+}
+
+template<class T, class VecT>
+static inline VecT interpolateVector(
+        const float* data, size_t strideY, size_t strideZ, const VecT& gridPosition) {
+    VecT frac = glm::fract(gridPosition);
+    VecT invFrac = VecT(1) - frac;
+    VecT interpolationValue;
+    for (int c = 0; c < 3; c++) {
+        interpolationValue[c] =
+                invFrac.x * invFrac.y * invFrac.z * T(data[c])
+                + frac.x * invFrac.y * invFrac.z * T(data[3 + c])
+                + invFrac.x * frac.y * invFrac.z * T(data[strideY + c])
+                + frac.x * frac.y * invFrac.z * T(data[strideY + 3 + c])
+                + invFrac.x * invFrac.y * frac.z * T(data[strideZ + c])
+                + frac.x * invFrac.y * frac.z * T(data[strideZ + 3 + c])
+                + invFrac.x * frac.y * frac.z * T(data[strideZ + strideY + c])
+                + frac.x * frac.y * frac.z * T(data[strideZ + strideY + 3 + c]);
+    }
+    return interpolationValue;
+}
+
+glm::vec3 BrickedGrid::sampleVector(int fieldIdx, const glm::vec3& gridPosition) const {
+    size_t cellOffset = 0;
+    BrickPtr brick = getCellData(
+            fieldIdx, truncateGridPosition(gridPosition.x), truncateGridPosition(gridPosition.y),
+            truncateGridPosition(gridPosition.z), cellOffset);
+    if (!brick) {
+        return glm::vec3(0.0f);
+    }
+    const size_t strideY = size_t(brickPointsPerAxis) * 3;
+    const size_t strideZ = size_t(brickPointsPerAxis) * size_t(brickPointsPerAxis) * 3;
+    return interpolateVector<float>(brick->data() + cellOffset, strideY, strideZ, gridPosition);
+}
+
+glm::dvec3 BrickedGrid::sampleVectorDouble(int fieldIdx, const glm::dvec3& gridPosition) const {
+    size_t cellOffset = 0;
+    BrickPtr brick = getCellData(
+            fieldIdx, truncateGridPosition(gridPosition.x), truncateGridPosition(gridPosition.y),
+            truncateGridPosition(gridPosition.z), cellOffset);
+    if (!brick) {
+        return glm::dvec3(0.0);
+    }
+    const size_t strideY = size_t(brickPointsPerAxis) * 3;
+    const size_t strideZ = size_t(brickPointsPerAxis) * size_t(brickPointsPerAxis) * 3;
+    return interpolateVector<double>(brick->data() + cellOffset, strideY, strideZ, gridPosition);
+}
+
+float BrickedGrid::sampleScalar(int fieldIdx, const glm::vec3& gridPosition) const {
+    size_t cellOffset = 0;
+    BrickPtr brick = getCellData(
+            fieldIdx, truncateGridPosition(gridPosition.x), truncateGridPosition(gridPosition.y),
+            truncateGridPosition(gridPosition.z), cellOffset);
+    if (!brick) {
+        return 0.0f;
+    }
+    const float* data = brick->data() + cellOffset;
+    const size_t strideY = size_t(brickPointsPerAxis);
+    const size_t strideZ = size_t(brickPointsPerAxis) * size_t(brickPointsPerAxis);
+    glm::vec3 frac = glm::fract(gridPosition);
+    glm::vec3 invFrac = glm::vec3(1.0) - frac;
+    return
+            invFrac.x * invFrac.y * invFrac.z * data[0]
+            + frac.x * invFrac.y * invFrac.z * data[1]
+            + invFrac.x * frac.y * invFrac.z * data[strideY]
+            + frac.x * frac.y * invFrac.z * data[strideY + 1]
+            + invFrac.x * invFrac.y * frac.z * data[strideZ]
+            + frac.x * invFrac.y * frac.z * data[strideZ + 1]
+            + invFrac.x * frac.y * frac.z * data[strideZ + strideY]
+            + frac.x * frac.y * frac.z * data[strideZ + strideY + 1];
+}
+
+float BrickedGrid::getScalarAtIdx(int fieldIdx, int x, int y, int z) const {
+    if (x < 0 || y < 0 || z < 0 || x >= xs || y >= ys || z >= zs) {
+        return 0.0f;
+    }
+    size_t cellOffset = 0;
+    BrickPtr brick = getCellData(fieldIdx, x, y, z, cellOffset);
+    return (*brick)[cellOffset];
+}
+
+float BrickedGrid::computeMaxMagnitude(int fieldIdx) const {
+    const Field& field = fields.at(fieldIdx);
+#ifdef USE_TBB
+    return tbb::parallel_reduce(
+            tbb::blocked_range<int>(0, bzs), 0.0f,
+            [&field, this](tbb::blocked_range<int> const& r, float maxMagnitude) {
+                Brick brick;
+                for (auto bz = r.begin(); bz != r.end(); bz++) {
+#else
+    float maxMagnitude = 0.0f;
+    Brick brick;
+#if _OPENMP >= 201107
+    #pragma omp parallel for shared(field) private(brick) reduction(max: maxMagnitude) default(none)
+#endif
+    for (int bz = 0; bz < bzs; bz++) {
+#endif
+        for (int by = 0; by < bys; by++) {
+            for (int bx = 0; bx < bxs; bx++) {
+                computeBrick(field, bx, by, bz, brick);
+                for (size_t i = 0; i < brick.size(); i += size_t(field.numComponents)) {
+                    float magnitude;
+                    if (field.numComponents == 3) {
+                        magnitude = std::sqrt(
+                                brick[i] * brick[i] + brick[i + 1] * brick[i + 1] + brick[i + 2] * brick[i + 2]);
+                    } else {
+                        magnitude = std::abs(brick[i]);
+                    }
+                    maxMagnitude = std::max(maxMagnitude, magnitude);
+                }
+            }
+        }
+    }
+#ifdef USE_TBB
+                return maxMagnitude;
+            }, sgl::max_predicate());
+#else
+    return maxMagnitude;
+#endif
+}
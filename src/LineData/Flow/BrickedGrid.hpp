@@ -0,0 +1,166 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_BRICKEDGRID_HPP
+#define LINEVIS_BRICKEDGRID_HPP
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "Utils/MappedFile.hpp"
+
+enum class BrickedFieldType {
+    CHANNEL_VECTOR, ///< Three consecutive channels of the source file.
+    CHANNEL_SCALAR, ///< One channel of the source file.
+    VELOCITY_MAGNITUDE, VORTICITY, VORTICITY_MAGNITUDE, HELICITY ///< Derived from the velocity (channels 0-2).
+};
+
+/**
+ * Out-of-core storage for Cartesian grids that do not fit into main memory.
+ *
+ * The data is read lazily from a memory-mapped raw file storing numChannels interleaved 32-bit floats per grid point
+ * (x fastest). The grid is split into bricks of brickSize^3 cells. Every brick additionally stores a layer of one grid
+ * point on each side, so all eight corners of a cell used for trilinear interpolation lie in the same brick. Bricks
+ * are created on first access and kept in an LRU cache with a fixed memory budget. Derived fields (vorticity,
+ * helicity, magnitudes) are computed per brick when the brick is created.
+ *
+ * Grid points outside of the grid have the value zero, like in the dense StreamlineTracingGrid fields.
+ * All sampling functions are thread-safe.
+ */
+class BrickedGrid {
+public:
+    BrickedGrid(int brickSize, size_t cacheMemoryBudget);
+    ~BrickedGrid();
+
+    /**
+     * Maps the raw source file.
+     * @param filename The file storing xs * ys * zs * numChannels floats (possibly after a header of headerSize bytes).
+     * @param dx, dy, dz The distance between two neighboring points (used for the vorticity).
+     * @return Whether the file could be mapped and has the expected size.
+     */
+    bool openRawFile(
+            const std::string& filename, int _xs, int _ys, int _zs, int _numChannels,
+            float _dx, float _dy, float _dz, size_t headerSize = 0);
+    /// Settings for BrickedFieldType::HELICITY (@see computeHelicityFieldNormalized).
+    void setHelicityNormalization(bool normalizeVelocity, bool normalizeVorticity);
+    /**
+     * Registers a field. Must be called before the first access to any brick.
+     * @return The index of the field.
+     */
+    int addField(const std::string& name, BrickedFieldType type, int channel = 0);
+
+    [[nodiscard]] inline int getGridSizeX() const { return xs; }
+    [[nodiscard]] inline int getGridSizeY() const { return ys; }
+    [[nodiscard]] inline int getGridSizeZ() const { return zs; }
+    [[nodiscard]] inline int getNumFields() const { return int(fields.size()); }
+    [[nodiscard]] inline const std::string& getFieldName(int fieldIdx) const { return fields.at(fieldIdx).name; }
+    [[nodiscard]] inline int getFieldNumComponents(int fieldIdx) const { return fields.at(fieldIdx).numComponents; }
+
+    /// Computes the maximum (vector) magnitude of a field brick by brick without adding the bricks to the cache.
+    float computeMaxMagnitude(int fieldIdx) const;
+
+    /**
+     * Trilinear interpolation at a position given in grid index space (i.e., (position - boxMin) / spacing).
+     * The base index is truncated like in StreamlineTracingGrid::_getScalarFieldAtPosition.
+     */
+    [[nodiscard]] glm::vec3 sampleVector(int fieldIdx, const glm::vec3& gridPosition) const;
+    [[nodiscard]] glm::dvec3 sampleVectorDouble(int fieldIdx, const glm::dvec3& gridPosition) const;
+    [[nodiscard]] float sampleScalar(int fieldIdx, const glm::vec3& gridPosition) const;
+    [[nodiscard]] float getScalarAtIdx(int fieldIdx, int x, int y, int z) const;
+
+    // Statistics.
+    [[nodiscard]] size_t getCacheMemoryUsage() const;
+    [[nodiscard]] inline size_t getCacheMemoryBudget() const { return cacheMemoryBudget; }
+    /// Changes the brick cache budget (e.g., when a grid is reused from the GridCache) and evicts bricks if necessary.
+    void setCacheMemoryBudget(size_t budget);
+    [[nodiscard]] inline size_t getNumBrickLoads() const { return numBrickLoads; }
+    [[nodiscard]] inline size_t getNumBrickEvictions() const { return numBrickEvictions; }
+
+private:
+    struct Field {
+        std::string name;
+        BrickedFieldType type;
+        int channel;
+        int numComponents;
+    };
+    typedef std::vector<float> Brick;
+    typedef std::shared_ptr<const Brick> BrickPtr;
+    struct CacheEntry {
+        BrickPtr brick;
+        std::list<uint64_t>::iterator lruIterator;
+    };
+
+    /**
+     * Returns the brick containing the cell with the passed base index, or nullptr if all its corners lie outside.
+     * The caller keeps the brick alive while reading from it, as it may be evicted concurrently.
+     */
+    BrickPtr getCellData(int fieldIdx, int x, int y, int z, size_t& cellOffset) const;
+    BrickPtr getBrick(int fieldIdx, int bx, int by, int bz) const;
+    void computeBrick(const Field& field, int bx, int by, int bz, Brick& brick) const;
+    [[nodiscard]] inline const float* getSourcePoint(int x, int y, int z) const {
+        return sourceData + (size_t(x) + size_t(y) * size_t(xs) + size_t(z) * size_t(xs) * size_t(ys))
+                * size_t(numChannels);
+    }
+    glm::vec3 computeVorticity(int x, int y, int z) const;
+    /// Evicts least recently used bricks until the budget is met. cacheMutex needs to be held by the caller.
+    void evictBricks() const;
+
+    const uint64_t gridId; ///< Unique ID (never reused) identifying the bricks in the thread-local lookup caches.
+    int brickSize;
+    int brickPointsPerAxis; ///< brickSize + 2 (one point on each side).
+    int xs = 0, ys = 0, zs = 0;
+    int bxs = 0, bys = 0, bzs = 0; ///< Number of bricks per axis.
+    int numChannels = 0;
+    float dx = 1.0f, dy = 1.0f, dz = 1.0f;
+    bool normalizeVelocity = false, normalizeVorticity = false;
+    std::vector<Field> fields;
+    MappedFile sourceFile;
+    const float* sourceData = nullptr;
+
+    // LRU brick cache.
+    size_t cacheMemoryBudget;
+    mutable std::mutex cacheMutex;
+    mutable std::list<uint64_t> lruList; ///< Most recently used brick at the front.
+    mutable std::unordered_map<uint64_t, CacheEntry> cache;
+    mutable size_t cacheMemoryUsage = 0;
+    mutable std::atomic<size_t> numBrickLoads{0};
+    mutable std::atomic<size_t> numBrickEvictions{0};
+};
+
+typedef std::shared_ptr<BrickedGrid> BrickedGridPtr;
+
+#endif //LINEVIS_BRICKEDGRID_HPP
@@ -0,0 +1,397 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <ctime>
+#include <utility>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include <Utils/File/Logfile.hpp>
+
+#include "StreamlineTracingDefines.hpp"
+#include "StreamlineTracingGrid.hpp"
+#include "GridCache.hpp"
+
+/// Needs to be increased whenever the file format or the computation of the cached fields changes.
+static const uint32_t GRID_CACHE_FILE_VERSION = 2;
+static const char GRID_CACHE_FILE_MAGIC[4] = { 'L', 'V', 'G', 'C' };
+/// Field data is aligned to the page size, so the fields can be used directly from the mapping.
+static const size_t GRID_CACHE_DATA_ALIGNMENT = 4096;
+
+struct GridCacheFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t xs, ys, zs;
+    float dx, dy, dz;
+    uint32_t numFields;
+    uint32_t keyLength;
+};
+
+struct GridCacheFieldHeader {
+    uint32_t numComponents;
+    uint32_t nameLength;
+    float maxMagnitude;
+    uint32_t padding;
+    uint64_t dataOffset;
+};
+/// The key and the field names have variable lengths. They are padded, so the field headers are read aligned.
+static const size_t GRID_CACHE_HEADER_ALIGNMENT = alignof(GridCacheFieldHeader);
+
+/// 64-bit FNV-1a hash. Unlike std::hash, it is stable across platforms and standard library implementations.
+static uint64_t hashStringFnv1a(const std::string& str) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : str) {
+        hash ^= uint64_t(uint8_t(c));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static inline size_t alignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+GridCache::GridCache(std::string cacheDirectory, size_t memoryBudget)
+        : cacheDirectory(std::move(cacheDirectory)), memoryBudget(memoryBudget) {
+}
+
+GridCache::~GridCache() {
+    waitForDiskWrite();
+}
+
+void GridCache::waitForDiskWrite() {
+    if (diskWriteThread.joinable()) {
+        diskWriteThread.join();
+    }
+}
+
+std::string GridCache::computeKey(
+        const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
+        int gridSubsamplingFactor) {
+    std::ostringstream keyStream;
+    keyStream << "version=" << GRID_CACHE_FILE_VERSION << ";file=" << dataSourceFilename;
+    boost::system::error_code errorCode;
+    boost::filesystem::path dataSourcePath(dataSourceFilename);
+    if (boost::filesystem::is_regular_file(dataSourcePath, errorCode)) {
+        keyStream << ";size=" << boost::filesystem::file_size(dataSourcePath, errorCode);
+        keyStream << ";mtime=" << boost::filesystem::last_write_time(dataSourcePath, errorCode);
+    }
+    const GridDataSetMetaData& m = gridDataSetMetaData;
+    keyStream << std::setprecision(9);
+    keyStream << ";date=" << m.date << ";time=" << m.time;
+    keyStream << ";scale=" << m.scale.x << "," << m.scale.y << "," << m.scale.z;
+    keyStream << ";axes=" << m.axes.x << "," << m.axes.y << "," << m.axes.z;
+    keyStream << ";velocity=" << m.velocityFieldName;
+    keyStream << ";normalizedVelocity=" << m.useNormalizedVelocity;
+    keyStream << ";normalizedVorticity=" << m.useNormalizedVorticity;
+    keyStream << ";derivedFields=" << m.derivedFields;
+    keyStream << ";bricked=" << m.useBrickedStorage << "," << m.brickSize;
+    keyStream << ";subsampling=" << gridSubsamplingFactor;
+    return keyStream.str();
+}
+
+std::string GridCache::getCacheFilename(const std::string& key) const {
+    std::ostringstream filenameStream;
+    filenameStream << cacheDirectory << std::hex << std::setw(16) << std::setfill('0') << hashStringFnv1a(key)
+                   << ".lvgrid";
+    return filenameStream.str();
+}
+
+StreamlineTracingGridPtr GridCache::find(const std::string& key) {
+    auto it = entryMap.find(key);
+    if (it != entryMap.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->grid;
+    }
+
+    if (!useDiskCache) {
+        return {};
+    }
+    std::string filename = getCacheFilename(key);
+    boost::system::error_code errorCode;
+    if (!boost::filesystem::exists(filename, errorCode)) {
+        return {};
+    }
+    StreamlineTracingGridPtr grid = readGridFile(filename, key);
+    if (grid) {
+        // The modification time marks the last use for evictCacheFiles.
+        boost::filesystem::last_write_time(filename, std::time(nullptr), errorCode);
+        pushEntry(key, grid);
+    }
+    return grid;
+}
+
+void GridCache::insert(const std::string& key, const StreamlineTracingGridPtr& grid, bool storeOnDisk) {
+    auto it = entryMap.find(key);
+    if (it != entryMap.end()) {
+        memoryUsage -= it->second->sizeInBytes;
+        entries.erase(it->second);
+        entryMap.erase(it);
+    }
+    if (useDiskCache && storeOnDisk && !grid->getBrickedGrid() && grid->getFieldsSizeInBytes() > 0) {
+        waitForDiskWrite();
+        // The thread holds a reference to the grid, so the fields stay valid even if the grid is evicted meanwhile.
+        diskWriteThread = std::thread([this, key, grid, maxDirectorySize = diskBudget]() {
+            std::string filename = getCacheFilename(key);
+            if (!writeGridFile(filename, key, *grid)) {
+                sgl::Logfile::get()->writeError(
+                        "Error in GridCache::insert: Could not write the cache file \"" + filename + "\".");
+                return;
+            }
+            evictCacheFiles(filename, maxDirectorySize);
+        });
+    }
+    pushEntry(key, grid);
+}
+
+void GridCache::pushEntry(const std::string& key, const StreamlineTracingGridPtr& grid) {
+    size_t sizeInBytes = grid->getFieldsSizeInBytes();
+    entries.push_front(Entry{ key, grid, sizeInBytes });
+    entryMap[key] = entries.begin();
+    memoryUsage += sizeInBytes;
+    evictEntries();
+}
+
+void GridCache::setMemoryBudget(size_t _memoryBudget) {
+    memoryBudget = _memoryBudget;
+    evictEntries();
+}
+
+void GridCache::evictEntries() {
+    while (memoryUsage > memoryBudget && entries.size() > 1) {
+        Entry& entry = entries.back();
+        memoryUsage -= entry.sizeInBytes;
+        entryMap.erase(entry.key);
+        entries.pop_back();
+    }
+}
+
+void GridCache::clear() {
+    waitForDiskWrite();
+    entries.clear();
+    entryMap.clear();
+    memoryUsage = 0;
+
+    boost::system::error_code errorCode;
+    if (!boost::filesystem::is_directory(cacheDirectory, errorCode)) {
+        return;
+    }
+    for (auto& entry : boost::filesystem::directory_iterator(cacheDirectory, errorCode)) {
+        if (entry.path().extension() == ".lvgrid") {
+            boost::filesystem::remove(entry.path(), errorCode);
+        }
+    }
+}
+
+void GridCache::evictCacheFiles(const std::string& keptFilename, size_t maxDirectorySize) {
+    struct CacheFile {
+        boost::filesystem::path path;
+        std::time_t lastUseTime;
+        size_t sizeInBytes;
+    };
+    std::vector<CacheFile> cacheFiles;
+    size_t directorySize = 0;
+    boost::system::error_code errorCode;
+    for (auto& entry : boost::filesystem::directory_iterator(cacheDirectory, errorCode)) {
+        if (entry.path().extension() != ".lvgrid") {
+            continue;
+        }
+        CacheFile cacheFile{ entry.path(), 0, 0 };
+        cacheFile.lastUseTime = boost::filesystem::last_write_time(cacheFile.path, errorCode);
+        cacheFile.sizeInBytes = size_t(boost::filesystem::file_size(cacheFile.path, errorCode));
+        if (errorCode) {
+            continue;
+        }
+        directorySize += cacheFile.sizeInBytes;
+        cacheFiles.push_back(cacheFile);
+    }
+    if (directorySize <= maxDirectorySize) {
+        return;
+    }
+
+    std::sort(cacheFiles.begin(), cacheFiles.end(), [](const CacheFile& lhs, const CacheFile& rhs) {
+        return lhs.lastUseTime < rhs.lastUseTime;
+    });
+    boost::filesystem::path keptPath(keptFilename);
+    for (const CacheFile& cacheFile : cacheFiles) {
+        if (directorySize <= maxDirectorySize) {
+            break;
+        }
+        if (boost::filesystem::equivalent(cacheFile.path, keptPath, errorCode)) {
+            continue;
+        }
+        // Grids still mapped from the file keep their data until they are released.
+        if (boost::filesystem::remove(cacheFile.path, errorCode)) {
+            directorySize -= cacheFile.sizeInBytes;
+        }
+    }
+}
+
+bool GridCache::writeGridFile(
+        const std::string& filename, const std::string& key, const StreamlineTracingGrid& grid) {
+    boost::system::error_code errorCode;
+    boost::filesystem::create_directories(cacheDirectory, errorCode);
+
+    struct FieldEntry {
+        const std::string* name;
+        const float* data;
+        uint32_t numComponents;
+        float maxMagnitude;
+    };
+    std::vector<FieldEntry> fieldEntries;
+    for (const auto& it : grid.getVectorFields()) {
+        fieldEntries.push_back(FieldEntry{ &it.first, it.second, 3, grid.getMaxVectorFieldMagnitude(it.first) });
+    }
+    for (const auto& it : grid.getScalarFields()) {
+        float maxMagnitude = it.first == "Helicity" ? grid.getMaxHelicityMagnitude() : 0.0f;
+        fieldEntries.push_back(FieldEntry{ &it.first, it.second, 1, maxMagnitude });
+    }
+
+    GridCacheFileHeader fileHeader{};
+    memcpy(fileHeader.magic, GRID_CACHE_FILE_MAGIC, sizeof(GRID_CACHE_FILE_MAGIC));
+    fileHeader.version = GRID_CACHE_FILE_VERSION;
+    fileHeader.xs = grid.getGridSizeX();
+    fileHeader.ys = grid.getGridSizeY();
+    fileHeader.zs = grid.getGridSizeZ();
+    fileHeader.dx = grid.getDx();
+    fileHeader.dy = grid.getDy();
+    fileHeader.dz = grid.getDz();
+    fileHeader.numFields = uint32_t(fieldEntries.size());
+    fileHeader.keyLength = uint32_t(key.size());
+
+    size_t numPoints = size_t(fileHeader.xs) * size_t(fileHeader.ys) * size_t(fileHeader.zs);
+    size_t headerSize = alignUp(sizeof(GridCacheFileHeader) + key.size(), GRID_CACHE_HEADER_ALIGNMENT);
+    for (const FieldEntry& fieldEntry : fieldEntries) {
+        headerSize += alignUp(sizeof(GridCacheFieldHeader) + fieldEntry.name->size(), GRID_CACHE_HEADER_ALIGNMENT);
+    }
+    std::vector<GridCacheFieldHeader> fieldHeaders(fieldEntries.size());
+    size_t dataOffset = alignUp(headerSize, GRID_CACHE_DATA_ALIGNMENT);
+    for (size_t i = 0; i < fieldEntries.size(); i++) {
+        fieldHeaders.at(i).numComponents = fieldEntries.at(i).numComponents;
+        fieldHeaders.at(i).nameLength = uint32_t(fieldEntries.at(i).name->size());
+        fieldHeaders.at(i).maxMagnitude = fieldEntries.at(i).maxMagnitude;
+        fieldHeaders.at(i).dataOffset = dataOffset;
+        dataOffset = alignUp(
+                dataOffset + numPoints * fieldEntries.at(i).numComponents * sizeof(float), GRID_CACHE_DATA_ALIGNMENT);
+    }
+
+    // Write to a temporary file first, so an interrupted write never leaves a truncated cache file behind.
+    std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream file(tmpFilename, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        const std::vector<char> padding(GRID_CACHE_DATA_ALIGNMENT, 0);
+        auto writePadding = [&](size_t alignment) {
+            auto currentOffset = size_t(file.tellp());
+            file.write(padding.data(), std::streamsize(alignUp(currentOffset, alignment) - currentOffset));
+        };
+        file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(GridCacheFileHeader));
+        file.write(key.data(), std::streamsize(key.size()));
+        writePadding(GRID_CACHE_HEADER_ALIGNMENT);
+        for (size_t i = 0; i < fieldEntries.size(); i++) {
+            file.write(reinterpret_cast<const char*>(&fieldHeaders.at(i)), sizeof(GridCacheFieldHeader));
+            file.write(fieldEntries.at(i).name->data(), std::streamsize(fieldEntries.at(i).name->size()));
+            writePadding(GRID_CACHE_HEADER_ALIGNMENT);
+        }
+        for (size_t i = 0; i < fieldEntries.size(); i++) {
+            auto currentOffset = size_t(file.tellp());
+            file.write(padding.data(), std::streamsize(fieldHeaders.at(i).dataOffset - currentOffset));
+            file.write(
+                    reinterpret_cast<const char*>(fieldEntries.at(i).data),
+                    std::streamsize(numPoints * fieldEntries.at(i).numComponents * sizeof(float)));
+        }
+        if (!file.good()) {
+            file.close();
+            boost::filesystem::remove(tmpFilename, errorCode);
+            return false;
+        }
+    }
+    boost::filesystem::rename(tmpFilename, filename, errorCode);
+    if (errorCode) {
+        boost::filesystem::remove(tmpFilename, errorCode);
+        return false;
+    }
+    return true;
+}
+
+StreamlineTracingGridPtr GridCache::readGridFile(const std::string& filename, const std::string& key) {
+    auto mappedFile = std::make_shared<MappedFile>();
+    if (!mappedFile->open(filename)) {
+        return {};
+    }
+
+    const auto* fileHeader = mappedFile->getPointer<GridCacheFileHeader>(0);
+    if (!fileHeader || memcmp(fileHeader->magic, GRID_CACHE_FILE_MAGIC, sizeof(GRID_CACHE_FILE_MAGIC)) != 0
+            || fileHeader->version != GRID_CACHE_FILE_VERSION) {
+        sgl::Logfile::get()->writeWarning(
+                "Warning in GridCache::readGridFile: Ignoring invalid cache file \"" + filename + "\".");
+        return {};
+    }
+    size_t offset = sizeof(GridCacheFileHeader);
+    const char* keyData = mappedFile->getPointer<char>(offset, fileHeader->keyLength);
+    if (!keyData || std::string(keyData, fileHeader->keyLength) != key) {
+        // Hash collision or outdated file for a data set with the same name.
+        return {};
+    }
+    offset = alignUp(offset + fileHeader->keyLength, GRID_CACHE_HEADER_ALIGNMENT);
+
+    auto grid = std::make_shared<StreamlineTracingGrid>();
+    grid->setGridExtent(
+            fileHeader->xs, fileHeader->ys, fileHeader->zs, fileHeader->dx, fileHeader->dy, fileHeader->dz);
+    size_t numPoints = size_t(fileHeader->xs) * size_t(fileHeader->ys) * size_t(fileHeader->zs);
+    for (uint32_t fieldIdx = 0; fieldIdx < fileHeader->numFields; fieldIdx++) {
+        const auto* fieldHeader = mappedFile->getPointer<GridCacheFieldHeader>(offset);
+        if (!fieldHeader) {
+            return {};
+        }
+        offset += sizeof(GridCacheFieldHeader);
+        const char* nameData = mappedFile->getPointer<char>(offset, fieldHeader->nameLength);
+        const float* fieldData = mappedFile->getPointer<float>(
+                fieldHeader->dataOffset, numPoints * fieldHeader->numComponents);
+        if (!nameData || !fieldData || fieldHeader->dataOffset % GRID_CACHE_DATA_ALIGNMENT != 0) {
+            sgl::Logfile::get()->writeWarning(
+                    "Warning in GridCache::readGridFile: Ignoring truncated cache file \"" + filename + "\".");
+            return {};
+        }
+        offset = alignUp(offset + fieldHeader->nameLength, GRID_CACHE_HEADER_ALIGNMENT);
+        std::string fieldName(nameData, fieldHeader->nameLength);
+        if (fieldHeader->numComponents == 3) {
+            grid->addMappedVectorField(mappedFile, fieldData, fieldName, fieldHeader->maxMagnitude);
+        } else {
+            grid->addMappedScalarField(mappedFile, fieldData, fieldName, fieldHeader->maxMagnitude);
+        }
+    }
+    return grid;
+}
@@ -0,0 +1,129 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_GRIDCACHE_HPP
+#define LINEVIS_GRIDCACHE_HPP
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+class StreamlineTracingGrid;
+typedef std::shared_ptr<StreamlineTracingGrid> StreamlineTracingGridPtr;
+struct GridDataSetMetaData;
+
+/**
+ * Cache for fully preprocessed streamline tracing grids (i.e., transposed, subsampled and with derived fields).
+ *
+ * Recently used grids are kept in memory in an LRU list with a byte budget. In addition, dense grids can be stored in
+ * a cache directory in a raw format. A grid found there is memory-mapped instead of parsed again by the grid loaders.
+ * The cache files are named after a hash of the cache key. The key itself is stored in the file, too, to detect hash
+ * collisions.
+ *
+ * Cache files are written on a background thread, so loading a data set does not wait for the write. The cache
+ * directory has a byte budget of its own. After each write, the least recently used files are deleted until the budget
+ * is met. The modification time of a file is its last use, as a cache hit updates it.
+ *
+ * The cache is not thread-safe and is meant to be used by the requester worker thread only.
+ */
+class GridCache {
+public:
+    /**
+     * @param cacheDirectory The directory for the cache files. It is created on the first write.
+     * @param memoryBudget The maximum size of the grids kept in memory in bytes.
+     */
+    GridCache(std::string cacheDirectory, size_t memoryBudget);
+    /// Waits until the cache file being written (if any) is complete.
+    ~GridCache();
+
+    /**
+     * Creates the cache key for a grid. It contains the data set file name, the file size and modification time, all
+     * loading options that change the grid data and the version of the cache file format. The brick cache budget is
+     * not part of the key.
+     */
+    static std::string computeKey(
+            const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
+            int gridSubsamplingFactor);
+
+    /**
+     * Looks up a grid first in the in-memory LRU list and then in the cache directory.
+     * @return The grid or nullptr if it is not cached.
+     */
+    StreamlineTracingGridPtr find(const std::string& key);
+    /**
+     * Adds a grid to the in-memory LRU list and optionally writes it to the cache directory on the background thread.
+     * Only one file is written at a time, so this waits for the previous write first.
+     * Grids using out-of-core (bricked) storage are never written to disk.
+     */
+    void insert(const std::string& key, const StreamlineTracingGridPtr& grid, bool storeOnDisk);
+    /// Waits until the cache file being written (if any) is complete.
+    void waitForDiskWrite();
+
+    /// Evicts least recently used grids until the budget is met. The most recently used grid is never evicted.
+    void setMemoryBudget(size_t _memoryBudget);
+    void setUseDiskCache(bool _useDiskCache) { useDiskCache = _useDiskCache; }
+    /// The maximum size of the cache directory in bytes. It is applied after the next write.
+    void setDiskBudget(size_t _diskBudget) { diskBudget = _diskBudget; }
+    [[nodiscard]] inline size_t getDiskBudget() const { return diskBudget; }
+    [[nodiscard]] inline size_t getMemoryBudget() const { return memoryBudget; }
+    [[nodiscard]] inline size_t getMemoryUsage() const { return memoryUsage; }
+    [[nodiscard]] inline size_t getNumEntries() const { return entries.size(); }
+    /// Removes all grids from memory and from the cache directory.
+    void clear();
+    /// @return The name of the cache file of a key (which may not exist).
+    [[nodiscard]] std::string getCacheFilename(const std::string& key) const;
+
+private:
+    struct Entry {
+        std::string key;
+        StreamlineTracingGridPtr grid;
+        size_t sizeInBytes;
+    };
+
+    bool writeGridFile(const std::string& filename, const std::string& key, const StreamlineTracingGrid& grid);
+    /// Deletes the least recently used cache files until the disk budget is met. The passed file is never deleted.
+    void evictCacheFiles(const std::string& keptFilename, size_t maxDirectorySize);
+    StreamlineTracingGridPtr readGridFile(const std::string& filename, const std::string& key);
+    void pushEntry(const std::string& key, const StreamlineTracingGridPtr& grid);
+    void evictEntries();
+
+    std::string cacheDirectory;
+    bool useDiskCache = true;
+    size_t memoryBudget;
+    size_t diskBudget = size_t(16) * size_t(1024 * 1024 * 1024);
+    std::thread diskWriteThread;
+    size_t memoryUsage = 0;
+    std::list<Entry> entries; ///< Front: Most recently used.
+    std::unordered_map<std::string, std::list<Entry>::iterator> entryMap;
+};
+
+#endif //LINEVIS_GRIDCACHE_HPP
@@ -0,0 +1,127 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include "KdTreeForest.hpp"
+
+void KdTreeForest::clear() {
+    points.clear();
+    treeOffsets.clear();
+    bufferOffset = 0;
+}
+
+void KdTreeForest::addPoints(const std::vector<glm::vec3>& newPoints) {
+    points.insert(points.end(), newPoints.begin(), newPoints.end());
+    size_t numNewTreePoints = points.size() - bufferOffset;
+    if (numNewTreePoints < BUFFER_SIZE) {
+        return;
+    }
+
+    // Merge with the smaller trees at the end of the list until the sizes decrease geometrically again. The merged
+    // trees and the buffer form the suffix of the point array starting at treeBegin.
+    size_t treeBegin = bufferOffset;
+    while (!treeOffsets.empty() && treeBegin - treeOffsets.back() <= 2 * numNewTreePoints) {
+        numNewTreePoints += treeBegin - treeOffsets.back();
+        treeBegin = treeOffsets.back();
+        treeOffsets.pop_back();
+    }
+
+    buildTree(treeBegin, points.size(), 0);
+    treeOffsets.push_back(treeBegin);
+    bufferOffset = points.size();
+}
+
+void KdTreeForest::buildTree(size_t begin, size_t end, int axis) {
+    while (end - begin > LEAF_SIZE) {
+        size_t median = begin + (end - begin) / 2;
+        std::nth_element(
+                points.begin() + ptrdiff_t(begin), points.begin() + ptrdiff_t(median), points.begin() + ptrdiff_t(end),
+                [axis](const glm::vec3& p0, const glm::vec3& p1) { return p0[axis] < p1[axis]; });
+        int nextAxis = (axis + 1) % 3;
+        buildTree(begin, median, nextAxis);
+        begin = median + 1;
+        axis = nextAxis;
+    }
+}
+
+bool KdTreeForest::getHasPointCloserThanInTree(
+        size_t begin, size_t end, int axis, const glm::vec3& point, float distanceSquared) const {
+    while (end - begin > LEAF_SIZE) {
+        size_t median = begin + (end - begin) / 2;
+        glm::vec3 diff = points[median] - point;
+        if (diff.x * diff.x + diff.y * diff.y + diff.z * diff.z < distanceSquared) {
+            return true;
+        }
+        int nextAxis = (axis + 1) % 3;
+        // diff[axis] > 0 means that the query point lies on the lower side of the splitting plane.
+        float planeDistance = diff[axis];
+        bool isLowerSide = planeDistance > 0.0f;
+        if (planeDistance * planeDistance < distanceSquared) {
+            // The far side may contain points closer than the search distance, too.
+            bool hasPoint = isLowerSide
+                    ? getHasPointCloserThanInTree(median + 1, end, nextAxis, point, distanceSquared)
+                    : getHasPointCloserThanInTree(begin, median, nextAxis, point, distanceSquared);
+            if (hasPoint) {
+                return true;
+            }
+        }
+        if (isLowerSide) {
+            end = median;
+        } else {
+            begin = median + 1;
+        }
+        axis = nextAxis;
+    }
+    for (size_t pointIdx = begin; pointIdx < end; pointIdx++) {
+        glm::vec3 diff = points[pointIdx] - point;
+        if (diff.x * diff.x + diff.y * diff.y + diff.z * diff.z < distanceSquared) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KdTreeForest::getHasPointCloserThan(const glm::vec3& point, float distance) const {
+    const float distanceSquared = distance * distance;
+    for (size_t pointIdx = bufferOffset; pointIdx < points.size(); pointIdx++) {
+        glm::vec3 diff = points[pointIdx] - point;
+        if (diff.x * diff.x + diff.y * diff.y + diff.z * diff.z < distanceSquared) {
+            return true;
+        }
+    }
+    // Query the small trees first, as they contain the most recently added points.
+    size_t treeEnd = bufferOffset;
+    for (auto it = treeOffsets.rbegin(); it != treeOffsets.rend(); it++) {
+        if (getHasPointCloserThanInTree(*it, treeEnd, 0, point, distanceSquared)) {
+            return true;
+        }
+        treeEnd = *it;
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_KDTREEFOREST_HPP
+#define LINEVIS_KDTREEFOREST_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+
+/**
+ * A point set supporting cheap insertions and "is there a point closer than r" queries.
+ * The points are stored in a logarithmic forest of static k-d-trees (Bentley-Saxe method): The trees are sorted by
+ * decreasing size, and a tree is merged with its predecessor as soon as the predecessor is no longer more than twice
+ * as large. Thus, there are at most O(log n) trees and every point is part of O(log n) rebuilds in total.
+ * Newly added points are first collected in a small buffer that is searched linearly.
+ *
+ * All points live in one array. As only the most recent trees are ever merged, every tree is a contiguous range of
+ * this array followed by the ranges of all smaller trees and the buffer. The trees are implicit k-d-trees (the median
+ * point of a range splits it along the axis of the tree level), so they are rebuilt in place without extra storage.
+ */
+class KdTreeForest {
+public:
+    KdTreeForest() = default;
+    KdTreeForest(const KdTreeForest&) = delete;
+    KdTreeForest& operator=(const KdTreeForest&) = delete;
+    KdTreeForest(KdTreeForest&&) = default;
+    KdTreeForest& operator=(KdTreeForest&&) = default;
+
+    /// Removes all points.
+    void clear();
+
+    /// Adds the passed points to the forest.
+    void addPoints(const std::vector<glm::vec3>& newPoints);
+
+    /// @return Whether a point in the forest has a distance smaller than the passed distance to the query point.
+    [[nodiscard]] bool getHasPointCloserThan(const glm::vec3& point, float distance) const;
+
+    [[nodiscard]] inline size_t getNumPoints() const { return points.size(); }
+    [[nodiscard]] inline size_t getNumTrees() const { return treeOffsets.size(); }
+
+private:
+    void buildTree(size_t begin, size_t end, int axis);
+    [[nodiscard]] bool getHasPointCloserThanInTree(
+            size_t begin, size_t end, int axis, const glm::vec3& point, float distanceSquared) const;
+
+    static constexpr size_t BUFFER_SIZE = 64;
+    static constexpr size_t LEAF_SIZE = 8;
+    std::vector<glm::vec3> points; ///< The points of all trees followed by the buffer.
+    std::vector<size_t> treeOffsets; ///< Index of the first point of each tree; sorted by decreasing tree size.
+    size_t bufferOffset = 0; ///< Index of the first point not yet part of a tree.
+};
+
+#endif //LINEVIS_KDTREEFOREST_HPP
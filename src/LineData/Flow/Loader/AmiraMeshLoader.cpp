@@ -192,24 +192,7 @@ void AmiraMeshLoader::load(
     float dz = cellStep * bbDimZ / maxBbDim;
     grid->setGridExtent(xs, ys, zs, dx, dy, dz);
 
-    auto* velocityMagnitudeField = new float[numPoints];
-    auto* vorticityField = new float[numPoints * 3];
-    auto* vorticityMagnitudeField = new float[numPoints];
-    auto* helicityField = new float[numPoints];
-
-    computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
-    computeVorticityField(velocityField, vorticityField, xs, ys, zs, dx, dy, dz);
-    computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, xs, ys, zs,
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(helicityField, "Helicity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
+    addVelocityAndDerivedFields(grid, velocityField, xs, ys, zs, dx, dy, dz, gridDataSetMetaData);
 
     delete[] buffer;
     buffer = nullptr;
@@ -199,10 +199,6 @@ void DatRawFileLoader::load(
     int scalarFieldNumEntries = xs * ys * zs;
 
     auto* velocityField = new float[vectorFieldNumEntries];
-    auto* velocityMagnitudeField = new float[scalarFieldNumEntries];
-    auto* vorticityField = new float[vectorFieldNumEntries];
-    auto* vorticityMagnitudeField = new float[scalarFieldNumEntries];
-    auto* helicityField = new float[scalarFieldNumEntries];
     float* scalarAttributeField = nullptr;
 
     if (numComponents == 3) {
@@ -229,20 +225,9 @@ void DatRawFileLoader::load(
         }
     }
 
-    computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
-    computeVorticityField(velocityField, vorticityField, xs, ys, zs, cellStep, cellStep, cellStep);
-    computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, xs, ys, zs,
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
     grid->setGridExtent(xs, ys, zs, cellStep, cellStep, cellStep);
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(helicityField, "Helicity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
+    addVelocityAndDerivedFields(
+            grid, velocityField, xs, ys, zs, cellStep, cellStep, cellStep, gridDataSetMetaData);
     if (scalarAttributeField) {
         // Make an educated guess about the type of the attribute.
         std::string filenameRawLower = sgl::FileUtils::get()->getPureFilename(dataSourceFilename);
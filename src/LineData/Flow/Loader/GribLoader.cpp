@@ -367,29 +367,8 @@ void GribLoader::load(
         velocityField[3 * ptIdx + 2] = wField[ptIdx] * gridDataSetMetaData.scale[2];
     }
 
-    auto* velocityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(
-            velocityField, velocityMagnitudeField, int(xs), int(ys), int(zs));
-
-    auto* vorticityField = new float[numPoints * 3];
-    computeVorticityField(
-            velocityField, vorticityField, int(xs), int(ys), int(zs), dx, dy, dz);
-
-    auto* vorticityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(
-            vorticityField, vorticityMagnitudeField, int(xs), int(ys), int(zs));
-
-    auto* helicityField = new float[numPoints];
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, int(xs), int(ys), int(zs),
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
-    grid->addScalarField(helicityField, "Helicity");
+    addVelocityAndDerivedFields(
+            grid, velocityField, int(xs), int(ys), int(zs), dx, dy, dz, gridDataSetMetaData);
 
     for (size_t varIdx = 0; varIdx < variableArrays.size(); varIdx++) {
         grid->addScalarField(variableArrays.at(varIdx), variableNames.at(varIdx));
@@ -30,6 +30,10 @@
 #define LINEVIS_GRIDLOADER_HPP
 
 #include <cstdint>
+#include <cstddef>
+
+class StreamlineTracingGrid;
+struct GridDataSetMetaData;
 
 /**
  * Computes the magnitude field of a given vector field.
@@ -49,6 +53,7 @@ void computeVectorMagnitudeField(
  * @param xs The grid size in x direction.
  * @param ys The grid size in y direction.
  * @param zs The grid size in z direction.
+ * Derivatives along axes with a grid size of one are zero.
  */
 void computeVorticityField(
         const float* velocityField, float* vorticityField, int xs, int ys, int zs, float dx, float dy, float dz);
@@ -84,6 +89,33 @@ void computeHelicityFieldNormalized(
         const float* velocityField, const float* vorticityField, float* helicityField, int xs, int ys, int zs,
         bool normalizeVelocity, bool normalizeVorticity);
 
+/**
+ * Computes the velocity magnitude, vorticity, vorticity magnitude and helicity fields in one sweep over the grid.
+ * The grid is processed in tiles of a few z slices and rows, so the velocity rows needed for the central differences
+ * stay in the cache. The results are the same as the ones of the separate functions above.
+ * Output arrays that are nullptr are not computed. The vorticity is only computed in a row buffer if vorticityField
+ * is nullptr.
+ * @param velocityField A float array of size xs * ys * zs * 3 storing the 3D velocity field (input).
+ * @param velocityMagnitudeField A float array of size xs * ys * zs (output, optional).
+ * @param vorticityField A float array of size xs * ys * zs * 3 (output, optional).
+ * @param vorticityMagnitudeField A float array of size xs * ys * zs (output, optional).
+ * @param helicityField A float array of size xs * ys * zs (output, optional).
+ * @param normalizeVelocity, normalizeVorticity @see computeHelicityFieldNormalized.
+ */
+void computeDerivedFields(
+        const float* velocityField, float* velocityMagnitudeField, float* vorticityField,
+        float* vorticityMagnitudeField, float* helicityField, int xs, int ys, int zs, float dx, float dy, float dz,
+        bool normalizeVelocity, bool normalizeVorticity);
+
+/**
+ * Computes the fields selected in gridDataSetMetaData.derivedFields using @see computeDerivedFields and adds them
+ * together with the velocity field to the grid. The grid extent needs to be set beforehand.
+ * The grid takes ownership of velocityField.
+ */
+void addVelocityAndDerivedFields(
+        StreamlineTracingGrid* grid, float* velocityField, int xs, int ys, int zs, float dx, float dy, float dz,
+        const GridDataSetMetaData& gridDataSetMetaData);
+
 /**
  * Swaps the endianness of the passed array.
  * @param values The array to swap endianness for.
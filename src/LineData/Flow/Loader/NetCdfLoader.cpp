@@ -256,29 +256,8 @@ void NetCdfLoader::load(
         velocityField[3 * ptIdx + 2] = wField[ptIdx];
     }
 
-    auto* velocityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(
-            velocityField, velocityMagnitudeField, int(xs), int(ys), int(zs));
-
-    auto* vorticityField = new float[numPoints * 3];
-    computeVorticityField(
-            velocityField, vorticityField, int(xs), int(ys), int(zs), dx, dy, dz);
-
-    auto* vorticityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(
-            vorticityField, vorticityMagnitudeField, int(xs), int(ys), int(zs));
-
-    auto* helicityField = new float[numPoints];
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, int(xs), int(ys), int(zs),
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
-    grid->addScalarField(helicityField, "Helicity");
+    addVelocityAndDerivedFields(
+            grid, velocityField, int(xs), int(ys), int(zs), dx, dy, dz, gridDataSetMetaData);
 
     grid->addScalarField(uField, uUpperCaseVariableExists ? "U" : "u");
     grid->addScalarField(vField, vUpperCaseVariableExists ? "V" : "v");
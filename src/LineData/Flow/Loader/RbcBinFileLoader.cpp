@@ -30,12 +30,18 @@
 #include <Utils/File/FileLoader.hpp>
 #include "../StreamlineTracingDefines.hpp"
 #include "../StreamlineTracingGrid.hpp"
+#include "../BrickedGrid.hpp"
 #include "GridLoader.hpp"
 #include "RbcBinFileLoader.hpp"
 
 void RbcBinFileLoader::load(
         const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
         StreamlineTracingGrid* grid) {
+    if (gridDataSetMetaData.useBrickedStorage) {
+        loadBricked(dataSourceFilename, gridDataSetMetaData, grid);
+        return;
+    }
+
     uint8_t* buffer = nullptr;
     size_t length = 0;
     bool loaded = sgl::loadFileFromSource(dataSourceFilename, buffer, length, false);
@@ -60,10 +66,6 @@ void RbcBinFileLoader::load(
     int scalarFieldNumEntries = xs * ys * zs;
 
     auto* velocityField = new float[vectorFieldNumEntries];
-    auto* velocityMagnitudeField = new float[scalarFieldNumEntries];
-    auto* vorticityField = new float[vectorFieldNumEntries];
-    auto* vorticityMagnitudeField = new float[scalarFieldNumEntries];
-    auto* helicityField = new float[scalarFieldNumEntries];
     auto* temperatureField = new float[scalarFieldNumEntries];
 
     for (int z = 0; z < zs; z++) {
@@ -77,21 +79,46 @@ void RbcBinFileLoader::load(
         }
     }
 
-    computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
-    computeVorticityField(velocityField, vorticityField, xs, ys, zs, cellStep, cellStep, cellStep);
-    computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, xs, ys, zs,
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
     grid->setGridExtent(xs, ys, zs, cellStep, cellStep, cellStep);
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(helicityField, "Helicity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
+    addVelocityAndDerivedFields(
+            grid, velocityField, xs, ys, zs, cellStep, cellStep, cellStep, gridDataSetMetaData);
     grid->addScalarField(temperatureField, "Temperature");
 
     delete[] buffer;
 }
+
+void RbcBinFileLoader::loadBricked(
+        const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
+        StreamlineTracingGrid* grid) {
+    int xs = 1024;
+    int ys = 32;
+    int zs = 1024;
+    float cellStep = 1.0f / 1023.0f;
+
+    auto brickedGrid = std::make_shared<BrickedGrid>(
+            gridDataSetMetaData.brickSize, gridDataSetMetaData.brickCacheMemoryBudget);
+    if (!brickedGrid->openRawFile(dataSourceFilename, xs, ys, zs, 4, cellStep, cellStep, cellStep)) {
+        sgl::Logfile::get()->throwError(
+                "Error in RbcBinFileLoader::loadBricked: Couldn't map file \"" + dataSourceFilename + "\".");
+    }
+    brickedGrid->setHelicityNormalization(
+            gridDataSetMetaData.useNormalizedVelocity, gridDataSetMetaData.useNormalizedVorticity);
+    brickedGrid->addField("Velocity", BrickedFieldType::CHANNEL_VECTOR, 0);
+    const uint32_t derivedFields = gridDataSetMetaData.derivedFields;
+    if ((derivedFields & DERIVED_FIELD_VORTICITY) != 0) {
+        brickedGrid->addField("Vorticity", BrickedFieldType::VORTICITY);
+    }
+    if ((derivedFields & DERIVED_FIELD_HELICITY) != 0) {
+        brickedGrid->addField("Helicity", BrickedFieldType::HELICITY);
+    }
+    if ((derivedFields & DERIVED_FIELD_VELOCITY_MAGNITUDE) != 0) {
+        brickedGrid->addField("Velocity Magnitude", BrickedFieldType::VELOCITY_MAGNITUDE);
+    }
+    if ((derivedFields & DERIVED_FIELD_VORTICITY_MAGNITUDE) != 0) {
+        brickedGrid->addField("Vorticity Magnitude", BrickedFieldType::VORTICITY_MAGNITUDE);
+    }
+    brickedGrid->addField("Temperature", BrickedFieldType::CHANNEL_SCALAR, 3);
+
+    grid->setGridExtent(xs, ys, zs, cellStep, cellStep, cellStep);
+    grid->setBrickedGrid(brickedGrid);
+}
@@ -40,12 +40,20 @@ class StreamlineTracingGrid;
  *
  * The file format stores 1024x32x1024 velocity and temperature values at the points of a Cartesian grid in the order
  * (Vx, Vy, Vz, T).
+ *
+ * If GridDataSetMetaData::useBrickedStorage is set, the file is memory-mapped and the fields are created lazily in
+ * bricks (@see BrickedGrid) instead of being loaded into memory at once.
  */
 class RbcBinFileLoader {
 public:
     static void load(
             const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
             StreamlineTracingGrid* grid);
+
+private:
+    static void loadBricked(
+            const std::string& dataSourceFilename, const GridDataSetMetaData& gridDataSetMetaData,
+            StreamlineTracingGrid* grid);
 };
 
 #endif //LINEVIS_RBCBINFILELOADER_HPP
@@ -586,44 +586,59 @@ void StructuredGridVtkLoader::load(
     }
     float* velocityField = itVelocity->second;
 
-    if (scalarFields.find("velocityMagnitude") == scalarFields.end()) {
-        auto* velocityMagnitudeField = new float[numPoints];
-        computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
+    // Don't use cached helicity if normalized velocity and/or normalized vorticity should be used.
+    if (gridDataSetMetaData.useNormalizedVelocity || gridDataSetMetaData.useNormalizedVorticity) {
+        auto helicityIt = scalarFields.find("helicity");
+        if (helicityIt != scalarFields.end()) {
+            delete[] helicityIt->second;
+            scalarFields.erase(helicityIt);
+        }
+    }
+
+    // Only compute the derived fields that are neither cached in the file nor deselected by the user.
+    const uint32_t derivedFields = gridDataSetMetaData.derivedFields;
+    float* velocityMagnitudeField = nullptr;
+    float* vorticityField = nullptr;
+    float* vorticityMagnitudeField = nullptr;
+    float* helicityField = nullptr;
+    if (scalarFields.find("velocityMagnitude") == scalarFields.end()
+            && (derivedFields & DERIVED_FIELD_VELOCITY_MAGNITUDE) != 0) {
+        velocityMagnitudeField = new float[numPoints];
         scalarFields.insert(std::make_pair("Velocity Magnitude", velocityMagnitudeField));
     }
+    if (scalarFields.find("vorticityMagnitude") == scalarFields.end()
+            && (derivedFields & DERIVED_FIELD_VORTICITY_MAGNITUDE) != 0) {
+        vorticityMagnitudeField = new float[numPoints];
+        scalarFields.insert(std::make_pair("Vorticity Magnitude", vorticityMagnitudeField));
+    }
+    if (scalarFields.find("helicity") == scalarFields.end() && (derivedFields & DERIVED_FIELD_HELICITY) != 0) {
+        helicityField = new float[numPoints];
+        scalarFields.insert(std::make_pair("Helicity", helicityField));
+    }
 
-    if (vectorFields.find("vorticity") == vectorFields.end()
-            || scalarFields.find("vorticityMagnitude") == scalarFields.end()
-            || scalarFields.find("helicity") == scalarFields.end()) {
-        float* vorticityField;
-        auto it = vectorFields.find("vorticity");
-        if (it == vectorFields.end()) {
+    auto itVorticity = vectorFields.find("vorticity");
+    if (itVorticity == vectorFields.end()) {
+        if ((derivedFields & DERIVED_FIELD_VORTICITY) != 0) {
             vorticityField = new float[numPoints * 3];
-            computeVorticityField(velocityField, vorticityField, xs, ys, zs, cellStep, cellStep, cellStep);
             vectorFields.insert(std::make_pair("Vorticity", vorticityField));
-        } else {
-            vorticityField = it->second;
         }
-        if (scalarFields.find("vorticityMagnitude") == scalarFields.end()) {
-            auto* vorticityMagnitudeField = new float[numPoints];
-            computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
-            scalarFields.insert(std::make_pair("Vorticity Magnitude", vorticityMagnitudeField));
+        computeDerivedFields(
+                velocityField, velocityMagnitudeField, vorticityField, vorticityMagnitudeField, helicityField,
+                xs, ys, zs, cellStep, cellStep, cellStep,
+                gridDataSetMetaData.useNormalizedVelocity, gridDataSetMetaData.useNormalizedVorticity);
+    } else {
+        vorticityField = itVorticity->second;
+        if (velocityMagnitudeField) {
+            computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
         }
-        // Don't use cached helicity if normalized velocity and/or normalized vorticity should be used.
-        if (gridDataSetMetaData.useNormalizedVelocity || gridDataSetMetaData.useNormalizedVorticity) {
-            auto helicityIt = scalarFields.find("helicity");
-            if (helicityIt != scalarFields.end()) {
-                delete[] it->second;
-                scalarFields.erase(helicityIt);
-            }
+        if (vorticityMagnitudeField) {
+            computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
         }
-        if (scalarFields.find("helicity") == scalarFields.end()) {
-            auto* helicityField = new float[numPoints];
+        if (helicityField) {
             computeHelicityFieldNormalized(
                     velocityField, vorticityField, helicityField, xs, ys, zs,
                     gridDataSetMetaData.useNormalizedVelocity,
                     gridDataSetMetaData.useNormalizedVorticity);
-            scalarFields.insert(std::make_pair("Helicity", helicityField));
         }
     }
 
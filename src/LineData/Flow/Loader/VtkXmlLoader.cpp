@@ -328,26 +328,7 @@ void VtkXmlLoader::load(
     float dz = cellStep * spacingArray.at(2) / maxSpacing;
     grid->setGridExtent(xs, ys, zs, dx, dy, dz);
 
-    auto* velocityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(velocityField, velocityMagnitudeField, xs, ys, zs);
-
-    auto* vorticityField = new float[numPoints * 3];
-    computeVorticityField(velocityField, vorticityField, xs, ys, zs, dx, dy, dz);
-
-    auto* vorticityMagnitudeField = new float[numPoints];
-    computeVectorMagnitudeField(vorticityField, vorticityMagnitudeField, xs, ys, zs);
-
-    auto* helicityField = new float[numPoints];
-    computeHelicityFieldNormalized(
-            velocityField, vorticityField, helicityField, xs, ys, zs,
-            gridDataSetMetaData.useNormalizedVelocity,
-            gridDataSetMetaData.useNormalizedVorticity);
-
-    grid->addVectorField(velocityField, "Velocity");
-    grid->addScalarField(velocityMagnitudeField, "Velocity Magnitude");
-    grid->addVectorField(vorticityField, "Vorticity");
-    grid->addScalarField(vorticityMagnitudeField, "Vorticity Magnitude");
-    grid->addScalarField(helicityField, "Helicity");
+    addVelocityAndDerivedFields(grid, velocityField, xs, ys, zs, dx, dy, dz, gridDataSetMetaData);
 
     grid->addScalarField(uField, "u");
     grid->addScalarField(vField, "v");
@@ -27,6 +27,7 @@
  */
 
 #include <iostream>
+#include <cassert>
 #include <Math/Geometry/AABB3.hpp>
 #include <Math/Geometry/Sphere.hpp>
 #include <ImGui/imgui.h>
@@ -363,6 +364,9 @@ StreamlineMaxHelicityFirstSeeder::~StreamlineMaxHelicityFirstSeeder() = default;
 
 void StreamlineMaxHelicityFirstSeeder::reset(
         StreamlineTracingSettings& tracingSettings, StreamlineTracingGrid* newGrid) {
+#ifndef NDEBUG
+    assert(numRunningQueries.load() == 0 && "The seeder must not be reset while termination queries are running.");
+#endif
     grid = newGrid;
     box = grid->getBox();
     xs = grid->getGridSizeX();
@@ -377,12 +381,13 @@ void StreamlineMaxHelicityFirstSeeder::reset(
 
     if (terminationCheckType == TerminationCheckType::GRID_BASED) {
         cellOccupancyGrid.resize((xs - 1) * (ys - 1) * (zs - 1), false);
+    } else if (terminationCheckType == TerminationCheckType::KD_TREE_BASED) {
+        kdTreeForest.clear();
     } else if (terminationCheckType == TerminationCheckType::HASHED_GRID_BASED) {
         hashedGrid = sgl::HashedGrid<sgl::Empty>(
                 std::max(((xs - 1) * (ys - 1) * (zs - 1)) / 4, 1), std::min(dx, std::min(dy, dz)));
     }
 
-    float* helicityField = grid->getHelicityField();
     if (gridSubsamplingFactor == 1) {
         samplePriorityQueue.reserve((xs - 2) * (ys - 2) * (zs - 2));
         for (int z = 1; z < zs - 1; z++) {
@@ -394,7 +399,7 @@ void StreamlineMaxHelicityFirstSeeder::reset(
                             boxMin.x + dimensions.x * float(x) / float(xs),
                             boxMin.y + dimensions.y * float(y) / float(ys),
                             boxMin.z + dimensions.z * float(z) / float(zs));
-                    samplePriorityQueue.emplace_back(helicityField[IDXS(x, y, z)], samplePoint);
+                    samplePriorityQueue.emplace_back(grid->getHelicityAtIdx(x, y, z), samplePoint);
                 }
             }
         }
@@ -416,7 +421,7 @@ void StreamlineMaxHelicityFirstSeeder::reset(
                     int ygrid = std::min(y * gridSubsamplingFactor, ys - 1);
                     int zgrid = std::min(z * gridSubsamplingFactor, zs - 1);
                     samplePriorityQueue.emplace_back(
-                            std::abs(helicityField[IDXS(xgrid, ygrid, zgrid)]), samplePoint);
+                            std::abs(grid->getHelicityAtIdx(xgrid, ygrid, zgrid)), samplePoint);
                 }
             }
         }
@@ -442,7 +447,7 @@ bool StreamlineMaxHelicityFirstSeeder::hasNextPoint() {
                 return true;
             }
         } else if (terminationCheckType == TerminationCheckType::KD_TREE_BASED) {
-            if (!kdTree.getHasPointCloserThan(nextSamplePoint, minimumSeparationDistance)) {
+            if (!kdTreeForest.getHasPointCloserThan(nextSamplePoint, minimumSeparationDistance)) {
                 return true;
             }
         } else if (terminationCheckType == TerminationCheckType::HASHED_GRID_BASED) {
@@ -462,6 +467,9 @@ glm::vec3 StreamlineMaxHelicityFirstSeeder::getNextPoint() {
 }
 
 void StreamlineMaxHelicityFirstSeeder::addFinishedTrajectory(const Trajectory& trajectory) {
+#ifndef NDEBUG
+    assert(numRunningQueries.load() == 0 && "Trajectories must not be added while termination queries are running.");
+#endif
     if (terminationCheckType == TerminationCheckType::GRID_BASED) {
         for (const glm::vec3& position : trajectory.positions) {
             sgl::AABB3 boundingBox(
@@ -500,10 +508,7 @@ void StreamlineMaxHelicityFirstSeeder::addFinishedTrajectory(const Trajectory& t
             }
         }
     } else if (terminationCheckType == TerminationCheckType::KD_TREE_BASED) {
-        for (const glm::vec3& position : trajectory.positions) {
-            kdTreePointCache.push_back(position);
-        }
-        kdTree.build(kdTreePointCache);
+        kdTreeForest.addPoints(trajectory.positions);
     } else if (terminationCheckType == TerminationCheckType::HASHED_GRID_BASED) {
         for (const glm::vec3& position : trajectory.positions) {
             hashedGrid.add(std::make_pair(position, sgl::Empty{}));
@@ -512,6 +517,13 @@ void StreamlineMaxHelicityFirstSeeder::addFinishedTrajectory(const Trajectory& t
 }
 
 bool StreamlineMaxHelicityFirstSeeder::isPointTerminated(const glm::vec3& point) {
+#ifndef NDEBUG
+    struct QueryScope {
+        explicit QueryScope(std::atomic<int>& counter) : counter(counter) { counter++; }
+        ~QueryScope() { counter--; }
+        std::atomic<int>& counter;
+    } queryScope(numRunningQueries);
+#endif
     if (terminationCheckType == TerminationCheckType::GRID_BASED) {
         glm::vec3 gridPositionFloat = point - box.getMinimum();
         gridPositionFloat *= glm::vec3(1.0f / dx, 1.0f / dy, 1.0f / dz);
@@ -521,8 +533,9 @@ bool StreamlineMaxHelicityFirstSeeder::isPointTerminated(const glm::vec3& point)
         gridPosition.z = glm::clamp(gridPosition.z, 0, zs - 2);
         return cellOccupancyGrid.at(IDXS_C(gridPosition.x, gridPosition.y, gridPosition.z));
     } else if (terminationCheckType == TerminationCheckType::KD_TREE_BASED) {
-        return kdTree.getHasPointCloserThan(point, minimumSeparationDistance);
+        return kdTreeForest.getHasPointCloserThan(point, minimumSeparationDistance);
     } else if (terminationCheckType == TerminationCheckType::HASHED_GRID_BASED) {
+        std::lock_guard<std::mutex> lock(hashedGridQueryMutex);
         return hashedGrid.getHasPointCloserThan(point, minimumSeparationDistance);
     }
     return false;
@@ -33,6 +33,8 @@
 #include <queue>
 #include <random>
 #include <memory>
+#include <mutex>
+#include <atomic>
 
 #include <glm/vec3.hpp>
 
@@ -42,6 +44,7 @@
 
 #include "Utils/InternalState.hpp"
 #include "StreamlineTracingDefines.hpp"
+#include "KdTreeForest.hpp"
 
 struct Trajectory;
 struct StreamlineTracingSettings;
@@ -186,6 +189,12 @@ public:
     void reset(StreamlineTracingSettings& tracingSettings, StreamlineTracingGrid* newGrid) override;
     bool hasNextPoint() override;
     glm::vec3 getNextPoint() override;
+    /**
+     * May be called concurrently by the tracing worker threads. The occupancy grid and k-d tree forest queries only
+     * read; the hashed grid queries are serialized, as sgl::HashedGrid does not guarantee thread-safe queries.
+     * The termination state must not be modified (@see addFinishedTrajectory, @see reset) while queries are running,
+     * which is asserted in debug builds.
+     */
     bool isPointTerminated(const glm::vec3& point);
     void addFinishedTrajectory(const Trajectory& trajectory);
     bool renderGui() override { return false; }
@@ -199,9 +208,12 @@ private:
     float minimumSeparationDistance = 0.0f;
     TerminationCheckType terminationCheckType = TerminationCheckType::GRID_BASED;
     int gridSubsamplingFactor = 1;
-    sgl::KdTree<sgl::Empty> kdTree; ///< For terminationCheckType == TerminationCheckType::KD_TREE_BASED.
+    KdTreeForest kdTreeForest; ///< For terminationCheckType == TerminationCheckType::KD_TREE_BASED.
     sgl::HashedGrid<sgl::Empty> hashedGrid; ///< For terminationCheckType == TerminationCheckType::HASHED_GRID_BASED.
-    std::vector<glm::vec3> kdTreePointCache;
+    std::mutex hashedGridQueryMutex;
+#ifndef NDEBUG
+    std::atomic<int> numRunningQueries{0}; ///< Number of isPointTerminated calls in flight.
+#endif
 
     struct GridSample {
         float attributeValue;
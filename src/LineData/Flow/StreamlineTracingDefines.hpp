@@ -31,9 +31,12 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 #include <glm/vec3.hpp>
 #include "Loader/AbcFlowGenerator.hpp"
 
+class JobToken;
+
 enum class StreamlineTracingDataSource {
     // A .vtk file storing a STRUCTURED_GRID data set.
     VTK_STRUCTURED_GRID_FILE,
@@ -113,6 +116,18 @@ class StreamlineTracingGrid;
 #define IDXS(x,y,z) ((z)*xs*ys + (y)*xs + (x))
 #define IDXS_C(x,y,z) ((z)*(xs-1)*(ys-1) + (y)*(xs-1) + (x))
 
+/**
+ * Fields derived from the velocity when loading a grid (@see computeDerivedFields). Fields that are not needed can be
+ * left out to save memory and loading time.
+ */
+enum DerivedFieldFlags : uint32_t {
+    DERIVED_FIELD_VELOCITY_MAGNITUDE = 1u,
+    DERIVED_FIELD_VORTICITY = 2u,
+    DERIVED_FIELD_VORTICITY_MAGNITUDE = 4u,
+    DERIVED_FIELD_HELICITY = 8u,
+    DERIVED_FIELDS_ALL = 15u
+};
+
 struct GridDataSetMetaData {
     // Date can be left 0. It is used for GRIB files storing time in a date-time format.
     // E.g., "data_date": 20161002, "data_time": 600 can be used for 2016-10-02 6:00.
@@ -131,13 +146,23 @@ struct GridDataSetMetaData {
     // Whether to use normalized velocity or normalized vorticity in helicity computation.
     bool useNormalizedVelocity = false;
     bool useNormalizedVorticity = false;
-
+    // Combination of DerivedFieldFlags.
+    uint32_t derivedFields = DERIVED_FIELDS_ALL;
+    // Out-of-core storage in bricks loaded on demand (at the moment only supported by RbcBinFileLoader).
+    bool useBrickedStorage = false;
+    int brickSize = 32;
+    size_t brickCacheMemoryBudget = size_t(1024) * size_t(1024) * size_t(1024);
+
+    // Compares all options that change the grid data, as GridCache::computeKey does. The brick cache budget is left
+    // out, as it can be changed on the loaded grid (@see BrickedGrid::setCacheMemoryBudget).
     inline bool operator==(const GridDataSetMetaData& rhs) const {
         return
                 this->date == rhs.date && this->time == rhs.time && this->scale == rhs.scale && this->axes == rhs.axes
                 && this->velocityFieldName == rhs.velocityFieldName
                 && this->useNormalizedVelocity == rhs.useNormalizedVelocity
-                && this->useNormalizedVorticity == rhs.useNormalizedVorticity;
+                && this->useNormalizedVorticity == rhs.useNormalizedVorticity
+                && this->derivedFields == rhs.derivedFields
+                && this->useBrickedStorage == rhs.useBrickedStorage && this->brickSize == rhs.brickSize;
     }
 };
 
@@ -164,6 +189,20 @@ struct StreamlineTracingSettings {
     int vectorFieldIndex = 0; // TODO: Remove?
     AbcFlowGenerator abcFlowGenerator;
     LoopCheckMode loopCheckMode = LoopCheckMode::START_POINT;
+    // Whether to advance packets of lines in lockstep for StreamlineSeedingStrategy::VOLUME and PLANE.
+    bool usePacketTracing = true;
+    // Derived fields to compute when loading the grid (combination of DerivedFieldFlags).
+    uint32_t derivedFields = DERIVED_FIELDS_ALL;
+    // Grids are cached in memory (LRU with this budget) and optionally in a cache directory on disk (LRU of the files
+    // with a budget of its own).
+    bool useGridDiskCache = true;
+    int gridCacheMemoryBudgetMiB = 4096;
+    int gridCacheDiskBudgetMiB = 16384;
+    // Number of seeds traced speculatively in parallel by MAX_HELICITY_FIRST (0: number of hardware threads).
+    // The traced lines do not depend on it.
+    int maxHelicityFirstBatchSize = 0;
+    // Set by the requester thread. Tracing stops early if the token is cancelled and reports its progress to it.
+    JobToken* jobToken = nullptr;
 
     // For flowPrimitives == FlowPrimitives::STREAMRIBBONS.
     bool useHelicity = true;
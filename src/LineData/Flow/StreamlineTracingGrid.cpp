@@ -30,6 +30,9 @@
 #include <algorithm>
 #include <queue>
 #include <cstring>
+#include <memory>
+#include <thread>
+#include <atomic>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/rotate_vector.hpp>
@@ -44,27 +47,72 @@
 #endif
 
 #include <Utils/File/Logfile.hpp>
+#include <Utils/CircularQueue.hpp>
 #include <Math/Geometry/Plane.hpp>
 #include <Math/Math.hpp>
 
+#include "Utils/RequestScheduler.hpp"
 #include "StreamlineTracingDefines.hpp"
 #include "StreamlineSeeder.hpp"
 #include "StreamlineTracingGrid.hpp"
 
+/**
+ * Loop check state of one worker thread tracing lines with the max. helicity first seeding strategy.
+ */
+struct StreamlineTracerContext {
+    // LoopCheckMode::ALL_POINTS
+    std::unique_ptr<sgl::HashedGrid<glm::vec3>> hashedGridLoop;
+    std::vector<std::pair<glm::vec3, glm::vec3>> closePoints;
+    // LoopCheckMode::GRID
+    std::vector<bool> selfOccupationGrid;
+    std::vector<size_t> occupiedCells; ///< Cells set in selfOccupationGrid by the current line.
+    size_t oldCellPosition = std::numeric_limits<size_t>::max();
+    CircularQueue<size_t> cellPositionQueue;
+    //  LoopCheckMode::CURVATURE
+    double curvatureSum = 0.0;
+    size_t segmentSum = 0;
+    // Whether the last point of the current line was clamped to the domain boundary.
+    bool endsAtBoundary = false;
+};
+
+/**
+ * A seed point of the max. helicity first seeding strategy traced speculatively in a parallel batch.
+ */
+struct MaxHelicityFirstCandidate {
+    glm::vec3 seedPoint{};
+    Trajectory trajectory;
+    Trajectory trajectoryBackward; ///< For StreamlineIntegrationDirection::BOTH.
+    bool endsAtBoundary = false;
+    bool endsAtBoundaryBackward = false;
+};
+
+static constexpr int TRACING_PACKET_SIZE = 16;
+
+/**
+ * Positions and time steps of the lines of one packet advanced in lockstep (structure of arrays).
+ */
+struct TracingPacket {
+    int numLanes = 0;
+    float p[3][TRACING_PACKET_SIZE];
+    float dt[TRACING_PACKET_SIZE];
+};
+
 StreamlineTracingGrid::StreamlineTracingGrid() {
     //curvatureFile.open("curvatures.txt");
 }
 
 StreamlineTracingGrid::~StreamlineTracingGrid() {
-    for (auto& it : vectorFields) {
-        delete[] it.second;
+    if (!mappedFile) {
+        for (auto& it : vectorFields) {
+            delete[] it.second;
+        }
+        for (auto& it : scalarFields) {
+            delete[] it.second;
+        }
     }
     vectorFields.clear();
-
-    for (auto& it : scalarFields) {
-        delete[] it.second;
-    }
     scalarFields.clear();
+    mappedFile = {};
 
     //curvatureFile.close();
 }
@@ -116,6 +164,10 @@ void StreamlineTracingGrid::setGridExtent(int _xs, int _ys, int _zs, float _dx,
 }
 
 void StreamlineTracingGrid::addVectorField(float* vectorField, const std::string& vectorName) {
+    if (mappedFile) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addVectorField: Owned and memory-mapped fields cannot be mixed.");
+    }
     if (transpose) {
         if (transposeAxes != glm::ivec3(0, 2, 1)) {
             sgl::Logfile::get()->throwError(
@@ -218,6 +270,19 @@ void StreamlineTracingGrid::addVectorField(float* vectorField, const std::string
 }
 
 void StreamlineTracingGrid::_setVectorField(StreamlineTracingSettings& tracingSettings) {
+    if (brickedGrid) {
+        tracingSettings.vectorFieldIndex = std::clamp(
+                tracingSettings.vectorFieldIndex, 0, int(brickedVectorFields.size()) - 1);
+        auto it = brickedVectorFields.begin();
+        std::advance(it, tracingSettings.vectorFieldIndex);
+        maxVectorMagnitude = maxVectorFieldMagnitudes.find(it->first)->second;
+        if (velocitySampler.getBrickedGrid() != brickedGrid.get()
+                || velocitySampler.getBrickedFieldIdx() != it->second) {
+            velocitySampler.setBrickedField(brickedGrid, it->second, box.getMinimum(), glm::vec3(dx, dy, dz));
+        }
+        return;
+    }
+
     tracingSettings.vectorFieldIndex = std::clamp(
             tracingSettings.vectorFieldIndex, 0, int(vectorFields.size()) - 1);
     float* vectorField = nullptr;
@@ -230,10 +295,16 @@ void StreamlineTracingGrid::_setVectorField(StreamlineTracingSettings& tracingSe
         }
         i++;
     }
-    V = reinterpret_cast<glm::vec3*>(vectorField);
+    if (velocitySampler.getSourceField() != vectorField) {
+        velocitySampler.setVectorField(vectorField, xs, ys, zs, box.getMinimum(), glm::vec3(dx, dy, dz));
+    }
 }
 
 void StreamlineTracingGrid::addScalarField(float* scalarField, const std::string& scalarName) {
+    if (mappedFile) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addScalarField: Owned and memory-mapped fields cannot be mixed.");
+    }
     if (transpose) {
         if (transposeAxes != glm::ivec3(0, 2, 1)) {
             sgl::Logfile::get()->throwError(
@@ -325,11 +396,93 @@ void StreamlineTracingGrid::addScalarField(float* scalarField, const std::string
     }
 }
 
+void StreamlineTracingGrid::addMappedVectorField(
+        const MappedFilePtr& _mappedFile, const float* vectorField, const std::string& vectorName,
+        float maxMagnitude) {
+    if (transpose || subsamplingFactor > 1 || brickedGrid) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addMappedVectorField: Memory-mapped fields cannot be transformed.");
+    }
+    if (mappedFile != _mappedFile && (mappedFile || !vectorFields.empty() || !scalarFields.empty())) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addMappedVectorField: All fields need to be stored in the same "
+                "memory-mapped file.");
+    }
+    mappedFile = _mappedFile;
+
+    // The fields are only read after loading, so the read-only mapping can be used directly.
+    auto* vectorFieldMapped = const_cast<float*>(vectorField);
+    vectorFields.insert(std::make_pair(vectorName, vectorFieldMapped));
+    maxVectorFieldMagnitudes.insert(std::make_pair(vectorName, maxMagnitude));
+    if (vectorName == "Velocity") {
+        velocityField = vectorFieldMapped;
+    } else if (vectorName == "Vorticity") {
+        vorticityField = vectorFieldMapped;
+    }
+}
+
+void StreamlineTracingGrid::addMappedScalarField(
+        const MappedFilePtr& _mappedFile, const float* scalarField, const std::string& scalarName,
+        float maxMagnitude) {
+    if (transpose || subsamplingFactor > 1 || brickedGrid) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addMappedScalarField: Memory-mapped fields cannot be transformed.");
+    }
+    if (mappedFile != _mappedFile && (mappedFile || !vectorFields.empty() || !scalarFields.empty())) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::addMappedScalarField: All fields need to be stored in the same "
+                "memory-mapped file.");
+    }
+    mappedFile = _mappedFile;
+
+    auto* scalarFieldMapped = const_cast<float*>(scalarField);
+    scalarFields.insert(std::make_pair(scalarName, scalarFieldMapped));
+    if (scalarName == "Helicity") {
+        helicityField = scalarFieldMapped;
+        maxHelicityMagnitude = maxMagnitude;
+    }
+}
+
+size_t StreamlineTracingGrid::getFieldsSizeInBytes() const {
+    size_t numPoints = size_t(xs) * size_t(ys) * size_t(zs);
+    return (vectorFields.size() * 3 + scalarFields.size()) * numPoints * sizeof(float);
+}
+
+void StreamlineTracingGrid::setBrickedGrid(const BrickedGridPtr& _brickedGrid) {
+    if (transpose || subsamplingFactor > 1) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::setBrickedGrid: Transposing and subsampling is not supported for "
+                "out-of-core grids.");
+    }
+    if (!vectorFields.empty() || !scalarFields.empty()) {
+        sgl::Logfile::get()->throwError(
+                "Error in StreamlineTracingGrid::setBrickedGrid: Dense and out-of-core fields cannot be mixed.");
+    }
+    brickedGrid = _brickedGrid;
+    for (int fieldIdx = 0; fieldIdx < brickedGrid->getNumFields(); fieldIdx++) {
+        const std::string& fieldName = brickedGrid->getFieldName(fieldIdx);
+        if (brickedGrid->getFieldNumComponents(fieldIdx) == 3) {
+            brickedVectorFields.insert(std::make_pair(fieldName, fieldIdx));
+            maxVectorFieldMagnitudes.insert(std::make_pair(
+                    fieldName, brickedGrid->computeMaxMagnitude(fieldIdx)));
+        } else {
+            brickedScalarFields.insert(std::make_pair(fieldName, fieldIdx));
+            if (fieldName == "Helicity") {
+                brickedHelicityFieldIdx = fieldIdx;
+                maxHelicityMagnitude = brickedGrid->computeMaxMagnitude(fieldIdx);
+            }
+        }
+    }
+}
+
 std::vector<std::string> StreamlineTracingGrid::getVectorFieldNames() {
     std::vector<std::string> vectorAttributeNames;
     for (auto& it : vectorFields) {
         vectorAttributeNames.push_back(it.first);
     }
+    for (auto& it : brickedVectorFields) {
+        vectorAttributeNames.push_back(it.first);
+    }
     return vectorAttributeNames;
 }
 
@@ -338,6 +491,9 @@ std::vector<std::string> StreamlineTracingGrid::getScalarFieldNames() {
     for (auto& it : scalarFields) {
         scalarAttributeNames.push_back(it.first);
     }
+    for (auto& it : brickedScalarFields) {
+        scalarAttributeNames.push_back(it.first);
+    }
     return scalarAttributeNames;
 }
 
@@ -359,6 +515,7 @@ void StreamlineTracingGrid::traceStreamlines(
 
     Trajectories trajectories;
     trajectories.resize(numTrajectories);
+    std::atomic<int> numFinished{0};
     if (tracingSettings.streamlineSeedingStrategy == StreamlineSeedingStrategy::VOLUME
             || tracingSettings.streamlineSeedingStrategy == StreamlineSeedingStrategy::PLANE) {
         std::vector<glm::vec3> seedPoints;
@@ -367,33 +524,42 @@ void StreamlineTracingGrid::traceStreamlines(
             seedPoint = seeder->getNextPoint();
         }
 
+        if (tracingSettings.usePacketTracing) {
+            _tracePackets(tracingSettings, seedPoints, trajectories, nullptr);
+        } else {
 #ifdef USE_TBB
-        tbb::parallel_for(tbb::blocked_range<int>(0, numTrajectories), [&](auto const& r) {
-            for (auto i = r.begin(); i != r.end(); i++) {
+            tbb::parallel_for(tbb::blocked_range<int>(0, numTrajectories), [&](auto const& r) {
+                for (auto i = r.begin(); i != r.end(); i++) {
 #else
-        #pragma omp parallel for shared(numTrajectories, trajectories, seedPoints, tracingSettings) default(none)
-        for (int i = 0; i < numTrajectories; i++) {
+            #pragma omp parallel for default(none) \
+            shared(numTrajectories, numFinished, trajectories, seedPoints, tracingSettings)
+            for (int i = 0; i < numTrajectories; i++) {
 #endif
-            Trajectory& trajectory = trajectories.at(i);
-            const glm::vec3& seedPoint = seedPoints.at(i);
-            if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
-                _traceStreamline(tracingSettings, trajectory, seedPoint, true);
-            } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
-                _traceStreamline(tracingSettings, trajectory, seedPoint, false);
-                _reverseTrajectory(trajectory);
-            } else {
-                Trajectory trajectoryBackward;
-                _traceStreamline(tracingSettings, trajectory, seedPoint, true);
-                _traceStreamline(tracingSettings, trajectoryBackward, seedPoint, false);
-                _reverseTrajectory(trajectoryBackward);
-                _insertBackwardTrajectory(trajectoryBackward, trajectory);
+                if (_getIsCancelled(tracingSettings)) {
+                    continue;
+                }
+                Trajectory& trajectory = trajectories.at(i);
+                const glm::vec3& seedPoint = seedPoints.at(i);
+                if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
+                    _traceStreamline(tracingSettings, trajectory, seedPoint, true);
+                } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
+                    _traceStreamline(tracingSettings, trajectory, seedPoint, false);
+                    _reverseTrajectory(trajectory);
+                } else {
+                    Trajectory trajectoryBackward;
+                    _traceStreamline(tracingSettings, trajectory, seedPoint, true);
+                    _traceStreamline(tracingSettings, trajectoryBackward, seedPoint, false);
+                    _reverseTrajectory(trajectoryBackward);
+                    _insertBackwardTrajectory(trajectoryBackward, trajectory);
+                }
+                _reportProgress(tracingSettings, numFinished, 1, numTrajectories);
             }
-        }
 #ifdef USE_TBB
-        });
+            });
 #endif
+        }
     } else {
-        for (int i = 0; i < numTrajectories; i++) {
+        for (int i = 0; i < numTrajectories && !_getIsCancelled(tracingSettings); i++) {
             Trajectory& trajectory = trajectories.at(i);
             glm::vec3 seedPoint = seeder->getNextPoint();
             if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
@@ -408,8 +574,12 @@ void StreamlineTracingGrid::traceStreamlines(
                 _reverseTrajectory(trajectoryBackward);
                 _insertBackwardTrajectory(trajectoryBackward, trajectory);
             }
+            _reportProgress(tracingSettings, numFinished, 1, numTrajectories);
         }
     }
+    if (_getIsCancelled(tracingSettings)) {
+        return;
+    }
 
     for (auto& trajectory: trajectories) {
         if (trajectory.positions.empty()) {
@@ -428,7 +598,7 @@ void StreamlineTracingGrid::traceStreamlines(
 void StreamlineTracingGrid::traceStreamribbons(
         StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories,
         std::vector<std::vector<glm::vec3>>& filteredRibbonsDirections) {
-    if (!helicityField) {
+    if (!getHasHelicityField()) {
         sgl::Logfile::get()->writeError(
                 "Error in StreamlineTracingGrid::traceStreamribbons: No helicity field is given!");
         return;
@@ -451,6 +621,7 @@ void StreamlineTracingGrid::traceStreamribbons(
     std::vector<std::vector<glm::vec3>> ribbonsDirections;
     trajectories.resize(numTrajectories);
     ribbonsDirections.resize(numTrajectories);
+    std::atomic<int> numFinished{0};
     if (tracingSettings.streamlineSeedingStrategy == StreamlineSeedingStrategy::VOLUME
             || tracingSettings.streamlineSeedingStrategy == StreamlineSeedingStrategy::PLANE) {
         std::vector<glm::vec3> seedPoints;
@@ -459,38 +630,46 @@ void StreamlineTracingGrid::traceStreamribbons(
             seedPoint = seeder->getNextPoint();
         }
 
+        if (tracingSettings.usePacketTracing) {
+            _tracePackets(tracingSettings, seedPoints, trajectories, &ribbonsDirections);
+        } else {
 #ifdef USE_TBB
-        tbb::parallel_for(tbb::blocked_range<int>(0, numTrajectories), [&](auto const& r) {
-            for (auto i = r.begin(); i != r.end(); i++) {
+            tbb::parallel_for(tbb::blocked_range<int>(0, numTrajectories), [&](auto const& r) {
+                for (auto i = r.begin(); i != r.end(); i++) {
 #else
-        #pragma omp parallel for shared(numTrajectories, trajectories, ribbonsDirections, seedPoints, tracingSettings) \
-        default(none)
-        for (int i = 0; i < numTrajectories; i++) {
+            #pragma omp parallel for default(none) \
+            shared(numTrajectories, numFinished, trajectories, ribbonsDirections, seedPoints, tracingSettings)
+            for (int i = 0; i < numTrajectories; i++) {
 #endif
-            Trajectory& trajectory = trajectories.at(i);
-            std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(i);
-            const glm::vec3& seedPoint = seedPoints.at(i);
-            if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
-                _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, true);
-            } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
-                _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, false);
-                _reverseRibbon(trajectory, ribbonDirections);
-            } else {
-                Trajectory trajectoryBackward;
-                std::vector<glm::vec3> ribbonDirectionsBackward;
-                _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, true);
-                _traceStreamribbon(
-                        tracingSettings, trajectoryBackward, ribbonDirectionsBackward, seedPoint,
-                        false);
-                _reverseRibbon(trajectoryBackward, ribbonDirectionsBackward);
-                _insertBackwardRibbon(trajectoryBackward, ribbonDirectionsBackward, trajectory, ribbonDirections);
+                if (_getIsCancelled(tracingSettings)) {
+                    continue;
+                }
+                Trajectory& trajectory = trajectories.at(i);
+                std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(i);
+                const glm::vec3& seedPoint = seedPoints.at(i);
+                if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
+                    _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, true);
+                } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
+                    _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, false);
+                    _reverseRibbon(trajectory, ribbonDirections);
+                } else {
+                    Trajectory trajectoryBackward;
+                    std::vector<glm::vec3> ribbonDirectionsBackward;
+                    _traceStreamribbon(tracingSettings, trajectory, ribbonDirections, seedPoint, true);
+                    _traceStreamribbon(
+                            tracingSettings, trajectoryBackward, ribbonDirectionsBackward, seedPoint,
+                            false);
+                    _reverseRibbon(trajectoryBackward, ribbonDirectionsBackward);
+                    _insertBackwardRibbon(trajectoryBackward, ribbonDirectionsBackward, trajectory, ribbonDirections);
+                }
+                _reportProgress(tracingSettings, numFinished, 1, numTrajectories);
             }
-        }
 #ifdef USE_TBB
-        });
+            });
 #endif
+        }
     } else {
-        for (int i = 0; i < numTrajectories; i++) {
+        for (int i = 0; i < numTrajectories && !_getIsCancelled(tracingSettings); i++) {
             Trajectory& trajectory = trajectories.at(i);
             std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(i);
             glm::vec3 seedPoint = seeder->getNextPoint();
@@ -509,8 +688,12 @@ void StreamlineTracingGrid::traceStreamribbons(
                 _reverseRibbon(trajectoryBackward, ribbonDirectionsBackward);
                 _insertBackwardRibbon(trajectoryBackward, ribbonDirectionsBackward, trajectory, ribbonDirections);
             }
+            _reportProgress(tracingSettings, numFinished, 1, numTrajectories);
         }
     }
+    if (_getIsCancelled(tracingSettings)) {
+        return;
+    }
 
     for (int trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
         Trajectory& trajectory = trajectories.at(trajectoryIdx);
@@ -544,9 +727,9 @@ float StreamlineTracingGrid::_computeTrajectoryLength(const Trajectory& trajecto
 }
 
 bool StreamlineTracingGrid::_isTerminated(
-        const StreamlineTracingSettings& tracingSettings,
+        const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
         Trajectory& currentTrajectory, const glm::vec3& currentPoint,
-        Trajectories& trajectories, float& segmentLength, int& iterationCounter) {
+        const Trajectories& trajectories, float& segmentLength, int& iterationCounter) const {
 #ifdef TRACY_PROFILE_TRACING
     ZoneScoped;
 #endif
@@ -581,6 +764,7 @@ bool StreamlineTracingGrid::_isTerminated(
             }
             currentTrajectory.positions.emplace_back(boundaryParticlePosition);
             _pushTrajectoryAttributes(currentTrajectory);
+            context.endsAtBoundary = true;
         }
         return true;
     }
@@ -607,10 +791,10 @@ bool StreamlineTracingGrid::_isTerminated(
                 return true;
             }
         } else if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS) {
-            closePoints.clear();
-            hashedGridLoop->findPointsAndDataInSphere(
-                    currentPoint, terminationDistanceStart, closePoints);
-            for (auto& closePoint : closePoints) {
+            context.closePoints.clear();
+            context.hashedGridLoop->findPointsAndDataInSphere(
+                    currentPoint, terminationDistanceStart, context.closePoints);
+            for (auto& closePoint : context.closePoints) {
                 const glm::vec3& pt0 = closePoint.first;
                 const glm::vec3& dir0 = closePoint.second;
                 sgl::Plane plane0(dir0, pt0);
@@ -632,21 +816,24 @@ bool StreamlineTracingGrid::_isTerminated(
             gridPosition.y = glm::clamp(gridPosition.y, 0, ys - 2);
             gridPosition.z = glm::clamp(gridPosition.z, 0, zs - 2);
             size_t cellPosition = IDXS_C(gridPosition.x, gridPosition.y, gridPosition.z);
-            bool occupied = selfOccupationGrid.at(cellPosition);
-            selfOccupationGrid.at(cellPosition) = true;
-            if (occupied && !cellPositionQueue.contains(cellPosition)) {
+            bool occupied = context.selfOccupationGrid.at(cellPosition);
+            if (!occupied) {
+                context.selfOccupationGrid.at(cellPosition) = true;
+                context.occupiedCells.push_back(cellPosition);
+            }
+            if (occupied && !context.cellPositionQueue.contains(cellPosition)) {
                 return true;
             }
             /*if (occupied && cellPosition != oldCellPosition) {
                  return true;
              }*/
-            if (cellPosition != oldCellPosition) {
-                if (cellPositionQueue.size() == cellPositionQueue.capacity()) {
-                    cellPositionQueue.pop_front();
+            if (cellPosition != context.oldCellPosition) {
+                if (context.cellPositionQueue.size() == context.cellPositionQueue.capacity()) {
+                    context.cellPositionQueue.pop_front();
                 }
-                cellPositionQueue.push_back(cellPosition);
+                context.cellPositionQueue.push_back(cellPosition);
             }
-            oldCellPosition = cellPosition;
+            context.oldCellPosition = cellPosition;
         } else if (tracingSettings.loopCheckMode == LoopCheckMode::CURVATURE) {
             if (currentTrajectory.positions.size() > 1) {
                 const glm::vec3& p0 = currentTrajectory.positions.at(currentTrajectory.positions.size() - 2);
@@ -662,10 +849,10 @@ bool StreamlineTracingGrid::_isTerminated(
                 if (length1 > 1e-8f) {
                     dir1 /= length1;
                 }
-                curvatureSum += double(glm::acos(glm::dot(dir0, dir1))) * double(length0 + length1);
-                segmentSum++;
+                context.curvatureSum += double(glm::acos(glm::dot(dir0, dir1))) * double(length0 + length1);
+                context.segmentSum++;
             }
-            if (segmentSum > 100 && curvatureSum > 2.5f) {
+            if (context.segmentSum > 100 && context.curvatureSum > 2.5f) {
                 return true;
             }
         }
@@ -688,17 +875,16 @@ bool StreamlineTracingGrid::_isTerminated(
 
     if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS && !currentTrajectory.positions.empty()) {
         glm::vec3 dir = glm::normalize(currentPoint - currentTrajectory.positions.back());
-        hashedGridLoop->add(std::make_pair(currentPoint, dir));
+        context.hashedGridLoop->add(std::make_pair(currentPoint, dir));
     }
 
     return false;
 }
 
 void StreamlineTracingGrid::_traceStreamlineDecreasingHelicity(
-        const StreamlineTracingSettings& tracingSettings,
-        Trajectory& currentTrajectory, Trajectories& trajectories,
-        std::vector<glm::vec3>& ribbonDirections, const glm::vec3& seedPoint,
-        float& dt, bool forwardMode) {
+        const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
+        Trajectory& currentTrajectory, const Trajectories& trajectories,
+        const glm::vec3& seedPoint, float& dt, bool forwardMode) const {
 #ifdef TRACY_PROFILE_TRACING
     ZoneScoped;
 #endif
@@ -707,9 +893,14 @@ void StreamlineTracingGrid::_traceStreamlineDecreasingHelicity(
     glm::vec3 lastPoint = seedPoint;
     float segmentLength = 0.0f;
     int iterationCounter = 0;
+    context.endsAtBoundary = false;
     while (true) {
+        // Checking the token only every few steps keeps the atomic load out of the hot path.
+        if ((iterationCounter & 63) == 0 && _getIsCancelled(tracingSettings)) {
+            break;
+        }
         if (_isTerminated(
-                tracingSettings, currentTrajectory, currentPoint, trajectories, segmentLength,
+                tracingSettings, context, currentTrajectory, currentPoint, trajectories, segmentLength,
                 iterationCounter)) {
             break;
         } else {
@@ -725,18 +916,145 @@ void StreamlineTracingGrid::_traceStreamlineDecreasingHelicity(
     }
 
     if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS) {
-        hashedGridLoop->clear();
+        context.hashedGridLoop->clear();
     } else if (tracingSettings.loopCheckMode == LoopCheckMode::GRID) {
-        std::fill(selfOccupationGrid.begin(), selfOccupationGrid.end(), false);
-        oldCellPosition = std::numeric_limits<size_t>::max();
-        cellPositionQueue.clear();
+        // Only reset the cells touched by this line instead of the whole grid.
+        for (size_t cellPosition : context.occupiedCells) {
+            context.selfOccupationGrid.at(cellPosition) = false;
+        }
+        context.occupiedCells.clear();
+        context.oldCellPosition = std::numeric_limits<size_t>::max();
+        context.cellPositionQueue.clear();
     } else if (tracingSettings.loopCheckMode == LoopCheckMode::CURVATURE) {
         //curvatureFile << std::to_string(curvatureSum) << '\n';
-        curvatureSum = 0.0;
-        segmentSum = 0;
+        context.curvatureSum = 0.0;
+        context.segmentSum = 0;
+    }
+}
+
+void StreamlineTracingGrid::_traceMaxHelicityFirstCandidate(
+        const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
+        const Trajectories& trajectories, MaxHelicityFirstCandidate& candidate, float dt) const {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
+        _traceStreamlineDecreasingHelicity(
+                tracingSettings, context, candidate.trajectory, trajectories, candidate.seedPoint, dt, true);
+        candidate.endsAtBoundary = context.endsAtBoundary;
+    } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
+        _traceStreamlineDecreasingHelicity(
+                tracingSettings, context, candidate.trajectory, trajectories, candidate.seedPoint, dt, false);
+        candidate.endsAtBoundary = context.endsAtBoundary;
+    } else {
+        _traceStreamlineDecreasingHelicity(
+                tracingSettings, context, candidate.trajectory, trajectories, candidate.seedPoint, dt, true);
+        candidate.endsAtBoundary = context.endsAtBoundary;
+        _traceStreamlineDecreasingHelicity(
+                tracingSettings, context, candidate.trajectoryBackward, trajectories, candidate.seedPoint,
+                dt, false);
+        candidate.endsAtBoundaryBackward = context.endsAtBoundary;
     }
 }
 
+/**
+ * The candidate was traced against the lines committed before its batch. Lines committed earlier in the same batch
+ * may violate the separation distance. As tracing is deterministic, cutting the line at its first point that is now
+ * terminated yields the same line as tracing it sequentially after all lines with higher priority.
+ */
+bool StreamlineTracingGrid::_commitMaxHelicityFirstCandidate(
+        const StreamlineTracingSettings& tracingSettings, const Trajectories& trajectories,
+        size_t numTrajectoriesOld, MaxHelicityFirstCandidate& candidate, std::vector<glm::vec3>& ribbonDirections) {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    Trajectory& trajectory = candidate.trajectory;
+    Trajectory& trajectoryBackward = candidate.trajectoryBackward;
+
+    if (trajectories.size() > numTrajectoriesOld) {
+        auto* seeder = static_cast<StreamlineMaxHelicityFirstSeeder*>(tracingSettings.seeder.get());
+        auto isPointTerminated = [&](const glm::vec3& point) {
+            if (tracingSettings.terminationCheckType != TerminationCheckType::NAIVE) {
+                return seeder->isPointTerminated(point);
+            }
+            for (size_t trajectoryIdx = numTrajectoriesOld; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
+                for (const glm::vec3& otherPoint : trajectories.at(trajectoryIdx).positions) {
+                    if (glm::distance(point, otherPoint) < tracingSettings.minimumSeparationDistance) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        };
+        // The points clamped to the domain boundary were never checked by _isTerminated.
+        auto truncateTrajectory = [&](Trajectory& currentTrajectory, bool endsAtBoundary) {
+            size_t numCheckedPoints = currentTrajectory.positions.size();
+            if (endsAtBoundary && numCheckedPoints > 0) {
+                numCheckedPoints--;
+            }
+            for (size_t i = 0; i < numCheckedPoints; i++) {
+                if (isPointTerminated(currentTrajectory.positions.at(i))) {
+                    currentTrajectory.positions.resize(i);
+                    for (auto& attribute : currentTrajectory.attributes) {
+                        attribute.resize(i);
+                    }
+                    return;
+                }
+            }
+        };
+
+        // Sequential tracing would have skipped this seed point in StreamlineMaxHelicityFirstSeeder::hasNextPoint.
+        if (isPointTerminated(candidate.seedPoint)) {
+            return false;
+        }
+        truncateTrajectory(trajectory, candidate.endsAtBoundary);
+        truncateTrajectory(trajectoryBackward, candidate.endsAtBoundaryBackward);
+    }
+
+    bool isValid = false;
+    if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
+        isValid = _computeTrajectoryLength(trajectory) >= tracingSettings.minimumLength;
+        if (isValid) {
+            if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+                _pushRibbonDirections(tracingSettings, trajectory, ribbonDirections, true);
+            }
+        }
+    } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
+        isValid = _computeTrajectoryLength(trajectory) >= tracingSettings.minimumLength;
+        if (isValid) {
+            if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+                _pushRibbonDirections(tracingSettings, trajectory, ribbonDirections, true);
+                _reverseRibbon(trajectory, ribbonDirections);
+            } else {
+                _reverseTrajectory(trajectory);
+            }
+        }
+    } else {
+        std::vector<glm::vec3> ribbonDirectionsBackward;
+        float totalLength =
+                _computeTrajectoryLength(trajectory) + _computeTrajectoryLength(trajectoryBackward);
+        isValid = totalLength >= tracingSettings.minimumLength;
+
+        if (isValid) {
+            if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+                _pushRibbonDirections(
+                        tracingSettings, trajectory, ribbonDirections, true);
+                _pushRibbonDirections(
+                        tracingSettings, trajectoryBackward, ribbonDirectionsBackward, true);
+                _reverseRibbon(trajectoryBackward, ribbonDirectionsBackward);
+                _insertBackwardRibbon(trajectoryBackward, ribbonDirectionsBackward, trajectory, ribbonDirections);
+            } else {
+                _reverseTrajectory(trajectoryBackward);
+                _insertBackwardTrajectory(trajectoryBackward, trajectory);
+            }
+        }
+    }
+
+    return isValid;
+}
+
 void StreamlineTracingGrid::_traceStreamlinesDecreasingHelicity(
         StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories) {
     std::vector<std::vector<glm::vec3>> filteredRibbonsDirections;
@@ -749,6 +1067,9 @@ void StreamlineTracingGrid::_traceStreamlinesDecreasingHelicity(
  * D. Rees, R. S. Laramee, D. Nguyen, L. Zhang, G. Chen, H. Yeh, and E. Zhang.
  * A stream ribbon seeding strategy. In Proceedings of the Eurographics/IEEE VGTC Conference on Visualization:
  * Short Papers, EuroVis '17, page 67-71, Goslar, DEU, 2017. Eurographics Association.
+ *
+ * The seeds with the highest helicity are traced speculatively in parallel batches (one seed per worker thread) and
+ * committed afterwards in the order of decreasing helicity (@see _commitMaxHelicityFirstCandidate).
  */
 void StreamlineTracingGrid::_traceStreamribbonsDecreasingHelicity(
         StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories,
@@ -757,7 +1078,7 @@ void StreamlineTracingGrid::_traceStreamribbonsDecreasingHelicity(
     ZoneScoped;
 #endif
 
-    if (!helicityField) {
+    if (!getHasHelicityField()) {
         sgl::Logfile::get()->writeError(
                 "Error in StreamlineTracingGrid::_traceStreamribbonsDecreasingHelicity: "
                 "No helicity field was found.");
@@ -771,86 +1092,72 @@ void StreamlineTracingGrid::_traceStreamribbonsDecreasingHelicity(
 
     float dt = 1.0f / maxVectorMagnitude * std::min(dx, std::min(dy, dz)) * tracingSettings.timeStepScale;
 
-    if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS) {
-        hashedGridLoop = new sgl::HashedGrid<glm::vec3>(
-                tracingSettings.maxNumIterations + 17, std::min(dx, std::min(dy, dz)));
-    } else if (tracingSettings.loopCheckMode == LoopCheckMode::GRID) {
-        selfOccupationGrid.resize((xs - 1) * (ys - 1) * (zs - 1), false);
-        cellPositionQueue = CircularQueue<size_t>(32);
+    int numWorkers = tracingSettings.maxHelicityFirstBatchSize;
+    if (numWorkers <= 0) {
+        numWorkers = std::max(int(std::thread::hardware_concurrency()), 1);
+    }
+    std::vector<StreamlineTracerContext> contexts(numWorkers);
+    for (StreamlineTracerContext& context : contexts) {
+        if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS) {
+            context.hashedGridLoop = std::make_unique<sgl::HashedGrid<glm::vec3>>(
+                    tracingSettings.maxNumIterations + 17, std::min(dx, std::min(dy, dz)));
+        } else if (tracingSettings.loopCheckMode == LoopCheckMode::GRID) {
+            context.selfOccupationGrid.resize((xs - 1) * (ys - 1) * (zs - 1), false);
+            context.cellPositionQueue = CircularQueue<size_t>(32);
+        }
     }
 
-    while (seeder->hasNextPoint()) {
-        glm::vec3 seedPoint = seeder->getNextPoint();
+    std::vector<MaxHelicityFirstCandidate> candidates;
+    candidates.reserve(numWorkers);
+    while (!_getIsCancelled(tracingSettings)) {
+        // Gather the next batch of seed points in the order of decreasing helicity.
+        candidates.clear();
+        while (int(candidates.size()) < numWorkers && seeder->hasNextPoint()) {
+            candidates.emplace_back();
+            candidates.back().seedPoint = seeder->getNextPoint();
+        }
+        if (candidates.empty()) {
+            break;
+        }
 
-        Trajectory trajectory;
-        std::vector<glm::vec3> ribbonDirections;
-        bool isValid = false;
-        if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
-            _traceStreamlineDecreasingHelicity(
-                    tracingSettings, trajectory, filteredTrajectories, ribbonDirections, seedPoint,
-                    dt, true);
-            isValid = _computeTrajectoryLength(trajectory) >= tracingSettings.minimumLength;
-            if (isValid) {
-                if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
-                    _pushRibbonDirections(tracingSettings, trajectory, ribbonDirections, true);
-                }
-            }
-        } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
-            _traceStreamlineDecreasingHelicity(
-                    tracingSettings, trajectory, filteredTrajectories, ribbonDirections, seedPoint,
-                    dt, false);
-            isValid = _computeTrajectoryLength(trajectory) >= tracingSettings.minimumLength;
-            if (isValid) {
-                if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
-                    _pushRibbonDirections(tracingSettings, trajectory, ribbonDirections, true);
-                    _reverseRibbon(trajectory, ribbonDirections);
-                } else {
-                    _reverseTrajectory(trajectory);
-                }
-            }
-        } else {
-            Trajectory trajectoryBackward;
-            std::vector<glm::vec3> ribbonDirectionsBackward;
-            _traceStreamlineDecreasingHelicity(
-                    tracingSettings, trajectory, filteredTrajectories, ribbonDirections, seedPoint,
-                    dt, true);
-            _traceStreamlineDecreasingHelicity(
-                    tracingSettings, trajectoryBackward, filteredTrajectories, ribbonDirectionsBackward,
-                    seedPoint, dt, false);
-            float totalLength =
-                    _computeTrajectoryLength(trajectory) + _computeTrajectoryLength(trajectoryBackward);
-            isValid = totalLength >= tracingSettings.minimumLength;
-
-            if (isValid) {
-                if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
-                    _pushRibbonDirections(
-                            tracingSettings, trajectory, ribbonDirections, true);
-                    _pushRibbonDirections(
-                            tracingSettings, trajectoryBackward, ribbonDirectionsBackward, true);
-                    _reverseRibbon(trajectoryBackward, ribbonDirectionsBackward);
-                    _insertBackwardRibbon(trajectoryBackward, ribbonDirectionsBackward, trajectory, ribbonDirections);
-                } else {
-                    _reverseTrajectory(trajectoryBackward);
-                    _insertBackwardTrajectory(trajectoryBackward, trajectory);
-                }
+        // Trace the batch against the lines committed so far. Each worker owns one context.
+        int numCandidates = int(candidates.size());
+        int numBatchWorkers = std::min(numWorkers, numCandidates);
+        std::atomic<int> nextCandidateIdx{0};
+#ifdef USE_TBB
+        tbb::parallel_for(tbb::blocked_range<int>(0, numBatchWorkers, 1), [&](auto const& r) {
+            for (auto workerIdx = r.begin(); workerIdx != r.end(); workerIdx++) {
+#else
+        #pragma omp parallel for schedule(static, 1) default(none) \
+        shared(numBatchWorkers, numCandidates, nextCandidateIdx, contexts, candidates, tracingSettings) \
+        shared(filteredTrajectories, dt)
+        for (int workerIdx = 0; workerIdx < numBatchWorkers; workerIdx++) {
+#endif
+            StreamlineTracerContext& context = contexts.at(workerIdx);
+            int candidateIdx;
+            while ((candidateIdx = nextCandidateIdx.fetch_add(1)) < numCandidates) {
+                _traceMaxHelicityFirstCandidate(
+                        tracingSettings, context, filteredTrajectories, candidates.at(candidateIdx), dt);
             }
         }
+#ifdef USE_TBB
+        });
+#endif
 
-        if (isValid) {
-            filteredTrajectories.push_back(trajectory);
-            if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
-                filteredRibbonsDirections.push_back(ribbonDirections);
+        // Commit the candidates in priority order.
+        size_t numTrajectoriesOld = filteredTrajectories.size();
+        for (MaxHelicityFirstCandidate& candidate : candidates) {
+            std::vector<glm::vec3> ribbonDirections;
+            if (_commitMaxHelicityFirstCandidate(
+                    tracingSettings, filteredTrajectories, numTrajectoriesOld, candidate, ribbonDirections)) {
+                filteredTrajectories.push_back(std::move(candidate.trajectory));
+                if (tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+                    filteredRibbonsDirections.push_back(std::move(ribbonDirections));
+                }
+                seeder->addFinishedTrajectory(filteredTrajectories.back());
             }
-            seeder->addFinishedTrajectory(trajectory);
         }
     }
-
-    if (tracingSettings.loopCheckMode == LoopCheckMode::ALL_POINTS) {
-        delete hashedGridLoop;
-    } else if (tracingSettings.loopCheckMode == LoopCheckMode::GRID) {
-        selfOccupationGrid.clear();
-        selfOccupationGrid.shrink_to_fit();
-    }
 }
 
 
@@ -882,65 +1189,13 @@ float StreamlineTracingGrid::_getScalarFieldAtPosition(
     return interpolationValue;
 }
 
-glm::vec3 StreamlineTracingGrid::_getVectorAtIdx(const glm::ivec3& gridIdx, bool forwardMode) const {
-    if (gridIdx.x < 0 || gridIdx.y < 0 || gridIdx.z < 0 || gridIdx.x >= xs || gridIdx.y >= ys || gridIdx.z >= zs) {
-        return glm::vec3(0.0f);
-    }
-    if (forwardMode) {
-        return V[gridIdx.x + gridIdx.y * xs + gridIdx.z * xs * ys];
-    } else {
-        return -V[gridIdx.x + gridIdx.y * xs + gridIdx.z * xs * ys];
+float StreamlineTracingGrid::_getHelicityAtPosition(const glm::vec3& particlePosition) const {
+    if (brickedGrid) {
+        glm::vec3 gridPositionFloat = particlePosition - box.getMinimum();
+        gridPositionFloat *= glm::vec3(1.0f / dx, 1.0f / dy, 1.0f / dz);
+        return brickedGrid->sampleScalar(brickedHelicityFieldIdx, gridPositionFloat);
     }
-}
-
-glm::vec3 StreamlineTracingGrid::_getVectorAtPosition(
-        const glm::vec3& particlePosition, bool forwardMode) const {
-    glm::vec3 gridPositionFloat = particlePosition - box.getMinimum();
-    gridPositionFloat *= glm::vec3(1.0f / dx, 1.0f / dy, 1.0f / dz);
-    auto gridPosition = glm::ivec3(gridPositionFloat);
-    glm::vec3 frac = glm::fract(gridPositionFloat);
-    glm::vec3 invFrac = glm::vec3(1.0) - frac;
-    glm::vec3 interpolationValue =
-            invFrac.x * invFrac.y * invFrac.z * _getVectorAtIdx(gridPosition + glm::ivec3(0,0,0), forwardMode)
-            + frac.x * invFrac.y * invFrac.z * _getVectorAtIdx(gridPosition + glm::ivec3(1,0,0), forwardMode)
-            + invFrac.x * frac.y * invFrac.z * _getVectorAtIdx(gridPosition + glm::ivec3(0,1,0), forwardMode)
-            + frac.x * frac.y * invFrac.z * _getVectorAtIdx(gridPosition + glm::ivec3(1,1,0), forwardMode)
-            + invFrac.x * invFrac.y * frac.z * _getVectorAtIdx(gridPosition + glm::ivec3(0,0,1), forwardMode)
-            + frac.x * invFrac.y * frac.z * _getVectorAtIdx(gridPosition + glm::ivec3(1,0,1), forwardMode)
-            + invFrac.x * frac.y * frac.z * _getVectorAtIdx(gridPosition + glm::ivec3(0,1,1), forwardMode)
-            + frac.x * frac.y * frac.z * _getVectorAtIdx(gridPosition + glm::ivec3(1,1,1), forwardMode);
-    return interpolationValue;
-}
-
-glm::dvec3 StreamlineTracingGrid::_getVectorAtIdxDouble(
-        const glm::ivec3 &gridIdx, bool forwardMode) const {
-    if (gridIdx.x < 0 || gridIdx.y < 0 || gridIdx.z < 0 || gridIdx.x >= xs || gridIdx.y >= ys || gridIdx.z >= zs) {
-        return glm::dvec3(0.0);
-    }
-    if (forwardMode) {
-        return V[gridIdx.x + gridIdx.y * xs + gridIdx.z * xs * ys];
-    } else {
-        return -V[gridIdx.x + gridIdx.y * xs + gridIdx.z * xs * ys];
-    }
-}
-
-glm::dvec3 StreamlineTracingGrid::_getVectorAtPositionDouble(
-        const glm::dvec3& particlePosition, bool forwardMode) const {
-    glm::dvec3 gridPositionFloat = particlePosition - glm::dvec3(box.getMinimum());
-    gridPositionFloat *= glm::dvec3(1.0 / double(dx), 1.0 / double(dy), 1.0 / double(dz));
-    auto gridPosition = glm::ivec3(gridPositionFloat);
-    glm::dvec3 frac = glm::fract(gridPositionFloat);
-    glm::dvec3 invFrac = glm::dvec3(1.0) - frac;
-    glm::dvec3 interpolationValue =
-            invFrac.x * invFrac.y * invFrac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(0,0,0), forwardMode)
-            + frac.x * invFrac.y * invFrac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(1,0,0), forwardMode)
-            + invFrac.x * frac.y * invFrac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(0,1,0), forwardMode)
-            + frac.x * frac.y * invFrac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(1,1,0), forwardMode)
-            + invFrac.x * invFrac.y * frac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(0,0,1), forwardMode)
-            + frac.x * invFrac.y * frac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(1,0,1), forwardMode)
-            + invFrac.x * frac.y * frac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(0,1,1), forwardMode)
-            + frac.x * frac.y * frac.z * _getVectorAtIdxDouble(gridPosition + glm::ivec3(1,1,1), forwardMode);
-    return interpolationValue;
+    return _getScalarFieldAtPosition(helicityField, particlePosition);
 }
 
 /**
@@ -1009,6 +1264,23 @@ bool StreamlineTracingGrid::_rayBoxIntersection(
     return true;
 }
 
+void StreamlineTracingGrid::_pushBoundaryPosition(Trajectory& trajectory, const glm::vec3& particlePosition) const {
+    // Clamp the position to the boundary.
+    glm::vec3 rayOrigin = trajectory.positions.back();
+    glm::vec3 rayDirection = glm::normalize(particlePosition - rayOrigin);
+    float tNear, tFar;
+    _rayBoxIntersection(
+            rayOrigin, rayDirection, box.getMinimum(), box.getMaximum(), tNear, tFar);
+    glm::vec3 boundaryParticlePosition;
+    if (tNear > 0.0f) {
+        boundaryParticlePosition = rayOrigin + tNear * rayDirection;
+    } else {
+        boundaryParticlePosition = rayOrigin + tFar * rayDirection;
+    }
+    trajectory.positions.emplace_back(boundaryParticlePosition);
+    _pushTrajectoryAttributes(trajectory);
+}
+
 void StreamlineTracingGrid::_pushTrajectoryAttributes(Trajectory& trajectory) const {
 #ifdef TRACY_PROFILE_TRACING
     ZoneScoped;
@@ -1016,12 +1288,21 @@ void StreamlineTracingGrid::_pushTrajectoryAttributes(Trajectory& trajectory) co
 
     // Necessary to initialize the data first?
     if (trajectory.attributes.empty()) {
-        trajectory.attributes.resize(scalarFields.size());
+        trajectory.attributes.resize(scalarFields.size() + brickedScalarFields.size());
     }
 
     glm::vec3 particlePosition = trajectory.positions.back();
     glm::vec3 gridPositionFloat = particlePosition - box.getMinimum();
     gridPositionFloat *= glm::vec3(1.0f / dx, 1.0f / dy, 1.0f / dz);
+
+    if (brickedGrid) {
+        int attributeIdx = 0;
+        for (auto& it : brickedScalarFields) {
+            trajectory.attributes.at(attributeIdx).push_back(brickedGrid->sampleScalar(it.second, gridPositionFloat));
+            attributeIdx++;
+        }
+        return;
+    }
     auto gridPosition = glm::ivec3(gridPositionFloat);
     glm::vec3 frac = glm::fract(gridPositionFloat);
     glm::vec3 invFrac = glm::vec3(1.0) - frac;
@@ -1096,7 +1377,7 @@ void StreamlineTracingGrid::_pushRibbonDirections(
         glm::vec3 ribbonDirection = glm::normalize(helperAxis - glm::dot(helperAxis, tangent) * tangent);
 
         if (tracingSettings.useHelicity) {
-            float helicity = _getScalarFieldAtPosition(helicityField, particlePosition);
+            float helicity = _getHelicityAtPosition(particlePosition);
             if (!forwardMode) {
                 helicity *= -1.0f;
             }
@@ -1211,25 +1492,15 @@ void StreamlineTracingGrid::_trace(
     const float MAX_LINE_LENGTH =
             glm::length(box.getDimensions()) * (float(tracingSettings.maxNumIterations) / float(2000));
     while (iterationCounter <= MAX_ITERATIONS && lineLength <= MAX_LINE_LENGTH) {
+        if ((iterationCounter & 63) == 0 && _getIsCancelled(tracingSettings)) {
+            break;
+        }
         oldParticlePosition = particlePosition;
 
         // Break if the position is outside of the domain.
         if (!box.contains(particlePosition)) {
             if (!trajectory.positions.empty()) {
-                // Clamp the position to the boundary.
-                glm::vec3 rayOrigin = trajectory.positions.back();
-                glm::vec3 rayDirection = glm::normalize(particlePosition - rayOrigin);
-                float tNear, tFar;
-                _rayBoxIntersection(
-                        rayOrigin, rayDirection, box.getMinimum(), box.getMaximum(), tNear, tFar);
-                glm::vec3 boundaryParticlePosition;
-                if (tNear > 0.0f) {
-                    boundaryParticlePosition = rayOrigin + tNear * rayDirection;
-                } else {
-                    boundaryParticlePosition = rayOrigin + tFar * rayDirection;
-                }
-                trajectory.positions.emplace_back(boundaryParticlePosition);
-                _pushTrajectoryAttributes(trajectory);
+                _pushBoundaryPosition(trajectory, particlePosition);
             }
             break;
         }
@@ -1258,6 +1529,181 @@ void StreamlineTracingGrid::_trace(
 }
 
 
+bool StreamlineTracingGrid::_getIsCancelled(const StreamlineTracingSettings& tracingSettings) {
+    return tracingSettings.jobToken && tracingSettings.jobToken->getIsCancelled();
+}
+
+void StreamlineTracingGrid::_reportProgress(
+        const StreamlineTracingSettings& tracingSettings, std::atomic<int>& numFinished, int numNewFinished,
+        int numTotal) {
+    if (tracingSettings.jobToken) {
+        int numFinishedTotal = numFinished.fetch_add(numNewFinished, std::memory_order_relaxed) + numNewFinished;
+        tracingSettings.jobToken->setProgress(float(numFinishedTotal) / float(std::max(numTotal, 1)));
+    }
+}
+
+void StreamlineTracingGrid::_tracePacket(
+        const StreamlineTracingSettings& tracingSettings, Trajectory* trajectories,
+        std::vector<glm::vec3>* ribbonsDirections, const glm::vec3* seedPoints, int numSeeds,
+        bool forwardMode) const {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    // Same termination criteria as in @see _trace, but evaluated per lane.
+    float dt = 1.0f / maxVectorMagnitude * std::min(dx, std::min(dy, dz)) * tracingSettings.timeStepScale;
+    float terminationDistance = 1e-6f * tracingSettings.terminationDistance;
+    const int MAX_ITERATIONS = std::min(
+            int(std::round(float(tracingSettings.maxNumIterations) / tracingSettings.timeStepScale)),
+            tracingSettings.maxNumIterations * 10);
+    const float MAX_LINE_LENGTH =
+            glm::length(box.getDimensions()) * (float(tracingSettings.maxNumIterations) / float(2000));
+
+    glm::vec3 particlePositions[TRACING_PACKET_SIZE];
+    float timeSteps[TRACING_PACKET_SIZE];
+    int iterationCounters[TRACING_PACKET_SIZE];
+    float lineLengths[TRACING_PACKET_SIZE];
+    int activeLanes[TRACING_PACKET_SIZE];
+    int numActiveLanes = 0;
+    for (int lane = 0; lane < numSeeds; lane++) {
+        particlePositions[lane] = seedPoints[lane];
+        timeSteps[lane] = dt;
+        iterationCounters[lane] = 0;
+        lineLengths[lane] = 0.0f;
+        activeLanes[numActiveLanes++] = lane;
+    }
+
+    TracingPacket packet;
+    while (numActiveLanes > 0 && !_getIsCancelled(tracingSettings)) {
+        // Add the current positions and gather the lanes that still need to be integrated.
+        int numSteppingLanes = 0;
+        for (int i = 0; i < numActiveLanes; i++) {
+            int lane = activeLanes[i];
+            if (iterationCounters[lane] > MAX_ITERATIONS || lineLengths[lane] > MAX_LINE_LENGTH) {
+                continue;
+            }
+            Trajectory& trajectory = trajectories[lane];
+            const glm::vec3& particlePosition = particlePositions[lane];
+            if (!box.contains(particlePosition)) {
+                if (!trajectory.positions.empty()) {
+                    _pushBoundaryPosition(trajectory, particlePosition);
+                }
+                continue;
+            }
+            trajectory.positions.push_back(particlePosition);
+            _pushTrajectoryAttributes(trajectory);
+
+            activeLanes[numSteppingLanes] = lane;
+            for (int c = 0; c < 3; c++) {
+                packet.p[c][numSteppingLanes] = particlePosition[c];
+            }
+            packet.dt[numSteppingLanes] = timeSteps[lane];
+            numSteppingLanes++;
+        }
+        if (numSteppingLanes == 0) {
+            break;
+        }
+
+        packet.numLanes = numSteppingLanes;
+        _integrationStepPacket(tracingSettings, packet, forwardMode);
+
+        numActiveLanes = 0;
+        for (int i = 0; i < numSteppingLanes; i++) {
+            int lane = activeLanes[i];
+            glm::vec3 particlePosition(packet.p[0][i], packet.p[1][i], packet.p[2][i]);
+            float segmentLength = glm::length(particlePosition - particlePositions[lane]);
+            particlePositions[lane] = particlePosition;
+            timeSteps[lane] = packet.dt[i];
+            lineLengths[lane] += segmentLength;
+
+            // Have we reached a singular point?
+            if (segmentLength < terminationDistance) {
+                continue;
+            }
+            iterationCounters[lane]++;
+            activeLanes[numActiveLanes++] = lane;
+        }
+    }
+
+    if (ribbonsDirections && tracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+        for (int lane = 0; lane < numSeeds; lane++) {
+            _pushRibbonDirections(tracingSettings, trajectories[lane], ribbonsDirections[lane], forwardMode);
+        }
+    }
+}
+
+void StreamlineTracingGrid::_tracePackets(
+        const StreamlineTracingSettings& tracingSettings, const std::vector<glm::vec3>& seedPoints,
+        Trajectories& trajectories, std::vector<std::vector<glm::vec3>>* ribbonsDirections) const {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    int numSeeds = int(seedPoints.size());
+    int numPackets = sgl::iceil(numSeeds, TRACING_PACKET_SIZE);
+    std::atomic<int> numFinished{0};
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numPackets), [&](auto const& r) {
+        for (auto packetIdx = r.begin(); packetIdx != r.end(); packetIdx++) {
+#else
+    #pragma omp parallel for schedule(dynamic) default(none) \
+    shared(numSeeds, numPackets, numFinished, seedPoints, trajectories, ribbonsDirections, tracingSettings)
+    for (int packetIdx = 0; packetIdx < numPackets; packetIdx++) {
+#endif
+        if (_getIsCancelled(tracingSettings)) {
+            continue;
+        }
+        int seedOffset = packetIdx * TRACING_PACKET_SIZE;
+        int numPacketSeeds = std::min(TRACING_PACKET_SIZE, numSeeds - seedOffset);
+        const glm::vec3* packetSeedPoints = seedPoints.data() + seedOffset;
+        Trajectory* packetTrajectories = trajectories.data() + seedOffset;
+        std::vector<glm::vec3>* packetRibbonsDirections =
+                ribbonsDirections ? ribbonsDirections->data() + seedOffset : nullptr;
+
+        if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::FORWARD) {
+            _tracePacket(
+                    tracingSettings, packetTrajectories, packetRibbonsDirections, packetSeedPoints,
+                    numPacketSeeds, true);
+        } else if (tracingSettings.integrationDirection == StreamlineIntegrationDirection::BACKWARD) {
+            _tracePacket(
+                    tracingSettings, packetTrajectories, packetRibbonsDirections, packetSeedPoints,
+                    numPacketSeeds, false);
+            for (int lane = 0; lane < numPacketSeeds; lane++) {
+                if (packetRibbonsDirections) {
+                    _reverseRibbon(packetTrajectories[lane], packetRibbonsDirections[lane]);
+                } else {
+                    _reverseTrajectory(packetTrajectories[lane]);
+                }
+            }
+        } else {
+            Trajectory trajectoriesBackward[TRACING_PACKET_SIZE];
+            std::vector<glm::vec3> ribbonsDirectionsBackward[TRACING_PACKET_SIZE];
+            _tracePacket(
+                    tracingSettings, packetTrajectories, packetRibbonsDirections, packetSeedPoints,
+                    numPacketSeeds, true);
+            _tracePacket(
+                    tracingSettings, trajectoriesBackward,
+                    packetRibbonsDirections ? ribbonsDirectionsBackward : nullptr, packetSeedPoints,
+                    numPacketSeeds, false);
+            for (int lane = 0; lane < numPacketSeeds; lane++) {
+                if (packetRibbonsDirections) {
+                    _reverseRibbon(trajectoriesBackward[lane], ribbonsDirectionsBackward[lane]);
+                    _insertBackwardRibbon(
+                            trajectoriesBackward[lane], ribbonsDirectionsBackward[lane],
+                            packetTrajectories[lane], packetRibbonsDirections[lane]);
+                } else {
+                    _reverseTrajectory(trajectoriesBackward[lane]);
+                    _insertBackwardTrajectory(trajectoriesBackward[lane], packetTrajectories[lane]);
+                }
+            }
+        }
+        _reportProgress(tracingSettings, numFinished, numPacketSeeds, numSeeds);
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
 void StreamlineTracingGrid::_integrationStep(
         const StreamlineTracingSettings& tracingSettings, glm::vec3& p0, float& dt, bool forwardMode) const {
     if (tracingSettings.integrationMethod == StreamlineIntegrationMethod::EXPLICIT_EULER) {
@@ -1395,6 +1841,202 @@ void StreamlineTracingGrid::_integrationStepRKF45(
     fDt = float(dt);
 }
 
+void StreamlineTracingGrid::_integrationStepPacket(
+        const StreamlineTracingSettings& tracingSettings, TracingPacket& packet, bool forwardMode) const {
+    if (tracingSettings.integrationMethod == StreamlineIntegrationMethod::RK4) {
+        _integrationStepRK4Packet(packet, forwardMode);
+    } else if (tracingSettings.integrationMethod == StreamlineIntegrationMethod::RKF45) {
+        _integrationStepRKF45Packet(tracingSettings, packet, forwardMode);
+    } else {
+        for (int i = 0; i < packet.numLanes; i++) {
+            glm::vec3 p0(packet.p[0][i], packet.p[1][i], packet.p[2][i]);
+            _integrationStep(tracingSettings, p0, packet.dt[i], forwardMode);
+            for (int c = 0; c < 3; c++) {
+                packet.p[c][i] = p0[c];
+            }
+        }
+    }
+}
+
+/**
+ * Packet version of @see _integrationStepRK4. Uses the same order of operations per lane.
+ */
+void StreamlineTracingGrid::_integrationStepRK4Packet(TracingPacket& packet, bool forwardMode) const {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    const int n = packet.numLanes;
+    float k[4][3][TRACING_PACKET_SIZE];
+    float q[3][TRACING_PACKET_SIZE];
+    float v[3][TRACING_PACKET_SIZE];
+
+    velocitySampler.samplePacket(packet.p[0], packet.p[1], packet.p[2], v[0], v[1], v[2], n, forwardMode);
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < n; i++) {
+            k[0][c][i] = packet.dt[i] * v[c][i];
+            q[c][i] = packet.p[c][i] + k[0][c][i] * float(0.5);
+        }
+    }
+    velocitySampler.samplePacket(q[0], q[1], q[2], v[0], v[1], v[2], n, forwardMode);
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < n; i++) {
+            k[1][c][i] = packet.dt[i] * v[c][i];
+            q[c][i] = packet.p[c][i] + k[1][c][i] * float(0.5);
+        }
+    }
+    velocitySampler.samplePacket(q[0], q[1], q[2], v[0], v[1], v[2], n, forwardMode);
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < n; i++) {
+            k[2][c][i] = packet.dt[i] * v[c][i];
+            q[c][i] = packet.p[c][i] + k[2][c][i];
+        }
+    }
+    velocitySampler.samplePacket(q[0], q[1], q[2], v[0], v[1], v[2], n, forwardMode);
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < n; i++) {
+            k[3][c][i] = packet.dt[i] * v[c][i];
+            packet.p[c][i] +=
+                    k[0][c][i] / float(6.0) + k[1][c][i] / float(3.0)
+                    + k[2][c][i] / float(3.0) + k[3][c][i] / float(6.0);
+        }
+    }
+}
+
+/**
+ * Packet version of @see _integrationStepRKF45. Each lane adapts its own time step. Lanes are removed from the packet
+ * as soon as their truncation error is small enough.
+ */
+void StreamlineTracingGrid::_integrationStepRKF45Packet(
+        const StreamlineTracingSettings& tracingSettings, TracingPacket& packet, bool forwardMode) const {
+#ifdef TRACY_PROFILE_TRACING
+    ZoneScoped;
+#endif
+
+    const double EPSILON =
+            double(2.0 * 1e-5) * double(std::min(dx, std::min(dy, dz))) * double(tracingSettings.timeStepScale);
+    const int MAX_NUM_ITERATIONS = 100;
+
+    // Lanes that still adapt their time step (compacted at the start of the arrays).
+    int laneIndices[TRACING_PACKET_SIZE];
+    double p0[3][TRACING_PACKET_SIZE];
+    double dt[TRACING_PACKET_SIZE];
+    int n = packet.numLanes;
+    for (int i = 0; i < n; i++) {
+        laneIndices[i] = i;
+        dt[i] = packet.dt[i];
+        for (int c = 0; c < 3; c++) {
+            p0[c][i] = packet.p[c][i];
+        }
+    }
+
+    double k[6][3][TRACING_PACKET_SIZE];
+    double q[3][TRACING_PACKET_SIZE];
+    double v[3][TRACING_PACKET_SIZE];
+    double approximationRK5[3][TRACING_PACKET_SIZE];
+    auto sampleStage = [&](int stage) {
+        velocitySampler.samplePacketDouble(q[0], q[1], q[2], v[0], v[1], v[2], n, forwardMode);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                k[stage][c][i] = dt[i] * v[c][i];
+            }
+        }
+    };
+
+    int iteration = 0;
+    while (n > 0 && iteration < MAX_NUM_ITERATIONS) {
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] = p0[c][i];
+            }
+        }
+        sampleStage(0);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] = p0[c][i] + k[0][c][i] * double(1.0 / 4.0);
+            }
+        }
+        sampleStage(1);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] = p0[c][i] + k[0][c][i] * double(3.0 / 32.0) + k[1][c][i] * double(9.0 / 32.0);
+            }
+        }
+        sampleStage(2);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] =
+                        p0[c][i] + k[0][c][i] * double(1932.0 / 2197.0) - k[1][c][i] * double(7200.0 / 2197.0)
+                        + k[2][c][i] * double(7296.0 / 2197.0);
+            }
+        }
+        sampleStage(3);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] =
+                        p0[c][i] + k[0][c][i] * double(439.0 / 216.0) - k[1][c][i] * double(8.0)
+                        + k[2][c][i] * double(3680.0 / 513.0) - k[3][c][i] * double(845.0 / 4104.0);
+            }
+        }
+        sampleStage(4);
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                q[c][i] =
+                        p0[c][i] - k[0][c][i] * double(8.0 / 27.0) + k[1][c][i] * double(2.0)
+                        - k[2][c][i] * double(3544.0 / 2565.0) + k[3][c][i] * double(1859.0 / 4104.0)
+                        - k[4][c][i] * double(11.0 / 40.0);
+            }
+        }
+        sampleStage(5);
+
+        double truncationErrorTerm[3][TRACING_PACKET_SIZE];
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < n; i++) {
+                approximationRK5[c][i] =
+                        p0[c][i] + k[0][c][i] * double(16.0/135.0) + k[2][c][i] * double(6656.0/12825.0)
+                        + k[3][c][i] * double(28561.0/56430.0) - k[4][c][i] * double(9.0/50.0)
+                        + k[5][c][i] * double(2.0/55.0);
+                truncationErrorTerm[c][i] =
+                        k[0][c][i] * double(1.0/360.0) + k[2][c][i] * double(-128.0/4275.0)
+                        + k[3][c][i] * double(-2197.0/75240.0) + k[4][c][i] * (1.0/50.0)
+                        + k[5][c][i] * double(2.0/55.0);
+            }
+        }
+        iteration++;
+
+        // Write back the converged lanes and compact the remaining ones.
+        int numAdaptingLanes = 0;
+        for (int i = 0; i < n; i++) {
+            double TE = glm::length(glm::dvec3(
+                    truncationErrorTerm[0][i], truncationErrorTerm[1][i], truncationErrorTerm[2][i]));
+            int lane = laneIndices[i];
+            bool timestepNeedsAdaptation = TE > EPSILON;
+            if (timestepNeedsAdaptation) {
+                dt[i] = 0.9 * dt[i] * std::pow(EPSILON / TE, double(1.0/5.0));
+            }
+            if (!timestepNeedsAdaptation || iteration >= MAX_NUM_ITERATIONS) {
+                for (int c = 0; c < 3; c++) {
+                    packet.p[c][lane] = float(approximationRK5[c][i]);
+                }
+                packet.dt[lane] = float(dt[i]);
+                continue;
+            }
+            laneIndices[numAdaptingLanes] = lane;
+            dt[numAdaptingLanes] = dt[i];
+            for (int c = 0; c < 3; c++) {
+                p0[c][numAdaptingLanes] = p0[c][i];
+            }
+            numAdaptingLanes++;
+        }
+        if (iteration >= MAX_NUM_ITERATIONS) {
+            sgl::Logfile::get()->writeError(
+                    "Error in StreamlineTracingGrid::_integrationStepRKF45Packet: The timestep adaption has not "
+                    "converged within a reasonable number of iterations.");
+        }
+        n = numAdaptingLanes;
+    }
+}
+
 void StreamlineTracingGrid::computeSimulationBoundaryMesh(
         std::vector<uint32_t>& cachedSimulationMeshOutlineTriangleIndices,
         std::vector<glm::vec3>& cachedSimulationMeshOutlineVertexPositions) {
@@ -32,10 +32,12 @@
 #include <string>
 #include <map>
 #include <fstream>
-
-#include <Utils/CircularQueue.hpp>
+#include <atomic>
 
 #include "Loaders/TrajectoryFile.hpp"
+#include "Utils/MappedFile.hpp"
+#include "VectorFieldSampler.hpp"
+#include "BrickedGrid.hpp"
 
 namespace sgl {
 template<class T>
@@ -44,6 +46,9 @@ class HashedGrid;
 
 struct StreamlineTracingSettings;
 class StreamlineSeeder;
+struct StreamlineTracerContext;
+struct MaxHelicityFirstCandidate;
+struct TracingPacket;
 
 /**
  * Stores a Cartesian grid. At each grid point, scalar data and velocity data is stored.
@@ -58,6 +63,31 @@ public:
     void setGridExtent(int _xs, int _ys, int _zs, float _dx, float _dy, float _dz);
     void addVectorField(float* vectorField, const std::string& vectorName);
     void addScalarField(float* scalarField, const std::string& scalarName);
+    /**
+     * Uses the fields of an out-of-core grid instead of dense fields. The grid size needs to be set beforehand using
+     * @see setGridExtent. Fields with three components are used as vector fields, all others as scalar fields.
+     */
+    void setBrickedGrid(const BrickedGridPtr& _brickedGrid);
+    [[nodiscard]] inline const BrickedGridPtr& getBrickedGrid() const { return brickedGrid; }
+    /**
+     * Adds a field stored in a memory-mapped file (@see GridCache). The data is neither copied nor transformed, so
+     * transposing and subsampling need to be applied already. The mapping is kept alive by the grid.
+     * @param maxMagnitude The maximum vector magnitude (for "Helicity": the maximum absolute value) of the field.
+     */
+    void addMappedVectorField(
+            const MappedFilePtr& _mappedFile, const float* vectorField, const std::string& vectorName,
+            float maxMagnitude);
+    void addMappedScalarField(
+            const MappedFilePtr& _mappedFile, const float* scalarField, const std::string& scalarName,
+            float maxMagnitude);
+    [[nodiscard]] inline const std::map<std::string, float*>& getVectorFields() const { return vectorFields; }
+    [[nodiscard]] inline const std::map<std::string, float*>& getScalarFields() const { return scalarFields; }
+    [[nodiscard]] inline float getMaxVectorFieldMagnitude(const std::string& vectorName) const {
+        return maxVectorFieldMagnitudes.find(vectorName)->second;
+    }
+    [[nodiscard]] inline float getMaxHelicityMagnitude() const { return maxHelicityMagnitude; }
+    /// Returns the size of all dense fields in bytes.
+    [[nodiscard]] size_t getFieldsSizeInBytes() const;
     std::vector<std::string> getVectorFieldNames();
     std::vector<std::string> getScalarFieldNames();
     [[nodiscard]] inline const sgl::AABB3& getBox() const { return box; }
@@ -70,6 +100,13 @@ public:
     [[nodiscard]] inline float* getVelocityField() const { return velocityField; }
     [[nodiscard]] inline float* getVorticityField() const { return vorticityField; }
     [[nodiscard]] inline float* getHelicityField() const { return helicityField; }
+    [[nodiscard]] inline bool getHasHelicityField() const { return helicityField || brickedHelicityFieldIdx >= 0; }
+    [[nodiscard]] inline float getHelicityAtIdx(int x, int y, int z) const {
+        if (brickedGrid) {
+            return brickedGrid->getScalarAtIdx(brickedHelicityFieldIdx, x, y, z);
+        }
+        return helicityField[z * xs * ys + y * xs + x];
+    }
 
     void traceStreamlines(StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories);
     void traceStreamribbons(
@@ -84,15 +121,20 @@ private:
     void _setVectorField(StreamlineTracingSettings& tracingSettings);
     float _getScalarFieldAtIdx(const float* scalarField, const glm::ivec3& gridIdx) const;
     float _getScalarFieldAtPosition(const float* scalarField, const glm::vec3& particlePosition) const;
-    [[nodiscard]] glm::vec3 _getVectorAtIdx(const glm::ivec3& gridIdx, bool forwardMode) const;
-    [[nodiscard]] glm::vec3 _getVectorAtPosition(const glm::vec3& particlePosition, bool forwardMode) const;
-    [[nodiscard]] glm::dvec3 _getVectorAtIdxDouble(const glm::ivec3& gridIdx, bool forwardMode) const;
-    [[nodiscard]] glm::dvec3 _getVectorAtPositionDouble(const glm::dvec3& particlePosition, bool forwardMode) const;
+    float _getHelicityAtPosition(const glm::vec3& particlePosition) const;
+    [[nodiscard]] inline glm::vec3 _getVectorAtPosition(const glm::vec3& particlePosition, bool forwardMode) const {
+        return velocitySampler.sample(particlePosition, forwardMode);
+    }
+    [[nodiscard]] inline glm::dvec3 _getVectorAtPositionDouble(
+            const glm::dvec3& particlePosition, bool forwardMode) const {
+        return velocitySampler.sampleDouble(particlePosition, forwardMode);
+    }
     static bool _rayBoxIntersection(
             const glm::vec3& rayOrigin, const glm::vec3& rayDirection, const glm::vec3& lower, const glm::vec3& upper,
             float& tNear, float& tFar);
     static bool _rayBoxPlaneIntersection(
             float rayOriginX, float rayDirectionX, float lowerX, float upperX, float& tNear, float& tFar);
+    void _pushBoundaryPosition(Trajectory& trajectory, const glm::vec3& particlePosition) const;
     void _pushTrajectoryAttributes(Trajectory& trajectory) const;
     void _pushRibbonDirections(
             const StreamlineTracingSettings& tracingSettings,
@@ -119,21 +161,43 @@ private:
             const StreamlineTracingSettings& tracingSettings, Trajectory& trajectory,
             std::vector<glm::vec3>& ribbonDirections, const glm::vec3& seedPoint, bool forwardMode) const;
 
+    /// Whether the requester cancelled the request (@see StreamlineTracingSettings::jobToken).
+    static bool _getIsCancelled(const StreamlineTracingSettings& tracingSettings);
+    /// Adds numNewFinished to the number of traced lines and reports the progress to the requester.
+    static void _reportProgress(
+            const StreamlineTracingSettings& tracingSettings, std::atomic<int>& numFinished, int numNewFinished,
+            int numTotal);
+
+    /// Traces the seed points in packets of TRACING_PACKET_SIZE lines advanced in lockstep (in parallel).
+    void _tracePackets(
+            const StreamlineTracingSettings& tracingSettings, const std::vector<glm::vec3>& seedPoints,
+            Trajectories& trajectories, std::vector<std::vector<glm::vec3>>* ribbonsDirections) const;
+    void _tracePacket(
+            const StreamlineTracingSettings& tracingSettings, Trajectory* trajectories,
+            std::vector<glm::vec3>* ribbonsDirections, const glm::vec3* seedPoints, int numSeeds,
+            bool forwardMode) const;
+
     void _traceStreamlinesDecreasingHelicity(
             StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories);
     void _traceStreamribbonsDecreasingHelicity(
             StreamlineTracingSettings& tracingSettings, Trajectories& filteredTrajectories,
             std::vector<std::vector<glm::vec3>>& filteredRibbonsDirections);
     void _traceStreamlineDecreasingHelicity(
-            const StreamlineTracingSettings& tracingSettings,
-            Trajectory& currentTrajectory, Trajectories& trajectories,
-            std::vector<glm::vec3>& ribbonDirections, const glm::vec3& seedPoint,
-            float& dt, bool forwardMode);
+            const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
+            Trajectory& currentTrajectory, const Trajectories& trajectories,
+            const glm::vec3& seedPoint, float& dt, bool forwardMode) const;
+    void _traceMaxHelicityFirstCandidate(
+            const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
+            const Trajectories& trajectories, MaxHelicityFirstCandidate& candidate, float dt) const;
+    bool _commitMaxHelicityFirstCandidate(
+            const StreamlineTracingSettings& tracingSettings, const Trajectories& trajectories,
+            size_t numTrajectoriesOld, MaxHelicityFirstCandidate& candidate,
+            std::vector<glm::vec3>& ribbonDirections);
     float _computeTrajectoryLength(const Trajectory& trajectory);
     bool _isTerminated(
-            const StreamlineTracingSettings& tracingSettings,
+            const StreamlineTracingSettings& tracingSettings, StreamlineTracerContext& context,
             Trajectory& currentTrajectory, const glm::vec3& currentPoint,
-            Trajectories& trajectories, float& segmentLength, int& iterationCounter);
+            const Trajectories& trajectories, float& segmentLength, int& iterationCounter) const;
 
     void _integrationStepExplicitEuler(glm::vec3& p0, float& dt, bool forwardMode) const;
     void _integrationStepImplicitEuler(glm::vec3& p0, float& dt, bool forwardMode) const;
@@ -144,6 +208,11 @@ private:
             const StreamlineTracingSettings& tracingSettings, glm::vec3& fP0, float& fDt, bool forwardMode) const;
     void _integrationStep(
             const StreamlineTracingSettings& tracingSettings, glm::vec3& p0, float& dt, bool forwardMode) const;
+    void _integrationStepRK4Packet(TracingPacket& packet, bool forwardMode) const;
+    void _integrationStepRKF45Packet(
+            const StreamlineTracingSettings& tracingSettings, TracingPacket& packet, bool forwardMode) const;
+    void _integrationStepPacket(
+            const StreamlineTracingSettings& tracingSettings, TracingPacket& packet, bool forwardMode) const;
 
     int xs = 0, ys = 0, zs = 0; ///< Size of the grid in data points.
     float dx = 0.0f, dy = 0.0f, dz = 0.0f; ///< Distance between two neighboring points in x/y/z direction.
@@ -155,24 +224,21 @@ private:
     float* velocityField = nullptr;
     float* vorticityField = nullptr;
     float* helicityField = nullptr;
-    glm::vec3* V = nullptr;
+    VectorFieldSampler velocitySampler; ///< Samples the vector field selected for tracing in place.
     float maxVectorMagnitude = 0.0f;
     float maxHelicityMagnitude = 0.0f;
     std::map<std::string, float*> vectorFields;
     std::map<std::string, float> maxVectorFieldMagnitudes;
     std::map<std::string, float*> scalarFields;
+    // Set if the dense fields above point into a memory-mapped cache file instead of being owned by the grid.
+    MappedFilePtr mappedFile;
+    // Out-of-core storage (replaces the dense fields above if set). The maps store the field indices in the grid.
+    BrickedGridPtr brickedGrid;
+    std::map<std::string, int> brickedVectorFields;
+    std::map<std::string, int> brickedScalarFields;
+    int brickedHelicityFieldIdx = -1;
     // LoopCheckMode::START_POINT and LoopCheckMode::ALL_POINTS
     float terminationDistanceStart = 0.0f;
-    // LoopCheckMode::ALL_POINTS
-    sgl::HashedGrid<glm::vec3>* hashedGridLoop = nullptr;
-    std::vector<std::pair<glm::vec3, glm::vec3>> closePoints;
-    // LoopCheckMode::GRID
-    std::vector<bool> selfOccupationGrid;
-    size_t oldCellPosition = std::numeric_limits<size_t>::max();
-    CircularQueue<size_t> cellPositionQueue;
-    //  LoopCheckMode::CURVATURE
-    double curvatureSum = 0.0;
-    size_t segmentSum = 0;
     // Test data.
     //std::ofstream curvatureFile;
 };
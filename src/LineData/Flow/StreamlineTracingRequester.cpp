@@ -61,7 +61,7 @@
 #include "StreamlineTracingRequester.hpp"
 
 StreamlineTracingRequester::StreamlineTracingRequester(sgl::TransferFunctionWindow& transferFunctionWindow)
-        : transferFunctionWindow(transferFunctionWindow) {
+        : transferFunctionWindow(transferFunctionWindow), requestScheduler("StreamlineTracingRequester") {
     streamlineSeeders.insert(std::make_pair(
             StreamlineSeedingStrategy::VOLUME, StreamlineSeederPtr(new StreamlineVolumeSeeder)));
     streamlineSeeders.insert(std::make_pair(
@@ -72,20 +72,17 @@ StreamlineTracingRequester::StreamlineTracingRequester(sgl::TransferFunctionWind
     guiTracingSettings.seeder = streamlineSeeders[guiTracingSettings.streamlineSeedingStrategy];
 
     lineDataSetsDirectory = sgl::AppSettings::get()->getDataDirectory() + "LineDataSets/";
+    gridCache = std::make_unique<GridCache>(
+            sgl::AppSettings::get()->getDataDirectory() + "Cache/FlowGrids/",
+            size_t(guiTracingSettings.gridCacheMemoryBudgetMiB) * size_t(1024 * 1024));
     loadGridDataSetList();
-    requesterThread = std::thread(&StreamlineTracingRequester::mainLoop, this);
 }
 
 StreamlineTracingRequester::~StreamlineTracingRequester() {
-    join();
+    requestScheduler.join();
 
-    if (cachedGrid) {
-        delete cachedGrid;
-        cachedGrid = nullptr;
-    }
-
-    requestLineData = {};
-    replyLineData = {};
+    cachedGrid = {};
+    gridCache = {};
 }
 
 void StreamlineTracingRequester::loadGridDataSetList() {
@@ -177,6 +174,16 @@ void StreamlineTracingRequester::loadGridDataSetList() {
             if (source.isMember("velocity_field_name")) {
                 gridDataSetMetaData.velocityFieldName = source["velocity_field_name"].asString();
             }
+            if (source.isMember("bricked_storage")) {
+                gridDataSetMetaData.useBrickedStorage = source["bricked_storage"].asBool();
+            }
+            if (source.isMember("brick_size")) {
+                gridDataSetMetaData.brickSize = source["brick_size"].asInt();
+            }
+            if (source.isMember("brick_cache_budget_mib")) {
+                gridDataSetMetaData.brickCacheMemoryBudget =
+                        size_t(source["brick_cache_budget_mib"].asUInt64()) * size_t(1024) * size_t(1024);
+            }
             gridDataSetsMetaData.push_back(gridDataSetMetaData);
         }
     }
@@ -345,6 +352,23 @@ void StreamlineTracingRequester::renderGui() {
                 }
             }
 
+            if (ImGui::CheckboxFlags(
+                    "Velocity Magnitude", &guiTracingSettings.derivedFields, DERIVED_FIELD_VELOCITY_MAGNITUDE)) {
+                changed = true;
+            }
+            ImGui::SameLine();
+            if (ImGui::CheckboxFlags("Vorticity", &guiTracingSettings.derivedFields, DERIVED_FIELD_VORTICITY)) {
+                changed = true;
+            }
+            if (ImGui::CheckboxFlags(
+                    "Vorticity Magnitude", &guiTracingSettings.derivedFields, DERIVED_FIELD_VORTICITY_MAGNITUDE)) {
+                changed = true;
+            }
+            ImGui::SameLine();
+            if (ImGui::CheckboxFlags("Helicity", &guiTracingSettings.derivedFields, DERIVED_FIELD_HELICITY)) {
+                changed = true;
+            }
+
             if (guiTracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
                 if (ImGui::Checkbox("Use Helicity Ribbons", &guiTracingSettings.useHelicity)) {
                     changed = true;
@@ -375,6 +399,14 @@ void StreamlineTracingRequester::renderGui() {
                 }
             }
 
+            // Only affects how the next grid is loaded, so no new request is necessary.
+            ImGui::Checkbox("Cache Grids on Disk", &guiTracingSettings.useGridDiskCache);
+            if (guiTracingSettings.useGridDiskCache) {
+                ImGui::SliderInt(
+                        "Grid Disk Cache Budget (MiB)", &guiTracingSettings.gridCacheDiskBudgetMiB, 1024, 262144);
+            }
+            ImGui::SliderInt("Grid Cache Budget (MiB)", &guiTracingSettings.gridCacheMemoryBudgetMiB, 256, 32768);
+
             if (ImGui::Checkbox("Export to Disk", &guiTracingSettings.exportToDisk)) {
                 changed = true;
             }
@@ -618,157 +650,111 @@ void StreamlineTracingRequester::requestNewData() {
     }
     request.gridDataSetMetaData.useNormalizedVelocity = guiTracingSettings.useNormalizedVelocity;
     request.gridDataSetMetaData.useNormalizedVorticity = guiTracingSettings.useNormalizedVorticity;
+    request.gridDataSetMetaData.derivedFields = guiTracingSettings.derivedFields;
+    // Stream ribbons and the max. helicity first seeding strategy can't be computed without the helicity field.
+    if (guiTracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS
+            || guiTracingSettings.streamlineSeedingStrategy == StreamlineSeedingStrategy::MAX_HELICITY_FIRST) {
+        request.gridDataSetMetaData.derivedFields |= DERIVED_FIELD_HELICITY;
+    }
 
     queueRequestStruct(request);
 }
 
 bool StreamlineTracingRequester::getHasNewData(DataSetInformation& dataSetInformation, LineDataPtr& lineData) {
-    if (getReply(lineData)) {
-        return true;
-    }
-    return false;
+    return requestScheduler.getReply(lineData);
 }
 
 void StreamlineTracingRequester::queueRequestStruct(const StreamlineTracingSettings& request) {
-    {
-        std::lock_guard<std::mutex> lock(requestMutex);
-        workerTracingSettings = request;
-        requestLineData = LineDataPtr(new LineDataFlow(transferFunctionWindow));
-        hasRequest = true;
-    }
-    hasRequestConditionVariable.notify_all();
-}
-
-bool StreamlineTracingRequester::getReply(LineDataPtr& lineData) {
-    bool hasReply;
-    {
-        std::lock_guard<std::mutex> lock(replyMutex);
-        hasReply = this->hasReply;
-        if (hasReply) {
-            lineData = replyLineData;
+    std::shared_ptr<LineDataFlow> lineData(new LineDataFlow(transferFunctionWindow));
+    requestScheduler.queueJob([this, request, lineData](LineDataPtr& reply, JobToken& jobToken) mutable {
+        request.jobToken = &jobToken;
+        if (!traceLines(request, lineData)) {
+            return false;
         }
-
-        // Now, new requests can be worked on.
-        this->hasReply = false;
-        // this->replyMessage.clear();
-        this->replyLineData = LineDataPtr();
-    }
-    hasReplyConditionVariable.notify_all();
-    return hasReply;
+        reply = lineData;
+        return true;
+    });
 }
 
-void StreamlineTracingRequester::join() {
-    if (!programIsFinished) {
-        {
-            std::lock_guard<std::mutex> lockRequest(requestMutex);
-            programIsFinished = true;
-            hasRequest = true;
-
-            {
-                std::lock_guard<std::mutex> lockReply(replyMutex);
-                this->hasReply = false;
-                // this->replyMessage.clear();
-            }
-            hasReplyConditionVariable.notify_all();
-        }
-        hasRequestConditionVariable.notify_all();
-        if (requesterThread.joinable()) {
-            requesterThread.join();
+void StreamlineTracingRequester::loadGrid(StreamlineTracingSettings& request) {
+    gridCache->setMemoryBudget(size_t(request.gridCacheMemoryBudgetMiB) * size_t(1024 * 1024));
+    gridCache->setUseDiskCache(request.useGridDiskCache);
+    gridCache->setDiskBudget(size_t(request.gridCacheDiskBudgetMiB) * size_t(1024 * 1024));
+    std::string cacheKey = GridCache::computeKey(
+            request.dataSourceFilename, request.gridDataSetMetaData, request.gridSubsamplingFactor);
+    // Release the old grid first, as it is not needed anymore if the LRU list evicts it.
+    cachedGrid = {};
+    cachedGrid = gridCache->find(cacheKey);
+    if (cachedGrid) {
+        // The brick cache budget is not part of the cache key, as it does not change the grid data.
+        if (cachedGrid->getBrickedGrid()) {
+            cachedGrid->getBrickedGrid()->setCacheMemoryBudget(request.gridDataSetMetaData.brickCacheMemoryBudget);
         }
+        return;
     }
-}
 
-void StreamlineTracingRequester::mainLoop() {
-#ifdef TRACY_ENABLE
-    tracy::SetThreadName("StreamlineTracingRequester");
+    cachedGrid = std::make_shared<StreamlineTracingGrid>();
+    StreamlineTracingGrid* grid = cachedGrid.get();
+    if (request.gridDataSetMetaData.axes != glm::ivec3(0, 1, 2)) {
+        grid->setTransposeAxes(request.gridDataSetMetaData.axes);
+    }
+    if (request.gridSubsamplingFactor != 1) {
+        grid->setGridSubsamplingFactor(request.gridSubsamplingFactor);
+    }
+    if (request.isAbcDataSet) {
+        request.abcFlowGenerator.load(request.gridDataSetMetaData, grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".vtk")) {
+        StructuredGridVtkLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".vti")
+            || boost::ends_with(request.dataSourceFilename, ".vts")) {
+        VtkXmlLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".nc")) {
+        NetCdfLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".am")) {
+        AmiraMeshLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".bin")) {
+        RbcBinFileLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".field")) {
+        FieldFileLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    } else if (boost::ends_with(request.dataSourceFilename, ".dat")
+            || boost::ends_with(request.dataSourceFilename, ".raw")) {
+        DatRawFileLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    }
+#ifdef USE_ECCODES
+    else if (boost::ends_with(request.dataSourceFilename, ".grib")
+            || boost::ends_with(request.dataSourceFilename, ".grb")) {
+        GribLoader::load(
+                request.dataSourceFilename, request.gridDataSetMetaData,
+                grid);
+    }
 #endif
 
-    while (true) {
-        std::unique_lock<std::mutex> requestLock(requestMutex);
-        hasRequestConditionVariable.wait(requestLock, [this] { return hasRequest; });
-
-        if (programIsFinished) {
-            break;
-        }
-
-        if (hasRequest) {
-            StreamlineTracingSettings request = workerTracingSettings;
-            std::shared_ptr<LineDataFlow> lineData = std::static_pointer_cast<LineDataFlow>(requestLineData);
-            hasRequest = false;
-            isProcessingRequest = true;
-            requestLock.unlock();
-
-            traceLines(request, lineData);
-
-            std::lock_guard<std::mutex> replyLock(replyMutex);
-            hasReply = true;
-
-            replyLineData = lineData;
-            isProcessingRequest = false;
-        }
-    }
+    // The ABC flow is generated faster than it could be read from disk.
+    gridCache->insert(cacheKey, cachedGrid, !request.isAbcDataSet);
 }
 
-void StreamlineTracingRequester::traceLines(
+bool StreamlineTracingRequester::traceLines(
         StreamlineTracingSettings& request, std::shared_ptr<LineDataFlow>& lineData) {
     if (cachedGridFilename != request.dataSourceFilename || !(cachedGridMetaData == request.gridDataSetMetaData)
             || cachedGridSubsamplingFactor != request.gridSubsamplingFactor) {
-        if (cachedGrid) {
-            delete cachedGrid;
-            cachedGrid = nullptr;
-        }
         cachedGridFilename = request.dataSourceFilename;
         cachedGridMetaData = request.gridDataSetMetaData;
         cachedGridSubsamplingFactor = request.gridSubsamplingFactor;
-
-        cachedGrid = new StreamlineTracingGrid;
-        if (request.gridDataSetMetaData.axes != glm::ivec3(0, 1, 2)) {
-            cachedGrid->setTransposeAxes(request.gridDataSetMetaData.axes);
-        }
-        if (request.gridSubsamplingFactor != 1) {
-            cachedGrid->setGridSubsamplingFactor(request.gridSubsamplingFactor);
-        }
-        if (request.isAbcDataSet) {
-            request.abcFlowGenerator.load(request.gridDataSetMetaData, cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".vtk")) {
-            StructuredGridVtkLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".vti")
-                || boost::ends_with(request.dataSourceFilename, ".vts")) {
-            VtkXmlLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".nc")) {
-            NetCdfLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".am")) {
-            AmiraMeshLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".bin")) {
-            RbcBinFileLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".field")) {
-            FieldFileLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        } else if (boost::ends_with(request.dataSourceFilename, ".dat")
-                || boost::ends_with(request.dataSourceFilename, ".raw")) {
-            DatRawFileLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        }
-#ifdef USE_ECCODES
-        else if (boost::ends_with(request.dataSourceFilename, ".grib")
-                || boost::ends_with(request.dataSourceFilename, ".grb")) {
-            GribLoader::load(
-                    request.dataSourceFilename, request.gridDataSetMetaData,
-                    cachedGrid);
-        }
-#endif
+        loadGrid(request);
 
         {
             std::lock_guard<std::mutex> replyLock(gridInfoMutex);
@@ -781,8 +767,14 @@ void StreamlineTracingRequester::traceLines(
         cachedSimulationMeshOutlineVertexPositions.clear();
         cachedSimulationMeshOutlineVertexNormals.clear();
         cachedGridVectorFieldNames = cachedGrid->getVectorFieldNames();
+    } else if (cachedGridMetaData.brickCacheMemoryBudget != request.gridDataSetMetaData.brickCacheMemoryBudget) {
+        // Only the brick cache budget changed, so the loaded grid is kept.
+        cachedGridMetaData.brickCacheMemoryBudget = request.gridDataSetMetaData.brickCacheMemoryBudget;
+        if (cachedGrid->getBrickedGrid()) {
+            cachedGrid->getBrickedGrid()->setCacheMemoryBudget(cachedGridMetaData.brickCacheMemoryBudget);
+        }
     }
-    if (guiTracingSettings.showSimulationGridOutline && cachedSimulationMeshOutlineVertexPositions.empty()) {
+    if (request.showSimulationGridOutline && cachedSimulationMeshOutlineVertexPositions.empty()) {
         std::vector<uint32_t> simulationMeshOutlineTriangleIndices;
         std::vector<glm::vec3> simulationMeshOutlineVertexPositions;
         std::vector<glm::vec3> simulationMeshOutlineVertexNormals;
@@ -790,7 +782,7 @@ void StreamlineTracingRequester::traceLines(
         cachedGrid->computeSimulationBoundaryMesh(
                 simulationMeshOutlineTriangleIndices,
                 simulationMeshOutlineVertexPositions);
-        if (guiTracingSettings.smoothedSimulationGridOutline) {
+        if (request.smoothedSimulationGridOutline) {
             sgl::laplacianSmoothing(
                     simulationMeshOutlineTriangleIndices, simulationMeshOutlineVertexPositions);
         }
@@ -807,24 +799,31 @@ void StreamlineTracingRequester::traceLines(
         cachedSimulationMeshOutlineVertexNormals = simulationMeshOutlineVertexNormals;
     }
 
+    if (request.jobToken && request.jobToken->getIsCancelled()) {
+        return false;
+    }
+
     Trajectories trajectories;
-    if (guiTracingSettings.flowPrimitives == FlowPrimitives::STREAMLINES) {
+    if (request.flowPrimitives == FlowPrimitives::STREAMLINES) {
         cachedGrid->traceStreamlines(request, trajectories);
-    } else if (guiTracingSettings.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
+    } else if (request.flowPrimitives == FlowPrimitives::STREAMRIBBONS) {
         std::vector<std::vector<glm::vec3>> ribbonsDirections;
         cachedGrid->traceStreamribbons(request, trajectories, ribbonsDirections);
         lineData->ribbonsDirections = ribbonsDirections;
     }
+    if (request.jobToken && request.jobToken->getIsCancelled()) {
+        return false;
+    }
     normalizeTrajectoriesVertexPositions(trajectories, gridBox, nullptr);
 
-    if (guiTracingSettings.showSimulationGridOutline) {
+    if (request.showSimulationGridOutline) {
         lineData->shallRenderSimulationMeshBoundary = true;
         lineData->simulationMeshOutlineTriangleIndices = cachedSimulationMeshOutlineTriangleIndices;
         lineData->simulationMeshOutlineVertexPositions = cachedSimulationMeshOutlineVertexPositions;
         lineData->simulationMeshOutlineVertexNormals = cachedSimulationMeshOutlineVertexNormals;
     }
 
-    if (workerTracingSettings.exportToDisk) {
+    if (request.exportToDisk) {
         BinLinesData binLinesData;
         binLinesData.trajectories = trajectories;
         binLinesData.verticesNormalized = true;
@@ -833,11 +832,12 @@ void StreamlineTracingRequester::traceLines(
         binLinesData.simulationMeshOutlineTriangleIndices = cachedSimulationMeshOutlineTriangleIndices;
         binLinesData.simulationMeshOutlineVertexPositions = cachedSimulationMeshOutlineVertexPositions;
         binLinesData.simulationMeshOutlineVertexNormals = cachedSimulationMeshOutlineVertexNormals;
-        saveTrajectoriesAsBinLines(workerTracingSettings.exportPath, binLinesData);
+        saveTrajectoriesAsBinLines(request.exportPath, binLinesData);
     }
 
     lineData->fileNames = { request.dataSourceFilename };
     lineData->attributeNames = cachedGrid->getScalarFieldNames();
     lineData->onAttributeNamesSet();
     lineData->setTrajectoryData(trajectories);
+    return true;
 }
@@ -29,18 +29,17 @@
 #ifndef LINEVIS_STREAMLINETRACINGREQUESTER_HPP
 #define LINEVIS_STREAMLINETRACINGREQUESTER_HPP
 
-#include <thread>
-#include <condition_variable>
 #include <json/json.h>
 
 #include "Loaders/DataSetList.hpp"
+#include "Utils/RequestScheduler.hpp"
 #include "Loader/AbcFlowGenerator.hpp"
 #include "../LineDataFlow.hpp"
 #include "StreamlineTracingDefines.hpp"
+#include "GridCache.hpp"
 
 class StreamlineSeeder;
 typedef std::shared_ptr<StreamlineSeeder> StreamlineSeederPtr;
-class StreamlineTracingGrid;
 struct GridDataSetMetaData;
 
 class StreamlineTracingRequester {
@@ -56,7 +55,11 @@ public:
     /**
      * @return Whether a request is currently processed (for UI progress spinner).
      */
-    [[nodiscard]] inline bool getIsProcessingRequest() const { return isProcessingRequest; }
+    [[nodiscard]] inline bool getIsProcessingRequest() const { return requestScheduler.getIsProcessingRequest(); }
+    /**
+     * @return The progress of the request currently processed in the range [0, 1], or a negative value if unknown.
+     */
+    [[nodiscard]] inline float getProgress() const { return requestScheduler.getProgress(); }
 
     inline void setShowWindow(bool _showWindow) { showWindow = _showWindow; }
 
@@ -64,49 +67,29 @@ private:
     void loadGridDataSetList();
     void requestNewData();
 
-    /// The main loop of the requester thread.
-    void mainLoop();
-    /// Waits for the requester thread to terminate.
-    void join();
-
     /**
-     * Queues the request for tracing .
+     * Queues the request for tracing. A request that is still being processed is cancelled.
      * @param request The message to queue.
      */
     void queueRequestStruct(const StreamlineTracingSettings& request);
-    /**
-     * Checks if a reply was received to a request.
-     * @return Whether a reply was received.
-     */
-    bool getReply(LineDataPtr& lineData);
 
     /**
      * @param request Information for the requested tracing of lines scattered in the grid.
      * @param lineData An object for storing the traced line data.
+     * @return False if the request was cancelled (request.jobToken) before it could be finished.
      */
-    void traceLines(StreamlineTracingSettings& request, std::shared_ptr<LineDataFlow>& lineData);
+    bool traceLines(StreamlineTracingSettings& request, std::shared_ptr<LineDataFlow>& lineData);
+    /// Sets cachedGrid to the grid requested, either from gridCache or by loading the data set file.
+    void loadGrid(StreamlineTracingSettings& request);
 
     sgl::TransferFunctionWindow& transferFunctionWindow;
 
-    std::thread requesterThread;
-    std::condition_variable hasRequestConditionVariable;
-    std::condition_variable hasReplyConditionVariable;
-    std::mutex requestMutex;
-    std::mutex replyMutex;
+    RequestScheduler<LineDataPtr> requestScheduler;
 
     std::mutex gridInfoMutex;
     bool newGridLoaded = false;
     sgl::AABB3 gridBox;
 
-    bool programIsFinished = false;
-    bool hasRequest = false;
-    bool hasReply = false;
-    bool isProcessingRequest = false;
-
-    StreamlineTracingSettings workerTracingSettings;
-    LineDataPtr requestLineData;
-    LineDataPtr replyLineData;
-
     // Line tracing settings.
     StreamlineTracingSettings guiTracingSettings;
     std::map<StreamlineSeedingStrategy, StreamlineSeederPtr> streamlineSeeders;
@@ -115,7 +98,9 @@ private:
     std::string cachedGridFilename;
     GridDataSetMetaData cachedGridMetaData{};
     int cachedGridSubsamplingFactor = 1;
-    StreamlineTracingGrid* cachedGrid = nullptr;
+    StreamlineTracingGridPtr cachedGrid;
+    // Recently used grids (in memory and on disk). Only accessed by the requester thread.
+    std::unique_ptr<GridCache> gridCache;
     std::mutex cachedGridMetadataMutex;
     std::vector<uint32_t> cachedSimulationMeshOutlineTriangleIndices;
     std::vector<glm::vec3> cachedSimulationMeshOutlineVertexPositions;
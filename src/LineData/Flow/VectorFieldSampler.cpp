@@ -0,0 +1,573 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VECTOR_FIELD_SAMPLER_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define VECTOR_FIELD_SAMPLER_NEON
+#include <arm_neon.h>
+#endif
+
+#include "BrickedGrid.hpp"
+#include "VectorFieldSampler.hpp"
+
+#ifdef VECTOR_FIELD_SAMPLER_X86
+static bool getIsAvx2Supported() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool isAvx2Supported = __builtin_cpu_supports("avx2");
+    return isAvx2Supported;
+#elif defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+#endif
+
+/**
+ * Clamps a (possibly NaN) grid position to the range [-BORDER, gridSize], where all corners outside of the grid are
+ * skipped. Like the previous glm::ivec3 conversion, the position is truncated towards zero. NaN is mapped to the lower
+ * end, like _mm256_max_ps and vmaxnmq_f32 do.
+ */
+template<class T>
+static inline int clampGridPosition(T gridPosition, int gridSize) {
+    if (!(gridPosition > T(-2))) {
+        return -2;
+    }
+    return gridPosition < T(gridSize) ? int(gridPosition) : gridSize;
+}
+
+/**
+ * Computes the offsets of the eight interpolation corners in the interleaved field in the order 000, 100, 010, 110,
+ * 001, 101, 011, 111 and whether they lie inside of the grid. Returns whether all corners lie inside of the grid.
+ */
+template<class T>
+static inline bool getGridCorners(
+        T gridPositionX, T gridPositionY, T gridPositionZ, int xs, int ys, int zs,
+        ptrdiff_t* cornerIndices, bool* cornersInside) {
+    int ix = clampGridPosition(gridPositionX, xs);
+    int iy = clampGridPosition(gridPositionY, ys);
+    int iz = clampGridPosition(gridPositionZ, zs);
+    const bool insideX[2] = { unsigned(ix) < unsigned(xs), unsigned(ix + 1) < unsigned(xs) };
+    const bool insideY[2] = { unsigned(iy) < unsigned(ys), unsigned(iy + 1) < unsigned(ys) };
+    const bool insideZ[2] = { unsigned(iz) < unsigned(zs), unsigned(iz + 1) < unsigned(zs) };
+    const ptrdiff_t strideY = ptrdiff_t(xs) * 3;
+    const ptrdiff_t strideZ = ptrdiff_t(xs) * ptrdiff_t(ys) * 3;
+    const ptrdiff_t idx000 = ptrdiff_t(ix) * 3 + ptrdiff_t(iy) * strideY + ptrdiff_t(iz) * strideZ;
+    for (int cornerIdx = 0; cornerIdx < 8; cornerIdx++) {
+        int offsetX = cornerIdx & 1, offsetY = (cornerIdx >> 1) & 1, offsetZ = cornerIdx >> 2;
+        cornerIndices[cornerIdx] = idx000 + offsetX * 3 + offsetY * strideY + offsetZ * strideZ;
+        cornersInside[cornerIdx] = insideX[offsetX] && insideY[offsetY] && insideZ[offsetZ];
+    }
+    return cornersInside[0] && cornersInside[7];
+}
+
+void VectorFieldSampler::setVectorField(
+        const float* vectorField, int _xs, int _ys, int _zs, const glm::vec3& _boxMin, const glm::vec3& spacing) {
+    brickedGrid = {};
+    brickedFieldIdx = -1;
+    sourceField = vectorField;
+    xs = _xs;
+    ys = _ys;
+    zs = _zs;
+    boxMin = _boxMin;
+    invSpacing = glm::vec3(1.0f / spacing.x, 1.0f / spacing.y, 1.0f / spacing.z);
+    boxMinDouble = glm::dvec3(_boxMin);
+    invSpacingDouble = glm::dvec3(1.0 / double(spacing.x), 1.0 / double(spacing.y), 1.0 / double(spacing.z));
+
+    // The SIMD kernels use 32-bit gather indices, also for the corners in the border around the grid.
+    size_t numBorderEntries =
+            size_t(xs + 2 * BORDER) * size_t(ys + 2 * BORDER) * size_t(zs + 2 * BORDER) * size_t(3);
+    useSimd = numBorderEntries <= size_t(std::numeric_limits<int32_t>::max());
+}
+
+void VectorFieldSampler::setBrickedField(
+        const std::shared_ptr<BrickedGrid>& _brickedGrid, int _brickedFieldIdx,
+        const glm::vec3& _boxMin, const glm::vec3& spacing) {
+    clear();
+    brickedGrid = _brickedGrid;
+    brickedFieldIdx = _brickedFieldIdx;
+    xs = brickedGrid->getGridSizeX();
+    ys = brickedGrid->getGridSizeY();
+    zs = brickedGrid->getGridSizeZ();
+    boxMin = _boxMin;
+    invSpacing = glm::vec3(1.0f / spacing.x, 1.0f / spacing.y, 1.0f / spacing.z);
+    boxMinDouble = glm::dvec3(_boxMin);
+    invSpacingDouble = glm::dvec3(1.0 / double(spacing.x), 1.0 / double(spacing.y), 1.0 / double(spacing.z));
+}
+
+void VectorFieldSampler::clear() {
+    brickedGrid = {};
+    brickedFieldIdx = -1;
+    useSimd = false;
+    sourceField = nullptr;
+    xs = ys = zs = 0;
+}
+
+glm::vec3 VectorFieldSampler::sample(const glm::vec3& position, bool forwardMode) const {
+    glm::vec3 gridPositionFloat = position - boxMin;
+    gridPositionFloat *= invSpacing;
+    if (brickedGrid) {
+        glm::vec3 interpolationValue = brickedGrid->sampleVector(brickedFieldIdx, gridPositionFloat);
+        return forwardMode ? interpolationValue : -interpolationValue;
+    }
+    glm::vec3 frac = glm::fract(gridPositionFloat);
+    glm::vec3 invFrac = glm::vec3(1.0) - frac;
+    ptrdiff_t cornerIndices[8];
+    bool cornersInside[8];
+    bool allCornersInside = getGridCorners(
+            gridPositionFloat.x, gridPositionFloat.y, gridPositionFloat.z, xs, ys, zs, cornerIndices, cornersInside);
+    const float weights[8] = {
+            invFrac.x * invFrac.y * invFrac.z, frac.x * invFrac.y * invFrac.z,
+            invFrac.x * frac.y * invFrac.z, frac.x * frac.y * invFrac.z,
+            invFrac.x * invFrac.y * frac.z, frac.x * invFrac.y * frac.z,
+            invFrac.x * frac.y * frac.z, frac.x * frac.y * frac.z };
+    glm::vec3 interpolationValue;
+    for (int c = 0; c < 3; c++) {
+        const float* data = sourceField + c;
+        if (allCornersInside) {
+            float value = weights[0] * data[cornerIndices[0]];
+            for (int cornerIdx = 1; cornerIdx < 8; cornerIdx++) {
+                value += weights[cornerIdx] * data[cornerIndices[cornerIdx]];
+            }
+            interpolationValue[c] = value;
+            continue;
+        }
+        float value = weights[0] * (cornersInside[0] ? data[cornerIndices[0]] : 0.0f);
+        for (int cornerIdx = 1; cornerIdx < 8; cornerIdx++) {
+            value += weights[cornerIdx] * (cornersInside[cornerIdx] ? data[cornerIndices[cornerIdx]] : 0.0f);
+        }
+        interpolationValue[c] = value;
+    }
+    return forwardMode ? interpolationValue : -interpolationValue;
+}
+
+glm::dvec3 VectorFieldSampler::sampleDouble(const glm::dvec3& position, bool forwardMode) const {
+    glm::dvec3 gridPositionFloat = position - boxMinDouble;
+    gridPositionFloat *= invSpacingDouble;
+    if (brickedGrid) {
+        glm::dvec3 interpolationValue = brickedGrid->sampleVectorDouble(brickedFieldIdx, gridPositionFloat);
+        return forwardMode ? interpolationValue : -interpolationValue;
+    }
+    glm::dvec3 frac = glm::fract(gridPositionFloat);
+    glm::dvec3 invFrac = glm::dvec3(1.0) - frac;
+    ptrdiff_t cornerIndices[8];
+    bool cornersInside[8];
+    bool allCornersInside = getGridCorners(
+            gridPositionFloat.x, gridPositionFloat.y, gridPositionFloat.z, xs, ys, zs, cornerIndices, cornersInside);
+    const double weights[8] = {
+            invFrac.x * invFrac.y * invFrac.z, frac.x * invFrac.y * invFrac.z,
+            invFrac.x * frac.y * invFrac.z, frac.x * frac.y * invFrac.z,
+            invFrac.x * invFrac.y * frac.z, frac.x * invFrac.y * frac.z,
+            invFrac.x * frac.y * frac.z, frac.x * frac.y * frac.z };
+    glm::dvec3 interpolationValue;
+    for (int c = 0; c < 3; c++) {
+        const float* data = sourceField + c;
+        if (allCornersInside) {
+            double value = weights[0] * double(data[cornerIndices[0]]);
+            for (int cornerIdx = 1; cornerIdx < 8; cornerIdx++) {
+                value += weights[cornerIdx] * double(data[cornerIndices[cornerIdx]]);
+            }
+            interpolationValue[c] = value;
+            continue;
+        }
+        double value = weights[0] * double(cornersInside[0] ? data[cornerIndices[0]] : 0.0f);
+        for (int cornerIdx = 1; cornerIdx < 8; cornerIdx++) {
+            value += weights[cornerIdx] * double(cornersInside[cornerIdx] ? data[cornerIndices[cornerIdx]] : 0.0f);
+        }
+        interpolationValue[c] = value;
+    }
+    return forwardMode ? interpolationValue : -interpolationValue;
+}
+
+void VectorFieldSampler::sampleScalarRange(
+        const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+        size_t begin, size_t end, bool forwardMode) const {
+    for (size_t i = begin; i < end; i++) {
+        glm::vec3 v = sample(glm::vec3(px[i], py[i], pz[i]), forwardMode);
+        vx[i] = v.x;
+        vy[i] = v.y;
+        vz[i] = v.z;
+    }
+}
+
+void VectorFieldSampler::sampleDoubleScalarRange(
+        const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+        size_t begin, size_t end, bool forwardMode) const {
+    for (size_t i = begin; i < end; i++) {
+        glm::dvec3 v = sampleDouble(glm::dvec3(px[i], py[i], pz[i]), forwardMode);
+        vx[i] = v.x;
+        vy[i] = v.y;
+        vz[i] = v.z;
+    }
+}
+
+void VectorFieldSampler::samplePacket(
+        const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+        size_t n, bool forwardMode) const {
+    size_t numProcessed = 0;
+#if defined(VECTOR_FIELD_SAMPLER_X86)
+    if (useSimd && getIsAvx2Supported()) {
+        numProcessed = samplePacketAvx2(px, py, pz, vx, vy, vz, n, forwardMode);
+    }
+#elif defined(VECTOR_FIELD_SAMPLER_NEON)
+    if (useSimd) {
+        numProcessed = samplePacketNeon(px, py, pz, vx, vy, vz, n, forwardMode);
+    }
+#endif
+    sampleScalarRange(px, py, pz, vx, vy, vz, numProcessed, n, forwardMode);
+}
+
+void VectorFieldSampler::samplePacketDouble(
+        const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+        size_t n, bool forwardMode) const {
+    size_t numProcessed = 0;
+#if defined(VECTOR_FIELD_SAMPLER_X86)
+    if (useSimd && getIsAvx2Supported()) {
+        numProcessed = samplePacketDoubleAvx2(px, py, pz, vx, vy, vz, n, forwardMode);
+    }
+#endif
+    sampleDoubleScalarRange(px, py, pz, vx, vy, vz, numProcessed, n, forwardMode);
+}
+
+
+#ifdef VECTOR_FIELD_SAMPLER_X86
+
+/// Returns the lanes of the grid index in the range [0, gridSize).
+AVX2_TARGET static inline __m256i isInsideGridAvx2(__m256i gridIndex, __m256i gridSize) {
+    return _mm256_and_si256(
+            _mm256_cmpgt_epi32(gridIndex, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(gridSize, gridIndex));
+}
+
+AVX2_TARGET static inline __m128i isInsideGridAvx2(__m128i gridIndex, __m128i gridSize) {
+    return _mm_and_si128(_mm_cmpgt_epi32(gridIndex, _mm_set1_epi32(-1)), _mm_cmpgt_epi32(gridSize, gridIndex));
+}
+
+/**
+ * Gathers the values of the eight corners. Corners outside of the grid are masked out, i.e., they are not read and
+ * contribute zero.
+ */
+AVX2_TARGET static inline __m256 interpolateAvx2(
+        const float* data, const __m256i* indices, const __m256i* masks, const __m256* weights, __m256 signMask) {
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 value = _mm256_mul_ps(
+            weights[0], _mm256_mask_i32gather_ps(zero, data, indices[0], _mm256_castsi256_ps(masks[0]), 4));
+    for (int i = 1; i < 8; i++) {
+        value = _mm256_add_ps(value, _mm256_mul_ps(
+                weights[i], _mm256_mask_i32gather_ps(zero, data, indices[i], _mm256_castsi256_ps(masks[i]), 4)));
+    }
+    return _mm256_xor_ps(value, signMask);
+}
+
+AVX2_TARGET size_t VectorFieldSampler::samplePacketAvx2(
+        const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+        size_t n, bool forwardMode) const {
+    const __m256 boxMinX = _mm256_set1_ps(boxMin.x);
+    const __m256 boxMinY = _mm256_set1_ps(boxMin.y);
+    const __m256 boxMinZ = _mm256_set1_ps(boxMin.z);
+    const __m256 invSpacingX = _mm256_set1_ps(invSpacing.x);
+    const __m256 invSpacingY = _mm256_set1_ps(invSpacing.y);
+    const __m256 invSpacingZ = _mm256_set1_ps(invSpacing.z);
+    const __m256 minGridPosition = _mm256_set1_ps(-float(BORDER));
+    const __m256 maxGridPositionX = _mm256_set1_ps(float(xs));
+    const __m256 maxGridPositionY = _mm256_set1_ps(float(ys));
+    const __m256 maxGridPositionZ = _mm256_set1_ps(float(zs));
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = forwardMode ? _mm256_setzero_ps() : _mm256_set1_ps(-0.0f);
+    const __m256i gridSizeX = _mm256_set1_epi32(xs);
+    const __m256i gridSizeY = _mm256_set1_epi32(ys);
+    const __m256i gridSizeZ = _mm256_set1_epi32(zs);
+    const __m256i oneInt = _mm256_set1_epi32(1);
+    const __m256i strideX = _mm256_set1_epi32(3);
+    const __m256i strideY = _mm256_set1_epi32(xs * 3);
+    const __m256i strideZ = _mm256_set1_epi32(xs * ys * 3);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 gx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(px + i), boxMinX), invSpacingX);
+        __m256 gy = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(py + i), boxMinY), invSpacingY);
+        __m256 gz = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(pz + i), boxMinZ), invSpacingZ);
+        __m256 fx = _mm256_sub_ps(gx, _mm256_floor_ps(gx));
+        __m256 fy = _mm256_sub_ps(gy, _mm256_floor_ps(gy));
+        __m256 fz = _mm256_sub_ps(gz, _mm256_floor_ps(gz));
+        __m256 ifx = _mm256_sub_ps(one, fx);
+        __m256 ify = _mm256_sub_ps(one, fy);
+        __m256 ifz = _mm256_sub_ps(one, fz);
+
+        // _mm256_max_ps returns the second operand for NaN input, which matches clampGridPosition.
+        __m256i ix = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gx, minGridPosition), maxGridPositionX));
+        __m256i iy = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gy, minGridPosition), maxGridPositionY));
+        __m256i iz = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gz, minGridPosition), maxGridPositionZ));
+        __m256i idx000 = _mm256_add_epi32(
+                _mm256_mullo_epi32(ix, strideX),
+                _mm256_add_epi32(_mm256_mullo_epi32(iy, strideY), _mm256_mullo_epi32(iz, strideZ)));
+        const __m256i insideX[2] = {
+                isInsideGridAvx2(ix, gridSizeX), isInsideGridAvx2(_mm256_add_epi32(ix, oneInt), gridSizeX) };
+        const __m256i insideY[2] = {
+                isInsideGridAvx2(iy, gridSizeY), isInsideGridAvx2(_mm256_add_epi32(iy, oneInt), gridSizeY) };
+        const __m256i insideZ[2] = {
+                isInsideGridAvx2(iz, gridSizeZ), isInsideGridAvx2(_mm256_add_epi32(iz, oneInt), gridSizeZ) };
+
+        __m256i indices[8];
+        indices[0] = idx000;
+        indices[1] = _mm256_add_epi32(idx000, strideX);
+        indices[2] = _mm256_add_epi32(idx000, strideY);
+        indices[3] = _mm256_add_epi32(indices[2], strideX);
+        indices[4] = _mm256_add_epi32(idx000, strideZ);
+        indices[5] = _mm256_add_epi32(indices[4], strideX);
+        indices[6] = _mm256_add_epi32(indices[4], strideY);
+        indices[7] = _mm256_add_epi32(indices[6], strideX);
+
+        __m256i masks[8];
+        for (int cornerIdx = 0; cornerIdx < 8; cornerIdx++) {
+            masks[cornerIdx] = _mm256_and_si256(
+                    _mm256_and_si256(insideX[cornerIdx & 1], insideY[(cornerIdx >> 1) & 1]), insideZ[cornerIdx >> 2]);
+        }
+
+        __m256 weights[8];
+        weights[0] = _mm256_mul_ps(_mm256_mul_ps(ifx, ify), ifz);
+        weights[1] = _mm256_mul_ps(_mm256_mul_ps(fx, ify), ifz);
+        weights[2] = _mm256_mul_ps(_mm256_mul_ps(ifx, fy), ifz);
+        weights[3] = _mm256_mul_ps(_mm256_mul_ps(fx, fy), ifz);
+        weights[4] = _mm256_mul_ps(_mm256_mul_ps(ifx, ify), fz);
+        weights[5] = _mm256_mul_ps(_mm256_mul_ps(fx, ify), fz);
+        weights[6] = _mm256_mul_ps(_mm256_mul_ps(ifx, fy), fz);
+        weights[7] = _mm256_mul_ps(_mm256_mul_ps(fx, fy), fz);
+
+        _mm256_storeu_ps(vx + i, interpolateAvx2(sourceField, indices, masks, weights, signMask));
+        _mm256_storeu_ps(vy + i, interpolateAvx2(sourceField + 1, indices, masks, weights, signMask));
+        _mm256_storeu_ps(vz + i, interpolateAvx2(sourceField + 2, indices, masks, weights, signMask));
+    }
+    return i;
+}
+
+AVX2_TARGET static inline __m256d interpolateDoubleAvx2(
+        const float* data, const __m128i* indices, const __m128i* masks, const __m256d* weights, __m256d signMask) {
+    const __m128 zero = _mm_setzero_ps();
+    __m256d value = _mm256_mul_pd(weights[0], _mm256_cvtps_pd(
+            _mm_mask_i32gather_ps(zero, data, indices[0], _mm_castsi128_ps(masks[0]), 4)));
+    for (int i = 1; i < 8; i++) {
+        value = _mm256_add_pd(value, _mm256_mul_pd(weights[i], _mm256_cvtps_pd(
+                _mm_mask_i32gather_ps(zero, data, indices[i], _mm_castsi128_ps(masks[i]), 4))));
+    }
+    return _mm256_xor_pd(value, signMask);
+}
+
+AVX2_TARGET size_t VectorFieldSampler::samplePacketDoubleAvx2(
+        const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+        size_t n, bool forwardMode) const {
+    const __m256d boxMinX = _mm256_set1_pd(boxMinDouble.x);
+    const __m256d boxMinY = _mm256_set1_pd(boxMinDouble.y);
+    const __m256d boxMinZ = _mm256_set1_pd(boxMinDouble.z);
+    const __m256d invSpacingX = _mm256_set1_pd(invSpacingDouble.x);
+    const __m256d invSpacingY = _mm256_set1_pd(invSpacingDouble.y);
+    const __m256d invSpacingZ = _mm256_set1_pd(invSpacingDouble.z);
+    const __m256d minGridPosition = _mm256_set1_pd(-double(BORDER));
+    const __m256d maxGridPositionX = _mm256_set1_pd(double(xs));
+    const __m256d maxGridPositionY = _mm256_set1_pd(double(ys));
+    const __m256d maxGridPositionZ = _mm256_set1_pd(double(zs));
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d signMask = forwardMode ? _mm256_setzero_pd() : _mm256_set1_pd(-0.0);
+    const __m128i gridSizeX = _mm_set1_epi32(xs);
+    const __m128i gridSizeY = _mm_set1_epi32(ys);
+    const __m128i gridSizeZ = _mm_set1_epi32(zs);
+    const __m128i oneInt = _mm_set1_epi32(1);
+    const __m128i strideX = _mm_set1_epi32(3);
+    const __m128i strideY = _mm_set1_epi32(xs * 3);
+    const __m128i strideZ = _mm_set1_epi32(xs * ys * 3);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d gx = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(px + i), boxMinX), invSpacingX);
+        __m256d gy = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(py + i), boxMinY), invSpacingY);
+        __m256d gz = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(pz + i), boxMinZ), invSpacingZ);
+        __m256d fx = _mm256_sub_pd(gx, _mm256_floor_pd(gx));
+        __m256d fy = _mm256_sub_pd(gy, _mm256_floor_pd(gy));
+        __m256d fz = _mm256_sub_pd(gz, _mm256_floor_pd(gz));
+        __m256d ifx = _mm256_sub_pd(one, fx);
+        __m256d ify = _mm256_sub_pd(one, fy);
+        __m256d ifz = _mm256_sub_pd(one, fz);
+
+        __m128i ix = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(gx, minGridPosition), maxGridPositionX));
+        __m128i iy = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(gy, minGridPosition), maxGridPositionY));
+        __m128i iz = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(gz, minGridPosition), maxGridPositionZ));
+        __m128i idx000 = _mm_add_epi32(
+                _mm_mullo_epi32(ix, strideX),
+                _mm_add_epi32(_mm_mullo_epi32(iy, strideY), _mm_mullo_epi32(iz, strideZ)));
+        const __m128i insideX[2] = {
+                isInsideGridAvx2(ix, gridSizeX), isInsideGridAvx2(_mm_add_epi32(ix, oneInt), gridSizeX) };
+        const __m128i insideY[2] = {
+                isInsideGridAvx2(iy, gridSizeY), isInsideGridAvx2(_mm_add_epi32(iy, oneInt), gridSizeY) };
+        const __m128i insideZ[2] = {
+                isInsideGridAvx2(iz, gridSizeZ), isInsideGridAvx2(_mm_add_epi32(iz, oneInt), gridSizeZ) };
+
+        __m128i indices[8];
+        indices[0] = idx000;
+        indices[1] = _mm_add_epi32(idx000, strideX);
+        indices[2] = _mm_add_epi32(idx000, strideY);
+        indices[3] = _mm_add_epi32(indices[2], strideX);
+        indices[4] = _mm_add_epi32(idx000, strideZ);
+        indices[5] = _mm_add_epi32(indices[4], strideX);
+        indices[6] = _mm_add_epi32(indices[4], strideY);
+        indices[7] = _mm_add_epi32(indices[6], strideX);
+
+        __m128i masks[8];
+        for (int cornerIdx = 0; cornerIdx < 8; cornerIdx++) {
+            masks[cornerIdx] = _mm_and_si128(
+                    _mm_and_si128(insideX[cornerIdx & 1], insideY[(cornerIdx >> 1) & 1]), insideZ[cornerIdx >> 2]);
+        }
+
+        __m256d weights[8];
+        weights[0] = _mm256_mul_pd(_mm256_mul_pd(ifx, ify), ifz);
+        weights[1] = _mm256_mul_pd(_mm256_mul_pd(fx, ify), ifz);
+        weights[2] = _mm256_mul_pd(_mm256_mul_pd(ifx, fy), ifz);
+        weights[3] = _mm256_mul_pd(_mm256_mul_pd(fx, fy), ifz);
+        weights[4] = _mm256_mul_pd(_mm256_mul_pd(ifx, ify), fz);
+        weights[5] = _mm256_mul_pd(_mm256_mul_pd(fx, ify), fz);
+        weights[6] = _mm256_mul_pd(_mm256_mul_pd(ifx, fy), fz);
+        weights[7] = _mm256_mul_pd(_mm256_mul_pd(fx, fy), fz);
+
+        _mm256_storeu_pd(vx + i, interpolateDoubleAvx2(sourceField, indices, masks, weights, signMask));
+        _mm256_storeu_pd(vy + i, interpolateDoubleAvx2(sourceField + 1, indices, masks, weights, signMask));
+        _mm256_storeu_pd(vz + i, interpolateDoubleAvx2(sourceField + 2, indices, masks, weights, signMask));
+    }
+    return i;
+}
+
+#endif
+
+
+#ifdef VECTOR_FIELD_SAMPLER_NEON
+
+size_t VectorFieldSampler::samplePacketNeon(
+        const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+        size_t n, bool forwardMode) const {
+    const float32x4_t boxMinX = vdupq_n_f32(boxMin.x);
+    const float32x4_t boxMinY = vdupq_n_f32(boxMin.y);
+    const float32x4_t boxMinZ = vdupq_n_f32(boxMin.z);
+    const float32x4_t invSpacingX = vdupq_n_f32(invSpacing.x);
+    const float32x4_t invSpacingY = vdupq_n_f32(invSpacing.y);
+    const float32x4_t invSpacingZ = vdupq_n_f32(invSpacing.z);
+    const float32x4_t minGridPosition = vdupq_n_f32(-float(BORDER));
+    const float32x4_t maxGridPositionX = vdupq_n_f32(float(xs));
+    const float32x4_t maxGridPositionY = vdupq_n_f32(float(ys));
+    const float32x4_t maxGridPositionZ = vdupq_n_f32(float(zs));
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const uint32x4_t gridSizeX = vdupq_n_u32(uint32_t(xs));
+    const uint32x4_t gridSizeY = vdupq_n_u32(uint32_t(ys));
+    const uint32x4_t gridSizeZ = vdupq_n_u32(uint32_t(zs));
+    const int32x4_t oneInt = vdupq_n_s32(1);
+    const int32x4_t strideX = vdupq_n_s32(3);
+    const int32x4_t strideY = vdupq_n_s32(xs * 3);
+    const int32x4_t strideZ = vdupq_n_s32(xs * ys * 3);
+    const ptrdiff_t cornerOffsets[8] = {
+            0, 3, ptrdiff_t(xs) * 3, ptrdiff_t(xs) * 3 + 3,
+            ptrdiff_t(xs) * ptrdiff_t(ys) * 3, ptrdiff_t(xs) * ptrdiff_t(ys) * 3 + 3,
+            ptrdiff_t(xs) * ptrdiff_t(ys) * 3 + ptrdiff_t(xs) * 3,
+            ptrdiff_t(xs) * ptrdiff_t(ys) * 3 + ptrdiff_t(xs) * 3 + 3 };
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t gx = vmulq_f32(vsubq_f32(vld1q_f32(px + i), boxMinX), invSpacingX);
+        float32x4_t gy = vmulq_f32(vsubq_f32(vld1q_f32(py + i), boxMinY), invSpacingY);
+        float32x4_t gz = vmulq_f32(vsubq_f32(vld1q_f32(pz + i), boxMinZ), invSpacingZ);
+        float32x4_t fx = vsubq_f32(gx, vrndmq_f32(gx));
+        float32x4_t fy = vsubq_f32(gy, vrndmq_f32(gy));
+        float32x4_t fz = vsubq_f32(gz, vrndmq_f32(gz));
+        float32x4_t ifx = vsubq_f32(one, fx);
+        float32x4_t ify = vsubq_f32(one, fy);
+        float32x4_t ifz = vsubq_f32(one, fz);
+
+        // vmaxnmq_f32 returns the number if one operand is NaN.
+        int32x4_t ix = vcvtq_s32_f32(vminnmq_f32(vmaxnmq_f32(gx, minGridPosition), maxGridPositionX));
+        int32x4_t iy = vcvtq_s32_f32(vminnmq_f32(vmaxnmq_f32(gy, minGridPosition), maxGridPositionY));
+        int32x4_t iz = vcvtq_s32_f32(vminnmq_f32(vmaxnmq_f32(gz, minGridPosition), maxGridPositionZ));
+        int32x4_t idx000 = vaddq_s32(
+                vmulq_s32(ix, strideX), vaddq_s32(vmulq_s32(iy, strideY), vmulq_s32(iz, strideZ)));
+        int32_t baseIndices[4];
+        vst1q_s32(baseIndices, idx000);
+
+        // The unsigned comparison rejects negative indices as well.
+        const uint32x4_t insideX[2] = {
+                vcltq_u32(vreinterpretq_u32_s32(ix), gridSizeX),
+                vcltq_u32(vreinterpretq_u32_s32(vaddq_s32(ix, oneInt)), gridSizeX) };
+        const uint32x4_t insideY[2] = {
+                vcltq_u32(vreinterpretq_u32_s32(iy), gridSizeY),
+                vcltq_u32(vreinterpretq_u32_s32(vaddq_s32(iy, oneInt)), gridSizeY) };
+        const uint32x4_t insideZ[2] = {
+                vcltq_u32(vreinterpretq_u32_s32(iz), gridSizeZ),
+                vcltq_u32(vreinterpretq_u32_s32(vaddq_s32(iz, oneInt)), gridSizeZ) };
+        uint32_t cornerMasks[8][4];
+        for (int cornerIdx = 0; cornerIdx < 8; cornerIdx++) {
+            vst1q_u32(cornerMasks[cornerIdx], vandq_u32(
+                    vandq_u32(insideX[cornerIdx & 1], insideY[(cornerIdx >> 1) & 1]), insideZ[cornerIdx >> 2]));
+        }
+
+        float32x4_t weights[8];
+        weights[0] = vmulq_f32(vmulq_f32(ifx, ify), ifz);
+        weights[1] = vmulq_f32(vmulq_f32(fx, ify), ifz);
+        weights[2] = vmulq_f32(vmulq_f32(ifx, fy), ifz);
+        weights[3] = vmulq_f32(vmulq_f32(fx, fy), ifz);
+        weights[4] = vmulq_f32(vmulq_f32(ifx, ify), fz);
+        weights[5] = vmulq_f32(vmulq_f32(fx, ify), fz);
+        weights[6] = vmulq_f32(vmulq_f32(ifx, fy), fz);
+        weights[7] = vmulq_f32(vmulq_f32(fx, fy), fz);
+
+        float* outputs[3] = { vx + i, vy + i, vz + i };
+        for (int c = 0; c < 3; c++) {
+            const float* data = sourceField + c;
+            float32x4_t value = vdupq_n_f32(0.0f);
+            for (int cornerIdx = 0; cornerIdx < 8; cornerIdx++) {
+                float cornerValues[4];
+                for (int lane = 0; lane < 4; lane++) {
+                    cornerValues[lane] = cornerMasks[cornerIdx][lane]
+                            ? data[ptrdiff_t(baseIndices[lane]) + cornerOffsets[cornerIdx]] : 0.0f;
+                }
+                float32x4_t product = vmulq_f32(weights[cornerIdx], vld1q_f32(cornerValues));
+                value = cornerIdx == 0 ? product : vaddq_f32(value, product);
+            }
+            vst1q_f32(outputs[c], forwardMode ? value : vnegq_f32(value));
+        }
+    }
+    return i;
+}
+
+#endif
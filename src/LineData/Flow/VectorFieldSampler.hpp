@@ -0,0 +1,118 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_VECTORFIELDSAMPLER_HPP
+#define LINEVIS_VECTORFIELDSAMPLER_HPP
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+class BrickedGrid;
+
+/**
+ * Trilinear sampler for a 3D vector field on a Cartesian grid.
+ *
+ * The interleaved field is sampled in place, so no copy is made and a memory-mapped grid stays mapped. Like the
+ * previous per-corner bounds checks, corners outside of the grid contribute zero. The SIMD kernels mask these corners
+ * out of the gathers instead of branching. The packet functions sample many positions at once and use AVX2 (selected
+ * at runtime on x86) or NEON if available, or a scalar loop otherwise. All paths use the same order of floating point
+ * operations as the scalar path.
+ *
+ * Alternatively, a field of a BrickedGrid can be sampled (@see setBrickedField). In this case, the packet functions
+ * sample the positions one by one.
+ */
+class VectorFieldSampler {
+public:
+    /**
+     * Samples the passed interleaved vector field. The field is not copied and must stay valid until it is replaced.
+     * @param vectorField A float array of size xs * ys * zs * 3 storing the 3D vector field.
+     * @param boxMin The position of the first grid point.
+     * @param spacing The distance between two neighboring grid points in x/y/z direction.
+     */
+    void setVectorField(
+            const float* vectorField, int _xs, int _ys, int _zs, const glm::vec3& _boxMin, const glm::vec3& spacing);
+    /// Samples the field with the passed index of an out-of-core grid instead of a dense field.
+    void setBrickedField(
+            const std::shared_ptr<BrickedGrid>& _brickedGrid, int _brickedFieldIdx,
+            const glm::vec3& _boxMin, const glm::vec3& spacing);
+    void clear();
+    /// The field passed to @see setVectorField (used for checking whether the data needs to be updated).
+    [[nodiscard]] inline const float* getSourceField() const { return sourceField; }
+    [[nodiscard]] inline const BrickedGrid* getBrickedGrid() const { return brickedGrid.get(); }
+    [[nodiscard]] inline int getBrickedFieldIdx() const { return brickedFieldIdx; }
+
+    [[nodiscard]] glm::vec3 sample(const glm::vec3& position, bool forwardMode) const;
+    [[nodiscard]] glm::dvec3 sampleDouble(const glm::dvec3& position, bool forwardMode) const;
+
+    /**
+     * Samples the vector field at n positions. Positions and results are passed as separate x/y/z arrays.
+     * The output arrays must not alias the input arrays.
+     */
+    void samplePacket(
+            const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+            size_t n, bool forwardMode) const;
+    void samplePacketDouble(
+            const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+            size_t n, bool forwardMode) const;
+
+private:
+    void sampleScalarRange(
+            const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+            size_t begin, size_t end, bool forwardMode) const;
+    void sampleDoubleScalarRange(
+            const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+            size_t begin, size_t end, bool forwardMode) const;
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    size_t samplePacketAvx2(
+            const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+            size_t n, bool forwardMode) const;
+    size_t samplePacketDoubleAvx2(
+            const double* px, const double* py, const double* pz, double* vx, double* vy, double* vz,
+            size_t n, bool forwardMode) const;
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    size_t samplePacketNeon(
+            const float* px, const float* py, const float* pz, float* vx, float* vy, float* vz,
+            size_t n, bool forwardMode) const;
+#endif
+
+    /// Grid positions are clamped to [-BORDER, size], where all corners outside of the grid are skipped.
+    static constexpr int BORDER = 2;
+    const float* sourceField = nullptr;
+    int xs = 0, ys = 0, zs = 0; ///< Size of the grid in data points.
+    glm::vec3 boxMin{}, invSpacing{};
+    glm::dvec3 boxMinDouble{}, invSpacingDouble{};
+    bool useSimd = false;
+    std::shared_ptr<BrickedGrid> brickedGrid;
+    int brickedFieldIdx = -1;
+};
+
+#endif //LINEVIS_VECTORFIELDSAMPLER_HPP
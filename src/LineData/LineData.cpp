@@ -26,11 +26,6 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef USE_TBB
-#include <tbb/parallel_reduce.h>
-#include <tbb/blocked_range.h>
-#endif
-
 #include <Utils/Dialog.hpp>
 #include <Utils/File/Logfile.hpp>
 #include <Graphics/Vulkan/Shader/ShaderManager.hpp>
@@ -177,6 +172,29 @@ bool LineData::setNewSettings(const SettingsMap& settings) {
         reloadGatherShader = true;
     }
 
+    std::string triangleSplitModeName;
+    if (settings.getValueOpt("triangle_split_mode", triangleSplitModeName)) {
+        int i;
+        for (i = 0; i < IM_ARRAYSIZE(triangleSplitModeNames); i++) {
+            if (triangleSplitModeName == triangleSplitModeNames[i]) {
+                if (triangleSplitMode != TriangleSplitMode(i)) {
+                    triangleSplitMode = TriangleSplitMode(i);
+                    setTriangleRepresentationDirty();
+                }
+                break;
+            }
+        }
+        if (i == IM_ARRAYSIZE(triangleSplitModeNames)) {
+            sgl::Logfile::get()->writeError(
+                    "Error in LineData::setNewSettings: Unknown triangle split mode \""
+                    + triangleSplitModeName + "\".");
+        }
+    }
+
+    if (settings.getValueOpt("render_data_cache_budget_mib", renderDataCacheBudgetMiB)) {
+        renderDataCache.setBudgetInBytes(size_t(std::max(renderDataCacheBudgetMiB, 0)) * 1024 * 1024);
+    }
+
     return reloadGatherShader;
 }
 
@@ -341,6 +359,22 @@ bool LineData::renderGuiPropertyEditorNodesRendererAdvanced(
 
     propertyEditor.addCheckbox("Render Color Legend", &shallRenderColorLegendWidgets);
 
+    if (propertyEditor.addSliderIntEdit(
+            "Render Data Cache (MiB)", &renderDataCacheBudgetMiB, 0, 8192) == ImGui::EditMode::INPUT_FINISHED) {
+        renderDataCache.setBudgetInBytes(size_t(renderDataCacheBudgetMiB) * 1024 * 1024);
+    }
+    propertyEditor.addText(
+            "Render Data Cache Usage",
+            sgl::toString(double(renderDataCache.getUsedSizeInBytes()) / 1024.0 / 1024.0) + "MiB ("
+            + std::to_string(renderDataCache.getNumEntries()) + " entries)");
+
+    if (propertyEditor.addCombo(
+            "Triangle Batch Split", (int*)&triangleSplitMode,
+            triangleSplitModeNames, IM_ARRAYSIZE(triangleSplitModeNames))) {
+        setTriangleRepresentationDirty();
+        reRender = true;
+    }
+
     return shallReloadGatherShader;
 }
 
@@ -449,11 +483,15 @@ void LineData::recomputeColorLegend() {
 void LineData::rebuildInternalRepresentationIfNecessary() {
     if (dirty) {
         cachedRenderDataGeometryShader = {};
-    }
-    if (dirty || cachedTubeNumSubdivisions != tubeNumSubdivisions) {
         cachedRenderDataProgrammablePull = {};
         cachedRenderDataMeshShader = {};
     }
+    if (!dirty && activeRenderDataKey.tubeNumSubdivisions != tubeNumSubdivisions
+            && (activeRenderDataKey.requestMode == RequestMode::PROGRAMMABLE_PULL
+                || activeRenderDataKey.requestMode == RequestMode::MESH_SHADER)) {
+        // Keep the data for the old number of subdivisions in case the user switches back.
+        stashActiveCachedDataType();
+    }
     if (dirty || triangleRepresentationDirty) {
         sgl::AppSettings::get()->getPrimaryDevice()->waitIdle();
         //updateMeshTriangleIntersectionDataStructure();
@@ -470,36 +508,107 @@ void LineData::rebuildInternalRepresentationIfNecessary() {
         tubeAabbAndHullTopLevelAS = {};
         cachedTubeTriangleRenderDataPayload = {};
 
+        if (dirty) {
+            // The line data or the filter state changed, so none of the cached representations can be reused.
+            renderDataCache.clear();
+            activeRenderDataKey = {};
+        } else {
+            renderDataCache.remove(RequestMode::TRIANGLES);
+            renderDataCache.remove(RequestMode::AABBS);
+            if (activeRenderDataKey.requestMode == RequestMode::TRIANGLES
+                    || activeRenderDataKey.requestMode == RequestMode::AABBS) {
+                activeRenderDataKey = {};
+            }
+        }
+
         dirty = false;
         triangleRepresentationDirty = false;
     }
 }
 
-void LineData::removeOtherCachedDataTypes(RequestMode requestMode) {
-    if (requestMode != RequestMode::TRIANGLES) {
-        cachedTubeTriangleRenderData = {};
-        tubeTriangleBottomLevelASes = {};
-        tubeTriangleTopLevelAS = {};
-        tubeTriangleAndHullTopLevelAS = {};
-        cachedTubeTriangleRenderDataPayload = {};
-    }
-    if (requestMode != RequestMode::AABBS) {
-        cachedTubeAabbRenderData = {};
-        tubeAabbBottomLevelAS = {};
-        tubeAabbTopLevelAS = {};
-        tubeAabbAndHullTopLevelAS = {};
+RenderDataCacheKey LineData::getRenderDataCacheKey(RequestMode requestMode) const {
+    RenderDataCacheKey key;
+    key.requestMode = requestMode;
+    if (requestMode == RequestMode::TRIANGLES || requestMode == RequestMode::PROGRAMMABLE_PULL
+            || requestMode == RequestMode::MESH_SHADER) {
+        key.tubeNumSubdivisions = tubeNumSubdivisions;
     }
-    if (requestMode != RequestMode::GEOMETRY_SHADER) {
-        cachedRenderDataGeometryShader = {};
-    }
-    if (requestMode != RequestMode::PROGRAMMABLE_PULL) {
-        cachedRenderDataProgrammablePull = {};
-    }
-    if (requestMode != RequestMode::MESH_SHADER) {
-        cachedRenderDataMeshShader = {};
+    return key;
+}
+
+void LineData::stashActiveCachedDataType() {
+    RenderDataCacheEntry entry;
+    entry.key = activeRenderDataKey;
+
+    entry.tubeTriangleRenderData = cachedTubeTriangleRenderData;
+    entry.tubeTriangleSplitData = std::move(tubeTriangleSplitData);
+    entry.tubeTriangleBottomLevelASes = tubeTriangleBottomLevelASes;
+    entry.tubeTriangleTopLevelAS = tubeTriangleTopLevelAS;
+    entry.tubeTriangleAndHullTopLevelAS = tubeTriangleAndHullTopLevelAS;
+    cachedTubeTriangleRenderData = {};
+    tubeTriangleSplitData = {};
+    tubeTriangleBottomLevelASes = {};
+    tubeTriangleTopLevelAS = {};
+    tubeTriangleAndHullTopLevelAS = {};
+    cachedTubeTriangleRenderDataPayload = {};
+
+    entry.tubeAabbRenderData = cachedTubeAabbRenderData;
+    entry.tubeAabbBottomLevelAS = tubeAabbBottomLevelAS;
+    entry.tubeAabbTopLevelAS = tubeAabbTopLevelAS;
+    entry.tubeAabbAndHullTopLevelAS = tubeAabbAndHullTopLevelAS;
+    cachedTubeAabbRenderData = {};
+    tubeAabbBottomLevelAS = {};
+    tubeAabbTopLevelAS = {};
+    tubeAabbAndHullTopLevelAS = {};
+
+    entry.renderDataGeometryShader = cachedRenderDataGeometryShader;
+    entry.renderDataProgrammablePull = cachedRenderDataProgrammablePull;
+    entry.renderDataMeshShader = cachedRenderDataMeshShader;
+    cachedRenderDataGeometryShader = {};
+    cachedRenderDataProgrammablePull = {};
+    cachedRenderDataMeshShader = {};
+
+    activeRenderDataKey = {};
+    entry.sizeInBytes = computeRenderDataCacheEntrySize(entry);
+    if (entry.key.requestMode != RequestMode::NO_CACHE_SUPPORTED && entry.sizeInBytes > 0) {
+        renderDataCache.insert(std::move(entry));
     }
 }
 
+bool LineData::activateCachedDataType(const RenderDataCacheKey& key) {
+    stashActiveCachedDataType();
+
+    RenderDataCacheEntry entry;
+    if (!renderDataCache.take(key, entry)) {
+        activeRenderDataKey = key;
+        return false;
+    }
+    activeRenderDataKey = entry.key;
+
+    if (entry.key.requestMode == RequestMode::TRIANGLES) {
+        cachedTubeTriangleRenderData = entry.tubeTriangleRenderData;
+        tubeTriangleSplitData = std::move(entry.tubeTriangleSplitData);
+        tubeTriangleBottomLevelASes = entry.tubeTriangleBottomLevelASes;
+        tubeTriangleTopLevelAS = entry.tubeTriangleTopLevelAS;
+        tubeTriangleAndHullTopLevelAS = entry.tubeTriangleAndHullTopLevelAS;
+        cachedTubeTriangleRenderDataPayload = entry.key.payload;
+        cachedTubeTriangleRenderDataIsRayTracing = entry.key.vulkanRayTracing;
+    } else if (entry.key.requestMode == RequestMode::AABBS) {
+        cachedTubeAabbRenderData = entry.tubeAabbRenderData;
+        tubeAabbBottomLevelAS = entry.tubeAabbBottomLevelAS;
+        tubeAabbTopLevelAS = entry.tubeAabbTopLevelAS;
+        tubeAabbAndHullTopLevelAS = entry.tubeAabbAndHullTopLevelAS;
+        tubeAabbEllipticTubes = entry.key.ellipticTubes;
+    } else if (entry.key.requestMode == RequestMode::GEOMETRY_SHADER) {
+        cachedRenderDataGeometryShader = entry.renderDataGeometryShader;
+    } else if (entry.key.requestMode == RequestMode::PROGRAMMABLE_PULL) {
+        cachedRenderDataProgrammablePull = entry.renderDataProgrammablePull;
+    } else if (entry.key.requestMode == RequestMode::MESH_SHADER) {
+        cachedRenderDataMeshShader = entry.renderDataMeshShader;
+    }
+    return true;
+}
+
 std::vector<std::string> LineData::getShaderModuleNames() {
     sgl::vk::ShaderManager->invalidateShaderCache();
     if (linePrimitiveMode == LINE_PRIMITIVES_QUADS_PROGRAMMABLE_PULL) {
@@ -768,101 +877,45 @@ std::vector<sgl::vk::BottomLevelAccelerationStructurePtr> LineData::getTubeTrian
 void LineData::splitTriangleIndices(
         std::vector<uint32_t>& tubeTriangleIndices,
         const std::vector<TubeTriangleVertexData> &tubeTriangleVertexDataList) {
-#ifdef USE_TBB
-
-    sgl::AABB3 geometryAABB = tbb::parallel_reduce(
-            tbb::blocked_range<size_t>(0, tubeTriangleVertexDataList.size()), sgl::AABB3(),
-            [&tubeTriangleVertexDataList](tbb::blocked_range<size_t> const& r, sgl::AABB3 init) {
-                for (auto i = r.begin(); i != r.end(); i++) {
-                    const glm::vec3& pt = tubeTriangleVertexDataList.at(i).vertexPosition;
-                    init.min.x = std::min(init.min.x, pt.x);
-                    init.min.y = std::min(init.min.y, pt.y);
-                    init.min.z = std::min(init.min.z, pt.z);
-                    init.max.x = std::max(init.max.x, pt.x);
-                    init.max.y = std::max(init.max.y, pt.y);
-                    init.max.z = std::max(init.max.z, pt.z);
-                }
-                return init;
-            },
-            [&](sgl::AABB3 lhs, sgl::AABB3 rhs) -> sgl::AABB3 {
-                lhs.combine(rhs);
-                return lhs;
-            });
-
-#else
-
-    sgl::AABB3 geometryAABB;
-    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
-#if _OPENMP >= 201107
-    #pragma omp parallel for shared(tubeTriangleVertexDataList) default(none) reduction(min: minX) \
-    reduction(min: minY) reduction(min: minZ) reduction(max: maxX) reduction(max: maxY) reduction(max: maxZ)
-#endif
-    for (size_t i = 0; i < tubeTriangleVertexDataList.size(); i++) {
-        const glm::vec3& pt = tubeTriangleVertexDataList.at(i).vertexPosition;
-        minX = std::min(minX, pt.x);
-        minY = std::min(minY, pt.y);
-        minZ = std::min(minZ, pt.z);
-        maxX = std::max(maxX, pt.x);
-        maxY = std::max(maxY, pt.y);
-        maxZ = std::max(maxZ, pt.z);
-    }
-    geometryAABB.min = glm::vec3(minX, minY, minZ);
-    geometryAABB.max = glm::vec3(maxX, maxY, maxZ);
-
-#endif
-
     // Assume here that in all subdivisions we have the same amount of data.
     size_t numIndicesPerBatch = batchSizeLimit;
 
     int numBatches = sgl::nextPowerOfTwo(int(tubeTriangleIndices.size() / numIndicesPerBatch));
     numBatches = std::max(numBatches, 1);
     auto numSubdivisions = sgl::intlog2(numBatches);
-    std::vector<std::vector<uint32_t>> batchIndicesList;
-    batchIndicesList.resize(numBatches);
-
-    tubeTriangleSplitData = {};
-    for (uint32_t triangleIdx = 0; triangleIdx < tubeTriangleIndices.size(); triangleIdx += 3) {
-        uint32_t idx0 = tubeTriangleIndices.at(triangleIdx);
-        uint32_t idx1 = tubeTriangleIndices.at(triangleIdx + 1);
-        uint32_t idx2 = tubeTriangleIndices.at(triangleIdx + 2);
-        glm::vec3 p0 = tubeTriangleVertexDataList.at(idx0).vertexPosition;
-        glm::vec3 p1 = tubeTriangleVertexDataList.at(idx1).vertexPosition;
-        glm::vec3 p2 = tubeTriangleVertexDataList.at(idx2).vertexPosition;
-        glm::vec3 triangleCentroid = (p0 + p1 + p2) / 3.0f;
-
-        sgl::AABB3 regionAABB = geometryAABB;
-        //const int k = 3; // Number of dimensions
-        int batchIdx = 0;
-        for (int depth = 0; depth < numSubdivisions; depth++) {
-            // Assign axis depending on the largest axis of extent of regionAABB.
-            //int axis = depth % k;
-            glm::vec3 dimensions = regionAABB.getDimensions();
-            int axis;
-            if (dimensions.x > dimensions.y && dimensions.x > dimensions.z) {
-                axis = 0;
-            } else if (dimensions.y > dimensions.z) {
-                axis = 1;
-            } else {
-                axis = 2;
-            }
-            float splitPosition = (regionAABB.min[axis] + regionAABB.max[axis]) / 2.0f;
-            if (triangleCentroid[axis] <= splitPosition) {
-                regionAABB.max[axis] = splitPosition;
-            } else {
-                regionAABB.min[axis] = splitPosition;
-                batchIdx += 1 << (numSubdivisions - depth - 1);
+    splitTrianglesIntoBatches(
+            tubeTriangleIndices, tubeTriangleVertexDataList, uint32_t(numSubdivisions), triangleSplitMode,
+            tubeTriangleSplitData);
+
+    if (numBatches > 1) {
+        auto getSurfaceArea = [](const sgl::AABB3& aabb) {
+            glm::vec3 dimensions = aabb.getDimensions();
+            return 2.0f * (dimensions.x * dimensions.y + dimensions.y * dimensions.z + dimensions.z * dimensions.x);
+        };
+        sgl::AABB3 geometryAABB;
+        float batchAreaSum = 0.0f;
+        for (int batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+            uint32_t numBatchTriangles = tubeTriangleSplitData.numBatchIndices.at(batchIdx) / 3;
+            if (numBatchTriangles == 0) {
+                sgl::Logfile::get()->writeInfo("Triangle batch " + std::to_string(batchIdx) + ": 0 triangles");
+                continue;
             }
+            sgl::AABB3 batchAABB(
+                    tubeTriangleSplitData.batchAabbMin.at(batchIdx), tubeTriangleSplitData.batchAabbMax.at(batchIdx));
+            sgl::Logfile::get()->writeInfo(
+                    "Triangle batch " + std::to_string(batchIdx) + ": " + std::to_string(numBatchTriangles)
+                    + " triangles, bounds (" + sgl::toString(batchAABB.min.x) + ", " + sgl::toString(batchAABB.min.y)
+                    + ", " + sgl::toString(batchAABB.min.z) + ") - (" + sgl::toString(batchAABB.max.x) + ", "
+                    + sgl::toString(batchAABB.max.y) + ", " + sgl::toString(batchAABB.max.z) + ")");
+            geometryAABB.combine(batchAABB);
+            batchAreaSum += getSurfaceArea(batchAABB);
+        }
+        float geometryArea = getSurfaceArea(geometryAABB);
+        if (geometryArea > 0.0f) {
+            sgl::Logfile::get()->writeInfo(
+                    "Sum of the triangle batch surface areas relative to the mesh bounds: "
+                    + sgl::toString(batchAreaSum / geometryArea));
         }
-        std::vector<uint32_t>& batchIndices = batchIndicesList.at(batchIdx);
-        batchIndices.push_back(idx0);
-        batchIndices.push_back(idx1);
-        batchIndices.push_back(idx2);
-    }
-
-    tubeTriangleIndices.clear();
-    for (std::vector<uint32_t>& batchIndices : batchIndicesList) {
-        tubeTriangleSplitData.numBatchIndices.push_back(uint32_t(batchIndices.size()));
-        tubeTriangleIndices.insert(tubeTriangleIndices.end(), batchIndices.begin(), batchIndices.end());
     }
 }
 
@@ -38,8 +38,11 @@
 #include "Utils/InternalState.hpp"
 #include "Loaders/DataSetList.hpp"
 #include "Loaders/TrajectoryFile.hpp"
+#include "Loaders/TrajectoryStore.hpp"
 #include "LineDataHeader.hpp"
 #include "LineRenderData.hpp"
+#include "RenderDataCache.hpp"
+#include "TriangleBatchSplitter.hpp"
 
 namespace sgl {
 class PropertyEditor;
@@ -155,9 +158,9 @@ public:
     virtual size_t getBaseSizeInBytes()=0;
 
     // Public interface for filtering trajectories.
-    virtual void iterateOverTrajectories(std::function<void(const Trajectory&)> callback)=0;
-    virtual void iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback)=0;
-    virtual void filterTrajectories(std::function<bool(const Trajectory&)> callback)=0;
+    virtual void iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback)=0;
+    virtual void iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback)=0;
+    virtual void filterTrajectories(std::function<bool(const TrajectoryView&)> callback)=0;
     virtual void resetTrajectoryFilter()=0;
 
     // Get filtered line data (only containing points also shown when rendering).
@@ -328,9 +331,14 @@ public:
                 || linePrimitiveMode == LINE_PRIMITIVES_TUBE_RIBBONS_MESH_SHADER_NV;
     }
 
-    enum class RequestMode {
-        NO_CACHE_SUPPORTED, TRIANGLES, AABBS, GEOMETRY_SHADER, PROGRAMMABLE_PULL, MESH_SHADER
-    };
+    typedef RenderDataRequestMode RequestMode;
+
+    /// Memory budget for the cached representations of renderers that are currently not active.
+    inline void setRenderDataCacheBudgetInBytes(size_t budgetInBytes) {
+        renderDataCache.setBudgetInBytes(budgetInBytes);
+        renderDataCacheBudgetMiB = int(budgetInBytes / (1024 * 1024));
+    }
+    [[nodiscard]] inline const RenderDataCache& getRenderDataCache() const { return renderDataCache; }
 
     static inline float getMinBandThickness() { return minBandThickness; }
 
@@ -343,7 +351,15 @@ protected:
     virtual void recomputeColorLegend();
     int getAttributeNameIndex(const std::string& attributeName);
     bool updateLinePrimitiveMode(LineRenderer* lineRenderer);
-    void removeOtherCachedDataTypes(RequestMode requestMode);
+    /**
+     * Makes the representation requested by key the active one. The previously active representation is moved to the
+     * render data cache instead of being destroyed.
+     * @return True if the representation was restored from the cache. Otherwise, the caller needs to generate it.
+     */
+    bool activateCachedDataType(const RenderDataCacheKey& key);
+    /// Moves the active representation to the render data cache.
+    void stashActiveCachedDataType();
+    [[nodiscard]] RenderDataCacheKey getRenderDataCacheKey(RequestMode requestMode) const;
 
     ///< The maximum number of line points to be considered a small data set (important, e.g., for live UI updates).
     const size_t SMALL_DATASET_LINE_POINTS_MAX = 10000;
@@ -393,10 +409,17 @@ protected:
             const std::vector<TubeTriangleVertexData> &tubeTriangleVertexDataList);
     TubeTriangleRenderData cachedTubeTriangleRenderData;
     TubeTriangleSplitData tubeTriangleSplitData;
+    TriangleSplitMode triangleSplitMode = TriangleSplitMode::MIDPOINT;
     TubeAabbRenderData cachedTubeAabbRenderData;
     HullTriangleRenderData cachedHullTriangleRenderData;
     bool cachedTubeTriangleRenderDataIsRayTracing = false;
     const size_t batchSizeLimit = 1024 * 1024 * 32;
+    // Size of the chunks the tube triangle mesh is generated and uploaded in if the complete mesh is not needed on
+    // the CPU. Payloads and the split triangle data need the complete mesh.
+    const size_t tubeTriangleStreamingChunkSize = 1024 * 1024 * 64;
+    [[nodiscard]] inline bool getCanStreamTubeTriangleMesh(const TubeTriangleRenderDataPayloadPtr& payload) const {
+        return !payload && !generateSplitTriangleData;
+    }
     bool generateSplitTriangleData = false, cachedGenerateSplitTriangleData = false;
     TubeTriangleRenderDataPayloadPtr cachedTubeTriangleRenderDataPayload{};
     std::vector<sgl::vk::BottomLevelAccelerationStructurePtr> tubeTriangleBottomLevelASes;
@@ -412,7 +435,12 @@ protected:
     LinePassTubeRenderData cachedRenderDataGeometryShader;
     LinePassTubeRenderDataProgrammablePull cachedRenderDataProgrammablePull;
     LinePassTubeRenderDataMeshShader cachedRenderDataMeshShader;
-    int cachedTubeNumSubdivisions = 0;
+
+    // Settings of the representation stored in the members above. The representations of other renderers are kept
+    // in the render data cache until its memory budget is exceeded.
+    RenderDataCacheKey activeRenderDataKey;
+    RenderDataCache renderDataCache;
+    int renderDataCacheBudgetMiB = 1024;
 
     // For deferred rendering.
     // Array of triangle meshlets (aabb, start idx, end idx)
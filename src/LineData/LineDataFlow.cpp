@@ -29,6 +29,7 @@
 #include <unordered_set>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #ifdef USE_TBB
 #include <tbb/parallel_reduce.h>
@@ -36,6 +37,7 @@
 #endif
 
 #include <Utils/StringUtils.hpp>
+#include <Utils/Convert.hpp>
 #include <Utils/File/Logfile.hpp>
 #include <Graphics/Texture/Bitmap.hpp>
 #include <Graphics/Vulkan/Buffers/Buffer.hpp>
@@ -46,8 +48,11 @@
 #include <ImGui/ImGuiFileDialog/ImGuiFileDialog.h>
 
 #include "Loaders/TrajectoryFile.hpp"
+#include "Loaders/BinLinesLoader.hpp"
 #include "Renderers/LineRenderer.hpp"
 #include "Renderers/Tubes/Tubes.hpp"
+#include "LinePassGenerator.hpp"
+#include "StagingRingUploader.hpp"
 #include "LineDataFlow.hpp"
 
 bool LineDataFlow::useRibbons = true;
@@ -365,6 +370,31 @@ bool LineDataFlow::renderGuiPropertyEditorNodes(sgl::PropertyEditor& propertyEdi
             reRender = true;
         }
 
+        if (propertyEditor.addCheckbox("Line Simplification", &useLineSimplification)) {
+            dirty = true;
+            reRender = true;
+        }
+        if (useLineSimplification) {
+            if (propertyEditor.addSliderFloatEdit(
+                    "Max. Position Error", &lineSimplificationPositionError, 0.0f, 0.01f,
+                    "%.5f") == ImGui::EditMode::INPUT_FINISHED) {
+                dirty = true;
+                reRender = true;
+            }
+            if (propertyEditor.addSliderFloatEdit(
+                    "Max. Attribute Error", &lineSimplificationAttributeError, 0.0f, 0.1f,
+                    "%.4f") == ImGui::EditMode::INPUT_FINISHED) {
+                dirty = true;
+                reRender = true;
+            }
+            if (!simplifiedLinesDirty) {
+                propertyEditor.addText(
+                        "Simplified Line Points",
+                        std::to_string(simplifiedLines.numLinePointsOut) + " / "
+                        + std::to_string(simplifiedLines.numLinePointsIn));
+            }
+        }
+
         propertyEditor.endNode();
     }
 
@@ -439,26 +469,60 @@ bool LineDataFlow::loadFromFile(
         glm::mat4* transformationMatrixPtr) {
     this->fileNames = fileNames;
     attributeNames = dataSetInformation.attributeNames;
+    trajectories = {};
+
+    // Version 3 .binlines files are used directly from the mapped file pages. If the vertex positions still need to
+    // be normalized, only the position plane is transformed into memory; the attribute planes stay mapped.
+    std::string lowerCaseFilename = boost::to_lower_copy(fileNames.front());
+    if (boost::ends_with(lowerCaseFilename, ".binlines") && getBinLinesFileVersion(fileNames.front()) == 3u) {
+        MappedBinLinesFile mappedBinLinesFile;
+        if (!mappedBinLinesFile.open(fileNames.front())) {
+            return false;
+        }
+        BinLinesData binLinesData;
+        mappedBinLinesFile.loadMetadata(binLinesData);
+        mappedBinLinesFile.loadRibbonDirections(binLinesData);
+        TrajectoryStore trajectoryStore;
+        trajectoryStore.setMappedBinLines(mappedBinLinesFile);
+        bool dataLoaded = !trajectoryStore.empty();
+        if (dataLoaded) {
+            if (!binLinesData.verticesNormalized) {
+                normalizeTrajectoriesVertexPositions(trajectoryStore, transformationMatrixPtr);
+            }
+            if (!binLinesData.attributeNames.empty()) {
+                attributeNames = binLinesData.attributeNames;
+            }
+            ribbonsDirections = binLinesData.ribbonsDirections;
+            setSimulationMeshOutline(binLinesData);
+            onAttributeNamesSet();
+            setTrajectoryData(std::move(trajectoryStore));
+        }
+        return dataLoaded;
+    }
+
     BinLinesData binLinesData = loadFlowTrajectoriesFromFile(
             fileNames.front(), attributeNames, true,
             false, transformationMatrixPtr);
-    trajectories = {};
     bool dataLoaded = !binLinesData.trajectories.empty();
 
     if (dataLoaded) {
         attributeNames = binLinesData.attributeNames;
         ribbonsDirections = binLinesData.ribbonsDirections;
-        shallRenderSimulationMeshBoundary = !binLinesData.simulationMeshOutlineTriangleIndices.empty();
-        simulationMeshOutlineTriangleIndices = binLinesData.simulationMeshOutlineTriangleIndices;
-        simulationMeshOutlineVertexPositions = binLinesData.simulationMeshOutlineVertexPositions;
-        simulationMeshOutlineVertexNormals = binLinesData.simulationMeshOutlineVertexNormals;
+        setSimulationMeshOutline(binLinesData);
         onAttributeNamesSet();
-        setTrajectoryData(binLinesData.trajectories);
+        setTrajectoryData(TrajectoryStore(binLinesData.trajectories));
     }
 
     return dataLoaded;
 }
 
+void LineDataFlow::setSimulationMeshOutline(const BinLinesData& binLinesData) {
+    shallRenderSimulationMeshBoundary = !binLinesData.simulationMeshOutlineTriangleIndices.empty();
+    simulationMeshOutlineTriangleIndices = binLinesData.simulationMeshOutlineTriangleIndices;
+    simulationMeshOutlineVertexPositions = binLinesData.simulationMeshOutlineVertexPositions;
+    simulationMeshOutlineVertexNormals = binLinesData.simulationMeshOutlineVertexNormals;
+}
+
 void LineDataFlow::onAttributeNamesSet() {
     isAttributeSelectedArray.clear();
     isAttributeSelectedArray.resize(attributeNames.size(), 0);
@@ -472,6 +536,10 @@ void LineDataFlow::onAttributeNamesSet() {
 }
 
 void LineDataFlow::setTrajectoryData(const Trajectories& trajectories) {
+    setTrajectoryData(TrajectoryStore(trajectories));
+}
+
+void LineDataFlow::setTrajectoryData(TrajectoryStore&& trajectoryStore) {
     hasBandsData = !ribbonsDirections.empty();
     useRibbons = !useRotatingHelicityBands && hasBandsData;
     if (ribbonsDirections.empty()
@@ -489,13 +557,12 @@ void LineDataFlow::setTrajectoryData(const Trajectories& trajectories) {
         tubeNumSubdivisions = std::max(tubeNumSubdivisions, 8);
     }
 
-    this->trajectories = trajectories;
+    trajectories = std::move(trajectoryStore);
+    simplifiedLinesDirty = true;
+    lineLodHierarchyDirty = true;
 
     if (getNumAttributes() == 0) {
-        for (Trajectory& trajectory : this->trajectories) {
-            trajectory.attributes.resize(1);
-            trajectory.attributes.front().resize(trajectory.positions.size());
-        }
+        trajectories.resizeAttributes(1);
     }
 
     for (size_t attrIdx = attributeNames.size(); attrIdx < getNumAttributes(); attrIdx++) {
@@ -517,14 +584,9 @@ void LineDataFlow::setTrajectoryData(const Trajectories& trajectories) {
 
     minMaxAttributeValues.clear();
     for (size_t varIdx = 0; varIdx < colorLegendWidgets.size(); varIdx++) {
-        float minAttr = std::numeric_limits<float>::max();
-        float maxAttr = std::numeric_limits<float>::lowest();
-        for (const Trajectory& trajectory : this->trajectories) {
-            for (float val : trajectory.attributes.at(varIdx)) {
-                minAttr = std::min(minAttr, val);
-                maxAttr = std::max(maxAttr, val);
-            }
-        }
+        glm::vec2 minMaxAttr = computeTrajectoriesAttributeMinMax(trajectories, varIdx);
+        float minAttr = minMaxAttr.x;
+        float maxAttr = minMaxAttr.y;
         if (attributeNames.at(varIdx) == "Helicity") {
             float maxAbs = std::max(std::abs(minAttr), std::abs(maxAttr));
             minAttr = -maxAbs;
@@ -556,28 +618,9 @@ void LineDataFlow::setTrajectoryData(const Trajectories& trajectories) {
         useRotatingHelicityBands = false;
     }
 
-#ifdef USE_TBB
-    numTotalTrajectoryPoints = tbb::parallel_reduce(
-            tbb::blocked_range<size_t>(0, trajectories.size()), size_t(0),
-            [&trajectories](tbb::blocked_range<size_t> const& r, size_t numTotalTrajectoryPoints) {
-                for (auto i = r.begin(); i != r.end(); i++) {
-                    const Trajectory& trajectory = trajectories.at(i);
-                    numTotalTrajectoryPoints += trajectory.positions.size();
-                }
-                return numTotalTrajectoryPoints;
-            }, std::plus<>{});
-#else
-    numTotalTrajectoryPoints = 0;
-#if _OPENMP >= 201107
-    #pragma omp parallel for reduction(+: numTotalTrajectoryPoints) shared(trajectories) default(none)
-#endif
-    for (size_t i = 0; i < trajectories.size(); i++) {
-        const Trajectory& trajectory = trajectories.at(i);
-        numTotalTrajectoryPoints += trajectory.positions.size();
-    }
-#endif
+    numTotalTrajectoryPoints = trajectories.getNumLinePoints();
 
-    modelBoundingBox = computeTrajectoriesAABB3(this->trajectories);
+    modelBoundingBox = computeTrajectoriesAABB3(trajectories);
     focusBoundingBox = modelBoundingBox;
 
     dirty = true;
@@ -715,17 +758,26 @@ bool LineDataFlow::setNewSettings(const SettingsMap& settings) {
         }
     }
 
+    if (settings.getValueOpt("line_simplification", useLineSimplification)) {
+        dirty = true;
+        reRender = true;
+    }
+    if (settings.getValueOpt("line_simplification_position_error", lineSimplificationPositionError)) {
+        dirty = true;
+        reRender = true;
+    }
+    if (settings.getValueOpt("line_simplification_attribute_error", lineSimplificationAttributeError)) {
+        dirty = true;
+        reRender = true;
+    }
+
     return shallReloadGatherShader;
 }
 
 void LineDataFlow::recomputeHistogram() {
     std::vector<float> attributeList;
     if (!attributeNames.empty()) {
-        for (const Trajectory& trajectory : trajectories) {
-            for (float val : trajectory.attributes.at(selectedAttributeIndex)) {
-                attributeList.push_back(val);
-            }
-        }
+        attributeList = trajectories.getAttributeValues(selectedAttributeIndex).toVector();
     }
     glm::vec2 minMaxAttributes;
     if (selectedAttributeIndex < int(minMaxAttributeValues.size())) {
@@ -738,13 +790,8 @@ void LineDataFlow::recomputeHistogram() {
 
     const size_t numAttributes = attributeNames.size();
     std::vector<std::vector<float>> attributesList(numAttributes);
-    for (const Trajectory& trajectory : trajectories) {
-        for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
-            std::vector<float>& attributeList = attributesList.at(attrIdx);
-            for (float val : trajectory.attributes.at(attrIdx)) {
-                attributeList.push_back(val);
-            }
-        }
+    for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+        attributesList.at(attrIdx) = trajectories.getAttributeValues(attrIdx).toVector();
     }
     multiVarTransferFunctionWindow.setAttributesValues(attributeNames, attributesList);
 
@@ -764,11 +811,7 @@ void LineDataFlow::recomputeColorLegend() {
 }
 
 size_t LineDataFlow::getNumAttributes() {
-    size_t numAttributes = 0;
-    if (!trajectories.empty()) {
-        numAttributes = trajectories.front().attributes.size();
-    }
-    return numAttributes;
+    return trajectories.getNumAttributes();
 }
 
 size_t LineDataFlow::getNumLines() {
@@ -776,45 +819,27 @@ size_t LineDataFlow::getNumLines() {
 }
 
 size_t LineDataFlow::getNumLinePoints() {
-    size_t numLinePoints = 0;
-    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-        Trajectory& trajectory = trajectories.at(trajectoryIdx);
-        numLinePoints += trajectory.positions.size();
-    }
-    return numLinePoints;
+    return trajectories.getNumLinePoints();
 }
 
 size_t LineDataFlow::getNumLineSegments() {
-    size_t numLineSegments = 0;
-    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-        Trajectory& trajectory = trajectories.at(trajectoryIdx);
-        numLineSegments += trajectory.positions.size() - 1ull;
-    }
-    return numLineSegments;
+    return trajectories.getNumLinePoints() - trajectories.getNumLines();
 }
 
 size_t LineDataFlow::getBaseSizeInBytes() {
-    size_t baseSizeInBytes = 0;
-    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-        const Trajectory& trajectory = trajectories.at(trajectoryIdx);
-        baseSizeInBytes += trajectory.positions.size() * sizeof(glm::vec3);
-        for (size_t attributeIdx = 0; attributeIdx < trajectory.attributes.size(); attributeIdx++) {
-            baseSizeInBytes += trajectory.attributes.at(attributeIdx).size() * sizeof(float);
-        }
-    }
-    return baseSizeInBytes;
+    return trajectories.getSizeInBytes();
 }
 
 
-void LineDataFlow::iterateOverTrajectories(std::function<void(const Trajectory&)> callback) {
-    for (const Trajectory& trajectory : trajectories) {
+void LineDataFlow::iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback) {
+    for (const TrajectoryView& trajectory : trajectories) {
         callback(trajectory);
     }
 }
 
-void LineDataFlow::iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback) {
+void LineDataFlow::iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback) {
     size_t trajectoryIndex = 0;
-    for (const Trajectory& trajectory : trajectories) {
+    for (const TrajectoryView& trajectory : trajectories) {
         if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIndex)) {
             trajectoryIndex++;
             continue;
@@ -824,9 +849,9 @@ void LineDataFlow::iterateOverTrajectoriesNotFiltered(std::function<void(const T
     }
 }
 
-void LineDataFlow::filterTrajectories(std::function<bool(const Trajectory&)> callback) {
+void LineDataFlow::filterTrajectories(std::function<bool(const TrajectoryView&)> callback) {
     size_t trajectoryIdx = 0;
-    for (const Trajectory& trajectory : trajectories) {
+    for (const TrajectoryView& trajectory : trajectories) {
         if (callback(trajectory)) {
             filteredTrajectories.at(trajectoryIdx) = true;
         }
@@ -850,7 +875,7 @@ Trajectories LineDataFlow::filterTrajectoryData() {
     Trajectories trajectoriesFiltered;
     trajectoriesFiltered.reserve(trajectories.size());
     size_t trajectoryIndex = 0;
-    for (const Trajectory& trajectory : trajectories) {
+    for (const TrajectoryView& trajectory : trajectories) {
         if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIndex)) {
             trajectoryIndex++;
             continue;
@@ -899,7 +924,7 @@ std::vector<std::vector<glm::vec3>> LineDataFlow::getFilteredLines(LineRenderer*
     std::vector<std::vector<glm::vec3>> linesFiltered;
     linesFiltered.reserve(trajectories.size());
     size_t trajectoryIndex = 0;
-    for (const Trajectory& trajectory : trajectories) {
+    for (const TrajectoryView& trajectory : trajectories) {
         if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIndex)) {
             trajectoryIndex++;
             continue;
@@ -1071,8 +1096,8 @@ LinePassQuadsRenderDataProgrammablePull LineDataFlow::getLinePassQuadsRenderData
             continue;
         }
 
-        Trajectory& trajectory = trajectories.at(trajectoryIdx);
-        std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+        TrajectoryView trajectory = trajectories.at(trajectoryIdx);
+        TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
         assert(attributes.size() == trajectory.positions.size());
         std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
         std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -1145,8 +1170,8 @@ TubeRenderDataOpacityOptimization LineDataFlow::getTubeRenderDataOpacityOptimiza
             continue;
         }
 
-        Trajectory& trajectory = trajectories.at(trajectoryIdx);
-        std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+        TrajectoryView trajectory = trajectories.at(trajectoryIdx);
+        TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
         assert(attributes.size() == trajectory.positions.size());
         std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
         std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -1194,261 +1219,187 @@ TubeRenderDataOpacityOptimization LineDataFlow::getTubeRenderDataOpacityOptimiza
     return tubeRenderData;
 }
 
-void LineDataFlow::getLinePassTubeRenderDataGeneral(
-        const std::function<uint32_t()>& indexOffsetFunctor,
-        const std::function<void(
-                const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                float lineRotation, uint32_t indexOffset, size_t lineIdx, size_t pointIdx)>& pointPushFunctor,
-        const std::function<void()>& pointPopFunctor,
-        const std::function<void(int numSegments, uint32_t indexOffset)>& indicesPushFunctor) {
-    std::vector<std::vector<glm::vec3>> lineCentersList;
-    std::vector<std::vector<float>> lineAttributesList;
-    std::vector<std::vector<float>> lineRotationsList; //< Used if useRotatingHelicityBands is set to true.
-
-    lineCentersList.resize(trajectories.size());
-    lineAttributesList.resize(trajectories.size());
-    if (!useRotatingHelicityBands && getUseBandRendering() && useRibbons && hasBandsData) {
-        std::vector<std::vector<glm::vec3>> ribbonDirectionsList;
-
-        ribbonDirectionsList.resize(trajectories.size());
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
-            }
+void LineDataFlow::getLinePassLineRanges(LinePassLineRanges& lineRanges) {
+    const SimplifiedLines* simplifiedLinesPtr = getSimplifiedLines();
+    computeLinePassLineRanges(
+            trajectories, filteredTrajectories, 0, 0, lineRanges,
+            simplifiedLinesPtr ? simplifiedLinesPtr->keepLinePoints.data() : nullptr);
+}
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-            std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(trajectoryIdx);
-            assert(attributes.size() == trajectory.positions.size());
-            std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
-            std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
-            std::vector<glm::vec3>& ribbonDirectionVectors = ribbonDirectionsList.at(trajectoryIdx);
+const SimplifiedLines* LineDataFlow::getSimplifiedLines() {
+    if (!useLineSimplification) {
+        return nullptr;
+    }
 
-            for (size_t j = 0; j < trajectory.positions.size(); j++) {
-                lineCenters.push_back(trajectory.positions.at(j));
-                lineAttributes.push_back(attributes.at(j));
-                ribbonDirectionVectors.push_back(ribbonDirections.at(j));
-            }
+    LineSimplificationSettings settings;
+    settings.maxPositionError =
+            lineSimplificationPositionError * glm::length(modelBoundingBox.getDimensions());
+    if (useMultiVarRendering) {
+        for (size_t attrIdx = 0; attrIdx < getNumAttributes(); attrIdx++) {
+            settings.attributeIndices.push_back(uint32_t(attrIdx));
+        }
+    } else {
+        settings.attributeIndices.push_back(uint32_t(selectedAttributeIndex));
+        if (useRotatingHelicityBands && helicityAttributeIndex != selectedAttributeIndex) {
+            // The band rotation is accumulated from the helicity along the line.
+            settings.attributeIndices.push_back(uint32_t(helicityAttributeIndex));
         }
+    }
+    for (uint32_t attrIdx : settings.attributeIndices) {
+        const glm::vec2& minMaxValue = minMaxAttributeValues.at(attrIdx);
+        settings.maxAttributeErrors.push_back(lineSimplificationAttributeError * (minMaxValue.y - minMaxValue.x));
+    }
 
-        for (size_t lineId = 0; lineId < lineCentersList.size(); lineId++) {
-            const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
-            const std::vector<float>& lineAttributes = lineAttributesList.at(lineId);
-            const std::vector<glm::vec3>& ribbonDirectionVectors = ribbonDirectionsList.at(lineId);
-            assert(lineCenters.size() == lineAttributes.size());
-            size_t n = lineCenters.size();
-            uint32_t indexOffset = indexOffsetFunctor();
+    if (!simplifiedLinesDirty && settings == simplifiedLinesSettings) {
+        return &simplifiedLines;
+    }
+    simplifyLines(trajectories, settings, simplifiedLines);
+    simplifiedLinesSettings = settings;
+    simplifiedLinesDirty = false;
 
-            if (n < 2) {
-                continue;
-            }
+    auto getPercentage = [](size_t numOut, size_t numIn) {
+        return sgl::toString(numIn > 0 ? 100.0 * double(numOut) / double(numIn) : 100.0);
+    };
+    size_t numTrianglesPerSegment = size_t(tubeNumSubdivisions) * 2;
+    sgl::Logfile::get()->writeInfo(
+            "Line simplification: " + std::to_string(simplifiedLines.numLinePointsOut) + " of "
+            + std::to_string(simplifiedLines.numLinePointsIn) + " line points kept ("
+            + getPercentage(simplifiedLines.numLinePointsOut, simplifiedLines.numLinePointsIn) + "%), "
+            + std::to_string(simplifiedLines.numLineSegmentsOut * numTrianglesPerSegment) + " of "
+            + std::to_string(simplifiedLines.numLineSegmentsIn * numTrianglesPerSegment)
+            + " tube triangles (without caps).");
+
+    return &simplifiedLines;
+}
 
-            glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
-            int numValidLinePoints = 0;
-            for (size_t i = 0; i < n; i++) {
-                glm::vec3 tangent, normal;
-                if (i == 0) {
-                    tangent = lineCenters[i+1] - lineCenters[i];
-                } else if (i == n - 1) {
-                    tangent = lineCenters[i] - lineCenters[i-1];
-                } else {
-                    tangent = (lineCenters[i+1] - lineCenters[i-1]);
-                }
-                float lineSegmentLength = glm::length(tangent);
+const LineLodHierarchy& LineDataFlow::getLineLodHierarchy() {
+    if (!lineLodHierarchyDirty) {
+        return lineLodHierarchy;
+    }
+    LineLodHierarchySettings settings;
+    settings.minError = lineLodMinError * glm::length(modelBoundingBox.getDimensions());
+    settings.errorFactor = 2.0f;
+    settings.numLevels = 12;
+    lineLodHierarchy.build(trajectories, settings);
+    lineLodHierarchyDirty = false;
 
-                if (lineSegmentLength < 0.0001f) {
-                    // In case the two vertices are almost identical, just skip this path line segment
-                    continue;
-                }
-                tangent = glm::normalize(tangent);
+    std::string levelSizesString;
+    for (size_t numLinePoints : lineLodHierarchy.getLevelNumLinePoints()) {
+        levelSizesString += (levelSizesString.empty() ? "" : ", ") + std::to_string(numLinePoints);
+    }
+    sgl::Logfile::get()->writeInfo(
+            "Line LOD hierarchy: " + std::to_string(lineLodHierarchy.getNumLevels()) + " levels with "
+            + levelSizesString + " line points ("
+            + std::to_string(lineLodHierarchy.getSizeInBytes() / (1024 * 1024)) + "MiB).");
+    return lineLodHierarchy;
+}
 
-                normal = glm::cross(ribbonDirectionVectors.at(i), tangent);
+void LineDataFlow::selectLineLodLevels(SceneData* sceneData, float pixelErrorBudget, LineLodSelection& selection) {
+    const LineLodHierarchy& hierarchy = getLineLodHierarchy();
+    LineLodViewParameters viewParameters;
+    viewParameters.cameraPosition = sceneData->camera->getPosition();
+    viewParameters.fieldOfViewY = sceneData->camera->getFOVy();
+    viewParameters.viewportHeight = float(*sceneData->viewportHeight);
+    hierarchy.selectLevels(viewParameters, pixelErrorBudget, 1.0f, selection);
 
-                pointPushFunctor(
-                        lineCenters.at(i), normal, tangent, lineAttributes.at(i),
-                        0.0f, indexOffset, lineId, i);
-                numValidLinePoints++;
-            }
+    if (filteredTrajectories.empty()) {
+        return;
+    }
+    for (size_t lineIdx = 0; lineIdx < selection.lineRanges.size(); lineIdx++) {
+        LineLodRange& lineRange = selection.lineRanges.at(lineIdx);
+        if (!filteredTrajectories.at(lineIdx) || lineRange.numIndices == 0) {
+            continue;
+        }
+        selection.numLinePoints -= lineRange.numIndices;
+        selection.numLineSegments -= lineRange.numIndices - 1;
+        selection.numLinePointsFinest -= hierarchy.getLineLevelNumPoints(lineIdx, 0);
+        selection.levelNumLines.at(lineRange.level)--;
+        lineRange.numIndices = 0;
+    }
+}
 
-            if (numValidLinePoints == 1) {
-                // Only one vertex left -> Output nothing (tube consisting only of one point).
-                pointPopFunctor();
-            }
-            if (numValidLinePoints <= 1) {
-                continue;
+void LineDataFlow::getTubeTriangleMeshLines(
+        std::vector<std::vector<glm::vec3>>& lineCentersList,
+        std::vector<std::vector<glm::vec3>>* ribbonDirectionsList) {
+    const SimplifiedLines* simplifiedLinesPtr = getSimplifiedLines();
+    lineCentersList.resize(trajectories.size());
+    if (ribbonDirectionsList) {
+        ribbonDirectionsList->resize(trajectories.size());
+    }
+    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
+        if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
+            continue;
+        }
+        TrajectorySpan<const glm::vec3> positions = trajectories.at(trajectoryIdx).positions;
+        if (!simplifiedLinesPtr) {
+            lineCentersList.at(trajectoryIdx) = positions.toVector();
+            if (ribbonDirectionsList) {
+                ribbonDirectionsList->at(trajectoryIdx) = ribbonsDirections.at(trajectoryIdx);
             }
-
-            // Create indices.
-            int numSegments = numValidLinePoints - 1;
-            indicesPushFunctor(numSegments, indexOffset);
+            continue;
         }
-    } else if (useRotatingHelicityBands) {
-        lineRotationsList.resize(trajectories.size());
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
+        size_t numPoints = simplifiedLinesPtr->getLineNumPoints(trajectoryIdx);
+        std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
+        lineCenters.resize(numPoints);
+        for (size_t i = 0; i < numPoints; i++) {
+            lineCenters[i] = positions[simplifiedLinesPtr->getLinePointIndex(trajectoryIdx, i)];
+        }
+        if (ribbonDirectionsList) {
+            const std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(trajectoryIdx);
+            std::vector<glm::vec3>& ribbonDirectionsSimplified = ribbonDirectionsList->at(trajectoryIdx);
+            ribbonDirectionsSimplified.resize(numPoints);
+            for (size_t i = 0; i < numPoints; i++) {
+                ribbonDirectionsSimplified[i] =
+                        ribbonDirections.at(simplifiedLinesPtr->getLinePointIndex(trajectoryIdx, i));
             }
+        }
+    }
+}
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-            std::vector<float>& helicities = trajectory.attributes.at(helicityAttributeIndex);
-            assert(attributes.size() == trajectory.positions.size());
-            std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
-            std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
-            std::vector<float>& lineRotations = lineRotationsList.at(trajectoryIdx);
+template<class LinePointWriter>
+void LineDataFlow::getLinePassTubeRenderDataGeneral(
+        const LinePassLineRanges& lineRanges, const LinePointWriter& writeLinePoint) {
+    const std::vector<uint64_t>& lineOffsets = trajectories.getLineOffsets();
 
+    // The rotation of the helicity bands accumulates along the line, so it is precomputed for all line points.
+    std::vector<float> lineRotations; //< Used if useRotatingHelicityBands is set to true.
+    if (useRotatingHelicityBands) {
+        lineRotations.resize(trajectories.getNumLinePoints());
+        forEachLinePassLine(lineRanges, [&](size_t lineIdx, const LinePassLineRange& /*lineRange*/) {
+            TrajectoryView trajectory = trajectories[lineIdx];
+            TrajectorySpan<const float> helicities = trajectory.attributes.at(helicityAttributeIndex);
+            float* rotations = lineRotations.data() + lineOffsets[lineIdx];
             float rotation = 0.0f;
             for (size_t j = 0; j < trajectory.positions.size(); j++) {
-                lineCenters.push_back(trajectory.positions.at(j));
-                lineAttributes.push_back(attributes.at(j));
-                lineRotations.push_back(rotation);
+                rotations[j] = rotation;
                 float lineSegmentLength = 0.0f;
                 if (j < trajectory.positions.size() - 1) {
-                    lineSegmentLength = glm::length(trajectory.positions.at(j + 1) - trajectory.positions.at(j));
-                }
-                rotation += helicities.at(j) / maxHelicity * sgl::PI * lineSegmentLength / 0.005f;
-            }
-        }
-
-        for (size_t lineId = 0; lineId < lineCentersList.size(); lineId++) {
-            const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
-            const std::vector<float>& lineAttributes = lineAttributesList.at(lineId);
-            const std::vector<float>& lineRotations = lineRotationsList.at(lineId);
-            assert(lineCenters.size() == lineAttributes.size());
-            size_t n = lineCenters.size();
-            uint32_t indexOffset = indexOffsetFunctor();
-
-            if (n < 2) {
-                continue;
-            }
-
-            glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
-            int numValidLinePoints = 0;
-            for (size_t i = 0; i < n; i++) {
-                glm::vec3 tangent, normal;
-                if (i == 0) {
-                    tangent = lineCenters[i+1] - lineCenters[i];
-                } else if (i == n - 1) {
-                    tangent = lineCenters[i] - lineCenters[i-1];
-                } else {
-                    tangent = (lineCenters[i+1] - lineCenters[i-1]);
-                }
-                float lineSegmentLength = glm::length(tangent);
-
-                if (lineSegmentLength < 0.0001f) {
-                    // In case the two vertices are almost identical, just skip this path line segment
-                    continue;
-                }
-                tangent = glm::normalize(tangent);
-
-                glm::vec3 helperAxis = lastLineNormal;
-                if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
-                    // If tangent == lastNormal
-                    helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-                    if (glm::length(glm::cross(helperAxis, normal)) < 0.01f) {
-                        // If tangent == helperAxis
-                        helperAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-                    }
+                    lineSegmentLength = glm::length(trajectory.positions[j + 1] - trajectory.positions[j]);
                 }
-                normal = glm::normalize(helperAxis - tangent * glm::dot(helperAxis, tangent)); // Gram-Schmidt
-                lastLineNormal = normal;
-
-                pointPushFunctor(
-                        lineCenters.at(i), normal, tangent, lineAttributes.at(i),
-                        lineRotations.at(i), indexOffset, lineId, i);
-                numValidLinePoints++;
-            }
-
-            if (numValidLinePoints == 1) {
-                // Only one vertex left -> Output nothing (tube consisting only of one point).
-                pointPopFunctor();
-            }
-            if (numValidLinePoints <= 1) {
-                continue;
-            }
-
-            // Create indices.
-            int numSegments = numValidLinePoints - 1;
-            indicesPushFunctor(numSegments, indexOffset);
-        }
-    } else {
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
-            }
-
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-            assert(attributes.size() == trajectory.positions.size());
-            std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
-            std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
-            for (size_t i = 0; i < trajectory.positions.size(); i++) {
-                lineCenters.push_back(trajectory.positions.at(i));
-                lineAttributes.push_back(attributes.at(i));
-            }
-        }
-
-        for (size_t lineId = 0; lineId < lineCentersList.size(); lineId++) {
-            const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
-            const std::vector<float>& lineAttributes = lineAttributesList.at(lineId);
-            assert(lineCenters.size() == lineAttributes.size());
-            size_t n = lineCenters.size();
-            uint32_t indexOffset = indexOffsetFunctor();
-
-            if (n < 2) {
-                continue;
+                rotation += helicities[j] / maxHelicity * sgl::PI * lineSegmentLength / 0.005f;
             }
+        });
+    }
 
-            glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
-            int numValidLinePoints = 0;
-            for (size_t i = 0; i < n; i++) {
-                glm::vec3 tangent, normal;
-                if (i == 0) {
-                    tangent = lineCenters[i+1] - lineCenters[i];
-                } else if (i == n - 1) {
-                    tangent = lineCenters[i] - lineCenters[i-1];
-                } else {
-                    tangent = (lineCenters[i+1] - lineCenters[i-1]);
-                }
-                float lineSegmentLength = glm::length(tangent);
-
-                if (lineSegmentLength < 0.0001f) {
-                    // In case the two vertices are almost identical, just skip this path line segment
-                    continue;
-                }
-                tangent = glm::normalize(tangent);
+    const std::vector<std::vector<glm::vec3>>* bandRightVectorsList = nullptr;
+    if (!useRotatingHelicityBands && getUseBandRendering() && useRibbons && hasBandsData) {
+        bandRightVectorsList = &ribbonsDirections;
+    }
 
-                glm::vec3 helperAxis = lastLineNormal;
-                if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
-                    // If tangent == lastNormal
-                    helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-                    if (glm::length(glm::cross(helperAxis, normal)) < 0.01f) {
-                        // If tangent == helperAxis
-                        helperAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-                    }
+    generateLinePassLinePoints(
+            trajectories, lineRanges, bandRightVectorsList,
+            [&](size_t lineIdx, size_t pointIdx, uint32_t linePointIdx, const LinePassLineRange& lineRange,
+                    const glm::vec3& normal, const glm::vec3& tangent) {
+                TrajectoryView trajectory = trajectories[lineIdx];
+                float lineRotation = 0.0f;
+                if (useRotatingHelicityBands) {
+                    lineRotation = lineRotations[lineOffsets[lineIdx] + pointIdx];
                 }
-                normal = glm::normalize(helperAxis - tangent * glm::dot(helperAxis, tangent)); // Gram-Schmidt
-                lastLineNormal = normal;
-
-                pointPushFunctor(
-                        lineCenters.at(i), normal, tangent, lineAttributes.at(i),
-                        0.0f, indexOffset, lineId, i);
-                numValidLinePoints++;
-            }
-
-            if (numValidLinePoints == 1) {
-                // Only one vertex left -> Output nothing (tube consisting only of one point).
-                pointPopFunctor();
-            }
-            if (numValidLinePoints <= 1) {
-                continue;
-            }
-
-            // Create indices.
-            int numSegments = numValidLinePoints - 1;
-            indicesPushFunctor(numSegments, indexOffset);
-        }
-    }
+                writeLinePoint(
+                        linePointIdx, trajectory.positions[pointIdx], normal, tangent,
+                        trajectory.attributes[selectedAttributeIndex][pointIdx], lineRotation,
+                        lineRange.linePointOffset, lineIdx, pointIdx);
+            });
 }
 
 LinePassTubeRenderData LineDataFlow::getLinePassTubeRenderData() {
@@ -1456,7 +1407,9 @@ LinePassTubeRenderData LineDataFlow::getLinePassTubeRenderData() {
     if (cachedRenderDataGeometryShader.indexBuffer) {
         return cachedRenderDataGeometryShader;
     }
-    removeOtherCachedDataTypes(RequestMode::GEOMETRY_SHADER);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::GEOMETRY_SHADER))) {
+        return cachedRenderDataGeometryShader;
+    }
 
     std::vector<uint32_t> lineIndices;
     std::vector<glm::vec3> vertexPositions;
@@ -1466,46 +1419,47 @@ LinePassTubeRenderData LineDataFlow::getLinePassTubeRenderData() {
     std::vector<float> vertexRotations; //< Used if useRotatingHelicityBands is set to true.
     std::vector<float> multiVarAttributeData;
 
+    LinePassLineRanges lineRanges;
+    getLinePassLineRanges(lineRanges);
+    vertexPositions.resize(lineRanges.numLinePoints);
+    vertexNormals.resize(lineRanges.numLinePoints);
+    vertexTangents.resize(lineRanges.numLinePoints);
+    vertexAttributes.resize(lineRanges.numLinePoints);
+    vertexRotations.resize(lineRanges.numLinePoints);
+    lineIndices.resize(size_t(lineRanges.numSegments) * 2);
+    const size_t numAttributes = attributeNames.size();
+    if (useMultiVarRendering) {
+        multiVarAttributeData.resize(size_t(lineRanges.numLinePoints) * numAttributes);
+    }
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(vertexPositions.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
-                    float lineAttribute, float lineRotation, uint32_t indexOffset,
+            lineRanges,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+                    float lineAttribute, float lineRotation, uint32_t /*indexOffset*/,
                     size_t lineIdx, size_t pointIdx) {
-                vertexPositions.push_back(lineCenter);
-                vertexNormals.push_back(normal);
-                vertexTangents.push_back(tangent);
-                vertexAttributes.push_back(lineAttribute);
-                vertexRotations.push_back(lineRotation);
-
-                if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.push_back(
-                                trajectories.at(lineIdx).attributes.at(attrIdx).at(pointIdx));
-                    }
-                }
-            },
-            [&] {
-                vertexPositions.pop_back();
-                vertexNormals.pop_back();
-                vertexTangents.pop_back();
-                vertexAttributes.pop_back();
-                vertexRotations.pop_back();
+                vertexPositions[linePointIdx] = lineCenter;
+                vertexNormals[linePointIdx] = normal;
+                vertexTangents[linePointIdx] = tangent;
+                vertexAttributes[linePointIdx] = lineAttribute;
+                vertexRotations[linePointIdx] = lineRotation;
 
                 if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.pop_back();
+                    TrajectoryView trajectory = trajectories[lineIdx];
+                    for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                        multiVarAttributeData[size_t(linePointIdx) * numAttributes + attrIdx] =
+                                trajectory.attributes.at(attrIdx).at(pointIdx);
                     }
                 }
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                for (int j = 0; j < numSegments; j++) {
-                    lineIndices.push_back(indexOffset + j);
-                    lineIndices.push_back(indexOffset + j + 1);
-                }
-            }
-    );
+            });
+    forEachLinePassLine(lineRanges, [&](size_t /*lineIdx*/, const LinePassLineRange& lineRange) {
+        uint32_t* indices = lineIndices.data() + size_t(lineRange.segmentOffset) * 2;
+        uint32_t indexOffset = lineRange.linePointOffset;
+        int numLineSegments = int(lineRange.numLinePoints) - 1;
+        for (int j = 0; j < numLineSegments; j++) {
+            *(indices++) = indexOffset + j;
+            *(indices++) = indexOffset + j + 1;
+        }
+    });
 
 
     if (lineIndices.empty()) {
@@ -1571,7 +1525,9 @@ LinePassTubeRenderDataMeshShader LineDataFlow::getLinePassTubeRenderDataMeshShad
     if (cachedRenderDataMeshShader.meshletDataBuffer) {
         return cachedRenderDataMeshShader;
     }
-    removeOtherCachedDataTypes(RequestMode::MESH_SHADER);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::MESH_SHADER))) {
+        return cachedRenderDataMeshShader;
+    }
 
     // We can emit a maximum of 64 vertices/primitives from the mesh shader.
     int numLineSegmentsPerMeshlet = 64 / tubeNumSubdivisions - 1;
@@ -1580,50 +1536,53 @@ LinePassTubeRenderDataMeshShader LineDataFlow::getLinePassTubeRenderDataMeshShad
     std::vector<LinePointDataUnified> linePoints;
     std::vector<float> multiVarAttributeData;
 
+    LinePassLineRanges lineRanges;
+    getLinePassLineRanges(lineRanges);
+    linePoints.resize(lineRanges.numLinePoints);
+    const size_t numAttributes = attributeNames.size();
+    if (useMultiVarRendering) {
+        multiVarAttributeData.resize(size_t(lineRanges.numLinePoints) * numAttributes);
+    }
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(linePoints.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+            lineRanges,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
                     float lineAttribute, float lineRotation, uint32_t indexOffset,
                     size_t lineIdx, size_t pointIdx) {
-                LinePointDataUnified linePointData;
+                LinePointDataUnified& linePointData = linePoints[linePointIdx];
                 linePointData.linePosition = lineCenter;
                 linePointData.lineNormal = normal;
                 linePointData.lineTangent = tangent;
                 linePointData.lineAttribute = lineAttribute;
                 linePointData.lineRotation = lineRotation;
                 linePointData.lineStartIndex = indexOffset;
-                linePoints.push_back(linePointData);
 
                 if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.push_back(
-                                trajectories.at(lineIdx).attributes.at(attrIdx).at(pointIdx));
+                    TrajectoryView trajectory = trajectories[lineIdx];
+                    for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                        multiVarAttributeData[size_t(linePointIdx) * numAttributes + attrIdx] =
+                                trajectory.attributes.at(attrIdx).at(pointIdx);
                     }
                 }
-            },
-            [&] {
-                linePoints.pop_back();
+            });
 
-                if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.pop_back();
-                    }
-                }
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                int numSegmentsLeft = numSegments;
-                int numMeshlets = sgl::iceil(numSegments, numLineSegmentsPerMeshlet);
-                for (int j = 0; j < numMeshlets; j++) {
-                    meshlet.linePointIndexStart = indexOffset + j * numLineSegmentsPerMeshlet;
-                    meshlet.numLinePoints =
-                            (numSegmentsLeft > numLineSegmentsPerMeshlet ? numLineSegmentsPerMeshlet : numSegmentsLeft) + 1;
-                    meshlets.push_back(meshlet);
-                    numSegmentsLeft -= numLineSegmentsPerMeshlet;
-                }
-            }
-    );
+    // The number of meshlets per line is cheap to compute, so they are created sequentially.
+    for (const LinePassLineRange& lineRange : lineRanges.lines) {
+        if (lineRange.numLinePoints == 0) {
+            continue;
+        }
+        uint32_t indexOffset = lineRange.linePointOffset;
+        int numLineSegments = int(lineRange.numLinePoints) - 1;
+        int numSegmentsLeft = numLineSegments;
+        int numMeshlets = sgl::iceil(numLineSegments, numLineSegmentsPerMeshlet);
+        for (int j = 0; j < numMeshlets; j++) {
+            meshlet.linePointIndexStart = indexOffset + j * numLineSegmentsPerMeshlet;
+            meshlet.numLinePoints =
+                    (numSegmentsLeft > numLineSegmentsPerMeshlet ? numLineSegmentsPerMeshlet : numSegmentsLeft) + 1;
+            meshlets.push_back(meshlet);
+            numSegmentsLeft -= numLineSegmentsPerMeshlet;
+        }
+    }
 
 
     if (meshlets.empty()) {
@@ -1654,7 +1613,6 @@ LinePassTubeRenderDataMeshShader LineDataFlow::getLinePassTubeRenderDataMeshShad
     }
 
     cachedRenderDataMeshShader = renderData;
-    cachedTubeNumSubdivisions = tubeNumSubdivisions;
     return renderData;
 }
 
@@ -1663,62 +1621,65 @@ LinePassTubeRenderDataProgrammablePull LineDataFlow::getLinePassTubeRenderDataPr
     if (cachedRenderDataProgrammablePull.indexBuffer) {
         return cachedRenderDataProgrammablePull;
     }
-    removeOtherCachedDataTypes(RequestMode::PROGRAMMABLE_PULL);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::PROGRAMMABLE_PULL))) {
+        return cachedRenderDataProgrammablePull;
+    }
 
     std::vector<uint32_t> triangleIndices;
     std::vector<LinePointDataUnified> linePoints;
     std::vector<float> multiVarAttributeData;
 
+    LinePassLineRanges lineRanges;
+    getLinePassLineRanges(lineRanges);
+    linePoints.resize(lineRanges.numLinePoints);
+    triangleIndices.resize(size_t(lineRanges.numSegments) * size_t(tubeNumSubdivisions) * 6);
+    const size_t numAttributes = attributeNames.size();
+    if (useMultiVarRendering) {
+        multiVarAttributeData.resize(size_t(lineRanges.numLinePoints) * numAttributes);
+    }
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(linePoints.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+            lineRanges,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
                     float lineAttribute, float lineRotation, uint32_t indexOffset,
                     size_t lineIdx, size_t pointIdx) {
-                LinePointDataUnified linePointData;
+                LinePointDataUnified& linePointData = linePoints[linePointIdx];
                 linePointData.linePosition = lineCenter;
                 linePointData.lineNormal = normal;
                 linePointData.lineTangent = tangent;
                 linePointData.lineAttribute = lineAttribute;
                 linePointData.lineRotation = lineRotation;
                 linePointData.lineStartIndex = indexOffset;
-                linePoints.push_back(linePointData);
 
                 if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.push_back(
-                                trajectories.at(lineIdx).attributes.at(attrIdx).at(pointIdx));
+                    TrajectoryView trajectory = trajectories[lineIdx];
+                    for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                        multiVarAttributeData[size_t(linePointIdx) * numAttributes + attrIdx] =
+                                trajectory.attributes.at(attrIdx).at(pointIdx);
                     }
                 }
-            },
-            [&] {
-                linePoints.pop_back();
+            });
+    forEachLinePassLine(lineRanges, [&](size_t /*lineIdx*/, const LinePassLineRange& lineRange) {
+        uint32_t* indices =
+                triangleIndices.data() + size_t(lineRange.segmentOffset) * size_t(tubeNumSubdivisions) * 6;
+        uint32_t indexOffset = lineRange.linePointOffset;
+        int numLineSegments = int(lineRange.numLinePoints) - 1;
+        for (int j = 0; j < numLineSegments; j++) {
+            uint32_t indexOffsetCurrent = (indexOffset + j) * tubeNumSubdivisions;
+            uint32_t indexOffsetNext = (indexOffset + j + 1) * tubeNumSubdivisions;
+            for (int k = 0; k < tubeNumSubdivisions; k++) {
+                int kNext = (k + 1) % tubeNumSubdivisions;
 
-                if (useMultiVarRendering) {
-                    for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                        multiVarAttributeData.pop_back();
-                    }
-                }
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                for (int j = 0; j < numSegments; j++) {
-                    uint32_t indexOffsetCurrent = (indexOffset + j) * tubeNumSubdivisions;
-                    uint32_t indexOffsetNext = (indexOffset + j + 1) * tubeNumSubdivisions;
-                    for (int k = 0; k < tubeNumSubdivisions; k++) {
-                        int kNext = (k + 1) % tubeNumSubdivisions;
-
-                        triangleIndices.push_back(indexOffsetCurrent + k);
-                        triangleIndices.push_back(indexOffsetCurrent + kNext);
-                        triangleIndices.push_back(indexOffsetNext + k);
-
-                        triangleIndices.push_back(indexOffsetNext + k);
-                        triangleIndices.push_back(indexOffsetCurrent + kNext);
-                        triangleIndices.push_back(indexOffsetNext + kNext);
-                    }
-                }
+                *(indices++) = indexOffsetCurrent + k;
+                *(indices++) = indexOffsetCurrent + kNext;
+                *(indices++) = indexOffsetNext + k;
+
+                *(indices++) = indexOffsetNext + k;
+                *(indices++) = indexOffsetCurrent + kNext;
+                *(indices++) = indexOffsetNext + kNext;
             }
-    );
+        }
+    });
 
 
     if (triangleIndices.empty()) {
@@ -1748,7 +1709,6 @@ LinePassTubeRenderDataProgrammablePull LineDataFlow::getLinePassTubeRenderDataPr
     }
 
     cachedRenderDataProgrammablePull = renderData;
-    cachedTubeNumSubdivisions = tubeNumSubdivisions;
     return renderData;
 }
 
@@ -1771,8 +1731,8 @@ LinePassQuadsRenderData LineDataFlow::getLinePassQuadsRenderData() {
                 continue;
             }
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
+            TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
             std::vector<glm::vec3>& ribbonDirections = ribbonsDirections.at(trajectoryIdx);
             assert(attributes.size() == trajectory.positions.size());
             assert(attributes.size() == ribbonDirections.size());
@@ -1838,9 +1798,9 @@ LinePassQuadsRenderData LineDataFlow::getLinePassQuadsRenderData() {
                 continue;
             }
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
             //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+            TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
             assert(attributes.size() == trajectory.positions.size());
             std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
             std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -1931,7 +1891,15 @@ TubeTriangleRenderData LineDataFlow::getLinePassTubeTriangleMeshRenderDataPayloa
         }
         return cachedTubeTriangleRenderData;
     }
-    removeOtherCachedDataTypes(RequestMode::TRIANGLES);
+    RenderDataCacheKey renderDataKey = getRenderDataCacheKey(RequestMode::TRIANGLES);
+    renderDataKey.vulkanRayTracing = vulkanRayTracing;
+    renderDataKey.payload = payload;
+    if (activateCachedDataType(renderDataKey)) {
+        if (cachedTubeTriangleRenderDataPayload) {
+            payload = cachedTubeTriangleRenderDataPayload;
+        }
+        return cachedTubeTriangleRenderData;
+    }
     cachedTubeTriangleRenderDataPayload = payload;
 
     std::vector<std::vector<glm::vec3>> lineCentersList;
@@ -1944,49 +1912,49 @@ TubeTriangleRenderData LineDataFlow::getLinePassTubeTriangleMeshRenderDataPayloa
     std::vector<LinePointDataUnified> tubeTriangleLinePointDataList;
     std::vector<float> multiVarAttributeData;
 
-    lineCentersList.resize(trajectories.size());
-    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-        if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-            continue;
-        }
-        lineCentersList.at(trajectoryIdx) = trajectories.at(trajectoryIdx).positions;
+    std::vector<std::vector<glm::vec3>> ribbonDirectionsList;
+    bool useEllipticTubes = getUseBandRendering() && useRibbons && hasBandsData;
+    getTubeTriangleMeshLines(lineCentersList, useEllipticTubes ? &ribbonDirectionsList : nullptr);
+    float tubeNormalRadius, tubeBinormalRadius;
+    if (useEllipticTubes) {
+        tubeBinormalRadius = LineRenderer::getBandWidth() * 0.5f;
+        tubeNormalRadius = tubeBinormalRadius * minBandThickness;
+    } else {
+        tubeNormalRadius = LineRenderer::getLineWidth() * 0.5f;
+        tubeBinormalRadius = tubeNormalRadius;
     }
 
-    if (getUseBandRendering() && useRibbons && hasBandsData) {
-        std::vector<std::vector<glm::vec3>> ribbonDirectionsList;
-        ribbonDirectionsList.resize(trajectories.size());
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
-            }
-            ribbonDirectionsList.at(trajectoryIdx) = ribbonsDirections.at(trajectoryIdx);
-        }
+    if (getCanStreamTubeTriangleMesh(payload)) {
+        createTubeTriangleRenderDataStreaming(
+                lineCentersList, useEllipticTubes ? &ribbonDirectionsList : nullptr,
+                tubeNormalRadius, tubeBinormalRadius, vulkanRayTracing);
+        return cachedTubeTriangleRenderData;
+    }
 
-        float binormalRadius = LineRenderer::getBandWidth() * 0.5f;
-        float normalRadius = binormalRadius * minBandThickness;
+    if (useEllipticTubes) {
         if (useCappedTubes) {
-            createCappedTriangleEllipticTubesRenderDataCPU(
-                    lineCentersList, ribbonDirectionsList, normalRadius,
-                    binormalRadius, tubeNumSubdivisions,
+            createCappedTriangleEllipticTubesRenderDataCPUParallel(
+                    lineCentersList, ribbonDirectionsList, tubeNormalRadius,
+                    tubeBinormalRadius, tubeNumSubdivisions,
                     false, tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
         } else {
-            createTriangleEllipticTubesRenderDataCPU(
-                    lineCentersList, ribbonDirectionsList, normalRadius,
-                    binormalRadius, tubeNumSubdivisions,
+            createTriangleEllipticTubesRenderDataCPUParallel(
+                    lineCentersList, ribbonDirectionsList, tubeNormalRadius,
+                    tubeBinormalRadius, tubeNumSubdivisions,
                     tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
         }
     } else {
         if (useCappedTubes) {
-            createCappedTriangleTubesRenderDataCPU(
-                    lineCentersList, LineRenderer::getLineWidth() * 0.5f,
+            createCappedTriangleTubesRenderDataCPUParallel(
+                    lineCentersList, tubeNormalRadius,
                     tubeNumSubdivisions, false,
                     tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
         } else {
-            createTriangleTubesRenderDataCPU(
-                    lineCentersList, LineRenderer::getLineWidth() * 0.5f,
+            createTriangleTubesRenderDataCPUParallel(
+                    lineCentersList, tubeNormalRadius,
                     tubeNumSubdivisions,
                     tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
@@ -1995,51 +1963,12 @@ TubeTriangleRenderData LineDataFlow::getLinePassTubeTriangleMeshRenderDataPayloa
 
     tubeTriangleLinePointDataList.resize(linePointReferences.size());
     if (useMultiVarRendering) {
-        multiVarAttributeData.reserve(attributeNames.size() * linePointReferences.size());
-    }
-    float rotation = 0.0f; //< Used if useRotatingHelicityBands is set to true.
-    uint32_t lineStartIndex = 0;
-    uint32_t lastTrajectoryIndex = 0;
-    for (size_t i = 0; i < linePointReferences.size(); i++) {
-        LinePointReference& linePointReference = linePointReferences.at(i);
-        LinePointDataUnified& tubeTriangleLinePointData = tubeTriangleLinePointDataList.at(i);
-        Trajectory& trajectory = trajectories.at(linePointReference.trajectoryIndex);
-        std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-
-        tubeTriangleLinePointData.linePosition = trajectory.positions.at(linePointReference.linePointIndex);
-        tubeTriangleLinePointData.lineAttribute = attributes.at(linePointReference.linePointIndex);
-        tubeTriangleLinePointData.lineTangent = lineTangents.at(i);
-        tubeTriangleLinePointData.lineNormal = lineNormals.at(i);
-
-        if (lastTrajectoryIndex != linePointReference.trajectoryIndex) {
-            lastTrajectoryIndex = linePointReference.trajectoryIndex;
-            lineStartIndex = uint32_t(i);
-        }
-        tubeTriangleLinePointData.lineStartIndex = lineStartIndex;
-
-        if (useRotatingHelicityBands) {
-            tubeTriangleLinePointData.lineRotation = rotation;
-            float helicity = trajectory.attributes.at(helicityAttributeIndex).at(
-                    linePointReference.linePointIndex);
-            float lineSegmentLength = 0.0f;
-            if (i < linePointReferences.size() - 1) {
-                LinePointReference& nextLinePointReference = linePointReferences.at(i + 1);
-                if (linePointReference.trajectoryIndex == nextLinePointReference.trajectoryIndex) {
-                    lineSegmentLength = glm::length(
-                            trajectory.positions.at(nextLinePointReference.linePointIndex)
-                            - trajectory.positions.at(linePointReference.linePointIndex));
-                }
-            }
-            rotation += helicity / maxHelicity * sgl::PI * lineSegmentLength / 0.005f;
-        }
-
-        if (useMultiVarRendering) {
-            for (size_t attrIdx = 0; attrIdx < attributeNames.size(); attrIdx++) {
-                multiVarAttributeData.push_back(
-                        trajectory.attributes.at(attrIdx).at(linePointReference.linePointIndex));
-            }
-        }
+        multiVarAttributeData.resize(attributeNames.size() * linePointReferences.size());
     }
+    TubeTriangleLinePointState linePointState;
+    fillTubeTriangleLinePointData(
+            linePointReferences, lineTangents, lineNormals, 0, linePointState,
+            tubeTriangleLinePointDataList.data(), multiVarAttributeData.data());
 
 
     sgl::vk::Device* device = sgl::AppSettings::get()->getPrimaryDevice();
@@ -2115,13 +2044,153 @@ TubeTriangleRenderData LineDataFlow::getLinePassTubeTriangleMeshRenderDataPayloa
     return cachedTubeTriangleRenderData;
 }
 
+void LineDataFlow::fillTubeTriangleLinePointData(
+        const std::vector<LinePointReference>& linePointReferences,
+        const std::vector<glm::vec3>& lineTangents, const std::vector<glm::vec3>& lineNormals,
+        size_t linePointOffset, TubeTriangleLinePointState& state,
+        LinePointDataUnified* tubeTriangleLinePointDataList, float* multiVarAttributeData) {
+    const size_t numAttributes = attributeNames.size();
+    for (size_t i = 0; i < linePointReferences.size(); i++) {
+        const LinePointReference& linePointReference = linePointReferences.at(i);
+        LinePointDataUnified& tubeTriangleLinePointData = tubeTriangleLinePointDataList[i];
+        TrajectoryView trajectory = trajectories.at(linePointReference.trajectoryIndex);
+        TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
+        uint32_t linePointIndex = getTrajectoryLinePointIndex(linePointReference);
+
+        tubeTriangleLinePointData.linePosition = trajectory.positions.at(linePointIndex);
+        tubeTriangleLinePointData.lineAttribute = attributes.at(linePointIndex);
+        tubeTriangleLinePointData.lineTangent = lineTangents.at(i);
+        tubeTriangleLinePointData.lineNormal = lineNormals.at(i);
+
+        if (state.lastTrajectoryIndex != linePointReference.trajectoryIndex) {
+            state.lastTrajectoryIndex = linePointReference.trajectoryIndex;
+            state.lineStartIndex = uint32_t(linePointOffset + i);
+        }
+        tubeTriangleLinePointData.lineStartIndex = state.lineStartIndex;
+
+        if (useRotatingHelicityBands) {
+            tubeTriangleLinePointData.lineRotation = state.rotation;
+            float helicity = trajectory.attributes.at(helicityAttributeIndex).at(linePointIndex);
+            // Chunks never split lines, so the next line point of the same line is always in the passed list.
+            float lineSegmentLength = 0.0f;
+            if (i < linePointReferences.size() - 1) {
+                const LinePointReference& nextLinePointReference = linePointReferences.at(i + 1);
+                if (linePointReference.trajectoryIndex == nextLinePointReference.trajectoryIndex) {
+                    lineSegmentLength = glm::length(
+                            trajectory.positions.at(getTrajectoryLinePointIndex(nextLinePointReference))
+                            - trajectory.positions.at(linePointIndex));
+                }
+            }
+            state.rotation += helicity / maxHelicity * sgl::PI * lineSegmentLength / 0.005f;
+        }
+
+        if (useMultiVarRendering) {
+            for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                multiVarAttributeData[i * numAttributes + attrIdx] =
+                        trajectory.attributes.at(attrIdx).at(linePointIndex);
+            }
+        }
+    }
+}
+
+void LineDataFlow::createTubeTriangleRenderDataStreaming(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>* lineRightVectorsList,
+        float tubeNormalRadius, float tubeBinormalRadius, bool vulkanRayTracing) {
+    sgl::vk::Device* device = sgl::AppSettings::get()->getPrimaryDevice();
+    cachedTubeTriangleRenderData = {};
+    cachedTubeTriangleRenderDataIsRayTracing = vulkanRayTracing;
+
+    // The count pass determines the size of the complete mesh, so the GPU buffers can be allocated up front.
+    TriangleTubeMeshChunkGenerator generator(
+            lineCentersList, lineRightVectorsList, tubeNormalRadius, tubeBinormalRadius, tubeNumSubdivisions,
+            useCappedTubes, false, 0, 0, tubeTriangleStreamingChunkSize);
+    if (generator.getNumIndices() == 0) {
+        return;
+    }
+    const size_t numAttributes = attributeNames.size();
+
+    uint32_t indexBufferFlags =
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    uint32_t vertexBufferFlags =
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (vulkanRayTracing) {
+        indexBufferFlags |=
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+        vertexBufferFlags |=
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+    }
+
+    cachedTubeTriangleRenderData.indexBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, generator.getNumIndices() * sizeof(uint32_t),
+            indexBufferFlags, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    cachedTubeTriangleRenderData.vertexBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, generator.getNumVertices() * sizeof(TubeTriangleVertexData),
+            vertexBufferFlags, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    cachedTubeTriangleRenderData.linePointDataBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, generator.getNumLinePoints() * sizeof(LinePointDataUnified),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+
+    if (useMultiVarRendering) {
+        cachedTubeTriangleRenderData.multiVarAttributeDataBuffer = std::make_shared<sgl::vk::Buffer>(
+                device, numAttributes * generator.getNumLinePoints() * sizeof(float),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+    }
+
+    // The copies of one chunk are submitted while the next chunk is generated.
+    StagingRingUploader uploader(device, tubeTriangleStreamingChunkSize);
+    std::vector<LinePointDataUnified> tubeTriangleLinePointDataList;
+    std::vector<float> multiVarAttributeData;
+    TubeTriangleLinePointState linePointState;
+    for (size_t chunkIdx = 0; chunkIdx < generator.getNumChunks(); chunkIdx++) {
+        const TubeTriangleMeshChunk& chunk = generator.generateChunk(chunkIdx);
+        const size_t numChunkLinePoints = chunk.linePointReferenceList.size();
+        tubeTriangleLinePointDataList.resize(numChunkLinePoints);
+        if (useMultiVarRendering) {
+            multiVarAttributeData.resize(numAttributes * numChunkLinePoints);
+        }
+        fillTubeTriangleLinePointData(
+                chunk.linePointReferenceList, chunk.lineTangents, chunk.lineNormals, chunk.linePointOffset,
+                linePointState, tubeTriangleLinePointDataList.data(), multiVarAttributeData.data());
+
+        uploader.uploadData(
+                cachedTubeTriangleRenderData.indexBuffer, chunk.indexOffset * sizeof(uint32_t),
+                chunk.triangleIndices.size() * sizeof(uint32_t), chunk.triangleIndices.data());
+        uploader.uploadData(
+                cachedTubeTriangleRenderData.vertexBuffer, chunk.vertexOffset * sizeof(TubeTriangleVertexData),
+                chunk.vertexDataList.size() * sizeof(TubeTriangleVertexData), chunk.vertexDataList.data());
+        uploader.uploadData(
+                cachedTubeTriangleRenderData.linePointDataBuffer,
+                chunk.linePointOffset * sizeof(LinePointDataUnified),
+                numChunkLinePoints * sizeof(LinePointDataUnified), tubeTriangleLinePointDataList.data());
+        if (useMultiVarRendering) {
+            uploader.uploadData(
+                    cachedTubeTriangleRenderData.multiVarAttributeDataBuffer,
+                    chunk.linePointOffset * numAttributes * sizeof(float),
+                    multiVarAttributeData.size() * sizeof(float), multiVarAttributeData.data());
+        }
+        uploader.flush();
+    }
+    uploader.finish();
+}
+
 TubeAabbRenderData LineDataFlow::getLinePassTubeAabbRenderData(bool isRasterizer, bool ellipticTubes) {
     rebuildInternalRepresentationIfNecessary();
     if (cachedTubeAabbRenderData.indexBuffer && tubeAabbEllipticTubes == ellipticTubes) {
         return cachedTubeAabbRenderData;
     }
+    RenderDataCacheKey renderDataKey = getRenderDataCacheKey(RequestMode::AABBS);
+    renderDataKey.ellipticTubes = ellipticTubes;
+    if (activateCachedDataType(renderDataKey)) {
+        return cachedTubeAabbRenderData;
+    }
     tubeAabbEllipticTubes = ellipticTubes;
-    removeOtherCachedDataTypes(RequestMode::AABBS);
 
     bool useRibbonNormals = ellipticTubes && useRibbons && hasBandsData;
     glm::vec3 lineWidthOffset;
@@ -2147,7 +2216,7 @@ TubeAabbRenderData LineDataFlow::getLinePassTubeAabbRenderData(bool isRasterizer
         if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
             continue;
         }
-        Trajectory& trajectory = trajectories.at(trajectoryIdx);
+        TrajectoryView trajectory = trajectories.at(trajectoryIdx);
 
         glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
         uint32_t numValidLinePoints = 0;
@@ -2326,34 +2395,21 @@ void LineDataFlow::getTriangleMesh(
     std::vector<TubeTriangleVertexData> tubeTriangleVertexDataList;
     std::vector<LinePointReference> linePointReferences;
 
-    lineCentersList.resize(trajectories.size());
-    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-        if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-            continue;
-        }
-        lineCentersList.at(trajectoryIdx) = trajectories.at(trajectoryIdx).positions;
-    }
-
-    if (getUseBandRendering() && useRibbons && hasBandsData) {
-        std::vector<std::vector<glm::vec3>> ribbonDirectionsList;
-        ribbonDirectionsList.resize(trajectories.size());
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
-            }
-            ribbonDirectionsList.at(trajectoryIdx) = ribbonsDirections.at(trajectoryIdx);
-        }
+    bool useEllipticTubes = getUseBandRendering() && useRibbons && hasBandsData;
+    std::vector<std::vector<glm::vec3>> ribbonDirectionsList;
+    getTubeTriangleMeshLines(lineCentersList, useEllipticTubes ? &ribbonDirectionsList : nullptr);
 
+    if (useEllipticTubes) {
         float binormalRadius = LineRenderer::getBandWidth() * 0.5f;
         float normalRadius = binormalRadius * minBandThickness;
         if (useCappedTubes) {
-            createCappedTriangleEllipticTubesRenderDataCPU(
+            createCappedTriangleEllipticTubesRenderDataCPUParallel(
                     lineCentersList, ribbonDirectionsList, normalRadius,
                     binormalRadius, tubeNumSubdivisions,
                     false, triangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
         } else {
-            createTriangleEllipticTubesRenderDataCPU(
+            createTriangleEllipticTubesRenderDataCPUParallel(
                     lineCentersList, ribbonDirectionsList, normalRadius,
                     binormalRadius, tubeNumSubdivisions,
                     triangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -2361,13 +2417,13 @@ void LineDataFlow::getTriangleMesh(
         }
     } else {
         if (useCappedTubes) {
-            createCappedTriangleTubesRenderDataCPU(
+            createCappedTriangleTubesRenderDataCPUParallel(
                     lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                     tubeNumSubdivisions, false,
                     triangleIndices, tubeTriangleVertexDataList, linePointReferences,
                     0, lineTangents, lineNormals);
         } else {
-            createTriangleTubesRenderDataCPU(
+            createTriangleTubesRenderDataCPUParallel(
                     lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                     tubeNumSubdivisions,
                     triangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -2384,9 +2440,9 @@ void LineDataFlow::getTriangleMesh(
 
         LinePointReference& linePointReference = linePointReferences.at(
                 tubeTriangleVertexData.vertexLinePointIndex & 0x7FFFFFFFu);
-        Trajectory& trajectory = trajectories.at(linePointReference.trajectoryIndex);
-        std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-        float attributeValue = attributes.at(linePointReference.linePointIndex);
+        TrajectoryView trajectory = trajectories.at(linePointReference.trajectoryIndex);
+        TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
+        float attributeValue = attributes.at(getTrajectoryLinePointIndex(linePointReference));
         vertexAttributes.push_back(attributeValue);
     }
 }
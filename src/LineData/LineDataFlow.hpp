@@ -31,6 +31,11 @@
 
 #include <ImGui/Widgets/MultiVarTransferFunctionWindow.hpp>
 #include "LineData.hpp"
+#include "LineSimplification.hpp"
+#include "LineLodHierarchy.hpp"
+
+struct LinePassLineRanges;
+struct SceneData;
 
 class LineDataFlow : public LineData {
     friend class StreamlineTracingRequester;
@@ -39,9 +44,22 @@ public:
     ~LineDataFlow() override;
     bool settingsDiffer(LineData* other) override;
     void update(float dt) override;
-    virtual void setTrajectoryData(const Trajectories& trajectories);
+    /**
+     * The array-of-structs overload converts the data and forwards to the virtual TrajectoryStore overload.
+     * Subclasses overriding the latter need 'using LineDataFlow::setTrajectoryData;' to keep the former visible.
+     */
+    void setTrajectoryData(const Trajectories& trajectories);
+    virtual void setTrajectoryData(TrajectoryStore&& trajectoryStore);
     [[nodiscard]] bool getIsSmallDataSet() const override;
 
+    /// Returns the multi-resolution line hierarchy (see LineLodHierarchy.hpp). It is (re-)built if necessary.
+    const LineLodHierarchy& getLineLodHierarchy();
+    /**
+     * Selects a level of detail per line such that the projected simplification error stays below pixelErrorBudget
+     * for the camera of the passed scene data. Filtered lines are culled.
+     */
+    void selectLineLodLevels(SceneData* sceneData, float pixelErrorBudget, LineLodSelection& selection);
+
     /// For changing internal settings programmatically and not over the GUI.
     bool setNewSettings(const SettingsMap& settings) override;
 
@@ -65,9 +83,9 @@ public:
     size_t getBaseSizeInBytes() override;
 
     // Public interface for filtering trajectories.
-    void iterateOverTrajectories(std::function<void(const Trajectory&)> callback) override;
-    void iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback) override;
-    void filterTrajectories(std::function<bool(const Trajectory&)> callback) override;
+    void iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback) override;
+    void iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback) override;
+    void filterTrajectories(std::function<bool(const TrajectoryView&)> callback) override;
     void resetTrajectoryFilter() override;
 
     // Get filtered line data (only containing points also shown when rendering).
@@ -131,29 +149,87 @@ protected:
     void recomputeColorLegend() override;
     void recomputeWidgetPositions();
     void onAttributeNamesSet();
+    void setSimulationMeshOutline(const BinLinesData& binLinesData);
 
+    /**
+     * Computes the number of valid line points of all lines and their offsets in the line point arrays created by
+     * @see getLinePassTubeRenderDataGeneral.
+     */
+    void getLinePassLineRanges(LinePassLineRanges& lineRanges);
     /**
      * Function used by, e.g., @see getLinePassTubeRenderData, @see getLinePassTubeRenderDataMeshShader and
      * @see getLinePassTubeRenderDataProgrammablePull.
-     * It encapsulates shared code for creating line vertex and index data.
-     * @param indexOffsetFunctor A functor that returns the line index offset for the next points to be pushed.
-     * @param pointPushFunctor A functor that accepts a new point.
-     * @param pointPopFunctor A functor that gets called when the previous point needs to be removed. This usually
-     * happens when a line doesn't have at least two valid points.
-     * @param indicesPushFunctor A functor that creates line index data for the previously pushed points.
+     * It encapsulates shared code for creating line vertex data. The line points are generated in parallel and
+     * passed to writeLinePoint, which needs to write them to index linePointIdx of preallocated arrays.
+     * @param lineRanges The line ranges computed by @see getLinePassLineRanges.
+     * @param writeLinePoint Called as writeLinePoint(linePointIdx, lineCenter, normal, tangent, lineAttribute,
+     * lineRotation, lineStartIndex, lineIdx, pointIdx).
      */
-    void getLinePassTubeRenderDataGeneral(
-            const std::function<uint32_t()>& indexOffsetFunctor,
-            const std::function<void(
-                    const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                    float lineRotation, uint32_t indexOffset, size_t lineIdx, size_t pointIdx)>& pointPushFunctor,
-            const std::function<void()>& pointPopFunctor,
-            const std::function<void(int numSegments, uint32_t indexOffset)>& indicesPushFunctor);
-
-    Trajectories trajectories;
+    template<class LinePointWriter>
+    void getLinePassTubeRenderDataGeneral(const LinePassLineRanges& lineRanges, const LinePointWriter& writeLinePoint);
+
+    /// State carried from one line point to the next by @see fillTubeTriangleLinePointData.
+    struct TubeTriangleLinePointState {
+        float rotation = 0.0f; ///< Used if useRotatingHelicityBands is set to true.
+        uint32_t lineStartIndex = 0;
+        uint32_t lastTrajectoryIndex = 0;
+    };
+    /**
+     * Fills the line point data of consecutive line points of the tube triangle mesh.
+     * @param linePointOffset The index of the first passed line point in the complete mesh.
+     * @param multiVarAttributeData Only used if multi-var rendering is enabled.
+     */
+    void fillTubeTriangleLinePointData(
+            const std::vector<LinePointReference>& linePointReferences,
+            const std::vector<glm::vec3>& lineTangents, const std::vector<glm::vec3>& lineNormals,
+            size_t linePointOffset, TubeTriangleLinePointState& state,
+            LinePointDataUnified* tubeTriangleLinePointDataList, float* multiVarAttributeData);
+    /**
+     * Generates the tube triangle mesh in chunks and uploads each chunk before the next one is generated.
+     * This way, the complete mesh never needs to be stored in host memory.
+     */
+    void createTubeTriangleRenderDataStreaming(
+            const std::vector<std::vector<glm::vec3>>& lineCentersList,
+            const std::vector<std::vector<glm::vec3>>* lineRightVectorsList,
+            float tubeNormalRadius, float tubeBinormalRadius, bool vulkanRayTracing);
+
+    TrajectoryStore trajectories;
     size_t numTotalTrajectoryPoints = 0;
     std::vector<bool> filteredTrajectories;
 
+    /*
+     * Optional error-bounded simplification of the lines before meshing (see LineSimplification.hpp). It is used by
+     * the line pass renderers and the tube triangle meshes.
+     */
+    /// Returns the simplified lines or nullptr if the simplification is disabled. Recomputes them if necessary.
+    const SimplifiedLines* getSimplifiedLines();
+    /**
+     * Returns the lines used for creating tube triangle meshes, i.e., the simplified lines if simplification is
+     * enabled. Filtered lines are empty.
+     * @param ribbonDirectionsList If not nullptr, the ribbon directions of the returned line points are stored.
+     */
+    void getTubeTriangleMeshLines(
+            std::vector<std::vector<glm::vec3>>& lineCentersList,
+            std::vector<std::vector<glm::vec3>>* ribbonDirectionsList);
+    /// Maps a line point reference of a mesh created from @see getTubeTriangleMeshLines to the trajectory point.
+    [[nodiscard]] inline uint32_t getTrajectoryLinePointIndex(const LinePointReference& linePointReference) const {
+        if (!useLineSimplification) {
+            return linePointReference.linePointIndex;
+        }
+        return simplifiedLines.getLinePointIndex(linePointReference.trajectoryIndex, linePointReference.linePointIndex);
+    }
+    bool useLineSimplification = false;
+    float lineSimplificationPositionError = 1e-4f; ///< Relative to the diagonal of the model bounding box.
+    float lineSimplificationAttributeError = 0.01f; ///< Relative to the value range of the attributes.
+    bool simplifiedLinesDirty = true; ///< Set when the line data changes.
+    LineSimplificationSettings simplifiedLinesSettings; ///< The settings simplifiedLines was computed with.
+    SimplifiedLines simplifiedLines;
+
+    // Multi-resolution line hierarchy for the level of detail selection.
+    float lineLodMinError = 1e-5f; ///< Error of the first coarser level relative to the model bounding box diagonal.
+    bool lineLodHierarchyDirty = true; ///< Set when the line data changes.
+    LineLodHierarchy lineLodHierarchy;
+
     // Optional ribbon data.
     static bool useRibbons;
     std::vector<std::vector<glm::vec3>> ribbonsDirections;
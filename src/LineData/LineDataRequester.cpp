@@ -35,8 +35,7 @@
 #include "LineDataRequester.hpp"
 
 LineDataRequester::LineDataRequester(sgl::TransferFunctionWindow& transferFunctionWindow)
-        : transferFunctionWindow(transferFunctionWindow) {
-    requesterThread = std::thread(&LineDataRequester::mainLoop, this);
+        : transferFunctionWindow(transferFunctionWindow), requestScheduler("LineDataRequester") {
 }
 
 LineDataRequester::~LineDataRequester() {
@@ -44,98 +43,33 @@ LineDataRequester::~LineDataRequester() {
 }
 
 void LineDataRequester::join() {
-    if (!programIsFinished) {
-        {
-            std::lock_guard<std::mutex> lock(requestMutex);
-            programIsFinished = true;
-            hasRequest = true;
-
-            {
-                std::lock_guard<std::mutex> lock(replyMutex);
-                this->lineData = LineDataPtr();
-            }
-            hasReplyConditionVariable.notify_all();
-        }
-        hasRequestConditionVariable.notify_all();
-        if (requesterThread.joinable()) {
-            requesterThread.join();
-        }
-    }
+    requestScheduler.join();
 }
 
 void LineDataRequester::queueRequest(
         LineDataPtr lineData, const std::vector<std::string>& fileNames,
         const DataSetInformation& dataSetInformation, glm::mat4* transformationMatrixPtr) {
-    {
-        std::lock_guard<std::mutex> lock(requestMutex);
-        this->requestedLineData = lineData;
-        this->requestedFileNames = fileNames;
-        this->requestedDataSetInformation = dataSetInformation;
-        if (transformationMatrixPtr) {
-            hasRequestedTransformationMatrix = true;
-            requestedTransformationMatrix = *transformationMatrixPtr;
-        } else {
-            hasRequestedTransformationMatrix = true;
-            requestedTransformationMatrix = sgl::matrixIdentity();
-        }
-        hasRequest = true;
+    glm::mat4 transformationMatrix = sgl::matrixIdentity();
+    if (transformationMatrixPtr) {
+        transformationMatrix = *transformationMatrixPtr;
     }
-    hasRequestConditionVariable.notify_all();
-}
-
-LineDataPtr LineDataRequester::getLoadedData(DataSetInformation& loadedDataSetInformation) {
-    LineDataPtr lineData;
-    {
-        std::lock_guard<std::mutex> lock(replyMutex);
-        if (isDataLoaded) {
-            lineData = this->lineData;
-            loadedDataSetInformation = this->loadedDataSetInformation;
+    requestScheduler.queueJob(
+            [lineData, fileNames, dataSetInformation, transformationMatrix](
+                    LoadedData& reply, JobToken& /*jobToken*/) mutable {
+        // Loading from a file can't be interrupted; the scheduler drops the result if the request became stale.
+        if (!lineData->loadFromFile(fileNames, dataSetInformation, &transformationMatrix)) {
+            return false;
         }
-
-        // Now, new requests can be worked on.
-        this->lineData = LineDataPtr();
-        this->loadedDataSetInformation = DataSetInformation();
-    }
-    hasReplyConditionVariable.notify_all();
-    return lineData;
+        reply.lineData = lineData;
+        reply.dataSetInformation = dataSetInformation;
+        return true;
+    });
 }
 
-void LineDataRequester::mainLoop() {
-#ifdef TRACY_ENABLE
-    tracy::SetThreadName("LineDataRequester");
-#endif
-
-    while (true) {
-        std::unique_lock<std::mutex> requestLock(requestMutex);
-        hasRequestConditionVariable.wait(requestLock, [this] { return hasRequest; });
-
-        if (programIsFinished) {
-            break;
-        }
-
-        if (hasRequest) {
-            LineDataPtr lineData = this->requestedLineData;
-            std::vector<std::string> fileNames = this->requestedFileNames;
-            DataSetInformation dataSetInformation = this->requestedDataSetInformation;
-            glm::mat4 transformationMatrix = sgl::matrixIdentity();
-            glm::mat4* transformationMatrixPtr = nullptr;
-            if (this->hasRequestedTransformationMatrix) {
-                transformationMatrix = this->requestedTransformationMatrix;
-                transformationMatrixPtr = &transformationMatrix;
-            }
-
-            hasRequest = false;
-            this->requestedLineData = LineDataPtr();
-            isProcessingRequest = true;
-            requestLock.unlock();
-
-            bool dataLoaded = lineData->loadFromFile(fileNames, dataSetInformation, transformationMatrixPtr);
-
-            std::lock_guard<std::mutex> replyLock(replyMutex);
-            this->lineData = lineData;
-            this->loadedDataSetInformation = dataSetInformation;
-            isProcessingRequest = false;
-            isDataLoaded = dataLoaded;
-        }
+LineDataPtr LineDataRequester::getLoadedData(DataSetInformation& loadedDataSetInformation) {
+    LoadedData loadedData;
+    if (requestScheduler.getReply(loadedData)) {
+        loadedDataSetInformation = loadedData.dataSetInformation;
     }
+    return loadedData.lineData;
 }
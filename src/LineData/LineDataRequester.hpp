@@ -29,18 +29,17 @@
 #ifndef LINEVIS_LINEDATAREQUESTER_HPP
 #define LINEVIS_LINEDATAREQUESTER_HPP
 
-#include <thread>
-#include <condition_variable>
-
 #include <ImGui/Widgets/TransferFunctionWindow.hpp>
 
 #include <Loaders/DataSetList.hpp>
+#include "Utils/RequestScheduler.hpp"
 #include "LineData.hpp"
 
 /**
  * A multi-threaded data loader for line data.
  * Similar to a mailbox queue of size 1 in the Vulkan API (cmp. VK_PRESENT_MODE_MAILBOX_KHR), it stores the most recent
- * request and reply. Older requests and replies are discarded if they are not handled fast enough.
+ * request and reply. Older requests and replies are discarded if they are not handled fast enough. Data that is still
+ * being loaded when a new request arrives is discarded once loading has finished (@see RequestScheduler).
  */
 class LineDataRequester {
 public:
@@ -67,7 +66,11 @@ public:
     /**
      * @return Whether a request is currently processed (for UI progress spinner).
      */
-    inline bool getIsProcessingRequest() const { return isProcessingRequest; }
+    inline bool getIsProcessingRequest() const { return requestScheduler.getIsProcessingRequest(); }
+    /**
+     * @return The progress of the request currently processed in the range [0, 1], or a negative value if unknown.
+     */
+    inline float getProgress() const { return requestScheduler.getProgress(); }
 
     /**
      * Checks if a request was finished and returns the loaded data.
@@ -77,28 +80,13 @@ public:
     LineDataPtr getLoadedData(DataSetInformation& loadedDataSetInformation);
 
 private:
-    /// The main loop of the requester thread.
-    void mainLoop();
+    struct LoadedData {
+        LineDataPtr lineData;
+        DataSetInformation dataSetInformation;
+    };
 
     sgl::TransferFunctionWindow& transferFunctionWindow;
-    std::thread requesterThread;
-
-    std::mutex requestMutex;
-    std::condition_variable hasRequestConditionVariable;
-    bool programIsFinished = false;
-    bool hasRequest = false;
-    bool isProcessingRequest = false;
-    LineDataPtr requestedLineData;
-    std::vector<std::string> requestedFileNames;
-    DataSetInformation requestedDataSetInformation;
-    bool hasRequestedTransformationMatrix = false;
-    glm::mat4 requestedTransformationMatrix;
-
-    std::mutex replyMutex;
-    std::condition_variable hasReplyConditionVariable;
-    LineDataPtr lineData = nullptr;
-    DataSetInformation loadedDataSetInformation;
-    bool isDataLoaded = false;
+    RequestScheduler<LoadedData> requestScheduler;
 };
 
 
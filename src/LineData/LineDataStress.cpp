@@ -26,6 +26,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <limits>
+#include <memory>
+
 #ifdef USE_EIGEN
 #include <Eigen/Eigenvalues>
 #endif
@@ -53,6 +56,8 @@
 
 #include "Loaders/DegeneratePointsDatLoader.hpp"
 #include "Renderers/LineRenderer.hpp"
+#include "LinePassGenerator.hpp"
+#include "StagingRingUploader.hpp"
 #include "LineDataStress.hpp"
 
 bool LineDataStress::useMajorPS = true;
@@ -519,7 +524,11 @@ void LineDataStress::onMainThreadDataInit(){
 void LineDataStress::setStressTrajectoryData(
         const std::vector<Trajectories>& trajectoriesPs,
         const std::vector<StressTrajectoriesData>& stressTrajectoriesDataPs) {
-    this->trajectoriesPs = trajectoriesPs;
+    this->trajectoriesPs.clear();
+    this->trajectoriesPs.reserve(trajectoriesPs.size());
+    for (const Trajectories& trajectories : trajectoriesPs) {
+        this->trajectoriesPs.emplace_back(trajectories);
+    }
     this->stressTrajectoriesDataPs = stressTrajectoriesDataPs;
     filteredTrajectoriesPs.resize(trajectoriesPs.size());
     for (size_t attrIdx = attributeNames.size(); attrIdx < getNumAttributes(); attrIdx++) {
@@ -540,16 +549,11 @@ void LineDataStress::setStressTrajectoryData(
         float minAttrTotal = std::numeric_limits<float>::max();
         float maxAttrTotal = std::numeric_limits<float>::lowest();
         int i = 0;
-        for (const Trajectories& trajectories : trajectoriesPs) {
+        for (const TrajectoryStore& trajectories : this->trajectoriesPs) {
             size_t psIdx = loadedPsIndices.at(i);
-            float minAttr = std::numeric_limits<float>::max();
-            float maxAttr = std::numeric_limits<float>::lowest();
-            for (const Trajectory& trajectory : trajectories) {
-                for (float val : trajectory.attributes.at(attrIdx)) {
-                    minAttr = std::min(minAttr, val);
-                    maxAttr = std::max(maxAttr, val);
-                }
-            }
+            glm::vec2 minMaxAttr = computeTrajectoriesAttributeMinMax(trajectories, attrIdx);
+            float minAttr = minMaxAttr.x;
+            float maxAttr = minMaxAttr.y;
             minMaxAttributeValuesPs[psIdx].emplace_back(minAttr, maxAttr);
             minAttrTotal = std::min(minAttrTotal, minAttr);
             maxAttrTotal = std::max(maxAttrTotal, maxAttr);
@@ -564,26 +568,8 @@ void LineDataStress::setStressTrajectoryData(
 #endif
 
     numTotalTrajectoryPoints = 0;
-    for (const Trajectories& trajectories : trajectoriesPs) {
-#ifdef USE_TBB
-        numTotalTrajectoryPoints += tbb::parallel_reduce(
-                tbb::blocked_range<size_t>(0, trajectories.size()), size_t(0),
-                [&trajectories](tbb::blocked_range<size_t> const& r, size_t numTotalTrajectoryPoints) {
-                    for (auto i = r.begin(); i != r.end(); i++) {
-                        const Trajectory& trajectory = trajectories.at(i);
-                        numTotalTrajectoryPoints += trajectory.positions.size();
-                    }
-                    return numTotalTrajectoryPoints;
-                }, std::plus<>{});
-#else
-#if _OPENMP >= 201107
-        #pragma omp parallel for reduction(+: numTotalTrajectoryPoints) shared(trajectories) default(none)
-#endif
-        for (size_t i = 0; i < trajectories.size(); i++) {
-            const Trajectory& trajectory = trajectories.at(i);
-            numTotalTrajectoryPoints += trajectory.positions.size();
-        }
-#endif
+    for (const TrajectoryStore& trajectories : this->trajectoriesPs) {
+        numTotalTrajectoryPoints += trajectories.getNumLinePoints();
     }
 
     dirty = true;
@@ -637,41 +623,40 @@ void LineDataStress::setDegeneratePoints(
 
     // Find for all line points the distance to the closest degenerate point.
     size_t psIdx = 0;
-    for (Trajectories& trajectories : trajectoriesPs) {
-        for (Trajectory& trajectory : trajectories) {
-            std::vector<float> distanceMeasuresExponentialKernel;
-            std::vector<float> distanceMeasuresSquaredExponentialKernel;
-            distanceMeasuresExponentialKernel.resize(trajectory.positions.size());
-            distanceMeasuresSquaredExponentialKernel.resize(trajectory.positions.size());
+    for (TrajectoryStore& trajectories : trajectoriesPs) {
+        TrajectorySpan<const glm::vec3> linePoints = trajectories.getPositions();
+        std::vector<float> distanceMeasuresExponentialKernel;
+        std::vector<float> distanceMeasuresSquaredExponentialKernel;
+        distanceMeasuresExponentialKernel.resize(linePoints.size());
+        distanceMeasuresSquaredExponentialKernel.resize(linePoints.size());
 #ifdef USE_TBB
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, trajectory.positions.size()), [&](auto const& r) {
-                for (size_t linePointIdx = r.begin(); linePointIdx != r.end(); linePointIdx++) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, linePoints.size()), [&](auto const& r) {
+            for (size_t linePointIdx = r.begin(); linePointIdx != r.end(); linePointIdx++) {
 #else
 #if _OPENMP >= 201107
-            #pragma omp parallel for shared(trajectory, kdTree, degeneratePoints, \
-            distanceMeasuresExponentialKernel, distanceMeasuresSquaredExponentialKernel) \
-            firstprivate(lengthScale) default(none)
+        #pragma omp parallel for shared(linePoints, kdTree, degeneratePoints, \
+        distanceMeasuresExponentialKernel, distanceMeasuresSquaredExponentialKernel) \
+        firstprivate(lengthScale) default(none)
 #endif
-            for (size_t linePointIdx = 0; linePointIdx < trajectory.positions.size(); linePointIdx++) {
+        for (size_t linePointIdx = 0; linePointIdx < linePoints.size(); linePointIdx++) {
 #endif
-                const glm::vec3& linePoint = trajectory.positions.at(linePointIdx);
+            const glm::vec3& linePoint = linePoints[linePointIdx];
 
-                auto nearestNeighbor = kdTree.findNearestNeighbor(linePoint);
-                float distanceExponentialKernel = exponentialKernel(
-                        linePoint, nearestNeighbor.value().first, lengthScale);
-                float distanceSquaredExponentialKernel = squaredExponentialKernel(
-                        linePoint, nearestNeighbor.value().first, lengthScale);
+            auto nearestNeighbor = kdTree.findNearestNeighbor(linePoint);
+            float distanceExponentialKernel = exponentialKernel(
+                    linePoint, nearestNeighbor.value().first, lengthScale);
+            float distanceSquaredExponentialKernel = squaredExponentialKernel(
+                    linePoint, nearestNeighbor.value().first, lengthScale);
 
-                distanceMeasuresExponentialKernel.at(linePointIdx) = distanceExponentialKernel;
-                distanceMeasuresSquaredExponentialKernel.at(linePointIdx) = distanceSquaredExponentialKernel;
-            }
+            distanceMeasuresExponentialKernel.at(linePointIdx) = distanceExponentialKernel;
+            distanceMeasuresSquaredExponentialKernel.at(linePointIdx) = distanceSquaredExponentialKernel;
+        }
 #ifdef USE_TBB
-            });
+        });
 #endif
 
-            trajectory.attributes.push_back(distanceMeasuresExponentialKernel);
-            trajectory.attributes.push_back(distanceMeasuresSquaredExponentialKernel);
-        }
+        trajectories.addAttribute(std::move(distanceMeasuresExponentialKernel));
+        trajectories.addAttribute(std::move(distanceMeasuresSquaredExponentialKernel));
         minMaxAttributeValuesPs[psIdx].emplace_back(0.0f, 1.0f);
         minMaxAttributeValuesPs[psIdx].emplace_back(0.0f, 1.0f);
         psIdx++;
@@ -703,12 +688,9 @@ void LineDataStress::setUsedPsDirections(const std::vector<bool>& usedPsDirectio
 
 void LineDataStress::recomputeHistogram() {
     std::vector<float> attributeList;
-    for (const Trajectories& trajectories : trajectoriesPs) {
-        for (const Trajectory& trajectory : trajectories) {
-            for (float val : trajectory.attributes.at(selectedAttributeIndex)) {
-                attributeList.push_back(val);
-            }
-        }
+    for (const TrajectoryStore& trajectories : trajectoriesPs) {
+        TrajectorySpan<const float> attributeValues = trajectories.getAttributeValues(selectedAttributeIndex);
+        attributeList.insert(attributeList.end(), attributeValues.begin(), attributeValues.end());
     }
     glm::vec2 minMaxAttributes = minMaxAttributeValues.at(selectedAttributeIndex);
     transferFunctionWindow.computeHistogram(attributeList, minMaxAttributes.x, minMaxAttributes.y);
@@ -721,12 +703,8 @@ void LineDataStress::recomputeHistogram() {
         std::vector<float> attributeValues;
         auto it = std::find(loadedPsIndices.begin(), loadedPsIndices.end(), psIdx);
         if (it != loadedPsIndices.end()) {
-            Trajectories& trajectories = trajectoriesPs.at(std::distance(loadedPsIndices.begin(), it));
-            for (Trajectory& trajectory : trajectories) {
-                for (float& attrVal : trajectory.attributes.at(selectedAttributeIndex)) {
-                    attributeValues.push_back(attrVal);
-                }
-            }
+            const TrajectoryStore& trajectories = trajectoriesPs.at(std::distance(loadedPsIndices.begin(), it));
+            attributeValues = trajectories.getAttributeValues(selectedAttributeIndex).toVector();
         } else {
             attributeValues = {0.0f, 1.0f};
         }
@@ -817,15 +795,15 @@ void LineDataStress::recomputeColorLegend() {
 
 size_t LineDataStress::getNumAttributes() {
     size_t numAttributes = 0;
-    if (!trajectoriesPs.empty() && !trajectoriesPs.front().empty()) {
-        numAttributes = trajectoriesPs.front().front().attributes.size();
+    if (!trajectoriesPs.empty()) {
+        numAttributes = trajectoriesPs.front().getNumAttributes();
     }
     return numAttributes;
 }
 
 size_t LineDataStress::getNumLines() {
     size_t numLines = 0;
-    for (Trajectories& trajectories : trajectoriesPs) {
+    for (const TrajectoryStore& trajectories : trajectoriesPs) {
         numLines += trajectories.size();
     }
     return numLines;
@@ -833,22 +811,16 @@ size_t LineDataStress::getNumLines() {
 
 size_t LineDataStress::getNumLinePoints() {
     size_t numLinePoints = 0;
-    for (Trajectories& trajectories : trajectoriesPs) {
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            numLinePoints += trajectory.positions.size();
-        }
+    for (const TrajectoryStore& trajectories : trajectoriesPs) {
+        numLinePoints += trajectories.getNumLinePoints();
     }
     return numLinePoints;
 }
 
 size_t LineDataStress::getNumLineSegments() {
     size_t numLineSegments = 0;
-    for (Trajectories& trajectories : trajectoriesPs) {
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
-            numLineSegments += trajectory.positions.size() - 1ull;
-        }
+    for (const TrajectoryStore& trajectories : trajectoriesPs) {
+        numLineSegments += trajectories.getNumLinePoints() - trajectories.getNumLines();
     }
     return numLineSegments;
 }
@@ -856,15 +828,11 @@ size_t LineDataStress::getNumLineSegments() {
 size_t LineDataStress::getBaseSizeInBytes() {
     size_t baseSizeInBytes = 0;
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         const StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
+        baseSizeInBytes += trajectories.getSizeInBytes();
         for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            const Trajectory& trajectory = trajectories.at(trajectoryIdx);
             const StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-            baseSizeInBytes += trajectory.positions.size() * sizeof(glm::vec3);
-            for (size_t attributeIdx = 0; attributeIdx < trajectory.attributes.size(); attributeIdx++) {
-                baseSizeInBytes += trajectory.attributes.at(attributeIdx).size() * sizeof(float);
-            }
             baseSizeInBytes += stressTrajectoryData.hierarchyLevels.size() * sizeof(float);
             baseSizeInBytes += sizeof(int); // appearanceOrder
             baseSizeInBytes += sizeof(glm::vec3); // seedPosition
@@ -880,25 +848,25 @@ size_t LineDataStress::getBaseSizeInBytes() {
 }
 
 
-void LineDataStress::iterateOverTrajectories(std::function<void(const Trajectory&)> callback) {
+void LineDataStress::iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback) {
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
-        for (const Trajectory& trajectory : trajectoriesPs.at(i)) {
+        for (const TrajectoryView& trajectory : trajectoriesPs.at(i)) {
             callback(trajectory);
         }
     }
 }
 
-void LineDataStress::iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback) {
+void LineDataStress::iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback) {
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
         int psIdx = loadedPsIndices.at(i);
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         if (!usedPsDirections.at(psIdx)) {
             continue;
         }
 
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
         size_t trajectoryIdx = 0;
-        for (const Trajectory& trajectory : trajectories) {
+        for (const TrajectoryView& trajectory : trajectories) {
             if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
                 trajectoryIdx++;
                 continue;
@@ -909,9 +877,9 @@ void LineDataStress::iterateOverTrajectoriesNotFiltered(std::function<void(const
     }
 }
 
-void LineDataStress::filterTrajectories(std::function<bool(const Trajectory&)> callback) {
+void LineDataStress::filterTrajectories(std::function<bool(const TrajectoryView&)> callback) {
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
 
         for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
@@ -924,7 +892,7 @@ void LineDataStress::filterTrajectories(std::function<bool(const Trajectory&)> c
 
 void LineDataStress::resetTrajectoryFilter()  {
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
 
         if (filteredTrajectories.empty()) {
@@ -944,14 +912,14 @@ Trajectories LineDataStress::filterTrajectoryData() {
 
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
         int psIdx = loadedPsIndices.at(i);
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         if (!usedPsDirections.at(psIdx)) {
             continue;
         }
 
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
         size_t trajectoryIdx = 0;
-        for (const Trajectory &trajectory : trajectories) {
+        for (const TrajectoryView& trajectory : trajectories) {
             if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
                 trajectoryIdx++;
                 continue;
@@ -1001,7 +969,7 @@ std::vector<std::vector<glm::vec3>> LineDataStress::getFilteredLines(LineRendere
     std::vector<std::vector<glm::vec3>> linesFiltered;
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
         int psIdx = loadedPsIndices.at(i);
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         const StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
         if (!usedPsDirections.at(psIdx)) {
             continue;
@@ -1009,7 +977,7 @@ std::vector<std::vector<glm::vec3>> LineDataStress::getFilteredLines(LineRendere
 
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
         size_t trajectoryIdx = 0;
-        for (const Trajectory &trajectory : trajectories) {
+        for (const TrajectoryView& trajectory : trajectories) {
             if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
                 trajectoryIdx++;
                 continue;
@@ -1062,7 +1030,7 @@ std::vector<Trajectories> LineDataStress::filterTrajectoryPsData() {
     trajectoriesPsFiltered.reserve(trajectoriesPs.size());
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
         int psIdx = loadedPsIndices.at(i);
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         if (!usedPsDirections.at(psIdx)) {
             continue;
         }
@@ -1071,7 +1039,7 @@ std::vector<Trajectories> LineDataStress::filterTrajectoryPsData() {
         trajectoriesFiltered.reserve(trajectories.size());
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
         size_t trajectoryIdx = 0;
-        for (const Trajectory &trajectory : trajectories) {
+        for (const TrajectoryView& trajectory : trajectories) {
             if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
                 trajectoryIdx++;
                 continue;
@@ -1121,7 +1089,7 @@ std::vector<std::vector<std::vector<glm::vec3>>> LineDataStress::getFilteredPrin
     linesPsFiltered.reserve(trajectoriesPs.size());
     for (size_t i = 0; i < trajectoriesPs.size(); i++) {
         int psIdx = loadedPsIndices.at(i);
-        const Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         if (!usedPsDirections.at(psIdx)) {
             continue;
         }
@@ -1130,7 +1098,7 @@ std::vector<std::vector<std::vector<glm::vec3>>> LineDataStress::getFilteredPrin
         linesFiltered.reserve(trajectories.size());
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
         size_t trajectoryIdx = 0;
-        for (const Trajectory &trajectory : trajectories) {
+        for (const TrajectoryView& trajectory : trajectories) {
             if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
                 trajectoryIdx++;
                 continue;
@@ -1167,7 +1135,7 @@ std::vector<std::vector<std::vector<glm::vec3>>> LineDataStress::getFilteredPrin
             trajectoryIdx++;
         }
 
-        trajectoriesPs.push_back(trajectories);
+        linesPsFiltered.push_back(linesFiltered);
     }
 
     return linesPsFiltered;
@@ -1357,7 +1325,7 @@ void LineDataStress::computeMaxPrincipalStress() {
             continue;
         }
 
-        Trajectories &trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
 
 #ifdef USE_TBB
@@ -1377,7 +1345,7 @@ void LineDataStress::computeMaxPrincipalStress() {
                 continue;
             }
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
             for (size_t j = 0; j < trajectory.positions.size(); j++) {
                 float majorStress = std::abs(trajectory.attributes.at(majorStressIdx).at(j));
                 float mediumStress = std::abs(trajectory.attributes.at(mediumStressIdx).at(j));
@@ -1396,14 +1364,28 @@ void LineDataStress::computeMaxPrincipalStress() {
 }
 #endif
 
+void LineDataStress::getLinePassLineRanges(
+        std::vector<LinePassLineRanges>& lineRangesPs, uint32_t& numLinePoints, uint32_t& numSegments) {
+    numLinePoints = 0;
+    numSegments = 0;
+    lineRangesPs.clear();
+    lineRangesPs.resize(trajectoriesPs.size());
+    for (size_t i = 0; i < trajectoriesPs.size(); i++) {
+        int psIdx = loadedPsIndices.at(i);
+        if (!usedPsDirections.at(psIdx)) {
+            continue;
+        }
+        LinePassLineRanges& lineRanges = lineRangesPs.at(i);
+        computeLinePassLineRanges(
+                trajectoriesPs.at(i), filteredTrajectoriesPs.at(i), numLinePoints, numSegments, lineRanges);
+        numLinePoints += lineRanges.numLinePoints;
+        numSegments += lineRanges.numSegments;
+    }
+}
+
+template<class LinePointWriter>
 void LineDataStress::getLinePassTubeRenderDataGeneral(
-        const std::function<uint32_t()>& indexOffsetFunctor,
-        const std::function<void(
-                const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel, int lineAppearanceOrder,
-                float majorStress, float mediumStress, float minorStress)>& pointPushFunctor,
-        const std::function<void()>& pointPopFunctor,
-        const std::function<void(int numSegments, uint32_t indexOffset)>& indicesPushFunctor) {
+        const std::vector<LinePassLineRanges>& lineRangesPs, const LinePointWriter& writeLinePoint) {
     std::vector<std::vector<std::vector<glm::vec3>>>* bandPointsListRightPs = nullptr;
     if (getUseBandRendering()) {
         if (useSmoothedBands) {
@@ -1417,12 +1399,14 @@ void LineDataStress::getLinePassTubeRenderDataGeneral(
     int majorStressIdx = -1;
     int mediumStressIdx = -1;
     int minorStressIdx = -1;
+    bool useLineMultiWidth = false;
 
     if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
             && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
         majorStressIdx = getAttributeNameIndex("Major Stress");
         mediumStressIdx = getAttributeNameIndex("Medium Stress");
         minorStressIdx = getAttributeNameIndex("Minor Stress");
+        useLineMultiWidth = true;
     }
 #endif
 
@@ -1432,230 +1416,40 @@ void LineDataStress::getLinePassTubeRenderDataGeneral(
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
-        StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
-
-        std::vector<std::vector<glm::vec3>> lineCentersList;
-        std::vector<std::vector<float>> lineAttributesList;
-
-#ifdef USE_EIGEN
-        std::vector<std::vector<float>> lineMajorStressesList;
-        std::vector<std::vector<float>> lineMediumStressesList;
-        std::vector<std::vector<float>> lineMinorStressesList;
-#endif
-
-        if (getUseBandRendering() && psUseBands.at(psIdx)) {
-            std::vector<std::vector<glm::vec3>> bandRightVectorList;
-            std::vector<std::vector<glm::vec3>>& bandPointsListRight = bandPointsListRightPs->at(i);
-
-#ifdef USE_EIGEN
-            lineMajorStressesList.resize(trajectories.size());
-            lineMediumStressesList.resize(trajectories.size());
-            lineMinorStressesList.resize(trajectories.size());
-#endif
-
-            lineCentersList.resize(trajectories.size());
-            lineAttributesList.resize(trajectories.size());
-            bandRightVectorList.resize(trajectories.size());
-            std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
-            for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-                if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                    continue;
-                }
-
-                Trajectory& trajectory = trajectories.at(trajectoryIdx);
-                //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-                std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-                std::vector<glm::vec3>& bandPointsRight = bandPointsListRight.at(trajectoryIdx);
-                assert(attributes.size() == trajectory.positions.size());
-                std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
-                std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
-                std::vector<glm::vec3>& bandRightVectors = bandRightVectorList.at(trajectoryIdx);
-
-#ifdef USE_EIGEN
-                std::vector<float>& lineMajorStresses = lineMajorStressesList.at(trajectoryIdx);
-                std::vector<float>& lineMediumStresses = lineMediumStressesList.at(trajectoryIdx);
-                std::vector<float>& lineMinorStresses = lineMinorStressesList.at(trajectoryIdx);
-#endif
-
-                for (size_t j = 0; j < trajectory.positions.size(); j++) {
-                    lineCenters.push_back(trajectory.positions.at(j));
-                    lineAttributes.push_back(attributes.at(j));
-                    bandRightVectors.push_back(bandPointsRight.at(j));
-
-#ifdef USE_EIGEN
-                    if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                            && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                        lineMajorStresses.push_back(
-                                trajectory.attributes.at(majorStressIdx).at(j) / maxPrincipalStressMagnitude);
-                        lineMediumStresses.push_back(
-                                trajectory.attributes.at(mediumStressIdx).at(j) / maxPrincipalStressMagnitude);
-                        lineMinorStresses.push_back(
-                                trajectory.attributes.at(minorStressIdx).at(j) / maxPrincipalStressMagnitude);
-                    }
-#endif
-                }
-            }
-
-            for (size_t lineId = 0; lineId < lineCentersList.size(); lineId++) {
-                const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
-                const std::vector<float>& lineAttributes = lineAttributesList.at(lineId);
-                const std::vector<glm::vec3>& bandRightVectors = bandRightVectorList.at(lineId);
-                StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(lineId);
-                assert(lineCenters.size() == lineAttributes.size());
-                size_t n = lineCenters.size();
-                uint32_t indexOffset = indexOffsetFunctor();
-
-                if (n < 2) {
-                    continue;
-                }
-
-                glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
-                int numValidLinePoints = 0;
-                for (size_t i = 0; i < n; i++) {
-                    glm::vec3 tangent, normal;
-                    if (i == 0) {
-                        tangent = lineCenters[i+1] - lineCenters[i];
-                    } else if (i == n - 1) {
-                        tangent = lineCenters[i] - lineCenters[i-1];
-                    } else {
-                        tangent = (lineCenters[i+1] - lineCenters[i-1]);
-                    }
-                    float lineSegmentLength = glm::length(tangent);
-
-                    if (lineSegmentLength < 0.0001f) {
-                        // In case the two vertices are almost identical, just skip this path line segment
-                        continue;
-                    }
-                    tangent = glm::normalize(tangent);
-
-                    normal = glm::cross(bandRightVectors.at(i), tangent);
-
-
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
+        const StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
+        bool useBands = getUseBandRendering() && psUseBands.at(psIdx);
+        const std::vector<std::vector<glm::vec3>>* bandRightVectorsList = nullptr;
+        if (useBands) {
+            bandRightVectorsList = &bandPointsListRightPs->at(i);
+        }
+
+        generateLinePassLinePoints(
+                trajectories, lineRangesPs.at(i), bandRightVectorsList,
+                [&](size_t lineIdx, size_t pointIdx, uint32_t linePointIdx, const LinePassLineRange& lineRange,
+                        const glm::vec3& normal, const glm::vec3& tangent) {
+                    TrajectoryView trajectory = trajectories[lineIdx];
+                    const StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(lineIdx);
                     float lineHierarchyLevel = 0.0f;
                     float majorStress = 1.0f, mediumStress = 1.0f, minorStress = 1.0f;
                     if (hasLineHierarchy) {
                         lineHierarchyLevel = stressTrajectoryData.hierarchyLevels.at(int(lineHierarchyType));
                     }
 #ifdef USE_EIGEN
-                    if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                            && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                        majorStress = lineMajorStressesList.at(lineId).at(i);
-                        mediumStress = lineMediumStressesList.at(lineId).at(i);
-                        minorStress = lineMinorStressesList.at(lineId).at(i);
+                    // The principal stresses are only used together with bands.
+                    if (useBands && useLineMultiWidth) {
+                        majorStress = trajectory.attributes.at(majorStressIdx)[pointIdx] / maxPrincipalStressMagnitude;
+                        mediumStress =
+                                trajectory.attributes.at(mediumStressIdx)[pointIdx] / maxPrincipalStressMagnitude;
+                        minorStress = trajectory.attributes.at(minorStressIdx)[pointIdx] / maxPrincipalStressMagnitude;
                     }
 #endif
-                    pointPushFunctor(
-                            lineCenters.at(i), normal, tangent, lineAttributes.at(i),
-                            indexOffset,
+                    writeLinePoint(
+                            linePointIdx, trajectory.positions[pointIdx], normal, tangent,
+                            trajectory.attributes[selectedAttributeIndex][pointIdx], lineRange.linePointOffset,
                             psIdx, lineHierarchyLevel, stressTrajectoryData.appearanceOrder,
                             majorStress, mediumStress, minorStress);
-                    numValidLinePoints++;
-                }
-
-                if (numValidLinePoints == 1) {
-                    // Only one vertex left -> Output nothing (tube consisting only of one point).
-                    pointPopFunctor();
-                }
-                if (numValidLinePoints <= 1) {
-                    continue;
-                }
-
-                // Create indices.
-                int numSegments = numValidLinePoints - 1;
-                indicesPushFunctor(numSegments, indexOffset);
-            }
-        } else {
-            // Compute all tangents.
-            lineCentersList.resize(trajectories.size());
-            lineAttributesList.resize(trajectories.size());
-            std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
-            for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-                if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                    continue;
-                }
-
-                Trajectory& trajectory = trajectories.at(trajectoryIdx);
-                //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-                std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-                assert(attributes.size() == trajectory.positions.size());
-                std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
-                std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
-                for (size_t i = 0; i < trajectory.positions.size(); i++) {
-                    lineCenters.push_back(trajectory.positions.at(i));
-                    lineAttributes.push_back(attributes.at(i));
-                }
-            }
-
-            for (size_t lineId = 0; lineId < lineCentersList.size(); lineId++) {
-                const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
-                const std::vector<float>& lineAttributes = lineAttributesList.at(lineId);
-                StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(lineId);
-                assert(lineCenters.size() == lineAttributes.size());
-                size_t n = lineCenters.size();
-                uint32_t indexOffset = indexOffsetFunctor();
-
-                if (n < 2) {
-                    continue;
-                }
-
-                glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
-                int numValidLinePoints = 0;
-                for (size_t i = 0; i < n; i++) {
-                    glm::vec3 tangent, normal;
-                    if (i == 0) {
-                        tangent = lineCenters[i+1] - lineCenters[i];
-                    } else if (i == n - 1) {
-                        tangent = lineCenters[i] - lineCenters[i-1];
-                    } else {
-                        tangent = (lineCenters[i+1] - lineCenters[i-1]);
-                    }
-                    float lineSegmentLength = glm::length(tangent);
-
-                    if (lineSegmentLength < 0.0001f) {
-                        // In case the two vertices are almost identical, just skip this path line segment
-                        continue;
-                    }
-                    tangent = glm::normalize(tangent);
-
-                    glm::vec3 helperAxis = lastLineNormal;
-                    if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
-                        // If tangent == lastNormal
-                        helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-                        if (glm::length(glm::cross(helperAxis, normal)) < 0.01f) {
-                            // If tangent == helperAxis
-                            helperAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-                        }
-                    }
-                    normal = glm::normalize(helperAxis - tangent * glm::dot(helperAxis, tangent)); // Gram-Schmidt
-                    lastLineNormal = normal;
-
-                    float lineHierarchyLevel = 0.0f;
-                    float majorStress = 1.0f, mediumStress = 1.0f, minorStress = 1.0f;
-                    if (hasLineHierarchy) {
-                        lineHierarchyLevel = stressTrajectoryData.hierarchyLevels.at(int(lineHierarchyType));
-                    }
-                    pointPushFunctor(
-                            lineCenters.at(i), normal, tangent, lineAttributes.at(i),
-                            indexOffset,
-                            psIdx, lineHierarchyLevel, stressTrajectoryData.appearanceOrder,
-                            majorStress, mediumStress, minorStress);
-                    numValidLinePoints++;
-                }
-
-                if (numValidLinePoints == 1) {
-                    // Only one vertex left -> Output nothing (tube consisting only of one point).
-                    pointPopFunctor();
-                }
-                if (numValidLinePoints <= 1) {
-                    continue;
-                }
-
-                // Create indices.
-                int numSegments = numValidLinePoints - 1;
-                indicesPushFunctor(numSegments, indexOffset);
-            }
-        }
+                });
     }
 }
 
@@ -1664,7 +1458,9 @@ LinePassTubeRenderData LineDataStress::getLinePassTubeRenderData() {
     if (cachedRenderDataGeometryShader.indexBuffer) {
         return cachedRenderDataGeometryShader;
     }
-    removeOtherCachedDataTypes(RequestMode::GEOMETRY_SHADER);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::GEOMETRY_SHADER))) {
+        return cachedRenderDataGeometryShader;
+    }
 
     std::vector<uint32_t> lineIndices;
     std::vector<glm::vec3> vertexPositions;
@@ -1681,55 +1477,63 @@ LinePassTubeRenderData LineDataStress::getLinePassTubeRenderData() {
     std::vector<float> vertexMinorStresses;
 #endif
 
+    std::vector<LinePassLineRanges> lineRangesPs;
+    uint32_t numLinePoints = 0, numSegments = 0;
+    getLinePassLineRanges(lineRangesPs, numLinePoints, numSegments);
+    vertexPositions.resize(numLinePoints);
+    vertexNormals.resize(numLinePoints);
+    vertexTangents.resize(numLinePoints);
+    vertexAttributes.resize(numLinePoints);
+    vertexPrincipalStressIndices.resize(numLinePoints);
+    if (hasLineHierarchy) {
+        vertexLineHierarchyLevels.resize(numLinePoints);
+    }
+    vertexLineAppearanceOrders.resize(numLinePoints);
+    lineIndices.resize(size_t(numSegments) * 2);
+#ifdef USE_EIGEN
+    bool useLineMultiWidth =
+            getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
+            && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS;
+    if (useLineMultiWidth) {
+        vertexMajorStresses.resize(numLinePoints);
+        vertexMediumStresses.resize(numLinePoints);
+        vertexMinorStresses.resize(numLinePoints);
+    }
+#endif
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(vertexPositions.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                    uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel, int lineAppearanceOrder,
-                    float majorStress, float mediumStress, float minorStress) {
-                vertexPositions.push_back(lineCenter);
-                vertexNormals.push_back(normal);
-                vertexTangents.push_back(tangent);
-                vertexAttributes.push_back(lineAttribute);
-                vertexPrincipalStressIndices.push_back(uint32_t(principalStressIndex));
+            lineRangesPs,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+                    float lineAttribute, uint32_t /*indexOffset*/, int principalStressIndex, float lineHierarchyLevel,
+                    int lineAppearanceOrder, float majorStress, float mediumStress, float minorStress) {
+                vertexPositions[linePointIdx] = lineCenter;
+                vertexNormals[linePointIdx] = normal;
+                vertexTangents[linePointIdx] = tangent;
+                vertexAttributes[linePointIdx] = lineAttribute;
+                vertexPrincipalStressIndices[linePointIdx] = uint32_t(principalStressIndex);
                 if (hasLineHierarchy) {
-                    vertexLineHierarchyLevels.push_back(lineHierarchyLevel);
+                    vertexLineHierarchyLevels[linePointIdx] = lineHierarchyLevel;
                 }
-                vertexLineAppearanceOrders.push_back(lineAppearanceOrder);
+                vertexLineAppearanceOrders[linePointIdx] = uint32_t(lineAppearanceOrder);
 #ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    vertexMajorStresses.push_back(majorStress);
-                    vertexMediumStresses.push_back(mediumStress);
-                    vertexMinorStresses.push_back(minorStress);
+                if (useLineMultiWidth) {
+                    vertexMajorStresses[linePointIdx] = majorStress;
+                    vertexMediumStresses[linePointIdx] = mediumStress;
+                    vertexMinorStresses[linePointIdx] = minorStress;
                 }
 #endif
-            },
-            [&] {
-                vertexPositions.pop_back();
-                vertexNormals.pop_back();
-                vertexTangents.pop_back();
-                vertexAttributes.pop_back();
-                vertexPrincipalStressIndices.pop_back();
-                vertexLineHierarchyLevels.pop_back();
-                vertexLineAppearanceOrders.pop_back();
-#ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    vertexMajorStresses.pop_back();
-                    vertexMediumStresses.pop_back();
-                    vertexMinorStresses.pop_back();
-                }
-#endif
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                for (int j = 0; j < numSegments; j++) {
-                    lineIndices.push_back(indexOffset + j);
-                    lineIndices.push_back(indexOffset + j + 1);
-                }
+            });
+    for (const LinePassLineRanges& lineRanges : lineRangesPs) {
+        forEachLinePassLine(lineRanges, [&](size_t /*lineIdx*/, const LinePassLineRange& lineRange) {
+            uint32_t* indices = lineIndices.data() + size_t(lineRange.segmentOffset) * 2;
+            uint32_t indexOffset = lineRange.linePointOffset;
+            int numLineSegments = int(lineRange.numLinePoints) - 1;
+            for (int j = 0; j < numLineSegments; j++) {
+                *(indices++) = indexOffset + j;
+                *(indices++) = indexOffset + j + 1;
             }
-    );
+        });
+    }
 
     if (lineIndices.empty()) {
         return {};
@@ -1829,7 +1633,7 @@ LinePassQuadsRenderDataProgrammablePull LineDataStress::getLinePassQuadsRenderDa
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
 
         // 1. Compute all tangents.
@@ -1844,9 +1648,9 @@ LinePassQuadsRenderDataProgrammablePull LineDataStress::getLinePassQuadsRenderDa
                 continue;
             }
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
             //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+            TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
             assert(attributes.size() == trajectory.positions.size());
             std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
             std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -1949,7 +1753,7 @@ TubeRenderDataOpacityOptimization LineDataStress::getTubeRenderDataOpacityOptimi
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
 
         // 1. Compute all tangents.
@@ -1964,9 +1768,9 @@ TubeRenderDataOpacityOptimization LineDataStress::getTubeRenderDataOpacityOptimi
                 continue;
             }
 
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
             //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+            TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
             assert(attributes.size() == trajectory.positions.size());
             std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
             std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -2066,7 +1870,9 @@ LinePassTubeRenderDataMeshShader LineDataStress::getLinePassTubeRenderDataMeshSh
     if (cachedRenderDataMeshShader.meshletDataBuffer) {
         return cachedRenderDataMeshShader;
     }
-    removeOtherCachedDataTypes(RequestMode::MESH_SHADER);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::MESH_SHADER))) {
+        return cachedRenderDataMeshShader;
+    }
 
     // We can emit a maximum of 64 vertices/primitives from the mesh shader.
     int numLineSegmentsPerMeshlet = 64 / tubeNumSubdivisions - 1;
@@ -2078,60 +1884,67 @@ LinePassTubeRenderDataMeshShader LineDataStress::getLinePassTubeRenderDataMeshSh
     std::vector<StressLinePointPrincipalStressDataUnified> stressLinePointsPrincipalStress;
 #endif
 
+    std::vector<LinePassLineRanges> lineRangesPs;
+    uint32_t numLinePoints = 0, numSegments = 0;
+    getLinePassLineRanges(lineRangesPs, numLinePoints, numSegments);
+    linePoints.resize(numLinePoints);
+    stressLinePoints.resize(numLinePoints);
+#ifdef USE_EIGEN
+    bool useLineMultiWidth =
+            getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
+            && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS;
+    if (useLineMultiWidth) {
+        stressLinePointsPrincipalStress.resize(numLinePoints);
+    }
+#endif
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(linePoints.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                    uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel, int lineAppearanceOrder,
-                    float majorStress, float mediumStress, float minorStress) {
-                LinePointDataUnified linePointData;
+            lineRangesPs,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+                    float lineAttribute, uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel,
+                    int lineAppearanceOrder, float majorStress, float mediumStress, float minorStress) {
+                LinePointDataUnified& linePointData = linePoints[linePointIdx];
                 linePointData.linePosition = lineCenter;
                 linePointData.lineNormal = normal;
                 linePointData.lineTangent = tangent;
                 linePointData.lineAttribute = lineAttribute;
                 linePointData.lineStartIndex = indexOffset;
-                linePoints.push_back(linePointData);
 
-                StressLinePointDataUnified stressLinePointData;
+                StressLinePointDataUnified& stressLinePointData = stressLinePoints[linePointIdx];
                 stressLinePointData.linePrincipalStressIndex = uint32_t(principalStressIndex);
                 stressLinePointData.lineLineAppearanceOrder = lineAppearanceOrder;
                 stressLinePointData.lineLineHierarchyLevel = lineHierarchyLevel;
-                stressLinePoints.push_back(stressLinePointData);
 
 #ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    StressLinePointPrincipalStressDataUnified stressLinePointPrincipalStressData;
+                if (useLineMultiWidth) {
+                    StressLinePointPrincipalStressDataUnified& stressLinePointPrincipalStressData =
+                            stressLinePointsPrincipalStress[linePointIdx];
                     stressLinePointPrincipalStressData.lineMajorStress = majorStress;
                     stressLinePointPrincipalStressData.lineMediumStress = mediumStress;
                     stressLinePointPrincipalStressData.lineMinorStress = minorStress;
-                    stressLinePointsPrincipalStress.push_back(stressLinePointPrincipalStressData);
                 }
 #endif
-            },
-            [&] {
-                linePoints.pop_back();
-                stressLinePoints.pop_back();
-#ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    stressLinePointsPrincipalStress.pop_back();
-                }
-#endif
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                int numSegmentsLeft = numSegments;
-                int numMeshlets = sgl::iceil(numSegments, numLineSegmentsPerMeshlet);
-                for (int j = 0; j < numMeshlets; j++) {
-                    meshlet.linePointIndexStart = indexOffset + j * numLineSegmentsPerMeshlet;
-                    meshlet.numLinePoints =
-                            (numSegmentsLeft > numLineSegmentsPerMeshlet ? numLineSegmentsPerMeshlet : numSegmentsLeft) + 1;
-                    meshlets.push_back(meshlet);
-                    numSegmentsLeft -= numLineSegmentsPerMeshlet;
-                }
+            });
+
+    // The number of meshlets per line is cheap to compute, so they are created sequentially.
+    for (const LinePassLineRanges& lineRanges : lineRangesPs) {
+        for (const LinePassLineRange& lineRange : lineRanges.lines) {
+            if (lineRange.numLinePoints == 0) {
+                continue;
+            }
+            uint32_t indexOffset = lineRange.linePointOffset;
+            int numLineSegments = int(lineRange.numLinePoints) - 1;
+            int numSegmentsLeft = numLineSegments;
+            int numMeshlets = sgl::iceil(numLineSegments, numLineSegmentsPerMeshlet);
+            for (int j = 0; j < numMeshlets; j++) {
+                meshlet.linePointIndexStart = indexOffset + j * numLineSegmentsPerMeshlet;
+                meshlet.numLinePoints =
+                        (numSegmentsLeft > numLineSegmentsPerMeshlet ? numLineSegmentsPerMeshlet : numSegmentsLeft) + 1;
+                meshlets.push_back(meshlet);
+                numSegmentsLeft -= numLineSegmentsPerMeshlet;
             }
-    );
+        }
+    }
 
     if (meshlets.empty()) {
         return {};
@@ -2171,7 +1984,6 @@ LinePassTubeRenderDataMeshShader LineDataStress::getLinePassTubeRenderDataMeshSh
 #endif
 
     cachedRenderDataMeshShader = renderData;
-    cachedTubeNumSubdivisions = tubeNumSubdivisions;
     return renderData;
 }
 
@@ -2180,7 +1992,9 @@ LinePassTubeRenderDataProgrammablePull LineDataStress::getLinePassTubeRenderData
     if (cachedRenderDataProgrammablePull.indexBuffer) {
         return cachedRenderDataProgrammablePull;
     }
-    removeOtherCachedDataTypes(RequestMode::PROGRAMMABLE_PULL);
+    if (activateCachedDataType(getRenderDataCacheKey(RequestMode::PROGRAMMABLE_PULL))) {
+        return cachedRenderDataProgrammablePull;
+    }
 
     std::vector<uint32_t> triangleIndices;
     std::vector<LinePointDataUnified> linePoints;
@@ -2189,66 +2003,71 @@ LinePassTubeRenderDataProgrammablePull LineDataStress::getLinePassTubeRenderData
     std::vector<StressLinePointPrincipalStressDataUnified> stressLinePointsPrincipalStress;
 #endif
 
+    std::vector<LinePassLineRanges> lineRangesPs;
+    uint32_t numLinePoints = 0, numSegments = 0;
+    getLinePassLineRanges(lineRangesPs, numLinePoints, numSegments);
+    linePoints.resize(numLinePoints);
+    stressLinePoints.resize(numLinePoints);
+#ifdef USE_EIGEN
+    bool useLineMultiWidth =
+            getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
+            && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS;
+    if (useLineMultiWidth) {
+        stressLinePointsPrincipalStress.resize(numLinePoints);
+    }
+#endif
+    triangleIndices.resize(size_t(numSegments) * size_t(tubeNumSubdivisions) * 6);
+
     getLinePassTubeRenderDataGeneral(
-            [&]() {
-                return uint32_t(linePoints.size());
-            },
-            [&](const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                    uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel, int lineAppearanceOrder,
-                    float majorStress, float mediumStress, float minorStress) {
-                LinePointDataUnified linePointData;
+            lineRangesPs,
+            [&](uint32_t linePointIdx, const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent,
+                    float lineAttribute, uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel,
+                    int lineAppearanceOrder, float majorStress, float mediumStress, float minorStress) {
+                LinePointDataUnified& linePointData = linePoints[linePointIdx];
                 linePointData.linePosition = lineCenter;
                 linePointData.lineNormal = normal;
                 linePointData.lineTangent = tangent;
                 linePointData.lineAttribute = lineAttribute;
                 linePointData.lineStartIndex = indexOffset;
-                linePoints.push_back(linePointData);
 
-                StressLinePointDataUnified stressLinePointData;
+                StressLinePointDataUnified& stressLinePointData = stressLinePoints[linePointIdx];
                 stressLinePointData.linePrincipalStressIndex = uint32_t(principalStressIndex);
                 stressLinePointData.lineLineAppearanceOrder = lineAppearanceOrder;
                 stressLinePointData.lineLineHierarchyLevel = lineHierarchyLevel;
-                stressLinePoints.push_back(stressLinePointData);
 
 #ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    StressLinePointPrincipalStressDataUnified stressLinePointPrincipalStressData;
+                if (useLineMultiWidth) {
+                    StressLinePointPrincipalStressDataUnified& stressLinePointPrincipalStressData =
+                            stressLinePointsPrincipalStress[linePointIdx];
                     stressLinePointPrincipalStressData.lineMajorStress = majorStress;
                     stressLinePointPrincipalStressData.lineMediumStress = mediumStress;
                     stressLinePointPrincipalStressData.lineMinorStress = minorStress;
-                    stressLinePointsPrincipalStress.push_back(stressLinePointPrincipalStressData);
                 }
 #endif
-            },
-            [&] {
-                linePoints.pop_back();
-                stressLinePoints.pop_back();
-#ifdef USE_EIGEN
-                if (getLinePrimitiveModeSupportsLineMultiWidth(linePrimitiveMode)
-                        && bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                    stressLinePointsPrincipalStress.pop_back();
-                }
-#endif
-            },
-            [&](int numSegments, uint32_t indexOffset) {
-                for (int j = 0; j < numSegments; j++) {
-                    uint32_t indexOffsetCurrent = (indexOffset + j) * tubeNumSubdivisions;
-                    uint32_t indexOffsetNext = (indexOffset + j + 1) * tubeNumSubdivisions;
-                    for (int k = 0; k < tubeNumSubdivisions; k++) {
-                        int kNext = (k + 1) % tubeNumSubdivisions;
-
-                        triangleIndices.push_back(indexOffsetCurrent + k);
-                        triangleIndices.push_back(indexOffsetCurrent + kNext);
-                        triangleIndices.push_back(indexOffsetNext + k);
-
-                        triangleIndices.push_back(indexOffsetNext + k);
-                        triangleIndices.push_back(indexOffsetCurrent + kNext);
-                        triangleIndices.push_back(indexOffsetNext + kNext);
-                    }
+            });
+    for (const LinePassLineRanges& lineRanges : lineRangesPs) {
+        forEachLinePassLine(lineRanges, [&](size_t /*lineIdx*/, const LinePassLineRange& lineRange) {
+            uint32_t* indices =
+                    triangleIndices.data() + size_t(lineRange.segmentOffset) * size_t(tubeNumSubdivisions) * 6;
+            uint32_t indexOffset = lineRange.linePointOffset;
+            int numLineSegments = int(lineRange.numLinePoints) - 1;
+            for (int j = 0; j < numLineSegments; j++) {
+                uint32_t indexOffsetCurrent = (indexOffset + j) * tubeNumSubdivisions;
+                uint32_t indexOffsetNext = (indexOffset + j + 1) * tubeNumSubdivisions;
+                for (int k = 0; k < tubeNumSubdivisions; k++) {
+                    int kNext = (k + 1) % tubeNumSubdivisions;
+
+                    *(indices++) = indexOffsetCurrent + k;
+                    *(indices++) = indexOffsetCurrent + kNext;
+                    *(indices++) = indexOffsetNext + k;
+
+                    *(indices++) = indexOffsetNext + k;
+                    *(indices++) = indexOffsetCurrent + kNext;
+                    *(indices++) = indexOffsetNext + kNext;
                 }
             }
-    );
+        });
+    }
 
     if (triangleIndices.empty()) {
         return {};
@@ -2287,7 +2106,6 @@ LinePassTubeRenderDataProgrammablePull LineDataStress::getLinePassTubeRenderData
 #endif
 
     cachedRenderDataProgrammablePull = renderData;
-    cachedTubeNumSubdivisions = tubeNumSubdivisions;
     return renderData;
 }
 
@@ -2313,7 +2131,7 @@ LinePassQuadsRenderData LineDataStress::getLinePassQuadsRenderData() {
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
 
         if (psUseBands.at(psIdx)) {
@@ -2335,9 +2153,9 @@ LinePassQuadsRenderData LineDataStress::getLinePassQuadsRenderData() {
                     continue;
                 }
 
-                Trajectory& trajectory = trajectories.at(trajectoryIdx);
+                TrajectoryView trajectory = trajectories.at(trajectoryIdx);
                 StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-                std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+                TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
                 std::vector<glm::vec3>& bandPointsLeft = bandPointsListLeft.at(trajectoryIdx);
                 std::vector<glm::vec3>& bandPointsRight = bandPointsListRight.at(trajectoryIdx);
                 assert(attributes.size() == trajectory.positions.size());
@@ -2412,9 +2230,9 @@ LinePassQuadsRenderData LineDataStress::getLinePassQuadsRenderData() {
                     continue;
                 }
 
-                Trajectory& trajectory = trajectories.at(trajectoryIdx);
+                TrajectoryView trajectory = trajectories.at(trajectoryIdx);
                 //StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
-                std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+                TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
                 assert(attributes.size() == trajectory.positions.size());
                 std::vector<glm::vec3>& lineCenters = lineCentersList.at(trajectoryIdx);
                 std::vector<float>& lineAttributes = lineAttributesList.at(trajectoryIdx);
@@ -2541,9 +2359,27 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
         }
         return cachedTubeTriangleRenderData;
     }
-    removeOtherCachedDataTypes(RequestMode::TRIANGLES);
+    RenderDataCacheKey renderDataKey = getRenderDataCacheKey(RequestMode::TRIANGLES);
+    renderDataKey.vulkanRayTracing = vulkanRayTracing;
+    renderDataKey.payload = payload;
+    if (activateCachedDataType(renderDataKey)) {
+        if (cachedTubeTriangleRenderDataPayload) {
+            payload = cachedTubeTriangleRenderDataPayload;
+        }
+        return cachedTubeTriangleRenderData;
+    }
     cachedTubeTriangleRenderDataPayload = payload;
 
+    // Principal stress tubes are only supported by the monolithic path.
+    if (getCanStreamTubeTriangleMesh(payload)
+#ifdef USE_EIGEN
+            && bandRenderMode == LineDataStress::BandRenderMode::RIBBONS
+#endif
+            ) {
+        createTubeTriangleRenderDataStreaming(isRasterizer, vulkanRayTracing);
+        return cachedTubeTriangleRenderData;
+    }
+
     std::vector<uint32_t> tubeTriangleIndices;
     std::vector<TubeTriangleVertexData> tubeTriangleVertexDataList;
     std::vector<LinePointDataUnified> tubeTriangleLinePointDataList;
@@ -2570,40 +2406,15 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
-        StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
-
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         std::vector<std::vector<glm::vec3>> lineCentersList;
-        lineCentersList.resize(trajectories.size());
-        std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
-        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                continue;
-            }
-            if (!isRasterizer && lineHierarchySliderValues[psIdx]
-                    < 1.0 - stressTrajectoriesData.at(trajectoryIdx).hierarchyLevels.at(int(lineHierarchyType))) {
-                continue;
-            }
-            lineCentersList.at(trajectoryIdx) = trajectories.at(trajectoryIdx).positions;
-        }
+        std::vector<std::vector<glm::vec3>> bandPointsListRight;
+        getTubeTriangleMeshLines(i, isRasterizer, lineCentersList, bandPointsListRight);
 
         std::vector<LinePointReference> linePointReferences;
         std::vector<glm::vec3> lineTangents;
         std::vector<glm::vec3> lineNormals;
         if (getUseBandRendering() && psUseBands.at(psIdx)) {
-            std::vector<std::vector<glm::vec3>> bandPointsListRight;
-            bandPointsListRight.resize(trajectories.size());
-            for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
-                if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
-                    continue;
-                }
-                if (useSmoothedBands) {
-                    bandPointsListRight.at(trajectoryIdx) = bandPointsSmoothedListRightPs.at(i).at(trajectoryIdx);
-                } else {
-                    bandPointsListRight.at(trajectoryIdx) = bandPointsUnsmoothedListRightPs.at(i).at(trajectoryIdx);
-                }
-            }
-
             std::vector<uint32_t> linePrincipalStressIndexList;
             linePrincipalStressIndexList.resize(trajectories.size(), uint32_t(psIdx));
 
@@ -2612,6 +2423,7 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
             std::vector<std::vector<float>> lineMediumStressesList;
             std::vector<std::vector<float>> lineMinorStressesList;
             if (bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
+                const std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
                 lineMajorStressesList.resize(trajectories.size());
                 lineMediumStressesList.resize(trajectories.size());
                 lineMinorStressesList.resize(trajectories.size());
@@ -2645,13 +2457,13 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
                 float binormalRadius = LineRenderer::getBandWidth() * 0.5f;
                 float normalRadius = binormalRadius * minBandThickness;
                 if (useCappedTubes) {
-                    createCappedTriangleEllipticTubesRenderDataCPU(
+                    createCappedTriangleEllipticTubesRenderDataCPUParallel(
                             lineCentersList, bandPointsListRight, normalRadius,
                             binormalRadius, tubeNumSubdivisions,
                             false, tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                             uint32_t(tubeTriangleLinePointDataList.size()), lineTangents, lineNormals);
                 } else {
-                    createTriangleEllipticTubesRenderDataCPU(
+                    createTriangleEllipticTubesRenderDataCPUParallel(
                             lineCentersList, bandPointsListRight, normalRadius,
                             binormalRadius, tubeNumSubdivisions,
                             tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -2682,13 +2494,13 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
 #endif
         } else {
             if (useCappedTubes) {
-                createCappedTriangleTubesRenderDataCPU(
+                createCappedTriangleTubesRenderDataCPUParallel(
                         lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                         tubeNumSubdivisions, false,
                         tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
                         uint32_t(tubeTriangleLinePointDataList.size()), lineTangents, lineNormals);
             } else {
-                createTriangleTubesRenderDataCPU(
+                createTriangleTubesRenderDataCPUParallel(
                         lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                         tubeNumSubdivisions,
                         tubeTriangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -2704,46 +2516,15 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
             tubeTriangleStressLinePointPrincipalStressDataList.resize(offset + linePointReferences.size());
         }
 #endif
-        uint32_t lineStartIndex = 0;
-        uint32_t lastTrajectoryIndex = 0;
-        for (size_t ptIdx = 0; ptIdx < linePointReferences.size(); ptIdx++) {
-            LinePointReference& linePointReference = linePointReferences.at(ptIdx);
-            LinePointDataUnified& tubeTriangleLinePointData = tubeTriangleLinePointDataList.at(offset + ptIdx);
-            StressLinePointDataUnified& tubeTriangleStressLinePointData =
-                    tubeTriangleStressLinePointDataList.at(offset + ptIdx);
-            Trajectory& trajectory = trajectories.at(linePointReference.trajectoryIndex);
-            StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(linePointReference.trajectoryIndex);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
-
-            tubeTriangleLinePointData.linePosition = trajectory.positions.at(linePointReference.linePointIndex);
-            tubeTriangleLinePointData.lineAttribute = attributes.at(linePointReference.linePointIndex);
-            tubeTriangleLinePointData.lineTangent = lineTangents.at(ptIdx);
-            tubeTriangleLinePointData.lineNormal = lineNormals.at(ptIdx);
-
-            if (lastTrajectoryIndex != linePointReference.trajectoryIndex) {
-                lastTrajectoryIndex = linePointReference.trajectoryIndex;
-                lineStartIndex = uint32_t(i);
-            }
-            tubeTriangleLinePointData.lineStartIndex = lineStartIndex;
-
-            tubeTriangleStressLinePointData.linePrincipalStressIndex = uint32_t(psIdx);
-            tubeTriangleStressLinePointData.lineLineHierarchyLevel =
-                    stressTrajectoryData.hierarchyLevels.at(int(lineHierarchyType));
-            tubeTriangleStressLinePointData.lineLineAppearanceOrder = uint32_t(stressTrajectoryData.appearanceOrder);
-
+        fillTubeTriangleLinePointData(
+                i, linePointReferences, lineTangents, lineNormals, offset,
+                tubeTriangleLinePointDataList.data() + offset, tubeTriangleStressLinePointDataList.data() + offset,
 #ifdef USE_EIGEN
-            if (bandRenderMode != LineDataStress::BandRenderMode::RIBBONS) {
-                StressLinePointPrincipalStressDataUnified& stressLinePointPrincipalStressData =
-                        tubeTriangleStressLinePointPrincipalStressDataList.at(offset + ptIdx);
-                stressLinePointPrincipalStressData.lineMajorStress =
-                        trajectory.attributes.at(majorStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
-                stressLinePointPrincipalStressData.lineMediumStress =
-                        trajectory.attributes.at(mediumStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
-                stressLinePointPrincipalStressData.lineMinorStress =
-                        trajectory.attributes.at(minorStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
-            }
+                bandRenderMode != LineDataStress::BandRenderMode::RIBBONS
+                        ? tubeTriangleStressLinePointPrincipalStressDataList.data() + offset : nullptr);
+#else
+                nullptr);
 #endif
-        }
 
         lineCentersList.clear();
     }
@@ -2830,13 +2611,230 @@ TubeTriangleRenderData LineDataStress::getLinePassTubeTriangleMeshRenderDataPayl
     return cachedTubeTriangleRenderData;
 }
 
+void LineDataStress::getTubeTriangleMeshLines(
+        size_t psSetIdx, bool isRasterizer, std::vector<std::vector<glm::vec3>>& lineCentersList,
+        std::vector<std::vector<glm::vec3>>& bandPointsListRight) {
+    int psIdx = loadedPsIndices.at(psSetIdx);
+    const TrajectoryStore& trajectories = trajectoriesPs.at(psSetIdx);
+    const StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(psSetIdx);
+    const std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(psSetIdx);
+
+    lineCentersList.clear();
+    lineCentersList.resize(trajectories.size());
+    for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
+        if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
+            continue;
+        }
+        if (!isRasterizer && lineHierarchySliderValues[psIdx]
+                < 1.0 - stressTrajectoriesData.at(trajectoryIdx).hierarchyLevels.at(int(lineHierarchyType))) {
+            continue;
+        }
+        lineCentersList.at(trajectoryIdx) = trajectories.at(trajectoryIdx).positions;
+    }
+
+    bandPointsListRight.clear();
+    if (getUseBandRendering() && psUseBands.at(psIdx)) {
+        bandPointsListRight.resize(trajectories.size());
+        for (size_t trajectoryIdx = 0; trajectoryIdx < trajectories.size(); trajectoryIdx++) {
+            if (!filteredTrajectories.empty() && filteredTrajectories.at(trajectoryIdx)) {
+                continue;
+            }
+            if (useSmoothedBands) {
+                bandPointsListRight.at(trajectoryIdx) = bandPointsSmoothedListRightPs.at(psSetIdx).at(trajectoryIdx);
+            } else {
+                bandPointsListRight.at(trajectoryIdx) = bandPointsUnsmoothedListRightPs.at(psSetIdx).at(trajectoryIdx);
+            }
+        }
+    }
+}
+
+void LineDataStress::fillTubeTriangleLinePointData(
+        size_t psSetIdx, const std::vector<LinePointReference>& linePointReferences,
+        const std::vector<glm::vec3>& lineTangents, const std::vector<glm::vec3>& lineNormals,
+        size_t linePointOffset, LinePointDataUnified* linePointDataList,
+        StressLinePointDataUnified* stressLinePointDataList,
+        StressLinePointPrincipalStressDataUnified* principalStressDataList) {
+    int psIdx = loadedPsIndices.at(psSetIdx);
+    const TrajectoryStore& trajectories = trajectoriesPs.at(psSetIdx);
+    const StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(psSetIdx);
+
+#ifdef USE_EIGEN
+    int majorStressIdx = -1;
+    int mediumStressIdx = -1;
+    int minorStressIdx = -1;
+    if (principalStressDataList) {
+        majorStressIdx = getAttributeNameIndex("Major Stress");
+        mediumStressIdx = getAttributeNameIndex("Medium Stress");
+        minorStressIdx = getAttributeNameIndex("Minor Stress");
+    }
+#endif
+
+    uint32_t lineStartIndex = 0;
+    uint32_t lastTrajectoryIndex = std::numeric_limits<uint32_t>::max();
+    for (size_t ptIdx = 0; ptIdx < linePointReferences.size(); ptIdx++) {
+        const LinePointReference& linePointReference = linePointReferences.at(ptIdx);
+        LinePointDataUnified& tubeTriangleLinePointData = linePointDataList[ptIdx];
+        StressLinePointDataUnified& tubeTriangleStressLinePointData = stressLinePointDataList[ptIdx];
+        TrajectoryView trajectory = trajectories.at(linePointReference.trajectoryIndex);
+        const StressTrajectoryData& stressTrajectoryData =
+                stressTrajectoriesData.at(linePointReference.trajectoryIndex);
+        TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
+
+        tubeTriangleLinePointData.linePosition = trajectory.positions.at(linePointReference.linePointIndex);
+        tubeTriangleLinePointData.lineAttribute = attributes.at(linePointReference.linePointIndex);
+        tubeTriangleLinePointData.lineTangent = lineTangents.at(ptIdx);
+        tubeTriangleLinePointData.lineNormal = lineNormals.at(ptIdx);
+
+        if (lastTrajectoryIndex != linePointReference.trajectoryIndex) {
+            lastTrajectoryIndex = linePointReference.trajectoryIndex;
+            lineStartIndex = uint32_t(linePointOffset + ptIdx);
+        }
+        tubeTriangleLinePointData.lineStartIndex = lineStartIndex;
+
+        tubeTriangleStressLinePointData.linePrincipalStressIndex = uint32_t(psIdx);
+        tubeTriangleStressLinePointData.lineLineHierarchyLevel =
+                stressTrajectoryData.hierarchyLevels.at(int(lineHierarchyType));
+        tubeTriangleStressLinePointData.lineLineAppearanceOrder = uint32_t(stressTrajectoryData.appearanceOrder);
+
+#ifdef USE_EIGEN
+        if (principalStressDataList) {
+            StressLinePointPrincipalStressDataUnified& stressLinePointPrincipalStressData =
+                    principalStressDataList[ptIdx];
+            stressLinePointPrincipalStressData.lineMajorStress =
+                    trajectory.attributes.at(majorStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
+            stressLinePointPrincipalStressData.lineMediumStress =
+                    trajectory.attributes.at(mediumStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
+            stressLinePointPrincipalStressData.lineMinorStress =
+                    trajectory.attributes.at(minorStressIdx).at(linePointReference.linePointIndex) / maxPrincipalStressMagnitude;
+        }
+#endif
+    }
+}
+
+void LineDataStress::createTubeTriangleRenderDataStreaming(bool isRasterizer, bool vulkanRayTracing) {
+    sgl::vk::Device* device = sgl::AppSettings::get()->getPrimaryDevice();
+    cachedTubeTriangleRenderData = {};
+    cachedTubeTriangleRenderDataIsRayTracing = vulkanRayTracing;
+
+    // Run the count pass for all principal stress directions first, as the GPU buffers are allocated up front.
+    std::vector<size_t> psSetIndices;
+    for (size_t i = 0; i < trajectoriesPs.size(); i++) {
+        if (usedPsDirections.at(loadedPsIndices.at(i))) {
+            psSetIndices.push_back(i);
+        }
+    }
+    std::vector<std::vector<std::vector<glm::vec3>>> lineCentersListPs(psSetIndices.size());
+    std::vector<std::vector<std::vector<glm::vec3>>> bandPointsListRightPs(psSetIndices.size());
+    std::vector<std::unique_ptr<TriangleTubeMeshChunkGenerator>> generators;
+    std::vector<size_t> vertexOffsets, indexOffsets, linePointOffsets;
+    size_t numVertices = 0, numIndices = 0, numLinePoints = 0;
+    for (size_t setIdx = 0; setIdx < psSetIndices.size(); setIdx++) {
+        std::vector<std::vector<glm::vec3>>& lineCentersList = lineCentersListPs.at(setIdx);
+        std::vector<std::vector<glm::vec3>>& bandPointsListRight = bandPointsListRightPs.at(setIdx);
+        getTubeTriangleMeshLines(psSetIndices.at(setIdx), isRasterizer, lineCentersList, bandPointsListRight);
+        float tubeNormalRadius, tubeBinormalRadius;
+        if (!bandPointsListRight.empty()) {
+            tubeBinormalRadius = LineRenderer::getBandWidth() * 0.5f;
+            tubeNormalRadius = tubeBinormalRadius * minBandThickness;
+        } else {
+            tubeNormalRadius = LineRenderer::getLineWidth() * 0.5f;
+            tubeBinormalRadius = tubeNormalRadius;
+        }
+        generators.push_back(std::make_unique<TriangleTubeMeshChunkGenerator>(
+                lineCentersList, bandPointsListRight.empty() ? nullptr : &bandPointsListRight,
+                tubeNormalRadius, tubeBinormalRadius, tubeNumSubdivisions, useCappedTubes, false,
+                numVertices, uint32_t(numLinePoints), tubeTriangleStreamingChunkSize));
+        vertexOffsets.push_back(numVertices);
+        indexOffsets.push_back(numIndices);
+        linePointOffsets.push_back(numLinePoints);
+        numVertices += generators.back()->getNumVertices();
+        numIndices += generators.back()->getNumIndices();
+        numLinePoints += generators.back()->getNumLinePoints();
+    }
+    if (numIndices == 0) {
+        return;
+    }
+
+    uint32_t indexBufferFlags =
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    uint32_t vertexBufferFlags =
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (vulkanRayTracing) {
+        indexBufferFlags |=
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+        vertexBufferFlags |=
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+    }
+
+    cachedTubeTriangleRenderData.indexBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, numIndices * sizeof(uint32_t), indexBufferFlags, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    cachedTubeTriangleRenderData.vertexBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, numVertices * sizeof(TubeTriangleVertexData), vertexBufferFlags, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    cachedTubeTriangleRenderData.linePointDataBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, numLinePoints * sizeof(LinePointDataUnified),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    cachedTubeTriangleRenderData.stressLinePointDataBuffer = std::make_shared<sgl::vk::Buffer>(
+            device, numLinePoints * sizeof(StressLinePointDataUnified),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    // The copies of one chunk are submitted while the next chunk is generated.
+    StagingRingUploader uploader(device, tubeTriangleStreamingChunkSize);
+    std::vector<LinePointDataUnified> tubeTriangleLinePointDataList;
+    std::vector<StressLinePointDataUnified> tubeTriangleStressLinePointDataList;
+    for (size_t setIdx = 0; setIdx < psSetIndices.size(); setIdx++) {
+        TriangleTubeMeshChunkGenerator& generator = *generators.at(setIdx);
+        for (size_t chunkIdx = 0; chunkIdx < generator.getNumChunks(); chunkIdx++) {
+            const TubeTriangleMeshChunk& chunk = generator.generateChunk(chunkIdx);
+            const size_t numChunkLinePoints = chunk.linePointReferenceList.size();
+            const size_t linePointOffset = linePointOffsets.at(setIdx) + chunk.linePointOffset;
+            tubeTriangleLinePointDataList.resize(numChunkLinePoints);
+            tubeTriangleStressLinePointDataList.resize(numChunkLinePoints);
+            fillTubeTriangleLinePointData(
+                    psSetIndices.at(setIdx), chunk.linePointReferenceList, chunk.lineTangents, chunk.lineNormals,
+                    linePointOffset, tubeTriangleLinePointDataList.data(),
+                    tubeTriangleStressLinePointDataList.data(), nullptr);
+
+            uploader.uploadData(
+                    cachedTubeTriangleRenderData.indexBuffer,
+                    (indexOffsets.at(setIdx) + chunk.indexOffset) * sizeof(uint32_t),
+                    chunk.triangleIndices.size() * sizeof(uint32_t), chunk.triangleIndices.data());
+            uploader.uploadData(
+                    cachedTubeTriangleRenderData.vertexBuffer,
+                    (vertexOffsets.at(setIdx) + chunk.vertexOffset) * sizeof(TubeTriangleVertexData),
+                    chunk.vertexDataList.size() * sizeof(TubeTriangleVertexData), chunk.vertexDataList.data());
+            uploader.uploadData(
+                    cachedTubeTriangleRenderData.linePointDataBuffer,
+                    linePointOffset * sizeof(LinePointDataUnified),
+                    numChunkLinePoints * sizeof(LinePointDataUnified), tubeTriangleLinePointDataList.data());
+            uploader.uploadData(
+                    cachedTubeTriangleRenderData.stressLinePointDataBuffer,
+                    linePointOffset * sizeof(StressLinePointDataUnified),
+                    numChunkLinePoints * sizeof(StressLinePointDataUnified),
+                    tubeTriangleStressLinePointDataList.data());
+            uploader.flush();
+        }
+    }
+    uploader.finish();
+}
+
 TubeAabbRenderData LineDataStress::getLinePassTubeAabbRenderData(bool isRasterizer, bool ellipticTubes) {
     rebuildInternalRepresentationIfNecessary();
     if (cachedTubeAabbRenderData.aabbBuffer && tubeAabbEllipticTubes == ellipticTubes) {
         return cachedTubeAabbRenderData;
     }
+    RenderDataCacheKey renderDataKey = getRenderDataCacheKey(RequestMode::AABBS);
+    renderDataKey.ellipticTubes = ellipticTubes;
+    if (activateCachedDataType(renderDataKey)) {
+        return cachedTubeAabbRenderData;
+    }
     tubeAabbEllipticTubes = ellipticTubes;
-    removeOtherCachedDataTypes(RequestMode::AABBS);
 
     //glm::vec3 lineWidthOffset(std::max(LineRenderer::getLineWidth() * 0.5f, LineRenderer::getBandWidth() * 0.5f));
     glm::vec3 lineWidthOffset;
@@ -2883,7 +2881,7 @@ TubeAabbRenderData LineDataStress::getLinePassTubeAabbRenderData(bool isRasteriz
             continue;
         }
 
-        Trajectories &trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         StressTrajectoriesData &stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
         std::vector<bool>& filteredTrajectories = filteredTrajectoriesPs.at(i);
 
@@ -2904,7 +2902,7 @@ TubeAabbRenderData LineDataStress::getLinePassTubeAabbRenderData(bool isRasteriz
                     < 1.0 - stressTrajectoriesData.at(trajectoryIdx).hierarchyLevels.at(int(lineHierarchyType))) {
                 continue;
             }
-            Trajectory& trajectory = trajectories.at(trajectoryIdx);
+            TrajectoryView trajectory = trajectories.at(trajectoryIdx);
             StressTrajectoryData& stressTrajectoryData = stressTrajectoriesData.at(trajectoryIdx);
 
             glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
@@ -3171,7 +3169,7 @@ void LineDataStress::getTriangleMesh(
             continue;
         }
 
-        Trajectories& trajectories = trajectoriesPs.at(i);
+        const TrajectoryStore& trajectories = trajectoriesPs.at(i);
         StressTrajectoriesData& stressTrajectoriesData = stressTrajectoriesDataPs.at(i);
 
         size_t offsetVertices = tubeTriangleVertexDataList.size();
@@ -3248,13 +3246,13 @@ void LineDataStress::getTriangleMesh(
                 float binormalRadius = LineRenderer::getBandWidth() * 0.5f;
                 float normalRadius = binormalRadius * minBandThickness;
                 if (useCappedTubes) {
-                    createCappedTriangleEllipticTubesRenderDataCPU(
+                    createCappedTriangleEllipticTubesRenderDataCPUParallel(
                             lineCentersList, bandPointsListRight, normalRadius,
                             binormalRadius, tubeNumSubdivisions,
                             false, triangleIndices, tubeTriangleVertexDataList, linePointReferences,
                             uint32_t(numTubeTriangleLinePoints), lineTangents, lineNormals);
                 } else {
-                    createTriangleEllipticTubesRenderDataCPU(
+                    createTriangleEllipticTubesRenderDataCPUParallel(
                             lineCentersList, bandPointsListRight, normalRadius,
                             binormalRadius, tubeNumSubdivisions,
                             triangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -3285,13 +3283,13 @@ void LineDataStress::getTriangleMesh(
 #endif
         } else {
             if (useCappedTubes) {
-                createCappedTriangleTubesRenderDataCPU(
+                createCappedTriangleTubesRenderDataCPUParallel(
                         lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                         tubeNumSubdivisions, false,
                         triangleIndices, tubeTriangleVertexDataList, linePointReferences,
                         uint32_t(numTubeTriangleLinePoints), lineTangents, lineNormals);
             } else {
-                createTriangleTubesRenderDataCPU(
+                createTriangleTubesRenderDataCPUParallel(
                         lineCentersList, LineRenderer::getLineWidth() * 0.5f,
                         tubeNumSubdivisions,
                         triangleIndices, tubeTriangleVertexDataList, linePointReferences,
@@ -3309,8 +3307,8 @@ void LineDataStress::getTriangleMesh(
 
             LinePointReference& linePointReference = linePointReferences.at(
                     (tubeTriangleVertexData.vertexLinePointIndex & 0x7FFFFFFFu) - offset);
-            Trajectory& trajectory = trajectories.at(linePointReference.trajectoryIndex);
-            std::vector<float>& attributes = trajectory.attributes.at(selectedAttributeIndex);
+            TrajectoryView trajectory = trajectories.at(linePointReference.trajectoryIndex);
+            TrajectorySpan<const float> attributes = trajectory.attributes.at(selectedAttributeIndex);
             float attributeValue = attributes.at(linePointReference.linePointIndex);
             vertexAttributes.push_back(attributeValue);
         }
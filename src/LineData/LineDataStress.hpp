@@ -36,6 +36,8 @@
 #include "LineData.hpp"
 #include "Widgets/StressLineHierarchyMappingWidget.hpp"
 
+struct LinePassLineRanges;
+
 //const char *const DISTANCE_MEASURES[] = {
 //        "Distance Exponential Kernel",
 //        "Distance Squared Exponential Kernel"
@@ -88,9 +90,9 @@ public:
     size_t getBaseSizeInBytes() override;
 
     // Public interface for filtering trajectories.
-    void iterateOverTrajectories(std::function<void(const Trajectory&)> callback) override;
-    void iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback) override;
-    void filterTrajectories(std::function<bool(const Trajectory&)> callback) override;
+    void iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback) override;
+    void iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback) override;
+    void filterTrajectories(std::function<bool(const TrajectoryView&)> callback) override;
     void resetTrajectoryFilter() override;
 
     // Get filtered line data (only containing points also shown when rendering).
@@ -180,24 +182,53 @@ private:
     void recomputeColorLegend() override;
     void recomputeColorLegendPositions();
 
+    /**
+     * Computes the number of valid line points of all lines of the used principal stress directions and their offsets
+     * in the line point arrays created by @see getLinePassTubeRenderDataGeneral.
+     * @param lineRangesPs The line ranges of each loaded principal stress direction (empty if unused).
+     * @param numLinePoints The total number of line points.
+     * @param numSegments The total number of line segments.
+     */
+    void getLinePassLineRanges(
+            std::vector<LinePassLineRanges>& lineRangesPs, uint32_t& numLinePoints, uint32_t& numSegments);
     /**
      * Function used by, e.g., @see getLinePassTubeRenderData, @see getLinePassTubeRenderDataMeshShader and
      * @see getLinePassTubeRenderDataProgrammablePull.
-     * It encapsulates shared code for creating line vertex and index data.
-     * @param indexOffsetFunctor A functor that returns the line index offset for the next points to be pushed.
-     * @param pointPushFunctor A functor that accepts a new point.
-     * @param pointPopFunctor A functor that gets called when the previous point needs to be removed. This usually
-     * happens when a line doesn't have at least two valid points.
-     * @param indicesPushFunctor A functor that creates line index data for the previously pushed points.
+     * It encapsulates shared code for creating line vertex data. The line points are generated in parallel and
+     * passed to writeLinePoint, which needs to write them to index linePointIdx of preallocated arrays.
+     * @param lineRangesPs The line ranges computed by @see getLinePassLineRanges.
+     * @param writeLinePoint Called as writeLinePoint(linePointIdx, lineCenter, normal, tangent, lineAttribute,
+     * lineStartIndex, principalStressIndex, lineHierarchyLevel, lineAppearanceOrder, majorStress, mediumStress,
+     * minorStress).
      */
+    template<class LinePointWriter>
     void getLinePassTubeRenderDataGeneral(
-            const std::function<uint32_t()>& indexOffsetFunctor,
-            const std::function<void(
-                    const glm::vec3& lineCenter, const glm::vec3& normal, const glm::vec3& tangent, float lineAttribute,
-                    uint32_t indexOffset, int principalStressIndex, float lineHierarchyLevel, int lineAppearanceOrder,
-                    float majorStress, float mediumStress, float minorStress)>& pointPushFunctor,
-            const std::function<void()>& pointPopFunctor,
-            const std::function<void(int numSegments, uint32_t indexOffset)>& indicesPushFunctor);
+            const std::vector<LinePassLineRanges>& lineRangesPs, const LinePointWriter& writeLinePoint);
+
+    /**
+     * Collects the lines of the loaded principal stress direction psSetIdx used for the tube triangle mesh.
+     * bandPointsListRight is only filled if bands are used for the direction.
+     */
+    void getTubeTriangleMeshLines(
+            size_t psSetIdx, bool isRasterizer, std::vector<std::vector<glm::vec3>>& lineCentersList,
+            std::vector<std::vector<glm::vec3>>& bandPointsListRight);
+    /**
+     * Fills the line point data of consecutive line points of the tube triangle mesh of the loaded principal stress
+     * direction psSetIdx.
+     * @param linePointOffset The index of the first passed line point in the complete mesh.
+     * @param principalStressDataList Only used if principal stress tubes are rendered (can be nullptr otherwise).
+     */
+    void fillTubeTriangleLinePointData(
+            size_t psSetIdx, const std::vector<LinePointReference>& linePointReferences,
+            const std::vector<glm::vec3>& lineTangents, const std::vector<glm::vec3>& lineNormals,
+            size_t linePointOffset, LinePointDataUnified* linePointDataList,
+            StressLinePointDataUnified* stressLinePointDataList,
+            StressLinePointPrincipalStressDataUnified* principalStressDataList);
+    /**
+     * Generates the tube triangle mesh in chunks and uploads each chunk before the next one is generated.
+     * This way, the complete mesh never needs to be stored in host memory.
+     */
+    void createTubeTriangleRenderDataStreaming(bool isRasterizer, bool vulkanRayTracing);
 
     // Should we show major, medium and/or minor principal stress lines?
     static bool useMajorPS, useMediumPS, useMinorPS;
@@ -206,7 +237,7 @@ private:
 
     // Principal stress lines (usually three line sets for three directions).
     std::vector<int> loadedPsIndices; ///< 0 = major, 1 = medium, 2 = minor.
-    std::vector<Trajectories> trajectoriesPs;
+    std::vector<TrajectoryStore> trajectoriesPs;
     std::vector<StressTrajectoriesData> stressTrajectoriesDataPs;
     std::vector<glm::vec3> degeneratePoints;
     std::vector<bool> usedPsDirections; ///< What principal stress (PS) directions do we want to display?
@@ -0,0 +1,291 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "LineLodHierarchy.hpp"
+
+namespace {
+
+/**
+ * Calls functor(lineIdx) in parallel for all lines.
+ */
+template<class Functor>
+void parallelForLines(size_t numLines, const Functor& functor) {
+    auto numLinesInt = int(numLines);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numLinesInt), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#pragma omp parallel for default(none) shared(numLinesInt, functor) schedule(dynamic, 64)
+    for (int lineIdx = 0; lineIdx < numLinesInt; lineIdx++) {
+#endif
+        functor(size_t(lineIdx));
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+struct ErrorRange {
+    uint32_t startIdx;
+    uint32_t endIdx;
+    float parentError;
+};
+
+/**
+ * Runs the Douglas-Peucker algorithm without error threshold on one line and stores for each point the max. position
+ * error of the range it splits. The error is clamped to the error of the parent range, as the point can only be kept
+ * if the parent range was split.
+ */
+void computeLinePointErrors(
+        const TrajectorySpan<const glm::vec3>& positions, float* errors, std::vector<ErrorRange>& rangeStack) {
+    const auto numPoints = uint32_t(positions.size());
+    if (numPoints == 0) {
+        return;
+    }
+    errors[0] = std::numeric_limits<float>::max();
+    errors[numPoints - 1] = std::numeric_limits<float>::max();
+
+    rangeStack.clear();
+    rangeStack.push_back({ 0, numPoints - 1, std::numeric_limits<float>::max() });
+    while (!rangeStack.empty()) {
+        ErrorRange range = rangeStack.back();
+        rangeStack.pop_back();
+        if (range.endIdx - range.startIdx < 2) {
+            continue;
+        }
+
+        const glm::vec3& startPoint = positions[range.startIdx];
+        glm::vec3 segment = positions[range.endIdx] - startPoint;
+        float segmentLengthSq = glm::dot(segment, segment);
+        float maxError = -1.0f;
+        uint32_t maxErrorIdx = range.startIdx + 1;
+        for (uint32_t i = range.startIdx + 1; i < range.endIdx; i++) {
+            glm::vec3 diff = positions[i] - startPoint;
+            if (segmentLengthSq > 0.0f) {
+                float t = std::clamp(glm::dot(diff, segment) / segmentLengthSq, 0.0f, 1.0f);
+                diff -= t * segment;
+            }
+            float error = glm::length(diff);
+            if (error > maxError) {
+                maxError = error;
+                maxErrorIdx = i;
+            }
+        }
+
+        float error = std::min(maxError, range.parentError);
+        errors[maxErrorIdx] = error;
+        rangeStack.push_back({ range.startIdx, maxErrorIdx, error });
+        rangeStack.push_back({ maxErrorIdx, range.endIdx, error });
+    }
+}
+
+/// Returns the finest level the point with the passed error is not part of anymore.
+inline uint32_t getLinePointNumLevels(float error, const std::vector<float>& levelErrors) {
+    auto numLevels = uint32_t(levelErrors.size());
+    uint32_t level = 1;
+    while (level < numLevels && error > levelErrors[level]) {
+        level++;
+    }
+    return level;
+}
+
+}
+
+void LineLodHierarchy::clear() {
+    levelErrors = {};
+    linePointErrors = {};
+    lineBoundingSpheres = {};
+    lineHierarchyLevels = {};
+    lineOrder = {};
+    levelLineOffsets = {};
+    linePointIndices = {};
+    levelNumLinePoints = {};
+}
+
+void LineLodHierarchy::build(
+        const TrajectoryStore& trajectories, const LineLodHierarchySettings& settings,
+        const std::vector<float>& _lineHierarchyLevels) {
+    const size_t numLines = trajectories.size();
+    const std::vector<uint64_t>& trajectoryLineOffsets = trajectories.getLineOffsets();
+    const uint32_t numLevels = std::max(settings.numLevels, 1u);
+    levelErrors.resize(numLevels);
+    levelErrors[0] = 0.0f;
+    for (uint32_t level = 1; level < numLevels; level++) {
+        levelErrors[level] = settings.minError * std::pow(settings.errorFactor, float(level - 1));
+    }
+
+    // Pass 1: Compute the point errors, the bounding spheres and arc lengths, and count the points of all levels.
+    linePointErrors.resize(trajectories.getNumLinePoints());
+    lineBoundingSpheres.resize(numLines);
+    std::vector<float> lineArcLengths(numLines, 0.0f);
+    std::vector<uint32_t> lineLevelNumPoints(size_t(numLevels) * numLines, 0);
+    parallelForLines(numLines, [&](size_t lineIdx) {
+        TrajectorySpan<const glm::vec3> positions = trajectories[lineIdx].positions;
+        if (positions.empty()) {
+            lineBoundingSpheres[lineIdx] = {};
+            return;
+        }
+        float* errors = linePointErrors.data() + trajectoryLineOffsets[lineIdx];
+        thread_local std::vector<ErrorRange> rangeStack;
+        computeLinePointErrors(positions, errors, rangeStack);
+
+        glm::vec3 aabbMin(std::numeric_limits<float>::max());
+        glm::vec3 aabbMax(std::numeric_limits<float>::lowest());
+        float arcLength = 0.0f;
+        for (size_t i = 0; i < positions.size(); i++) {
+            aabbMin = glm::min(aabbMin, positions[i]);
+            aabbMax = glm::max(aabbMax, positions[i]);
+            if (i > 0) {
+                arcLength += glm::length(positions[i] - positions[i - 1]);
+            }
+            uint32_t numPointLevels = getLinePointNumLevels(errors[i], levelErrors);
+            for (uint32_t level = 0; level < numPointLevels; level++) {
+                lineLevelNumPoints[size_t(level) * numLines + lineIdx]++;
+            }
+        }
+        lineBoundingSpheres[lineIdx].center = 0.5f * (aabbMin + aabbMax);
+        lineBoundingSpheres[lineIdx].radius = 0.5f * glm::length(aabbMax - aabbMin);
+        lineArcLengths[lineIdx] = arcLength;
+    });
+
+    levelLineOffsets.resize(size_t(numLevels) * numLines + 1);
+    levelNumLinePoints.assign(numLevels, 0);
+    uint64_t offset = 0;
+    for (uint32_t level = 0; level < numLevels; level++) {
+        for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            uint32_t numPoints = lineLevelNumPoints[size_t(level) * numLines + lineIdx];
+            levelLineOffsets[size_t(level) * numLines + lineIdx] = offset;
+            offset += numPoints;
+            levelNumLinePoints[level] += numPoints;
+        }
+    }
+    levelLineOffsets.back() = offset;
+
+    // Pass 2: Write the point indices of all levels.
+    linePointIndices.resize(size_t(offset));
+    parallelForLines(numLines, [&](size_t lineIdx) {
+        const uint64_t lineOffset = trajectoryLineOffsets[lineIdx];
+        const auto numPoints = uint32_t(trajectoryLineOffsets[lineIdx + 1] - lineOffset);
+        const float* errors = linePointErrors.data() + lineOffset;
+        for (uint32_t level = 0; level < numLevels; level++) {
+            uint32_t* indices = linePointIndices.data() + levelLineOffsets[size_t(level) * numLines + lineIdx];
+            for (uint32_t i = 0; i < numPoints; i++) {
+                if (level == 0 || errors[i] > levelErrors[level]) {
+                    *(indices++) = uint32_t(lineOffset) + i;
+                }
+            }
+        }
+    });
+
+    // Line importance ordering.
+    if (_lineHierarchyLevels.size() == numLines) {
+        lineHierarchyLevels = _lineHierarchyLevels;
+    } else {
+        // Rank by arc length; the longest line gets the importance 1.
+        std::vector<uint32_t> arcLengthOrder(numLines);
+        std::iota(arcLengthOrder.begin(), arcLengthOrder.end(), 0u);
+        std::stable_sort(arcLengthOrder.begin(), arcLengthOrder.end(), [&](uint32_t i0, uint32_t i1) {
+            return lineArcLengths[i0] > lineArcLengths[i1];
+        });
+        lineHierarchyLevels.resize(numLines);
+        for (size_t rank = 0; rank < numLines; rank++) {
+            lineHierarchyLevels[arcLengthOrder[rank]] =
+                    numLines > 1 ? 1.0f - float(rank) / float(numLines - 1) : 1.0f;
+        }
+    }
+    lineOrder.resize(numLines);
+    std::iota(lineOrder.begin(), lineOrder.end(), 0u);
+    std::stable_sort(lineOrder.begin(), lineOrder.end(), [&](uint32_t i0, uint32_t i1) {
+        return lineHierarchyLevels[i0] > lineHierarchyLevels[i1];
+    });
+}
+
+void LineLodHierarchy::selectLevels(
+        const LineLodViewParameters& viewParameters, float pixelErrorBudget, float lineHierarchyThreshold,
+        LineLodSelection& selection) const {
+    const size_t numLines = getNumLines();
+    const uint32_t numLevels = getNumLevels();
+    selection.lineRanges.resize(numLines);
+
+    // Number of pixels a world space length at distance one covers on the screen.
+    const float pixelsPerUnitLength =
+            viewParameters.viewportHeight / (2.0f * std::tan(0.5f * viewParameters.fieldOfViewY));
+    const float maxErrorPerDistance = pixelErrorBudget / pixelsPerUnitLength;
+
+    parallelForLines(numLines, [&](size_t lineIdx) {
+        LineLodRange& lineRange = selection.lineRanges[lineIdx];
+        if (1.0f - lineHierarchyLevels[lineIdx] > lineHierarchyThreshold) {
+            lineRange = {};
+            return;
+        }
+        const BoundingSphere& boundingSphere = lineBoundingSpheres[lineIdx];
+        float distance = glm::length(boundingSphere.center - viewParameters.cameraPosition) - boundingSphere.radius;
+        uint32_t level = 0;
+        if (distance > 0.0f) {
+            float maxError = maxErrorPerDistance * distance;
+            while (level + 1 < numLevels && levelErrors[level + 1] <= maxError) {
+                level++;
+            }
+        }
+        lineRange.level = level;
+        lineRange.indexOffset = getLineLevelIndexOffset(lineIdx, level);
+        lineRange.numIndices = getLineLevelNumPoints(lineIdx, level);
+    });
+
+    selection.numLinePoints = 0;
+    selection.numLineSegments = 0;
+    selection.numLinePointsFinest = 0;
+    selection.levelNumLines.assign(numLevels, 0);
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        const LineLodRange& lineRange = selection.lineRanges[lineIdx];
+        if (lineRange.numIndices == 0) {
+            continue;
+        }
+        selection.numLinePoints += lineRange.numIndices;
+        selection.numLineSegments += lineRange.numIndices - 1;
+        selection.numLinePointsFinest += getLineLevelNumPoints(lineIdx, 0);
+        selection.levelNumLines[lineRange.level]++;
+    }
+}
+
+size_t LineLodHierarchy::getSizeInBytes() const {
+    return levelErrors.size() * sizeof(float) + linePointErrors.size() * sizeof(float)
+            + lineBoundingSpheres.size() * sizeof(BoundingSphere) + lineHierarchyLevels.size() * sizeof(float)
+            + lineOrder.size() * sizeof(uint32_t) + levelLineOffsets.size() * sizeof(uint64_t)
+            + linePointIndices.size() * sizeof(uint32_t) + levelNumLinePoints.size() * sizeof(size_t);
+}
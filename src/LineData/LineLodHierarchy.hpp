@@ -0,0 +1,146 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_LINELODHIERARCHY_HPP
+#define LINEVIS_LINELODHIERARCHY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Loaders/TrajectoryStore.hpp"
+
+/*
+ * Multi-resolution representation of a line set for level-of-detail rendering. Every line point stores the position
+ * error at which the Douglas-Peucker algorithm (see LineSimplification.hpp) removes it. The errors are made monotonic
+ * along the refinement hierarchy, so thresholding them yields exactly the Douglas-Peucker simplification for the
+ * threshold. Level 0 contains all points, level l > 0 the points with an error larger than
+ * minError * errorFactor^(l - 1). The first and last point of a line are part of all levels.
+ *
+ * The points of all levels are stored as indices into the finest point buffer, i.e., the point order of the trajectory
+ * store. Thus, renderers only need one vertex buffer and select one index range per line (@see selectLevels).
+ * Optionally, the lines are ranked by an importance value in [0, 1], which is used like the hierarchy levels of stress
+ * lines (1 is the most important line).
+ */
+
+struct LineLodHierarchySettings {
+    float minError = 0.0f; ///< World space error of level 1.
+    float errorFactor = 2.0f; ///< Ratio of the errors of two subsequent levels.
+    uint32_t numLevels = 8; ///< Including the finest level 0.
+};
+
+/// The camera parameters used for projecting the world space error of a level to the screen.
+struct LineLodViewParameters {
+    glm::vec3 cameraPosition{};
+    float fieldOfViewY = 0.0f; ///< Vertical field of view in radians.
+    float viewportHeight = 0.0f; ///< In pixels.
+};
+
+/// The selected index range of one line.
+struct LineLodRange {
+    uint64_t indexOffset = 0; ///< Offset into LineLodHierarchy::getLinePointIndices().
+    uint32_t numIndices = 0; ///< Zero if the line is culled.
+    uint32_t level = 0;
+};
+
+struct LineLodSelection {
+    std::vector<LineLodRange> lineRanges; ///< One entry per line.
+
+    // Statistics.
+    size_t numLinePoints = 0; ///< Number of emitted line points.
+    size_t numLineSegments = 0;
+    size_t numLinePointsFinest = 0; ///< Number of points of the selected lines at the finest level.
+    std::vector<size_t> levelNumLines; ///< Number of lines using each level.
+};
+
+class LineLodHierarchy {
+public:
+    /**
+     * Builds the hierarchy for all lines in parallel.
+     * @param trajectories The lines.
+     * @param settings The errors of the levels.
+     * @param lineHierarchyLevels Optional per-line importance in [0, 1]. If empty, the lines are ranked by arc length.
+     */
+    void build(
+            const TrajectoryStore& trajectories, const LineLodHierarchySettings& settings,
+            const std::vector<float>& lineHierarchyLevels = {});
+    void clear();
+
+    /**
+     * Selects the coarsest level per line whose error projected at the closest point of the bounding sphere of the
+     * line stays below the passed pixel error.
+     * @param viewParameters The camera.
+     * @param pixelErrorBudget The maximum allowed screen space error in pixels.
+     * @param lineHierarchyThreshold Lines with 1 - importance > lineHierarchyThreshold are culled (1 keeps all lines).
+     * @param selection The index ranges and statistics.
+     */
+    void selectLevels(
+            const LineLodViewParameters& viewParameters, float pixelErrorBudget, float lineHierarchyThreshold,
+            LineLodSelection& selection) const;
+
+    [[nodiscard]] inline size_t getNumLines() const { return lineBoundingSpheres.size(); }
+    [[nodiscard]] inline uint32_t getNumLevels() const { return uint32_t(levelErrors.size()); }
+    /// World space error of each level (0 for level 0).
+    [[nodiscard]] inline const std::vector<float>& getLevelErrors() const { return levelErrors; }
+    /// Error at which each line point is removed (FLT_MAX for the end points).
+    [[nodiscard]] inline const std::vector<float>& getLinePointErrors() const { return linePointErrors; }
+    /// Indices into the finest point buffer of all levels of all lines.
+    [[nodiscard]] inline const std::vector<uint32_t>& getLinePointIndices() const { return linePointIndices; }
+    /// Per-line importance in [0, 1].
+    [[nodiscard]] inline const std::vector<float>& getLineHierarchyLevels() const { return lineHierarchyLevels; }
+    /// Line indices sorted by decreasing importance.
+    [[nodiscard]] inline const std::vector<uint32_t>& getLineOrder() const { return lineOrder; }
+    [[nodiscard]] inline uint64_t getLineLevelIndexOffset(size_t lineIdx, uint32_t level) const {
+        return levelLineOffsets[size_t(level) * getNumLines() + lineIdx];
+    }
+    [[nodiscard]] inline uint32_t getLineLevelNumPoints(size_t lineIdx, uint32_t level) const {
+        size_t idx = size_t(level) * getNumLines() + lineIdx;
+        return uint32_t(levelLineOffsets[idx + 1] - levelLineOffsets[idx]);
+    }
+    /// Number of points of all lines at each level.
+    [[nodiscard]] inline const std::vector<size_t>& getLevelNumLinePoints() const { return levelNumLinePoints; }
+    [[nodiscard]] size_t getSizeInBytes() const;
+
+private:
+    struct BoundingSphere {
+        glm::vec3 center{};
+        float radius = 0.0f;
+    };
+
+    std::vector<float> levelErrors;
+    std::vector<float> linePointErrors;
+    std::vector<BoundingSphere> lineBoundingSpheres;
+    std::vector<float> lineHierarchyLevels;
+    std::vector<uint32_t> lineOrder;
+    /// Offset of line i at level l in linePointIndices at l * numLines + i (size: numLevels * numLines + 1).
+    std::vector<uint64_t> levelLineOffsets;
+    std::vector<uint32_t> linePointIndices;
+    std::vector<size_t> levelNumLinePoints;
+};
+
+#endif //LINEVIS_LINELODHIERARCHY_HPP
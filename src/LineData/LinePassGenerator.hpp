@@ -0,0 +1,225 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_LINEPASSGENERATOR_HPP
+#define LINEVIS_LINEPASSGENERATOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "Loaders/TrajectoryStore.hpp"
+
+/*
+ * Two-phase generator for the line point data used by the line pass renderers (geometry shader, mesh shader and
+ * programmable pull). The first phase counts the valid points of each line and assigns the output offsets with a prefix
+ * sum, the second phase writes the line points of all lines in parallel directly into the preallocated output arrays.
+ * Line points whose neighbors are almost identical are skipped. Lines with less than two valid points produce no output.
+ */
+
+struct LinePassLineRange {
+    uint32_t linePointOffset = 0; ///< Index of the first line point of the line in the output arrays.
+    uint32_t numLinePoints = 0; ///< Number of valid line points; zero if the line produces no output.
+    uint32_t segmentOffset = 0; ///< Number of line segments of all previous lines.
+};
+
+struct LinePassLineRanges {
+    std::vector<LinePassLineRange> lines; ///< One entry per trajectory.
+    uint32_t numLinePoints = 0;
+    uint32_t numSegments = 0;
+    /// If not nullptr, only the marked line points are used (one entry per line point of the trajectory store).
+    const uint8_t* keepLinePoints = nullptr;
+};
+
+/// Whether line point i of the passed line is marked as kept (e.g., by the line simplification).
+inline bool getLinePassKeepLinePoint(
+        const TrajectoryStore& trajectories, const uint8_t* keepLinePoints, size_t lineIdx, size_t i) {
+    return !keepLinePoints || keepLinePoints[trajectories.getLineOffsets()[lineIdx] + i] != 0;
+}
+
+/**
+ * Computes the tangent at line point i.
+ * @return False if the line point should be skipped, as the neighboring vertices are almost identical.
+ */
+inline bool computeLinePassTangent(const TrajectorySpan<const glm::vec3>& positions, size_t i, glm::vec3& tangent) {
+    size_t n = positions.size();
+    if (i == 0) {
+        tangent = positions[i + 1] - positions[i];
+    } else if (i == n - 1) {
+        tangent = positions[i] - positions[i - 1];
+    } else {
+        tangent = positions[i + 1] - positions[i - 1];
+    }
+    float lineSegmentLength = glm::length(tangent);
+    return !(lineSegmentLength < 0.0001f);
+}
+
+/**
+ * Computes a normal orthogonal to the passed normalized tangent that is as close as possible to the last normal.
+ */
+inline glm::vec3 computeLinePassNormal(const glm::vec3& tangent, glm::vec3& lastLineNormal) {
+    glm::vec3 helperAxis = lastLineNormal;
+    if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
+        // If tangent == lastNormal
+        helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+        if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
+            // If tangent == helperAxis
+            helperAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+    }
+    glm::vec3 normal = glm::normalize(helperAxis - tangent * glm::dot(helperAxis, tangent)); // Gram-Schmidt
+    lastLineNormal = normal;
+    return normal;
+}
+
+/**
+ * Calls lineFunctor(lineIdx, lineRange) in parallel for all lines producing output.
+ */
+template<class LineFunctor>
+void forEachLinePassLine(const LinePassLineRanges& lineRanges, const LineFunctor& lineFunctor) {
+    auto numLines = int(lineRanges.lines.size());
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numLines), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#pragma omp parallel for default(none) shared(numLines, lineRanges, lineFunctor) schedule(dynamic, 64)
+    for (int lineIdx = 0; lineIdx < numLines; lineIdx++) {
+#endif
+        const LinePassLineRange& lineRange = lineRanges.lines[lineIdx];
+        if (lineRange.numLinePoints == 0) {
+            continue;
+        }
+        lineFunctor(size_t(lineIdx), lineRange);
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+/**
+ * Phase 1: Counts the valid line points of all trajectories and computes their output offsets.
+ * @param trajectories The lines.
+ * @param filteredTrajectories Lines marked as filtered produce no output. Can be empty.
+ * @param linePointBase The offset of the first line point (e.g., when appending multiple line sets).
+ * @param segmentBase The offset of the first line segment.
+ * @param lineRanges The output ranges.
+ * @param keepLinePoints If not nullptr, line points not marked in this array are skipped (e.g., after simplification).
+ */
+inline void computeLinePassLineRanges(
+        const TrajectoryStore& trajectories, const std::vector<bool>& filteredTrajectories,
+        uint32_t linePointBase, uint32_t segmentBase, LinePassLineRanges& lineRanges,
+        const uint8_t* keepLinePoints = nullptr) {
+    auto numLines = int(trajectories.size());
+    lineRanges.lines.clear();
+    lineRanges.lines.resize(trajectories.size());
+    lineRanges.keepLinePoints = keepLinePoints;
+
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numLines), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#pragma omp parallel for default(none) \
+    shared(numLines, trajectories, filteredTrajectories, lineRanges, keepLinePoints) schedule(dynamic, 64)
+    for (int lineIdx = 0; lineIdx < numLines; lineIdx++) {
+#endif
+        if (!filteredTrajectories.empty() && filteredTrajectories.at(lineIdx)) {
+            continue;
+        }
+        TrajectorySpan<const glm::vec3> positions = trajectories[lineIdx].positions;
+        if (positions.size() < 2) {
+            continue;
+        }
+        uint32_t numValidLinePoints = 0;
+        glm::vec3 tangent;
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (getLinePassKeepLinePoint(trajectories, keepLinePoints, lineIdx, i)
+                    && computeLinePassTangent(positions, i, tangent)) {
+                numValidLinePoints++;
+            }
+        }
+        if (numValidLinePoints >= 2) {
+            lineRanges.lines[lineIdx].numLinePoints = numValidLinePoints;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    uint32_t linePointOffset = linePointBase;
+    uint32_t segmentOffset = segmentBase;
+    for (LinePassLineRange& lineRange : lineRanges.lines) {
+        lineRange.linePointOffset = linePointOffset;
+        lineRange.segmentOffset = segmentOffset;
+        linePointOffset += lineRange.numLinePoints;
+        if (lineRange.numLinePoints > 0) {
+            segmentOffset += lineRange.numLinePoints - 1;
+        }
+    }
+    lineRanges.numLinePoints = linePointOffset - linePointBase;
+    lineRanges.numSegments = segmentOffset - segmentBase;
+}
+
+/**
+ * Phase 2: Computes the tangents and normals of all valid line points and calls
+ * writeLinePoint(lineIdx, pointIdx, linePointIdx, lineRange, normal, tangent) for each of them in parallel.
+ * linePointIdx is the index of the point in the output arrays.
+ * @param bandRightVectorsList If not nullptr, the normals are computed from these band/ribbon directions. Otherwise,
+ * a rotation minimizing frame is approximated by iteratively constructing normals using Gram-Schmidt.
+ */
+template<class LinePointWriter>
+void generateLinePassLinePoints(
+        const TrajectoryStore& trajectories, const LinePassLineRanges& lineRanges,
+        const std::vector<std::vector<glm::vec3>>* bandRightVectorsList, const LinePointWriter& writeLinePoint) {
+    forEachLinePassLine(lineRanges, [&](size_t lineIdx, const LinePassLineRange& lineRange) {
+        TrajectorySpan<const glm::vec3> positions = trajectories[lineIdx].positions;
+        glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
+        uint32_t linePointIdx = lineRange.linePointOffset;
+        for (size_t i = 0; i < positions.size(); i++) {
+            glm::vec3 tangent, normal;
+            if (!getLinePassKeepLinePoint(trajectories, lineRanges.keepLinePoints, lineIdx, i)
+                    || !computeLinePassTangent(positions, i, tangent)) {
+                continue;
+            }
+            tangent = glm::normalize(tangent);
+            if (bandRightVectorsList) {
+                normal = glm::cross(bandRightVectorsList->at(lineIdx).at(i), tangent);
+            } else {
+                normal = computeLinePassNormal(tangent, lastLineNormal);
+            }
+            writeLinePoint(lineIdx, i, linePointIdx, lineRange, normal, tangent);
+            linePointIdx++;
+        }
+    });
+}
+
+#endif //LINEVIS_LINEPASSGENERATOR_HPP
@@ -215,6 +215,9 @@ struct HullTriangleRenderData {
 
 struct TubeTriangleSplitData {
     std::vector<uint32_t> numBatchIndices;
+    // Bounds of the vertices of the triangles of each batch (min > max for empty batches).
+    std::vector<glm::vec3> batchAabbMin;
+    std::vector<glm::vec3> batchAabbMax;
 };
 
 /**
@@ -234,6 +237,8 @@ public:
     [[nodiscard]] virtual bool settingsEqual(TubeTriangleRenderDataPayload* other) const {
         return this->getType() == other->getType();
     }
+    /// Returns the size of the GPU data of the payload (used for the memory budget of the render data cache).
+    [[nodiscard]] virtual size_t getSizeInBytes() const { return 0; }
 
     /**
      * This function is called before uploading the triangle mesh to the GPU.
@@ -0,0 +1,198 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <utility>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "LineSimplification.hpp"
+
+namespace {
+
+/**
+ * Calls functor(lineIdx) in parallel for all lines.
+ */
+template<class Functor>
+void parallelForLines(size_t numLines, const Functor& functor) {
+    auto numLinesInt = int(numLines);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numLinesInt), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#pragma omp parallel for default(none) shared(numLinesInt, functor) schedule(dynamic, 64)
+    for (int lineIdx = 0; lineIdx < numLinesInt; lineIdx++) {
+#endif
+        functor(size_t(lineIdx));
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+/// Error relative to the passed threshold; a value > 1 means the threshold is exceeded.
+inline float getRelativeError(float error, float maxError) {
+    return error / std::max(maxError, std::numeric_limits<float>::min());
+}
+
+/**
+ * Marks the points of one line that are kept by the Douglas-Peucker algorithm.
+ * @return The number of kept points.
+ */
+uint32_t simplifyLine(
+        const TrajectoryView& trajectory, const LineSimplificationSettings& settings, uint8_t* keepLinePoints) {
+    const TrajectorySpan<const glm::vec3>& positions = trajectory.positions;
+    const auto numPoints = uint32_t(positions.size());
+    if (numPoints <= 2) {
+        std::fill(keepLinePoints, keepLinePoints + numPoints, uint8_t(1));
+        return numPoints;
+    }
+    std::fill(keepLinePoints, keepLinePoints + numPoints, uint8_t(0));
+    keepLinePoints[0] = 1;
+    keepLinePoints[numPoints - 1] = 1;
+    uint32_t numKeptPoints = 2;
+
+    const size_t numAttributes = settings.attributeIndices.size();
+    std::vector<TrajectorySpan<const float>> attributes(numAttributes);
+    for (size_t i = 0; i < numAttributes; i++) {
+        attributes[i] = trajectory.attributes.at(settings.attributeIndices[i]);
+    }
+
+    // The attributes are interpolated by arc length.
+    std::vector<float> arcLengths;
+    if (numAttributes > 0) {
+        arcLengths.resize(numPoints);
+        arcLengths[0] = 0.0f;
+        for (uint32_t i = 1; i < numPoints; i++) {
+            arcLengths[i] = arcLengths[i - 1] + glm::length(positions[i] - positions[i - 1]);
+        }
+    }
+
+    // Iterative instead of recursive, as lines can have hundreds of thousands of points.
+    std::vector<std::pair<uint32_t, uint32_t>> rangeStack;
+    rangeStack.emplace_back(0, numPoints - 1);
+    while (!rangeStack.empty()) {
+        auto [startIdx, endIdx] = rangeStack.back();
+        rangeStack.pop_back();
+        if (endIdx - startIdx < 2) {
+            continue;
+        }
+
+        const glm::vec3& startPoint = positions[startIdx];
+        glm::vec3 segment = positions[endIdx] - startPoint;
+        float segmentLengthSq = glm::dot(segment, segment);
+        float arcLengthStart = numAttributes > 0 ? arcLengths[startIdx] : 0.0f;
+        float arcLength = numAttributes > 0 ? arcLengths[endIdx] - arcLengthStart : 0.0f;
+
+        float maxRelativeError = 0.0f;
+        uint32_t maxErrorIdx = startIdx;
+        for (uint32_t i = startIdx + 1; i < endIdx; i++) {
+            glm::vec3 diff = positions[i] - startPoint;
+            if (segmentLengthSq > 0.0f) {
+                float t = std::clamp(glm::dot(diff, segment) / segmentLengthSq, 0.0f, 1.0f);
+                diff -= t * segment;
+            }
+            float relativeError = getRelativeError(glm::length(diff), settings.maxPositionError);
+
+            if (numAttributes > 0) {
+                float w = arcLength > 0.0f ? (arcLengths[i] - arcLengthStart) / arcLength : 0.5f;
+                for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+                    const TrajectorySpan<const float>& values = attributes[attrIdx];
+                    float interpolatedValue = values[startIdx] + w * (values[endIdx] - values[startIdx]);
+                    relativeError = std::max(relativeError, getRelativeError(
+                            std::abs(values[i] - interpolatedValue), settings.maxAttributeErrors[attrIdx]));
+                }
+            }
+
+            if (relativeError > maxRelativeError) {
+                maxRelativeError = relativeError;
+                maxErrorIdx = i;
+            }
+        }
+
+        if (maxRelativeError > 1.0f) {
+            keepLinePoints[maxErrorIdx] = 1;
+            numKeptPoints++;
+            rangeStack.emplace_back(startIdx, maxErrorIdx);
+            rangeStack.emplace_back(maxErrorIdx, endIdx);
+        }
+    }
+
+    return numKeptPoints;
+}
+
+}
+
+void simplifyLines(
+        const TrajectoryStore& trajectories, const LineSimplificationSettings& settings,
+        SimplifiedLines& simplifiedLines) {
+    const size_t numLines = trajectories.size();
+    const std::vector<uint64_t>& trajectoryLineOffsets = trajectories.getLineOffsets();
+    simplifiedLines.keepLinePoints.resize(trajectories.getNumLinePoints());
+    simplifiedLines.lineOffsets.resize(numLines + 1);
+
+    // Pass 1: Mark the kept points and count them.
+    std::vector<uint32_t> lineNumKeptPoints(numLines);
+    parallelForLines(numLines, [&](size_t lineIdx) {
+        lineNumKeptPoints[lineIdx] = simplifyLine(
+                trajectories[lineIdx], settings,
+                simplifiedLines.keepLinePoints.data() + trajectoryLineOffsets[lineIdx]);
+    });
+
+    simplifiedLines.numLinePointsIn = trajectories.getNumLinePoints();
+    simplifiedLines.numLineSegmentsIn = 0;
+    simplifiedLines.numLineSegmentsOut = 0;
+    uint64_t offset = 0;
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        simplifiedLines.lineOffsets[lineIdx] = offset;
+        offset += lineNumKeptPoints[lineIdx];
+        size_t numPointsIn = trajectories.getLineNumPoints(lineIdx);
+        simplifiedLines.numLineSegmentsIn += numPointsIn > 0 ? numPointsIn - 1 : 0;
+        simplifiedLines.numLineSegmentsOut += lineNumKeptPoints[lineIdx] > 0 ? lineNumKeptPoints[lineIdx] - 1 : 0;
+    }
+    simplifiedLines.lineOffsets[numLines] = offset;
+    simplifiedLines.numLinePointsOut = size_t(offset);
+
+    // Pass 2: Write the indices of the kept points.
+    simplifiedLines.linePointIndices.resize(size_t(offset));
+    parallelForLines(numLines, [&](size_t lineIdx) {
+        const uint8_t* keepLinePoints = simplifiedLines.keepLinePoints.data() + trajectoryLineOffsets[lineIdx];
+        uint32_t* linePointIndices = simplifiedLines.linePointIndices.data() + simplifiedLines.lineOffsets[lineIdx];
+        auto numPoints = uint32_t(trajectories.getLineNumPoints(lineIdx));
+        for (uint32_t i = 0; i < numPoints; i++) {
+            if (keepLinePoints[i]) {
+                *(linePointIndices++) = i;
+            }
+        }
+    });
+}
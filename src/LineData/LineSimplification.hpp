@@ -0,0 +1,90 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_LINESIMPLIFICATION_HPP
+#define LINEVIS_LINESIMPLIFICATION_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "Loaders/TrajectoryStore.hpp"
+
+/*
+ * Error-bounded line simplification used before meshing oversampled lines (e.g., streamlines traced with small time
+ * steps). Each line is simplified independently with the Douglas-Peucker algorithm: A point is removed if its distance
+ * to the segment between the neighboring kept points and the error of the linearly interpolated attribute values
+ * (interpolated by arc length) stay below the passed thresholds. The first and last point of a line are always kept.
+ * The lines are simplified in parallel.
+ */
+
+struct LineSimplificationSettings {
+    float maxPositionError = 0.0f; ///< Max. world space distance of a removed point to the simplified line.
+    std::vector<uint32_t> attributeIndices; ///< The attributes whose interpolation error is bounded.
+    std::vector<float> maxAttributeErrors; ///< Max. absolute error of each attribute in attributeIndices.
+
+    bool operator==(const LineSimplificationSettings& rhs) const {
+        return maxPositionError == rhs.maxPositionError && attributeIndices == rhs.attributeIndices
+                && maxAttributeErrors == rhs.maxAttributeErrors;
+    }
+    bool operator!=(const LineSimplificationSettings& rhs) const { return !(*this == rhs); }
+};
+
+struct SimplifiedLines {
+    /// One entry per line point of the trajectory store; 1 if the point is kept, 0 if it was removed.
+    std::vector<uint8_t> keepLinePoints;
+    /// Offset of the kept points of each line in linePointIndices (size: number of lines + 1).
+    std::vector<uint64_t> lineOffsets;
+    /// The indices of the kept points within their line.
+    std::vector<uint32_t> linePointIndices;
+
+    // Statistics.
+    size_t numLinePointsIn = 0;
+    size_t numLinePointsOut = 0;
+    size_t numLineSegmentsIn = 0;
+    size_t numLineSegmentsOut = 0;
+
+    /// Returns the index of a point of a simplified line in the original line.
+    [[nodiscard]] inline uint32_t getLinePointIndex(size_t lineIdx, size_t simplifiedLinePointIdx) const {
+        return linePointIndices[lineOffsets[lineIdx] + simplifiedLinePointIdx];
+    }
+    [[nodiscard]] inline size_t getLineNumPoints(size_t lineIdx) const {
+        return size_t(lineOffsets[lineIdx + 1] - lineOffsets[lineIdx]);
+    }
+};
+
+/**
+ * Simplifies all lines of the passed trajectory store in parallel.
+ * @param trajectories The lines.
+ * @param settings The error thresholds.
+ * @param simplifiedLines The kept points and the statistics.
+ */
+void simplifyLines(
+        const TrajectoryStore& trajectories, const LineSimplificationSettings& settings,
+        SimplifiedLines& simplifiedLines);
+
+#endif //LINEVIS_LINESIMPLIFICATION_HPP
@@ -0,0 +1,159 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Graphics/Vulkan/Buffers/Buffer.hpp>
+
+#include "RenderDataCache.hpp"
+
+bool RenderDataCacheKey::satisfies(const RenderDataCacheKey& request) const {
+    if (requestMode != request.requestMode || tubeNumSubdivisions != request.tubeNumSubdivisions
+            || vulkanRayTracing != request.vulkanRayTracing || ellipticTubes != request.ellipticTubes) {
+        return false;
+    }
+    if (request.payload) {
+        return payload && request.payload->settingsEqual(payload.get());
+    }
+    return true;
+}
+
+static size_t getBufferSizeInBytes(const sgl::vk::BufferPtr& buffer) {
+    return buffer ? buffer->getSizeInBytes() : 0;
+}
+
+size_t computeRenderDataCacheEntrySize(const RenderDataCacheEntry& entry) {
+    size_t sizeInBytes = 0;
+
+    const TubeTriangleRenderData& triangles = entry.tubeTriangleRenderData;
+    sizeInBytes += getBufferSizeInBytes(triangles.indexBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.vertexBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.linePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.stressLinePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.stressLinePointPrincipalStressDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.multiVarAttributeDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(triangles.instanceTriangleIndexOffsetBuffer);
+    if (entry.key.payload) {
+        sizeInBytes += entry.key.payload->getSizeInBytes();
+    }
+
+    const TubeAabbRenderData& aabbs = entry.tubeAabbRenderData;
+    sizeInBytes += getBufferSizeInBytes(aabbs.indexBuffer);
+    sizeInBytes += getBufferSizeInBytes(aabbs.aabbBuffer);
+    sizeInBytes += getBufferSizeInBytes(aabbs.linePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(aabbs.stressLinePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(aabbs.stressLinePointPrincipalStressDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(aabbs.multiVarAttributeDataBuffer);
+
+    const LinePassTubeRenderData& geometryShader = entry.renderDataGeometryShader;
+    sizeInBytes += getBufferSizeInBytes(geometryShader.indexBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexPositionBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexAttributeBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexNormalBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexTangentBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexRotationBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.multiVarAttributeDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexPrincipalStressIndexBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexLineHierarchyLevelBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexLineAppearanceOrderBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexMajorStressBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexMediumStressBuffer);
+    sizeInBytes += getBufferSizeInBytes(geometryShader.vertexMinorStressBuffer);
+
+    const LinePassTubeRenderDataProgrammablePull& programmablePull = entry.renderDataProgrammablePull;
+    sizeInBytes += getBufferSizeInBytes(programmablePull.indexBuffer);
+    sizeInBytes += getBufferSizeInBytes(programmablePull.linePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(programmablePull.stressLinePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(programmablePull.stressLinePointPrincipalStressDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(programmablePull.multiVarAttributeDataBuffer);
+
+    const LinePassTubeRenderDataMeshShader& meshShader = entry.renderDataMeshShader;
+    sizeInBytes += getBufferSizeInBytes(meshShader.meshletDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(meshShader.linePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(meshShader.stressLinePointDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(meshShader.stressLinePointPrincipalStressDataBuffer);
+    sizeInBytes += getBufferSizeInBytes(meshShader.multiVarAttributeDataBuffer);
+
+    return sizeInBytes;
+}
+
+void RenderDataCache::setBudgetInBytes(size_t _budgetInBytes) {
+    budgetInBytes = _budgetInBytes;
+    evictToBudget();
+}
+
+void RenderDataCache::insert(RenderDataCacheEntry&& entry) {
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->key.satisfies(entry.key) && entry.key.satisfies(it->key)) {
+            usedSizeInBytes -= it->sizeInBytes;
+            it = entries.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (entry.sizeInBytes > budgetInBytes) {
+        return;
+    }
+    usedSizeInBytes += entry.sizeInBytes;
+    entries.push_front(std::move(entry));
+    evictToBudget();
+}
+
+bool RenderDataCache::take(const RenderDataCacheKey& request, RenderDataCacheEntry& entry) {
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        if (it->key.satisfies(request)) {
+            usedSizeInBytes -= it->sizeInBytes;
+            entry = std::move(*it);
+            entries.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RenderDataCache::remove(RenderDataRequestMode requestMode) {
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->key.requestMode == requestMode) {
+            usedSizeInBytes -= it->sizeInBytes;
+            it = entries.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void RenderDataCache::clear() {
+    entries.clear();
+    usedSizeInBytes = 0;
+}
+
+void RenderDataCache::evictToBudget() {
+    while (usedSizeInBytes > budgetInBytes && !entries.empty()) {
+        usedSizeInBytes -= entries.back().sizeInBytes;
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LINEVIS_RENDERDATACACHE_HPP
+#define LINEVIS_RENDERDATACACHE_HPP
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "LineRenderData.hpp"
+
+namespace sgl { namespace vk {
+class BottomLevelAccelerationStructure;
+typedef std::shared_ptr<BottomLevelAccelerationStructure> BottomLevelAccelerationStructurePtr;
+class TopLevelAccelerationStructure;
+typedef std::shared_ptr<TopLevelAccelerationStructure> TopLevelAccelerationStructurePtr;
+}}
+
+/// The different GPU representations LineData can generate for the renderers.
+enum class RenderDataRequestMode {
+    NO_CACHE_SUPPORTED, TRIANGLES, AABBS, GEOMETRY_SHADER, PROGRAMMABLE_PULL, MESH_SHADER
+};
+
+/**
+ * The settings a cached representation was generated with. Settings that invalidate all representations at once
+ * (e.g., the filter state or the line width) are not part of the key; in that case, the cache is cleared.
+ */
+struct RenderDataCacheKey {
+    RenderDataRequestMode requestMode = RenderDataRequestMode::NO_CACHE_SUPPORTED;
+    int tubeNumSubdivisions = 0; ///< Only for TRIANGLES, PROGRAMMABLE_PULL and MESH_SHADER.
+    bool vulkanRayTracing = false; ///< Only for TRIANGLES.
+    bool ellipticTubes = false; ///< Only for AABBS.
+    TubeTriangleRenderDataPayloadPtr payload; ///< Only for TRIANGLES; compared using settingsEqual.
+
+    /// Returns whether data generated with the settings of this key can be used for the passed request.
+    [[nodiscard]] bool satisfies(const RenderDataCacheKey& request) const;
+};
+
+/// A cached representation. Only the members belonging to key.requestMode are used.
+struct RenderDataCacheEntry {
+    RenderDataCacheKey key;
+    size_t sizeInBytes = 0;
+
+    // RenderDataRequestMode::TRIANGLES.
+    TubeTriangleRenderData tubeTriangleRenderData;
+    TubeTriangleSplitData tubeTriangleSplitData;
+    std::vector<sgl::vk::BottomLevelAccelerationStructurePtr> tubeTriangleBottomLevelASes;
+    sgl::vk::TopLevelAccelerationStructurePtr tubeTriangleTopLevelAS;
+    sgl::vk::TopLevelAccelerationStructurePtr tubeTriangleAndHullTopLevelAS;
+
+    // RenderDataRequestMode::AABBS.
+    TubeAabbRenderData tubeAabbRenderData;
+    sgl::vk::BottomLevelAccelerationStructurePtr tubeAabbBottomLevelAS;
+    sgl::vk::TopLevelAccelerationStructurePtr tubeAabbTopLevelAS;
+    sgl::vk::TopLevelAccelerationStructurePtr tubeAabbAndHullTopLevelAS;
+
+    // RenderDataRequestMode::GEOMETRY_SHADER, PROGRAMMABLE_PULL and MESH_SHADER.
+    LinePassTubeRenderData renderDataGeometryShader;
+    LinePassTubeRenderDataProgrammablePull renderDataProgrammablePull;
+    LinePassTubeRenderDataMeshShader renderDataMeshShader;
+};
+
+/// Returns the GPU memory used by the buffers and the payload of the entry (acceleration structures are not counted).
+size_t computeRenderDataCacheEntrySize(const RenderDataCacheEntry& entry);
+
+/**
+ * Keeps the representations LineData generated for renderers that are currently not active, e.g., the triangle mesh
+ * of a ray tracer in one view while an opaque renderer in another view requested programmable pull data. This way,
+ * switching back to a representation does not need to rebuild it. If the total size of the entries exceeds the
+ * budget, the least recently used entries are evicted.
+ */
+class RenderDataCache {
+public:
+    explicit RenderDataCache(size_t budgetInBytes = size_t(1024) * 1024 * 1024) : budgetInBytes(budgetInBytes) {}
+
+    /// Evicts the least recently used entries if the used memory exceeds the new budget.
+    void setBudgetInBytes(size_t _budgetInBytes);
+    [[nodiscard]] inline size_t getBudgetInBytes() const { return budgetInBytes; }
+    [[nodiscard]] inline size_t getUsedSizeInBytes() const { return usedSizeInBytes; }
+    [[nodiscard]] inline size_t getNumEntries() const { return entries.size(); }
+    /// Entries sorted from most recently to least recently used.
+    [[nodiscard]] inline const std::list<RenderDataCacheEntry>& getEntries() const { return entries; }
+
+    /**
+     * Adds an entry (with entry.sizeInBytes already set) as the most recently used one. Entries with the same key are
+     * replaced. Entries larger than the budget are not stored.
+     */
+    void insert(RenderDataCacheEntry&& entry);
+    /**
+     * Removes the most recently used entry satisfying the request from the cache.
+     * @return True if an entry was found and moved to entry.
+     */
+    bool take(const RenderDataCacheKey& request, RenderDataCacheEntry& entry);
+    /// Removes all entries of the passed request mode.
+    void remove(RenderDataRequestMode requestMode);
+    void clear();
+
+private:
+    void evictToBudget();
+
+    std::list<RenderDataCacheEntry> entries; ///< Front: Most recently used entry.
+    size_t budgetInBytes;
+    size_t usedSizeInBytes = 0;
+};
+
+#endif //LINEVIS_RENDERDATACACHE_HPP
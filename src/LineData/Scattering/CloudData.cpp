@@ -491,8 +491,7 @@ void CloudData::computeSparseGridMetadata() {
 
 bool CloudData::loadFromNvdbFile(const std::string& filename) {
     //sparseGridHandle = nanovdb::io::readGrid<nanovdb::HostBuffer>(filename, gridName);
-    sparseGridHandle = nanovdb::io::readGrid<nanovdb::HostBuffer>(filename, 0);
-    computeSparseGridMetadata();
+    setNanoVdbGridHandle(nanovdb::io::readGrid<nanovdb::HostBuffer>(filename, 0));
     return !sparseGridHandle.empty();
 }
 
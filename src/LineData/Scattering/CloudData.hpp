@@ -63,6 +63,9 @@ public:
     [[nodiscard]] inline uint32_t getGridSizeX() const { return gridSizeX; }
     [[nodiscard]] inline uint32_t getGridSizeY() const { return gridSizeY; }
     [[nodiscard]] inline uint32_t getGridSizeZ() const { return gridSizeZ; }
+    [[nodiscard]] inline float getVoxelSizeX() const { return voxelSizeX; }
+    [[nodiscard]] inline float getVoxelSizeY() const { return voxelSizeY; }
+    [[nodiscard]] inline float getVoxelSizeZ() const { return voxelSizeZ; }
 
     [[nodiscard]] inline const glm::vec3& getWorldSpaceBoxMin() const { return boxMin; }
     [[nodiscard]] inline const glm::vec3& getWorldSpaceBoxMax() const { return boxMax; }
@@ -84,6 +87,8 @@ public:
      */
     void getSparseDensityField(uint8_t*& data, uint64_t& size);
     [[nodiscard]] inline bool hasSparseData() const { return !sparseGridHandle.empty(); }
+    /// @return The sparse float grid, or nullptr if no sparse field is loaded. It is not created from a dense field.
+    [[nodiscard]] inline const nanovdb::FloatGrid* getSparseGrid() const { return sparseGridHandle.grid<float>(); }
     inline void setCacheSparseGrid(bool cache) { cacheSparseGrid = true; }
 
 private:
@@ -0,0 +1,119 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "DensitySampler.hpp"
+
+typedef nanovdb::NanoLeaf<float> NanoVdbLeafNode;
+
+NanoVdbDensitySampler::NanoVdbDensitySampler(const nanovdb::FloatGrid& grid)
+        : accessor(grid.getAccessor()), background(grid.tree().background()), has_min_max(grid.hasMinMax()) {
+    const auto& index_bbox = grid.indexBBox();
+    index_min = index_bbox.min();
+    cell_origin = index_min & ~int32_t(NanoVdbLeafNode::MASK);
+    for (int a = 0; a < 3; a++) {
+        grid_size[a] = uint32_t(std::max(index_bbox.max()[a] - index_bbox.min()[a] + 1, 1));
+        // The voxel centers lie at the normalized coordinates i / (size - 1) (see Texture3D::sample_at).
+        auto cell_offset_voxels = float(index_min[a] - cell_origin[a]);
+        normalized_to_cell_scale[a] = float(grid_size[a] - 1) / float(NanoVdbLeafNode::DIM);
+        normalized_to_cell_offset[a] = cell_offset_voxels / float(NanoVdbLeafNode::DIM);
+        cell_count[a] = (index_min[a] - cell_origin[a] + int(grid_size[a]) - 1) / int(NanoVdbLeafNode::DIM) + 1;
+    }
+}
+
+inline float lerp_nanovdb(float a, float t, float b) {
+    return a * (1.0f - t) + b * t;
+}
+
+float NanoVdbDensitySampler::sample_at(glm::vec3 pos) const {
+    // Same arithmetic as Texture3D::sample_at, so that both backends return identical values for identical data.
+    float fw = pos.x * float(grid_size[0] - 1);
+    float fh = pos.y * float(grid_size[1] - 1);
+    float fd = pos.z * float(grid_size[2] - 1);
+
+    float tw = fw - (int)fw;
+    float th = fh - (int)fh;
+    float td = fd - (int)fd;
+
+    int32_t idx_w_left = index_min[0] + int32_t(std::floor(fw));
+    int32_t idx_h_low  = index_min[1] + int32_t(std::floor(fh));
+    int32_t idx_d_near = index_min[2] + int32_t(std::floor(fd));
+
+    int32_t idx_w_right = index_min[0] + int32_t(std::ceil(fw));
+    int32_t idx_h_high  = index_min[1] + int32_t(std::ceil(fh));
+    int32_t idx_d_far   = index_min[2] + int32_t(std::ceil(fd));
+
+    float left_low_near   = accessor.getValue(nanovdb::Coord(idx_w_left,  idx_h_low,  idx_d_near));
+    float left_low_far    = accessor.getValue(nanovdb::Coord(idx_w_left,  idx_h_low,  idx_d_far));
+    float left_high_near  = accessor.getValue(nanovdb::Coord(idx_w_left,  idx_h_high, idx_d_near));
+    float left_high_far   = accessor.getValue(nanovdb::Coord(idx_w_left,  idx_h_high, idx_d_far));
+    float right_low_near  = accessor.getValue(nanovdb::Coord(idx_w_right, idx_h_low,  idx_d_near));
+    float right_low_far   = accessor.getValue(nanovdb::Coord(idx_w_right, idx_h_low,  idx_d_far));
+    float right_high_near = accessor.getValue(nanovdb::Coord(idx_w_right, idx_h_high, idx_d_near));
+    float right_high_far  = accessor.getValue(nanovdb::Coord(idx_w_right, idx_h_high, idx_d_far));
+
+    float low_near = lerp_nanovdb(left_low_near, tw, right_low_near);
+    float low_far  = lerp_nanovdb(left_low_far,  tw, right_low_far);
+    float low      = lerp_nanovdb(low_near,      td, low_far);
+
+    float high_near = lerp_nanovdb(left_high_near, tw, right_high_near);
+    float high_far  = lerp_nanovdb(left_high_far,  tw, right_high_far);
+    float high      = lerp_nanovdb(high_near,      td, high_far);
+
+    return lerp_nanovdb(low, th, high);
+}
+
+float NanoVdbDensitySampler::get_node_maximum(const nanovdb::Coord& ijk) const {
+    const NanoVdbLeafNode* leaf = accessor.probeLeaf(ijk);
+    if (!leaf) {
+        // Tiles (and the background) have one constant value.
+        return accessor.getValue(ijk);
+    }
+    if (has_min_max) {
+        // The statistics only cover the active voxels; the inactive ones store the background value.
+        return std::max(leaf->maximum(), background);
+    }
+    float value_max = leaf->getValue(0u);
+    for (uint32_t i = 1; i < NanoVdbLeafNode::SIZE; i++) {
+        value_max = std::max(value_max, leaf->getValue(i));
+    }
+    return value_max;
+}
+
+float NanoVdbDensitySampler::max_density_at(int x, int y, int z) const {
+    const int dim = int(NanoVdbLeafNode::DIM);
+    nanovdb::Coord origin = cell_origin + nanovdb::Coord(x * dim, y * dim, z * dim);
+    float density_max = get_node_maximum(origin);
+    for (int i = 1; i < 8; i++) {
+        nanovdb::Coord neighbor = origin + nanovdb::Coord((i & 1) * dim, ((i >> 1) & 1) * dim, (i >> 2) * dim);
+        density_max = std::max(density_max, get_node_maximum(neighbor));
+    }
+    return density_max;
+}
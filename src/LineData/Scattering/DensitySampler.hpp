@@ -0,0 +1,113 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Renderers/Scattering/nanovdb/NanoVDB.h"
+#include "Texture3d.hpp"
+#include "MajorantGrid.hpp"
+
+/*
+ * Density sampling backends of the CPU scattering tracer (see dt_path_trace). A backend provides trilinear density
+ * lookups at normalized grid coordinates in [0, 1]^3 matching Texture3D::sample_at and, optionally, local majorants
+ * on a grid of cells used for the DDA-based free-flight sampling. The normalized coordinate pos lies in the cell
+ * floor(pos * get_normalized_to_cell_scale() + get_normalized_to_cell_offset()).
+ *
+ * Sampler objects are cheap to create and not thread-safe; every task tracing paths creates its own.
+ */
+
+/**
+ * Samples a dense Texture3D. The local majorants are taken from an optional MajorantGrid.
+ */
+class DenseDensitySampler {
+public:
+    DenseDensitySampler(const Texture3D& grid, const MajorantGrid* majorant_grid)
+            : grid(grid), majorant_grid(majorant_grid) {}
+
+    [[nodiscard]] inline uint32_t get_grid_size(int axis) const {
+        return axis == 0 ? grid.size_x : (axis == 1 ? grid.size_y : grid.size_z);
+    }
+    [[nodiscard]] inline float sample_at(glm::vec3 pos) const { return grid.sample_at(pos); }
+
+    [[nodiscard]] inline bool has_local_majorants() const { return majorant_grid != nullptr; }
+    [[nodiscard]] inline int get_cell_count(int axis) const {
+        return int(axis == 0 ? majorant_grid->size_x : (axis == 1 ? majorant_grid->size_y : majorant_grid->size_z));
+    }
+    [[nodiscard]] inline float get_normalized_to_cell_scale(int axis) const {
+        return majorant_grid->normalized_to_cell_scale[axis];
+    }
+    [[nodiscard]] inline float get_normalized_to_cell_offset(int /*axis*/) const { return 0.0f; }
+    [[nodiscard]] inline float max_density_at(int x, int y, int z) const {
+        return majorant_grid->max_density_at(uint32_t(x), uint32_t(y), uint32_t(z));
+    }
+
+private:
+    const Texture3D& grid;
+    const MajorantGrid* majorant_grid;
+};
+
+/**
+ * Samples a sparse NanoVDB float grid through a cached ReadAccessor, i.e., the volume never needs to be stored
+ * densely. Voxel (0, 0, 0) of the normalized coordinates is the minimum of the index bounding box of the grid.
+ *
+ * The local majorants are taken from the bounds of the tree nodes. The cells have the size of the leaf nodes
+ * (8^3 voxels). As the trilinear interpolation of cell c also reads the first voxel layer of the upper neighbors,
+ * the majorant of a cell is the maximum of the (leaf or tile) nodes containing c and its seven upper neighbors.
+ */
+class NanoVdbDensitySampler {
+public:
+    explicit NanoVdbDensitySampler(const nanovdb::FloatGrid& grid);
+
+    [[nodiscard]] inline uint32_t get_grid_size(int axis) const { return grid_size[axis]; }
+    [[nodiscard]] float sample_at(glm::vec3 pos) const;
+
+    [[nodiscard]] inline bool has_local_majorants() const { return true; }
+    [[nodiscard]] inline int get_cell_count(int axis) const { return cell_count[axis]; }
+    [[nodiscard]] inline float get_normalized_to_cell_scale(int axis) const {
+        return normalized_to_cell_scale[axis];
+    }
+    [[nodiscard]] inline float get_normalized_to_cell_offset(int axis) const {
+        return normalized_to_cell_offset[axis];
+    }
+    [[nodiscard]] float max_density_at(int x, int y, int z) const;
+
+private:
+    /// Returns the maximum value of the leaf node or tile containing ijk.
+    [[nodiscard]] float get_node_maximum(const nanovdb::Coord& ijk) const;
+
+    nanovdb::FloatGrid::AccessorType accessor;
+    nanovdb::Coord index_min; ///< Index of the voxel at the normalized coordinates (0, 0, 0).
+    nanovdb::Coord cell_origin; ///< Index of the first voxel of cell (0, 0, 0); aligned to the leaf nodes.
+    uint32_t grid_size[3] = {};
+    int cell_count[3] = {};
+    float normalized_to_cell_scale[3] = {};
+    float normalized_to_cell_offset[3] = {};
+    float background;
+    bool has_min_max; ///< Whether the nodes store their value range. Otherwise, the leaf values are scanned.
+};
@@ -30,9 +30,14 @@
 #include <variant>
 #include <cstdint>
 #include <cmath>
+#include <iterator>
+#include <algorithm>
+#include <limits>
 
-#include <Utils/Defer.hpp>
-#include <Utils/SearchStructures/KdTree.hpp>
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
 
 #include "DtPathTrace.hpp"
 
@@ -81,149 +86,34 @@ inline uint32_t min(uint32_t a, uint32_t b) {
 }
 
 
-Image create_spherical_heatmap_image(sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height) {
-    const float search_radius = 0.1f;
-    const float rbf_epsilon = 3.0f;
-
-
-    Image out_image;
-    out_image.width  = image_height * 2;
-    out_image.height = image_height;
-    out_image.allocate();
-
-    const float sqrt_two     = std::sqrt(2.0f);
-    const float two_sqrt_two = 2.0f * sqrt_two;
-
-    assert(out_image.width > 0);
-    assert(out_image.height > 0);
-
-    std::vector<std::pair<glm::vec3, sgl::Empty>> searchCache;
-    float max_rbf_value = 0.0f;
-
-    for (uint32_t y = 0; y < out_image.height; ++y) {
-        for (uint32_t x = 0; x < out_image.width; ++x) {
-            float u = -1.0f + (1.0f * x / (out_image.width - 1)) * 2.0f; // from   -1 to 1
-            float v = -0.5f + (1.0f * y / (out_image.height - 1));       // from -0.5 to 0.5
-
-            Pixel* p = &out_image.pixels[y*out_image.width+x];
-
-            if (glm::length(glm::vec2(u, 2*v)) <= 1) {
-                // we are in the ellipse
-                float x_inner = two_sqrt_two * u;
-                float y_inner = two_sqrt_two * v;
-
-                float z = float(std::sqrt(1 - std::pow(x_inner / 4, 2) - std::pow(y_inner / 2, 2)));
-
-                float lambda = float(2 * std::atan((z * x_inner) / (2 * (2 * std::pow(z, 2) - 1)))); // from -pi to pi
-                float phi    = std::asin(z * y_inner);                                               // from -pi/2 to pi/2
-
-                const glm::vec4 X = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
-                const glm::vec3 Y = glm::vec3(0.0f, 1.0f, 0.0f);
-                const glm::vec3 Z = glm::vec3(0.0f, 0.0f, 1.0f);
-
-                glm::vec3 point_on_sphere =
-                    glm::rotate(lambda,  Y) *
-                    glm::rotate(phi,     Z) *
-                    X;
-
-
-                searchCache.clear();
-                kd_tree->findPointsAndDataInSphere(point_on_sphere, search_radius, searchCache);
-
-                p->f32 = 0.0f;
-
-                for (std::pair<glm::vec3, sgl::Empty>& hit : searchCache) {
-                    glm::vec3 pos = hit.first;
-
-                    float dist = glm::length(point_on_sphere - pos);
-
-                    float rbf_param = dist / search_radius;
-
-                    p->f32 += (float)std::exp(-(float)std::pow(rbf_epsilon * rbf_param,2));
-                }
-
-                // auto num_hits = kd_tree->getNumPointsInSphere(point_on_sphere, 0.025f, searchCache);
-
-                max_rbf_value = std::max(p->f32, max_rbf_value);
-            } else {
-                // we are outside the ellipse
-                p->f32 = -1.0f;
-            }
-        }
-    }
-
-    for (uint32_t y = 0; y < out_image.height; ++y) {
-        for (uint32_t x = 0; x < out_image.width; ++x) {
-            Pixel* p = &out_image.pixels[y*out_image.width+x];
-            if (p->f32 == -1.0f) {
-                p->r = 0;
-                p->g = 0;
-                p->b = 0;
-                p->a = 0;
-            } else {
-                auto rbf_value = p->f32;
-                sgl::Color result;
-                // NOTE(Felix): poor man's transfer function
-                if (rbf_value < max_rbf_value/2) {
-                    // blue to green gradient
-                    result = sgl::colorLerp({0,0,255,255}, {0,255,0,255}, 2.0f*rbf_value/max_rbf_value);
-                } else {
-                    // green to red gradient
-                    result = sgl::colorLerp({0,255,0,255}, {255,0,0,255}, 2.0f*rbf_value/max_rbf_value-1.0f);
-                }
-                p->r = result.getR();
-                p->g = result.getG();
-                p->b = result.getB();
-                p->a = 255;
-            }
-        }
-    }
-
-    return out_image;
-}
-
-namespace Random {
-    static struct {
-        uint32_t x;
-        uint32_t y;
-        uint32_t z;
-        uint32_t w;
-    } RNG_STATE;
-
-
-    uint32_t taus_step(uint32_t z, int S1, int S2, int S3, uint32_t M) {
-        uint32_t b = (((z << S1) ^ z) >> S2);
-        return ((z & M) << S3) ^ b;
+void PathRng::generate_block() {
+    const uint32_t M0 = 0xD2511F53u;
+    const uint32_t M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u;
+    const uint32_t W1 = 0xBB67AE85u;
+
+    uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+    uint32_t k[2] = { key[0], key[1] };
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = uint64_t(M0) * uint64_t(c[0]);
+        uint64_t p1 = uint64_t(M1) * uint64_t(c[2]);
+        uint32_t hi0 = uint32_t(p0 >> 32), lo0 = uint32_t(p0);
+        uint32_t hi1 = uint32_t(p1 >> 32), lo1 = uint32_t(p1);
+        c[0] = hi1 ^ c[1] ^ k[0];
+        c[1] = lo1;
+        c[2] = hi0 ^ c[3] ^ k[1];
+        c[3] = lo0;
+        k[0] += W0;
+        k[1] += W1;
     }
-
-    uint32_t lcg_step(uint32_t z, uint32_t A, uint32_t C) {
-        return A * z + C;
+    for (int i = 0; i < 4; i++) {
+        buffer[i] = c[i];
     }
 
-    float hybrid_taus() {
-        RNG_STATE.x = taus_step(RNG_STATE.x, 13, 19, 12, 4294967294);
-        RNG_STATE.y = taus_step(RNG_STATE.y, 2, 25, 4, 4294967288);
-        RNG_STATE.z = taus_step(RNG_STATE.z, 3, 11, 17, 4294967280);
-        RNG_STATE.w = lcg_step(RNG_STATE.w, 1664525, 1013904223);
-
-        return float(2.3283064365387e-10 * (RNG_STATE.x ^ RNG_STATE.y ^ RNG_STATE.z ^ RNG_STATE.w));
-    }
-
-    float random() {
-        return hybrid_taus();
+    // Advance the 64-bit block counter.
+    if (++counter[0] == 0) {
+        counter[1]++;
     }
-
-    void init(uint32_t seed) {
-
-        RNG_STATE.x = seed;
-        RNG_STATE.y = seed;
-        RNG_STATE.z = seed;
-        RNG_STATE.w = seed;
-
-        for (uint32_t i = 0; i < 23 + seed % 13; i++)
-            random();
-    }
-
 }
 
 void create_orthonormal_basis(glm::vec3 D, glm::vec3& B, glm::vec3& T) {
@@ -246,9 +136,9 @@ void create_orthonormal_basis2(glm::vec3 D, glm::vec3& B, glm::vec3& T) {
     T = glm::normalize(glm::cross(D, B));
 }
 
-glm::vec3 random_direction(glm::vec3 D) {
-    float r1 = Random::random();
-    float r2 = Random::random() * 2 - 1;
+glm::vec3 random_direction(glm::vec3 D, PathRng& rng) {
+    float r1 = rng.random();
+    float r2 = rng.random() * 2 - 1;
     float sqrR2 = r2 * r2;
     float two_pi_by_r1 = two_pi * r1;
     float sqrt_of_one_minus_sqrR2 = std::sqrt(1.0f - sqrR2);
@@ -275,13 +165,13 @@ float invert_cdf(float g_factor, float xi) {
 #undef one_over_2g
 }
 
-glm::vec3 importance_sample_phase(float g_factor, glm::vec3 D) {
+glm::vec3 importance_sample_phase(float g_factor, glm::vec3 D, PathRng& rng) {
     if (std::fabs(g_factor) < 0.001f) {
-        return random_direction(-D);
+        return random_direction(-D, rng);
     }
 
-    float phi = Random::random() * 2 * pi;
-    float cosTheta = invert_cdf(g_factor, Random::random());
+    float phi = rng.random() * 2 * pi;
+    float cosTheta = invert_cdf(g_factor, rng.random());
     float sinTheta = std::sqrt(max(0.0f, 1.0f - cosTheta * cosTheta));
 
     glm::vec3 t0, t1;
@@ -292,12 +182,12 @@ glm::vec3 importance_sample_phase(float g_factor, glm::vec3 D) {
          + cosTheta * D;
 }
 
-void get_grid_box(Texture3D grid, glm::vec3& minim, glm::vec3& maxim) {
-    float maxDim = max(float(grid.size_x), float(grid.size_y), float(grid.size_z));
+void get_grid_box(uint32_t size_x, uint32_t size_y, uint32_t size_z, glm::vec3& minim, glm::vec3& maxim) {
+    float maxDim = max(float(size_x), float(size_y), float(size_z));
     maxim = glm::vec3{
-        (float)grid.size_x,
-        (float)grid.size_y,
-        (float)grid.size_z
+        (float)size_x,
+        (float)size_y,
+        (float)size_z
     } / maxDim * 0.25f;
     minim = -maxim;
 }
@@ -381,8 +271,72 @@ bool box_intersect(glm::vec3 b_min, glm::vec3 b_max, glm::vec3 P,
 //     return result;
 // }
 
-void dt_path_trace(PathInfo path_info, VolumeInfo volume_info,
-                   Trajectories* trajis, Exit_Directions* exit_dirs)
+/**
+ * Samples the next collision along the ray x + t * w with t in [0, d) against the local majorants by stepping through
+ * the majorant cells of the density sampler with a 3D DDA. The optical depth to the next collision is sampled once and
+ * consumed cell by cell, so empty cells are skipped without any density lookups.
+ * @return False if the ray leaves the volume before the next collision. Otherwise, t is the distance to the collision
+ * and majorant the majorant extinction coefficient at the collision.
+ */
+template<class DensitySampler>
+bool sample_collision_local_majorants(
+        const DensitySampler& sampler, glm::vec3 b_min, glm::vec3 b_max, glm::vec3 x, glm::vec3 w, float d,
+        float density, PathRng& rng, float& t, float& majorant)
+{
+    int cell_counts[3] = { sampler.get_cell_count(0), sampler.get_cell_count(1), sampler.get_cell_count(2) };
+    int cell[3], step[3];
+    float t_next[3], t_delta[3];
+    for (int a = 0; a < 3; a++) {
+        float scale = sampler.get_normalized_to_cell_scale(a) / (b_max[a] - b_min[a]);
+        float cell_coord = (x[a] - b_min[a]) * scale + sampler.get_normalized_to_cell_offset(a);
+        cell[a] = std::clamp(int(std::floor(cell_coord)), 0, cell_counts[a] - 1);
+        float w_cell = w[a] * scale;
+        if (w_cell > 0.0f) {
+            step[a] = 1;
+            t_delta[a] = 1.0f / w_cell;
+            t_next[a] = (float(cell[a] + 1) - cell_coord) * t_delta[a];
+        } else if (w_cell < 0.0f) {
+            step[a] = -1;
+            t_delta[a] = -1.0f / w_cell;
+            t_next[a] = (cell_coord - float(cell[a])) * t_delta[a];
+        } else {
+            step[a] = 0;
+            t_delta[a] = std::numeric_limits<float>::infinity();
+            t_next[a] = t_delta[a];
+        }
+    }
+
+    float tau = -std::log(std::max(0.00000000001f, 1.0f - rng.random())); // optical depth to the next collision
+    float t_cell_start = 0.0f;
+    while (true) {
+        int axis = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+        float t_cell_end = max(min(t_next[axis], d), t_cell_start);
+        float mu = density * sampler.max_density_at(cell[0], cell[1], cell[2]);
+        float tau_cell = mu * (t_cell_end - t_cell_start);
+        if (tau < tau_cell) {
+            t = t_cell_start + tau / mu;
+            majorant = mu;
+            return true;
+        }
+        tau -= tau_cell;
+        if (t_cell_end >= d) {
+            break;
+        }
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= cell_counts[axis]) {
+            break;
+        }
+        t_cell_start = t_cell_end;
+        t_next[axis] += t_delta[axis];
+    }
+    t = d;
+    return false;
+}
+
+template<class DensitySampler>
+bool dt_path_trace_sampler(const PathInfo& path_info, const VolumeInfo& volume_info, const DensitySampler& sampler,
+                           PathRng& rng, ScatteringEventStream* paths, glm::vec3& exit_direction,
+                           PathTraceStatistics& statistics)
 {
     int pass_number = path_info.pass_number;
     glm::vec3 x = path_info.camera_pos;
@@ -392,82 +346,88 @@ void dt_path_trace(PathInfo path_info, VolumeInfo volume_info,
     INFO("  density: %f\n", density);
 
     glm::vec3 b_min, b_max;
-    get_grid_box(volume_info.grid, b_min, b_max);
+    get_grid_box(sampler.get_grid_size(0), sampler.get_grid_size(1), sampler.get_grid_size(2), b_min, b_max);
 
     glm::vec3 W { 0 }; // weight
     W[pass_number % 3] = 3; // Wavelenght dependent importance multiplier
 
     float t_min, t_max;
     if (!box_intersect(b_min, b_max, x, w, t_min, t_max))
-        return;
-
-    Trajectory trajectory;
-    std::vector<float> attribs;
-
-    defer {
-        trajectory.attributes.push_back(attribs);
-        trajis->push_back(trajectory);
-        // TODO(Felix): probably `w' is already normalized, so we don't need to
-        //   normalize it again
-        exit_dirs->push_back(glm::normalize(w));
-    };
+        return false;
 
-    trajectory.positions.push_back(x);
-    attribs.push_back({1});
+    if (paths) {
+        paths->push_event(x, ScatteringEventType::CAMERA);
+    }
 
     float d = t_max - t_min;
     x += w * t_min;
 
-    trajectory.positions.push_back(x);
-    attribs.push_back({1});
+    if (paths) {
+        paths->push_event(x, ScatteringEventType::ENTRY);
+    }
 
+    statistics.num_paths++;
 
     while (true) {
-        float t = // majorant of all volume data
-            density <= 0.00001
-            ? 10000000
-            : -std::log(std::max(0.00000000001f, 1.0f - Random::random())) / density;
+        float t;
+        float majorant = density; // majorant of all volume data
+        bool left_volume;
+        if (sampler.has_local_majorants()) {
+            left_volume = !sample_collision_local_majorants(
+                    sampler, b_min, b_max, x, w, d, density, rng, t, majorant);
+        } else {
+            t = density <= 0.00001
+                ? 10000000
+                : -std::log(std::max(0.00000000001f, 1.0f - rng.random())) / density;
+            left_volume = t >= d;
+        }
 
         INFO("  t: %f\n", t);
         INFO("  d: %f\n", d);
 
         x += w * t; // move to next event position or border
 
-        if (t >= d) {
+        if (left_volume) {
             INFO("->Ray left the volume\n");
-            trajectory.positions.push_back(x);
-            attribs.push_back({1});
-
+            if (paths) {
+                paths->push_event(x, ScatteringEventType::EXIT);
+            }
             break;
         }
 
-        trajectory.positions.push_back(x);
-        attribs.push_back({1});
-
         glm::vec3 tSamplePosition = (x - b_min) / (b_max - b_min);
-        float probExt = volume_info.grid.sample_at(tSamplePosition);
+        float probExt = sampler.sample_at(tSamplePosition);
+        statistics.num_density_lookups++;
         INFO("  sample pos: %f %f %f\n", tSamplePosition.x, tSamplePosition.y, tSamplePosition.z);
         INFO("  density there: %f\n", probExt);
 
         float m_t = probExt * density; // extinction coef
         float m_s = m_t * volume_info.scattering_albedo[pass_number % 3]; // scattering coef
         float m_a = m_t - m_s; // absorption coef
-        float m_n = density - m_t; // null coef
+        float m_n = majorant - m_t; // null coef
 
-        float xi = Random::random();
+        float xi = rng.random();
 
-        float Pa = m_a / density;
-        //float Ps = m_s / density;
-        float Pn = m_n / density;
+        float Pa = m_a / majorant;
+        //float Ps = m_s / majorant;
+        float Pn = m_n / majorant;
 
         if (xi < Pa) { // absorption
             INFO("->absorbtion\n");
+            statistics.num_absorption_events++;
+            if (paths) {
+                paths->push_event(x, ScatteringEventType::ABSORPTION);
+            }
             break;
         }
 
         if (xi < 1 - Pn) { // scattering
             INFO("->scatter\n");
-            w = importance_sample_phase(volume_info.g, w); // scattering event...
+            statistics.num_scattering_events++;
+            if (paths) {
+                paths->push_event(x, ScatteringEventType::SCATTERING);
+            }
+            w = importance_sample_phase(volume_info.g, w, rng); // scattering event...
 
             if (!box_intersect(b_min, b_max, x, w, t_min, t_max)) {
                 break;
@@ -477,9 +437,276 @@ void dt_path_trace(PathInfo path_info, VolumeInfo volume_info,
             x += w * t_min;
         } else {
             INFO("->null collision\n");
+            statistics.num_null_collisions++;
+            if (paths) {
+                paths->push_event(x, ScatteringEventType::NULL_COLLISION);
+            }
             // if no absorption and no scattering null collision occurred
             d -= t;
         }
     }
 
+    // TODO(Felix): probably `w' is already normalized, so we don't need to
+    //   normalize it again
+    exit_direction = glm::normalize(w);
+    if (paths) {
+        paths->end_path(exit_direction);
+    }
+    return true;
+}
+
+bool dt_path_trace(const PathInfo& path_info, const VolumeInfo& volume_info, PathRng& rng,
+                   ScatteringEventStream* paths, glm::vec3& exit_direction, PathTraceStatistics& statistics)
+{
+    if (volume_info.sparse_grid) {
+        NanoVdbDensitySampler sampler(*volume_info.sparse_grid);
+        return dt_path_trace_sampler(path_info, volume_info, sampler, rng, paths, exit_direction, statistics);
+    } else {
+        DenseDensitySampler sampler(volume_info.grid, volume_info.majorant_grid);
+        return dt_path_trace_sampler(path_info, volume_info, sampler, rng, paths, exit_direction, statistics);
+    }
+}
+
+/**
+ * Sampling key of path stream_idx for the subsampling in trace_scattering_paths. The finalizer of splitmix64 is a
+ * bijection, so different paths of one run never get the same key.
+ */
+inline uint64_t get_path_sampling_key(uint32_t seed, uint64_t stream_idx) {
+    uint64_t z = stream_idx + (uint64_t(seed) << 32 | 0x9E3779B9u) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// Memory of the paths with a key below the threshold, including the keys.
+size_t get_path_memory_below_threshold(
+        const ScatteringEventStream& paths, const std::vector<uint64_t>& path_keys, uint64_t key_threshold) {
+    size_t memory_size = 0;
+    for (size_t path_idx = 0; path_idx < path_keys.size(); path_idx++) {
+        if (path_keys[path_idx] < key_threshold) {
+            size_t num_events = size_t(paths.path_offsets[path_idx + 1] - paths.path_offsets[path_idx]);
+            memory_size += ScatteringEventStream::get_path_memory_size(num_events) + sizeof(uint64_t);
+        }
+    }
+    return memory_size;
+}
+
+/**
+ * Returns the largest key threshold not above key_threshold such that the paths of all passed sets with a key below
+ * the threshold need at most max_memory_size bytes. The memory is monotonic in the threshold, so bisection is used.
+ */
+uint64_t find_path_key_threshold(
+        const std::vector<std::pair<const ScatteringEventStream*, const std::vector<uint64_t>*>>& path_sets,
+        uint64_t key_threshold, size_t max_memory_size) {
+    auto get_memory_size = [&](uint64_t threshold) {
+        size_t memory_size = 0;
+        for (const auto& path_set : path_sets) {
+            memory_size += get_path_memory_below_threshold(*path_set.first, *path_set.second, threshold);
+        }
+        return memory_size;
+    };
+    if (get_memory_size(key_threshold) <= max_memory_size) {
+        return key_threshold;
+    }
+    uint64_t lower = 0; // Fits.
+    uint64_t upper = key_threshold; // Does not fit.
+    while (upper - lower > 1) {
+        uint64_t mid = lower + (upper - lower) / 2;
+        if (get_memory_size(mid) <= max_memory_size) {
+            lower = mid;
+        } else {
+            upper = mid;
+        }
+    }
+    return lower;
+}
+
+/// Removes all paths with a key not below the threshold in place.
+void remove_paths_above_threshold(
+        ScatteringEventStream& paths, std::vector<uint64_t>& path_keys, uint64_t key_threshold) {
+    size_t num_kept_paths = 0;
+    paths.keep_paths_if([&](size_t path_idx) {
+        if (path_keys[path_idx] >= key_threshold) {
+            return false;
+        }
+        path_keys[num_kept_paths++] = path_keys[path_idx];
+        return true;
+    });
+    path_keys.resize(num_kept_paths);
+}
+
+bool trace_scattering_paths(
+        const VolumeInfo& volume_info, glm::vec3 camera_pos, glm::vec3 camera_look_at, float camera_fov_deg,
+        uint32_t res_x, uint32_t res_y, uint32_t samples_per_pixel, uint32_t seed, size_t max_path_memory_bytes,
+        ScatteringEventStream& paths, PathTraceStatistics* statistics, SphericalHistogram* exit_direction_histogram,
+        const std::function<bool(float)>& progress_callback)
+{
+    glm::vec3 camera_dir = glm::normalize(camera_look_at - camera_pos);
+    glm::vec3 Y = { 0, -1, 0 };
+    glm::vec3 X = glm::cross(camera_dir, Y);
+    Y = glm::cross(X, camera_dir);
+
+    float focal_length        = 1;  // how far away from the camera the grid will be
+    float camera_fov_rad = glm::radians(camera_fov_deg);
+    float grid_width     = tan(camera_fov_rad / 2) * 2 * focal_length;
+    float grid_height    = res_y * (grid_width / res_x);
+
+    glm::vec3 P0 =
+        camera_pos +
+        camera_dir * focal_length -
+        0.5f * Y * grid_height -
+        0.5f * X * grid_width;
+
+    // Every row of a block is traced into its own buffers, which are appended to the output in row order afterwards.
+    // The rows are processed in blocks, so that the progress can be reported and cancellation can be checked on the
+    // calling thread, and so that only the rows of one block need to be buffered.
+    // When subsampling, the memory budget not used by the kept paths is split between the row buffers of a block.
+    // The kept paths always leave every row buffer at least twice the share of the budget that one row of the image
+    // gets on average (the rows through the center of the volume have longer paths). A row buffer that exceeds its
+    // share lowers its own key threshold; the global threshold is the minimum of all thresholds.
+    const uint32_t rows_per_block = 16;
+    const bool subsample_paths = max_path_memory_bytes != 0;
+    const uint32_t num_buffered_rows = min(rows_per_block, res_y);
+    const size_t min_row_memory_bytes = 2 * max_path_memory_bytes / max(res_y + 2 * num_buffered_rows, 1u);
+    const size_t max_kept_memory_bytes = max_path_memory_bytes - min_row_memory_bytes * num_buffered_rows;
+    size_t max_row_memory_bytes = 0;
+    uint64_t key_threshold = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> path_keys;
+    std::vector<ScatteringEventStream> row_paths(rows_per_block);
+    std::vector<std::vector<uint64_t>> row_path_keys(rows_per_block);
+    std::vector<uint64_t> row_key_thresholds(rows_per_block);
+    std::vector<PathTraceStatistics> row_statistics(res_y);
+    std::vector<SphericalHistogram> row_histograms(exit_direction_histogram ? rows_per_block : 0);
+    paths.clear();
+
+    auto trace_row = [&](const auto& sampler, int y, uint32_t block_row) {
+        ScatteringEventStream& row = row_paths[block_row];
+        std::vector<uint64_t>& keys = row_path_keys[block_row];
+        uint64_t& row_key_threshold = row_key_thresholds[block_row];
+        PathTraceStatistics& stats = row_statistics[y];
+        PathInfo path_info {};
+        path_info.camera_pos = camera_pos;
+        glm::vec3 exit_direction;
+        for (uint32_t x = 0; x < res_x; ++x) {
+            // NOTE(Felix): these percentage values tell us how far along
+            //   the x and y axis we are, while rendering the pixels. This
+            //   is used to find out the direction onto which we send the
+            //   ray. If the resolution in a dimension is 1, we send the ray
+            //   in the middle, the calculation would otherwise lead to a
+            //   divison-by-zero.
+            float x_percentage = res_x < 2 ? 0.5f : (x*1.0f/(res_x-1));
+            float y_percentage = res_y < 2 ? 0.5f : (uint32_t(y)*1.0f/(res_y-1));
+
+            glm::vec3 P =
+                P0 +
+                X * x_percentage * grid_width +
+                Y * y_percentage * grid_height;
+            path_info.ray_direction = glm::normalize(P - camera_pos);
+
+            // Sample loop
+            uint64_t pixel_idx = uint64_t(y) * uint64_t(res_x) + uint64_t(x);
+            for (uint32_t i = 0; i < samples_per_pixel; ++i) {
+                path_info.pass_number = int32_t(i);
+                uint64_t stream_idx = pixel_idx * samples_per_pixel + i;
+                PathRng rng(seed, stream_idx);
+                uint64_t key = subsample_paths ? get_path_sampling_key(seed, stream_idx) : 0;
+                bool keep_path = key < row_key_threshold;
+                if (!dt_path_trace_sampler(
+                        path_info, volume_info, sampler, rng, keep_path ? &row : nullptr, exit_direction, stats)) {
+                    continue;
+                }
+                if (exit_direction_histogram) {
+                    row_histograms[block_row].add(exit_direction);
+                }
+                if (!keep_path || !subsample_paths) {
+                    continue;
+                }
+                keys.push_back(key);
+                if (row.get_memory_size() + keys.size() * sizeof(uint64_t) > max_row_memory_bytes) {
+                    // Shrink to 7/8 of the share, so that the threshold search is not repeated for every path.
+                    row_key_threshold = find_path_key_threshold(
+                            {{&row, &keys}}, row_key_threshold, max_row_memory_bytes / 8 * 7);
+                    remove_paths_above_threshold(row, keys, row_key_threshold);
+                }
+            }
+        }
+    };
+    for (uint32_t block_start = 0; block_start < res_y; block_start += rows_per_block) {
+        if (progress_callback && !progress_callback(float(block_start) / float(res_y))) {
+            paths.clear();
+            return false;
+        }
+        auto block_end = int(min(block_start + rows_per_block, res_y));
+        std::fill(row_key_thresholds.begin(), row_key_thresholds.end(), key_threshold);
+        if (subsample_paths) {
+            size_t kept_memory_bytes = paths.get_memory_size() + path_keys.size() * sizeof(uint64_t);
+            max_row_memory_bytes = (max_path_memory_bytes - kept_memory_bytes) / num_buffered_rows;
+        }
+
+#ifdef USE_TBB
+        tbb::parallel_for(tbb::blocked_range<int>(int(block_start), block_end), [&](auto const& r) {
+            for (auto y = r.begin(); y != r.end(); y++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic, 1) shared(block_start, block_end, res_x, res_y, \
+        volume_info, trace_row)
+        for (int y = int(block_start); y < block_end; y++) {
+#endif
+            // Each row creates its own sampler, so that, e.g., NanoVDB accessors are never shared between threads.
+            auto block_row = uint32_t(y) - block_start;
+            if (volume_info.sparse_grid) {
+                trace_row(NanoVdbDensitySampler(*volume_info.sparse_grid), y, block_row);
+            } else {
+                trace_row(DenseDensitySampler(volume_info.grid, volume_info.majorant_grid), y, block_row);
+            }
+        }
+#ifdef USE_TBB
+        });
+#endif
+
+        // Merge the rows in order, so that the output does not depend on the scheduling.
+        auto num_block_rows = uint32_t(block_end) - block_start;
+        if (subsample_paths) {
+            for (uint32_t block_row = 0; block_row < num_block_rows; block_row++) {
+                key_threshold = std::min(key_threshold, row_key_thresholds[block_row]);
+            }
+            std::vector<std::pair<const ScatteringEventStream*, const std::vector<uint64_t>*>> path_sets;
+            path_sets.emplace_back(&paths, &path_keys);
+            for (uint32_t block_row = 0; block_row < num_block_rows; block_row++) {
+                path_sets.emplace_back(&row_paths[block_row], &row_path_keys[block_row]);
+            }
+            key_threshold = find_path_key_threshold(path_sets, key_threshold, max_kept_memory_bytes);
+            remove_paths_above_threshold(paths, path_keys, key_threshold);
+        }
+        for (uint32_t block_row = 0; block_row < num_block_rows; block_row++) {
+            ScatteringEventStream& row = row_paths[block_row];
+            if (subsample_paths) {
+                std::vector<uint64_t>& keys = row_path_keys[block_row];
+                for (size_t path_idx = 0; path_idx < keys.size(); path_idx++) {
+                    if (keys[path_idx] < key_threshold) {
+                        paths.append_path(row, path_idx);
+                        path_keys.push_back(keys[path_idx]);
+                    }
+                }
+                keys.clear();
+            } else {
+                paths.append(row);
+            }
+            row.clear();
+            if (exit_direction_histogram) {
+                exit_direction_histogram->add(row_histograms[block_row]);
+                row_histograms[block_row].clear();
+            }
+        }
+    }
+
+    if (statistics) {
+        for (const PathTraceStatistics& stats : row_statistics) {
+            *statistics += stats;
+        }
+    }
+
+    if (progress_callback) {
+        progress_callback(1.0f);
+    }
+    return true;
 }
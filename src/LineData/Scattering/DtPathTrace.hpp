@@ -29,11 +29,16 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 #include <glm/glm.hpp>
 #include "Texture3d.hpp"
+#include "MajorantGrid.hpp"
+#include "DensitySampler.hpp"
+#include "ScatteringEventStream.hpp"
 #include "Loaders/DataSetList.hpp"
 #include "LineDataScattering.hpp"
 #include "Image.hpp"
+#include "SphericalHeatMap.hpp"
 #include "../LineData.hpp"
 
 
@@ -48,16 +53,96 @@ struct VolumeInfo {
     glm::vec3 extinction;
     glm::vec3 scattering_albedo;
     float g;
+    /// Optional local majorants for the free-flight sampling. If nullptr, the global majorant extinction is used.
+    const MajorantGrid* majorant_grid = nullptr;
+    /// Optional sparse density field (e.g., of a .nvdb data set). If set, it is sampled instead of grid and its tree
+    /// nodes give the local majorants.
+    const nanovdb::FloatGrid* sparse_grid = nullptr;
+};
+
+struct PathTraceStatistics {
+    uint64_t num_paths = 0;
+    uint64_t num_density_lookups = 0; ///< Number of collisions, i.e., Texture3D::sample_at calls.
+    uint64_t num_null_collisions = 0;
+    uint64_t num_scattering_events = 0;
+    uint64_t num_absorption_events = 0;
+
+    PathTraceStatistics& operator+=(const PathTraceStatistics& other) {
+        num_paths += other.num_paths;
+        num_density_lookups += other.num_density_lookups;
+        num_null_collisions += other.num_null_collisions;
+        num_scattering_events += other.num_scattering_events;
+        num_absorption_events += other.num_absorption_events;
+        return *this;
+    }
 };
 
 
 typedef std::vector<glm::vec3> Exit_Directions;
 
-Image create_spherical_heatmap_image(sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height);
+/**
+ * Counter-based random number generator (Philox-4x32-10). Each path gets its own stream keyed by the seed and the
+ * index of the path, so the traced paths neither depend on the order they are traced in nor on the thread count.
+ */
+class PathRng {
+public:
+    PathRng(uint32_t seed, uint64_t stream_idx) {
+        key[0] = seed;
+        key[1] = 0x8A5CD789u;
+        counter[0] = 0;
+        counter[1] = 0;
+        counter[2] = uint32_t(stream_idx);
+        counter[3] = uint32_t(stream_idx >> 32);
+    }
+
+    /// Returns a uniformly distributed number in [0, 1).
+    inline float random() {
+        if (buffer_idx == 4) {
+            generate_block();
+            buffer_idx = 0;
+        }
+        return float(buffer[buffer_idx++] >> 8) * (1.0f / 16777216.0f);
+    }
 
-void dt_path_trace(PathInfo path_info, VolumeInfo volume_info,
-                   Trajectories* traj, Exit_Directions* exit_dirs);
+private:
+    void generate_block();
 
-namespace Random {
-    void init(uint32_t seed);
-}
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t buffer[4] = {};
+    int buffer_idx = 4;
+};
+
+/**
+ * Traces one path with delta tracking. Reentrant, i.e., it can be called concurrently with different output streams and
+ * generators. If volume_info.majorant_grid is set, the free-flight distances are sampled against the local majorants by
+ * stepping through the majorant grid with a 3D DDA. This is the same unbiased estimator with fewer null collisions.
+ * @param paths If not nullptr, the events of the path are appended to it as a new path.
+ * @param exit_direction The direction the path leaves the volume in (or of the last event if the path was absorbed).
+ * @return False if the ray misses the volume. In this case, no path is added and the statistics are not changed.
+ */
+bool dt_path_trace(const PathInfo& path_info, const VolumeInfo& volume_info, PathRng& rng,
+                   ScatteringEventStream* paths, glm::vec3& exit_direction, PathTraceStatistics& statistics);
+
+/**
+ * Traces samples_per_pixel paths for each pixel of a res_x x res_y image plane in front of the camera in parallel.
+ * Path (x, y, i) uses the random number stream (y * res_x + x) * samples_per_pixel + i. The paths are stored in pixel
+ * order, so the output is identical for any number of threads.
+ *
+ * If max_path_memory_bytes is not zero, the paths are subsampled such that the stored path data (events, offsets, exit
+ * directions and sampling keys) never exceeds this size. Each path gets a pseudo-random key derived from its stream
+ * index, and the kept paths are exactly the paths with a key below a threshold that is lowered whenever the budget
+ * would be exceeded. This is a uniform random subset of all paths (bottom-k sampling), and it also does not depend on
+ * the number of threads. The statistics and the exit direction histogram always include all paths.
+ * @param paths The kept paths. The stream is cleared first, and it is empty if tracing was cancelled.
+ * @param statistics If not nullptr, the event counts of all paths are added to it.
+ * @param exit_direction_histogram If not nullptr, the exit directions of all paths are added to it.
+ * @param progress_callback Called on the calling thread with the progress in [0, 1]; tracing is cancelled if it
+ * returns false. Can be empty.
+ * @return False if tracing was cancelled.
+ */
+bool trace_scattering_paths(
+        const VolumeInfo& volume_info, glm::vec3 camera_pos, glm::vec3 camera_look_at, float camera_fov_deg,
+        uint32_t res_x, uint32_t res_y, uint32_t samples_per_pixel, uint32_t seed, size_t max_path_memory_bytes,
+        ScatteringEventStream& paths, PathTraceStatistics* statistics, SphericalHistogram* exit_direction_histogram,
+        const std::function<bool(float)>& progress_callback);
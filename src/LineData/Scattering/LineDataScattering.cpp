@@ -59,8 +59,16 @@ const std::vector<glm::vec3>& LineDataScattering::getExitDirections() {
     return ray_exit_directions;
 }
 
-void LineDataScattering::setExitDirections(const std::vector<glm::vec3>& exit_dirs) {
-    ray_exit_directions = exit_dirs;
+void LineDataScattering::setExitDirections(std::vector<glm::vec3> exit_dirs) {
+    ray_exit_directions = std::move(exit_dirs);
+}
+
+void LineDataScattering::setExitDirectionHistogram(std::unique_ptr<SphericalHistogram> histogram) {
+    exit_direction_histogram = std::move(histogram);
+}
+
+const SphericalHistogram* LineDataScattering::getExitDirectionHistogram() {
+    return exit_direction_histogram.get();
 }
 
 void LineDataScattering::setDataSetInformation(
@@ -75,6 +83,31 @@ void LineDataScattering::setGridData(
         const std::vector<glm::vec3>& outlineVertexPositions, const std::vector<glm::vec3>& outlineVertexNormals,
         float* scalarFieldData, uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ,
         float voxelSizeX, float voxelSizeY, float voxelSizeZ) {
+    this->scalarFieldData = new float[gridSizeX * gridSizeY * gridSizeZ];
+    memcpy(this->scalarFieldData, scalarFieldData, sizeof(float) * gridSizeX * gridSizeY * gridSizeZ);
+    cloudData = std::make_shared<CloudData>();
+    cloudData->setDensityField(gridSizeX, gridSizeY, gridSizeZ, this->scalarFieldData);
+    setGridExtent(scalarFieldTexture, gridSizeX, gridSizeY, gridSizeZ, voxelSizeX, voxelSizeY, voxelSizeZ);
+
+    if (!outlineTriangleIndices.empty()) {
+        simulationMeshOutlineTriangleIndices = outlineTriangleIndices;
+        simulationMeshOutlineVertexPositions = outlineVertexPositions;
+        simulationMeshOutlineVertexNormals = outlineVertexNormals;
+        shallRenderSimulationMeshBoundary = true;
+    }
+}
+
+void LineDataScattering::setSparseGridData(const CloudDataPtr& sparseCloudData) {
+    scalarFieldData = nullptr;
+    cloudData = sparseCloudData;
+    setGridExtent(
+            {}, cloudData->getGridSizeX(), cloudData->getGridSizeY(), cloudData->getGridSizeZ(),
+            cloudData->getVoxelSizeX(), cloudData->getVoxelSizeY(), cloudData->getVoxelSizeZ());
+}
+
+void LineDataScattering::setGridExtent(
+        const sgl::vk::TexturePtr& scalarFieldTexture, uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ,
+        float voxelSizeX, float voxelSizeY, float voxelSizeZ) {
     this->gridSizeX = gridSizeX;
     this->gridSizeY = gridSizeY;
     this->gridSizeZ = gridSizeZ;
@@ -82,11 +115,6 @@ void LineDataScattering::setGridData(
     this->voxelSizeY = voxelSizeY;
     this->voxelSizeZ = voxelSizeZ;
 
-    this->scalarFieldData = new float[gridSizeX * gridSizeY * gridSizeZ];
-    memcpy(this->scalarFieldData, scalarFieldData, sizeof(float) * gridSizeX * gridSizeY * gridSizeZ);
-    cloudData = std::make_shared<CloudData>();
-    cloudData->setDensityField(gridSizeX, gridSizeY, gridSizeZ, this->scalarFieldData);
-
     uint32_t maxDimSize = std::max(gridSizeX, std::max(gridSizeY, gridSizeZ));
     gridAabb.max = glm::vec3(gridSizeX, gridSizeY, gridSizeZ) * 0.25f / float(maxDimSize);
     gridAabb.min = -gridAabb.max;
@@ -124,13 +152,6 @@ void LineDataScattering::setGridData(
         colorLegendWidgets.back().setAttributeMaxValue(1.0f);
         colorLegendWidgets.back().setAttributeDisplayName("Line Density");
     }
-
-    if (!outlineTriangleIndices.empty()) {
-        simulationMeshOutlineTriangleIndices = outlineTriangleIndices;
-        simulationMeshOutlineVertexPositions = outlineVertexPositions;
-        simulationMeshOutlineVertexNormals = outlineVertexNormals;
-        shallRenderSimulationMeshBoundary = true;
-    }
 }
 
 void LineDataScattering::recomputeHistogram() {
@@ -35,6 +35,7 @@
 #include "../LineDataFlow.hpp"
 #include "CloudData.hpp"
 #include "Texture3d.hpp"
+#include "SphericalHeatMap.hpp"
 
 namespace sgl { namespace vk {
 class Renderer;
@@ -64,6 +65,7 @@ public:
             sgl::TransferFunctionWindow& transferFunctionWindow, sgl::vk::Renderer* rendererVk
     );
     ~LineDataScattering() override;
+    using LineDataFlow::setTrajectoryData;
 
     [[nodiscard]] inline CloudDataPtr getCloudData() { return cloudData; }
     [[nodiscard]] inline uint32_t getGridSizeX() const { return gridSizeX; }
@@ -87,8 +89,12 @@ public:
 
     void setDataSetInformation(const std::string& dataSetName, const std::vector<std::string>& attributeNames);
 
-    void setExitDirections(const std::vector<glm::vec3>& exit_dirs);
+    void setExitDirections(std::vector<glm::vec3> exit_dirs);
     const std::vector<glm::vec3>& getExitDirections();
+    /// Histogram of the exit directions of all traced paths, including the paths not kept for rendering.
+    void setExitDirectionHistogram(std::unique_ptr<SphericalHistogram> histogram);
+    /// @return The exit direction histogram, or nullptr if none was set.
+    const SphericalHistogram* getExitDirectionHistogram();
 
     void setGridData(
             const sgl::vk::TexturePtr& scalarFieldTexture,
@@ -96,6 +102,11 @@ public:
             const std::vector<glm::vec3>& outlineVertexPositions, const std::vector<glm::vec3>& outlineVertexNormals,
             float* scalarFieldData, uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ,
             float voxelSizeX, float voxelSizeY, float voxelSizeZ);
+    /**
+     * Uses the sparse density field of the passed cloud data (e.g., loaded from a .nvdb file) for the volume renderers.
+     * No dense copy of the field is created, so getScalarFieldData returns nullptr.
+     */
+    void setSparseGridData(const CloudDataPtr& sparseCloudData);
 
     void rebuildInternalRepresentationIfNecessary() override;
 
@@ -110,6 +121,11 @@ protected:
     void recomputeHistogram() override;
 
 private:
+    /// Sets the grid extent and creates the line density field texture.
+    void setGridExtent(
+            const sgl::vk::TexturePtr& scalarFieldTexture, uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ,
+            float voxelSizeX, float voxelSizeY, float voxelSizeZ);
+
     CloudDataPtr cloudData{};
     uint32_t gridSizeX = 0, gridSizeY = 0, gridSizeZ = 0;
     float voxelSizeX = 0.0f, voxelSizeY = 0.0f, voxelSizeZ = 0.0f;
@@ -120,6 +136,7 @@ private:
     bool isVolumeRenderer = false;
     bool useLineSegmentLengthForDensityField = true;
     std::vector<glm::vec3> ray_exit_directions;
+    std::unique_ptr<SphericalHistogram> exit_direction_histogram;
 
     // Caches the rendering data when using Vulkan.
     VulkanLineDataScatteringRenderData vulkanScatteredLinesGridRenderData;
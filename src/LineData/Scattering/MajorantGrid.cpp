@@ -0,0 +1,96 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "MajorantGrid.hpp"
+
+void MajorantGrid::build(const Texture3D& grid, uint32_t super_voxel_size_1d) {
+    super_voxel_size = std::max(super_voxel_size_1d, 1u);
+
+    // The voxel centers lie at the integer index coordinates 0 to size - 1 (see Texture3D::sample_at).
+    uint32_t grid_sizes[3] = { grid.size_x, grid.size_y, grid.size_z };
+    uint32_t cell_counts[3];
+    for (int a = 0; a < 3; a++) {
+        if (grid_sizes[a] <= 1) {
+            cell_counts[a] = 1;
+            normalized_to_cell_scale[a] = 1.0f;
+        } else {
+            cell_counts[a] = std::max((grid_sizes[a] - 1 + super_voxel_size - 1) / super_voxel_size, 1u);
+            normalized_to_cell_scale[a] = float(grid_sizes[a] - 1) / float(super_voxel_size);
+        }
+    }
+    size_x = cell_counts[0];
+    size_y = cell_counts[1];
+    size_z = cell_counts[2];
+
+    auto num_cells = int(size_x * size_y * size_z);
+    max_densities.resize(size_t(num_cells));
+
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_cells), [&](auto const& r) {
+        for (auto cell_idx = r.begin(); cell_idx != r.end(); cell_idx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for shared(num_cells, grid) default(none)
+#endif
+    for (int cell_idx = 0; cell_idx < num_cells; cell_idx++) {
+#endif
+        int cell_x = cell_idx % int(size_x);
+        int cell_y = (cell_idx / int(size_x)) % int(size_y);
+        int cell_z = cell_idx / int(size_x * size_y);
+        int b = int(super_voxel_size);
+        int x_start = std::max(cell_x * b - 1, 0), x_end = std::min((cell_x + 1) * b + 1, int(grid.size_x) - 1);
+        int y_start = std::max(cell_y * b - 1, 0), y_end = std::min((cell_y + 1) * b + 1, int(grid.size_y) - 1);
+        int z_start = std::max(cell_z * b - 1, 0), z_end = std::min((cell_z + 1) * b + 1, int(grid.size_z) - 1);
+
+        float density_max = 0.0f;
+        for (int z = z_start; z <= z_end; z++) {
+            for (int y = y_start; y <= y_end; y++) {
+                const float* row = grid.data + (size_t(y) + size_t(z) * grid.size_y) * grid.size_x;
+                for (int x = x_start; x <= x_end; x++) {
+                    density_max = std::max(density_max, row[x]);
+                }
+            }
+        }
+        max_densities[cell_idx] = density_max;
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+void MajorantGrid::clear() {
+    max_densities = {};
+    size_x = size_y = size_z = 0;
+}
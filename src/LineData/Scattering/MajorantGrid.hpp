@@ -0,0 +1,66 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Texture3d.hpp"
+
+/**
+ * Coarse grid storing the maximum density of blocks of super_voxel_size^3 voxels of a Texture3D. It is used as a
+ * piecewise constant local majorant for delta tracking, so that free-flight distances in empty or thin regions of the
+ * volume can be sampled with far fewer null collisions than with a single global majorant.
+ *
+ * Super voxel (x, y, z) covers the voxel index range [x * super_voxel_size, (x + 1) * super_voxel_size] along the
+ * x axis (and analogously along y and z). As Texture3D::sample_at interpolates trilinearly, the maximum is taken over
+ * this range extended by one voxel on each side, which makes the bound robust against rounding at cell borders.
+ */
+struct MajorantGrid {
+    std::vector<float> max_densities;
+    uint32_t size_x = 0;
+    uint32_t size_y = 0;
+    uint32_t size_z = 0;
+    uint32_t super_voxel_size = 8;
+
+    // Maps normalized grid coordinates in [0, 1] (as passed to Texture3D::sample_at) to super voxel coordinates.
+    glm::vec3 normalized_to_cell_scale = glm::vec3(1.0f);
+
+    // ---------------------------- //
+
+    /**
+     * @param grid The density grid. The densities are assumed to be normalized to [0, 1].
+     * @param super_voxel_size_1d The number of voxels per super voxel along each axis.
+     */
+    void build(const Texture3D& grid, uint32_t super_voxel_size_1d = 8);
+    void clear();
+    [[nodiscard]] inline bool empty() const { return max_densities.empty(); }
+    [[nodiscard]] inline float max_density_at(uint32_t x, uint32_t y, uint32_t z) const {
+        return max_densities[x + (y + z * size_y) * size_x];
+    }
+};
@@ -0,0 +1,68 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ScatteringEventStream.hpp"
+
+void ScatteringEventStream::clear() {
+    positions.clear();
+    event_types.clear();
+    path_offsets.clear();
+    path_offsets.push_back(0);
+    exit_directions.clear();
+}
+
+void ScatteringEventStream::append(const ScatteringEventStream& other) {
+    uint64_t event_offset = positions.size();
+    positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+    event_types.insert(event_types.end(), other.event_types.begin(), other.event_types.end());
+    path_offsets.reserve(path_offsets.size() + other.get_num_paths());
+    for (size_t path_idx = 1; path_idx < other.path_offsets.size(); path_idx++) {
+        path_offsets.push_back(event_offset + other.path_offsets[path_idx]);
+    }
+    exit_directions.insert(exit_directions.end(), other.exit_directions.begin(), other.exit_directions.end());
+}
+
+void ScatteringEventStream::append_path(const ScatteringEventStream& other, size_t path_idx) {
+    auto event_start = ptrdiff_t(other.path_offsets[path_idx]);
+    auto event_end = ptrdiff_t(other.path_offsets[path_idx + 1]);
+    positions.insert(positions.end(), other.positions.begin() + event_start, other.positions.begin() + event_end);
+    event_types.insert(
+            event_types.end(), other.event_types.begin() + event_start, other.event_types.begin() + event_end);
+    end_path(other.exit_directions[path_idx]);
+}
+
+TrajectoryStore ScatteringEventStream::move_to_trajectory_store() {
+    std::vector<std::vector<float>> attributes;
+    attributes.push_back(std::move(event_types));
+    TrajectoryStore trajectories;
+    trajectories.setLineData(std::move(path_offsets), std::move(positions), std::move(attributes));
+    positions = {};
+    event_types = {};
+    path_offsets = { 0 };
+    return trajectories;
+}
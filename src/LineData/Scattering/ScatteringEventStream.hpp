@@ -0,0 +1,138 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Loaders/TrajectoryStore.hpp"
+
+enum class ScatteringEventType : uint32_t {
+    CAMERA = 0, ///< Start of the path at the camera.
+    ENTRY = 1, ///< The ray enters the volume.
+    SCATTERING = 2,
+    NULL_COLLISION = 3,
+    ABSORPTION = 4,
+    EXIT = 5 ///< The ray leaves the volume.
+};
+
+/**
+ * Storage of scattering paths in the flat layout of @see TrajectoryStore: the event positions and event types of all
+ * paths in contiguous arrays, indexed by path offsets (path i consists of the events
+ * [path_offsets[i], path_offsets[i + 1])). Unlike one Trajectory per path, appending a path does not need any
+ * allocations of its own. The event types are stored as the float attribute used for rendering, so that the arrays can
+ * be moved into a TrajectoryStore without copying them (@see move_to_trajectory_store).
+ */
+struct ScatteringEventStream {
+    std::vector<glm::vec3> positions;
+    std::vector<float> event_types; ///< The ScatteringEventType of each event as a float.
+    std::vector<uint64_t> path_offsets = { 0 };
+    std::vector<glm::vec3> exit_directions; ///< One per path.
+
+    [[nodiscard]] inline size_t get_num_paths() const { return path_offsets.size() - 1; }
+    [[nodiscard]] inline size_t get_num_events() const { return positions.size(); }
+    [[nodiscard]] inline bool empty() const { return path_offsets.size() <= 1; }
+    [[nodiscard]] inline ScatteringEventType get_event_type(size_t event_idx) const {
+        return ScatteringEventType(uint32_t(event_types[event_idx]));
+    }
+    [[nodiscard]] inline size_t get_path_num_events(size_t path_idx) const {
+        return size_t(path_offsets[path_idx + 1] - path_offsets[path_idx]);
+    }
+    [[nodiscard]] inline TrajectorySpan<const glm::vec3> get_path_positions(size_t path_idx) const {
+        return TrajectorySpan<const glm::vec3>(
+                positions.data() + path_offsets[path_idx], get_path_num_events(path_idx));
+    }
+    [[nodiscard]] inline TrajectorySpan<const float> get_path_event_types(size_t path_idx) const {
+        return TrajectorySpan<const float>(event_types.data() + path_offsets[path_idx], get_path_num_events(path_idx));
+    }
+    /// Number of bytes used by the path data (without unused capacity).
+    [[nodiscard]] inline size_t get_memory_size() const {
+        return positions.size() * sizeof(glm::vec3) + event_types.size() * sizeof(float)
+                + path_offsets.size() * sizeof(uint64_t) + exit_directions.size() * sizeof(glm::vec3);
+    }
+    /// Number of bytes a path with num_events events adds to get_memory_size().
+    [[nodiscard]] static inline size_t get_path_memory_size(size_t num_events) {
+        return num_events * (sizeof(glm::vec3) + sizeof(float)) + sizeof(uint64_t) + sizeof(glm::vec3);
+    }
+
+    inline void push_event(const glm::vec3& position, ScatteringEventType type) {
+        positions.push_back(position);
+        event_types.push_back(float(uint32_t(type)));
+    }
+    /// Closes the path consisting of all events pushed since the last call.
+    inline void end_path(const glm::vec3& exit_direction) {
+        path_offsets.push_back(positions.size());
+        exit_directions.push_back(exit_direction);
+    }
+
+    void clear();
+    /// Appends all paths of the passed stream.
+    void append(const ScatteringEventStream& other);
+    /// Appends path path_idx of the passed stream.
+    void append_path(const ScatteringEventStream& other, size_t path_idx);
+    /**
+     * Removes all paths for which keep_path(path_idx) returns false in place. keep_path is called once per path in
+     * increasing order of the path indices.
+     */
+    template<class Predicate>
+    void keep_paths_if(const Predicate& keep_path) {
+        size_t num_paths = get_num_paths();
+        size_t num_kept_paths = 0;
+        uint64_t num_kept_events = 0;
+        for (size_t path_idx = 0; path_idx < num_paths; path_idx++) {
+            if (!keep_path(path_idx)) {
+                continue;
+            }
+            uint64_t event_start = path_offsets[path_idx];
+            uint64_t event_end = path_offsets[path_idx + 1];
+            if (num_kept_events != event_start) {
+                std::copy(
+                        positions.begin() + ptrdiff_t(event_start), positions.begin() + ptrdiff_t(event_end),
+                        positions.begin() + ptrdiff_t(num_kept_events));
+                std::copy(
+                        event_types.begin() + ptrdiff_t(event_start), event_types.begin() + ptrdiff_t(event_end),
+                        event_types.begin() + ptrdiff_t(num_kept_events));
+            }
+            num_kept_events += event_end - event_start;
+            path_offsets[num_kept_paths + 1] = num_kept_events;
+            exit_directions[num_kept_paths] = exit_directions[path_idx];
+            num_kept_paths++;
+        }
+        positions.resize(num_kept_events);
+        event_types.resize(num_kept_events);
+        path_offsets.resize(num_kept_paths + 1);
+        exit_directions.resize(num_kept_paths);
+    }
+
+    /**
+     * Moves the paths into a TrajectoryStore for rendering without copying them. The line points are the event
+     * positions, and the only attribute is the event type. Only the exit directions are left in the stream.
+     */
+    [[nodiscard]] TrajectoryStore move_to_trajectory_store();
+};
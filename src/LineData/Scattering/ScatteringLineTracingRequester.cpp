@@ -27,6 +27,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 
 #include <boost/filesystem.hpp>
@@ -69,20 +70,14 @@ ScatteringLineTracingRequester::ScatteringLineTracingRequester(
 
     lineDataSetsDirectory = sgl::AppSettings::get()->getDataDirectory() + "LineDataSets/";
     loadGridDataSetList();
-    if (supportsMultiThreadedLoading) {
-        requesterThread = std::thread(&ScatteringLineTracingRequester::mainLoop, this);
-    }
+    requestScheduler = std::make_unique<RequestScheduler<LineDataPtr>>(
+            "ScatteringLineTracingRequester", supportsMultiThreadedLoading);
 }
 
 ScatteringLineTracingRequester::~ScatteringLineTracingRequester() {
-    if (supportsMultiThreadedLoading) {
-        join();
-    }
+    requestScheduler->join();
     cachedGrid.delete_maybe();
 
-    requestLineData = {};
-    replyLineData = {};
-
     if (rendererVk) {
         lineDensityFieldSmoothingPass = {};
         cachedScalarFieldTexture = {};
@@ -192,6 +187,8 @@ void ScatteringLineTracingRequester::renderGui() {
                 "Scattering Albedo", &guiTracingSettings.scattering_albedo.x, 0.0f, 1.0f) == ImGui::EditMode::INPUT_FINISHED;
         changed |= ImGui::SliderFloatEdit(
                 "G", &guiTracingSettings.g, 0.0f, 1.0f) == ImGui::EditMode::INPUT_FINISHED;
+        changed |= ImGui::Checkbox("Local Majorants", &guiTracingSettings.use_majorant_grid);
+        changed |= ImGui::InputInt("Max. Path Memory (MiB)", (int*)&guiTracingSettings.max_path_memory_mib);
 
         if (changed) {
             requestNewData();
@@ -238,6 +235,8 @@ void ScatteringLineTracingRequester::setLineTracerSettings(const SettingsMap& se
     changed |= settings.getValueOpt("extinction", guiTracingSettings.extinction);
     changed |= settings.getValueOpt("scattering_albedo", guiTracingSettings.scattering_albedo);
     changed |= settings.getValueOpt("g", guiTracingSettings.g);
+    changed |= settings.getValueOpt("use_majorant_grid", guiTracingSettings.use_majorant_grid);
+    changed |= settings.getValueOpt("max_path_memory_mib", guiTracingSettings.max_path_memory_mib);
 
     if (changed) {
         requestNewData();
@@ -287,108 +286,28 @@ void ScatteringLineTracingRequester::requestNewData() {
     request.dataset_filename = boost::filesystem::absolute(gridDataSetFilename).generic_string();
 
     queueRequestStruct(request);
-    if (!supportsMultiThreadedLoading) {
-        mainLoop();
-    }
 }
 
 bool ScatteringLineTracingRequester::getHasNewData(DataSetInformation& dataSetInformation, LineDataPtr& lineData) {
-    if (getReply(lineData)) {
-        return true;
-    }
-    return false;
+    return requestScheduler->getReply(lineData);
 }
 
 void ScatteringLineTracingRequester::queueRequestStruct(const ScatteringTracingSettings& request) {
-    {
-        std::lock_guard<std::mutex> lock(requestMutex);
-        workerTracingSettings = request;
-        requestLineData = LineDataPtr(new LineDataScattering(
-                transferFunctionWindow, rendererVk
-        ));
-        hasRequest = true;
-    }
-    hasRequestConditionVariable.notify_all();
-}
-
-bool ScatteringLineTracingRequester::getReply(LineDataPtr& lineData) {
-    bool hasReply;
-    {
-        std::lock_guard<std::mutex> lock(replyMutex);
-        hasReply = this->hasReply;
-        if (hasReply) {
-            lineData = replyLineData;
-        }
-
-        // Now, new requests can be worked on.
-        this->hasReply = false;
-        // this->replyMessage.clear();
-        this->replyLineData = LineDataPtr();
-    }
-    hasReplyConditionVariable.notify_all();
-    return hasReply;
-}
-
-void ScatteringLineTracingRequester::join() {
-    if (!programIsFinished) {
-        {
-            std::lock_guard<std::mutex> lockRequest(requestMutex);
-            programIsFinished = true;
-            hasRequest = true;
-
-            {
-                std::lock_guard<std::mutex> lockReply(replyMutex);
-                this->hasReply = false;
-                // this->replyMessage.clear();
-            }
-            hasReplyConditionVariable.notify_all();
-        }
-        hasRequestConditionVariable.notify_all();
-        if (requesterThread.joinable()) {
-            requesterThread.join();
-        }
-    }
-}
-
-void ScatteringLineTracingRequester::mainLoop() {
-#ifdef TRACY_ENABLE
-    tracy::SetThreadName("ScatteringLineTracingRequester");
-#endif
-
-    while (true) {
-        std::unique_lock<std::mutex> requestLock(requestMutex);
-        hasRequestConditionVariable.wait(requestLock, [this] { return hasRequest; });
-
-        if (programIsFinished) {
-            break;
-        }
-
-        if (hasRequest) {
-            ScatteringTracingSettings request = workerTracingSettings;
-            std::shared_ptr<LineDataScattering> lineData =
-                    std::static_pointer_cast<LineDataScattering>(requestLineData);
-            hasRequest = false;
-            isProcessingRequest = true;
-            requestLock.unlock();
-
-            traceLines(request, lineData);
-
-            std::lock_guard<std::mutex> replyLock(replyMutex);
-            hasReply = true;
-
-            replyLineData = lineData;
-            isProcessingRequest = false;
+    std::shared_ptr<LineDataScattering> lineData(new LineDataScattering(
+            transferFunctionWindow, rendererVk
+    ));
+    requestScheduler->queueJob([this, request, lineData](LineDataPtr& reply, JobToken& jobToken) mutable {
+        if (!traceLines(request, lineData, jobToken)) {
+            return false;
         }
-
-        // Only one operation if this function is not run in a separate thread.
-        if (!supportsMultiThreadedLoading) {
-            break;
-        }
-    }
+        reply = lineData;
+        return true;
+    });
 }
 
-void ScatteringLineTracingRequester::traceLines(
-        const ScatteringTracingSettings& request, std::shared_ptr<LineDataScattering>& lineData)
+bool ScatteringLineTracingRequester::traceLines(
+        const ScatteringTracingSettings& request, std::shared_ptr<LineDataScattering>& lineData,
+        JobToken& jobToken)
 {
     std::string data_set_filename = request.dataset_filename;
     bool use_iso_surface = request.show_iso_surface;
@@ -396,105 +315,97 @@ void ScatteringLineTracingRequester::traceLines(
     // if the user changed the file
     if (data_set_filename != cachedGridFileName) {
         cachedGrid.delete_maybe();
+        cachedGrid = {};
+        cachedSparseCloudData = {};
         cachedGridFileName = data_set_filename;
-        cachedGrid = load_xyz_file(cachedGridFileName);
-
-        if (use_iso_surface) {
-            createScalarFieldTexture();
-            createIsosurface();
+        cachedMajorantGrid.clear();
+        outlineTriangleIndices.clear();
+        outlineVertexPositions.clear();
+        outlineVertexNormals.clear();
+
+        if (sgl::FileUtils::get()->hasExtension(cachedGridFileName.c_str(), ".nvdb")) {
+            // The sparse grid is sampled directly; the tree nodes give the local majorants.
+            auto cloudData = std::make_shared<CloudData>();
+            if (cloudData->loadFromFile(cachedGridFileName) && cloudData->getSparseGrid()) {
+                cachedSparseCloudData = cloudData;
+            } else {
+                sgl::Logfile::get()->writeError(
+                        "Error in ScatteringLineTracingRequester::traceLines: Couldn't load a float grid from the "
+                        "NanoVDB file \"" + cachedGridFileName + "\".");
+            }
+        } else {
+            cachedGrid = load_xyz_file(cachedGridFileName);
+            if (use_iso_surface && cachedGrid.data) {
+                createScalarFieldTexture();
+                createIsosurface();
+            }
         }
     }
-
-    PathInfo pi {};
-    pi.camera_pos    = request.camera_position;
-    pi.ray_direction = glm::normalize(request.camera_look_at - request.camera_position);
+    if (!cachedGrid.data && !cachedSparseCloudData) {
+        return false;
+    }
 
     VolumeInfo vi {};
     vi.grid              = cachedGrid;
     vi.extinction        = request.extinction;
     vi.scattering_albedo = request.scattering_albedo;
     vi.g                 = request.g;
-
-    float camera_fov_deg       = request.camera_fov_deg;
-    uint32_t res_x             = request.res_x;
-    uint32_t res_y             = request.res_y;
-    uint32_t samples_per_pixel = request.samples_per_pixel;
-
-
-    Trajectories trajectories;
-    Exit_Directions exit_directions;
-    pi.pass_number = 0;
-    Random::init(request.seed);
-
-    { // NEW
-
-        glm::vec3 Y = { 0, -1, 0 };
-        glm::vec3 X = glm::cross(pi.ray_direction, Y);
-        Y = glm::cross(X, pi.ray_direction);
-
-        float focal_length        = 1;  // how far away from the camera the grid will be
-        float camera_fov_rad = glm::radians(camera_fov_deg);
-        float grid_width     = tan(camera_fov_rad / 2) * 2 * focal_length;
-        float grid_height    = res_y * (grid_width / res_x);
-
-        glm::vec3 P0 =
-            pi.camera_pos +
-            pi.ray_direction * focal_length -
-            0.5f * Y * grid_height -
-            0.5f * X * grid_width;
-
-        // Pixel loop
-        for (uint32_t y = 0; y < res_y; ++y) {
-            for (uint32_t x = 0; x < res_x; ++x) {
-
-                // NOTE(Felix): these percentage values tell us how far along
-                //   the x and y axis we are, while rendering the pixels. This
-                //   is used to find out the direction onto which we send the
-                //   ray. If the resolution in a dimension is 1, we send the ray
-                //   in the middle, the calculation would otherwise lead to a
-                //   divison-by-zero. Maybe this is too complicated. Is there a
-                //   simper way?
-                float x_percentage;
-                float y_percentage;
-                if (res_x < 2) {
-                    x_percentage = 0.5f;
-                } else {
-                    x_percentage = (x*1.0f/(res_x-1));
-                }
-
-                if (res_y < 2) {
-                    y_percentage = 0.5f;
-                } else {
-                    y_percentage = (y*1.0f/(res_y-1));
-                }
-
-                glm::vec3 P =
-                    P0 +
-                    X * x_percentage * grid_width +
-                    Y * y_percentage * grid_height;
-
-                P = glm::normalize(P - pi.camera_pos);
-                pi.ray_direction = P;
-
-                // Sample loop
-                for (uint32_t i = 0; i < samples_per_pixel; ++i) {
-                    pi.pass_number = i;
-                    dt_path_trace(pi, vi, &trajectories, &exit_directions);
-                }
-            }
+    if (cachedSparseCloudData) {
+        vi.sparse_grid = cachedSparseCloudData->getSparseGrid();
+    } else if (request.use_majorant_grid) {
+        if (cachedMajorantGrid.empty()) {
+            cachedMajorantGrid.build(cachedGrid);
         }
+        vi.majorant_grid = &cachedMajorantGrid;
     }
 
-    lineData->setExitDirections(exit_directions);
-
-    lineData->setDataSetInformation(gridDataSetFilename, { "Attribute #1" });
-    lineData->setTrajectoryData(trajectories);
-    lineData->setGridData(
-            cachedScalarFieldTexture,
-            outlineTriangleIndices, outlineVertexPositions, outlineVertexNormals,
-            cachedGrid.data, cachedGrid.size_x, cachedGrid.size_y, cachedGrid.size_z,
-            cachedGrid.voxel_size_x, cachedGrid.voxel_size_y, cachedGrid.voxel_size_z);
-
+    // The line data adopts the arrays of the kept paths, so they are never held twice and get the full budget.
+    size_t max_path_memory_bytes = size_t(request.max_path_memory_mib) * size_t(1024 * 1024);
+    ScatteringEventStream paths;
+    auto exit_direction_histogram = std::make_unique<SphericalHistogram>();
+    PathTraceStatistics statistics;
+    auto startTime = std::chrono::steady_clock::now();
+    bool finished = trace_scattering_paths(
+            vi, request.camera_position, request.camera_look_at, request.camera_fov_deg,
+            request.res_x, request.res_y, request.samples_per_pixel, request.seed, max_path_memory_bytes,
+            paths, &statistics, exit_direction_histogram.get(), [&jobToken](float progress) {
+                if (jobToken.getIsCancelled()) {
+                    return false;
+                }
+                jobToken.setProgress(progress);
+                return true;
+            });
+    if (!finished) {
+        return false;
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+    sgl::Logfile::get()->writeInfo(
+            "ScatteringLineTracingRequester::traceLines: Traced " + std::to_string(statistics.num_paths)
+            + " paths in " + std::to_string(elapsedSeconds) + "s ("
+            + std::to_string(double(statistics.num_paths) / std::max(elapsedSeconds, 1e-9)) + " paths/s, "
+            + std::to_string(statistics.num_density_lookups) + " density lookups, "
+            + std::to_string(statistics.num_null_collisions) + " null collisions, "
+            + std::to_string(statistics.num_scattering_events) + " scattering events, "
+            + std::to_string(statistics.num_absorption_events) + " absorption events). Kept "
+            + std::to_string(paths.get_num_paths()) + " paths ("
+            + std::to_string(double(paths.get_memory_size()) / (1024.0 * 1024.0)) + " MiB).");
+
+    lineData->setExitDirections(std::move(paths.exit_directions));
+    lineData->setExitDirectionHistogram(std::move(exit_direction_histogram));
+
+    lineData->setDataSetInformation(gridDataSetFilename, { "Event Type" });
+    lineData->setTrajectoryData(paths.move_to_trajectory_store());
+    if (cachedSparseCloudData) {
+        lineData->setSparseGridData(cachedSparseCloudData);
+    } else {
+        lineData->setGridData(
+                cachedScalarFieldTexture,
+                outlineTriangleIndices, outlineVertexPositions, outlineVertexNormals,
+                cachedGrid.data, cachedGrid.size_x, cachedGrid.size_y, cachedGrid.size_z,
+                cachedGrid.voxel_size_x, cachedGrid.voxel_size_y, cachedGrid.voxel_size_z);
+    }
+    return true;
 }
 
 void ScatteringLineTracingRequester::createScalarFieldTexture() {
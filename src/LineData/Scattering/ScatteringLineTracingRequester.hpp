@@ -29,13 +29,14 @@
 #ifndef LINEVIS_SCATTERINGLINETRACINGREQUESTER_HPP
 #define LINEVIS_SCATTERINGLINETRACINGREQUESTER_HPP
 
-#include <thread>
-#include <condition_variable>
 #include <json/json.h>
 
 #include "Loaders/DataSetList.hpp"
+#include "Utils/RequestScheduler.hpp"
 #include "LineDataScattering.hpp"
 #include "Texture3d.hpp"
+#include "MajorantGrid.hpp"
+#include "CloudData.hpp"
 
 struct ScatteringTracingSettings {
     bool show_iso_surface         = true;
@@ -55,6 +56,12 @@ struct ScatteringTracingSettings {
     glm::vec3 extinction        = { 1024, 1024, 1024};
     glm::vec3 scattering_albedo = {    1,    1,    1};
     float g                     = 0.2f;
+
+    // Whether to sample the free-flight distances against the local majorants of a super voxel grid.
+    bool use_majorant_grid      = true;
+    // Upper bound for the memory of the paths kept for rendering; 0 keeps all paths. If the traced paths need more
+    // memory, a uniform random subset of them is kept. The statistics and the exit direction histogram use all paths.
+    uint32_t max_path_memory_mib = 1024;
 };
 
 /**
@@ -75,7 +82,11 @@ public:
     /**
      * @return Whether a request is currently processed (for UI progress spinner).
      */
-    [[nodiscard]] inline bool getIsProcessingRequest() const { return isProcessingRequest; }
+    [[nodiscard]] inline bool getIsProcessingRequest() const { return requestScheduler->getIsProcessingRequest(); }
+    /**
+     * @return The progress of the request currently processed in the range [0, 1], or a negative value if unknown.
+     */
+    [[nodiscard]] inline float getProgress() const { return requestScheduler->getProgress(); }
 
     inline void setShowWindow(bool _showWindow) { showWindow = _showWindow; }
 
@@ -83,45 +94,27 @@ private:
     void loadGridDataSetList();
     void requestNewData();
 
-    /// The main loop of the requester thread.
-    void mainLoop();
-    /// Waits for the requester thread to terminate.
-    void join();
-
     /**
-     * Queues the request for tracing .
+     * Queues the request for tracing. A request that is still being processed is cancelled.
      * @param request The message to queue.
      */
     void queueRequestStruct(const ScatteringTracingSettings& request);
-    /**
-     * Checks if a reply was received to a request.
-     * @return Whether a reply was received.
-     */
-    bool getReply(LineDataPtr& lineData);
 
     /**
      * @param request Information for the requested tracing of lines scattered in the grid.
+     * @param jobToken Polled for cancellation and used for reporting the progress.
+     * @return False if the request was cancelled before it could be finished.
      */
-    void traceLines(const ScatteringTracingSettings& request, std::shared_ptr<LineDataScattering>& lineData);
+    bool traceLines(
+            const ScatteringTracingSettings& request, std::shared_ptr<LineDataScattering>& lineData,
+            JobToken& jobToken);
 
     sgl::TransferFunctionWindow& transferFunctionWindow;
     sgl::vk::Renderer* rendererVk = nullptr;
 
     bool supportsMultiThreadedLoading = true;
-    std::thread requesterThread;
-    std::condition_variable hasRequestConditionVariable;
-    std::condition_variable hasReplyConditionVariable;
-    std::mutex requestMutex;
-    std::mutex replyMutex;
-
-    bool programIsFinished = false;
-    bool hasRequest = false;
-    bool hasReply = false;
-    bool isProcessingRequest = false;
-
-    ScatteringTracingSettings workerTracingSettings;
-    LineDataPtr requestLineData;
-    LineDataPtr replyLineData;
+    // Runs the requests synchronously if multi-threaded loading is not supported.
+    std::unique_ptr<RequestScheduler<LineDataPtr>> requestScheduler;
 
     // Line tracing settings.
     ScatteringTracingSettings guiTracingSettings;
@@ -129,6 +122,9 @@ private:
     // Cache.
     std::string cachedGridFileName;
     Texture3D   cachedGrid = {};
+    MajorantGrid cachedMajorantGrid;
+    /// Set instead of cachedGrid for sparse (.nvdb) data sets, which are traced without a dense copy.
+    CloudDataPtr cachedSparseCloudData;
 
     std::vector<uint32_t> outlineTriangleIndices;
     std::vector<glm::vec3> outlineVertexPositions;
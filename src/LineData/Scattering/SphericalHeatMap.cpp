@@ -0,0 +1,412 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include <Graphics/Color.hpp>
+
+#include "SphericalHeatMap.hpp"
+
+namespace {
+
+const float pi = 3.1415926535897932384626433832795f;
+const float two_pi = 6.283185307179586476925286766559f;
+
+const float search_radius = 0.1f;
+const float rbf_epsilon = 3.0f;
+
+/// Number of bins per standard deviation of the Gaussian kernel used by compute_spherical_heatmap_values.
+const float bins_per_kernel_sigma = 2.0f;
+const int kernel_table_size = 256;
+
+/**
+ * Computes the direction of pixel (x, y) of the inverse Mollweide projection.
+ * @return False if the pixel lies outside of the ellipse.
+ */
+bool get_mollweide_pixel_direction(uint32_t x, uint32_t y, uint32_t width, uint32_t height, glm::vec3& direction) {
+    float u = -1.0f + (1.0f * x / (width - 1)) * 2.0f; // from   -1 to 1
+    float v = -0.5f + (1.0f * y / (height - 1));       // from -0.5 to 0.5
+    if (u * u + 4.0f * v * v > 1.0f) {
+        return false;
+    }
+
+    const float two_sqrt_two = 2.0f * std::sqrt(2.0f);
+    float x_inner = two_sqrt_two * u;
+    float y_inner = two_sqrt_two * v;
+
+    float z = float(std::sqrt(1 - std::pow(x_inner / 4, 2) - std::pow(y_inner / 2, 2)));
+
+    float lambda = float(2 * std::atan((z * x_inner) / (2 * (2 * std::pow(z, 2) - 1)))); // from -pi to pi
+    float phi    = std::asin(z * y_inner);                                               // from -pi/2 to pi/2
+
+    // The x axis rotated by phi around the z axis and then by lambda around the y axis.
+    direction = glm::vec3(std::cos(phi) * std::cos(lambda), std::sin(phi), -std::cos(phi) * std::sin(lambda));
+    return true;
+}
+
+}
+
+SphericalBinGrid::SphericalBinGrid(float bin_size) {
+    num_rows = std::max(int(std::ceil(pi / bin_size)), 1);
+    row_theta_size = pi / float(num_rows);
+    row_offsets.resize(num_rows + 1);
+    row_offsets[0] = 0;
+    for (int row = 0; row < num_rows; row++) {
+        float theta_center = (float(row) + 0.5f) * row_theta_size;
+        int num_columns = std::max(int(std::round(two_pi * std::sin(theta_center) / row_theta_size)), 1);
+        row_offsets[row + 1] = row_offsets[row] + num_columns;
+    }
+}
+
+void SphericalBinGrid::get_polar_coordinates(const glm::vec3& direction, float& theta, float& phi) {
+    theta = std::acos(std::clamp(direction.y, -1.0f, 1.0f));
+    phi = std::atan2(-direction.z, direction.x); // from -pi to pi
+}
+
+int SphericalBinGrid::get_column(int row, float phi) const {
+    int num_columns = get_num_columns(row);
+    return std::clamp(int((phi + pi) / two_pi * float(num_columns)), 0, num_columns - 1);
+}
+
+int SphericalBinGrid::get_bin_idx(const glm::vec3& direction) const {
+    float theta, phi;
+    get_polar_coordinates(direction, theta, phi);
+    int row = get_row(theta);
+    return row_offsets[row] + get_column(row, phi);
+}
+
+glm::vec3 SphericalBinGrid::get_bin_center(int row, int column) const {
+    float theta = (float(row) + 0.5f) * row_theta_size;
+    float phi = (float(column) + 0.5f) / float(get_num_columns(row)) * two_pi - pi;
+    return { std::sin(theta) * std::cos(phi), std::cos(theta), -std::sin(theta) * std::sin(phi) };
+}
+
+float SphericalBinGrid::interpolate_row(const std::vector<float>& bin_values, int row, float phi) const {
+    int num_columns = get_num_columns(row);
+    float column_coord = (phi + pi) / two_pi * float(num_columns) - 0.5f;
+    float column_floor = std::floor(column_coord);
+    float t = column_coord - column_floor;
+    int column0 = (int(column_floor) % num_columns + num_columns) % num_columns;
+    int column1 = (column0 + 1) % num_columns;
+    const float* row_values = bin_values.data() + row_offsets[row];
+    return row_values[column0] * (1.0f - t) + row_values[column1] * t;
+}
+
+SphericalHistogram::SphericalHistogram()
+        : bin_grid(search_radius / (rbf_epsilon * std::sqrt(2.0f)) / bins_per_kernel_sigma) {
+    clear();
+}
+
+void SphericalHistogram::clear() {
+    direction_sums.assign(size_t(bin_grid.get_num_bins()), glm::vec3(0.0f));
+    counts.assign(size_t(bin_grid.get_num_bins()), 0);
+    num_directions = 0;
+}
+
+void SphericalHistogram::add(const glm::vec3& direction) {
+    int bin_idx = bin_grid.get_bin_idx(direction);
+    direction_sums[bin_idx] += direction;
+    counts[bin_idx]++;
+    num_directions++;
+}
+
+void SphericalHistogram::add(const SphericalHistogram& other) {
+    assert(bin_grid.row_offsets == other.bin_grid.row_offsets);
+    for (size_t bin_idx = 0; bin_idx < counts.size(); bin_idx++) {
+        direction_sums[bin_idx] += other.direction_sums[bin_idx];
+        counts[bin_idx] += other.counts[bin_idx];
+    }
+    num_directions += other.num_directions;
+}
+
+void compute_spherical_heatmap_values_kd_tree(
+        sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height, std::vector<float>& values) {
+    uint32_t image_width = image_height * 2;
+    assert(image_height > 1);
+    values.resize(size_t(image_width) * size_t(image_height));
+
+    std::vector<std::pair<glm::vec3, sgl::Empty>> searchCache;
+    for (uint32_t y = 0; y < image_height; ++y) {
+        for (uint32_t x = 0; x < image_width; ++x) {
+            float& value = values[y * image_width + x];
+            glm::vec3 point_on_sphere;
+            if (!get_mollweide_pixel_direction(x, y, image_width, image_height, point_on_sphere)) {
+                // we are outside the ellipse
+                value = -1.0f;
+                continue;
+            }
+
+            searchCache.clear();
+            kd_tree->findPointsAndDataInSphere(point_on_sphere, search_radius, searchCache);
+
+            value = 0.0f;
+            for (std::pair<glm::vec3, sgl::Empty>& hit : searchCache) {
+                glm::vec3 pos = hit.first;
+                float dist = glm::length(point_on_sphere - pos);
+                float rbf_param = dist / search_radius;
+                value += (float)std::exp(-(float)std::pow(rbf_epsilon * rbf_param,2));
+            }
+        }
+    }
+}
+
+void compute_spherical_heatmap_values(
+        const SphericalHistogram& histogram, uint32_t image_height, std::vector<float>& values) {
+    uint32_t image_width = image_height * 2;
+    assert(image_height > 1);
+    values.resize(size_t(image_width) * size_t(image_height));
+
+    // Each bin stores the normalized mean direction (xyz) and the number of directions (w).
+    const SphericalBinGrid& bin_grid = histogram.bin_grid;
+    auto num_bins = size_t(bin_grid.get_num_bins());
+    std::vector<glm::vec4> bins(num_bins, glm::vec4(0.0f));
+    for (size_t bin_idx = 0; bin_idx < num_bins; bin_idx++) {
+        if (histogram.counts[bin_idx] > 0) {
+            bins[bin_idx] = glm::vec4(
+                    glm::normalize(histogram.direction_sums[bin_idx]), float(histogram.counts[bin_idx]));
+        }
+    }
+
+    // The kernel only depends on the squared chord distance, which is tabulated in [0, search_radius^2].
+    const float squared_search_radius = search_radius * search_radius;
+    const float kernel_table_scale = float(kernel_table_size - 1) / squared_search_radius;
+    const float max_table_coord = float(kernel_table_size - 2);
+    float kernel_table[kernel_table_size];
+    for (int i = 0; i < kernel_table_size; i++) {
+        float squared_distance = float(i) / kernel_table_scale;
+        kernel_table[i] = std::exp(-rbf_epsilon * rbf_epsilon * squared_distance / squared_search_radius);
+    }
+
+    // Convolve the binned directions with the kernel at the bin centers. All directions with a chord distance below
+    // search_radius from a bin center lie in a spherical cap with the angular radius cap_angle around the center.
+    const float cap_angle = 2.0f * std::asin(0.5f * search_radius);
+    std::vector<float> bin_values(num_bins);
+    int num_rows = bin_grid.num_rows;
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_rows), [&](auto const& r) {
+        for (auto row = r.begin(); row != r.end(); row++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic) shared(num_rows, bin_grid, bins) \
+        shared(bin_values, kernel_table, kernel_table_scale, max_table_coord, squared_search_radius, cap_angle)
+    for (int row = 0; row < num_rows; row++) {
+#endif
+        float theta_center = (float(row) + 0.5f) * bin_grid.row_theta_size;
+        int source_row_min = bin_grid.get_row(theta_center - cap_angle);
+        int source_row_max = bin_grid.get_row(theta_center + cap_angle);
+        bool cap_contains_pole = theta_center - cap_angle <= 0.0f || theta_center + cap_angle >= pi;
+        float cap_phi_extent = cap_contains_pole ? pi : std::asin(std::sin(cap_angle) / std::sin(theta_center));
+        int num_columns = bin_grid.get_num_columns(row);
+        for (int column = 0; column < num_columns; column++) {
+            glm::vec3 center = bin_grid.get_bin_center(row, column);
+            float phi_center = (float(column) + 0.5f) / float(num_columns) * two_pi - pi;
+            float value = 0.0f;
+            for (int source_row = source_row_min; source_row <= source_row_max; source_row++) {
+                int num_source_columns = bin_grid.get_num_columns(source_row);
+                int source_column_min = 0;
+                int source_column_max = num_source_columns - 1;
+                if (!cap_contains_pole) {
+                    source_column_min = int(std::floor(
+                            (phi_center - cap_phi_extent + pi) / two_pi * float(num_source_columns)));
+                    source_column_max = int(std::floor(
+                            (phi_center + cap_phi_extent + pi) / two_pi * float(num_source_columns)));
+                    if (source_column_max - source_column_min >= num_source_columns) {
+                        source_column_min = 0;
+                        source_column_max = num_source_columns - 1;
+                    }
+                }
+                // The column range may wrap around at phi = +-pi; it is split into at most two contiguous ranges.
+                const glm::vec4* row_bins = bins.data() + bin_grid.row_offsets[source_row];
+                for (int range_idx = 0; range_idx < 2; range_idx++) {
+                    int column_begin, column_end;
+                    if (range_idx == 0) {
+                        column_begin = std::max(source_column_min, 0);
+                        column_end = std::min(source_column_max, num_source_columns - 1) + 1;
+                    } else if (source_column_min < 0) {
+                        column_begin = source_column_min + num_source_columns;
+                        column_end = num_source_columns;
+                    } else if (source_column_max >= num_source_columns) {
+                        column_begin = 0;
+                        column_end = source_column_max - num_source_columns + 1;
+                    } else {
+                        break;
+                    }
+                    for (int source_column = column_begin; source_column < column_end; source_column++) {
+                        // Branchless; empty bins have the weight zero, and directions outside of the search radius
+                        // are clamped to the last table entry and masked out.
+                        const glm::vec4& bin = row_bins[source_column];
+                        glm::vec3 diff = center - glm::vec3(bin);
+                        float squared_distance = glm::dot(diff, diff);
+                        float weight = squared_distance < squared_search_radius ? bin.w : 0.0f;
+                        float table_coord = std::min(squared_distance * kernel_table_scale, max_table_coord);
+                        auto table_idx = int(table_coord);
+                        float t = table_coord - float(table_idx);
+                        value += weight * (kernel_table[table_idx] * (1.0f - t) + kernel_table[table_idx + 1] * t);
+                    }
+                }
+            }
+            bin_values[bin_grid.row_offsets[row] + column] = value;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    // Interpolate the pixel values from the bin centers (linearly along and between the rows).
+    auto image_height_int = int(image_height);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, image_height_int), [&](auto const& r) {
+        for (auto y = r.begin(); y != r.end(); y++) {
+#else
+#pragma omp parallel for default(none) shared(image_height_int, image_width, image_height, bin_grid, bin_values, values)
+    for (int y = 0; y < image_height_int; y++) {
+#endif
+        for (uint32_t x = 0; x < image_width; ++x) {
+            float& value = values[size_t(y) * size_t(image_width) + size_t(x)];
+            glm::vec3 direction;
+            if (!get_mollweide_pixel_direction(x, uint32_t(y), image_width, image_height, direction)) {
+                value = -1.0f;
+                continue;
+            }
+            float theta, phi;
+            SphericalBinGrid::get_polar_coordinates(direction, theta, phi);
+            float row_coord = std::clamp(
+                    theta / bin_grid.row_theta_size - 0.5f, 0.0f, float(bin_grid.num_rows - 1));
+            auto row0 = int(row_coord);
+            int row1 = std::min(row0 + 1, bin_grid.num_rows - 1);
+            float t = row_coord - float(row0);
+            value = bin_grid.interpolate_row(bin_values, row0, phi) * (1.0f - t)
+                    + bin_grid.interpolate_row(bin_values, row1, phi) * t;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+void compute_spherical_heatmap_values(
+        const std::vector<glm::vec3>& exit_directions, uint32_t image_height, std::vector<float>& values) {
+    SphericalHistogram histogram;
+    auto num_directions = int(exit_directions.size());
+    std::vector<int> direction_bins(exit_directions.size());
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_directions), [&](auto const& r) {
+        for (auto i = r.begin(); i != r.end(); i++) {
+#else
+#pragma omp parallel for default(none) shared(num_directions, exit_directions, histogram, direction_bins)
+    for (int i = 0; i < num_directions; i++) {
+#endif
+        direction_bins[i] = histogram.bin_grid.get_bin_idx(exit_directions[i]);
+    }
+#ifdef USE_TBB
+    });
+#endif
+    for (int i = 0; i < num_directions; i++) {
+        histogram.direction_sums[direction_bins[i]] += exit_directions[i];
+        histogram.counts[direction_bins[i]]++;
+    }
+    histogram.num_directions = exit_directions.size();
+    compute_spherical_heatmap_values(histogram, image_height, values);
+}
+
+Image create_spherical_heatmap_image(const std::vector<float>& values, uint32_t image_height) {
+    Image out_image;
+    out_image.width  = image_height * 2;
+    out_image.height = image_height;
+    out_image.allocate();
+
+    assert(out_image.width > 0);
+    assert(out_image.height > 0);
+    assert(values.size() == size_t(out_image.width) * size_t(out_image.height));
+
+    float max_rbf_value = 0.0f;
+    for (float rbf_value : values) {
+        max_rbf_value = std::max(rbf_value, max_rbf_value);
+    }
+
+    auto num_pixels = int(values.size());
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_pixels), [&](auto const& r) {
+        for (auto i = r.begin(); i != r.end(); i++) {
+#else
+#pragma omp parallel for default(none) shared(num_pixels, values, out_image, max_rbf_value)
+    for (int i = 0; i < num_pixels; i++) {
+#endif
+        Pixel* p = &out_image.pixels[i];
+        auto rbf_value = values[i];
+        if (rbf_value == -1.0f) {
+            p->r = 0;
+            p->g = 0;
+            p->b = 0;
+            p->a = 0;
+        } else {
+            sgl::Color result;
+            // NOTE(Felix): poor man's transfer function
+            if (rbf_value < max_rbf_value/2) {
+                // blue to green gradient
+                result = sgl::colorLerp({0,0,255,255}, {0,255,0,255}, 2.0f*rbf_value/max_rbf_value);
+            } else {
+                // green to red gradient
+                result = sgl::colorLerp({0,255,0,255}, {255,0,0,255}, 2.0f*rbf_value/max_rbf_value-1.0f);
+            }
+            p->r = result.getR();
+            p->g = result.getG();
+            p->b = result.getB();
+            p->a = 255;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    return out_image;
+}
+
+Image create_spherical_heatmap_image(sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height) {
+    std::vector<float> values;
+    compute_spherical_heatmap_values_kd_tree(kd_tree, image_height, values);
+    return create_spherical_heatmap_image(values, image_height);
+}
+
+Image create_spherical_heatmap_image(const std::vector<glm::vec3>& exit_directions, uint32_t image_height) {
+    std::vector<float> values;
+    compute_spherical_heatmap_values(exit_directions, image_height, values);
+    return create_spherical_heatmap_image(values, image_height);
+}
+
+Image create_spherical_heatmap_image(const SphericalHistogram& histogram, uint32_t image_height) {
+    std::vector<float> values;
+    compute_spherical_heatmap_values(histogram, image_height, values);
+    return create_spherical_heatmap_image(values, image_height);
+}
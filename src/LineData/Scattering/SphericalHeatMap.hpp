@@ -0,0 +1,111 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <Utils/SearchStructures/KdTree.hpp>
+#include "Image.hpp"
+
+/*
+ * Spherical heat maps of the exit directions of the scattering paths in the Mollweide projection. The images have the
+ * size (2 * image_height) x image_height. The value of a pixel with the direction p on the unit sphere is the sum of the
+ * radial basis function weights exp(-(rbf_epsilon * |p - d| / search_radius)^2) of all exit directions d with
+ * |p - d| < search_radius. Pixels outside of the ellipse get the value -1.
+ */
+
+/**
+ * Grid on the unit sphere with rows of equal polar angle (measured from the y axis) and a number of bins per row that
+ * is proportional to the circumference of the row, i.e., the bins are approximately square and of equal area. The bins
+ * of row r have the indices [row_offsets[r], row_offsets[r + 1]).
+ */
+struct SphericalBinGrid {
+    explicit SphericalBinGrid(float bin_size);
+
+    [[nodiscard]] inline int get_num_bins() const { return row_offsets.back(); }
+    [[nodiscard]] inline int get_num_columns(int row) const { return row_offsets[row + 1] - row_offsets[row]; }
+    [[nodiscard]] inline int get_row(float theta) const {
+        return std::clamp(int(theta / row_theta_size), 0, num_rows - 1);
+    }
+    [[nodiscard]] int get_column(int row, float phi) const;
+    [[nodiscard]] int get_bin_idx(const glm::vec3& direction) const;
+    [[nodiscard]] glm::vec3 get_bin_center(int row, int column) const;
+    /// Linearly interpolates the per-bin values along the row at the azimuth phi.
+    [[nodiscard]] float interpolate_row(const std::vector<float>& bin_values, int row, float phi) const;
+
+    /// Returns the polar angle theta in [0, pi] and the azimuth phi in [-pi, pi] of the passed direction.
+    static void get_polar_coordinates(const glm::vec3& direction, float& theta, float& phi);
+
+    int num_rows;
+    float row_theta_size;
+    std::vector<int> row_offsets;
+};
+
+/**
+ * Histogram of directions on a SphericalBinGrid that resolves the kernel of the heat maps. Each bin stores the number
+ * of directions and their sum, so that histograms can be merged and the mean direction of each bin is known.
+ */
+struct SphericalHistogram {
+    SphericalHistogram();
+    void clear();
+    void add(const glm::vec3& direction);
+    void add(const SphericalHistogram& other);
+
+    SphericalBinGrid bin_grid;
+    std::vector<glm::vec3> direction_sums;
+    std::vector<uint32_t> counts;
+    uint64_t num_directions = 0;
+};
+
+/**
+ * Reference implementation; queries the k-d tree of the exit directions once per pixel.
+ */
+void compute_spherical_heatmap_values_kd_tree(
+        sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height, std::vector<float>& values);
+
+/**
+ * Parallel approximation of compute_spherical_heatmap_values_kd_tree. The exit directions are binned into a
+ * SphericalHistogram, whose bins are much smaller than the kernel. The binned directions are convolved with a tabulated
+ * kernel at the bin centers, and the pixel values are interpolated from the bin centers. The cost thus depends on the
+ * kernel size, but hardly on the number of exit directions or the image resolution.
+ */
+void compute_spherical_heatmap_values(
+        const std::vector<glm::vec3>& exit_directions, uint32_t image_height, std::vector<float>& values);
+void compute_spherical_heatmap_values(
+        const SphericalHistogram& histogram, uint32_t image_height, std::vector<float>& values);
+
+/**
+ * Maps the heat map values to colors (blue to green to red) relative to the maximum value.
+ */
+Image create_spherical_heatmap_image(const std::vector<float>& values, uint32_t image_height);
+
+Image create_spherical_heatmap_image(sgl::KdTree<sgl::Empty>* kd_tree, uint32_t image_height);
+Image create_spherical_heatmap_image(const std::vector<glm::vec3>& exit_directions, uint32_t image_height);
+Image create_spherical_heatmap_image(const SphericalHistogram& histogram, uint32_t image_height);
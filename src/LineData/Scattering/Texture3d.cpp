@@ -127,7 +127,7 @@ Texture3D load_xyz_file(std::string file_name) {
     return grid;
 }
 
-float Texture3D::sample_at(glm::vec3 pos) {
+float Texture3D::sample_at(glm::vec3 pos) const {
     // cubic interpolation
 
 # define IDX(x, y, z) ((x) + ((y) + (z) * size_y) * size_x)
@@ -44,7 +44,7 @@ struct Texture3D {
 
     // ---------------------------- //
 
-    float sample_at(glm::vec3 pos);
+    float sample_at(glm::vec3 pos) const;
     void delete_maybe();
 };
 
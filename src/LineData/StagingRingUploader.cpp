@@ -0,0 +1,156 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#include <Utils/File/Logfile.hpp>
+#include <Graphics/Vulkan/Utils/Device.hpp>
+#include <Graphics/Vulkan/Utils/SyncObjects.hpp>
+#include <Graphics/Vulkan/Buffers/Buffer.hpp>
+
+#include "StagingRingUploader.hpp"
+
+StagingRingUploader::StagingRingUploader(
+        sgl::vk::Device* device, size_t stagingBufferSizeInBytes, size_t numStagingBuffers)
+        : device(device), stagingBufferSizeInBytes(stagingBufferSizeInBytes) {
+    if (stagingBufferSizeInBytes == 0 || numStagingBuffers == 0) {
+        sgl::Logfile::get()->throwError(
+                "Error in StagingRingUploader::StagingRingUploader: Invalid staging buffer configuration.");
+    }
+
+    sgl::vk::CommandPoolType commandPoolType;
+    commandPoolType.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolType.queueFamilyIndex = device->getGraphicsQueueIndex();
+    std::vector<VkCommandBuffer> commandBuffers = device->allocateCommandBuffers(
+            commandPoolType, &commandPool, uint32_t(numStagingBuffers));
+
+    slots.resize(numStagingBuffers);
+    for (size_t slotIdx = 0; slotIdx < numStagingBuffers; slotIdx++) {
+        StagingSlot& slot = slots.at(slotIdx);
+        slot.stagingBuffer = std::make_shared<sgl::vk::Buffer>(
+                device, stagingBufferSizeInBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+        slot.mappedData = static_cast<uint8_t*>(slot.stagingBuffer->mapMemory());
+        slot.commandBuffer = commandBuffers.at(slotIdx);
+        slot.fence = std::make_shared<sgl::vk::Fence>(device, 0);
+    }
+}
+
+StagingRingUploader::~StagingRingUploader() {
+    finish();
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (StagingSlot& slot : slots) {
+        slot.stagingBuffer->unmapMemory();
+        commandBuffers.push_back(slot.commandBuffer);
+    }
+    device->freeCommandBuffers(commandPool, commandBuffers);
+}
+
+void StagingRingUploader::beginSlot(StagingSlot& slot) {
+    waitSlot(slot);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS) {
+        sgl::Logfile::get()->throwError(
+                "Error in StagingRingUploader::beginSlot: Could not begin recording a command buffer.");
+    }
+    slot.usedSizeInBytes = 0;
+    slot.isRecording = true;
+}
+
+void StagingRingUploader::submitSlot(StagingSlot& slot) {
+    if (!slot.isRecording) {
+        return;
+    }
+    if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) {
+        sgl::Logfile::get()->throwError(
+                "Error in StagingRingUploader::submitSlot: Could not record a command buffer.");
+    }
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &slot.commandBuffer;
+    if (vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, slot.fence->getVkFence()) != VK_SUCCESS) {
+        sgl::Logfile::get()->throwError(
+                "Error in StagingRingUploader::submitSlot: Could not submit a command buffer to the queue.");
+    }
+    slot.isRecording = false;
+    slot.isInFlight = true;
+}
+
+void StagingRingUploader::waitSlot(StagingSlot& slot) {
+    if (!slot.isInFlight) {
+        return;
+    }
+    slot.fence->wait(std::numeric_limits<uint64_t>::max());
+    slot.fence->reset();
+    slot.isInFlight = false;
+}
+
+void StagingRingUploader::uploadData(
+        const sgl::vk::BufferPtr& buffer, size_t dstOffset, size_t sizeInBytes, const void* data) {
+    const auto* srcData = static_cast<const uint8_t*>(data);
+    while (sizeInBytes > 0) {
+        StagingSlot* slot = &slots.at(currentSlotIdx);
+        if (slot->isRecording && slot->usedSizeInBytes == stagingBufferSizeInBytes) {
+            // The current staging buffer is full; hand it to the GPU and continue with the next one.
+            submitSlot(*slot);
+            currentSlotIdx = (currentSlotIdx + 1) % slots.size();
+            slot = &slots.at(currentSlotIdx);
+        }
+        if (!slot->isRecording) {
+            beginSlot(*slot);
+        }
+
+        size_t copySizeInBytes = std::min(sizeInBytes, stagingBufferSizeInBytes - slot->usedSizeInBytes);
+        memcpy(slot->mappedData + slot->usedSizeInBytes, srcData, copySizeInBytes);
+        slot->stagingBuffer->copyDataTo(
+                buffer, slot->usedSizeInBytes, dstOffset, copySizeInBytes, slot->commandBuffer);
+        slot->usedSizeInBytes += copySizeInBytes;
+        srcData += copySizeInBytes;
+        dstOffset += copySizeInBytes;
+        sizeInBytes -= copySizeInBytes;
+    }
+}
+
+void StagingRingUploader::flush() {
+    StagingSlot& slot = slots.at(currentSlotIdx);
+    if (slot.isRecording) {
+        submitSlot(slot);
+        currentSlotIdx = (currentSlotIdx + 1) % slots.size();
+    }
+}
+
+void StagingRingUploader::finish() {
+    flush();
+    for (StagingSlot& slot : slots) {
+        waitSlot(slot);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_STAGINGRINGUPLOADER_HPP
+#define LINEVIS_STAGINGRINGUPLOADER_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace sgl { namespace vk {
+class Device;
+class Buffer;
+typedef std::shared_ptr<Buffer> BufferPtr;
+class Fence;
+typedef std::shared_ptr<Fence> FencePtr;
+}}
+
+/**
+ * Uploads data to device-local buffers using a small ring of host-visible staging buffers.
+ * Copies are recorded into the command buffer of the current staging buffer. When it is full, the command buffer is
+ * submitted asynchronously and the next staging buffer is used. This way, the CPU can already produce the next data
+ * while the GPU is still copying the previous one. A staging buffer is only reused after its fence was signaled, so
+ * the host memory used is bounded by numStagingBuffers * stagingBufferSizeInBytes.
+ */
+class StagingRingUploader {
+public:
+    StagingRingUploader(sgl::vk::Device* device, size_t stagingBufferSizeInBytes, size_t numStagingBuffers = 2);
+    ~StagingRingUploader();
+
+    /**
+     * Copies sizeInBytes bytes from data to the buffer at offset dstOffset. The data can be freed or overwritten
+     * after the call returns. Data larger than one staging buffer is split into multiple copies.
+     */
+    void uploadData(const sgl::vk::BufferPtr& buffer, size_t dstOffset, size_t sizeInBytes, const void* data);
+    /// Submits the pending copies without waiting for them. The next copies use the next staging buffer.
+    void flush();
+    /// Submits all pending copies and waits until all of them have finished.
+    void finish();
+
+private:
+    struct StagingSlot {
+        sgl::vk::BufferPtr stagingBuffer;
+        uint8_t* mappedData = nullptr;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        sgl::vk::FencePtr fence;
+        size_t usedSizeInBytes = 0;
+        bool isRecording = false;
+        bool isInFlight = false;
+    };
+    void beginSlot(StagingSlot& slot);
+    void submitSlot(StagingSlot& slot);
+    void waitSlot(StagingSlot& slot);
+
+    sgl::vk::Device* device;
+    size_t stagingBufferSizeInBytes;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<StagingSlot> slots;
+    size_t currentSlotIdx = 0;
+};
+
+#endif //LINEVIS_STAGINGRINGUPLOADER_HPP
@@ -0,0 +1,333 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "TriangleBatchSplitter.hpp"
+
+namespace {
+
+/// Minimum number of triangles per chunk of the parallel passes.
+const size_t SPLIT_CHUNK_MIN_SIZE = size_t(1) << 16u;
+/// Maximum number of chunks (bounds the memory of the per-chunk histograms).
+const size_t SPLIT_MAX_NUM_CHUNKS = 256;
+const int NUM_SAH_BINS = 16;
+
+struct BatchAabb {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+    inline void combine(const glm::vec3& pt) {
+        min = glm::min(min, pt);
+        max = glm::max(max, pt);
+    }
+    inline void combine(const BatchAabb& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+    [[nodiscard]] inline float getHalfArea() const {
+        if (min.x > max.x) {
+            return 0.0f;
+        }
+        glm::vec3 extent = max - min;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+};
+
+struct SplitPlane {
+    int axis = 0;
+    float position = 0.0f;
+};
+
+/**
+ * Calls functor(chunkIdx) in parallel for all chunks.
+ */
+template<class Functor>
+void parallelForChunks(size_t numChunks, const Functor& functor) {
+    auto numChunksInt = int(numChunks);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numChunksInt), [&](auto const& r) {
+        for (auto chunkIdx = r.begin(); chunkIdx != r.end(); chunkIdx++) {
+#else
+#pragma omp parallel for default(none) shared(numChunksInt, functor) schedule(dynamic, 1)
+    for (int chunkIdx = 0; chunkIdx < numChunksInt; chunkIdx++) {
+#endif
+        functor(size_t(chunkIdx));
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+inline void getTriangleData(
+        const std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        size_t triangleIdx, glm::vec3& centroid, BatchAabb& aabb) {
+    const glm::vec3& p0 = vertexDataList[triangleIndices[triangleIdx * 3]].vertexPosition;
+    const glm::vec3& p1 = vertexDataList[triangleIndices[triangleIdx * 3 + 1]].vertexPosition;
+    const glm::vec3& p2 = vertexDataList[triangleIndices[triangleIdx * 3 + 2]].vertexPosition;
+    centroid = (p0 + p1 + p2) / 3.0f;
+    aabb = BatchAabb();
+    aabb.combine(p0);
+    aabb.combine(p1);
+    aabb.combine(p2);
+}
+
+/// Returns the index of the node at the passed depth containing the centroid (in heap order, root = 0).
+inline uint32_t classifyCentroid(const glm::vec3& centroid, const std::vector<SplitPlane>& splitPlanes, uint32_t depth) {
+    uint32_t nodeIdx = 0;
+    for (uint32_t level = 0; level < depth; level++) {
+        const SplitPlane& splitPlane = splitPlanes[nodeIdx];
+        nodeIdx = 2 * nodeIdx + (centroid[splitPlane.axis] > splitPlane.position ? 2 : 1);
+    }
+    return nodeIdx;
+}
+
+inline SplitPlane computeMidpointSplitPlane(const BatchAabb& region) {
+    glm::vec3 dimensions = region.max - region.min;
+    SplitPlane splitPlane;
+    if (dimensions.x > dimensions.y && dimensions.x > dimensions.z) {
+        splitPlane.axis = 0;
+    } else if (dimensions.y > dimensions.z) {
+        splitPlane.axis = 1;
+    } else {
+        splitPlane.axis = 2;
+    }
+    splitPlane.position = (region.min[splitPlane.axis] + region.max[splitPlane.axis]) / 2.0f;
+    return splitPlane;
+}
+
+struct SahBin {
+    uint32_t count = 0;
+    BatchAabb aabb;
+};
+
+/**
+ * Chooses the split plane between two bins with the lowest SAH cost where both sides get at least a quarter of the
+ * triangles. Falls back to the midpoint split if there is no such plane.
+ */
+SplitPlane computeSahSplitPlane(const BatchAabb& region, const SahBin* nodeBins) {
+    SplitPlane bestSplitPlane = computeMidpointSplitPlane(region);
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; axis++) {
+        const SahBin* bins = nodeBins + axis * NUM_SAH_BINS;
+        uint32_t rightCounts[NUM_SAH_BINS];
+        float rightAreas[NUM_SAH_BINS];
+        BatchAabb rightAabb;
+        uint32_t rightCount = 0;
+        for (int binIdx = NUM_SAH_BINS - 1; binIdx > 0; binIdx--) {
+            rightAabb.combine(bins[binIdx].aabb);
+            rightCount += bins[binIdx].count;
+            rightCounts[binIdx] = rightCount;
+            rightAreas[binIdx] = rightAabb.getHalfArea();
+        }
+        uint32_t totalCount = rightCount + bins[0].count;
+        BatchAabb leftAabb;
+        uint32_t leftCount = 0;
+        for (int binIdx = 0; binIdx < NUM_SAH_BINS - 1; binIdx++) {
+            leftAabb.combine(bins[binIdx].aabb);
+            leftCount += bins[binIdx].count;
+            uint32_t rightCountSplit = rightCounts[binIdx + 1];
+            if (size_t(leftCount) * 4 < totalCount || size_t(rightCountSplit) * 4 < totalCount) {
+                continue;
+            }
+            float cost =
+                    leftAabb.getHalfArea() * float(leftCount) + rightAreas[binIdx + 1] * float(rightCountSplit);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestSplitPlane.axis = axis;
+                bestSplitPlane.position =
+                        region.min[axis]
+                        + float(binIdx + 1) * (region.max[axis] - region.min[axis]) / float(NUM_SAH_BINS);
+            }
+        }
+    }
+    return bestSplitPlane;
+}
+
+}
+
+void splitTrianglesIntoBatches(
+        std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        uint32_t numSubdivisions, TriangleSplitMode splitMode, TubeTriangleSplitData& splitData) {
+    const size_t numTriangles = triangleIndices.size() / 3;
+    const uint32_t numBatches = 1u << numSubdivisions;
+    const uint32_t numInnerNodes = numBatches - 1;
+    size_t numChunks = std::clamp(
+            (numTriangles + SPLIT_CHUNK_MIN_SIZE - 1) / SPLIT_CHUNK_MIN_SIZE, size_t(1), SPLIT_MAX_NUM_CHUNKS);
+    size_t chunkSize = (numTriangles + numChunks - 1) / numChunks;
+    auto getChunkRange = [numTriangles, chunkSize](size_t chunkIdx, size_t& begin, size_t& end) {
+        begin = std::min(chunkIdx * chunkSize, numTriangles);
+        end = std::min(begin + chunkSize, numTriangles);
+    };
+
+    // Bounds of all vertices.
+    std::vector<BatchAabb> chunkAabbs(numChunks);
+    size_t numVertices = vertexDataList.size();
+    size_t vertexChunkSize = (numVertices + numChunks - 1) / numChunks;
+    parallelForChunks(numChunks, [&](size_t chunkIdx) {
+        size_t begin = std::min(chunkIdx * vertexChunkSize, numVertices);
+        size_t end = std::min(begin + vertexChunkSize, numVertices);
+        BatchAabb aabb;
+        for (size_t vertexIdx = begin; vertexIdx < end; vertexIdx++) {
+            aabb.combine(vertexDataList[vertexIdx].vertexPosition);
+        }
+        chunkAabbs[chunkIdx] = aabb;
+    });
+    std::vector<BatchAabb> nodeRegions(numInnerNodes + numBatches);
+    for (const BatchAabb& chunkAabb : chunkAabbs) {
+        nodeRegions[0].combine(chunkAabb);
+    }
+
+    // Compute the split planes top-down (in heap order).
+    std::vector<SplitPlane> splitPlanes(numInnerNodes);
+    std::vector<SahBin> chunkBins;
+    for (uint32_t depth = 0; depth < numSubdivisions; depth++) {
+        uint32_t levelBegin = (1u << depth) - 1;
+        uint32_t numLevelNodes = 1u << depth;
+        if (splitMode == TriangleSplitMode::SAH) {
+            // Bin the centroids of the triangles of all nodes of this level.
+            const size_t numNodeBins = 3 * NUM_SAH_BINS;
+            chunkBins.clear();
+            chunkBins.resize(numChunks * numLevelNodes * numNodeBins);
+            parallelForChunks(numChunks, [&](size_t chunkIdx) {
+                size_t begin, end;
+                getChunkRange(chunkIdx, begin, end);
+                SahBin* bins = chunkBins.data() + chunkIdx * numLevelNodes * numNodeBins;
+                glm::vec3 centroid;
+                BatchAabb triangleAabb;
+                for (size_t triangleIdx = begin; triangleIdx < end; triangleIdx++) {
+                    getTriangleData(triangleIndices, vertexDataList, triangleIdx, centroid, triangleAabb);
+                    uint32_t nodeIdx = classifyCentroid(centroid, splitPlanes, depth);
+                    const BatchAabb& region = nodeRegions[nodeIdx];
+                    SahBin* nodeBins = bins + (nodeIdx - levelBegin) * numNodeBins;
+                    for (int axis = 0; axis < 3; axis++) {
+                        float extent = region.max[axis] - region.min[axis];
+                        int binIdx = 0;
+                        if (extent > 0.0f) {
+                            binIdx = std::clamp(
+                                    int((centroid[axis] - region.min[axis]) / extent * float(NUM_SAH_BINS)),
+                                    0, NUM_SAH_BINS - 1);
+                        }
+                        SahBin& bin = nodeBins[axis * NUM_SAH_BINS + binIdx];
+                        bin.count++;
+                        bin.aabb.combine(triangleAabb);
+                    }
+                }
+            });
+            for (size_t chunkIdx = 1; chunkIdx < numChunks; chunkIdx++) {
+                const SahBin* bins = chunkBins.data() + chunkIdx * numLevelNodes * numNodeBins;
+                for (size_t binIdx = 0; binIdx < numLevelNodes * numNodeBins; binIdx++) {
+                    chunkBins[binIdx].count += bins[binIdx].count;
+                    chunkBins[binIdx].aabb.combine(bins[binIdx].aabb);
+                }
+            }
+        }
+        for (uint32_t nodeIdx = levelBegin; nodeIdx < levelBegin + numLevelNodes; nodeIdx++) {
+            const BatchAabb& region = nodeRegions[nodeIdx];
+            SplitPlane& splitPlane = splitPlanes[nodeIdx];
+            if (splitMode == TriangleSplitMode::SAH) {
+                splitPlane = computeSahSplitPlane(region, chunkBins.data() + (nodeIdx - levelBegin) * 3 * NUM_SAH_BINS);
+            } else {
+                splitPlane = computeMidpointSplitPlane(region);
+            }
+            BatchAabb& leftRegion = nodeRegions[2 * nodeIdx + 1];
+            BatchAabb& rightRegion = nodeRegions[2 * nodeIdx + 2];
+            leftRegion = region;
+            rightRegion = region;
+            leftRegion.max[splitPlane.axis] = splitPlane.position;
+            rightRegion.min[splitPlane.axis] = splitPlane.position;
+        }
+    }
+
+    // Pass 1: Count the triangles and compute the bounds of each batch per chunk.
+    std::vector<uint32_t> chunkBatchOffsets(numChunks * numBatches);
+    std::vector<BatchAabb> chunkBatchAabbs(numChunks * numBatches);
+    parallelForChunks(numChunks, [&](size_t chunkIdx) {
+        size_t begin, end;
+        getChunkRange(chunkIdx, begin, end);
+        uint32_t* counts = chunkBatchOffsets.data() + chunkIdx * numBatches;
+        BatchAabb* aabbs = chunkBatchAabbs.data() + chunkIdx * numBatches;
+        glm::vec3 centroid;
+        BatchAabb triangleAabb;
+        for (size_t triangleIdx = begin; triangleIdx < end; triangleIdx++) {
+            getTriangleData(triangleIndices, vertexDataList, triangleIdx, centroid, triangleAabb);
+            uint32_t batchIdx = classifyCentroid(centroid, splitPlanes, numSubdivisions) - numInnerNodes;
+            counts[batchIdx]++;
+            aabbs[batchIdx].combine(triangleAabb);
+        }
+    });
+
+    // Prefix sum in batch-major order.
+    splitData = {};
+    splitData.numBatchIndices.resize(numBatches);
+    splitData.batchAabbMin.resize(numBatches);
+    splitData.batchAabbMax.resize(numBatches);
+    uint32_t offset = 0;
+    for (uint32_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+        uint32_t batchOffset = offset;
+        BatchAabb batchAabb;
+        for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+            uint32_t& chunkBatchOffset = chunkBatchOffsets[chunkIdx * numBatches + batchIdx];
+            uint32_t count = chunkBatchOffset;
+            chunkBatchOffset = offset;
+            offset += count;
+            batchAabb.combine(chunkBatchAabbs[chunkIdx * numBatches + batchIdx]);
+        }
+        splitData.numBatchIndices[batchIdx] = (offset - batchOffset) * 3;
+        splitData.batchAabbMin[batchIdx] = batchAabb.min;
+        splitData.batchAabbMax[batchIdx] = batchAabb.max;
+    }
+    if (numBatches == 1) {
+        return;
+    }
+
+    // Pass 2: Scatter the triangles of all chunks.
+    std::vector<uint32_t> triangleIndicesSplit(triangleIndices.size());
+    parallelForChunks(numChunks, [&](size_t chunkIdx) {
+        size_t begin, end;
+        getChunkRange(chunkIdx, begin, end);
+        uint32_t* offsets = chunkBatchOffsets.data() + chunkIdx * numBatches;
+        glm::vec3 centroid;
+        BatchAabb triangleAabb;
+        for (size_t triangleIdx = begin; triangleIdx < end; triangleIdx++) {
+            getTriangleData(triangleIndices, vertexDataList, triangleIdx, centroid, triangleAabb);
+            uint32_t batchIdx = classifyCentroid(centroid, splitPlanes, numSubdivisions) - numInnerNodes;
+            size_t writeIdx = size_t(offsets[batchIdx]++) * 3;
+            triangleIndicesSplit[writeIdx] = triangleIndices[triangleIdx * 3];
+            triangleIndicesSplit[writeIdx + 1] = triangleIndices[triangleIdx * 3 + 1];
+            triangleIndicesSplit[writeIdx + 2] = triangleIndices[triangleIdx * 3 + 2];
+        }
+    });
+    triangleIndices.swap(triangleIndicesSplit);
+}
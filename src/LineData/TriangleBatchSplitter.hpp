@@ -0,0 +1,71 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_TRIANGLEBATCHSPLITTER_HPP
+#define LINEVIS_TRIANGLEBATCHSPLITTER_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "LineRenderData.hpp"
+
+/*
+ * Splits a triangle mesh into spatially coherent batches, e.g., for building multiple ray tracing bottom level
+ * acceleration structures. The batches are the leaves of a binary tree of split planes with a depth of
+ * numSubdivisions. Triangles are assigned to a batch by their centroid. The partitioning runs in parallel: The batch
+ * indices of all triangles are counted per chunk of triangles, the scatter offsets are computed with a prefix sum, and
+ * all chunks are scattered in parallel. The triangles of each batch keep their relative order.
+ */
+
+const char* const triangleSplitModeNames[2] = {
+        "Midpoint",
+        "SAH"
+};
+enum class TriangleSplitMode {
+    /// Splits the region of a node in the middle of its largest axis (starting with the AABB of all vertices).
+    MIDPOINT,
+    /**
+     * Chooses the binned split plane with the lowest surface area heuristic cost. Both children need to receive at
+     * least a quarter of the triangles of a node, so the batch sizes stay bounded.
+     */
+    SAH
+};
+
+/**
+ * Reorders the passed triangle indices so that all triangles of a batch are stored consecutively.
+ * @param triangleIndices The triangle indices (three per triangle).
+ * @param vertexDataList The vertices.
+ * @param numSubdivisions The depth of the split tree. The mesh is split into 2^numSubdivisions batches.
+ * @param splitMode How the split planes are chosen.
+ * @param splitData The number of indices and the bounds of the triangles of each batch.
+ */
+void splitTrianglesIntoBatches(
+        std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        uint32_t numSubdivisions, TriangleSplitMode splitMode, TubeTriangleSplitData& splitData);
+
+#endif //LINEVIS_TRIANGLEBATCHSPLITTER_HPP
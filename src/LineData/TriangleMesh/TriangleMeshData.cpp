@@ -217,7 +217,15 @@ TubeTriangleRenderData TriangleMeshData::getLinePassTubeTriangleMeshRenderDataPa
         }
         return cachedTubeTriangleRenderData;
     }
-    removeOtherCachedDataTypes(RequestMode::TRIANGLES);
+    RenderDataCacheKey renderDataKey = getRenderDataCacheKey(RequestMode::TRIANGLES);
+    renderDataKey.vulkanRayTracing = vulkanRayTracing;
+    renderDataKey.payload = payload;
+    if (activateCachedDataType(renderDataKey)) {
+        if (cachedTubeTriangleRenderDataPayload) {
+            payload = cachedTubeTriangleRenderDataPayload;
+        }
+        return cachedTubeTriangleRenderData;
+    }
     cachedTubeTriangleRenderDataPayload = payload;
 
     std::vector<uint32_t> triangleIndexData = triangleIndices;
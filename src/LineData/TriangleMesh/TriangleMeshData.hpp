@@ -65,9 +65,9 @@ public:
 
 
     // Public interface for filtering trajectories.
-    void iterateOverTrajectories(std::function<void(const Trajectory&)> callback) override {}
-    void iterateOverTrajectoriesNotFiltered(std::function<void(const Trajectory&)> callback) override {}
-    void filterTrajectories(std::function<bool(const Trajectory&)> callback) override {}
+    void iterateOverTrajectories(std::function<void(const TrajectoryView&)> callback) override {}
+    void iterateOverTrajectoriesNotFiltered(std::function<void(const TrajectoryView&)> callback) override {}
+    void filterTrajectories(std::function<bool(const TrajectoryView&)> callback) override {}
     void resetTrajectoryFilter() override {}
 
     // Get filtered line data (only containing points also shown when rendering).
@@ -0,0 +1,396 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <array>
+#include <limits>
+#include <glm/glm.hpp>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "MeshletBuilder.hpp"
+
+namespace {
+
+/// Number of triangles the search for the line run boundaries is split into.
+const uint32_t LINE_RUN_BLOCK_SIZE = 1u << 16u;
+
+inline uint32_t getTriangleLineIndex(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList, uint32_t triangleIdx) {
+    uint32_t vertexIdx = tubeTriangleIndices[triangleIdx * 3];
+    uint32_t linePointIdx = tubeTriangleVertexDataList[vertexIdx].vertexLinePointIndex & 0x7FFFFFFFu;
+    return tubeTriangleLinePointDataList[linePointIdx].lineStartIndex;
+}
+
+/**
+ * Maps vertex indices to their index in the current meshlet. As a meshlet has at most 256 vertices, a small open
+ * addressing table is sufficient. Clearing only increments a stamp, so starting a new meshlet is free.
+ */
+class MeshletVertexTable {
+public:
+    MeshletVertexTable() { entries.fill(Entry{}); }
+    inline void clear() { stamp++; }
+    /// Returns the local index of the vertex in the current meshlet or -1 if the meshlet does not contain it.
+    [[nodiscard]] inline int find(uint32_t vertexIdx) const {
+        uint32_t slot = vertexIdx & TABLE_MASK;
+        while (entries[slot].stamp == stamp) {
+            if (entries[slot].vertexIdx == vertexIdx) {
+                return int(entries[slot].localIdx);
+            }
+            slot = (slot + 1) & TABLE_MASK;
+        }
+        return -1;
+    }
+    /// Adds the vertex if it is not yet part of the current meshlet.
+    inline void insert(uint32_t vertexIdx, uint32_t localIdx) {
+        uint32_t slot = vertexIdx & TABLE_MASK;
+        while (entries[slot].stamp == stamp) {
+            if (entries[slot].vertexIdx == vertexIdx) {
+                return;
+            }
+            slot = (slot + 1) & TABLE_MASK;
+        }
+        entries[slot] = { vertexIdx, stamp, localIdx };
+    }
+
+private:
+    static const uint32_t TABLE_SIZE = 512; ///< At most half full for 256 vertices.
+    static const uint32_t TABLE_MASK = TABLE_SIZE - 1;
+    struct Entry {
+        uint32_t vertexIdx = 0;
+        uint32_t stamp = 0;
+        uint32_t localIdx = 0;
+    };
+    std::array<Entry, TABLE_SIZE> entries;
+    uint32_t stamp = 1;
+};
+
+/// Output pointers of packMeshletRun. All pointers are nullptr in the counting pass.
+struct MeshletRunOutput {
+    MeshletTaskMeskShaderPayloadData* meshlets = nullptr;
+    glm::vec3* dedupVertices = nullptr;
+    uint32_t* dedupVertexIndexToOrigIndexMap = nullptr;
+    uint8_t* dedupTriangleIndices = nullptr;
+};
+
+/**
+ * Packs the triangles [triangleBegin, triangleEnd) of one line into meshlets with deduplicated vertices.
+ * @param vertexOffset The index of the first deduplicated vertex of the run.
+ * @param numMeshlets The number of meshlets of the run (output).
+ * @param numVertices The number of deduplicated vertices of the run (output).
+ */
+template<bool writeOutput>
+void packMeshletRun(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet,
+        uint32_t triangleBegin, uint32_t triangleEnd, uint32_t vertexOffset, MeshletVertexTable& vertexTable,
+        const MeshletRunOutput& output, uint32_t& numMeshlets, uint32_t& numVertices) {
+    MeshletTaskMeskShaderPayloadData currentMeshlet{};
+    currentMeshlet.meshletFirstPrimitiveIdx = triangleBegin;
+    currentMeshlet.vertexStart = vertexOffset;
+    currentMeshlet.primitiveStart = triangleBegin;
+    glm::vec3 aabbMin(std::numeric_limits<float>::max());
+    glm::vec3 aabbMax(std::numeric_limits<float>::lowest());
+    uint32_t vertexIdx = vertexOffset;
+    numMeshlets = 0;
+    vertexTable.clear();
+
+    for (uint32_t triangleIdx = triangleBegin; triangleIdx < triangleEnd; triangleIdx++) {
+        const uint32_t* indices = tubeTriangleIndices.data() + size_t(triangleIdx) * 3;
+        int localIndices[3];
+        uint32_t numVerticesNew = currentMeshlet.vertexCount;
+        for (int i = 0; i < 3; i++) {
+            localIndices[i] = vertexTable.find(indices[i]);
+            if (localIndices[i] < 0) {
+                numVerticesNew++;
+            }
+        }
+        if (currentMeshlet.primitiveCount > 0 && (currentMeshlet.primitiveCount + 1 > maxNumPrimitivesPerMeshlet
+                || numVerticesNew > maxNumVerticesPerMeshlet)) {
+            if constexpr (writeOutput) {
+                currentMeshlet.worldSpaceAabbMin = aabbMin;
+                currentMeshlet.worldSpaceAabbMax = aabbMax;
+                output.meshlets[numMeshlets] = currentMeshlet;
+            }
+            numMeshlets++;
+            currentMeshlet = {};
+            currentMeshlet.meshletFirstPrimitiveIdx = triangleIdx;
+            currentMeshlet.vertexStart = vertexIdx;
+            currentMeshlet.primitiveStart = triangleIdx;
+            aabbMin = glm::vec3(std::numeric_limits<float>::max());
+            aabbMax = glm::vec3(std::numeric_limits<float>::lowest());
+            vertexTable.clear();
+            localIndices[0] = localIndices[1] = localIndices[2] = -1;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            uint32_t localIdx;
+            if (localIndices[i] < 0) {
+                localIdx = currentMeshlet.vertexCount;
+                if constexpr (writeOutput) {
+                    output.dedupVertices[vertexIdx - vertexOffset] =
+                            tubeTriangleVertexDataList[indices[i]].vertexPosition;
+                    output.dedupVertexIndexToOrigIndexMap[vertexIdx - vertexOffset] = indices[i];
+                }
+                vertexTable.insert(indices[i], localIdx);
+                vertexIdx++;
+                currentMeshlet.vertexCount++;
+            } else {
+                localIdx = uint32_t(localIndices[i]);
+            }
+            if constexpr (writeOutput) {
+                output.dedupTriangleIndices[size_t(triangleIdx - triangleBegin) * 3 + size_t(i)] = uint8_t(localIdx);
+                const glm::vec3& vertexPosition = tubeTriangleVertexDataList[indices[i]].vertexPosition;
+                aabbMin = glm::min(aabbMin, vertexPosition);
+                aabbMax = glm::max(aabbMax, vertexPosition);
+            }
+        }
+        currentMeshlet.primitiveCount++;
+    }
+
+    if (currentMeshlet.primitiveCount > 0) {
+        if constexpr (writeOutput) {
+            currentMeshlet.worldSpaceAabbMin = aabbMin;
+            currentMeshlet.worldSpaceAabbMax = aabbMax;
+            output.meshlets[numMeshlets] = currentMeshlet;
+        }
+        numMeshlets++;
+    }
+    numVertices = vertexIdx - vertexOffset;
+}
+
+}
+
+void computeMeshletLineRuns(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        std::vector<uint32_t>& runTriangleOffsets) {
+    auto numTriangles = uint32_t(tubeTriangleIndices.size() / 3);
+    runTriangleOffsets.clear();
+    if (numTriangles == 0) {
+        runTriangleOffsets.push_back(0);
+        return;
+    }
+    if (tubeTriangleLinePointDataList.empty()) {
+        runTriangleOffsets.push_back(0);
+        runTriangleOffsets.push_back(numTriangles);
+        return;
+    }
+
+    auto numBlocks = int((numTriangles - 1) / LINE_RUN_BLOCK_SIZE + 1);
+    std::vector<std::vector<uint32_t>> blockRunOffsets(numBlocks);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numBlocks), [&](auto const& r) {
+        for (auto blockIdx = r.begin(); blockIdx != r.end(); blockIdx++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic, 1) shared(numBlocks, numTriangles, blockRunOffsets) \
+    shared(tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList)
+    for (int blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+#endif
+        uint32_t triangleBegin = uint32_t(blockIdx) * LINE_RUN_BLOCK_SIZE;
+        uint32_t triangleEnd = std::min(triangleBegin + LINE_RUN_BLOCK_SIZE, numTriangles);
+        std::vector<uint32_t>& runOffsets = blockRunOffsets[blockIdx];
+        uint32_t lastLineIdx = 0;
+        if (triangleBegin == 0) {
+            runOffsets.push_back(0);
+        } else {
+            lastLineIdx = getTriangleLineIndex(
+                    tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList,
+                    triangleBegin - 1);
+        }
+        for (uint32_t triangleIdx = triangleBegin; triangleIdx < triangleEnd; triangleIdx++) {
+            uint32_t lineIdx = getTriangleLineIndex(
+                    tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList, triangleIdx);
+            if (lineIdx != lastLineIdx && triangleIdx != 0) {
+                runOffsets.push_back(triangleIdx);
+            }
+            lastLineIdx = lineIdx;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    size_t numRuns = 0;
+    for (const std::vector<uint32_t>& runOffsets : blockRunOffsets) {
+        numRuns += runOffsets.size();
+    }
+    runTriangleOffsets.reserve(numRuns + 1);
+    for (const std::vector<uint32_t>& runOffsets : blockRunOffsets) {
+        runTriangleOffsets.insert(runTriangleOffsets.end(), runOffsets.begin(), runOffsets.end());
+    }
+    runTriangleOffsets.push_back(numTriangles);
+}
+
+void buildMeshletsDrawIndirect(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        uint32_t maxNumPrimitivesPerMeshlet, std::vector<MeshletDrawIndirectPayloadData>& meshlets) {
+    std::vector<uint32_t> runTriangleOffsets;
+    computeMeshletLineRuns(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList, runTriangleOffsets);
+    auto numRuns = int(runTriangleOffsets.size() - 1);
+
+    // Each run is split into meshlets with maxNumPrimitivesPerMeshlet triangles (except for the last one).
+    std::vector<uint32_t> runMeshletOffsets(numRuns + 1);
+    uint32_t numMeshlets = 0;
+    for (int runIdx = 0; runIdx < numRuns; runIdx++) {
+        runMeshletOffsets[runIdx] = numMeshlets;
+        uint32_t numRunTriangles = runTriangleOffsets[runIdx + 1] - runTriangleOffsets[runIdx];
+        numMeshlets += (numRunTriangles + maxNumPrimitivesPerMeshlet - 1) / maxNumPrimitivesPerMeshlet;
+    }
+    runMeshletOffsets[numRuns] = numMeshlets;
+    meshlets.clear();
+    meshlets.resize(numMeshlets);
+
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numRuns), [&](auto const& r) {
+        for (auto runIdx = r.begin(); runIdx != r.end(); runIdx++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic, 64) shared(numRuns, runTriangleOffsets, runMeshletOffsets) \
+    shared(tubeTriangleIndices, tubeTriangleVertexDataList, maxNumPrimitivesPerMeshlet, meshlets)
+    for (int runIdx = 0; runIdx < numRuns; runIdx++) {
+#endif
+        uint32_t triangleBegin = runTriangleOffsets[runIdx];
+        uint32_t triangleEnd = runTriangleOffsets[runIdx + 1];
+        uint32_t meshletIdx = runMeshletOffsets[runIdx];
+        for (uint32_t meshletBegin = triangleBegin; meshletBegin < triangleEnd;
+                meshletBegin += maxNumPrimitivesPerMeshlet) {
+            uint32_t meshletEnd = std::min(meshletBegin + maxNumPrimitivesPerMeshlet, triangleEnd);
+            glm::vec3 aabbMin(std::numeric_limits<float>::max());
+            glm::vec3 aabbMax(std::numeric_limits<float>::lowest());
+            for (size_t i = size_t(meshletBegin) * 3; i < size_t(meshletEnd) * 3; i++) {
+                const glm::vec3& vertexPosition = tubeTriangleVertexDataList[tubeTriangleIndices[i]].vertexPosition;
+                aabbMin = glm::min(aabbMin, vertexPosition);
+                aabbMax = glm::max(aabbMax, vertexPosition);
+            }
+            MeshletDrawIndirectPayloadData& meshlet = meshlets[meshletIdx];
+            meshlet.worldSpaceAabbMin = aabbMin;
+            meshlet.worldSpaceAabbMax = aabbMax;
+            meshlet.firstIndex = meshletBegin * 3;
+            meshlet.indexCount = (meshletEnd - meshletBegin) * 3;
+            meshletIdx++;
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+void buildMeshletsTaskMeshShader(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet,
+        std::vector<MeshletTaskMeskShaderPayloadData>& meshlets, std::vector<glm::vec3>& dedupVertices,
+        std::vector<uint32_t>& dedupVertexIndexToOrigIndexMap, std::vector<uint8_t>& dedupTriangleIndices) {
+    std::vector<uint32_t> runTriangleOffsets;
+    computeMeshletLineRuns(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList, runTriangleOffsets);
+    auto numRuns = int(runTriangleOffsets.size() - 1);
+
+    // Pass 1: Count the meshlets and deduplicated vertices of each run.
+    std::vector<uint32_t> runMeshletOffsets(numRuns + 1);
+    std::vector<uint32_t> runVertexOffsets(numRuns + 1);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numRuns), [&](auto const& r) {
+        MeshletVertexTable vertexTable;
+        for (auto runIdx = r.begin(); runIdx != r.end(); runIdx++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic, 64) shared(numRuns, runTriangleOffsets) \
+    shared(runMeshletOffsets, runVertexOffsets, tubeTriangleIndices, tubeTriangleVertexDataList) \
+    shared(maxNumPrimitivesPerMeshlet, maxNumVerticesPerMeshlet)
+    for (int runIdx = 0; runIdx < numRuns; runIdx++) {
+        MeshletVertexTable vertexTable;
+#endif
+        packMeshletRun<false>(
+                tubeTriangleIndices, tubeTriangleVertexDataList, maxNumPrimitivesPerMeshlet,
+                maxNumVerticesPerMeshlet, runTriangleOffsets[runIdx], runTriangleOffsets[runIdx + 1], 0,
+                vertexTable, MeshletRunOutput{}, runMeshletOffsets[runIdx], runVertexOffsets[runIdx]);
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    uint32_t numMeshlets = 0;
+    uint32_t numVertices = 0;
+    for (int runIdx = 0; runIdx <= numRuns; runIdx++) {
+        uint32_t numRunMeshlets = runMeshletOffsets[runIdx];
+        uint32_t numRunVertices = runVertexOffsets[runIdx];
+        runMeshletOffsets[runIdx] = numMeshlets;
+        runVertexOffsets[runIdx] = numVertices;
+        numMeshlets += numRunMeshlets;
+        numVertices += numRunVertices;
+    }
+    meshlets.clear();
+    meshlets.resize(numMeshlets);
+    dedupVertices.clear();
+    dedupVertices.resize(numVertices);
+    dedupVertexIndexToOrigIndexMap.clear();
+    dedupVertexIndexToOrigIndexMap.resize(numVertices);
+    dedupTriangleIndices.clear();
+    dedupTriangleIndices.resize(size_t(runTriangleOffsets.back()) * 3);
+
+    // Pass 2: Write the meshlets of all runs to the offsets computed above.
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numRuns), [&](auto const& r) {
+        MeshletVertexTable vertexTable;
+        for (auto runIdx = r.begin(); runIdx != r.end(); runIdx++) {
+#else
+#pragma omp parallel for default(none) schedule(dynamic, 64) shared(numRuns, runTriangleOffsets) \
+    shared(runMeshletOffsets, runVertexOffsets, tubeTriangleIndices, tubeTriangleVertexDataList) \
+    shared(maxNumPrimitivesPerMeshlet, maxNumVerticesPerMeshlet, meshlets, dedupVertices) \
+    shared(dedupVertexIndexToOrigIndexMap, dedupTriangleIndices)
+    for (int runIdx = 0; runIdx < numRuns; runIdx++) {
+        MeshletVertexTable vertexTable;
+#endif
+        uint32_t triangleBegin = runTriangleOffsets[runIdx];
+        uint32_t vertexOffset = runVertexOffsets[runIdx];
+        MeshletRunOutput output;
+        output.meshlets = meshlets.data() + runMeshletOffsets[runIdx];
+        output.dedupVertices = dedupVertices.data() + vertexOffset;
+        output.dedupVertexIndexToOrigIndexMap = dedupVertexIndexToOrigIndexMap.data() + vertexOffset;
+        output.dedupTriangleIndices = dedupTriangleIndices.data() + size_t(triangleBegin) * 3;
+        uint32_t numRunMeshlets = 0, numRunVertices = 0;
+        packMeshletRun<true>(
+                tubeTriangleIndices, tubeTriangleVertexDataList, maxNumPrimitivesPerMeshlet,
+                maxNumVerticesPerMeshlet, triangleBegin, runTriangleOffsets[runIdx + 1], vertexOffset,
+                vertexTable, output, numRunMeshlets, numRunVertices);
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
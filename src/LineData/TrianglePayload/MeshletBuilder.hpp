@@ -0,0 +1,79 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef LINEVIS_MESHLETBUILDER_HPP
+#define LINEVIS_MESHLETBUILDER_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "MeshletsDrawIndirectPayload.hpp"
+#include "MeshletsTaskMeshShaderPayload.hpp"
+
+/*
+ * Parallel meshlet builders for the tube triangle mesh payloads. Meshlets never cross the boundary between two lines,
+ * so the triangles are first split into runs of consecutive triangles belonging to the same line. The runs are packed
+ * independently in parallel. For meshlets with deduplicated vertices, a first pass counts the meshlets and vertices of
+ * each run, and a second pass writes them to the offsets computed with a prefix sum. The output is identical to
+ * packing all triangles sequentially.
+ */
+
+/**
+ * Computes the offsets of the runs of consecutive triangles belonging to the same line. The last entry is the number
+ * of triangles. If tubeTriangleLinePointDataList is empty, all triangles belong to one run.
+ */
+void computeMeshletLineRuns(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        std::vector<uint32_t>& runTriangleOffsets);
+
+/**
+ * Splits the triangles into meshlets of at most maxNumPrimitivesPerMeshlet triangles (MeshletsDrawIndirectPayload).
+ */
+void buildMeshletsDrawIndirect(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        uint32_t maxNumPrimitivesPerMeshlet, std::vector<MeshletDrawIndirectPayloadData>& meshlets);
+
+/**
+ * Splits the triangles into meshlets with at most maxNumPrimitivesPerMeshlet triangles and maxNumVerticesPerMeshlet
+ * deduplicated vertices (MeshletsTaskMeshShaderPayload). maxNumVerticesPerMeshlet must not exceed 256, as the local
+ * triangle indices are stored as uint8_t values.
+ */
+void buildMeshletsTaskMeshShader(
+        const std::vector<uint32_t>& tubeTriangleIndices,
+        const std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
+        const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList,
+        uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet,
+        std::vector<MeshletTaskMeskShaderPayloadData>& meshlets, std::vector<glm::vec3>& dedupVertices,
+        std::vector<uint32_t>& dedupVertexIndexToOrigIndexMap, std::vector<uint8_t>& dedupTriangleIndices);
+
+#endif //LINEVIS_MESHLETBUILDER_HPP
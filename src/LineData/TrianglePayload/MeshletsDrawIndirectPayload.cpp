@@ -27,8 +27,8 @@
  */
 
 #include <Math/Math.hpp>
-#include <Math/Geometry/AABB3.hpp>
 #include <Graphics/Vulkan/Buffers/Buffer.hpp>
+#include "MeshletBuilder.hpp"
 #include "MeshletsDrawIndirectPayload.hpp"
 
 bool MeshletsDrawIndirectPayload::settingsEqual(TubeTriangleRenderDataPayload* other) const {
@@ -40,52 +40,30 @@ bool MeshletsDrawIndirectPayload::settingsEqual(TubeTriangleRenderDataPayload* o
             && this->shallVisualizeNodes == otherCast->shallVisualizeNodes;
 }
 
+size_t MeshletsDrawIndirectPayload::getSizeInBytes() const {
+    size_t sizeInBytes = 0;
+    for (const sgl::vk::BufferPtr& buffer : {
+            meshletDataBuffer,
+            meshletVisibilityArrayBuffer,
+            indirectDrawBuffer,
+            indirectDrawCountBuffer,
+            nodeAabbBuffer,
+            nodeAabbCountBuffer }) {
+        if (buffer) {
+            sizeInBytes += buffer->getSizeInBytes();
+        }
+    }
+    return sizeInBytes;
+}
+
 void MeshletsDrawIndirectPayload::createPayloadPre(
         sgl::vk::Device* device, uint32_t tubeNumSubdivisions, std::vector<uint32_t>& tubeTriangleIndices,
         std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
         const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList) {
     std::vector<MeshletDrawIndirectPayloadData> meshlets;
-    meshlets.reserve(sgl::uiceil(uint32_t(tubeTriangleIndices.size()), maxNumPrimitivesPerMeshlet));
-
-    MeshletDrawIndirectPayloadData currentMeshlet{};
-    sgl::AABB3 currentMeshletBB;
-    uint32_t currentLineIdx = 0;
-
-    for (size_t primitiveIdx = 0; primitiveIdx < tubeTriangleIndices.size(); primitiveIdx += 3) {
-        uint32_t idx0 = tubeTriangleIndices.at(primitiveIdx);
-        uint32_t idx1 = tubeTriangleIndices.at(primitiveIdx + 1);
-        uint32_t idx2 = tubeTriangleIndices.at(primitiveIdx + 2);
-        const auto& v0 = tubeTriangleVertexDataList.at(idx0);
-        const auto& v1 = tubeTriangleVertexDataList.at(idx1);
-        const auto& v2 = tubeTriangleVertexDataList.at(idx2);
-        uint32_t l0 = 0;
-        if (!tubeTriangleLinePointDataList.empty()) {
-            l0 = tubeTriangleLinePointDataList.at(v0.vertexLinePointIndex & 0x7FFFFFFFu).lineStartIndex;
-        }
-
-        if (currentMeshlet.indexCount >= maxNumPrimitivesPerMeshlet * 3
-                || (currentLineIdx != l0 && currentMeshlet.indexCount > 0)) {
-            currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-            currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-            meshlets.push_back(currentMeshlet);
-            currentMeshletBB = {};
-            currentMeshlet = {};
-            currentMeshlet.firstIndex = uint32_t(primitiveIdx);
-        }
-        currentLineIdx = l0;
-
-        currentMeshletBB.combine(v0.vertexPosition);
-        currentMeshletBB.combine(v1.vertexPosition);
-        currentMeshletBB.combine(v2.vertexPosition);
-        currentMeshlet.indexCount += 3;
-    }
-
-    // Add any missing meshlet.
-    if (currentMeshlet.indexCount > 0) {
-        currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-        currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-        meshlets.push_back(currentMeshlet);
-    }
+    buildMeshletsDrawIndirect(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList,
+            maxNumPrimitivesPerMeshlet, meshlets);
 
     numMeshlets = uint32_t(meshlets.size());
     meshletDataBuffer = std::make_shared<sgl::vk::Buffer>(
@@ -44,6 +44,7 @@ public:
             : maxNumPrimitivesPerMeshlet(maxNumPrimitivesPerMeshlet), shallVisualizeNodes(shallVisualizeNodes) {}
     [[nodiscard]] Type getType() const override { return Type::MESHLETS_DRAW_INDIRECT; }
     [[nodiscard]] bool settingsEqual(TubeTriangleRenderDataPayload* other) const override;
+    [[nodiscard]] size_t getSizeInBytes() const override;
 
     void createPayloadPre(
             sgl::vk::Device* device, uint32_t tubeNumSubdivisions, std::vector<uint32_t>& tubeTriangleIndices,
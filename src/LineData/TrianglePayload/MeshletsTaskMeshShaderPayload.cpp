@@ -26,10 +26,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <unordered_map>
 #include <Math/Math.hpp>
-#include <Math/Geometry/AABB3.hpp>
 #include <Graphics/Vulkan/Buffers/Buffer.hpp>
+#include "MeshletBuilder.hpp"
 #include "MeshletsTaskMeshShaderPayload.hpp"
 
 bool MeshletsTaskMeshShaderPayload::settingsEqual(TubeTriangleRenderDataPayload* other) const {
@@ -43,26 +42,27 @@ bool MeshletsTaskMeshShaderPayload::settingsEqual(TubeTriangleRenderDataPayload*
             && this->shallVisualizeNodes == otherCast->shallVisualizeNodes;
 }
 
+size_t MeshletsTaskMeshShaderPayload::getSizeInBytes() const {
+    size_t sizeInBytes = 0;
+    for (const sgl::vk::BufferPtr& buffer : {
+            meshletDataBuffer,
+            meshletVisibilityArrayBuffer,
+            dedupVerticesBuffer,
+            dedupVertexIndexToOrigIndexMapBuffer,
+            dedupTriangleIndicesBuffer,
+            nodeAabbBuffer,
+            nodeAabbCountBuffer }) {
+        if (buffer) {
+            sizeInBytes += buffer->getSizeInBytes();
+        }
+    }
+    return sizeInBytes;
+}
+
 void MeshletsTaskMeshShaderPayload::createPayloadPre(
         sgl::vk::Device* device, uint32_t tubeNumSubdivisions, std::vector<uint32_t>& tubeTriangleIndices,
         std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
         const std::vector<LinePointDataUnified>& tubeTriangleLinePointDataList) {
-    std::vector<MeshletTaskMeskShaderPayloadData> meshlets;
-    meshlets.reserve(sgl::uiceil(uint32_t(tubeTriangleIndices.size()), maxNumPrimitivesPerMeshlet));
-    std::vector<glm::vec3> dedupVertices;
-    dedupVertices.reserve(tubeTriangleVertexDataList.size());
-    std::vector<uint32_t> dedupVertexIndexToOrigIndexMap;
-    dedupVertexIndexToOrigIndexMap.reserve(tubeTriangleVertexDataList.size());
-    std::vector<uint8_t> dedupTriangleIndices;
-    dedupTriangleIndices.reserve(tubeTriangleIndices.size());
-
-    MeshletTaskMeskShaderPayloadData currentMeshlet{};
-    std::unordered_map<uint32_t, uint8_t> currentMeshletIndices;
-    sgl::AABB3 currentMeshletBB;
-    uint32_t currentNumPrimitives = 0;
-    uint32_t currentNumVertices = 0;
-    uint32_t currentLineIdx = 0;
-
     uint32_t maxNumPrimitivesPerMeshletLocal = maxNumPrimitivesPerMeshlet;
     uint32_t maxNumVerticesPerMeshletLocal = maxNumVerticesPerMeshlet;
     if (useMeshShaderWritePackedPrimitiveIndices) {
@@ -80,88 +80,14 @@ void MeshletsTaskMeshShaderPayload::createPayloadPre(
         maxNumVerticesPerMeshletLocal = tubeNumSubdivisions + tubeNumSubdivisions * numSegments;
     }
 
-    for (size_t primitiveIdx = 0; primitiveIdx < tubeTriangleIndices.size(); primitiveIdx += 3) {
-        currentNumVertices = currentMeshlet.vertexCount;
-        currentNumPrimitives = currentMeshlet.primitiveCount;
-        uint32_t idx0 = tubeTriangleIndices.at(primitiveIdx);
-        uint32_t idx1 = tubeTriangleIndices.at(primitiveIdx + 1);
-        uint32_t idx2 = tubeTriangleIndices.at(primitiveIdx + 2);
-        const auto& v0 = tubeTriangleVertexDataList.at(idx0);
-        const auto& v1 = tubeTriangleVertexDataList.at(idx1);
-        const auto& v2 = tubeTriangleVertexDataList.at(idx2);
-        uint32_t l0 = 0;
-        if (!tubeTriangleLinePointDataList.empty()) {
-            l0 = tubeTriangleLinePointDataList.at(v0.vertexLinePointIndex & 0x7FFFFFFFu).lineStartIndex;
-        }
-        auto it0 = currentMeshletIndices.find(idx0);
-        auto it1 = currentMeshletIndices.find(idx1);
-        auto it2 = currentMeshletIndices.find(idx2);
-        if (it0 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        if (it1 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        if (it2 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        currentNumPrimitives++;
-
-        if (currentNumPrimitives > maxNumPrimitivesPerMeshletLocal
-                || currentNumVertices > maxNumVerticesPerMeshletLocal
-                || (currentLineIdx != l0 && currentMeshlet.primitiveCount > 0)) {
-            currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-            currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-            meshlets.push_back(currentMeshlet);
-            currentMeshletBB = {};
-            currentMeshletIndices.clear();
-            currentMeshlet = {};
-            currentMeshlet.meshletFirstPrimitiveIdx = uint32_t(primitiveIdx / 3);
-            currentMeshlet.vertexStart = uint32_t(dedupVertexIndexToOrigIndexMap.size());
-            currentMeshlet.primitiveStart = uint32_t(dedupTriangleIndices.size() / 3);
-        }
-        currentLineIdx = l0;
-
-        if (currentMeshlet.primitiveCount == 0 || it0 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v0.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx0);
-            dedupTriangleIndices.push_back(uint8_t(currentMeshlet.vertexCount));
-            currentMeshletIndices.insert(std::make_pair(idx0, uint8_t(currentMeshlet.vertexCount)));
-            currentMeshlet.vertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it0->second);
-        }
-        if (currentMeshlet.primitiveCount == 0 || it1 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v1.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx1);
-            dedupTriangleIndices.push_back(uint8_t(currentMeshlet.vertexCount));
-            currentMeshletIndices.insert(std::make_pair(idx1, uint8_t(currentMeshlet.vertexCount)));
-            currentMeshlet.vertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it1->second);
-        }
-        if (currentMeshlet.primitiveCount == 0 || it2 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v2.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx2);
-            currentMeshletIndices.insert(std::make_pair(idx2, uint8_t(currentMeshlet.vertexCount)));
-            dedupTriangleIndices.push_back(uint8_t(currentMeshlet.vertexCount));
-            currentMeshlet.vertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it2->second);
-        }
-        currentMeshlet.primitiveCount++;
-
-        currentMeshletBB.combine(v0.vertexPosition);
-        currentMeshletBB.combine(v1.vertexPosition);
-        currentMeshletBB.combine(v2.vertexPosition);
-    }
-
-    // Add any missing meshlet.
-    if (currentMeshlet.primitiveCount > 0) {
-        currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-        currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-        meshlets.push_back(currentMeshlet);
-    }
+    std::vector<MeshletTaskMeskShaderPayloadData> meshlets;
+    std::vector<glm::vec3> dedupVertices;
+    std::vector<uint32_t> dedupVertexIndexToOrigIndexMap;
+    std::vector<uint8_t> dedupTriangleIndices;
+    buildMeshletsTaskMeshShader(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList,
+            maxNumPrimitivesPerMeshletLocal, maxNumVerticesPerMeshletLocal,
+            meshlets, dedupVertices, dedupVertexIndexToOrigIndexMap, dedupTriangleIndices);
 
     numMeshlets = uint32_t(meshlets.size());
     meshletDataBuffer = std::make_shared<sgl::vk::Buffer>(
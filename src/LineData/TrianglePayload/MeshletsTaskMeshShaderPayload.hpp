@@ -53,6 +53,7 @@ public:
               shallVisualizeNodes(shallVisualizeNodes) {}
     [[nodiscard]] Type getType() const override { return Type::MESHLETS_TASK_MESH_SHADER; }
     [[nodiscard]] bool settingsEqual(TubeTriangleRenderDataPayload* other) const override;
+    [[nodiscard]] size_t getSizeInBytes() const override;
 
     void createPayloadPre(
             sgl::vk::Device* device, uint32_t tubeNumSubdivisions, std::vector<uint32_t>& tubeTriangleIndices,
@@ -37,11 +37,11 @@
 //#include <bvh/spatial_split_bvh_builder.hpp>
 
 #include <Math/Math.hpp>
-#include <Math/Geometry/AABB3.hpp>
 #include <Utils/File/Logfile.hpp>
 #include <Graphics/Vulkan/Utils/Device.hpp>
 #include <Graphics/Vulkan/Buffers/Buffer.hpp>
-#include "MeshletsDrawIndirectPayload.hpp"
+#include "MeshletBuilder.hpp"
+#include "ParallelLinearBvhBuilder.hpp"
 #include "NodesBVHTreePayload.hpp"
 
 using Scalar = float;
@@ -75,6 +75,35 @@ bool NodesBVHTreePayload::settingsEqual(TubeTriangleRenderDataPayload* other) co
     return isEqual;
 }
 
+size_t NodesBVHTreePayload::getSizeInBytes() const {
+    size_t sizeInBytes = 0;
+    for (const sgl::vk::BufferPtr& buffer : {
+            nodeDataBuffer,
+            queueStateBuffer,
+            queueStateBufferRecheck,
+            queueBuffer,
+            queueBufferRecheck,
+            indirectDrawCountBuffer,
+            queueInfoBuffer,
+            maxWorkLeftTestBuffer,
+            indirectDrawBuffer,
+            tasksIndirectCommandBuffer,
+            tasksIndirectCommandsCountBuffer,
+            visibleMeshletIndexArrayBuffer,
+            treeLeafMeshletsBuffer,
+            dedupVerticesBuffer,
+            dedupVertexIndexToOrigIndexMapBuffer,
+            dedupTriangleIndicesBuffer,
+            nodeAabbBuffer,
+            nodeAabbCountBuffer,
+            nodeIdxToTreeHeightBuffer }) {
+        if (buffer) {
+            sizeInBytes += buffer->getSizeInBytes();
+        }
+    }
+    return sizeInBytes;
+}
+
 void createBBsDrawIndexedTriangles(
         std::vector<uint32_t>& tubeTriangleIndices, std::vector<TubeTriangleVertexData>& tubeTriangleVertexDataList,
         size_t& numPrimitives, std::vector<BoundingBox>& bboxes, std::vector<Vector3>& centers,
@@ -114,46 +143,9 @@ void createBBsDrawIndexedMeshlets(
         size_t& numPrimitives, std::vector<BoundingBox>& bboxes, std::vector<Vector3>& centers,
         std::vector<MeshletDrawIndirectPayloadData>& meshlets,
         BvhBuildPrimitiveCenterMode bvhBuildPrimitiveCenterMode, uint32_t maxNumPrimitivesPerMeshlet) {
-    meshlets.reserve(sgl::uiceil(uint32_t(tubeTriangleIndices.size()), maxNumPrimitivesPerMeshlet));
-    MeshletDrawIndirectPayloadData currentMeshlet{};
-    sgl::AABB3 currentMeshletBB;
-    uint32_t currentLineIdx = 0;
-
-    for (size_t primitiveIdx = 0; primitiveIdx < tubeTriangleIndices.size(); primitiveIdx += 3) {
-        uint32_t idx0 = tubeTriangleIndices.at(primitiveIdx);
-        uint32_t idx1 = tubeTriangleIndices.at(primitiveIdx + 1);
-        uint32_t idx2 = tubeTriangleIndices.at(primitiveIdx + 2);
-        const auto& v0 = tubeTriangleVertexDataList.at(idx0);
-        const auto& v1 = tubeTriangleVertexDataList.at(idx1);
-        const auto& v2 = tubeTriangleVertexDataList.at(idx2);
-        uint32_t l0 = 0;
-        if (!tubeTriangleLinePointDataList.empty()) {
-            l0 = tubeTriangleLinePointDataList.at(v0.vertexLinePointIndex & 0x7FFFFFFFu).lineStartIndex;
-        }
-
-        if (currentMeshlet.indexCount >= maxNumPrimitivesPerMeshlet * 3
-                || (currentLineIdx != l0 && currentMeshlet.indexCount > 0)) {
-            currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-            currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-            meshlets.push_back(currentMeshlet);
-            currentMeshletBB = {};
-            currentMeshlet = {};
-            currentMeshlet.firstIndex = uint32_t(primitiveIdx);
-        }
-        currentLineIdx = l0;
-
-        currentMeshletBB.combine(v0.vertexPosition);
-        currentMeshletBB.combine(v1.vertexPosition);
-        currentMeshletBB.combine(v2.vertexPosition);
-        currentMeshlet.indexCount += 3;
-    }
-
-    // Add any missing meshlet.
-    if (currentMeshlet.indexCount > 0) {
-        currentMeshlet.worldSpaceAabbMin = currentMeshletBB.min;
-        currentMeshlet.worldSpaceAabbMax = currentMeshletBB.max;
-        meshlets.push_back(currentMeshlet);
-    }
+    buildMeshletsDrawIndirect(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList,
+            maxNumPrimitivesPerMeshlet, meshlets);
 
     numPrimitives = meshlets.size();
     bboxes.reserve(numPrimitives);
@@ -193,25 +185,6 @@ void createBBsMeshShaderMeshlets(
         BvhBuildPrimitiveCenterMode bvhBuildPrimitiveCenterMode,
         uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet,
         bool useMeshShaderWritePackedPrimitiveIndices) {
-    uint32_t currentVertexCount = 0;
-    uint32_t currentPrimitiveCount = 0;
-
-    std::vector<sgl::AABB3> meshletBBs;
-    uint32_t expectedNumMeshlets = sgl::uiceil(uint32_t(tubeTriangleIndices.size()), maxNumPrimitivesPerMeshlet);
-    treeLeafMeshlets.reserve(expectedNumMeshlets);
-    meshletBBs.reserve(expectedNumMeshlets);
-
-    dedupVertices.reserve(tubeTriangleVertexDataList.size());
-    dedupVertexIndexToOrigIndexMap.reserve(tubeTriangleVertexDataList.size());
-    dedupTriangleIndices.reserve(tubeTriangleIndices.size());
-
-    BVHTreeLeafMeshlet currentMeshlet{};
-    std::unordered_map<uint32_t, uint8_t> currentMeshletIndices;
-    sgl::AABB3 currentMeshletBB;
-    uint32_t currentNumPrimitives = 0;
-    uint32_t currentNumVertices = 0;
-    uint32_t currentLineIdx = 0;
-
     uint32_t maxNumPrimitivesPerMeshletLocal = maxNumPrimitivesPerMeshlet;
     uint32_t maxNumVerticesPerMeshletLocal = maxNumVerticesPerMeshlet;
     if (useMeshShaderWritePackedPrimitiveIndices) {
@@ -229,89 +202,19 @@ void createBBsMeshShaderMeshlets(
         maxNumVerticesPerMeshletLocal = tubeNumSubdivisions + tubeNumSubdivisions * numSegments;
     }
 
-    for (size_t primitiveIdx = 0; primitiveIdx < tubeTriangleIndices.size(); primitiveIdx += 3) {
-        currentNumVertices = currentVertexCount;
-        currentNumPrimitives = currentPrimitiveCount;
-        uint32_t idx0 = tubeTriangleIndices.at(primitiveIdx);
-        uint32_t idx1 = tubeTriangleIndices.at(primitiveIdx + 1);
-        uint32_t idx2 = tubeTriangleIndices.at(primitiveIdx + 2);
-        const auto& v0 = tubeTriangleVertexDataList.at(idx0);
-        const auto& v1 = tubeTriangleVertexDataList.at(idx1);
-        const auto& v2 = tubeTriangleVertexDataList.at(idx2);
-        uint32_t l0 = 0;
-        if (!tubeTriangleLinePointDataList.empty()) {
-            l0 = tubeTriangleLinePointDataList.at(v0.vertexLinePointIndex & 0x7FFFFFFFu).lineStartIndex;
-        }
-        auto it0 = currentMeshletIndices.find(idx0);
-        auto it1 = currentMeshletIndices.find(idx1);
-        auto it2 = currentMeshletIndices.find(idx2);
-        if (it0 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        if (it1 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        if (it2 == currentMeshletIndices.end()) {
-            currentNumVertices++;
-        }
-        currentNumPrimitives++;
-
-        if (currentNumPrimitives > maxNumPrimitivesPerMeshletLocal
-                || currentNumVertices > maxNumVerticesPerMeshletLocal
-                || (currentLineIdx != l0 && currentPrimitiveCount > 0)) {
-            currentMeshlet.vertexAndPrimitiveCountCombined = currentVertexCount | (currentPrimitiveCount << 16u);
-            treeLeafMeshlets.push_back(currentMeshlet);
-            meshletBBs.push_back(currentMeshletBB);
-            currentMeshletBB = {};
-            currentMeshletIndices.clear();
-            currentMeshlet = {};
-            currentVertexCount = 0;
-            currentPrimitiveCount = 0;
-            currentMeshlet.meshletFirstPrimitiveIdx = uint32_t(primitiveIdx / 3);
-            currentMeshlet.vertexStart = uint32_t(dedupVertexIndexToOrigIndexMap.size());
-            currentMeshlet.primitiveStart = uint32_t(dedupTriangleIndices.size() / 3);
-        }
-        currentLineIdx = l0;
-
-        if (currentPrimitiveCount == 0 || it0 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v0.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx0);
-            dedupTriangleIndices.push_back(uint8_t(currentVertexCount));
-            currentMeshletIndices.insert(std::make_pair(idx0, uint8_t(currentVertexCount)));
-            currentVertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it0->second);
-        }
-        if (currentPrimitiveCount == 0 || it1 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v1.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx1);
-            dedupTriangleIndices.push_back(uint8_t(currentVertexCount));
-            currentMeshletIndices.insert(std::make_pair(idx1, uint8_t(currentVertexCount)));
-            currentVertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it1->second);
-        }
-        if (currentPrimitiveCount == 0 || it2 == currentMeshletIndices.end()) {
-            dedupVertices.push_back(v2.vertexPosition);
-            dedupVertexIndexToOrigIndexMap.push_back(idx2);
-            currentMeshletIndices.insert(std::make_pair(idx2, uint8_t(currentVertexCount)));
-            dedupTriangleIndices.push_back(uint8_t(currentVertexCount));
-            currentVertexCount++;
-        } else {
-            dedupTriangleIndices.push_back(it2->second);
-        }
-        currentPrimitiveCount++;
-
-        currentMeshletBB.combine(v0.vertexPosition);
-        currentMeshletBB.combine(v1.vertexPosition);
-        currentMeshletBB.combine(v2.vertexPosition);
-    }
-
-    // Add any missing meshlet.
-    if (currentPrimitiveCount > 0) {
-        currentMeshlet.vertexAndPrimitiveCountCombined = currentVertexCount | (currentPrimitiveCount << 16u);
-        treeLeafMeshlets.push_back(currentMeshlet);
-        meshletBBs.push_back(currentMeshletBB);
+    std::vector<MeshletTaskMeskShaderPayloadData> meshlets;
+    buildMeshletsTaskMeshShader(
+            tubeTriangleIndices, tubeTriangleVertexDataList, tubeTriangleLinePointDataList,
+            maxNumPrimitivesPerMeshletLocal, maxNumVerticesPerMeshletLocal,
+            meshlets, dedupVertices, dedupVertexIndexToOrigIndexMap, dedupTriangleIndices);
+    treeLeafMeshlets.resize(meshlets.size());
+    for (size_t meshletIdx = 0; meshletIdx < meshlets.size(); meshletIdx++) {
+        const MeshletTaskMeskShaderPayloadData& meshlet = meshlets.at(meshletIdx);
+        BVHTreeLeafMeshlet& treeLeafMeshlet = treeLeafMeshlets.at(meshletIdx);
+        treeLeafMeshlet.meshletFirstPrimitiveIdx = meshlet.meshletFirstPrimitiveIdx;
+        treeLeafMeshlet.vertexStart = meshlet.vertexStart;
+        treeLeafMeshlet.primitiveStart = meshlet.primitiveStart;
+        treeLeafMeshlet.vertexAndPrimitiveCountCombined = meshlet.vertexCount | (meshlet.primitiveCount << 16u);
     }
 
     numPrimitives = treeLeafMeshlets.size();
@@ -320,10 +223,12 @@ void createBBsMeshShaderMeshlets(
 
     for (size_t meshletIdx = 0; meshletIdx < treeLeafMeshlets.size(); meshletIdx++) {
         const BVHTreeLeafMeshlet& meshlet = treeLeafMeshlets.at(meshletIdx);
-        const sgl::AABB3& aabb = meshletBBs.at(meshletIdx);
+        const MeshletTaskMeskShaderPayloadData& meshletData = meshlets.at(meshletIdx);
         BoundingBox bb;
-        bb.min = Vector3(aabb.min.x, aabb.min.y, aabb.min.z);
-        bb.max = Vector3(aabb.max.x, aabb.max.y, aabb.max.z);
+        bb.min = Vector3(
+                meshletData.worldSpaceAabbMin.x, meshletData.worldSpaceAabbMin.y, meshletData.worldSpaceAabbMin.z);
+        bb.max = Vector3(
+                meshletData.worldSpaceAabbMax.x, meshletData.worldSpaceAabbMax.y, meshletData.worldSpaceAabbMax.z);
         bboxes.push_back(bb);
         if (bvhBuildPrimitiveCenterMode == BvhBuildPrimitiveCenterMode::PRIMITIVE_CENTROID) {
             uint32_t vertexCount = meshlet.vertexAndPrimitiveCountCombined & 0xFFFFu;
@@ -427,7 +332,7 @@ void createTreeNodesMeshShader(
 }
 
 /*
- * TODO: Add support for Parallel LBVH construction.
+ * TODO: Add support for Parallel LBVH construction on the GPU (see ParallelLinearBvhBuilder for the CPU version).
  * - https://developer.nvidia.com/blog/thinking-parallel-part-iii-tree-construction-gpu/
  * - https://luebke.us/publications/eg09.pdf
  * - https://devblogs.nvidia.com/parallelforall/wp-content/uploads/2012/11/karras2012hpg_paper.pdf
@@ -520,6 +425,19 @@ void NodesBVHTreePayload::createPayloadPre(
         bvh::LinearBvhBuilder<Bvh, Morton> linearBvhBuilder(bvh);
         linearBvhBuilder.build(
                 globalBbox, bboxes.data(), centers.data(), numPrimitives);
+    } else if (bvhBuildAlgorithm == BvhBuildAlgorithm::LINEAR_BVH_PARALLEL_CPU) {
+        ParallelLinearBvhBuilder parallelLinearBvhBuilder(bvh);
+        if (useStdBvhParameters) {
+            if (bvhBuildGeometryMode == BvhBuildGeometryMode::TRIANGLES && drawIndexedIndirectMode) {
+                parallelLinearBvhBuilder.maxLeafSize = maxNumPrimitivesPerMeshlet;
+            } else if (bvhBuildGeometryMode == BvhBuildGeometryMode::MESHLETS) {
+                parallelLinearBvhBuilder.maxLeafSize = 1;
+            }
+        } else {
+            parallelLinearBvhBuilder.maxLeafSize = maxLeafSize;
+        }
+        parallelLinearBvhBuilder.build(
+                globalBbox, bboxes.data(), centers.data(), numPrimitives);
     }
 
     // Get statistics.
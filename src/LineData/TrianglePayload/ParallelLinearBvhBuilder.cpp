@@ -0,0 +1,406 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "ParallelLinearBvhBuilder.hpp"
+
+namespace {
+
+using Scalar = ParallelLinearBvhBuilder::Scalar;
+using Bvh = ParallelLinearBvhBuilder::Bvh;
+using Vector3 = ParallelLinearBvhBuilder::Vector3;
+using BoundingBox = ParallelLinearBvhBuilder::BoundingBox;
+
+/// Number of elements processed by one task of the radix sort and the prefix sums.
+const size_t LBVH_BLOCK_SIZE = size_t(1) << 16u;
+/// Number of bits sorted per radix sort pass.
+const uint32_t RADIX_NUM_BITS = 8;
+const uint32_t RADIX_NUM_BINS = 1u << RADIX_NUM_BITS;
+/// 10 bits per axis.
+const int MORTON_NUM_BITS = 30;
+/// Marks children of inner nodes of the binary radix tree that are leaves.
+const uint32_t LEAF_BIT = 0x80000000u;
+
+/**
+ * Calls functor(i) in parallel for all i in [0, n).
+ */
+template<class Functor>
+void parallelFor(size_t n, const Functor& functor) {
+    auto numIterations = int(n);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numIterations), [&](auto const& r) {
+        for (auto i = r.begin(); i != r.end(); i++) {
+#else
+#pragma omp parallel for default(none) shared(numIterations, functor) schedule(dynamic, 64)
+    for (int i = 0; i < numIterations; i++) {
+#endif
+        functor(size_t(i));
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+inline int countLeadingZeros(uint32_t value) {
+    if (value == 0) {
+        return 32;
+    }
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return 31 - int(index);
+#else
+    return __builtin_clz(value);
+#endif
+}
+
+/// Inserts two zero bits after each of the lower 10 bits of the passed value.
+inline uint32_t expandBits(uint32_t value) {
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+inline uint32_t computeMortonCode(const Vector3& center, const Vector3& gridMin, const Vector3& gridScale) {
+    const uint32_t gridDim = 1u << uint32_t(MORTON_NUM_BITS / 3);
+    uint32_t mortonCode = 0;
+    for (int i = 0; i < 3; i++) {
+        Scalar gridPosition = std::clamp((center[i] - gridMin[i]) * gridScale[i], Scalar(0), Scalar(gridDim - 1));
+        mortonCode |= expandBits(uint32_t(gridPosition)) << uint32_t(2 - i);
+    }
+    return mortonCode;
+}
+
+/**
+ * Computes the exclusive prefix sum of the passed values in place and returns the total sum.
+ */
+uint32_t exclusiveScanParallel(std::vector<uint32_t>& values) {
+    size_t numBlocks = (values.size() + LBVH_BLOCK_SIZE - 1) / LBVH_BLOCK_SIZE;
+    std::vector<uint32_t> blockSums(numBlocks);
+    parallelFor(numBlocks, [&](size_t blockIdx) {
+        size_t begin = blockIdx * LBVH_BLOCK_SIZE;
+        size_t end = std::min(begin + LBVH_BLOCK_SIZE, values.size());
+        uint32_t blockSum = 0;
+        for (size_t i = begin; i < end; i++) {
+            blockSum += values[i];
+        }
+        blockSums[blockIdx] = blockSum;
+    });
+    uint32_t totalSum = 0;
+    for (uint32_t& blockSum : blockSums) {
+        uint32_t blockOffset = totalSum;
+        totalSum += blockSum;
+        blockSum = blockOffset;
+    }
+    parallelFor(numBlocks, [&](size_t blockIdx) {
+        size_t begin = blockIdx * LBVH_BLOCK_SIZE;
+        size_t end = std::min(begin + LBVH_BLOCK_SIZE, values.size());
+        uint32_t offset = blockSums[blockIdx];
+        for (size_t i = begin; i < end; i++) {
+            uint32_t value = values[i];
+            values[i] = offset;
+            offset += value;
+        }
+    });
+    return totalSum;
+}
+
+/**
+ * Stable parallel LSD radix sort of key-value pairs. Each pass computes one histogram per block of keys, computes the
+ * scatter offsets of all (digit, block) pairs with a prefix sum and scatters the blocks in parallel. Passes where all
+ * keys share the same digit are skipped.
+ */
+void radixSortPairs(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, int numKeyBits) {
+    size_t numElements = keys.size();
+    size_t numBlocks = (numElements + LBVH_BLOCK_SIZE - 1) / LBVH_BLOCK_SIZE;
+    std::vector<uint32_t> keysTmp(numElements), valuesTmp(numElements);
+    std::vector<uint32_t> blockDigitOffsets(numBlocks * RADIX_NUM_BINS);
+
+    for (int shift = 0; shift < numKeyBits; shift += int(RADIX_NUM_BITS)) {
+        parallelFor(numBlocks, [&](size_t blockIdx) {
+            uint32_t* histogram = blockDigitOffsets.data() + blockIdx * RADIX_NUM_BINS;
+            std::fill(histogram, histogram + RADIX_NUM_BINS, 0u);
+            size_t begin = blockIdx * LBVH_BLOCK_SIZE;
+            size_t end = std::min(begin + LBVH_BLOCK_SIZE, numElements);
+            for (size_t i = begin; i < end; i++) {
+                histogram[(keys[i] >> uint32_t(shift)) & (RADIX_NUM_BINS - 1)]++;
+            }
+        });
+
+        // Offsets in digit-major order keep the sort stable.
+        bool isSingleDigit = false;
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX_NUM_BINS; digit++) {
+            uint32_t digitOffset = offset;
+            for (size_t blockIdx = 0; blockIdx < numBlocks; blockIdx++) {
+                uint32_t& blockDigitOffset = blockDigitOffsets[blockIdx * RADIX_NUM_BINS + digit];
+                uint32_t count = blockDigitOffset;
+                blockDigitOffset = offset;
+                offset += count;
+            }
+            if (offset - digitOffset == numElements) {
+                isSingleDigit = true;
+            }
+        }
+        if (isSingleDigit) {
+            continue;
+        }
+
+        parallelFor(numBlocks, [&](size_t blockIdx) {
+            uint32_t* digitOffsets = blockDigitOffsets.data() + blockIdx * RADIX_NUM_BINS;
+            size_t begin = blockIdx * LBVH_BLOCK_SIZE;
+            size_t end = std::min(begin + LBVH_BLOCK_SIZE, numElements);
+            for (size_t i = begin; i < end; i++) {
+                uint32_t writeIdx = digitOffsets[(keys[i] >> uint32_t(shift)) & (RADIX_NUM_BINS - 1)]++;
+                keysTmp[writeIdx] = keys[i];
+                valuesTmp[writeIdx] = values[i];
+            }
+        });
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+/// Inner node of the binary radix tree. Covers the sorted primitives [firstPrimitive, lastPrimitive].
+struct RadixTreeNode {
+    uint32_t children[2]; ///< Inner node index or sorted primitive index with LEAF_BIT set.
+    uint32_t firstPrimitive;
+    uint32_t lastPrimitive;
+};
+
+/**
+ * Length of the common prefix of the Morton codes of the sorted primitives i and j, or -1 if j is out of range.
+ */
+inline int computeCommonPrefixLength(const uint32_t* mortonCodes, int numPrimitives, int i, int j) {
+    if (j < 0 || j >= numPrimitives) {
+        return -1;
+    }
+    uint32_t codeI = mortonCodes[i];
+    uint32_t codeJ = mortonCodes[j];
+    if (codeI == codeJ) {
+        return 32 + countLeadingZeros(uint32_t(i) ^ uint32_t(j));
+    }
+    return countLeadingZeros(codeI ^ codeJ);
+}
+
+/**
+ * Determines the range and split position of inner node i (Karras 2012, Figure 4).
+ */
+inline RadixTreeNode computeRadixTreeNode(const uint32_t* mortonCodes, int numPrimitives, int i) {
+    int direction =
+            computeCommonPrefixLength(mortonCodes, numPrimitives, i, i + 1)
+            - computeCommonPrefixLength(mortonCodes, numPrimitives, i, i - 1) >= 0 ? 1 : -1;
+
+    // Find the other end of the range using exponential and binary search.
+    int minPrefixLength = computeCommonPrefixLength(mortonCodes, numPrimitives, i, i - direction);
+    int maxLength = 2;
+    while (computeCommonPrefixLength(mortonCodes, numPrimitives, i, i + maxLength * direction) > minPrefixLength) {
+        maxLength *= 2;
+    }
+    int length = 0;
+    for (int step = maxLength / 2; step >= 1; step /= 2) {
+        if (computeCommonPrefixLength(mortonCodes, numPrimitives, i, i + (length + step) * direction)
+                > minPrefixLength) {
+            length += step;
+        }
+    }
+    int j = i + length * direction;
+
+    // Find the split position using binary search.
+    int nodePrefixLength = computeCommonPrefixLength(mortonCodes, numPrimitives, i, j);
+    int splitOffset = 0;
+    int step = length;
+    do {
+        step = (step + 1) / 2;
+        if (computeCommonPrefixLength(mortonCodes, numPrimitives, i, i + (splitOffset + step) * direction)
+                > nodePrefixLength) {
+            splitOffset += step;
+        }
+    } while (step > 1);
+    int split = i + splitOffset * direction + std::min(direction, 0);
+
+    RadixTreeNode node{};
+    node.firstPrimitive = uint32_t(std::min(i, j));
+    node.lastPrimitive = uint32_t(std::max(i, j));
+    node.children[0] = uint32_t(split) | (node.firstPrimitive == uint32_t(split) ? LEAF_BIT : 0u);
+    node.children[1] = uint32_t(split + 1) | (node.lastPrimitive == uint32_t(split + 1) ? LEAF_BIT : 0u);
+    return node;
+}
+
+inline void setNodeBounds(Bvh::Node& node, const BoundingBox& bbox) {
+    for (int i = 0; i < 3; i++) {
+        node.bounds[i * 2] = bbox.min[i];
+        node.bounds[i * 2 + 1] = bbox.max[i];
+    }
+}
+
+}
+
+void ParallelLinearBvhBuilder::build(
+        const BoundingBox& globalBbox, const BoundingBox* bboxes, const Vector3* centers, size_t primitiveCount) {
+    bvh.node_count = 0;
+    bvh.nodes.reset();
+    bvh.primitive_indices.reset();
+    if (primitiveCount == 0) {
+        return;
+    }
+    auto numPrimitives = uint32_t(primitiveCount);
+    uint32_t leafSize = std::max(maxLeafSize, 1u);
+
+    // Morton codes of the primitive centers.
+    std::vector<uint32_t> mortonCodes(numPrimitives);
+    std::vector<uint32_t> sortedPrimitiveIndices(numPrimitives);
+    Vector3 gridMin = globalBbox.min;
+    Vector3 gridScale;
+    const auto gridDim = Scalar(1u << uint32_t(MORTON_NUM_BITS / 3));
+    for (int i = 0; i < 3; i++) {
+        Scalar extent = globalBbox.max[i] - globalBbox.min[i];
+        gridScale[i] = extent > Scalar(0) ? gridDim / extent : Scalar(0);
+    }
+    parallelFor(numPrimitives, [&](size_t primitiveIdx) {
+        mortonCodes[primitiveIdx] = computeMortonCode(centers[primitiveIdx], gridMin, gridScale);
+        sortedPrimitiveIndices[primitiveIdx] = uint32_t(primitiveIdx);
+    });
+    radixSortPairs(mortonCodes, sortedPrimitiveIndices, MORTON_NUM_BITS);
+
+    bvh.primitive_indices = std::make_unique<size_t[]>(numPrimitives);
+    parallelFor(numPrimitives, [&](size_t i) {
+        bvh.primitive_indices[i] = sortedPrimitiveIndices[i];
+    });
+
+    if (numPrimitives <= leafSize) {
+        BoundingBox rootBbox = BoundingBox::empty();
+        for (uint32_t i = 0; i < numPrimitives; i++) {
+            rootBbox.extend(bboxes[i]);
+        }
+        bvh.nodes = std::make_unique<Bvh::Node[]>(1);
+        bvh.node_count = 1;
+        setNodeBounds(bvh.nodes[0], rootBbox);
+        bvh.nodes[0].primitive_count = numPrimitives;
+        bvh.nodes[0].first_child_or_primitive = 0;
+        return;
+    }
+
+    // Hierarchy emission: All inner nodes of the binary radix tree are independent.
+    uint32_t numInnerNodes = numPrimitives - 1;
+    std::vector<RadixTreeNode> innerNodes(numInnerNodes);
+    std::vector<uint32_t> innerNodeParents(numInnerNodes);
+    std::vector<uint32_t> leafParents(numPrimitives);
+    parallelFor(numInnerNodes, [&](size_t i) {
+        RadixTreeNode node = computeRadixTreeNode(mortonCodes.data(), int(numPrimitives), int(i));
+        innerNodes[i] = node;
+        for (uint32_t child : node.children) {
+            if ((child & LEAF_BIT) != 0) {
+                leafParents[child & ~LEAF_BIT] = uint32_t(i);
+            } else {
+                innerNodeParents[child] = uint32_t(i);
+            }
+        }
+    });
+
+    // Bottom-up refitting. The first thread arriving at a node terminates, the second one computes its bounds.
+    std::vector<BoundingBox> innerNodeBboxes(numInnerNodes);
+    std::unique_ptr<std::atomic<uint32_t>[]> visitCounters(new std::atomic<uint32_t>[numInnerNodes]);
+    parallelFor(numInnerNodes, [&](size_t i) {
+        visitCounters[i].store(0, std::memory_order_relaxed);
+    });
+    auto getChildBbox = [&](uint32_t child) -> const BoundingBox& {
+        if ((child & LEAF_BIT) != 0) {
+            return bboxes[sortedPrimitiveIndices[child & ~LEAF_BIT]];
+        }
+        return innerNodeBboxes[child];
+    };
+    parallelFor(numPrimitives, [&](size_t leafIdx) {
+        uint32_t nodeIdx = leafParents[leafIdx];
+        while (visitCounters[nodeIdx].fetch_add(1, std::memory_order_acq_rel) != 0) {
+            const RadixTreeNode& node = innerNodes[nodeIdx];
+            BoundingBox bbox = getChildBbox(node.children[0]);
+            bbox.extend(getChildBbox(node.children[1]));
+            innerNodeBboxes[nodeIdx] = bbox;
+            if (nodeIdx == 0) {
+                break;
+            }
+            nodeIdx = innerNodeParents[nodeIdx];
+        }
+    });
+
+    // Inner nodes with more than leafSize primitives are kept and store their two children at consecutive indices.
+    std::vector<uint32_t> childPairOffsets(numInnerNodes);
+    parallelFor(numInnerNodes, [&](size_t i) {
+        const RadixTreeNode& node = innerNodes[i];
+        childPairOffsets[i] = node.lastPrimitive - node.firstPrimitive + 1 > leafSize ? 1u : 0u;
+    });
+    uint32_t numKeptInnerNodes = exclusiveScanParallel(childPairOffsets);
+
+    bvh.node_count = 1 + 2 * size_t(numKeptInnerNodes);
+    bvh.nodes = std::make_unique<Bvh::Node[]>(bvh.node_count);
+    auto writeNode = [&](Bvh::Node& bvhNode, uint32_t radixTreeNodeIdx) {
+        if ((radixTreeNodeIdx & LEAF_BIT) != 0) {
+            uint32_t sortedIdx = radixTreeNodeIdx & ~LEAF_BIT;
+            setNodeBounds(bvhNode, bboxes[sortedPrimitiveIndices[sortedIdx]]);
+            bvhNode.primitive_count = 1;
+            bvhNode.first_child_or_primitive = sortedIdx;
+            return;
+        }
+        const RadixTreeNode& node = innerNodes[radixTreeNodeIdx];
+        setNodeBounds(bvhNode, innerNodeBboxes[radixTreeNodeIdx]);
+        uint32_t numNodePrimitives = node.lastPrimitive - node.firstPrimitive + 1;
+        if (numNodePrimitives > leafSize) {
+            bvhNode.primitive_count = 0;
+            bvhNode.first_child_or_primitive = 1 + 2 * childPairOffsets[radixTreeNodeIdx];
+        } else {
+            bvhNode.primitive_count = numNodePrimitives;
+            bvhNode.first_child_or_primitive = node.firstPrimitive;
+        }
+    };
+    writeNode(bvh.nodes[0], 0);
+    parallelFor(numInnerNodes, [&](size_t i) {
+        const RadixTreeNode& node = innerNodes[i];
+        if (node.lastPrimitive - node.firstPrimitive + 1 <= leafSize) {
+            return;
+        }
+        size_t firstChildIdx = 1 + 2 * size_t(childPairOffsets[i]);
+        writeNode(bvh.nodes[firstChildIdx], node.children[0]);
+        writeNode(bvh.nodes[firstChildIdx + 1], node.children[1]);
+    });
+}
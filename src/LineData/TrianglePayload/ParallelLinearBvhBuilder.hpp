@@ -0,0 +1,74 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_PARALLELLINEARBVHBUILDER_HPP
+#define LINEVIS_PARALLELLINEARBVHBUILDER_HPP
+
+#include <cstdint>
+#include <bvh/bvh.hpp>
+#include <bvh/vector.hpp>
+#include <bvh/bounding_box.hpp>
+
+/**
+ * Parallel linear BVH (LBVH) builder producing the same node layout as the builders of the bvh library.
+ * 1. The Morton codes of the primitive centers are computed in parallel.
+ * 2. The primitives are sorted by their Morton codes using a parallel LSD radix sort.
+ * 3. All inner nodes of the binary radix tree are emitted in parallel (Karras, "Maximizing Parallelism in the
+ *    Construction of BVHs, Octrees, and k-d Trees", HPG 2012). Duplicate Morton codes are disambiguated by the index
+ *    of the primitive in the sorted order.
+ * 4. The bounding boxes are refitted bottom-up in parallel. The second thread arriving at a node processes it.
+ * 5. Subtrees with at most maxLeafSize primitives are collapsed into a single leaf, and the remaining nodes are written
+ *    to bvh.nodes in parallel using a prefix sum over the inner nodes that are kept.
+ */
+class ParallelLinearBvhBuilder {
+public:
+    using Scalar = float;
+    using Bvh = bvh::Bvh<Scalar>;
+    using Vector3 = bvh::Vector3<Scalar>;
+    using BoundingBox = bvh::BoundingBox<Scalar>;
+
+    explicit ParallelLinearBvhBuilder(Bvh& bvh) : bvh(bvh) {}
+
+    /**
+     * Builds the BVH with the same interface as, e.g., bvh::LinearBvhBuilder.
+     * @param globalBbox The union of all primitive bounding boxes. Used for quantizing the primitive centers.
+     * @param bboxes The bounding boxes of the primitives.
+     * @param centers The centers of the primitives.
+     * @param primitiveCount The number of primitives (must be smaller than 2^31).
+     */
+    void build(
+            const BoundingBox& globalBbox, const BoundingBox* bboxes, const Vector3* centers, size_t primitiveCount);
+
+    /// Subtrees with at most this number of primitives are stored as a single leaf. Values < 1 are treated as 1.
+    uint32_t maxLeafSize = 1;
+
+private:
+    Bvh& bvh;
+};
+
+#endif //LINEVIS_PARALLELLINEARBVHBUILDER_HPP
@@ -27,6 +27,14 @@
  */
 
 #include <fstream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
 
 #include <Utils/Events/Stream/Stream.hpp>
 #include <Utils/File/FileLoader.hpp>
@@ -123,8 +131,188 @@ void loadTrajectoriesFromBinLinesV2(
     }
 }
 
+/**
+ * Version 3 of the .binlines file format. The line data is stored in contiguous planes that are accessed through a
+ * memory mapping of the file (see @see BinLinesHeaderV3).
+ */
+bool MappedBinLinesFile::open(const std::string& filename) {
+    mappedFile = std::make_shared<MappedFile>();
+    if (!mappedFile->open(filename, true)) {
+        mappedFile = {};
+        return false;
+    }
+
+    header = mappedFile->getPointer<BinLinesHeaderV3>(0);
+    if (header == nullptr || header->versionNumber != 3u) {
+        sgl::Logfile::get()->writeError(
+                "Error in MappedBinLinesFile::open: File \"" + filename + "\" is not a version 3 .binlines file.");
+        mappedFile = {};
+        header = nullptr;
+        return false;
+    }
+
+    auto numTrajectories = size_t(header->numTrajectories);
+    auto numLinePoints = size_t(header->numLinePoints);
+    // All sizes are checked against the file size, so the products below cannot overflow if the checks pass.
+    bool isSizeValid =
+            header->numTrajectories < uint64_t(std::numeric_limits<size_t>::max())
+            && (header->numAttributes == 0
+                || header->attributePlaneStride <= uint64_t(mappedFile->getSize()) / header->numAttributes);
+    lineOffsets = nullptr;
+    positions = nullptr;
+    attributePlanes = nullptr;
+    if (isSizeValid) {
+        lineOffsets = mappedFile->getPointer<uint64_t>(header->lineOffsetsOffset, numTrajectories + 1);
+        positions = mappedFile->getPointer<glm::vec3>(header->positionsOffset, numLinePoints);
+        attributePlanes = mappedFile->getPointer<uint8_t>(
+                header->attributesOffset, size_t(header->attributePlaneStride) * size_t(header->numAttributes));
+    }
+    ribbonDirections = nullptr;
+    if (header->ribbonDirectionsOffset != 0) {
+        ribbonDirections = mappedFile->getPointer<glm::vec3>(header->ribbonDirectionsOffset, numLinePoints);
+    }
+    bool isValid =
+            lineOffsets != nullptr && positions != nullptr && attributePlanes != nullptr
+            && (header->ribbonDirectionsOffset == 0 || ribbonDirections != nullptr)
+            && header->attributePlaneStride >= sizeof(float) * header->numLinePoints
+            && lineOffsets[0] == 0 && lineOffsets[numTrajectories] == header->numLinePoints
+            && mappedFile->getPointer<uint8_t>(header->metadataOffset, size_t(header->metadataSize)) != nullptr;
+    if (!isValid) {
+        sgl::Logfile::get()->writeError(
+                "Error in MappedBinLinesFile::open: The header of file \"" + filename + "\" is corrupted.");
+        mappedFile = {};
+        header = nullptr;
+        return false;
+    }
+
+    // The per-line pointers into the planes are only in range if the offsets are monotonic.
+    for (size_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+        if (lineOffsets[trajectoryIdx] > lineOffsets[trajectoryIdx + 1]) {
+            sgl::Logfile::get()->writeError(
+                    "Error in MappedBinLinesFile::open: The line offsets of file \"" + filename
+                    + "\" are not monotonic.");
+            mappedFile = {};
+            header = nullptr;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Trajectory MappedBinLinesFile::loadTrajectory(size_t trajectoryIdx) const {
+    Trajectory trajectory;
+    size_t numPoints = getTrajectoryNumPoints(trajectoryIdx);
+    const glm::vec3* trajectoryPositions = getTrajectoryPositions(trajectoryIdx);
+    trajectory.positions.assign(trajectoryPositions, trajectoryPositions + numPoints);
+    trajectory.attributes.resize(header->numAttributes);
+    for (uint32_t attrIdx = 0; attrIdx < header->numAttributes; attrIdx++) {
+        const float* attributeValues = getTrajectoryAttribute(trajectoryIdx, attrIdx);
+        trajectory.attributes.at(attrIdx).assign(attributeValues, attributeValues + numPoints);
+    }
+    return trajectory;
+}
+
+void MappedBinLinesFile::loadMetadata(BinLinesData& binLinesData) const {
+    binLinesData.verticesNormalized = getVerticesNormalized();
+    if (header->metadataSize == 0) {
+        return;
+    }
+
+    // The metadata block is small, so a copy is cheaper than special-casing the (owning) read stream.
+    auto metadataSize = size_t(header->metadataSize);
+    auto* buffer = new uint8_t[metadataSize]; //< BinaryReadStream does deallocation.
+    memcpy(buffer, mappedFile->getData() + header->metadataOffset, metadataSize);
+    sgl::BinaryReadStream stream(buffer, metadataSize);
+
+    if ((header->flags & BINLINES_FLAG_HAS_ATTRIBUTE_NAMES) != 0) {
+        binLinesData.attributeNames.resize(header->numAttributes);
+        for (uint32_t attributeIdx = 0; attributeIdx < header->numAttributes; attributeIdx++) {
+            stream.read(binLinesData.attributeNames.at(attributeIdx));
+        }
+    }
+
+    uint32_t numMeshOutlineTriangleIndices, numMeshOutlineTriangleVertices, numMeshOutlineTriangleNormals;
+    stream.read(numMeshOutlineTriangleIndices);
+    stream.read(numMeshOutlineTriangleVertices);
+    stream.read(numMeshOutlineTriangleNormals);
+    if (numMeshOutlineTriangleIndices != 0) {
+        binLinesData.simulationMeshOutlineTriangleIndices.resize(numMeshOutlineTriangleIndices);
+        stream.read(
+                binLinesData.simulationMeshOutlineTriangleIndices.data(),
+                sizeof(uint32_t) * numMeshOutlineTriangleIndices);
+    }
+    if (numMeshOutlineTriangleVertices != 0) {
+        binLinesData.simulationMeshOutlineVertexPositions.resize(numMeshOutlineTriangleVertices);
+        stream.read(
+                binLinesData.simulationMeshOutlineVertexPositions.data(),
+                sizeof(glm::vec3) * numMeshOutlineTriangleVertices);
+    }
+    if (numMeshOutlineTriangleNormals != 0) {
+        binLinesData.simulationMeshOutlineVertexNormals.resize(numMeshOutlineTriangleNormals);
+        stream.read(
+                binLinesData.simulationMeshOutlineVertexNormals.data(),
+                sizeof(glm::vec3) * numMeshOutlineTriangleNormals);
+    }
+}
+
+void MappedBinLinesFile::loadRibbonDirections(BinLinesData& binLinesData) const {
+    if (!getHasRibbonDirections()) {
+        return;
+    }
+    size_t numTrajectories = getNumTrajectories();
+    binLinesData.ribbonsDirections.resize(numTrajectories);
+    for (size_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+        const glm::vec3* ribbonDirectionsLine = ribbonDirections + lineOffsets[trajectoryIdx];
+        binLinesData.ribbonsDirections.at(trajectoryIdx).assign(
+                ribbonDirectionsLine, ribbonDirectionsLine + getTrajectoryNumPoints(trajectoryIdx));
+    }
+}
+
+void MappedBinLinesFile::loadTrajectories(BinLinesData& binLinesData) const {
+    Trajectories& trajectories = binLinesData.trajectories;
+    size_t numTrajectories = getNumTrajectories();
+    trajectories.resize(numTrajectories);
+
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numTrajectories), [&](auto const& r) {
+        for (auto trajectoryIdx = r.begin(); trajectoryIdx != r.end(); trajectoryIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for shared(trajectories, numTrajectories) default(none)
+#endif
+    for (size_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+#endif
+        trajectories.at(trajectoryIdx) = loadTrajectory(trajectoryIdx);
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    loadRibbonDirections(binLinesData);
+}
+
+uint32_t getBinLinesFileVersion(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ifstream::binary);
+    uint32_t versionNumber = 0;
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&versionNumber), sizeof(uint32_t))) {
+        return 0;
+    }
+    return versionNumber;
+}
+
 BinLinesData loadTrajectoriesFromBinLines(const std::string& filename) {
-    Trajectories trajectories;
+    // Version 3 files are read directly from the mapped pages without an intermediate copy of the whole file.
+    if (getBinLinesFileVersion(filename) == 3u) {
+        BinLinesData binLinesData;
+        MappedBinLinesFile mappedBinLinesFile;
+        if (!mappedBinLinesFile.open(filename)) {
+            return {};
+        }
+        mappedBinLinesFile.loadMetadata(binLinesData);
+        mappedBinLinesFile.loadTrajectories(binLinesData);
+        return binLinesData;
+    }
 
     uint8_t* buffer = nullptr; //< BinaryReadStream does deallocation.
     size_t length = 0;
@@ -151,6 +339,10 @@ BinLinesData loadTrajectoriesFromBinLines(const std::string& filename) {
     return binLinesData;
 }
 
+static inline uint64_t alignBinLinesOffset(uint64_t offset) {
+    return (offset + 15u) & ~uint64_t(15u);
+}
+
 void saveTrajectoriesAsBinLines(const std::string& filename, const BinLinesData& binLinesData) {
 #ifndef __MINGW32__
     std::ofstream file(filename.c_str(), std::ofstream::binary);
@@ -170,78 +362,120 @@ void saveTrajectoriesAsBinLines(const std::string& filename, const BinLinesData&
     }
 #endif
 
-    sgl::BinaryWriteStream stream;
-    stream.write(2u); //< Version number.
+    // The planes are written one after another, so the file never needs to be assembled in memory.
+    uint64_t filePosition = 0;
+    auto writeData = [&](const void* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+#ifndef __MINGW32__
+        file.write(reinterpret_cast<const char*>(data), std::streamsize(size));
+#else
+        fwrite(data, size, 1, fileptr);
+#endif
+        filePosition += size;
+    };
+    auto writePadding = [&](uint64_t targetPosition) {
+        const uint8_t zeros[16] = {};
+        while (filePosition < targetPosition) {
+            writeData(zeros, size_t(std::min(targetPosition - filePosition, uint64_t(16))));
+        }
+    };
 
-    auto numTrajectories = uint32_t(binLinesData.trajectories.size());
+    const Trajectories& trajectories = binLinesData.trajectories;
+    auto numTrajectories = uint64_t(trajectories.size());
     uint32_t numAttributes =
-            binLinesData.trajectories.empty() ? 0 : uint32_t(binLinesData.trajectories.front().attributes.size());
-    stream.write(numTrajectories);
-    stream.write(numAttributes);
-
-    // Write 'Trajectories' base data.
-    for (uint32_t trajectoryIndex = 0; trajectoryIndex < numTrajectories; trajectoryIndex++) {
-        const Trajectory& currentTrajectory = binLinesData.trajectories.at(trajectoryIndex);
-        auto trajectoryNumPoints = uint32_t(currentTrajectory.positions.size());
-        stream.write(trajectoryNumPoints);
-        stream.write(currentTrajectory.positions.data(), sizeof(glm::vec3) * trajectoryNumPoints);
-        for (uint32_t attributeIndex = 0; attributeIndex < numAttributes; attributeIndex++) {
-            const std::vector<float>& currentAttribute = currentTrajectory.attributes.at(attributeIndex);
-            stream.write(currentAttribute.data(), sizeof(float) * trajectoryNumPoints);
-        }
+            trajectories.empty() ? 0 : uint32_t(trajectories.front().attributes.size());
+    std::vector<uint64_t> lineOffsets(numTrajectories + 1);
+    lineOffsets.front() = 0;
+    for (uint64_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+        lineOffsets.at(trajectoryIdx + 1) =
+                lineOffsets.at(trajectoryIdx) + uint64_t(trajectories.at(trajectoryIdx).positions.size());
     }
+    uint64_t numLinePoints = lineOffsets.back();
+    bool hasRibbonData = !binLinesData.ribbonsDirections.empty();
+    bool hasAttributeNames = !binLinesData.attributeNames.empty();
 
-    uint32_t verticesNormalized = binLinesData.verticesNormalized ? 1 : 0;
-    stream.write(verticesNormalized);
-
-    // Attribute name data.
-    uint32_t hasAttributeNames = binLinesData.attributeNames.empty() ? 0 : 1;
-    stream.write(hasAttributeNames);
-    if (hasAttributeNames != 0) {
+    // Attribute name and simulation grid outline mesh data.
+    sgl::BinaryWriteStream metadataStream;
+    if (hasAttributeNames) {
         for (uint32_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
-            stream.write(binLinesData.attributeNames.at(attributeIdx));
-        }
-    }
-
-    // Ribbon direction data.
-    uint32_t hasRibbonData = binLinesData.ribbonsDirections.empty() ? 0 : 1;
-    stream.write(hasRibbonData);
-    if (hasRibbonData != 0) {
-        for (uint32_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
-            size_t trajectoryNumPoints = binLinesData.trajectories.at(trajectoryIdx).positions.size();
-            const std::vector<glm::vec3>& ribbonDirections = binLinesData.ribbonsDirections.at(trajectoryIdx);
-            stream.write(ribbonDirections.data(), sizeof(glm::vec3) * trajectoryNumPoints);
+            metadataStream.write(binLinesData.attributeNames.at(attributeIdx));
         }
     }
-
-    // Simulation grid outline mesh data.
     auto numMeshOutlineTriangleIndices = uint32_t(binLinesData.simulationMeshOutlineTriangleIndices.size());
     auto numMeshOutlineTriangleVertices = uint32_t(binLinesData.simulationMeshOutlineVertexPositions.size());
     auto numMeshOutlineTriangleNormals = uint32_t(binLinesData.simulationMeshOutlineVertexNormals.size());
-    stream.write(numMeshOutlineTriangleIndices);
-    stream.write(numMeshOutlineTriangleVertices);
-    stream.write(numMeshOutlineTriangleNormals);
+    metadataStream.write(numMeshOutlineTriangleIndices);
+    metadataStream.write(numMeshOutlineTriangleVertices);
+    metadataStream.write(numMeshOutlineTriangleNormals);
     if (numMeshOutlineTriangleIndices != 0) {
-        stream.write(
+        metadataStream.write(
                 binLinesData.simulationMeshOutlineTriangleIndices.data(),
                 sizeof(uint32_t) * numMeshOutlineTriangleIndices);
     }
     if (numMeshOutlineTriangleVertices != 0) {
-        stream.write(
+        metadataStream.write(
                 binLinesData.simulationMeshOutlineVertexPositions.data(),
                 sizeof(glm::vec3) * numMeshOutlineTriangleVertices);
     }
     if (numMeshOutlineTriangleNormals != 0) {
-        stream.write(
+        metadataStream.write(
                 binLinesData.simulationMeshOutlineVertexNormals.data(),
                 sizeof(glm::vec3) * numMeshOutlineTriangleNormals);
     }
 
+    BinLinesHeaderV3 header{};
+    header.versionNumber = 3u;
+    header.flags =
+            (binLinesData.verticesNormalized ? uint32_t(BINLINES_FLAG_VERTICES_NORMALIZED) : 0u)
+            | (hasAttributeNames ? uint32_t(BINLINES_FLAG_HAS_ATTRIBUTE_NAMES) : 0u);
+    header.numAttributes = numAttributes;
+    header.numTrajectories = numTrajectories;
+    header.numLinePoints = numLinePoints;
+    header.lineOffsetsOffset = sizeof(BinLinesHeaderV3);
+    header.positionsOffset = alignBinLinesOffset(
+            header.lineOffsetsOffset + sizeof(uint64_t) * (numTrajectories + 1));
+    header.attributesOffset = alignBinLinesOffset(header.positionsOffset + sizeof(glm::vec3) * numLinePoints);
+    header.attributePlaneStride = alignBinLinesOffset(sizeof(float) * numLinePoints);
+    uint64_t endOfPlanes = header.attributesOffset + header.attributePlaneStride * numAttributes;
+    if (hasRibbonData) {
+        header.ribbonDirectionsOffset = endOfPlanes;
+        endOfPlanes = alignBinLinesOffset(endOfPlanes + sizeof(glm::vec3) * numLinePoints);
+    }
+    header.metadataOffset = endOfPlanes;
+    header.metadataSize = metadataStream.getSize();
+
+    writeData(&header, sizeof(BinLinesHeaderV3));
+    writeData(lineOffsets.data(), sizeof(uint64_t) * lineOffsets.size());
+
+    writePadding(header.positionsOffset);
+    for (const Trajectory& trajectory : trajectories) {
+        writeData(trajectory.positions.data(), sizeof(glm::vec3) * trajectory.positions.size());
+    }
+
+    for (uint32_t attributeIdx = 0; attributeIdx < numAttributes; attributeIdx++) {
+        writePadding(header.attributesOffset + header.attributePlaneStride * attributeIdx);
+        for (const Trajectory& trajectory : trajectories) {
+            const std::vector<float>& attributeValues = trajectory.attributes.at(attributeIdx);
+            writeData(attributeValues.data(), sizeof(float) * attributeValues.size());
+        }
+    }
+
+    if (hasRibbonData) {
+        writePadding(header.ribbonDirectionsOffset);
+        for (uint64_t trajectoryIdx = 0; trajectoryIdx < numTrajectories; trajectoryIdx++) {
+            const std::vector<glm::vec3>& ribbonDirections = binLinesData.ribbonsDirections.at(trajectoryIdx);
+            writeData(ribbonDirections.data(), sizeof(glm::vec3) * ribbonDirections.size());
+        }
+    }
+
+    writePadding(header.metadataOffset);
+    writeData(metadataStream.getBuffer(), metadataStream.getSize());
+
 #ifndef __MINGW32__
-    file.write((const char*)stream.getBuffer(), stream.getSize());
     file.close();
 #else
-    fwrite((const void*)stream.getBuffer(), stream.getSize(), 1, fileptr);
     fclose(fileptr);
 #endif
 }
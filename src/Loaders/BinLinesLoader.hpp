@@ -30,9 +30,110 @@
 #define LINEVIS_BINLINESLOADER_HPP
 
 #include <string>
+#include <Utils/MappedFile.hpp>
 #include "TrajectoryFile.hpp"
 
+/**
+ * Header of version 3 of the .binlines file format. Version 3 stores the line data as contiguous planes that can be
+ * accessed directly from a memory mapping of the file:
+ * - Line offset table: uint64_t[numTrajectories + 1], i.e., the first point of each line in the planes below.
+ * - Position plane: glm::vec3[numLinePoints].
+ * - Attribute planes: numAttributes x float[numLinePoints], each starting at a 16-byte aligned offset.
+ * - Ribbon direction plane (optional): glm::vec3[numLinePoints].
+ * - Metadata block: Attribute names and simulation mesh outline in the same encoding as the version 2 trailer.
+ * All offsets are absolute byte offsets from the start of the file.
+ */
+struct BinLinesHeaderV3 {
+    uint32_t versionNumber; ///< Always 3; at the same location as the version number of version 1 and 2.
+    uint32_t flags; ///< Combination of BinLinesFlagsV3.
+    uint32_t numAttributes;
+    uint32_t padding0;
+    uint64_t numTrajectories;
+    uint64_t numLinePoints;
+    uint64_t lineOffsetsOffset;
+    uint64_t positionsOffset;
+    uint64_t attributesOffset;
+    uint64_t attributePlaneStride; ///< Distance in bytes between two subsequent attribute planes.
+    uint64_t ribbonDirectionsOffset; ///< 0 if no ribbon directions are stored.
+    uint64_t metadataOffset;
+    uint64_t metadataSize;
+    uint64_t reserved[5];
+};
+static_assert(sizeof(BinLinesHeaderV3) == 128, "Unexpected size of BinLinesHeaderV3.");
+
+enum BinLinesFlagsV3 : uint32_t {
+    BINLINES_FLAG_VERTICES_NORMALIZED = 1u,
+    BINLINES_FLAG_HAS_ATTRIBUTE_NAMES = 2u
+};
+
+/**
+ * Zero-copy view of a version 3 .binlines file. The position and attribute planes are accessed directly in the mapped
+ * pages, so only pages that are actually touched are read from disk.
+ */
+class MappedBinLinesFile {
+public:
+    /// Returns false if the file could not be mapped or is not a valid version 3 .binlines file.
+    bool open(const std::string& filename);
+
+    [[nodiscard]] inline size_t getNumTrajectories() const { return size_t(header->numTrajectories); }
+    [[nodiscard]] inline size_t getNumLinePoints() const { return size_t(header->numLinePoints); }
+    [[nodiscard]] inline uint32_t getNumAttributes() const { return header->numAttributes; }
+    [[nodiscard]] inline bool getVerticesNormalized() const {
+        return (header->flags & BINLINES_FLAG_VERTICES_NORMALIZED) != 0;
+    }
+    [[nodiscard]] inline bool getHasRibbonDirections() const { return ribbonDirections != nullptr; }
+
+    // Whole planes.
+    [[nodiscard]] inline const uint64_t* getLineOffsets() const { return lineOffsets; }
+    [[nodiscard]] inline const glm::vec3* getPositions() const { return positions; }
+    [[nodiscard]] inline const float* getAttributePlane(uint32_t attrIdx) const {
+        return reinterpret_cast<const float*>(attributePlanes + size_t(attrIdx) * header->attributePlaneStride);
+    }
+    [[nodiscard]] inline const glm::vec3* getRibbonDirections() const { return ribbonDirections; }
+
+    // Lazy per-trajectory access.
+    [[nodiscard]] inline size_t getTrajectoryNumPoints(size_t trajectoryIdx) const {
+        return size_t(lineOffsets[trajectoryIdx + 1] - lineOffsets[trajectoryIdx]);
+    }
+    [[nodiscard]] inline const glm::vec3* getTrajectoryPositions(size_t trajectoryIdx) const {
+        return positions + lineOffsets[trajectoryIdx];
+    }
+    [[nodiscard]] inline const float* getTrajectoryAttribute(size_t trajectoryIdx, uint32_t attrIdx) const {
+        return getAttributePlane(attrIdx) + lineOffsets[trajectoryIdx];
+    }
+    /// Copies the data of a single trajectory out of the mapped pages.
+    [[nodiscard]] Trajectory loadTrajectory(size_t trajectoryIdx) const;
+
+    /// Reads the optional data (attribute names, mesh outline) into the passed object.
+    void loadMetadata(BinLinesData& binLinesData) const;
+    /// Copies the ribbon directions (if any) into the passed object.
+    void loadRibbonDirections(BinLinesData& binLinesData) const;
+    /// Copies all trajectories (and ribbon directions) into the passed object.
+    void loadTrajectories(BinLinesData& binLinesData) const;
+
+    /// Objects referencing the planes above need to keep the mapped file alive.
+    [[nodiscard]] inline const MappedFilePtr& getMappedFile() const { return mappedFile; }
+
+private:
+    MappedFilePtr mappedFile;
+    const BinLinesHeaderV3* header = nullptr;
+    const uint64_t* lineOffsets = nullptr;
+    const glm::vec3* positions = nullptr;
+    const uint8_t* attributePlanes = nullptr;
+    const glm::vec3* ribbonDirections = nullptr;
+};
+
+/**
+ * Returns the format version stored at the start of a .binlines file, or 0 if the file could not be read.
+ */
+uint32_t getBinLinesFileVersion(const std::string& filename);
+/**
+ * Loads a .binlines file of version 1, 2 or 3. Version 3 files are read through a memory mapping of the file.
+ */
 BinLinesData loadTrajectoriesFromBinLines(const std::string& filename);
+/**
+ * Saves the passed data as a version 3 .binlines file.
+ */
 void saveTrajectoriesAsBinLines(const std::string& filename, const BinLinesData& binLinesData);
 
 #endif //LINEVIS_BINLINESLOADER_HPP
@@ -27,13 +27,30 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <functional>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+#endif
 
 #include <Utils/File/Logfile.hpp>
 #include <Utils/File/FileLoader.hpp>
 
+#include "Utils/MappedFile.hpp"
 #include "ObjLoader.hpp"
 
-Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<std::string>& attributeNames) {
+Trajectories loadTrajectoriesFromObjSequential(
+        const std::string& filename, std::vector<std::string>& attributeNames) {
     Trajectories trajectories;
 
     std::vector<glm::vec3> globalLineVertices;
@@ -44,7 +61,8 @@ Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<st
     size_t length = 0;
     bool loaded = sgl::loadFileFromSource(filename, buffer, length, false);
     if (!loaded) {
-        sgl::Logfile::get()->writeError("Error in loadTrajectoriesFromObj: Could not open file \"" + filename + "\".");
+        sgl::Logfile::get()->writeError(
+                "Error in loadTrajectoriesFromObjSequential: Could not open file \"" + filename + "\".");
         return trajectories;
     }
     char* fileBuffer = reinterpret_cast<char*>(buffer);
@@ -96,7 +114,7 @@ Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<st
 
             if (numVertexAttributesGlobal > 0 && numVertexAttributesGlobal != numAttributes) {
                 sgl::Logfile::get()->writeError(
-                        std::string() + "Error in loadTrajectoriesFromObj: Encountered inconsistent number of "
+                        std::string() + "Error in loadTrajectoriesFromObjSequential: Encountered inconsistent number of "
                         + "vertex attributes in file \"" + filename + "\".");
             }
             numVertexAttributesGlobal = numAttributes;
@@ -193,3 +211,495 @@ Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<st
 
     return trajectories;
 }
+
+
+/*
+ * Locale-free number parsing on raw character ranges. Neither function allocates or requires null-terminated input.
+ */
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define OBJ_LOADER_USE_FROM_CHARS
+#endif
+
+static inline bool isObjWhitespace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static inline const char* skipObjWhitespace(const char* ptr, const char* end) {
+    while (ptr != end && isObjWhitespace(*ptr)) {
+        ptr++;
+    }
+    return ptr;
+}
+
+static inline const char* skipObjToken(const char* ptr, const char* end) {
+    while (ptr != end && !isObjWhitespace(*ptr)) {
+        ptr++;
+    }
+    return ptr;
+}
+
+/**
+ * Returns a pointer to the first line terminator in [ptr, end), or end if there is none. As in the sequential loader,
+ * both '\n' and '\r' end a line, so files with LF, CRLF and CR-only line endings are supported ("\r\n" yields an
+ * additional empty line, which is skipped).
+ */
+static inline const char* findObjLineEnd(const char* ptr, const char* end) {
+    while (ptr != end && *ptr != '\n' && *ptr != '\r') {
+        ptr++;
+    }
+    return ptr;
+}
+
+/// Returns a pointer to the first occurrence of c in [ptr, end), or end if there is none.
+static inline const char* findObjChar(const char* ptr, const char* end, char c) {
+    const void* found = memchr(ptr, c, size_t(end - ptr));
+    return found ? static_cast<const char*>(found) : end;
+}
+
+/**
+ * Slow path for special values ("inf", "nan") and values out of the float range. The token is copied, as strtof needs
+ * a null-terminated string.
+ */
+static const char* parseObjFloatStrtof(const char* ptr, const char* end, float& value) {
+    char tokenBuffer[64];
+    size_t tokenLength = std::min(size_t(skipObjToken(ptr, end) - ptr), sizeof(tokenBuffer) - 1);
+    memcpy(tokenBuffer, ptr, tokenLength);
+    tokenBuffer[tokenLength] = '\0';
+    char* tokenEnd = nullptr;
+    value = std::strtof(tokenBuffer, &tokenEnd);
+    return tokenEnd == tokenBuffer ? nullptr : ptr + (tokenEnd - tokenBuffer);
+}
+
+/**
+ * Parses a floating point number in the range [ptr, end).
+ * @return The pointer to the first character after the number, or nullptr if no number could be parsed.
+ */
+static const char* parseObjFloat(const char* ptr, const char* end, float& value) {
+    if (ptr != end && *ptr == '+') {
+        ptr++;
+    }
+#ifdef OBJ_LOADER_USE_FROM_CHARS
+    std::from_chars_result result = std::from_chars(ptr, end, value);
+    if (result.ec == std::errc::invalid_argument) {
+        return nullptr;
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        return parseObjFloatStrtof(ptr, end, value);
+    }
+    return result.ptr;
+#else
+    const char* start = ptr;
+    bool negative = false;
+    if (ptr != end && *ptr == '-') {
+        negative = true;
+        ptr++;
+    }
+
+    if (ptr != end && (*ptr == 'i' || *ptr == 'I' || *ptr == 'n' || *ptr == 'N')) {
+        return parseObjFloatStrtof(start, end, value);
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    bool hasDigits = false;
+    while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+        if (numDigits < 19) {
+            mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+            if (mantissa != 0) {
+                numDigits++;
+            }
+        } else {
+            exponent++;
+        }
+        hasDigits = true;
+        ptr++;
+    }
+    if (ptr != end && *ptr == '.') {
+        ptr++;
+        while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+            if (numDigits < 19) {
+                mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+                exponent--;
+                if (mantissa != 0) {
+                    numDigits++;
+                }
+            }
+            hasDigits = true;
+            ptr++;
+        }
+    }
+    if (!hasDigits) {
+        return nullptr;
+    }
+    if (ptr != end && (*ptr == 'e' || *ptr == 'E')) {
+        const char* exponentStart = ptr;
+        ptr++;
+        bool negativeExponent = false;
+        if (ptr != end && (*ptr == '+' || *ptr == '-')) {
+            negativeExponent = *ptr == '-';
+            ptr++;
+        }
+        if (ptr != end && *ptr >= '0' && *ptr <= '9') {
+            int exponentValue = 0;
+            while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+                exponentValue = std::min(exponentValue * 10 + int(*ptr - '0'), 10000);
+                ptr++;
+            }
+            exponent += negativeExponent ? -exponentValue : exponentValue;
+        } else {
+            ptr = exponentStart;
+        }
+    }
+
+    // The mantissa holds at most 19 significant digits, so double precision arithmetic is exact enough for floats.
+    double result = double(mantissa);
+    if (exponent != 0 && mantissa != 0) {
+        if (exponent < -300 || exponent > 300) {
+            return parseObjFloatStrtof(start, end, value);
+        }
+        result *= std::pow(10.0, double(exponent));
+    }
+    value = float(negative ? -result : result);
+    return ptr;
+#endif
+}
+
+/**
+ * Parses an unsigned integer in the range [ptr, end).
+ * @return The pointer to the first character after the number, or nullptr if no number could be parsed or the number
+ * exceeds the range of uint32_t (the type of the vertex indices).
+ */
+static inline const char* parseObjIndex(const char* ptr, const char* end, int64_t& value) {
+    bool negative = false;
+    if (ptr != end && (*ptr == '-' || *ptr == '+')) {
+        negative = *ptr == '-';
+        ptr++;
+    }
+    const char* digitsStart = ptr;
+    int64_t result = 0;
+    while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+        result = result * 10 + int64_t(*ptr - '0');
+        // Stop before the next digit could overflow int64_t.
+        if (result > int64_t(std::numeric_limits<uint32_t>::max())) {
+            return nullptr;
+        }
+        ptr++;
+    }
+    if (ptr == digitsStart) {
+        return nullptr;
+    }
+    value = negative ? -result : result;
+    // Skip texture/normal indices of the form "v/vt/vn".
+    return skipObjToken(ptr, end);
+}
+
+/// Data parsed from one newline-aligned chunk of the file.
+struct ObjChunkData {
+    std::vector<glm::vec3> vertices;
+    std::vector<float> vertexAttributes;
+    std::vector<uint32_t> lineIndices; ///< Global one-based vertex indices of all "l" commands.
+    std::vector<uint32_t> lineNumIndices; ///< Number of entries in lineIndices per "l" command.
+    std::vector<std::string> attributeNames; ///< Names of the first "a" command in the chunk.
+    size_t numVertexAttributes = 0; ///< Number of values of the first "vt" command in the chunk.
+    bool hasAttributeNames = false;
+    bool inconsistentNumAttributes = false;
+    bool hasInvalidIndices = false;
+};
+
+static void parseObjChunk(const char* chunkBegin, const char* chunkEnd, ObjChunkData& chunk) {
+    // Rough upper bound for the number of vertices ("v x y z\n" needs at least 8 bytes).
+    chunk.vertices.reserve(size_t(chunkEnd - chunkBegin) / 32);
+
+    // Both '\n' and '\r' end a line (@see findObjLineEnd). Their next positions are found with memchr, which is faster
+    // than a byte loop, and only searched again once the current line starts after them, so that every byte is scanned
+    // at most once per terminator, also for files with CR-only line endings.
+    const char* linePtr = chunkBegin;
+    const char* newlinePtr = findObjChar(chunkBegin, chunkEnd, '\n');
+    const char* carriageReturnPtr = findObjChar(chunkBegin, chunkEnd, '\r');
+    while (linePtr < chunkEnd) {
+        if (newlinePtr < linePtr) {
+            newlinePtr = findObjChar(linePtr, chunkEnd, '\n');
+        }
+        if (carriageReturnPtr < linePtr) {
+            carriageReturnPtr = findObjChar(linePtr, chunkEnd, '\r');
+        }
+        const char* lineEnd = std::min(newlinePtr, carriageReturnPtr);
+        const char* nextLine = lineEnd == chunkEnd ? chunkEnd : lineEnd + 1;
+
+        if (linePtr == lineEnd) {
+            linePtr = nextLine;
+            continue;
+        }
+
+        char command = linePtr[0];
+        char command2 = lineEnd - linePtr > 1 ? linePtr[1] : ' ';
+        const char* ptr = linePtr + std::min(ptrdiff_t(2), lineEnd - linePtr);
+
+        if (command == 'v' && command2 == 't') {
+            size_t numAttributes = 0;
+            float value = 0.0f;
+            while ((ptr = skipObjWhitespace(ptr, lineEnd)) != lineEnd) {
+                const char* valueEnd = parseObjFloat(ptr, lineEnd, value);
+                if (valueEnd == nullptr) {
+                    // Mimic atof, which returns zero for unparsable tokens.
+                    value = 0.0f;
+                    valueEnd = skipObjToken(ptr, lineEnd);
+                }
+                chunk.vertexAttributes.push_back(value);
+                numAttributes++;
+                ptr = skipObjToken(valueEnd, lineEnd);
+            }
+            if (chunk.numVertexAttributes == 0) {
+                chunk.numVertexAttributes = numAttributes;
+            } else if (chunk.numVertexAttributes != numAttributes) {
+                chunk.inconsistentNumAttributes = true;
+            }
+        } else if (command == 'v' && command2 != 'n') {
+            // Path line vertex position
+            glm::vec3 position(0.0f);
+            for (int i = 0; i < 3; i++) {
+                ptr = skipObjWhitespace(ptr, lineEnd);
+                ptr = parseObjFloat(ptr, lineEnd, position[i]);
+                if (ptr == nullptr) {
+                    break;
+                }
+            }
+            chunk.vertices.push_back(position);
+        } else if (command == 'l') {
+            uint32_t numIndices = 0;
+            int64_t index = 0;
+            while ((ptr = skipObjWhitespace(ptr, lineEnd)) != lineEnd) {
+                const char* indexEnd = parseObjIndex(ptr, lineEnd, index);
+                if (indexEnd == nullptr || index <= 0 || index > int64_t(std::numeric_limits<uint32_t>::max())) {
+                    chunk.hasInvalidIndices = true;
+                    ptr = skipObjToken(ptr, lineEnd);
+                    continue;
+                }
+                chunk.lineIndices.push_back(uint32_t(index));
+                numIndices++;
+                ptr = indexEnd;
+            }
+            chunk.lineNumIndices.push_back(numIndices);
+        } else if (command == 'a' && !chunk.hasAttributeNames) {
+            chunk.hasAttributeNames = true;
+            while ((ptr = skipObjWhitespace(ptr, lineEnd)) != lineEnd) {
+                const char* tokenEnd = skipObjToken(ptr, lineEnd);
+                chunk.attributeNames.emplace_back(ptr, tokenEnd);
+                ptr = tokenEnd;
+            }
+        }
+        // "g", "vn", "#" and unknown commands are ignored, as in the sequential loader.
+
+        linePtr = nextLine;
+    }
+}
+
+Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<std::string>& attributeNames) {
+    Trajectories trajectories;
+
+    MappedFile mappedFile;
+    if (!mappedFile.open(filename, true)) {
+        sgl::Logfile::get()->writeError("Error in loadTrajectoriesFromObj: Could not open file \"" + filename + "\".");
+        return trajectories;
+    }
+    const char* fileBuffer = reinterpret_cast<const char*>(mappedFile.getData());
+    const size_t length = mappedFile.getSize();
+
+    // Split the file into chunks that start at line boundaries. Using more chunks than threads balances the load.
+    const size_t minChunkSize = size_t(1) << 20;
+    size_t numThreads = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+    size_t numChunks = std::clamp(length / minChunkSize, size_t(1), numThreads * 4);
+    std::vector<size_t> chunkOffsets;
+    chunkOffsets.reserve(numChunks + 1);
+    chunkOffsets.push_back(0);
+    for (size_t chunkIdx = 1; chunkIdx < numChunks; chunkIdx++) {
+        size_t offset = std::max(length / numChunks * chunkIdx, chunkOffsets.back());
+        const char* lineEnd = findObjLineEnd(fileBuffer + offset, fileBuffer + length);
+        if (lineEnd == fileBuffer + length) {
+            break;
+        }
+        offset = size_t(lineEnd - fileBuffer) + 1;
+        if (offset > chunkOffsets.back() && offset < length) {
+            chunkOffsets.push_back(offset);
+        }
+    }
+    chunkOffsets.push_back(length);
+    numChunks = chunkOffsets.size() - 1;
+
+    std::vector<ObjChunkData> chunks(numChunks);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numChunks, 1), [&](auto const& r) {
+        for (auto chunkIdx = r.begin(); chunkIdx != r.end(); chunkIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for schedule(dynamic) shared(numChunks, chunks, chunkOffsets, fileBuffer) default(none)
+#endif
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+#endif
+        parseObjChunk(
+                fileBuffer + chunkOffsets.at(chunkIdx), fileBuffer + chunkOffsets.at(chunkIdx + 1),
+                chunks.at(chunkIdx));
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    // Exclusive prefix sums over the per-chunk vertex, attribute and line counts.
+    size_t numVertexAttributesGlobal = 0;
+    bool inconsistentNumAttributes = false;
+    bool hasInvalidIndices = false;
+    std::vector<size_t> vertexOffsets(numChunks + 1, 0);
+    std::vector<size_t> vertexAttributeOffsets(numChunks + 1, 0);
+    std::vector<size_t> lineOffsets(numChunks + 1, 0);
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        ObjChunkData& chunk = chunks.at(chunkIdx);
+        vertexOffsets.at(chunkIdx + 1) = vertexOffsets.at(chunkIdx) + chunk.vertices.size();
+        vertexAttributeOffsets.at(chunkIdx + 1) =
+                vertexAttributeOffsets.at(chunkIdx) + chunk.vertexAttributes.size();
+        lineOffsets.at(chunkIdx + 1) = lineOffsets.at(chunkIdx) + chunk.lineNumIndices.size();
+        if (chunk.numVertexAttributes > 0) {
+            if (numVertexAttributesGlobal > 0 && numVertexAttributesGlobal != chunk.numVertexAttributes) {
+                inconsistentNumAttributes = true;
+            }
+            numVertexAttributesGlobal = chunk.numVertexAttributes;
+        }
+        inconsistentNumAttributes = inconsistentNumAttributes || chunk.inconsistentNumAttributes;
+        hasInvalidIndices = hasInvalidIndices || chunk.hasInvalidIndices;
+        if (attributeNames.empty() && chunk.hasAttributeNames) {
+            attributeNames = std::move(chunk.attributeNames);
+        }
+    }
+    if (inconsistentNumAttributes) {
+        sgl::Logfile::get()->writeError(
+                std::string() + "Error in loadTrajectoriesFromObj: Encountered inconsistent number of "
+                + "vertex attributes in file \"" + filename + "\".");
+    }
+
+    // Merge the vertex and attribute blocks at their prefix sum offsets.
+    std::vector<glm::vec3> globalLineVertices(vertexOffsets.back());
+    std::vector<float> globalLineVertexAttributes(vertexAttributeOffsets.back());
+    std::vector<size_t> lineIndexOffsets(lineOffsets.back() + 1, 0);
+    std::vector<size_t> chunkLineIndexOffsets(numChunks + 1, 0);
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        chunkLineIndexOffsets.at(chunkIdx + 1) =
+                chunkLineIndexOffsets.at(chunkIdx) + chunks.at(chunkIdx).lineIndices.size();
+    }
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numChunks, 1), [&](auto const& r) {
+        for (auto chunkIdx = r.begin(); chunkIdx != r.end(); chunkIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for shared(numChunks, chunks, vertexOffsets, vertexAttributeOffsets, lineOffsets) \
+    shared(globalLineVertices, globalLineVertexAttributes, lineIndexOffsets, chunkLineIndexOffsets) default(none)
+#endif
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+#endif
+        ObjChunkData& chunk = chunks.at(chunkIdx);
+        std::copy(
+                chunk.vertices.begin(), chunk.vertices.end(),
+                globalLineVertices.begin() + ptrdiff_t(vertexOffsets.at(chunkIdx)));
+        std::copy(
+                chunk.vertexAttributes.begin(), chunk.vertexAttributes.end(),
+                globalLineVertexAttributes.begin() + ptrdiff_t(vertexAttributeOffsets.at(chunkIdx)));
+        size_t lineIndexOffset = chunkLineIndexOffsets.at(chunkIdx);
+        size_t lineIdx = lineOffsets.at(chunkIdx);
+        for (uint32_t numIndices : chunk.lineNumIndices) {
+            lineIndexOffsets.at(lineIdx) = lineIndexOffset;
+            lineIndexOffset += numIndices;
+            lineIdx++;
+        }
+        std::vector<glm::vec3>().swap(chunk.vertices);
+        std::vector<float>().swap(chunk.vertexAttributes);
+    }
+#ifdef USE_TBB
+    });
+#endif
+    lineIndexOffsets.back() = chunkLineIndexOffsets.back();
+
+    // The line indices are only needed as one global array from here on.
+    std::vector<uint32_t> globalLineIndices(chunkLineIndexOffsets.back());
+    for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+        ObjChunkData& chunk = chunks.at(chunkIdx);
+        std::copy(
+                chunk.lineIndices.begin(), chunk.lineIndices.end(),
+                globalLineIndices.begin() + ptrdiff_t(chunkLineIndexOffsets.at(chunkIdx)));
+        std::vector<uint32_t>().swap(chunk.lineIndices);
+    }
+
+    // Build the trajectories. Lines can reference vertices of any chunk, so this needs the merged arrays.
+    size_t numLines = lineOffsets.back();
+    size_t numVertices = globalLineVertices.size();
+    size_t numVerticesWithAttributes =
+            numVertexAttributesGlobal == 0 ? 0 : globalLineVertexAttributes.size() / numVertexAttributesGlobal;
+    trajectories.resize(numLines);
+    bool hasInvalidLineIndices = false;
+#ifdef USE_TBB
+    hasInvalidLineIndices = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, numLines), false,
+            [&](tbb::blocked_range<size_t> const& r, bool hasInvalidLineIndicesLocal) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for reduction(||: hasInvalidLineIndices) shared(numLines, numVertices) \
+    shared(numVerticesWithAttributes, numVertexAttributesGlobal, trajectories, lineIndexOffsets, globalLineIndices) \
+    shared(globalLineVertices, globalLineVertexAttributes) default(none)
+#endif
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        bool& hasInvalidLineIndicesLocal = hasInvalidLineIndices;
+#endif
+        Trajectory& trajectory = trajectories.at(lineIdx);
+        const size_t indexBegin = lineIndexOffsets.at(lineIdx);
+        const size_t indexEnd = lineIndexOffsets.at(lineIdx + 1);
+        trajectory.positions.reserve(indexEnd - indexBegin);
+        trajectory.attributes.resize(numVertexAttributesGlobal);
+        for (size_t j = 0; j < numVertexAttributesGlobal; j++) {
+            trajectory.attributes.at(j).reserve(indexEnd - indexBegin);
+        }
+
+        for (size_t i = indexBegin; i < indexEnd; i++) {
+            const size_t vertexIdx = size_t(globalLineIndices[i]) - 1;
+            if (vertexIdx >= numVertices) {
+                hasInvalidLineIndicesLocal = true;
+                continue;
+            }
+            const glm::vec3& pos = globalLineVertices[vertexIdx];
+
+            // Remove large values (often used in many scientific datasets to indicate invalid lines/line points).
+            const float MAX_VAL = 1e10f;
+            if (std::fabs(pos.x) > MAX_VAL || std::fabs(pos.y) > MAX_VAL || std::fabs(pos.z) > MAX_VAL) {
+                continue;
+            }
+            if (numVertexAttributesGlobal > 0 && vertexIdx >= numVerticesWithAttributes) {
+                hasInvalidLineIndicesLocal = true;
+                continue;
+            }
+
+            trajectory.positions.push_back(pos);
+            for (size_t j = 0; j < numVertexAttributesGlobal; j++) {
+                trajectory.attributes[j].push_back(
+                        globalLineVertexAttributes[vertexIdx * numVertexAttributesGlobal + j]);
+            }
+        }
+    }
+#ifdef USE_TBB
+        return hasInvalidLineIndicesLocal;
+    }, std::logical_or<>{});
+#endif
+    if (hasInvalidIndices || hasInvalidLineIndices) {
+        sgl::Logfile::get()->writeError(
+                std::string() + "Error in loadTrajectoriesFromObj: Encountered invalid line vertex indices in file \""
+                + filename + "\".");
+    }
+
+    size_t geometryByteSize = 0;
+    for (const auto& trajectory : trajectories) {
+        geometryByteSize += trajectory.positions.size() * sizeof(float) * 3;
+        for (const std::vector<float>& attributes : trajectory.attributes) {
+            geometryByteSize += attributes.size() * sizeof(float);
+        }
+    }
+    std::cout << "Size of line geometry data (MiB): " << (geometryByteSize / (1024.0 * 1024.0)) << std::endl;
+
+    return trajectories;
+}
@@ -32,6 +32,19 @@
 #include <string>
 #include "TrajectoryFile.hpp"
 
+/**
+ * Loads line data from an ASCII .obj file. The memory-mapped file is split into chunks at line boundaries, which are
+ * parsed in parallel and merged afterwards using prefix sums over the per-chunk vertex, attribute and line counts.
+ * @param filename The name of the .obj file to load.
+ * @param attributeNames The names of the vertex attributes (only written if empty and an "a" command exists).
+ * @return The loaded trajectories.
+ */
 Trajectories loadTrajectoriesFromObj(const std::string& filename, std::vector<std::string>& attributeNames);
 
+/**
+ * Single-threaded reference implementation of @see loadTrajectoriesFromObj. It is kept for comparing results and
+ * loading throughput in the test suite.
+ */
+Trajectories loadTrajectoriesFromObjSequential(const std::string& filename, std::vector<std::string>& attributeNames);
+
 #endif //LINEVIS_OBJLOADER_HPP
@@ -0,0 +1,493 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <functional>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include <Utils/File/Logfile.hpp>
+
+#include "BinLinesLoader.hpp"
+#include "TrajectoryStore.hpp"
+
+TrajectoryStore::TrajectoryStore(const Trajectories& trajectories) {
+    setTrajectories(trajectories);
+}
+
+TrajectoryStore::TrajectoryStore(const TrajectoryStore& other)
+        : lineOffsets(other.lineOffsets), positionsData(other.positionsData), attributesData(other.attributesData),
+          positionsPtr(other.positionsPtr), attributePtrs(other.attributePtrs), mappedFile(other.mappedFile),
+          ownsPositions(other.ownsPositions) {
+    updatePointers();
+}
+
+TrajectoryStore::TrajectoryStore(TrajectoryStore&& other) noexcept
+        : lineOffsets(std::move(other.lineOffsets)), positionsData(std::move(other.positionsData)),
+          attributesData(std::move(other.attributesData)), positionsPtr(other.positionsPtr),
+          attributePtrs(std::move(other.attributePtrs)), mappedFile(std::move(other.mappedFile)),
+          ownsPositions(other.ownsPositions) {
+    other.clear();
+}
+
+TrajectoryStore& TrajectoryStore::operator=(const TrajectoryStore& other) {
+    if (this != &other) {
+        lineOffsets = other.lineOffsets;
+        positionsData = other.positionsData;
+        attributesData = other.attributesData;
+        positionsPtr = other.positionsPtr;
+        attributePtrs = other.attributePtrs;
+        mappedFile = other.mappedFile;
+        ownsPositions = other.ownsPositions;
+        updatePointers();
+    }
+    return *this;
+}
+
+TrajectoryStore& TrajectoryStore::operator=(TrajectoryStore&& other) noexcept {
+    if (this != &other) {
+        // Moving a std::vector keeps its heap buffer, so the raw pointers stay valid.
+        lineOffsets = std::move(other.lineOffsets);
+        positionsData = std::move(other.positionsData);
+        attributesData = std::move(other.attributesData);
+        positionsPtr = other.positionsPtr;
+        attributePtrs = std::move(other.attributePtrs);
+        mappedFile = std::move(other.mappedFile);
+        ownsPositions = other.ownsPositions;
+        other.clear();
+    }
+    return *this;
+}
+
+void TrajectoryStore::clear() {
+    lineOffsets.clear();
+    lineOffsets.push_back(0);
+    positionsData = {};
+    attributesData = {};
+    positionsPtr = nullptr;
+    attributePtrs.clear();
+    mappedFile = {};
+    ownsPositions = false;
+}
+
+void TrajectoryStore::updatePointers() {
+    if (mappedFile) {
+        // The planes not detached yet still reference the mapped file.
+        if (ownsPositions) {
+            positionsPtr = positionsData.data();
+        }
+        return;
+    }
+    positionsPtr = positionsData.data();
+    attributePtrs.resize(attributesData.size());
+    for (size_t attrIdx = 0; attrIdx < attributesData.size(); attrIdx++) {
+        attributePtrs.at(attrIdx) = attributesData.at(attrIdx).data();
+    }
+}
+
+void TrajectoryStore::makeOwned() {
+    if (!mappedFile) {
+        return;
+    }
+    size_t numLinePoints = getNumLinePoints();
+    if (!ownsPositions) {
+        positionsData.assign(positionsPtr, positionsPtr + numLinePoints);
+    }
+    attributesData.resize(attributePtrs.size());
+    for (size_t attrIdx = 0; attrIdx < attributePtrs.size(); attrIdx++) {
+        attributesData.at(attrIdx).assign(attributePtrs.at(attrIdx), attributePtrs.at(attrIdx) + numLinePoints);
+    }
+    mappedFile = {};
+    ownsPositions = false;
+    updatePointers();
+}
+
+bool TrajectoryStore::getIsDataOf(const TrajectoryView& trajectory) const {
+    if (trajectory.positions.empty()) {
+        return false;
+    }
+    std::less_equal<const glm::vec3*> lessEqual;
+    return lessEqual(positionsPtr, trajectory.positions.data())
+            && lessEqual(trajectory.positions.data(), positionsPtr + getNumLinePoints());
+}
+
+void TrajectoryStore::setTrajectories(const Trajectories& trajectories) {
+    clear();
+    size_t numLines = trajectories.size();
+    size_t numAttributes = trajectories.empty() ? 0 : trajectories.front().attributes.size();
+    lineOffsets.resize(numLines + 1);
+    lineOffsets.front() = 0;
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        const Trajectory& trajectory = trajectories.at(lineIdx);
+        if (trajectory.attributes.size() != numAttributes) {
+            sgl::Logfile::get()->throwError(
+                    "Error in TrajectoryStore::setTrajectories: All lines need the same number of attributes.");
+        }
+        lineOffsets.at(lineIdx + 1) = lineOffsets.at(lineIdx) + uint64_t(trajectory.positions.size());
+    }
+    size_t numLinePoints = getNumLinePoints();
+
+    positionsData.resize(numLinePoints);
+    attributesData.resize(numAttributes);
+    for (std::vector<float>& attributeValues : attributesData) {
+        attributeValues.resize(numLinePoints);
+    }
+
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numLines), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for shared(trajectories, numLines, numAttributes) default(none)
+#endif
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+#endif
+        const Trajectory& trajectory = trajectories[lineIdx];
+        size_t offset = lineOffsets[lineIdx];
+        size_t numPoints = trajectory.positions.size();
+        if (numPoints == 0) {
+            continue;
+        }
+        memcpy(positionsData.data() + offset, trajectory.positions.data(), sizeof(glm::vec3) * numPoints);
+        for (size_t attrIdx = 0; attrIdx < numAttributes; attrIdx++) {
+            memcpy(
+                    attributesData[attrIdx].data() + offset, trajectory.attributes[attrIdx].data(),
+                    sizeof(float) * numPoints);
+        }
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    updatePointers();
+}
+
+void TrajectoryStore::setMappedBinLines(const MappedBinLinesFile& mappedBinLinesFile) {
+    clear();
+    size_t numLines = mappedBinLinesFile.getNumTrajectories();
+    const uint64_t* mappedLineOffsets = mappedBinLinesFile.getLineOffsets();
+    lineOffsets.assign(mappedLineOffsets, mappedLineOffsets + numLines + 1);
+    positionsPtr = mappedBinLinesFile.getPositions();
+    attributePtrs.resize(mappedBinLinesFile.getNumAttributes());
+    for (uint32_t attrIdx = 0; attrIdx < mappedBinLinesFile.getNumAttributes(); attrIdx++) {
+        attributePtrs.at(attrIdx) = mappedBinLinesFile.getAttributePlane(attrIdx);
+    }
+    mappedFile = mappedBinLinesFile.getMappedFile();
+}
+
+void TrajectoryStore::setLineData(
+        std::vector<uint64_t> newLineOffsets, std::vector<glm::vec3> positions,
+        std::vector<std::vector<float>> attributes) {
+    if (newLineOffsets.empty() || newLineOffsets.front() != 0 || newLineOffsets.back() != positions.size()) {
+        sgl::Logfile::get()->throwError(
+                "Error in TrajectoryStore::setLineData: The line offsets do not match the number of positions.");
+    }
+    for (const std::vector<float>& attributeValues : attributes) {
+        if (attributeValues.size() != positions.size()) {
+            sgl::Logfile::get()->throwError(
+                    "Error in TrajectoryStore::setLineData: The number of values does not match the number of points.");
+        }
+    }
+    clear();
+    lineOffsets = std::move(newLineOffsets);
+    positionsData = std::move(positions);
+    attributesData = std::move(attributes);
+    updatePointers();
+}
+
+Trajectories TrajectoryStore::toTrajectories() const {
+    Trajectories trajectories(size());
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, size()), [&](auto const& r) {
+        for (auto lineIdx = r.begin(); lineIdx != r.end(); lineIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for shared(trajectories) default(none)
+#endif
+    for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+#endif
+        trajectories[lineIdx] = (*this)[lineIdx].toTrajectory();
+    }
+#ifdef USE_TBB
+    });
+#endif
+    return trajectories;
+}
+
+void TrajectoryStore::reserve(size_t numLines, size_t numLinePoints) {
+    makeOwned();
+    lineOffsets.reserve(numLines + 1);
+    positionsData.reserve(numLinePoints);
+    for (std::vector<float>& attributeValues : attributesData) {
+        attributeValues.reserve(numLinePoints);
+    }
+    updatePointers();
+}
+
+void TrajectoryStore::pushBack(const Trajectory& trajectory) {
+    makeOwned();
+    if (empty() && attributesData.empty()) {
+        attributesData.resize(trajectory.attributes.size());
+    }
+    if (trajectory.attributes.size() != attributesData.size()) {
+        sgl::Logfile::get()->throwError(
+                "Error in TrajectoryStore::pushBack: All lines need the same number of attributes.");
+    }
+    positionsData.insert(positionsData.end(), trajectory.positions.begin(), trajectory.positions.end());
+    for (size_t attrIdx = 0; attrIdx < attributesData.size(); attrIdx++) {
+        const std::vector<float>& attributeValues = trajectory.attributes.at(attrIdx);
+        attributesData.at(attrIdx).insert(
+                attributesData.at(attrIdx).end(), attributeValues.begin(), attributeValues.end());
+    }
+    lineOffsets.push_back(lineOffsets.back() + uint64_t(trajectory.positions.size()));
+    updatePointers();
+}
+
+void TrajectoryStore::pushBack(const TrajectoryView& trajectory) {
+    // Growing the storage (or detaching it from the mapped file) would invalidate a view of one of our own lines.
+    if (getIsDataOf(trajectory)) {
+        pushBack(trajectory.toTrajectory());
+        return;
+    }
+    makeOwned();
+    if (empty() && attributesData.empty()) {
+        attributesData.resize(trajectory.attributes.size());
+    }
+    if (trajectory.attributes.size() != attributesData.size()) {
+        sgl::Logfile::get()->throwError(
+                "Error in TrajectoryStore::pushBack: All lines need the same number of attributes.");
+    }
+    positionsData.insert(positionsData.end(), trajectory.positions.begin(), trajectory.positions.end());
+    for (size_t attrIdx = 0; attrIdx < attributesData.size(); attrIdx++) {
+        TrajectorySpan<const float> attributeValues = trajectory.attributes[attrIdx];
+        attributesData.at(attrIdx).insert(
+                attributesData.at(attrIdx).end(), attributeValues.begin(), attributeValues.end());
+    }
+    lineOffsets.push_back(lineOffsets.back() + uint64_t(trajectory.positions.size()));
+    updatePointers();
+}
+
+void TrajectoryStore::addAttribute(std::vector<float> attributeValues) {
+    makeOwned();
+    if (attributeValues.size() != getNumLinePoints()) {
+        sgl::Logfile::get()->throwError(
+                "Error in TrajectoryStore::addAttribute: The number of values does not match the number of points.");
+    }
+    attributesData.push_back(std::move(attributeValues));
+    updatePointers();
+}
+
+void TrajectoryStore::resizeAttributes(size_t numAttributes) {
+    makeOwned();
+    size_t numLinePoints = getNumLinePoints();
+    attributesData.resize(numAttributes);
+    for (std::vector<float>& attributeValues : attributesData) {
+        attributeValues.resize(numLinePoints, 0.0f);
+    }
+    updatePointers();
+}
+
+MutableTrajectoryView TrajectoryStore::getMutable(size_t lineIdx) {
+    makeOwned();
+    size_t offset = lineOffsets.at(lineIdx);
+    size_t numPoints = lineOffsets.at(lineIdx + 1) - offset;
+    // The data is owned after makeOwned, so casting away the constness of the pointer table is safe.
+    return MutableTrajectoryView{
+            TrajectorySpan<glm::vec3>(positionsData.data() + offset, numPoints),
+            TrajectoryAttributesView<float>(
+                    const_cast<float* const*>(attributePtrs.data()), attributePtrs.size(), offset, numPoints)};
+}
+
+void TrajectoryStore::setPositions(std::vector<glm::vec3> positions) {
+    if (positions.size() != getNumLinePoints()) {
+        sgl::Logfile::get()->throwError(
+                "Error in TrajectoryStore::setPositions: The number of positions does not match the number of points.");
+    }
+    positionsData = std::move(positions);
+    if (mappedFile) {
+        ownsPositions = true;
+    }
+    updatePointers();
+}
+
+TrajectorySpan<glm::vec3> TrajectoryStore::getMutablePositions() {
+    if (getArePositionsMapped()) {
+        setPositions(std::vector<glm::vec3>(positionsPtr, positionsPtr + getNumLinePoints()));
+    }
+    return TrajectorySpan<glm::vec3>(positionsData.data(), positionsData.size());
+}
+
+TrajectorySpan<float> TrajectoryStore::getMutableAttributeValues(size_t attrIdx) {
+    makeOwned();
+    std::vector<float>& attributeValues = attributesData.at(attrIdx);
+    return TrajectorySpan<float>(attributeValues.data(), attributeValues.size());
+}
+
+size_t TrajectoryStore::getSizeInBytes() const {
+    return lineOffsets.size() * sizeof(uint64_t)
+            + getNumLinePoints() * (sizeof(glm::vec3) + sizeof(float) * getNumAttributes());
+}
+
+
+sgl::AABB3 computeTrajectoriesAABB3(const TrajectoryStore& trajectories) {
+    TrajectorySpan<const glm::vec3> positions = trajectories.getPositions();
+#ifdef USE_TBB
+
+    return tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, positions.size()), sgl::AABB3(),
+            [&positions](tbb::blocked_range<size_t> const& r, sgl::AABB3 init) {
+                for (auto pointIdx = r.begin(); pointIdx != r.end(); pointIdx++) {
+                    const glm::vec3& pt = positions[pointIdx];
+                    init.min.x = std::min(init.min.x, pt.x);
+                    init.min.y = std::min(init.min.y, pt.y);
+                    init.min.z = std::min(init.min.z, pt.z);
+                    init.max.x = std::max(init.max.x, pt.x);
+                    init.max.y = std::max(init.max.y, pt.y);
+                    init.max.z = std::max(init.max.z, pt.z);
+                }
+                return init;
+            },
+            [&](sgl::AABB3 lhs, sgl::AABB3 rhs) -> sgl::AABB3 {
+                lhs.combine(rhs);
+                return lhs;
+            });
+
+#else
+
+    float minX, minY, minZ, maxX, maxY, maxZ;
+    minX = minY = minZ = std::numeric_limits<float>::max();
+    maxX = maxY = maxZ = std::numeric_limits<float>::lowest();
+#if _OPENMP >= 201107
+    #pragma omp parallel for shared(positions) default(none) reduction(min: minX) reduction(min: minY) \
+    reduction(min: minZ) reduction(max: maxX) reduction(max: maxY) reduction(max: maxZ)
+#endif
+    for (size_t pointIdx = 0; pointIdx < positions.size(); pointIdx++) {
+        const glm::vec3& pt = positions[pointIdx];
+        minX = std::min(minX, pt.x);
+        minY = std::min(minY, pt.y);
+        minZ = std::min(minZ, pt.z);
+        maxX = std::max(maxX, pt.x);
+        maxY = std::max(maxY, pt.y);
+        maxZ = std::max(maxZ, pt.z);
+    }
+    sgl::AABB3 aabb;
+    aabb.min = glm::vec3(minX, minY, minZ);
+    aabb.max = glm::vec3(maxX, maxY, maxZ);
+    return aabb;
+
+#endif
+}
+
+void normalizeTrajectoriesVertexPositions(
+        TrajectoryStore& trajectories, const sgl::AABB3& aabb, const glm::mat4* vertexTransformationMatrixPtr) {
+    glm::vec3 translation = -aabb.getCenter();
+    glm::vec3 scale3D = 0.5f / aabb.getDimensions();
+    float scale = std::min(scale3D.x, std::min(scale3D.y, scale3D.z));
+    glm::mat4 transformationMatrix =
+            vertexTransformationMatrixPtr != nullptr ? *vertexTransformationMatrixPtr : glm::mat4(1.0f);
+    bool useTransformationMatrix = vertexTransformationMatrixPtr != nullptr;
+
+    // Positions referencing a mapped file are transformed while being copied out of the mapping; the attribute planes
+    // stay mapped.
+    TrajectorySpan<const glm::vec3> positionsIn = trajectories.getPositions();
+    std::vector<glm::vec3> positionsMapped;
+    TrajectorySpan<glm::vec3> positions;
+    bool arePositionsMapped = trajectories.getArePositionsMapped();
+    if (arePositionsMapped) {
+        positionsMapped.resize(positionsIn.size());
+        positions = TrajectorySpan<glm::vec3>(positionsMapped.data(), positionsMapped.size());
+    } else {
+        positions = trajectories.getMutablePositions();
+    }
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, positions.size()), [&](auto const& r) {
+        for (auto pointIdx = r.begin(); pointIdx != r.end(); pointIdx++) {
+#else
+#if _OPENMP >= 200805
+    #pragma omp parallel for default(none) \
+    shared(positionsIn, positions, translation, scale, transformationMatrix, useTransformationMatrix)
+#endif
+    for (size_t pointIdx = 0; pointIdx < positions.size(); pointIdx++) {
+#endif
+        glm::vec3 v = (positionsIn[pointIdx] + translation) * scale;
+        if (useTransformationMatrix) {
+            glm::vec4 transformedVec = transformationMatrix * glm::vec4(v.x, v.y, v.z, 1.0f);
+            v = glm::vec3(transformedVec.x, transformedVec.y, transformedVec.z);
+        }
+        positions[pointIdx] = v;
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    if (arePositionsMapped) {
+        trajectories.setPositions(std::move(positionsMapped));
+    }
+}
+
+void normalizeTrajectoriesVertexPositions(
+        TrajectoryStore& trajectories, const glm::mat4* vertexTransformationMatrixPtr) {
+    sgl::AABB3 aabb = computeTrajectoriesAABB3(trajectories);
+    normalizeTrajectoriesVertexPositions(trajectories, aabb, vertexTransformationMatrixPtr);
+}
+
+glm::vec2 computeTrajectoriesAttributeMinMax(const TrajectoryStore& trajectories, size_t attrIdx) {
+    TrajectorySpan<const float> attributeValues = trajectories.getAttributeValues(attrIdx);
+#ifdef USE_TBB
+    return tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, attributeValues.size()),
+            glm::vec2(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()),
+            [&attributeValues](tbb::blocked_range<size_t> const& r, glm::vec2 init) {
+                for (auto pointIdx = r.begin(); pointIdx != r.end(); pointIdx++) {
+                    float val = attributeValues[pointIdx];
+                    init.x = std::min(init.x, val);
+                    init.y = std::max(init.y, val);
+                }
+                return init;
+            },
+            [&](glm::vec2 lhs, glm::vec2 rhs) -> glm::vec2 {
+                return glm::vec2(std::min(lhs.x, rhs.x), std::max(lhs.y, rhs.y));
+            });
+#else
+    float minVal = std::numeric_limits<float>::max();
+    float maxVal = std::numeric_limits<float>::lowest();
+#if _OPENMP >= 201107
+    #pragma omp parallel for shared(attributeValues) default(none) reduction(min: minVal) reduction(max: maxVal)
+#endif
+    for (size_t pointIdx = 0; pointIdx < attributeValues.size(); pointIdx++) {
+        float val = attributeValues[pointIdx];
+        minVal = std::min(minVal, val);
+        maxVal = std::max(maxVal, val);
+    }
+    return glm::vec2(minVal, maxVal);
+#endif
+}
@@ -0,0 +1,268 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_TRAJECTORYSTORE_HPP
+#define LINEVIS_TRAJECTORYSTORE_HPP
+
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <iterator>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "TrajectoryFile.hpp"
+
+class MappedFile;
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+class MappedBinLinesFile;
+
+/**
+ * Non-owning view of a contiguous range of elements. Offers the read interface of std::vector, such that code written
+ * for the members of @see Trajectory also works for @see TrajectoryView.
+ */
+template<class T>
+class TrajectorySpan {
+public:
+    typedef T value_type;
+    TrajectorySpan() = default;
+    TrajectorySpan(T* data, size_t size) : ptr(data), count(size) {}
+
+    [[nodiscard]] inline size_t size() const { return count; }
+    [[nodiscard]] inline bool empty() const { return count == 0; }
+    [[nodiscard]] inline T* data() const { return ptr; }
+    [[nodiscard]] inline T* begin() const { return ptr; }
+    [[nodiscard]] inline T* end() const { return ptr + count; }
+    [[nodiscard]] inline T& front() const { return ptr[0]; }
+    [[nodiscard]] inline T& back() const { return ptr[count - 1]; }
+    inline T& operator[](size_t i) const { return ptr[i]; }
+    inline T& at(size_t i) const {
+        if (i >= count) {
+            throw std::out_of_range("Error in TrajectorySpan::at: Index out of range.");
+        }
+        return ptr[i];
+    }
+    [[nodiscard]] inline std::vector<std::remove_const_t<T>> toVector() const {
+        return std::vector<std::remove_const_t<T>>(ptr, ptr + count);
+    }
+
+private:
+    T* ptr = nullptr;
+    size_t count = 0;
+};
+
+/**
+ * The attributes of a single line in a @see TrajectoryStore. attributes.at(attrIdx) returns the values of one
+ * attribute at all line points, as trajectory.attributes.at(attrIdx) does for @see Trajectory.
+ */
+template<class T>
+class TrajectoryAttributesView {
+public:
+    TrajectoryAttributesView() = default;
+    TrajectoryAttributesView(T* const* planes, size_t numAttributes, size_t pointOffset, size_t numPoints)
+            : planes(planes), numAttributes(numAttributes), pointOffset(pointOffset), numPoints(numPoints) {}
+
+    [[nodiscard]] inline size_t size() const { return numAttributes; }
+    [[nodiscard]] inline bool empty() const { return numAttributes == 0; }
+    inline TrajectorySpan<T> operator[](size_t attrIdx) const {
+        return TrajectorySpan<T>(planes[attrIdx] + pointOffset, numPoints);
+    }
+    inline TrajectorySpan<T> at(size_t attrIdx) const {
+        if (attrIdx >= numAttributes) {
+            throw std::out_of_range("Error in TrajectoryAttributesView::at: Index out of range.");
+        }
+        return (*this)[attrIdx];
+    }
+    [[nodiscard]] inline TrajectorySpan<T> front() const { return (*this)[0]; }
+    [[nodiscard]] inline TrajectorySpan<T> back() const { return (*this)[numAttributes - 1]; }
+
+private:
+    T* const* planes = nullptr;
+    size_t numAttributes = 0;
+    size_t pointOffset = 0;
+    size_t numPoints = 0;
+};
+
+/**
+ * Cheap view of a single line in a @see TrajectoryStore. It has the same member names as @see Trajectory.
+ */
+template<class PositionType, class AttributeType>
+struct BasicTrajectoryView {
+    TrajectorySpan<PositionType> positions;
+    TrajectoryAttributesView<AttributeType> attributes;
+
+    [[nodiscard]] Trajectory toTrajectory() const {
+        Trajectory trajectory;
+        trajectory.positions.assign(positions.begin(), positions.end());
+        trajectory.attributes.resize(attributes.size());
+        for (size_t attrIdx = 0; attrIdx < attributes.size(); attrIdx++) {
+            TrajectorySpan<AttributeType> attributeValues = attributes[attrIdx];
+            trajectory.attributes.at(attrIdx).assign(attributeValues.begin(), attributeValues.end());
+        }
+        return trajectory;
+    }
+};
+typedef BasicTrajectoryView<const glm::vec3, const float> TrajectoryView;
+typedef BasicTrajectoryView<glm::vec3, float> MutableTrajectoryView;
+
+/**
+ * Flat structure-of-arrays (CSR-style) storage for a set of lines.
+ * - positions: One contiguous array with the points of all lines.
+ * - attributes: One contiguous array per attribute, parallel to the positions.
+ * - lineOffsets: lineOffsets[i] is the index of the first point of line i; lineOffsets[numLines] == numLinePoints.
+ * The data can either be owned by the store or reference the planes of a memory-mapped .binlines v3 file. In the latter
+ * case, the data is copied the first time mutable access is requested (copy-on-write). Mutable access to the positions
+ * only (@see getMutablePositions, @see setPositions) detaches the position plane and keeps the attributes mapped.
+ */
+class TrajectoryStore {
+public:
+    class Iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef TrajectoryView value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const TrajectoryView* pointer;
+        typedef TrajectoryView reference;
+        Iterator(const TrajectoryStore* store, size_t lineIdx) : store(store), lineIdx(lineIdx) {}
+        inline TrajectoryView operator*() const { return (*store)[lineIdx]; }
+        inline Iterator& operator++() { lineIdx++; return *this; }
+        inline Iterator operator++(int) { Iterator it = *this; lineIdx++; return it; }
+        inline bool operator==(const Iterator& rhs) const { return lineIdx == rhs.lineIdx; }
+        inline bool operator!=(const Iterator& rhs) const { return lineIdx != rhs.lineIdx; }
+    private:
+        const TrajectoryStore* store;
+        size_t lineIdx;
+    };
+
+    TrajectoryStore() : lineOffsets(1, 0) {}
+    explicit TrajectoryStore(const Trajectories& trajectories);
+    TrajectoryStore(const TrajectoryStore& other);
+    TrajectoryStore(TrajectoryStore&& other) noexcept;
+    TrajectoryStore& operator=(const TrajectoryStore& other);
+    TrajectoryStore& operator=(TrajectoryStore&& other) noexcept;
+
+    void clear();
+    /// Copies the passed array-of-structs line data into the flat storage.
+    void setTrajectories(const Trajectories& trajectories);
+    /// References the planes of the passed file without copying them. The file stays mapped while the store lives.
+    void setMappedBinLines(const MappedBinLinesFile& mappedBinLinesFile);
+    /**
+     * Takes ownership of the passed arrays without copying them. lineOffsets needs to start with zero and end with the
+     * number of positions, and every attribute needs one value per position.
+     */
+    void setLineData(
+            std::vector<uint64_t> lineOffsets, std::vector<glm::vec3> positions,
+            std::vector<std::vector<float>> attributes);
+    /// Converts the data back to the array-of-structs representation.
+    [[nodiscard]] Trajectories toTrajectories() const;
+
+    /// Appends a line. All lines must have the same number of attributes.
+    void pushBack(const Trajectory& trajectory);
+    /// The view may also reference a line of this store; the data is then copied before the storage grows.
+    void pushBack(const TrajectoryView& trajectory);
+    void reserve(size_t numLines, size_t numLinePoints);
+    /// Appends an attribute; the passed array needs to contain one value per line point.
+    void addAttribute(std::vector<float> attributeValues);
+    /// Adds or removes attributes. New attributes are zero-initialized.
+    void resizeAttributes(size_t numAttributes);
+    /// Replaces the positions of all line points; the passed array needs to contain one entry per line point.
+    void setPositions(std::vector<glm::vec3> positions);
+
+    // std::vector-like interface.
+    [[nodiscard]] inline size_t size() const { return lineOffsets.size() - 1; }
+    [[nodiscard]] inline bool empty() const { return lineOffsets.size() <= 1; }
+    [[nodiscard]] inline TrajectoryView operator[](size_t lineIdx) const {
+        size_t offset = lineOffsets[lineIdx];
+        size_t numPoints = lineOffsets[lineIdx + 1] - offset;
+        return TrajectoryView{
+                TrajectorySpan<const glm::vec3>(positionsPtr + offset, numPoints),
+                TrajectoryAttributesView<const float>(attributePtrs.data(), attributePtrs.size(), offset, numPoints)};
+    }
+    [[nodiscard]] inline TrajectoryView at(size_t lineIdx) const {
+        if (lineIdx >= size()) {
+            throw std::out_of_range("Error in TrajectoryStore::at: Index out of range.");
+        }
+        return (*this)[lineIdx];
+    }
+    [[nodiscard]] inline TrajectoryView front() const { return (*this)[0]; }
+    [[nodiscard]] inline TrajectoryView back() const { return (*this)[size() - 1]; }
+    [[nodiscard]] inline Iterator begin() const { return Iterator(this, 0); }
+    [[nodiscard]] inline Iterator end() const { return Iterator(this, size()); }
+
+    // Mutable access; detaches the store from a memory-mapped file if necessary.
+    [[nodiscard]] MutableTrajectoryView getMutable(size_t lineIdx);
+    [[nodiscard]] TrajectorySpan<glm::vec3> getMutablePositions();
+    [[nodiscard]] TrajectorySpan<float> getMutableAttributeValues(size_t attrIdx);
+
+    // Whole-data-set access.
+    [[nodiscard]] inline size_t getNumLines() const { return size(); }
+    [[nodiscard]] inline size_t getNumLinePoints() const { return size_t(lineOffsets.back()); }
+    [[nodiscard]] inline size_t getNumAttributes() const { return attributePtrs.size(); }
+    [[nodiscard]] inline size_t getLineNumPoints(size_t lineIdx) const {
+        return size_t(lineOffsets[lineIdx + 1] - lineOffsets[lineIdx]);
+    }
+    [[nodiscard]] inline const std::vector<uint64_t>& getLineOffsets() const { return lineOffsets; }
+    [[nodiscard]] inline TrajectorySpan<const glm::vec3> getPositions() const {
+        return TrajectorySpan<const glm::vec3>(positionsPtr, getNumLinePoints());
+    }
+    [[nodiscard]] inline TrajectorySpan<const float> getAttributeValues(size_t attrIdx) const {
+        return TrajectorySpan<const float>(attributePtrs.at(attrIdx), getNumLinePoints());
+    }
+    [[nodiscard]] inline bool getIsMapped() const { return mappedFile != nullptr; }
+    [[nodiscard]] inline bool getArePositionsMapped() const { return mappedFile != nullptr && !ownsPositions; }
+    /// Size of the line data in bytes.
+    [[nodiscard]] size_t getSizeInBytes() const;
+
+private:
+    void updatePointers();
+    void makeOwned();
+    [[nodiscard]] bool getIsDataOf(const TrajectoryView& trajectory) const;
+
+    std::vector<uint64_t> lineOffsets;
+    std::vector<glm::vec3> positionsData;
+    std::vector<std::vector<float>> attributesData;
+
+    // Point either into the vectors above or into the mapped file.
+    const glm::vec3* positionsPtr = nullptr;
+    std::vector<const float*> attributePtrs;
+    MappedFilePtr mappedFile;
+    // Whether positionsData holds the positions while the attribute planes still reference mappedFile.
+    bool ownsPositions = false;
+};
+
+sgl::AABB3 computeTrajectoriesAABB3(const TrajectoryStore& trajectories);
+void normalizeTrajectoriesVertexPositions(
+        TrajectoryStore& trajectories, const glm::mat4* vertexTransformationMatrixPtr = nullptr);
+void normalizeTrajectoriesVertexPositions(
+        TrajectoryStore& trajectories, const sgl::AABB3& aabb,
+        const glm::mat4* vertexTransformationMatrixPtr = nullptr);
+/// Returns the minimum and maximum value of an attribute over all lines.
+glm::vec2 computeTrajectoriesAttributeMinMax(const TrajectoryStore& trajectories, size_t attrIdx);
+
+#endif //LINEVIS_TRAJECTORYSTORE_HPP
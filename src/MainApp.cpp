@@ -1620,6 +1620,17 @@ void MainApp::openFileDialog() {
             ImGuiFileDialogFlags_None);
 }
 
+float MainApp::getRequestProgress() const {
+    float requestProgress = lineDataRequester.getProgress();
+    if (requestProgress < 0.0f) {
+        requestProgress = streamlineTracingRequester->getProgress();
+    }
+    if (requestProgress < 0.0f) {
+        requestProgress = scatteringLineTracingRequester->getProgress();
+    }
+    return requestProgress;
+}
+
 void MainApp::renderGuiMenuBar() {
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
@@ -1746,7 +1757,15 @@ void MainApp::renderGuiMenuBar() {
                 || stressLineTracingRequester->getIsProcessingRequest()
                 || scatteringLineTracingRequester->getIsProcessingRequest()
                 || isRendererComputationRunning) {
-            ImGui::SetCursorPosX(ImGui::GetWindowContentRegionWidth() - ImGui::GetTextLineHeight());
+            float spinnerPosX = ImGui::GetWindowContentRegionWidth() - ImGui::GetTextLineHeight();
+            float requestProgress = getRequestProgress();
+            if (requestProgress >= 0.0f) {
+                std::string progressText = std::to_string(int(requestProgress * 100.0f)) + "%";
+                ImGui::SetCursorPosX(
+                        spinnerPosX - ImGui::CalcTextSize(progressText.c_str()).x - ImGui::GetStyle().ItemSpacing.x);
+                ImGui::TextUnformatted(progressText.c_str());
+            }
+            ImGui::SetCursorPosX(spinnerPosX);
             ImGui::ProgressSpinner(
                     "##progress-spinner", -1.0f, -1.0f, 4.0f,
                     ImVec4(0.1f, 0.5f, 1.0f, 1.0f));
@@ -1777,6 +1796,11 @@ void MainApp::renderGuiPropertyEditorBegin() {
             ImGui::ProgressSpinner(
                     "##progress-spinner", -1.0f, -1.0f, 4.0f,
                     ImVec4(0.1f, 0.5f, 1.0f, 1.0f));
+            float requestProgress = getRequestProgress();
+            if (requestProgress >= 0.0f) {
+                ImGui::SameLine();
+                ImGui::Text("%d%%", int(requestProgress * 100.0f));
+            }
         }
 
         if (selectedDataSetIndex == 0) {
@@ -100,6 +100,8 @@ private:
 
     // Dock space mode.
     void renderGuiMenuBar();
+    /// @return The progress of the line data request currently processed in [0, 1], or a negative value if unknown.
+    float getRequestProgress() const;
     void renderGuiPropertyEditorBegin() override;
     void renderGuiPropertyEditorCustomNodes() override;
     void addNewDataView();
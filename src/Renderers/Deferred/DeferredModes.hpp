@@ -69,24 +69,30 @@ enum class DrawIndirectReductionMode {
  *   Standard: max_leaf_size = maxNumPrimitivesPerMeshlet, max_depth = maxHeight
  *   => UI: if (useMaxNumPrimitives): SliderInt. else: max_leaf_size, max_depth.
  * - LOCALLY_ORDERED_CLUSTERING_CPU, LINEAR_BVH_CPU: No control.
+ * - LINEAR_BVH_PARALLEL_CPU: max_leaf_size
+ *   Standard: max_leaf_size = maxNumPrimitivesPerMeshlet
+ *   => UI: if (useMaxNumPrimitives): SliderInt. else: max_leaf_size.
  * b) BvhBuildGeometryMode::MESHLETS:
  * - BINNED_SAH_CPU, SWEEP_SAH_CPU: max_leaf_size, max_depth
  *   Standard: max_leaf_size = 1, max_depth = 64 (library standard).
  *   => UI: max_leaf_size, max_depth.
  * - LOCALLY_ORDERED_CLUSTERING_CPU, LINEAR_BVH_CPU: No control.
+ * - LINEAR_BVH_PARALLEL_CPU: max_leaf_size
+ *   Standard: max_leaf_size = 1.
+ *   => UI: max_leaf_size.
  * 2. Task/Mesh Shaders: Like 1b).
  */
-const char* const bvhBuildAlgorithmNames[4] = {
+const char* const bvhBuildAlgorithmNames[5] = {
         "Binned SAH (CPU)",
         "Sweep SAH (CPU)",
         "Locally Ordered Clustering (CPU)",
         "Linear BVH (CPU)",
-        //"Linear BVH (Parallel, CPU)",
+        "Linear BVH (Parallel, CPU)",
         //"Linear BVH (Parallel, GPU)"
 };
 enum class BvhBuildAlgorithm {
-    BINNED_SAH_CPU, SWEEP_SAH_CPU, LOCALLY_ORDERED_CLUSTERING_CPU, LINEAR_BVH_CPU,
-    //LINEAR_BVH_PARALLEL_CPU, LINEAR_BVH_PARALLEL_GPU
+    BINNED_SAH_CPU, SWEEP_SAH_CPU, LOCALLY_ORDERED_CLUSTERING_CPU, LINEAR_BVH_CPU, LINEAR_BVH_PARALLEL_CPU,
+    //LINEAR_BVH_PARALLEL_GPU
 };
 
 const char* const bvhBuildGeometryModeNames[2] = {
@@ -1828,7 +1828,8 @@ void DeferredRenderer::renderGuiPropertyEditorNodes(sgl::PropertyEditor& propert
                 || bvhBuildGeometryMode == BvhBuildGeometryMode::MESHLETS
                 || (bvhBuildGeometryMode == BvhBuildGeometryMode::TRIANGLES && (
                         bvhBuildAlgorithm == BvhBuildAlgorithm::BINNED_SAH_CPU
-                        || bvhBuildAlgorithm == BvhBuildAlgorithm::SWEEP_SAH_CPU));
+                        || bvhBuildAlgorithm == BvhBuildAlgorithm::SWEEP_SAH_CPU
+                        || bvhBuildAlgorithm == BvhBuildAlgorithm::LINEAR_BVH_PARALLEL_CPU));
         if (deferredRenderingMode == DeferredRenderingMode::BVH_DRAW_INDIRECT && meshletSizeConfigurable) {
             if (propertyEditor.addSliderIntEdit(
                     "#Tri/Meshlet", (int*)&drawIndirectMaxNumPrimitivesPerMeshlet,
@@ -1905,9 +1906,11 @@ void DeferredRenderer::renderGuiPropertyEditorNodes(sgl::PropertyEditor& propert
         }
 
         if (propertyEditor.beginNode("Advanced Settings##bvh")) {
-            bool bvhOptionsAvailable =
+            bool bvhDepthOptionAvailable =
                     bvhBuildAlgorithm == BvhBuildAlgorithm::SWEEP_SAH_CPU
                     || bvhBuildAlgorithm == BvhBuildAlgorithm::BINNED_SAH_CPU;
+            bool bvhOptionsAvailable =
+                    bvhDepthOptionAvailable || bvhBuildAlgorithm == BvhBuildAlgorithm::LINEAR_BVH_PARALLEL_CPU;
             if (bvhOptionsAvailable) {
                 if (propertyEditor.addCheckbox("Standard BVH Parameters", &useStdBvhParameters)) {
                     updateUseStdBvhParameters();
@@ -1918,7 +1921,7 @@ void DeferredRenderer::renderGuiPropertyEditorNodes(sgl::PropertyEditor& propert
                             1, int(maxNumWorkgroups)) == ImGui::EditMode::INPUT_FINISHED) {
                         updateMaxLeafSizeBvh();
                     }
-                    if (propertyEditor.addSliderIntEdit(
+                    if (bvhDepthOptionAvailable && propertyEditor.addSliderIntEdit(
                             "Max. Tree Depth", (int*)&maxTreeDepthBvh,
                             1, int(maxNumWorkgroups)) == ImGui::EditMode::INPUT_FINISHED) {
                         updateMaxTreeDepthBvh();
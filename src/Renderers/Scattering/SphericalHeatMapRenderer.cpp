@@ -91,6 +91,15 @@ void SphericalHeatMapRenderer::recreateMapImage() {
         sgl::KdTree<sgl::Empty>* kd_tree_exit_dirs = new sgl::KdTree<sgl::Empty>;
         kd_tree_exit_dirs->build(lineDataScattering->getExitDirections());
         heat_map = create_spherical_heatmap_image(kd_tree_exit_dirs, 300);
+    } else if (sphericalMapType == SphericalMapType::MOLLWEIDE_RBF) {
+        // Same radial basis function heat map as above, but computed in parallel on a binned grid on the sphere.
+        // The histogram of the tracer also contains the paths that were not kept due to the path memory limit.
+        const SphericalHistogram* histogram = lineDataScattering->getExitDirectionHistogram();
+        if (histogram && histogram->num_directions > 0) {
+            heat_map = create_spherical_heatmap_image(*histogram, 300);
+        } else {
+            heat_map = create_spherical_heatmap_image(lineDataScattering->getExitDirections(), 300);
+        }
     } else if (sphericalMapType == SphericalMapType::MOLLWEIDE
             || sphericalMapType == SphericalMapType::MOLLWEIDE_SPHERE) {
         Mollweide_Grid<sgl::Empty>* grid = new Mollweide_Grid<sgl::Empty>;
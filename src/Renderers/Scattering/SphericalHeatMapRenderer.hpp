@@ -42,11 +42,11 @@ typedef std::shared_ptr<BlitRenderPass> BlitRenderPassPtr;
 class TexturedSphereRasterPass;
 
 enum class SphericalMapType {
-    MOLLWEIDE_KD_TREE, MOLLWEIDE, MOLLWEIDE_SPHERE
+    MOLLWEIDE_KD_TREE, MOLLWEIDE, MOLLWEIDE_SPHERE, MOLLWEIDE_RBF
 };
 
 const char* const SPHERICAL_MAP_TYPE_NAMES[] = {
-    "Mollweide (k-D Tree)", "Mollweide", "Mollweide (Sphere)"
+    "Mollweide (k-D Tree)", "Mollweide", "Mollweide (Sphere)", "Mollweide (RBF)"
 };
 
 class SphericalHeatMapRenderer : public LineRenderer {
@@ -0,0 +1,598 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2020, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Math/Math.hpp>
+
+#ifdef USE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+#include "Tubes.hpp"
+
+/**
+ * Output ranges of one line. In the first pass, the offsets store the number of elements written by the line. After
+ * the prefix sum, they store the offsets relative to the start of the elements appended by this call.
+ */
+struct TubeLineOutputRange {
+    int numValidLinePoints = 0;
+    size_t vertexOffset = 0;
+    size_t indexOffset = 0;
+    size_t linePointOffset = 0;
+};
+
+/**
+ * Mirrors the control flow of the sequential (capped) triangle tube functions line by line. Lines write only to the
+ * ranges reserved for them in countLine, which makes emitLine safe to call concurrently for different lines.
+ * In order to stay bit-identical to the sequential code, the zero-initialized cap slots the sequential code leaves
+ * behind for lines with less than two valid line points are reproduced.
+ */
+class TriangleTubeMeshBuilder {
+public:
+    TriangleTubeMeshBuilder(
+            const std::vector<std::vector<glm::vec3>>& lineCentersList,
+            const std::vector<std::vector<glm::vec3>>* lineRightVectorsList,
+            const TubeCrossSection& crossSection, bool hasCaps, bool tubeClosed,
+            float tubeNormalRadius, float tubeBinormalRadius,
+            std::vector<uint32_t>& triangleIndices,
+            std::vector<TubeTriangleVertexData>& vertexDataList,
+            std::vector<LinePointReference>& linePointReferenceList,
+            uint32_t linePointOffset,
+            std::vector<glm::vec3>& lineTangents,
+            std::vector<glm::vec3>& lineNormals)
+            : lineCentersList(lineCentersList), lineRightVectorsList(lineRightVectorsList),
+              crossSection(crossSection), tubeClosed(tubeClosed),
+              tubeNormalRadius(tubeNormalRadius), tubeBinormalRadius(tubeBinormalRadius),
+              triangleIndices(triangleIndices), vertexDataList(vertexDataList),
+              linePointReferenceList(linePointReferenceList), linePointOffset(linePointOffset),
+              lineTangents(lineTangents), lineNormals(lineNormals) {
+        numSubdivisions = int(crossSection.getNumVertices());
+        if (hasCaps && !tubeClosed) {
+            numLongitudeSubdivisions = numSubdivisions; // azimuth
+            numLatitudeSubdivisions = int(std::ceil(numSubdivisions / 2)); // zenith
+            numCapVertices = size_t(numLongitudeSubdivisions * (numLatitudeSubdivisions - 1) + 1);
+            numCapIndices = size_t(
+                    numLongitudeSubdivisions * (numLatitudeSubdivisions - 1) * 6 + numLongitudeSubdivisions * 3);
+        }
+    }
+
+    /// Generates the mesh of all lines and appends it to the output lists.
+    void build();
+
+    /// Pass 1: Counts the elements produced by each line and computes the offsets of the lines in the mesh.
+    void countLines();
+    [[nodiscard]] inline const std::vector<TubeLineOutputRange>& getLineOutputRanges() const {
+        return lineOutputRanges;
+    }
+    [[nodiscard]] inline size_t getNumVertices() const { return numVertices; }
+    [[nodiscard]] inline size_t getNumIndices() const { return numIndices; }
+    [[nodiscard]] inline size_t getNumLinePoints() const { return numLinePoints; }
+
+    /**
+     * Pass 2 for a range of lines: Overwrites the output lists with the mesh of the lines [lineBegin, lineEnd).
+     * Requires countLines to be called first. The vertex indices are offset by vertexIndexBase, i.e., they refer to
+     * the mesh of all lines starting at vertexIndexBase.
+     */
+    void buildChunk(size_t lineBegin, size_t lineEnd, size_t vertexIndexBase);
+
+private:
+    /// Returns false if the line point is skipped, as the two neighboring vertices are almost identical.
+    inline bool computeTangent(const std::vector<glm::vec3>& lineCenters, size_t i, glm::vec3& tangent) const {
+        size_t n = lineCenters.size();
+        if (!tubeClosed && i == 0) {
+            tangent = lineCenters[i + 1] - lineCenters[i];
+        } else if (!tubeClosed && i == n - 1) {
+            tangent = lineCenters[i] - lineCenters[i - 1];
+        } else {
+            tangent = (lineCenters[(i + 1) % n] - lineCenters[(i + n - 1) % n]);
+        }
+        float lineSegmentLength = glm::length(tangent);
+        return !(lineSegmentLength < 0.0001f);
+    }
+    /// Number of indices written by a line with at least two valid line points.
+    [[nodiscard]] inline size_t getLineNumIndices(int numValidLinePoints) const {
+        size_t lineNumIndices = size_t(numValidLinePoints - 1) * size_t(numSubdivisions) * 6;
+        lineNumIndices += tubeClosed ? size_t(numSubdivisions) * 6 : 2 * numCapIndices;
+        return lineNumIndices;
+    }
+    void countLine(size_t lineId);
+    void emitLine(size_t lineId);
+    void emitLines(size_t lineBegin, size_t lineEnd);
+
+    const std::vector<std::vector<glm::vec3>>& lineCentersList;
+    const std::vector<std::vector<glm::vec3>>* lineRightVectorsList; ///< nullptr for circular tubes.
+    const TubeCrossSection& crossSection;
+    bool tubeClosed;
+    float tubeNormalRadius, tubeBinormalRadius;
+    int numSubdivisions = 0;
+    int numLongitudeSubdivisions = 0;
+    int numLatitudeSubdivisions = 0;
+    size_t numCapVertices = 0;
+    size_t numCapIndices = 0;
+
+    std::vector<TubeLineOutputRange> lineOutputRanges;
+    size_t numVertices = 0, numIndices = 0, numLinePoints = 0;
+    size_t vertexBase = 0, indexBase = 0, linePointReferenceBase = 0, lineTangentBase = 0, lineNormalBase = 0;
+    // Offsets of the first line of the current chunk, which are subtracted from the write positions in chunk mode.
+    size_t chunkVertexOffset = 0, chunkIndexOffset = 0, chunkLinePointOffset = 0;
+    // Offset added to the written vertex indices in chunk mode (zero when all lines are written at once).
+    size_t chunkVertexIndexShift = 0;
+    std::vector<uint32_t>& triangleIndices;
+    std::vector<TubeTriangleVertexData>& vertexDataList;
+    std::vector<LinePointReference>& linePointReferenceList;
+    uint32_t linePointOffset;
+    std::vector<glm::vec3>& lineTangents;
+    std::vector<glm::vec3>& lineNormals;
+};
+
+void TriangleTubeMeshBuilder::countLine(size_t lineId) {
+    const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
+    TubeLineOutputRange& range = lineOutputRanges.at(lineId);
+    size_t n = lineCenters.size();
+
+    // Assert that we have a valid input data range
+    if (n < (tubeClosed ? size_t(3) : size_t(2))) {
+        return;
+    }
+
+    int numValidLinePoints = 0;
+    glm::vec3 tangent;
+    for (size_t i = 0; i < n; i++) {
+        if (computeTangent(lineCenters, i, tangent)) {
+            numValidLinePoints++;
+        }
+    }
+    range.numValidLinePoints = numValidLinePoints;
+
+    if (numValidLinePoints == 0) {
+        // The sequential code keeps the start cap slots it has reserved up front.
+        range.vertexOffset = numCapVertices;
+        range.indexOffset = numCapIndices;
+    } else if (numValidLinePoints == 1) {
+        // Only one vertex left -> output nothing (but the reserved start cap indices remain).
+        range.indexOffset = numCapIndices;
+    } else {
+        range.vertexOffset = size_t(numValidLinePoints) * size_t(numSubdivisions) + 2 * numCapVertices;
+        range.indexOffset = getLineNumIndices(numValidLinePoints);
+        range.linePointOffset = size_t(numValidLinePoints);
+    }
+}
+
+void TriangleTubeMeshBuilder::emitLine(size_t lineId) {
+    const std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
+    const TubeLineOutputRange& range = lineOutputRanges.at(lineId);
+    size_t n = lineCenters.size();
+    int numValidLinePoints = range.numValidLinePoints;
+    if (numValidLinePoints <= 1) {
+        // Nothing to emit; reserved cap slots stay zero-initialized.
+        return;
+    }
+
+    auto indexOffsetCapStart = uint32_t(vertexBase + range.vertexOffset - chunkVertexOffset);
+    auto triOffsetCapStart = uint32_t(indexBase + range.indexOffset - chunkIndexOffset);
+    auto indexOffset = uint32_t(indexOffsetCapStart + numCapVertices);
+    size_t lineIndexOffset = lineTangentBase + range.linePointOffset - chunkLinePointOffset;
+    size_t lineNormalOffset = lineNormalBase + range.linePointOffset - chunkLinePointOffset;
+    size_t linePointReferenceOffset = linePointReferenceBase + range.linePointOffset - chunkLinePointOffset;
+    auto vertexLinePointIndexBase = uint32_t(linePointOffset + chunkLinePointOffset);
+
+    // Gather the valid line points and their frames. The rings of all points are then written in one batch.
+    thread_local std::vector<glm::vec3> validLineCenters;
+    validLineCenters.resize(size_t(numValidLinePoints));
+    int firstIdx = int(n) - 2;
+    int lastIdx = 1;
+    int linePointIdx = 0;
+    for (size_t i = 0; i < n; i++) {
+        glm::vec3 tangent;
+        if (!computeTangent(lineCenters, i, tangent)) {
+            continue;
+        }
+        firstIdx = std::min(int(i), firstIdx);
+        lastIdx = std::max(int(i), lastIdx);
+        tangent = glm::normalize(tangent);
+
+        validLineCenters[linePointIdx] = lineCenters.at(i);
+        lineTangents[lineIndexOffset + linePointIdx] = tangent;
+        if (lineRightVectorsList) {
+            lineNormals[lineNormalOffset + linePointIdx] = glm::cross(lineRightVectorsList->at(lineId).at(i), tangent);
+        }
+        linePointReferenceList[linePointReferenceOffset + linePointIdx] = LinePointReference(
+                uint32_t(lineId), uint32_t(i));
+        linePointIdx++;
+    }
+
+    TubeTriangleVertexData* vertexData = vertexDataList.data() + indexOffset;
+    auto vertexLinePointIndex = vertexLinePointIndexBase + uint32_t(linePointReferenceOffset);
+    if (lineRightVectorsList) {
+        insertOrientedEllipsePointsBatch(
+                crossSection, size_t(numValidLinePoints), validLineCenters.data(),
+                lineTangents.data() + lineIndexOffset, lineNormals.data() + lineNormalOffset,
+                vertexLinePointIndex, vertexData);
+    } else {
+        glm::vec3 lastLineNormal(1.0f, 0.0f, 0.0f);
+        insertOrientedCirclePointsBatch(
+                crossSection, size_t(numValidLinePoints), validLineCenters.data(),
+                lineTangents.data() + lineIndexOffset, lastLineNormal, vertexLinePointIndex,
+                lineNormals.data() + lineNormalOffset, vertexData);
+    }
+
+    uint32_t* indices = triangleIndices.data() + triOffsetCapStart + numCapIndices;
+    for (int i = 0; i < numValidLinePoints-1; i++) {
+        for (int j = 0; j < numSubdivisions; j++) {
+            // Build two CCW triangles (one quad) for each side
+            // Triangle 1
+            *(indices++) = indexOffset + i*numSubdivisions+j;
+            *(indices++) = indexOffset + i*numSubdivisions+(j+1)%numSubdivisions;
+            *(indices++) = indexOffset + ((i+1)%numValidLinePoints)*numSubdivisions+(j+1)%numSubdivisions;
+
+            // Triangle 2
+            *(indices++) = indexOffset + i*numSubdivisions+j;
+            *(indices++) = indexOffset + ((i+1)%numValidLinePoints)*numSubdivisions+(j+1)%numSubdivisions;
+            *(indices++) = indexOffset + ((i+1)%numValidLinePoints)*numSubdivisions+j;
+        }
+    }
+
+    if (tubeClosed) {
+        // Connect the begin and the end of the tube with minimal edge lengths (see createCappedTriangleTubesRenderDataCPU).
+        glm::vec3 normalA = lineNormals[lineNormalOffset + numValidLinePoints - 1];
+        glm::vec3 normalB = lineNormals[lineNormalOffset];
+        float normalAngleDifference = std::atan2(
+                glm::length(glm::cross(normalA, normalB)), glm::dot(normalA, normalB));
+        normalAngleDifference = std::fmod(normalAngleDifference + sgl::TWO_PI, sgl::TWO_PI);
+        int jOffset = int(std::round(normalAngleDifference / (sgl::TWO_PI) * float(numSubdivisions)));
+        for (int j = 0; j < numSubdivisions; j++) {
+            // Build two CCW triangles (one quad) for each side
+            // Triangle 1
+            *(indices++) = indexOffset + (numValidLinePoints-1)*numSubdivisions+(j)%numSubdivisions;
+            *(indices++) = indexOffset + (numValidLinePoints-1)*numSubdivisions+(j+1)%numSubdivisions;
+            *(indices++) = indexOffset + 0*numSubdivisions+(j+1+jOffset)%numSubdivisions;
+
+            // Triangle 2
+            *(indices++) = indexOffset + (numValidLinePoints-1)*numSubdivisions+(j)%numSubdivisions;
+            *(indices++) = indexOffset + 0*numSubdivisions+(j+1+jOffset)%numSubdivisions;
+            *(indices++) = indexOffset + 0*numSubdivisions+(j+jOffset)%numSubdivisions;
+        }
+    } else if (numCapVertices > 0) {
+        auto indexOffsetCapEnd = uint32_t(indexOffset + numValidLinePoints * numSubdivisions);
+        auto triOffsetCapEnd = uint32_t(indices - triangleIndices.data());
+
+        // Hemisphere at the start
+        glm::vec3 center0 = lineCenters[firstIdx];
+        glm::vec3 tangent0 = lineCenters[firstIdx] - lineCenters[firstIdx + 1];
+        tangent0 = glm::normalize(tangent0);
+        glm::vec3 normal0 = lineNormals[lineNormalOffset];
+
+        // Hemisphere at the end
+        glm::vec3 center1 = lineCenters[lastIdx];
+        glm::vec3 tangent1 = lineCenters[lastIdx] - lineCenters[lastIdx - 1];
+        tangent1 = glm::normalize(tangent1);
+        glm::vec3 normal1 = lineNormals[lineNormalOffset + numValidLinePoints - 1];
+
+        auto vertexLinePointIndexStart = vertexLinePointIndexBase + uint32_t(lineIndexOffset);
+        auto vertexLinePointIndexStop = vertexLinePointIndexBase + uint32_t(lineIndexOffset + numValidLinePoints - 1);
+        if (lineRightVectorsList) {
+            addEllipticHemisphereToMeshStart(
+                    center0, tangent0, normal0, indexOffset, indexOffsetCapStart, triOffsetCapStart,
+                    vertexLinePointIndexStart,
+                    tubeNormalRadius, tubeBinormalRadius, numLongitudeSubdivisions, numLatitudeSubdivisions,
+                    triangleIndices, vertexDataList);
+            addEllipticHemisphereToMeshStop(
+                    center1, tangent1, normal1, indexOffset, indexOffsetCapEnd, triOffsetCapEnd,
+                    vertexLinePointIndexStop,
+                    tubeNormalRadius, tubeBinormalRadius, numLongitudeSubdivisions, numLatitudeSubdivisions,
+                    triangleIndices, vertexDataList);
+        } else {
+            addHemisphereToMeshStart(
+                    center0, tangent0, normal0, indexOffset, indexOffsetCapStart, triOffsetCapStart,
+                    vertexLinePointIndexStart,
+                    tubeNormalRadius, numLongitudeSubdivisions, numLatitudeSubdivisions,
+                    triangleIndices, vertexDataList);
+            addHemisphereToMeshStop(
+                    center1, tangent1, normal1, indexOffset, indexOffsetCapEnd, triOffsetCapEnd,
+                    vertexLinePointIndexStop,
+                    tubeNormalRadius, numLongitudeSubdivisions, numLatitudeSubdivisions,
+                    triangleIndices, vertexDataList);
+        }
+    }
+
+    if (chunkVertexIndexShift != 0) {
+        // The vertex indices were written relative to the start of the chunk.
+        uint32_t* lineIndices = triangleIndices.data() + triOffsetCapStart;
+        size_t lineNumIndices = getLineNumIndices(numValidLinePoints);
+        for (size_t i = 0; i < lineNumIndices; i++) {
+            lineIndices[i] += uint32_t(chunkVertexIndexShift);
+        }
+    }
+}
+
+void TriangleTubeMeshBuilder::countLines() {
+    auto numLines = int(lineCentersList.size());
+    lineOutputRanges.clear();
+    lineOutputRanges.resize(lineCentersList.size());
+
+    // Pass 1: Count the number of elements each line will produce.
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(0, numLines), [&](auto const& r) {
+        for (auto lineId = r.begin(); lineId != r.end(); lineId++) {
+#else
+#pragma omp parallel for default(none) shared(numLines) schedule(dynamic, 64)
+    for (int lineId = 0; lineId < numLines; lineId++) {
+#endif
+        countLine(size_t(lineId));
+    }
+#ifdef USE_TBB
+    });
+#endif
+
+    // Exclusive prefix sum over the per-line counts.
+    numVertices = 0;
+    numIndices = 0;
+    numLinePoints = 0;
+    for (TubeLineOutputRange& range : lineOutputRanges) {
+        size_t lineNumVertices = range.vertexOffset;
+        size_t lineNumIndices = range.indexOffset;
+        size_t lineNumLinePoints = range.linePointOffset;
+        range.vertexOffset = numVertices;
+        range.indexOffset = numIndices;
+        range.linePointOffset = numLinePoints;
+        numVertices += lineNumVertices;
+        numIndices += lineNumIndices;
+        numLinePoints += lineNumLinePoints;
+    }
+}
+
+void TriangleTubeMeshBuilder::emitLines(size_t lineBegin, size_t lineEnd) {
+    auto lineIdxBegin = int(lineBegin);
+    auto lineIdxEnd = int(lineEnd);
+#ifdef USE_TBB
+    tbb::parallel_for(tbb::blocked_range<int>(lineIdxBegin, lineIdxEnd), [&](auto const& r) {
+        for (auto lineId = r.begin(); lineId != r.end(); lineId++) {
+#else
+#pragma omp parallel for default(none) shared(lineIdxBegin, lineIdxEnd) schedule(dynamic, 64)
+    for (int lineId = lineIdxBegin; lineId < lineIdxEnd; lineId++) {
+#endif
+        emitLine(size_t(lineId));
+    }
+#ifdef USE_TBB
+    });
+#endif
+}
+
+void TriangleTubeMeshBuilder::build() {
+    countLines();
+
+    // The lists may already contain data from previous calls; the new elements are appended.
+    vertexBase = vertexDataList.size();
+    indexBase = triangleIndices.size();
+    linePointReferenceBase = linePointReferenceList.size();
+    lineTangentBase = lineTangents.size();
+    lineNormalBase = lineNormals.size();
+    chunkVertexOffset = 0;
+    chunkIndexOffset = 0;
+    chunkLinePointOffset = 0;
+    chunkVertexIndexShift = 0;
+    vertexDataList.resize(vertexBase + numVertices);
+    triangleIndices.resize(indexBase + numIndices);
+    linePointReferenceList.resize(linePointReferenceBase + numLinePoints);
+    lineTangents.resize(lineTangentBase + numLinePoints);
+    lineNormals.resize(lineNormalBase + numLinePoints);
+
+    // Pass 2: Emit the geometry of all lines into their preallocated ranges.
+    emitLines(0, lineCentersList.size());
+}
+
+void TriangleTubeMeshBuilder::buildChunk(size_t lineBegin, size_t lineEnd, size_t vertexIndexBase) {
+    vertexBase = 0;
+    indexBase = 0;
+    linePointReferenceBase = 0;
+    lineTangentBase = 0;
+    lineNormalBase = 0;
+    size_t chunkVertexEnd = numVertices, chunkIndexEnd = numIndices, chunkLinePointEnd = numLinePoints;
+    if (lineBegin < lineOutputRanges.size()) {
+        const TubeLineOutputRange& rangeBegin = lineOutputRanges.at(lineBegin);
+        chunkVertexOffset = rangeBegin.vertexOffset;
+        chunkIndexOffset = rangeBegin.indexOffset;
+        chunkLinePointOffset = rangeBegin.linePointOffset;
+    } else {
+        chunkVertexOffset = numVertices;
+        chunkIndexOffset = numIndices;
+        chunkLinePointOffset = numLinePoints;
+    }
+    if (lineEnd < lineOutputRanges.size()) {
+        const TubeLineOutputRange& rangeEnd = lineOutputRanges.at(lineEnd);
+        chunkVertexEnd = rangeEnd.vertexOffset;
+        chunkIndexEnd = rangeEnd.indexOffset;
+        chunkLinePointEnd = rangeEnd.linePointOffset;
+    }
+    chunkVertexIndexShift = vertexIndexBase + chunkVertexOffset;
+
+    // Clear before resizing, as the reserved cap slots of degenerate lines need to be zero-initialized.
+    vertexDataList.clear();
+    triangleIndices.clear();
+    linePointReferenceList.clear();
+    lineTangents.clear();
+    lineNormals.clear();
+    vertexDataList.resize(chunkVertexEnd - chunkVertexOffset);
+    triangleIndices.resize(chunkIndexEnd - chunkIndexOffset);
+    linePointReferenceList.resize(chunkLinePointEnd - chunkLinePointOffset);
+    lineTangents.resize(chunkLinePointEnd - chunkLinePointOffset);
+    lineNormals.resize(chunkLinePointEnd - chunkLinePointOffset);
+
+    emitLines(lineBegin, lineEnd);
+}
+
+void createTriangleTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        float tubeRadius,
+        int numCircleSubdivisions,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals) {
+    TubeCrossSection crossSection;
+    crossSection.initCircle(std::max(numCircleSubdivisions, 4), tubeRadius);
+    TriangleTubeMeshBuilder builder(
+            lineCentersList, nullptr, crossSection, false, false, tubeRadius, tubeRadius,
+            triangleIndices, vertexDataList, linePointReferenceList, linePointOffset, lineTangents, lineNormals);
+    builder.build();
+}
+
+void createTriangleEllipticTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>& lineRightVectorsList,
+        float tubeNormalRadius,
+        float tubeBinormalRadius,
+        int numEllipseSubdivisions,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals) {
+    TubeCrossSection crossSection;
+    crossSection.initEllipse(std::max(numEllipseSubdivisions, 4), tubeNormalRadius, tubeBinormalRadius);
+    TriangleTubeMeshBuilder builder(
+            lineCentersList, &lineRightVectorsList, crossSection, false, false,
+            tubeNormalRadius, tubeBinormalRadius,
+            triangleIndices, vertexDataList, linePointReferenceList, linePointOffset, lineTangents, lineNormals);
+    builder.build();
+}
+
+void createCappedTriangleTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        float tubeRadius, int numCircleSubdivisions, bool tubeClosed,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals) {
+    TubeCrossSection crossSection;
+    crossSection.initCircle(std::max(numCircleSubdivisions, 4), tubeRadius);
+    TriangleTubeMeshBuilder builder(
+            lineCentersList, nullptr, crossSection, true, tubeClosed, tubeRadius, tubeRadius,
+            triangleIndices, vertexDataList, linePointReferenceList, linePointOffset, lineTangents, lineNormals);
+    builder.build();
+}
+
+void createCappedTriangleEllipticTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>& lineRightVectorsList,
+        float tubeNormalRadius, float tubeBinormalRadius, int numEllipseSubdivisions, bool tubeClosed,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals) {
+    TubeCrossSection crossSection;
+    crossSection.initEllipse(std::max(numEllipseSubdivisions, 4), tubeNormalRadius, tubeBinormalRadius);
+    TriangleTubeMeshBuilder builder(
+            lineCentersList, &lineRightVectorsList, crossSection, true, tubeClosed,
+            tubeNormalRadius, tubeBinormalRadius,
+            triangleIndices, vertexDataList, linePointReferenceList, linePointOffset, lineTangents, lineNormals);
+    builder.build();
+}
+
+
+TriangleTubeMeshChunkGenerator::TriangleTubeMeshChunkGenerator(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>* lineRightVectorsList,
+        float tubeNormalRadius, float tubeBinormalRadius, int numSubdivisions, bool hasCaps, bool tubeClosed,
+        size_t vertexIndexBase, uint32_t linePointOffset, size_t maxChunkSizeInBytes)
+        : vertexIndexBase(vertexIndexBase) {
+    if (lineRightVectorsList) {
+        crossSection.initEllipse(std::max(numSubdivisions, 4), tubeNormalRadius, tubeBinormalRadius);
+    } else {
+        crossSection.initCircle(std::max(numSubdivisions, 4), tubeNormalRadius);
+    }
+    builder = std::make_unique<TriangleTubeMeshBuilder>(
+            lineCentersList, lineRightVectorsList, crossSection, hasCaps, tubeClosed,
+            tubeNormalRadius, tubeBinormalRadius,
+            chunk.triangleIndices, chunk.vertexDataList, chunk.linePointReferenceList, linePointOffset,
+            chunk.lineTangents, chunk.lineNormals);
+    builder->countLines();
+
+    // Greedily assign consecutive lines to chunks based on the sizes computed by the count pass.
+    const size_t linePointSizeInBytes = sizeof(LinePointReference) + 2 * sizeof(glm::vec3);
+    const std::vector<TubeLineOutputRange>& lineOutputRanges = builder->getLineOutputRanges();
+    const size_t numLines = lineOutputRanges.size();
+    auto getLineOffsetSizeInBytes = [&](size_t lineIdx) {
+        if (lineIdx == numLines) {
+            return builder->getNumVertices() * sizeof(TubeTriangleVertexData)
+                    + builder->getNumIndices() * sizeof(uint32_t)
+                    + builder->getNumLinePoints() * linePointSizeInBytes;
+        }
+        const TubeLineOutputRange& range = lineOutputRanges.at(lineIdx);
+        return range.vertexOffset * sizeof(TubeTriangleVertexData)
+                + range.indexOffset * sizeof(uint32_t)
+                + range.linePointOffset * linePointSizeInBytes;
+    };
+    chunkLineOffsets.push_back(0);
+    size_t chunkStartSizeInBytes = 0;
+    for (size_t lineIdx = 1; lineIdx <= numLines; lineIdx++) {
+        size_t lineEndSizeInBytes = getLineOffsetSizeInBytes(lineIdx);
+        if (lineEndSizeInBytes - chunkStartSizeInBytes > maxChunkSizeInBytes
+                && lineIdx - 1 > chunkLineOffsets.back()) {
+            // Close the chunk before line lineIdx - 1, as it does not fit into the chunk anymore.
+            chunkLineOffsets.push_back(lineIdx - 1);
+            chunkStartSizeInBytes = getLineOffsetSizeInBytes(lineIdx - 1);
+        }
+    }
+    if (numLines > 0) {
+        chunkLineOffsets.push_back(numLines);
+    }
+}
+
+TriangleTubeMeshChunkGenerator::~TriangleTubeMeshChunkGenerator() = default;
+
+size_t TriangleTubeMeshChunkGenerator::getNumVertices() const {
+    return builder->getNumVertices();
+}
+
+size_t TriangleTubeMeshChunkGenerator::getNumIndices() const {
+    return builder->getNumIndices();
+}
+
+size_t TriangleTubeMeshChunkGenerator::getNumLinePoints() const {
+    return builder->getNumLinePoints();
+}
+
+const TubeTriangleMeshChunk& TriangleTubeMeshChunkGenerator::generateChunk(size_t chunkIdx) {
+    chunk.lineBegin = chunkLineOffsets.at(chunkIdx);
+    chunk.lineEnd = chunkLineOffsets.at(chunkIdx + 1);
+    builder->buildChunk(chunk.lineBegin, chunk.lineEnd, vertexIndexBase);
+    const std::vector<TubeLineOutputRange>& lineOutputRanges = builder->getLineOutputRanges();
+    const TubeLineOutputRange& rangeBegin = lineOutputRanges.at(chunk.lineBegin);
+    chunk.vertexOffset = rangeBegin.vertexOffset;
+    chunk.indexOffset = rangeBegin.indexOffset;
+    chunk.linePointOffset = rangeBegin.linePointOffset;
+    return chunk;
+}
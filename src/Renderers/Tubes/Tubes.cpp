@@ -27,22 +27,49 @@
  */
 
 #include <Math/Math.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TUBES_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX_TARGET __attribute__((target("avx")))
+#else
+#define AVX_TARGET
+#endif
+#endif
+
 #include "Tubes.hpp"
 
+#ifdef TUBES_X86
+static bool getIsAvxSupported() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool isAvxSupported = __builtin_cpu_supports("avx");
+    return isAvxSupported;
+#elif defined(__AVX__)
+    return true;
+#else
+    return false;
+#endif
+}
+#endif
+
 float globalTubeRadius = 0.0f;
 std::vector<glm::vec3> globalCircleVertexPositions;
+std::vector<glm::vec3> globalCircleVertexNormals;
 
-void initGlobalCircleVertexPositions(int numCircleSubdivisions, float tubeRadius) {
-    globalCircleVertexPositions.clear();
-    globalTubeRadius = tubeRadius;
-
+static void computeCircleVertexPositions(
+        int numCircleSubdivisions, float tubeRadius,
+        std::vector<glm::vec3>& circleVertexPositions, std::vector<glm::vec3>& circleVertexNormals) {
+    circleVertexPositions.clear();
+    circleVertexNormals.clear();
     const float theta = sgl::TWO_PI / numCircleSubdivisions;
     const float tangentialFactor = std::tan(theta); // opposite / adjacent
     const float radialFactor = std::cos(theta); // adjacent / hypotenuse
     glm::vec3 position(tubeRadius, 0, 0);
 
     for (int i = 0; i < numCircleSubdivisions; i++) {
-        globalCircleVertexPositions.push_back(position);
+        circleVertexPositions.push_back(position);
+        circleVertexNormals.push_back(glm::normalize(position));
 
         // Add the tangent vector and correct the position using the radial factor.
         glm::vec3 tangent(-position.y, position.x, 0);
@@ -51,9 +78,16 @@ void initGlobalCircleVertexPositions(int numCircleSubdivisions, float tubeRadius
     }
 }
 
-void insertOrientedCirclePoints(
-        const glm::vec3& center, const glm::vec3& tangent, glm::vec3& lastNormal, uint32_t vertexLinePointIndex,
-        std::vector<TubeTriangleVertexData>& vertexDataList) {
+void initGlobalCircleVertexPositions(int numCircleSubdivisions, float tubeRadius) {
+    globalTubeRadius = tubeRadius;
+    computeCircleVertexPositions(
+            numCircleSubdivisions, tubeRadius, globalCircleVertexPositions, globalCircleVertexNormals);
+}
+
+/**
+ * Computes a normal orthogonal to the passed tangent that is as close as possible to the last normal.
+ */
+static glm::vec3 computeOrientedCircleNormal(const glm::vec3& tangent, glm::vec3& lastNormal) {
     glm::vec3 helperAxis = lastNormal;
     if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
         // If tangent == lastNormal
@@ -65,40 +99,137 @@ void insertOrientedCirclePoints(
     }
     glm::vec3 normal = glm::normalize(helperAxis - glm::dot(helperAxis, tangent) * tangent); // Gram-Schmidt
     lastNormal = normal;
+    return normal;
+}
+
+/**
+ * Writes the vertices of a circle or ellipse in the xy plane transformed to the frame (normal, binormal, tangent).
+ * The vertex normals are the rotated cross section normals, so they are normalized without any further work.
+ * The batched SIMD version below needs to perform exactly the same operations in order to produce identical results.
+ */
+static void writeOrientedCrossSectionPoints(
+        const std::vector<glm::vec3>& crossSectionVertexPositions,
+        const std::vector<glm::vec3>& crossSectionVertexNormals,
+        const glm::vec3& center, const glm::vec3& tangent, const glm::vec3& normal, uint32_t vertexLinePointIndex,
+        TubeTriangleVertexData* vertexData) {
     glm::vec3 binormal = glm::cross(tangent, normal);
 
-    for (size_t i = 0; i < globalCircleVertexPositions.size(); i++) {
-        glm::vec3 pt = globalCircleVertexPositions.at(i);
+    for (size_t i = 0; i < crossSectionVertexPositions.size(); i++) {
+        const glm::vec3& pt = crossSectionVertexPositions[i];
+        const glm::vec3& ptNormal = crossSectionVertexNormals[i];
         glm::vec3 transformedPoint(
-                pt.x * normal.x + pt.y * binormal.x + pt.z * tangent.x + center.x,
-                pt.x * normal.y + pt.y * binormal.y + pt.z * tangent.y + center.y,
-                pt.x * normal.z + pt.y * binormal.z + pt.z * tangent.z + center.z
+                pt.x * normal.x + pt.y * binormal.x + center.x,
+                pt.x * normal.y + pt.y * binormal.y + center.y,
+                pt.x * normal.z + pt.y * binormal.z + center.z
+        );
+        glm::vec3 transformedNormal(
+                ptNormal.x * normal.x + ptNormal.y * binormal.x,
+                ptNormal.x * normal.y + ptNormal.y * binormal.y,
+                ptNormal.x * normal.z + ptNormal.y * binormal.z
         );
-        glm::vec3 vertexNormal = glm::normalize(transformedPoint - center);
 
-        TubeTriangleVertexData tubeTriangleVertexData{};
+        TubeTriangleVertexData& tubeTriangleVertexData = vertexData[i];
         tubeTriangleVertexData.vertexPosition = transformedPoint;
         tubeTriangleVertexData.vertexLinePointIndex = vertexLinePointIndex;
-        tubeTriangleVertexData.vertexNormal = vertexNormal;
-        tubeTriangleVertexData.phi = float(i) / float(globalCircleVertexPositions.size()) * sgl::TWO_PI;
-        vertexDataList.push_back(tubeTriangleVertexData);
+        tubeTriangleVertexData.vertexNormal = transformedNormal;
+        tubeTriangleVertexData.phi = float(i) / float(crossSectionVertexPositions.size()) * sgl::TWO_PI;
+    }
+}
+
+#ifdef TUBES_X86
+static_assert(sizeof(TubeTriangleVertexData) == 8 * sizeof(float), "Unexpected size of TubeTriangleVertexData.");
+
+/**
+ * Each vertex is computed in one 256-bit register: The lower half holds the position and the line point index, the
+ * upper half the normal and the angle phi.
+ */
+AVX_TARGET static void writeOrientedCrossSectionPointsAvx(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        const glm::vec3* normals, uint32_t vertexLinePointIndexBase, TubeTriangleVertexData* vertexData) {
+    const size_t numVertices = crossSection.getNumVertices();
+    const float* coefficients = crossSection.simdVertexCoefficients.data();
+    auto* output = reinterpret_cast<float*>(vertexData);
+    for (size_t pointIdx = 0; pointIdx < numPoints; pointIdx++) {
+        const glm::vec3& center = centers[pointIdx];
+        const glm::vec3& normal = normals[pointIdx];
+        glm::vec3 binormal = glm::cross(tangents[pointIdx], normal);
+        const __m256 frameX = _mm256_setr_ps(normal.x, normal.y, normal.z, 0.0f, normal.x, normal.y, normal.z, 0.0f);
+        const __m256 frameY = _mm256_setr_ps(
+                binormal.x, binormal.y, binormal.z, 0.0f, binormal.x, binormal.y, binormal.z, 0.0f);
+        // Adding -0 leaves the normal unchanged (including the sign of zero).
+        const __m256 offset = _mm256_setr_ps(center.x, center.y, center.z, 0.0f, -0.0f, -0.0f, -0.0f, -0.0f);
+        const __m256 linePointIndex = _mm256_castsi256_ps(
+                _mm256_set1_epi32(int(vertexLinePointIndexBase + uint32_t(pointIdx))));
+        for (size_t i = 0; i < numVertices; i++) {
+            const float* vertexCoefficients = coefficients + i * 24;
+            __m256 value = _mm256_add_ps(
+                    _mm256_mul_ps(_mm256_loadu_ps(vertexCoefficients), frameX),
+                    _mm256_mul_ps(_mm256_loadu_ps(vertexCoefficients + 8), frameY));
+            value = _mm256_add_ps(value, offset);
+            value = _mm256_blend_ps(value, linePointIndex, 0x08);
+            value = _mm256_blend_ps(value, _mm256_loadu_ps(vertexCoefficients + 16), 0x80);
+            _mm256_storeu_ps(output, value);
+            output += 8;
+        }
     }
 }
+#endif
+
+static void writeOrientedCrossSectionPointsBatch(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        const glm::vec3* normals, uint32_t vertexLinePointIndexBase, TubeTriangleVertexData* vertexData) {
+#ifdef TUBES_X86
+    if (getIsAvxSupported()) {
+        writeOrientedCrossSectionPointsAvx(
+                crossSection, numPoints, centers, tangents, normals, vertexLinePointIndexBase, vertexData);
+        return;
+    }
+#endif
+    const size_t numVertices = crossSection.getNumVertices();
+    for (size_t pointIdx = 0; pointIdx < numPoints; pointIdx++) {
+        writeOrientedCrossSectionPoints(
+                crossSection.vertexPositions, crossSection.vertexNormals,
+                centers[pointIdx], tangents[pointIdx], normals[pointIdx],
+                vertexLinePointIndexBase + uint32_t(pointIdx), vertexData + pointIdx * numVertices);
+    }
+}
+
+void insertOrientedCirclePoints(
+        const glm::vec3& center, const glm::vec3& tangent, glm::vec3& lastNormal, uint32_t vertexLinePointIndex,
+        std::vector<TubeTriangleVertexData>& vertexDataList) {
+    glm::vec3 normal = computeOrientedCircleNormal(tangent, lastNormal);
+    size_t vertexOffset = vertexDataList.size();
+    vertexDataList.resize(vertexOffset + globalCircleVertexPositions.size());
+    writeOrientedCrossSectionPoints(
+            globalCircleVertexPositions, globalCircleVertexNormals, center, tangent, normal, vertexLinePointIndex,
+            vertexDataList.data() + vertexOffset);
+}
+
+void insertOrientedCirclePoints(
+        const TubeCrossSection& crossSection,
+        const glm::vec3& center, const glm::vec3& tangent, glm::vec3& lastNormal, uint32_t vertexLinePointIndex,
+        TubeTriangleVertexData* vertexData) {
+    glm::vec3 normal = computeOrientedCircleNormal(tangent, lastNormal);
+    writeOrientedCrossSectionPoints(
+            crossSection.vertexPositions, crossSection.vertexNormals, center, tangent, normal, vertexLinePointIndex,
+            vertexData);
+}
+
+void insertOrientedCirclePointsBatch(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        glm::vec3& lastNormal, uint32_t vertexLinePointIndexBase, glm::vec3* normals,
+        TubeTriangleVertexData* vertexData) {
+    for (size_t pointIdx = 0; pointIdx < numPoints; pointIdx++) {
+        normals[pointIdx] = computeOrientedCircleNormal(tangents[pointIdx], lastNormal);
+    }
+    writeOrientedCrossSectionPointsBatch(
+            crossSection, numPoints, centers, tangents, normals, vertexLinePointIndexBase, vertexData);
+}
 
 void insertOrientedCirclePoints(
         const glm::vec3& center, const glm::vec3& tangent, glm::vec3& lastNormal,
         std::vector<glm::vec3>& vertexPositions) {
-    glm::vec3 helperAxis = lastNormal;
-    if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
-        // If tangent == lastNormal
-        helperAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-        if (glm::length(glm::cross(helperAxis, tangent)) < 0.01f) {
-            // If tangent == helperAxis
-            helperAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-        }
-    }
-    glm::vec3 normal = glm::normalize(helperAxis - glm::dot(helperAxis, tangent) * tangent); // Gram-Schmidt
-    lastNormal = normal;
+    glm::vec3 normal = computeOrientedCircleNormal(tangent, lastNormal);
     glm::vec3 binormal = glm::cross(tangent, normal);
 
     for (size_t i = 0; i < globalCircleVertexPositions.size(); i++) {
@@ -118,12 +249,11 @@ float globalTubeBinormalRadius = 0.0f;
 std::vector<glm::vec3> globalEllipseVertexPositions;
 std::vector<glm::vec3> globalEllipseVertexNormals;
 
-void initGlobalEllipseVertexPositions(int numCircleSubdivisions, float tubeNormalRadius, float tubeBinormalRadius) {
-    globalEllipseVertexPositions.clear();
-    globalEllipseVertexNormals.clear();
-    globalTubeNormalRadius = tubeNormalRadius;
-    globalTubeBinormalRadius = tubeBinormalRadius;
-
+static void computeEllipseVertexPositions(
+        int numCircleSubdivisions, float tubeNormalRadius, float tubeBinormalRadius,
+        std::vector<glm::vec3>& ellipseVertexPositions, std::vector<glm::vec3>& ellipseVertexNormals) {
+    ellipseVertexPositions.clear();
+    ellipseVertexNormals.clear();
     for (int i = 0; i < numCircleSubdivisions; i++) {
         float t = float(i) / float(numCircleSubdivisions) * sgl::TWO_PI;
         float cosAngle = std::cos(t);
@@ -132,35 +262,74 @@ void initGlobalEllipseVertexPositions(int numCircleSubdivisions, float tubeNorma
         glm::vec3 localNormal = glm::normalize(glm::vec3(
                 tubeBinormalRadius * cosAngle, tubeNormalRadius * sinAngle, 0.0f));
 
-        globalEllipseVertexPositions.emplace_back(localPosition);
-        globalEllipseVertexNormals.push_back(localNormal);
+        ellipseVertexPositions.emplace_back(localPosition);
+        ellipseVertexNormals.push_back(localNormal);
     }
 }
 
+void initGlobalEllipseVertexPositions(int numCircleSubdivisions, float tubeNormalRadius, float tubeBinormalRadius) {
+    globalTubeNormalRadius = tubeNormalRadius;
+    globalTubeBinormalRadius = tubeBinormalRadius;
+    computeEllipseVertexPositions(
+            numCircleSubdivisions, tubeNormalRadius, tubeBinormalRadius,
+            globalEllipseVertexPositions, globalEllipseVertexNormals);
+}
+
 void insertOrientedEllipsePoints(
         const glm::vec3& center, const glm::vec3& tangent, glm::vec3& normal, uint32_t vertexLinePointIndex,
         std::vector<TubeTriangleVertexData>& vertexDataList) {
-    glm::vec3 binormal = glm::cross(tangent, normal);
+    size_t vertexOffset = vertexDataList.size();
+    vertexDataList.resize(vertexOffset + globalEllipseVertexPositions.size());
+    writeOrientedCrossSectionPoints(
+            globalEllipseVertexPositions, globalEllipseVertexNormals, center, tangent, normal, vertexLinePointIndex,
+            vertexDataList.data() + vertexOffset);
+}
 
-    for (size_t i = 0; i < globalEllipseVertexPositions.size(); i++) {
-        glm::vec3 pt = globalEllipseVertexPositions.at(i);
-        glm::vec3 ptNormal = globalEllipseVertexNormals.at(i);
-        glm::vec3 transformedPoint(
-                pt.x * normal.x + pt.y * binormal.x + pt.z * tangent.x + center.x,
-                pt.x * normal.y + pt.y * binormal.y + pt.z * tangent.y + center.y,
-                pt.x * normal.z + pt.y * binormal.z + pt.z * tangent.z + center.z
-        );
-        glm::vec3 transformedNormal(
-                ptNormal.x * normal.x + ptNormal.y * binormal.x + ptNormal.z * tangent.x,
-                ptNormal.x * normal.y + ptNormal.y * binormal.y + ptNormal.z * tangent.y,
-                ptNormal.x * normal.z + ptNormal.y * binormal.z + ptNormal.z * tangent.z
-        );
+void insertOrientedEllipsePoints(
+        const TubeCrossSection& crossSection,
+        const glm::vec3& center, const glm::vec3& tangent, const glm::vec3& normal, uint32_t vertexLinePointIndex,
+        TubeTriangleVertexData* vertexData) {
+    writeOrientedCrossSectionPoints(
+            crossSection.vertexPositions, crossSection.vertexNormals, center, tangent, normal, vertexLinePointIndex,
+            vertexData);
+}
 
-        TubeTriangleVertexData tubeTriangleVertexData{};
-        tubeTriangleVertexData.vertexPosition = transformedPoint;
-        tubeTriangleVertexData.vertexLinePointIndex = vertexLinePointIndex;
-        tubeTriangleVertexData.vertexNormal = transformedNormal;
-        tubeTriangleVertexData.phi = float(i) / float(globalEllipseVertexPositions.size()) * sgl::TWO_PI;
-        vertexDataList.push_back(tubeTriangleVertexData);
+void insertOrientedEllipsePointsBatch(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        const glm::vec3* normals, uint32_t vertexLinePointIndexBase, TubeTriangleVertexData* vertexData) {
+    writeOrientedCrossSectionPointsBatch(
+            crossSection, numPoints, centers, tangents, normals, vertexLinePointIndexBase, vertexData);
+}
+
+
+/**
+ * Stores the coefficients used by writeOrientedCrossSectionPointsAvx. The position and normal coefficients are
+ * duplicated for the x, y and z components, and the last group stores phi in the last component.
+ */
+static void computeCrossSectionSimdCoefficients(TubeCrossSection& crossSection) {
+    const size_t numVertices = crossSection.getNumVertices();
+    crossSection.simdVertexCoefficients.assign(numVertices * 24, 0.0f);
+    for (size_t i = 0; i < numVertices; i++) {
+        const glm::vec3& pt = crossSection.vertexPositions[i];
+        const glm::vec3& ptNormal = crossSection.vertexNormals[i];
+        float* vertexCoefficients = crossSection.simdVertexCoefficients.data() + i * 24;
+        for (int j = 0; j < 4; j++) {
+            vertexCoefficients[j] = pt.x;
+            vertexCoefficients[4 + j] = ptNormal.x;
+            vertexCoefficients[8 + j] = pt.y;
+            vertexCoefficients[12 + j] = ptNormal.y;
+        }
+        vertexCoefficients[23] = float(i) / float(numVertices) * sgl::TWO_PI;
     }
 }
+
+void TubeCrossSection::initCircle(int numCircleSubdivisions, float tubeRadius) {
+    computeCircleVertexPositions(numCircleSubdivisions, tubeRadius, vertexPositions, vertexNormals);
+    computeCrossSectionSimdCoefficients(*this);
+}
+
+void TubeCrossSection::initEllipse(int numEllipseSubdivisions, float tubeNormalRadius, float tubeBinormalRadius) {
+    computeEllipseVertexPositions(
+            numEllipseSubdivisions, tubeNormalRadius, tubeBinormalRadius, vertexPositions, vertexNormals);
+    computeCrossSectionSimdCoefficients(*this);
+}
@@ -127,6 +127,84 @@ void createCappedTrianglePrincipalStressTubesRenderDataCPU(
         std::vector<glm::vec3>& lineTangents,
         std::vector<glm::vec3>& lineNormals);
 
+/*
+ * Thread-safe counterparts of the triangle tube functions above. They first count the number of vertices, indices
+ * and line points produced by each line, compute the output offsets of all lines using a prefix sum and then emit the
+ * geometry of all lines in parallel into the preallocated output arrays. The circle/ellipse templates are created per
+ * call instead of being stored in the global variables below. The output is bit-identical to the sequential version.
+ */
+void createTriangleTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        float tubeRadius,
+        int numCircleSubdivisions,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals);
+
+void createTriangleEllipticTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>& lineRightVectorsList,
+        float tubeNormalRadius,
+        float tubeBinormalRadius,
+        int numEllipseSubdivisions,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals);
+
+void createCappedTriangleTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        float tubeRadius, int numCircleSubdivisions, bool tubeClosed,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals);
+
+void createCappedTriangleEllipticTubesRenderDataCPUParallel(
+        const std::vector<std::vector<glm::vec3>>& lineCentersList,
+        const std::vector<std::vector<glm::vec3>>& lineRightVectorsList,
+        float tubeNormalRadius, float tubeBinormalRadius, int numEllipseSubdivisions, bool tubeClosed,
+        std::vector<uint32_t>& triangleIndices,
+        std::vector<TubeTriangleVertexData>& vertexDataList,
+        std::vector<LinePointReference>& linePointReferenceList,
+        uint32_t linePointOffset,
+        std::vector<glm::vec3>& lineTangents,
+        std::vector<glm::vec3>& lineNormals);
+
+/*
+ * Hemisphere caps used by the capped tube functions. They write into the preallocated ranges starting at
+ * indexOffsetCap (vertices) and triOffsetCap (indices).
+ */
+void addHemisphereToMeshStart(
+        const glm::vec3& center, glm::vec3 tangent, glm::vec3 normal,
+        uint32_t indexOffset, uint32_t indexOffsetCap, uint32_t triOffsetCap,
+        uint32_t vertexLinePointIndex, float tubeRadius, int numLongitudeSubdivisions, int numLatitudeSubdivisions,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList);
+void addHemisphereToMeshStop(
+        const glm::vec3& center, glm::vec3 tangent, glm::vec3 normal,
+        uint32_t indexOffset, uint32_t indexOffsetCap, uint32_t triOffsetCap,
+        uint32_t vertexLinePointIndex, float tubeRadius, int numLongitudeSubdivisions, int numLatitudeSubdivisions,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList);
+void addEllipticHemisphereToMeshStart(
+        const glm::vec3& center, glm::vec3 tangent, glm::vec3 normal,
+        uint32_t indexOffset, uint32_t indexOffsetCap, uint32_t triOffsetCap,
+        uint32_t vertexLinePointIndex, float tubeNormalRadius, float tubeBinormalRadius,
+        int numLongitudeSubdivisions, int numLatitudeSubdivisions,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList);
+void addEllipticHemisphereToMeshStop(
+        const glm::vec3& center, glm::vec3 tangent, glm::vec3 normal,
+        uint32_t indexOffset, uint32_t indexOffsetCap, uint32_t triOffsetCap,
+        uint32_t vertexLinePointIndex, float tubeNormalRadius, float tubeBinormalRadius,
+        int numLongitudeSubdivisions, int numLatitudeSubdivisions,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList);
+
 template<typename T>
 void createLineTubesRenderDataCPU(
         const std::vector<std::vector<glm::vec3>>& lineCentersList,
@@ -155,12 +233,14 @@ void createLineTubesRenderDataCPU(
  */
 extern float globalTubeRadius;
 extern std::vector<glm::vec3> globalCircleVertexPositions;
+extern std::vector<glm::vec3> globalCircleVertexNormals;
 extern float globalTubeNormalRadius;
 extern float globalTubeBinormalRadius;
 extern std::vector<glm::vec3> globalEllipseVertexPositions;
 extern std::vector<glm::vec3> globalEllipseVertexNormals;
 /**
- * Computes the points lying on the specified circle and stores them in @see globalCircleVertexPositions.
+ * Computes the points lying on the specified circle and stores them in @see globalCircleVertexPositions (and their
+ * unit normals in @see globalCircleVertexNormals).
  * @param numCircleSubdivisions The number of segments to use to approximate the circle.
  * @param tubeRadius The radius of the circle.
  */
@@ -200,6 +280,114 @@ extern void insertOrientedEllipsePoints(
         const glm::vec3& center, const glm::vec3& tangent, glm::vec3& normal, uint32_t vertexLinePointIndex,
         std::vector<TubeTriangleVertexData>& vertexDataList);
 
+/**
+ * Circle or ellipse template owned by the caller. In contrast to the global variables above, it can be used
+ * concurrently by multiple threads.
+ */
+struct TubeCrossSection {
+    void initCircle(int numCircleSubdivisions, float tubeRadius);
+    void initEllipse(int numEllipseSubdivisions, float tubeNormalRadius, float tubeBinormalRadius);
+    [[nodiscard]] inline size_t getNumVertices() const { return vertexPositions.size(); }
+
+    std::vector<glm::vec3> vertexPositions; ///< In the xy plane.
+    std::vector<glm::vec3> vertexNormals; ///< Unit normals in the xy plane.
+    /// Per vertex, three groups of eight floats with the position/normal coefficients for the batched functions below.
+    std::vector<float> simdVertexCoefficients;
+};
+/**
+ * Writes the vertex points of an oriented and shifted copy of the circle template to vertexData, which needs to
+ * provide space for crossSection.getNumVertices() elements.
+ */
+extern void insertOrientedCirclePoints(
+        const TubeCrossSection& crossSection,
+        const glm::vec3& center, const glm::vec3& tangent, glm::vec3& lastNormal, uint32_t vertexLinePointIndex,
+        TubeTriangleVertexData* vertexData);
+/**
+ * Writes the vertex points of an oriented and shifted copy of the ellipse template to vertexData, which needs to
+ * provide space for crossSection.getNumVertices() elements.
+ */
+extern void insertOrientedEllipsePoints(
+        const TubeCrossSection& crossSection,
+        const glm::vec3& center, const glm::vec3& tangent, const glm::vec3& normal, uint32_t vertexLinePointIndex,
+        TubeTriangleVertexData* vertexData);
+/**
+ * Batched version of the circle function above for numPoints consecutive line points. The normals are transported
+ * along the points in the same way (i.e., starting from lastNormal, each normal is the last normal projected onto the
+ * plane orthogonal to the tangent), and all rings are written with SIMD instructions if supported by the CPU.
+ * @param centers The centers of the circles.
+ * @param tangents The normalized tangents.
+ * @param lastNormal The normal of the previous line point; set to the normal of the last point.
+ * @param vertexLinePointIndexBase The line point index of the first point. Point k uses vertexLinePointIndexBase + k.
+ * @param normals Output of the normal of each point.
+ * @param vertexData Output with space for numPoints * crossSection.getNumVertices() elements.
+ */
+extern void insertOrientedCirclePointsBatch(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        glm::vec3& lastNormal, uint32_t vertexLinePointIndexBase, glm::vec3* normals,
+        TubeTriangleVertexData* vertexData);
+/**
+ * Batched version of the ellipse function above for numPoints consecutive line points with the passed normals.
+ */
+extern void insertOrientedEllipsePointsBatch(
+        const TubeCrossSection& crossSection, size_t numPoints, const glm::vec3* centers, const glm::vec3* tangents,
+        const glm::vec3* normals, uint32_t vertexLinePointIndexBase, TubeTriangleVertexData* vertexData);
+
+/**
+ * Part of a triangle tube mesh covering the lines [lineBegin, lineEnd).
+ * The vertex indices and line point indices stored in the vertices refer to the complete mesh.
+ */
+struct TubeTriangleMeshChunk {
+    size_t lineBegin = 0, lineEnd = 0;
+    size_t vertexOffset = 0; ///< Offset of the first vertex of the chunk in the complete vertex list.
+    size_t indexOffset = 0; ///< Offset of the first index of the chunk in the complete index list.
+    size_t linePointOffset = 0; ///< Offset of the first line point of the chunk in the complete line point list.
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    std::vector<LinePointReference> linePointReferenceList;
+    std::vector<glm::vec3> lineTangents;
+    std::vector<glm::vec3> lineNormals;
+};
+
+class TriangleTubeMeshBuilder;
+
+/**
+ * Generates the same mesh as the parallel (capped) triangle tube functions above, but in chunks of consecutive lines
+ * whose size does not exceed the passed budget. This way, the mesh can be uploaded chunk by chunk without ever
+ * holding the complete mesh in host memory. Lines whose mesh exceeds the budget on their own form a chunk of one line.
+ * Concatenating all chunks yields the output of the corresponding monolithic function called with empty lists.
+ */
+class TriangleTubeMeshChunkGenerator {
+public:
+    /**
+     * @param lineRightVectorsList The ellipse orientation for elliptic tubes or nullptr for circular tubes.
+     * @param vertexIndexBase Offset added to all vertex indices (e.g., when appending multiple line sets).
+     * @param linePointOffset Offset added to the line point indices stored in the vertices.
+     * @param maxChunkSizeInBytes The maximum size of the data of one chunk.
+     */
+    TriangleTubeMeshChunkGenerator(
+            const std::vector<std::vector<glm::vec3>>& lineCentersList,
+            const std::vector<std::vector<glm::vec3>>* lineRightVectorsList,
+            float tubeNormalRadius, float tubeBinormalRadius, int numSubdivisions, bool hasCaps, bool tubeClosed,
+            size_t vertexIndexBase, uint32_t linePointOffset, size_t maxChunkSizeInBytes);
+    ~TriangleTubeMeshChunkGenerator();
+
+    /// The size of the complete mesh.
+    [[nodiscard]] size_t getNumVertices() const;
+    [[nodiscard]] size_t getNumIndices() const;
+    [[nodiscard]] size_t getNumLinePoints() const;
+    [[nodiscard]] inline size_t getNumChunks() const { return chunkLineOffsets.size() - 1; }
+
+    /// Generates the passed chunk. The returned data is overwritten by the next call.
+    const TubeTriangleMeshChunk& generateChunk(size_t chunkIdx);
+
+private:
+    TubeCrossSection crossSection;
+    size_t vertexIndexBase;
+    std::vector<size_t> chunkLineOffsets;
+    TubeTriangleMeshChunk chunk;
+    std::unique_ptr<TriangleTubeMeshBuilder> builder;
+};
+
 
 /*
  * Template forward declarations, as code is in .cpp file.
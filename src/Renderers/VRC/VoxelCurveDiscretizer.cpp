@@ -102,7 +102,7 @@ void VoxelCurveDiscretizer::loadLineData(
     int selectedAttributeIndex = lineData->getSelectedAttributeIndex();
     lineData->rebuildInternalRepresentationIfNecessary();
     lineData->iterateOverTrajectoriesNotFiltered([this, selectedAttributeIndex](
-            const Trajectory& trajectory) {
+            const TrajectoryView& trajectory) {
         Curve curve;
         for (size_t pointIdx = 0; pointIdx < trajectory.positions.size(); pointIdx++) {
             curve.points.push_back(sgl::transformPoint(linesToVoxel, trajectory.positions.at(pointIdx)));
@@ -0,0 +1,163 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <Utils/File/Logfile.hpp>
+
+#include "MappedFile.hpp"
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& _filename, bool sequentialAccess) {
+    close();
+    filename = _filename;
+
+    DWORD flags = sequentialAccess ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+    HANDLE hFile = CreateFileA(
+            filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: File \"" + filename + "\" could not be opened.");
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(hFile);
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: File \"" + filename + "\" is empty or its size could not be queried.");
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping == nullptr) {
+        CloseHandle(hFile);
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: CreateFileMapping failed for file \"" + filename + "\".");
+        return false;
+    }
+
+    void* mappedPtr = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mappedPtr == nullptr) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: MapViewOfFile failed for file \"" + filename + "\".");
+        return false;
+    }
+
+    fileHandle = hFile;
+    fileMappingHandle = hMapping;
+    data = reinterpret_cast<const uint8_t*>(mappedPtr);
+    size = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (fileMappingHandle) {
+        CloseHandle(fileMappingHandle);
+        fileMappingHandle = nullptr;
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+    size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& _filename, bool sequentialAccess) {
+    close();
+    filename = _filename;
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: File \"" + filename + "\" could not be opened.");
+        return false;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        ::close(fd);
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: File \"" + filename + "\" is empty or its size could not be queried.");
+        return false;
+    }
+
+    auto fileSize = size_t(fileStat.st_size);
+    void* mappedPtr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mappedPtr == MAP_FAILED) {
+        ::close(fd);
+        sgl::Logfile::get()->writeError(
+                "Error in MappedFile::open: mmap failed for file \"" + filename + "\".");
+        return false;
+    }
+    if (sequentialAccess) {
+        madvise(mappedPtr, fileSize, MADV_SEQUENTIAL);
+    }
+
+    fileDescriptor = fd;
+    data = reinterpret_cast<const uint8_t*>(mappedPtr);
+    size = fileSize;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), size);
+        data = nullptr;
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+    size = 0;
+}
+
+#endif
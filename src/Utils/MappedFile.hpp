@@ -0,0 +1,85 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_MAPPEDFILE_HPP
+#define LINEVIS_MAPPEDFILE_HPP
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Read-only memory mapping of a file. The mapping stays valid as long as the object lives, so objects referencing the
+ * mapped pages should hold a MappedFilePtr.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps the passed file into the address space of the process.
+     * @param filename The name of the file to map.
+     * @param sequentialAccess Whether the OS should expect sequential page accesses (read-ahead hint).
+     * @return Whether the file could be mapped.
+     */
+    bool open(const std::string& filename, bool sequentialAccess = false);
+    void close();
+
+    [[nodiscard]] inline bool getIsOpen() const { return data != nullptr; }
+    [[nodiscard]] inline const uint8_t* getData() const { return data; }
+    [[nodiscard]] inline size_t getSize() const { return size; }
+    [[nodiscard]] inline const std::string& getFilename() const { return filename; }
+
+    /// Returns a typed pointer into the mapped memory. Returns nullptr if the range exceeds the file size.
+    template<class T>
+    [[nodiscard]] inline const T* getPointer(size_t byteOffset, size_t numElements = 1) const {
+        if (byteOffset > size || numElements > (size - byteOffset) / sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(data + byteOffset);
+    }
+
+private:
+    std::string filename;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* fileMappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
+
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+#endif //LINEVIS_MAPPEDFILE_HPP
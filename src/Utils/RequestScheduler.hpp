@@ -0,0 +1,228 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2023, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_REQUESTSCHEDULER_HPP
+#define LINEVIS_REQUESTSCHEDULER_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <functional>
+#include <condition_variable>
+
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+/**
+ * Shared state of a job run by @see RequestScheduler. Long-running jobs should poll getIsCancelled() in their inner
+ * loops and return early, and may report their progress.
+ */
+class JobToken {
+public:
+    [[nodiscard]] inline bool getIsCancelled() const { return isCancelled.load(std::memory_order_acquire); }
+    inline void cancel() { isCancelled.store(true, std::memory_order_release); }
+
+    /// @param progress The progress in the range [0, 1].
+    inline void setProgress(float progress) { this->progress.store(progress, std::memory_order_relaxed); }
+    /// @return The progress in the range [0, 1], or a negative value if the job has not reported any progress.
+    [[nodiscard]] inline float getProgress() const { return progress.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> isCancelled{false};
+    std::atomic<float> progress{-1.0f};
+};
+typedef std::shared_ptr<JobToken> JobTokenPtr;
+
+/**
+ * Runs requests on a worker thread. Similar to a mailbox queue of size 1 in the Vulkan API
+ * (cmp. VK_PRESENT_MODE_MAILBOX_KHR), only the most recent request and reply are stored. In contrast to a plain
+ * mailbox, queueing a new request also cancels the request currently being processed, as its result would be stale
+ * anyway. Replies of cancelled jobs are never published.
+ */
+template<class Reply>
+class RequestScheduler {
+public:
+    /**
+     * A job writes its result to the passed reply object. It returns whether the reply shall be published.
+     */
+    typedef std::function<bool(Reply& reply, JobToken& jobToken)> Job;
+
+    /**
+     * @param threadName The name of the worker thread (for profiling).
+     * @param useWorkerThread If false, jobs are run synchronously in @see queueJob on the calling thread.
+     */
+    explicit RequestScheduler(std::string threadName, bool useWorkerThread = true)
+            : threadName(std::move(threadName)), useWorkerThread(useWorkerThread) {
+        if (useWorkerThread) {
+            workerThread = std::thread(&RequestScheduler::mainLoop, this);
+        }
+    }
+    ~RequestScheduler() {
+        join();
+    }
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    /**
+     * Cancels the job currently being processed and replaces the pending job (if any) with the passed one.
+     */
+    void queueJob(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (runningJobToken) {
+                runningJobToken->cancel();
+            }
+            pendingJob = std::move(job);
+            hasPendingJob = true;
+        }
+        if (useWorkerThread) {
+            hasPendingJobConditionVariable.notify_all();
+        } else {
+            runPendingJob();
+        }
+    }
+
+    /**
+     * Checks if a reply is available. If this is the case, it is moved to reply.
+     * @return Whether a reply was available.
+     */
+    bool getReply(Reply& reply) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!hasReply) {
+            return false;
+        }
+        reply = std::move(this->reply);
+        this->reply = Reply();
+        hasReply = false;
+        return true;
+    }
+
+    /**
+     * @return Whether a request is currently pending or processed (for UI progress spinner).
+     */
+    [[nodiscard]] bool getIsProcessingRequest() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hasPendingJob || runningJobToken;
+    }
+
+    /**
+     * @return The progress of the job currently processed in the range [0, 1], or a negative value if unknown.
+     */
+    [[nodiscard]] float getProgress() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return runningJobToken ? runningJobToken->getProgress() : -1.0f;
+    }
+
+    /**
+     * Cancels the running job, discards the pending job and waits for the worker thread to terminate.
+     */
+    void join() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (programIsFinished) {
+                return;
+            }
+            programIsFinished = true;
+            if (runningJobToken) {
+                runningJobToken->cancel();
+            }
+            pendingJob = {};
+            hasPendingJob = false;
+        }
+        hasPendingJobConditionVariable.notify_all();
+        if (workerThread.joinable()) {
+            workerThread.join();
+        }
+        reply = Reply();
+        hasReply = false;
+    }
+
+private:
+    /// The main loop of the worker thread.
+    void mainLoop() {
+#ifdef TRACY_ENABLE
+        tracy::SetThreadName(threadName.c_str());
+#endif
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                hasPendingJobConditionVariable.wait(lock, [this] { return hasPendingJob || programIsFinished; });
+                if (programIsFinished) {
+                    break;
+                }
+            }
+            runPendingJob();
+        }
+    }
+
+    void runPendingJob() {
+        Job job;
+        JobTokenPtr jobToken = std::make_shared<JobToken>();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!hasPendingJob || programIsFinished) {
+                return;
+            }
+            job = std::move(pendingJob);
+            pendingJob = {};
+            hasPendingJob = false;
+            runningJobToken = jobToken;
+        }
+
+        Reply newReply{};
+        bool shallPublish = job(newReply, *jobToken);
+        job = {};
+
+        std::lock_guard<std::mutex> lock(mutex);
+        runningJobToken = {};
+        if (shallPublish && !jobToken->getIsCancelled()) {
+            reply = std::move(newReply);
+            hasReply = true;
+        }
+    }
+
+    std::string threadName;
+    bool useWorkerThread;
+    std::thread workerThread;
+    mutable std::mutex mutex;
+    std::condition_variable hasPendingJobConditionVariable;
+
+    bool programIsFinished = false;
+    bool hasPendingJob = false;
+    Job pendingJob;
+    JobTokenPtr runningJobToken;
+
+    bool hasReply = false;
+    Reply reply{};
+};
+
+#endif //LINEVIS_REQUESTSCHEDULER_HPP
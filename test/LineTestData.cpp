@@ -0,0 +1,82 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <random>
+
+#include "Renderers/Tubes/Tubes.hpp"
+#include "LineTestData.hpp"
+
+void createTubeMesh(
+        size_t numLines, int numLinePoints, int numSubdivisions, uint32_t seed,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> positionDistribution(-1.0f, 1.0f);
+    std::vector<std::vector<glm::vec3>> lineCentersList(numLines);
+    for (std::vector<glm::vec3>& lineCenters : lineCentersList) {
+        glm::vec3 position(
+                positionDistribution(generator), positionDistribution(generator), positionDistribution(generator));
+        for (int i = 0; i < numLinePoints; i++) {
+            position += 0.02f * glm::vec3(
+                    positionDistribution(generator), positionDistribution(generator),
+                    positionDistribution(generator));
+            lineCenters.push_back(position);
+        }
+    }
+    std::vector<LinePointReference> linePointReferences;
+    std::vector<glm::vec3> lineTangents, lineNormals;
+    createTriangleTubesRenderDataCPUParallel(
+            lineCentersList, 0.005f, numSubdivisions, triangleIndices, vertexDataList,
+            linePointReferences, 0, lineTangents, lineNormals);
+}
+
+TrajectoryStore createHelixLines(
+        size_t numLines, size_t numLinePoints, float noiseAmplitude, uint32_t seed, bool useVaryingLengths) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    TrajectoryStore trajectories;
+    for (size_t lineIdx = 0; lineIdx < numLines; lineIdx++) {
+        Trajectory trajectory;
+        trajectory.attributes.resize(2);
+        glm::vec3 center(distribution(generator), distribution(generator), distribution(generator));
+        float radius = 0.05f + 0.05f * std::abs(distribution(generator));
+        size_t numPoints = useVaryingLengths ? numLinePoints / 2 + lineIdx % (numLinePoints / 2) : numLinePoints;
+        for (size_t i = 0; i < numPoints; i++) {
+            float t = float(i) / float(numLinePoints - 1);
+            float angle = t * 6.0f * 3.14159265f;
+            glm::vec3 noise(distribution(generator), distribution(generator), distribution(generator));
+            trajectory.positions.push_back(
+                    center + glm::vec3(radius * std::cos(angle), radius * std::sin(angle), 0.5f * t)
+                    + noiseAmplitude * noise);
+            trajectory.attributes.at(0).push_back(std::sin(4.0f * angle));
+            trajectory.attributes.at(1).push_back(t);
+        }
+        trajectories.pushBack(trajectory);
+    }
+    return trajectories;
+}
@@ -0,0 +1,64 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LINEVIS_LINETESTDATA_HPP
+#define LINEVIS_LINETESTDATA_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "Loaders/TrajectoryStore.hpp"
+
+struct TubeTriangleVertexData;
+
+/**
+ * Creates random walk lines in [-1, 1]^3 and meshes them with the parallel triangle tube mesher.
+ */
+void createTubeMesh(
+        size_t numLines, int numLinePoints, int numSubdivisions, uint32_t seed,
+        std::vector<uint32_t>& triangleIndices, std::vector<TubeTriangleVertexData>& vertexDataList);
+
+/**
+ * Creates oversampled helices (similar to streamlines traced with a small step size) with random noise of the passed
+ * amplitude in [-1, 1]^3. Attribute 0 varies smoothly along the line, attribute 1 is the line parameter t in [0, 1].
+ * @param useVaryingLengths Whether the lines should have different lengths between numLinePoints / 2 and
+ * numLinePoints - 1 (e.g., for an importance ordering by length).
+ */
+TrajectoryStore createHelixLines(
+        size_t numLines, size_t numLinePoints, float noiseAmplitude, uint32_t seed, bool useVaryingLengths = false);
+
+/**
+ * Half of the surface area of an axis-aligned bounding box. Works for all vector types with an index operator.
+ */
+template<class Vector>
+inline auto computeHalfArea(const Vector& aabbMin, const Vector& aabbMax) {
+    Vector extent = aabbMax - aabbMin;
+    return extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0];
+}
+
+#endif //LINEVIS_LINETESTDATA_HPP
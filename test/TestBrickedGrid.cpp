@@ -0,0 +1,249 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include <Math/Math.hpp>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineSeeder.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+#include "LineData/Flow/BrickedGrid.hpp"
+#include "LineData/Flow/Loader/GridLoader.hpp"
+
+/**
+ * Writes an ABC flow with a temperature-like fourth channel to a raw file in the (Vx, Vy, Vz, T) layout also used by
+ * RbcBinFileLoader.
+ */
+class BrickedGridTest : public ::testing::Test {
+protected:
+    void createDataSet(int _xs, int _ys, int _zs) {
+        xs = _xs;
+        ys = _ys;
+        zs = _zs;
+        dx = 2.0f * sgl::PI / float(xs - 1);
+        dy = 2.0f * sgl::PI / float(ys - 1);
+        dz = 2.0f * sgl::PI / float(zs - 1);
+        const float A = std::sqrt(3.0f), B = std::sqrt(2.0f), C = 1.0f;
+        dataField.resize(size_t(xs) * size_t(ys) * size_t(zs) * 4);
+        for (int z = 0; z < zs; z++) {
+            for (int y = 0; y < ys; y++) {
+                for (int x = 0; x < xs; x++) {
+                    float px = float(x) * dx, py = float(y) * dy, pz = float(z) * dz;
+                    size_t idx = (size_t(x) + size_t(y) * size_t(xs) + size_t(z) * size_t(xs) * size_t(ys)) * 4;
+                    dataField[idx] = A * std::sin(pz) + C * std::cos(py);
+                    dataField[idx + 1] = B * std::sin(px) + A * std::cos(pz);
+                    dataField[idx + 2] = C * std::sin(py) + B * std::cos(px);
+                    dataField[idx + 3] = std::sin(px) * std::sin(py) * std::sin(pz);
+                }
+            }
+        }
+        filename = (std::filesystem::temp_directory_path() / "LineVisTestBrickedGrid.raw").string();
+        std::ofstream file(filename, std::ios::binary);
+        ASSERT_TRUE(file.is_open());
+        file.write(reinterpret_cast<const char*>(dataField.data()), std::streamsize(dataField.size() * sizeof(float)));
+        file.close();
+    }
+
+    void TearDown() override {
+        if (!filename.empty()) {
+            std::filesystem::remove(filename);
+        }
+    }
+
+    BrickedGridPtr createBrickedGrid(int brickSize, size_t cacheMemoryBudget) {
+        auto brickedGrid = std::make_shared<BrickedGrid>(brickSize, cacheMemoryBudget);
+        EXPECT_TRUE(brickedGrid->openRawFile(filename, xs, ys, zs, 4, dx, dy, dz));
+        brickedGrid->addField("Velocity", BrickedFieldType::CHANNEL_VECTOR, 0);
+        brickedGrid->addField("Vorticity", BrickedFieldType::VORTICITY);
+        brickedGrid->addField("Helicity", BrickedFieldType::HELICITY);
+        brickedGrid->addField("Temperature", BrickedFieldType::CHANNEL_SCALAR, 3);
+        return brickedGrid;
+    }
+
+    /// Adds the same fields as @see createBrickedGrid as dense fields.
+    void addDenseFields(StreamlineTracingGrid& grid) {
+        size_t numPoints = size_t(xs) * size_t(ys) * size_t(zs);
+        auto* velocityField = new float[numPoints * 3];
+        auto* vorticityField = new float[numPoints * 3];
+        auto* helicityField = new float[numPoints];
+        auto* temperatureField = new float[numPoints];
+        for (size_t i = 0; i < numPoints; i++) {
+            velocityField[i * 3] = dataField[i * 4];
+            velocityField[i * 3 + 1] = dataField[i * 4 + 1];
+            velocityField[i * 3 + 2] = dataField[i * 4 + 2];
+            temperatureField[i] = dataField[i * 4 + 3];
+        }
+        computeVorticityField(velocityField, vorticityField, xs, ys, zs, dx, dy, dz);
+        computeHelicityFieldNormalized(velocityField, vorticityField, helicityField, xs, ys, zs, false, false);
+        grid.setGridExtent(xs, ys, zs, dx, dy, dz);
+        grid.addVectorField(velocityField, "Velocity");
+        grid.addVectorField(vorticityField, "Vorticity");
+        grid.addScalarField(helicityField, "Helicity");
+        grid.addScalarField(temperatureField, "Temperature");
+    }
+
+    int xs = 0, ys = 0, zs = 0;
+    float dx = 0.0f, dy = 0.0f, dz = 0.0f;
+    std::vector<float> dataField;
+    std::string filename;
+};
+
+TEST_F(BrickedGridTest, MatchesDenseFields) {
+    createDataSet(37, 21, 29);
+    // A budget of a few bricks forces frequent evictions.
+    const int brickSize = 8;
+    const size_t brickMemory = size_t(brickSize + 2) * size_t(brickSize + 2) * size_t(brickSize + 2) * 3 * 4;
+    BrickedGridPtr brickedGrid = createBrickedGrid(brickSize, brickMemory * 4);
+
+    std::vector<float> velocityField(size_t(xs) * size_t(ys) * size_t(zs) * 3);
+    for (size_t i = 0; i < velocityField.size() / 3; i++) {
+        for (int c = 0; c < 3; c++) {
+            velocityField[i * 3 + c] = dataField[i * 4 + c];
+        }
+    }
+    std::vector<float> vorticityField(velocityField.size());
+    std::vector<float> helicityField(velocityField.size() / 3);
+    computeVorticityField(velocityField.data(), vorticityField.data(), xs, ys, zs, dx, dy, dz);
+    computeHelicityField(velocityField.data(), vorticityField.data(), helicityField.data(), xs, ys, zs);
+
+    auto getValue = [this](const std::vector<float>& field, int numComponents, int c, int x, int y, int z) {
+        if (x < 0 || y < 0 || z < 0 || x >= xs || y >= ys || z >= zs) {
+            return 0.0f;
+        }
+        return field[(size_t(x) + size_t(y) * size_t(xs) + size_t(z) * size_t(xs) * size_t(ys))
+                * size_t(numComponents) + size_t(c)];
+    };
+    auto interpolate = [&](const std::vector<float>& field, int numComponents, int c, const glm::vec3& p) {
+        auto gridPosition = glm::ivec3(p);
+        glm::vec3 frac = glm::fract(p);
+        float value = 0.0f;
+        for (int offset = 0; offset < 8; offset++) {
+            int ox = offset & 1, oy = (offset >> 1) & 1, oz = offset >> 2;
+            float weight = (ox ? frac.x : 1.0f - frac.x) * (oy ? frac.y : 1.0f - frac.y) * (oz ? frac.z : 1.0f - frac.z);
+            value += weight * getValue(
+                    field, numComponents, c, gridPosition.x + ox, gridPosition.y + oy, gridPosition.z + oz);
+        }
+        return value;
+    };
+
+    std::default_random_engine generator(17);
+    std::uniform_real_distribution<float> distX(0.0f, float(xs - 1));
+    std::uniform_real_distribution<float> distY(0.0f, float(ys - 1));
+    std::uniform_real_distribution<float> distZ(0.0f, float(zs - 1));
+    for (int i = 0; i < 10000; i++) {
+        glm::vec3 p(distX(generator), distY(generator), distZ(generator));
+        glm::vec3 velocity = brickedGrid->sampleVector(0, p);
+        glm::vec3 vorticity = brickedGrid->sampleVector(1, p);
+        for (int c = 0; c < 3; c++) {
+            EXPECT_NEAR(velocity[c], interpolate(velocityField, 3, c, p), 1e-5f);
+            EXPECT_NEAR(vorticity[c], interpolate(vorticityField, 3, c, p), 1e-4f);
+        }
+        EXPECT_NEAR(brickedGrid->sampleScalar(2, p), interpolate(helicityField, 1, 0, p), 1e-4f);
+        EXPECT_NEAR(brickedGrid->sampleScalar(3, p), interpolate(dataField, 4, 3, p), 1e-5f);
+    }
+    EXPECT_EQ(brickedGrid->getScalarAtIdx(3, xs - 1, ys - 1, zs - 1), dataField.back());
+    EXPECT_GT(brickedGrid->getNumBrickEvictions(), size_t(0));
+    EXPECT_LE(brickedGrid->getCacheMemoryUsage(), brickedGrid->getCacheMemoryBudget());
+}
+
+static size_t getPeakResidentSetSizeMiB() {
+#ifdef __linux__
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return size_t(usage.ru_maxrss) / size_t(1024);
+#else
+    return 0;
+#endif
+}
+
+static void traceAndReport(const char* modeName, StreamlineTracingGrid& grid) {
+    StreamlineTracingSettings tracingSettings;
+    tracingSettings.flowPrimitives = FlowPrimitives::STREAMLINES;
+    tracingSettings.streamlineSeedingStrategy = StreamlineSeedingStrategy::VOLUME;
+    tracingSettings.seeder = std::make_shared<StreamlineVolumeSeeder>();
+    tracingSettings.numPrimitives = 2000;
+    tracingSettings.minimumLength = 0.0f;
+
+    Trajectories trajectories;
+    auto startTime = std::chrono::steady_clock::now();
+    grid.traceStreamlines(tracingSettings, trajectories);
+    auto endTime = std::chrono::steady_clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    size_t numPoints = 0;
+    for (const Trajectory& trajectory : trajectories) {
+        numPoints += trajectory.positions.size();
+    }
+    EXPECT_GT(numPoints, size_t(0));
+    std::cout
+            << "Tracing (" << modeName << "): " << trajectories.size() << " lines, " << numPoints << " points, "
+            << elapsedSeconds << "s, " << double(numPoints) / elapsedSeconds * 1e-6 << "M points/s, peak RSS "
+            << getPeakResidentSetSizeMiB() << " MiB" << std::endl;
+}
+
+/**
+ * Compares the tracing throughput and peak memory of dense and bricked storage. As the peak RSS of the process can only
+ * grow, the bricked mode is measured first.
+ */
+TEST_F(BrickedGridTest, DISABLED_DenseVsBrickedBenchmark) {
+    createDataSet(256, 256, 256);
+    size_t rawSizeMiB = dataField.size() * sizeof(float) / size_t(1024 * 1024);
+    std::cout << "Raw data set size: " << rawSizeMiB << " MiB, peak RSS before tracing: "
+              << getPeakResidentSetSizeMiB() << " MiB" << std::endl;
+    std::vector<float>().swap(dataField);
+    {
+        StreamlineTracingGrid grid;
+        grid.setGridExtent(xs, ys, zs, dx, dy, dz);
+        BrickedGridPtr brickedGrid = createBrickedGrid(32, size_t(64) * size_t(1024 * 1024));
+        grid.setBrickedGrid(brickedGrid);
+        traceAndReport("bricked, 64 MiB cache", grid);
+        std::cout << "Brick loads: " << brickedGrid->getNumBrickLoads() << ", evictions: "
+                  << brickedGrid->getNumBrickEvictions() << std::endl;
+    }
+    {
+        // Reload the data for the dense grid.
+        dataField.resize(size_t(xs) * size_t(ys) * size_t(zs) * 4);
+        std::ifstream file(filename, std::ios::binary);
+        file.read(reinterpret_cast<char*>(dataField.data()), std::streamsize(dataField.size() * sizeof(float)));
+        StreamlineTracingGrid grid;
+        addDenseFields(grid);
+        std::vector<float>().swap(dataField);
+        traceAndReport("dense", grid);
+    }
+}
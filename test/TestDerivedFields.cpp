@@ -0,0 +1,171 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+#include "LineData/Flow/Loader/GridLoader.hpp"
+
+/**
+ * Computes the derived fields once with the separate passes over the grid and once with the fused kernel.
+ */
+class DerivedFieldsTest : public ::testing::Test {
+protected:
+    void createVelocityField(int _xs, int _ys, int _zs) {
+        xs = _xs;
+        ys = _ys;
+        zs = _zs;
+        numPoints = size_t(xs) * size_t(ys) * size_t(zs);
+        std::mt19937 generator(17);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        velocityField.resize(numPoints * 3);
+        for (float& value : velocityField) {
+            value = distribution(generator);
+        }
+    }
+
+    void computeReferenceFields(bool normalizeVelocity, bool normalizeVorticity) {
+        velocityMagnitudeField.resize(numPoints);
+        vorticityField.resize(numPoints * 3);
+        vorticityMagnitudeField.resize(numPoints);
+        helicityField.resize(numPoints);
+        computeVectorMagnitudeField(velocityField.data(), velocityMagnitudeField.data(), xs, ys, zs);
+        computeVorticityField(velocityField.data(), vorticityField.data(), xs, ys, zs, dx, dy, dz);
+        computeVectorMagnitudeField(vorticityField.data(), vorticityMagnitudeField.data(), xs, ys, zs);
+        computeHelicityFieldNormalized(
+                velocityField.data(), vorticityField.data(), helicityField.data(), xs, ys, zs,
+                normalizeVelocity, normalizeVorticity);
+    }
+
+    static void expectFieldsEqual(const std::vector<float>& reference, const std::vector<float>& fused) {
+        ASSERT_EQ(reference.size(), fused.size());
+        for (size_t i = 0; i < reference.size(); i++) {
+            ASSERT_FLOAT_EQ(reference[i], fused[i]) << "Mismatch at index " << i << ".";
+        }
+    }
+
+    int xs = 0, ys = 0, zs = 0;
+    size_t numPoints = 0;
+    float dx = 0.1f, dy = 0.2f, dz = 0.3f;
+    std::vector<float> velocityField;
+    std::vector<float> velocityMagnitudeField, vorticityField, vorticityMagnitudeField, helicityField;
+};
+
+TEST_F(DerivedFieldsTest, MatchesSeparatePasses) {
+    // Grid sizes that are not multiples of the tile size and degenerate x extents.
+    const int gridSizes[][3] = { { 37, 21, 29 }, { 1, 5, 7 }, { 2, 33, 3 }, { 64, 16, 4 } };
+    for (const auto& gridSize : gridSizes) {
+        createVelocityField(gridSize[0], gridSize[1], gridSize[2]);
+        for (int normalizationMode = 0; normalizationMode < 4; normalizationMode++) {
+            bool normalizeVelocity = (normalizationMode & 1) != 0;
+            bool normalizeVorticity = (normalizationMode & 2) != 0;
+            computeReferenceFields(normalizeVelocity, normalizeVorticity);
+
+            std::vector<float> fusedVelocityMagnitude(numPoints), fusedVorticity(numPoints * 3);
+            std::vector<float> fusedVorticityMagnitude(numPoints), fusedHelicity(numPoints);
+            computeDerivedFields(
+                    velocityField.data(), fusedVelocityMagnitude.data(), fusedVorticity.data(),
+                    fusedVorticityMagnitude.data(), fusedHelicity.data(), xs, ys, zs, dx, dy, dz,
+                    normalizeVelocity, normalizeVorticity);
+            expectFieldsEqual(velocityMagnitudeField, fusedVelocityMagnitude);
+            expectFieldsEqual(vorticityField, fusedVorticity);
+            expectFieldsEqual(vorticityMagnitudeField, fusedVorticityMagnitude);
+            expectFieldsEqual(helicityField, fusedHelicity);
+        }
+    }
+}
+
+TEST_F(DerivedFieldsTest, SkipsUnselectedOutputs) {
+    createVelocityField(33, 18, 9);
+    computeReferenceFields(true, false);
+
+    // The helicity needs the vorticity internally even if the vorticity field itself is not requested.
+    std::vector<float> fusedHelicity(numPoints);
+    computeDerivedFields(
+            velocityField.data(), nullptr, nullptr, nullptr, fusedHelicity.data(), xs, ys, zs, dx, dy, dz,
+            true, false);
+    expectFieldsEqual(helicityField, fusedHelicity);
+
+    std::vector<float> fusedVelocityMagnitude(numPoints);
+    computeDerivedFields(
+            velocityField.data(), fusedVelocityMagnitude.data(), nullptr, nullptr, nullptr, xs, ys, zs, dx, dy, dz,
+            false, false);
+    expectFieldsEqual(velocityMagnitudeField, fusedVelocityMagnitude);
+
+    StreamlineTracingGrid grid;
+    grid.setGridExtent(xs, ys, zs, dx, dy, dz);
+    GridDataSetMetaData gridDataSetMetaData;
+    gridDataSetMetaData.derivedFields = DERIVED_FIELD_HELICITY;
+    auto* gridVelocityField = new float[numPoints * 3];
+    std::copy(velocityField.begin(), velocityField.end(), gridVelocityField);
+    addVelocityAndDerivedFields(&grid, gridVelocityField, xs, ys, zs, dx, dy, dz, gridDataSetMetaData);
+    EXPECT_EQ(grid.getVectorFieldNames(), std::vector<std::string>({ "Velocity" }));
+    EXPECT_EQ(grid.getScalarFieldNames(), std::vector<std::string>({ "Helicity" }));
+}
+
+TEST_F(DerivedFieldsTest, DISABLED_FusedVsSeparateBenchmark) {
+    createVelocityField(256, 256, 256);
+    const int numIterations = 3;
+    std::vector<float> fusedVelocityMagnitude(numPoints), fusedVorticity(numPoints * 3);
+    std::vector<float> fusedVorticityMagnitude(numPoints), fusedHelicity(numPoints);
+    // Touch all output pages once so that page faults are not measured.
+    computeReferenceFields(true, true);
+    computeDerivedFields(
+            velocityField.data(), fusedVelocityMagnitude.data(), fusedVorticity.data(),
+            fusedVorticityMagnitude.data(), fusedHelicity.data(), xs, ys, zs, dx, dy, dz, true, true);
+
+    auto startSeparate = std::chrono::steady_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        computeReferenceFields(true, true);
+    }
+    auto endSeparate = std::chrono::steady_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        computeDerivedFields(
+                velocityField.data(), fusedVelocityMagnitude.data(), fusedVorticity.data(),
+                fusedVorticityMagnitude.data(), fusedHelicity.data(), xs, ys, zs, dx, dy, dz, true, true);
+    }
+    auto endFused = std::chrono::steady_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        computeDerivedFields(
+                velocityField.data(), nullptr, nullptr, nullptr, fusedHelicity.data(), xs, ys, zs, dx, dy, dz,
+                true, true);
+    }
+    auto endHelicityOnly = std::chrono::steady_clock::now();
+
+    auto elapsedSeparate = std::chrono::duration_cast<std::chrono::milliseconds>(endSeparate - startSeparate);
+    auto elapsedFused = std::chrono::duration_cast<std::chrono::milliseconds>(endFused - endSeparate);
+    auto elapsedHelicityOnly = std::chrono::duration_cast<std::chrono::milliseconds>(endHelicityOnly - endFused);
+    std::cout << "Separate passes: " << elapsedSeparate.count() / numIterations << "ms" << std::endl;
+    std::cout << "Fused: " << elapsedFused.count() / numIterations << "ms" << std::endl;
+    std::cout << "Fused (helicity only): " << elapsedHelicityOnly.count() / numIterations << "ms" << std::endl;
+    expectFieldsEqual(helicityField, fusedHelicity);
+}
@@ -0,0 +1,225 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+#include "LineData/Flow/GridCache.hpp"
+#include "LineData/Flow/Loader/GridLoader.hpp"
+
+class GridCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        cacheDirectory = (std::filesystem::temp_directory_path() / "LineVisTestGridCache").string() + "/";
+        std::filesystem::remove_all(cacheDirectory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(cacheDirectory);
+    }
+
+    StreamlineTracingGridPtr createGrid(int xs, int ys, int zs, uint32_t seed) {
+        size_t numPoints = size_t(xs) * size_t(ys) * size_t(zs);
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        auto* velocityField = new float[numPoints * 3];
+        for (size_t i = 0; i < numPoints * 3; i++) {
+            velocityField[i] = distribution(generator);
+        }
+        auto grid = std::make_shared<StreamlineTracingGrid>();
+        grid->setGridExtent(xs, ys, zs, 0.1f, 0.2f, 0.3f);
+        GridDataSetMetaData gridDataSetMetaData;
+        addVelocityAndDerivedFields(grid.get(), velocityField, xs, ys, zs, 0.1f, 0.2f, 0.3f, gridDataSetMetaData);
+        return grid;
+    }
+
+    static void expectGridsEqual(const StreamlineTracingGrid& reference, const StreamlineTracingGrid& cached) {
+        ASSERT_EQ(reference.getGridSizeX(), cached.getGridSizeX());
+        ASSERT_EQ(reference.getGridSizeY(), cached.getGridSizeY());
+        ASSERT_EQ(reference.getGridSizeZ(), cached.getGridSizeZ());
+        EXPECT_EQ(reference.getDx(), cached.getDx());
+        EXPECT_EQ(reference.getDy(), cached.getDy());
+        EXPECT_EQ(reference.getDz(), cached.getDz());
+        EXPECT_EQ(reference.getMaxHelicityMagnitude(), cached.getMaxHelicityMagnitude());
+        size_t numPoints = size_t(reference.getGridSizeX()) * size_t(reference.getGridSizeY())
+                * size_t(reference.getGridSizeZ());
+        ASSERT_EQ(reference.getVectorFields().size(), cached.getVectorFields().size());
+        for (const auto& it : reference.getVectorFields()) {
+            auto itCached = cached.getVectorFields().find(it.first);
+            ASSERT_NE(itCached, cached.getVectorFields().end()) << "Missing vector field " << it.first << ".";
+            EXPECT_EQ(memcmp(it.second, itCached->second, numPoints * 3 * sizeof(float)), 0);
+            EXPECT_EQ(
+                    reference.getMaxVectorFieldMagnitude(it.first), cached.getMaxVectorFieldMagnitude(it.first));
+        }
+        ASSERT_EQ(reference.getScalarFields().size(), cached.getScalarFields().size());
+        for (const auto& it : reference.getScalarFields()) {
+            auto itCached = cached.getScalarFields().find(it.first);
+            ASSERT_NE(itCached, cached.getScalarFields().end()) << "Missing scalar field " << it.first << ".";
+            EXPECT_EQ(memcmp(it.second, itCached->second, numPoints * sizeof(float)), 0);
+        }
+    }
+
+    std::string cacheDirectory;
+};
+
+TEST_F(GridCacheTest, DiskRoundTrip) {
+    GridDataSetMetaData gridDataSetMetaData;
+    std::string key = GridCache::computeKey("grid.vti", gridDataSetMetaData, 1);
+    StreamlineTracingGridPtr grid = createGrid(23, 17, 11, 3);
+    {
+        GridCache gridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+        gridCache.insert(key, grid, true);
+        EXPECT_EQ(gridCache.find(key), grid);
+    }
+
+    // A new cache (e.g., after restarting the program) only finds the grid in the cache directory.
+    GridCache gridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+    StreamlineTracingGridPtr cachedGrid = gridCache.find(key);
+    ASSERT_TRUE(cachedGrid);
+    EXPECT_NE(cachedGrid, grid);
+    expectGridsEqual(*grid, *cachedGrid);
+
+    // Different loading options must not hit the cache entry.
+    gridDataSetMetaData.useNormalizedVelocity = true;
+    EXPECT_FALSE(gridCache.find(GridCache::computeKey("grid.vti", gridDataSetMetaData, 1)));
+    EXPECT_FALSE(gridCache.find(GridCache::computeKey("grid.vti", GridDataSetMetaData{}, 2)));
+}
+
+TEST(GridCacheKeyTest, BrickCacheBudgetIsNotPartOfKey) {
+    GridDataSetMetaData gridDataSetMetaData;
+    std::string key = GridCache::computeKey("grid.vti", gridDataSetMetaData, 1);
+    gridDataSetMetaData.brickCacheMemoryBudget *= 2;
+    EXPECT_EQ(GridCache::computeKey("grid.vti", gridDataSetMetaData, 1), key);
+    // The requester compares the metadata the same way to decide whether the loaded grid can be kept.
+    EXPECT_TRUE(gridDataSetMetaData == GridDataSetMetaData{});
+    gridDataSetMetaData.brickSize *= 2;
+    EXPECT_NE(GridCache::computeKey("grid.vti", gridDataSetMetaData, 1), key);
+    EXPECT_FALSE(gridDataSetMetaData == GridDataSetMetaData{});
+}
+
+TEST_F(GridCacheTest, MemoryBudgetEvictsLeastRecentlyUsed) {
+    StreamlineTracingGridPtr gridA = createGrid(16, 16, 16, 1);
+    StreamlineTracingGridPtr gridB = createGrid(16, 16, 16, 2);
+    StreamlineTracingGridPtr gridC = createGrid(16, 16, 16, 3);
+    size_t gridSize = gridA->getFieldsSizeInBytes();
+    GridCache gridCache(cacheDirectory, gridSize * 2);
+    gridCache.setUseDiskCache(false);
+    gridCache.insert("A", gridA, false);
+    gridCache.insert("B", gridB, false);
+    EXPECT_EQ(gridCache.find("A"), gridA);
+    gridCache.insert("C", gridC, false);
+    EXPECT_EQ(gridCache.getNumEntries(), size_t(2));
+    EXPECT_EQ(gridCache.getMemoryUsage(), gridSize * 2);
+    EXPECT_FALSE(gridCache.find("B"));
+    EXPECT_EQ(gridCache.find("A"), gridA);
+    EXPECT_EQ(gridCache.find("C"), gridC);
+
+    // The most recently used grid is kept even if it exceeds the budget on its own.
+    gridCache.setMemoryBudget(gridSize / 2);
+    EXPECT_EQ(gridCache.getNumEntries(), size_t(1));
+    EXPECT_EQ(gridCache.find("C"), gridC);
+}
+
+TEST_F(GridCacheTest, DiskBudgetEvictsLeastRecentlyUsedFiles) {
+    StreamlineTracingGridPtr grids[4];
+    std::string keys[4];
+    for (int i = 0; i < 4; i++) {
+        grids[i] = createGrid(16, 16, 16, uint32_t(i + 1));
+        keys[i] = GridCache::computeKey("grid" + std::to_string(i) + ".vti", GridDataSetMetaData{}, 1);
+    }
+    GridCache gridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+    for (int i = 0; i < 3; i++) {
+        gridCache.insert(keys[i], grids[i], true);
+    }
+    gridCache.waitForDiskWrite();
+    size_t fileSize = std::filesystem::file_size(gridCache.getCacheFilename(keys[0]));
+
+    // Order of the last use from old to new: 2, 0, 1.
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(gridCache.getCacheFilename(keys[2]), now - std::chrono::hours(3));
+    std::filesystem::last_write_time(gridCache.getCacheFilename(keys[0]), now - std::chrono::hours(2));
+    std::filesystem::last_write_time(gridCache.getCacheFilename(keys[1]), now - std::chrono::hours(1));
+
+    // A cache hit marks the file as recently used.
+    {
+        GridCache otherGridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+        ASSERT_TRUE(otherGridCache.find(keys[2]));
+    }
+    EXPECT_GT(std::filesystem::last_write_time(gridCache.getCacheFilename(keys[2])), now - std::chrono::minutes(1));
+
+    // Two files fit into the budget after the next write, so only the least recently used ones are kept.
+    gridCache.setDiskBudget(fileSize * 5 / 2);
+    gridCache.insert(keys[3], grids[3], true);
+    gridCache.waitForDiskWrite();
+    EXPECT_FALSE(std::filesystem::exists(gridCache.getCacheFilename(keys[0])));
+    EXPECT_FALSE(std::filesystem::exists(gridCache.getCacheFilename(keys[1])));
+    EXPECT_TRUE(std::filesystem::exists(gridCache.getCacheFilename(keys[2])));
+    EXPECT_TRUE(std::filesystem::exists(gridCache.getCacheFilename(keys[3])));
+
+    // The file just written is kept even if it exceeds the budget on its own.
+    gridCache.setDiskBudget(fileSize / 2);
+    gridCache.insert(keys[0], grids[0], true);
+    gridCache.waitForDiskWrite();
+    EXPECT_TRUE(std::filesystem::exists(gridCache.getCacheFilename(keys[0])));
+    EXPECT_FALSE(std::filesystem::exists(gridCache.getCacheFilename(keys[2])));
+    EXPECT_FALSE(std::filesystem::exists(gridCache.getCacheFilename(keys[3])));
+}
+
+TEST_F(GridCacheTest, DISABLED_LoadBenchmark) {
+    const int gridSize = 192;
+    GridDataSetMetaData gridDataSetMetaData;
+    std::string key = GridCache::computeKey("benchmark.vti", gridDataSetMetaData, 1);
+
+    auto startCompute = std::chrono::steady_clock::now();
+    StreamlineTracingGridPtr grid = createGrid(gridSize, gridSize, gridSize, 5);
+    auto endCompute = std::chrono::steady_clock::now();
+    {
+        GridCache gridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+        gridCache.insert(key, grid, true);
+    }
+    auto endWrite = std::chrono::steady_clock::now();
+    GridCache gridCache(cacheDirectory, size_t(1024) * size_t(1024 * 1024));
+    StreamlineTracingGridPtr cachedGrid = gridCache.find(key);
+    auto endRead = std::chrono::steady_clock::now();
+    ASSERT_TRUE(cachedGrid);
+
+    auto elapsedCompute = std::chrono::duration_cast<std::chrono::milliseconds>(endCompute - startCompute);
+    auto elapsedWrite = std::chrono::duration_cast<std::chrono::milliseconds>(endWrite - endCompute);
+    auto elapsedRead = std::chrono::duration_cast<std::chrono::microseconds>(endRead - endWrite);
+    std::cout << "Fields size: " << grid->getFieldsSizeInBytes() / size_t(1024 * 1024) << " MiB" << std::endl;
+    std::cout << "Random velocity + derived fields: " << elapsedCompute.count() << "ms" << std::endl;
+    std::cout << "Writing the cache file: " << elapsedWrite.count() << "ms" << std::endl;
+    std::cout << "Mapping the cache file: " << elapsedRead.count() << "us" << std::endl;
+    expectGridsEqual(*grid, *cachedGrid);
+}
@@ -0,0 +1,183 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include "Loaders/BinLinesLoader.hpp"
+#include "LineData/LineSimplification.hpp"
+#include "LineData/LineLodHierarchy.hpp"
+#include "LineTestData.hpp"
+
+TEST(LineLodHierarchyTest, LevelsMatchSimplification) {
+    // Every level needs to be identical to the Douglas-Peucker simplification with the error of the level.
+    TrajectoryStore trajectories = createHelixLines(50, 2000, 1e-4f, 3, true);
+    LineLodHierarchySettings settings;
+    settings.minError = 1e-4f;
+    settings.errorFactor = 2.0f;
+    settings.numLevels = 8;
+    LineLodHierarchy lineLodHierarchy;
+    lineLodHierarchy.build(trajectories, settings);
+    ASSERT_EQ(lineLodHierarchy.getNumLines(), trajectories.size());
+    ASSERT_EQ(lineLodHierarchy.getNumLevels(), settings.numLevels);
+    EXPECT_EQ(lineLodHierarchy.getLevelNumLinePoints().front(), trajectories.getNumLinePoints());
+
+    const std::vector<uint64_t>& lineOffsets = trajectories.getLineOffsets();
+    const std::vector<uint32_t>& linePointIndices = lineLodHierarchy.getLinePointIndices();
+    for (uint32_t level = 1; level < lineLodHierarchy.getNumLevels(); level++) {
+        LineSimplificationSettings simplificationSettings;
+        simplificationSettings.maxPositionError = lineLodHierarchy.getLevelErrors().at(level);
+        SimplifiedLines simplifiedLines;
+        simplifyLines(trajectories, simplificationSettings, simplifiedLines);
+        EXPECT_EQ(lineLodHierarchy.getLevelNumLinePoints().at(level), simplifiedLines.numLinePointsOut);
+        EXPECT_LE(lineLodHierarchy.getLevelNumLinePoints().at(level),
+                  lineLodHierarchy.getLevelNumLinePoints().at(level - 1));
+        for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+            ASSERT_EQ(size_t(lineLodHierarchy.getLineLevelNumPoints(lineIdx, level)),
+                      simplifiedLines.getLineNumPoints(lineIdx));
+            uint64_t indexOffset = lineLodHierarchy.getLineLevelIndexOffset(lineIdx, level);
+            for (size_t i = 0; i < simplifiedLines.getLineNumPoints(lineIdx); i++) {
+                ASSERT_EQ(linePointIndices.at(indexOffset + i),
+                          uint32_t(lineOffsets[lineIdx]) + simplifiedLines.getLinePointIndex(lineIdx, i));
+            }
+        }
+    }
+}
+
+TEST(LineLodHierarchyTest, SelectLevels) {
+    TrajectoryStore trajectories = createHelixLines(100, 1000, 1e-4f, 5, true);
+    LineLodHierarchySettings settings;
+    settings.minError = 1e-4f;
+    settings.numLevels = 10;
+    LineLodHierarchy lineLodHierarchy;
+    lineLodHierarchy.build(trajectories, settings);
+
+    LineLodViewParameters viewParameters;
+    viewParameters.fieldOfViewY = std::atan(1.0f) * 2.0f;
+    viewParameters.viewportHeight = 1080.0f;
+    size_t lastNumLinePoints = std::numeric_limits<size_t>::max();
+    for (float distance : { 2.0f, 10.0f, 100.0f }) {
+        viewParameters.cameraPosition = glm::vec3(0.0f, 0.0f, distance);
+        LineLodSelection selection;
+        lineLodHierarchy.selectLevels(viewParameters, 1.0f, 1.0f, selection);
+        ASSERT_EQ(selection.lineRanges.size(), trajectories.size());
+        EXPECT_EQ(selection.numLinePointsFinest, trajectories.getNumLinePoints());
+        EXPECT_LE(selection.numLinePoints, lastNumLinePoints);
+        lastNumLinePoints = selection.numLinePoints;
+
+        // The selected level needs to satisfy the pixel error.
+        float pixelsPerUnitLength =
+                viewParameters.viewportHeight / (2.0f * std::tan(0.5f * viewParameters.fieldOfViewY));
+        for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+            const LineLodRange& lineRange = selection.lineRanges.at(lineIdx);
+            ASSERT_EQ(lineRange.indexOffset, lineLodHierarchy.getLineLevelIndexOffset(lineIdx, lineRange.level));
+            ASSERT_EQ(lineRange.numIndices, lineLodHierarchy.getLineLevelNumPoints(lineIdx, lineRange.level));
+            float levelError = lineLodHierarchy.getLevelErrors().at(lineRange.level);
+            for (const glm::vec3& position : trajectories[lineIdx].positions) {
+                float pointDistance = glm::length(position - viewParameters.cameraPosition);
+                ASSERT_LE(levelError * pixelsPerUnitLength / pointDistance, 1.0001f);
+            }
+        }
+    }
+
+    // Only the most important (i.e., longest) lines are kept.
+    LineLodSelection selection;
+    lineLodHierarchy.selectLevels(viewParameters, 1.0f, 0.5f, selection);
+    const std::vector<uint32_t>& lineOrder = lineLodHierarchy.getLineOrder();
+    std::vector<float> lineArcLengths(trajectories.size(), 0.0f);
+    for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+        TrajectorySpan<const glm::vec3> positions = trajectories[lineIdx].positions;
+        for (size_t i = 1; i < positions.size(); i++) {
+            lineArcLengths[lineIdx] += glm::length(positions[i] - positions[i - 1]);
+        }
+    }
+    for (size_t rank = 0; rank < lineOrder.size(); rank++) {
+        size_t numSelectedIndices = selection.lineRanges.at(lineOrder.at(rank)).numIndices;
+        if (rank < lineOrder.size() / 2) {
+            EXPECT_GT(numSelectedIndices, 0u);
+        } else if (rank > lineOrder.size() / 2) {
+            EXPECT_EQ(numSelectedIndices, 0u);
+        }
+        if (rank > 0) {
+            EXPECT_GE(lineArcLengths.at(lineOrder.at(rank - 1)), lineArcLengths.at(lineOrder.at(rank)));
+        }
+    }
+}
+
+/**
+ * Prints the number of emitted line points for different camera distances. By default, synthetic lines are used. A
+ * .binlines file (e.g., converted from the NetCDF test data) can be passed in LINEVIS_LOD_BENCHMARK_FILE.
+ */
+TEST(LineLodHierarchyBenchmark, DISABLED_SelectLevels) {
+    TrajectoryStore trajectories;
+    const char* benchmarkFilename = std::getenv("LINEVIS_LOD_BENCHMARK_FILE");
+    if (benchmarkFilename) {
+        trajectories.setTrajectories(loadTrajectoriesFromBinLines(benchmarkFilename).trajectories);
+    } else {
+        trajectories = createHelixLines(2000, 5000, 1e-5f, 7, true);
+    }
+    ASSERT_FALSE(trajectories.empty());
+
+    glm::vec3 aabbMin(std::numeric_limits<float>::max());
+    glm::vec3 aabbMax(std::numeric_limits<float>::lowest());
+    for (const TrajectoryView& trajectory : trajectories) {
+        for (const glm::vec3& position : trajectory.positions) {
+            aabbMin = glm::min(aabbMin, position);
+            aabbMax = glm::max(aabbMax, position);
+        }
+    }
+    float diagonal = glm::length(aabbMax - aabbMin);
+
+    LineLodHierarchySettings settings;
+    settings.minError = 1e-5f * diagonal;
+    settings.numLevels = 12;
+    LineLodHierarchy lineLodHierarchy;
+    auto startTime = std::chrono::steady_clock::now();
+    lineLodHierarchy.build(trajectories, settings);
+    auto endTime = std::chrono::steady_clock::now();
+    std::cout << "Build time: " << std::chrono::duration<double>(endTime - startTime).count() * 1e3 << "ms, "
+              << lineLodHierarchy.getSizeInBytes() / (1024 * 1024) << "MiB" << std::endl;
+
+    LineLodViewParameters viewParameters;
+    viewParameters.fieldOfViewY = std::atan(1.0f) * 2.0f;
+    viewParameters.viewportHeight = 1080.0f;
+    const float pixelErrorBudget = 1.0f;
+    for (float distance : { 1.0f, 2.0f, 4.0f, 8.0f }) {
+        viewParameters.cameraPosition = 0.5f * (aabbMin + aabbMax) + glm::vec3(0.0f, 0.0f, distance * diagonal);
+        LineLodSelection selection;
+        startTime = std::chrono::steady_clock::now();
+        lineLodHierarchy.selectLevels(viewParameters, pixelErrorBudget, 1.0f, selection);
+        endTime = std::chrono::steady_clock::now();
+        std::cout << "Camera distance " << distance << " x diagonal, " << pixelErrorBudget << "px: "
+                  << selection.numLinePointsFinest << " -> " << selection.numLinePoints << " line points ("
+                  << std::chrono::duration<double>(endTime - startTime).count() * 1e3 << "ms)" << std::endl;
+    }
+}
@@ -0,0 +1,202 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include "LineData/LineSimplification.hpp"
+#include "LineData/LinePassGenerator.hpp"
+#include "LineTestData.hpp"
+
+static float getDistanceToSegment(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 segment = b - a;
+    float segmentLengthSq = glm::dot(segment, segment);
+    glm::vec3 diff = p - a;
+    if (segmentLengthSq > 0.0f) {
+        float t = std::clamp(glm::dot(diff, segment) / segmentLengthSq, 0.0f, 1.0f);
+        diff -= t * segment;
+    }
+    return glm::length(diff);
+}
+
+/**
+ * Checks that the kept points are consistent and that all removed points are within the error bounds of the
+ * simplified lines.
+ */
+static void validateSimplifiedLines(
+        const TrajectoryStore& trajectories, const LineSimplificationSettings& settings,
+        const SimplifiedLines& simplifiedLines) {
+    const std::vector<uint64_t>& lineOffsets = trajectories.getLineOffsets();
+    ASSERT_EQ(simplifiedLines.keepLinePoints.size(), trajectories.getNumLinePoints());
+    ASSERT_EQ(simplifiedLines.lineOffsets.size(), trajectories.size() + 1);
+    ASSERT_EQ(simplifiedLines.numLinePointsIn, trajectories.getNumLinePoints());
+    ASSERT_EQ(simplifiedLines.numLinePointsOut, simplifiedLines.linePointIndices.size());
+    size_t numLineSegmentsOut = 0;
+    for (size_t lineIdx = 0; lineIdx < trajectories.size(); lineIdx++) {
+        TrajectoryView trajectory = trajectories[lineIdx];
+        size_t numPoints = trajectory.positions.size();
+        size_t numKeptPoints = simplifiedLines.getLineNumPoints(lineIdx);
+        if (numPoints == 0) {
+            ASSERT_EQ(numKeptPoints, size_t(0));
+            continue;
+        }
+        numLineSegmentsOut += numKeptPoints - 1;
+        ASSERT_GE(numKeptPoints, std::min(numPoints, size_t(2)));
+        ASSERT_EQ(simplifiedLines.getLinePointIndex(lineIdx, 0), 0u);
+        ASSERT_EQ(simplifiedLines.getLinePointIndex(lineIdx, numKeptPoints - 1), uint32_t(numPoints - 1));
+
+        // The arc length is used for interpolating the attributes.
+        std::vector<float> arcLengths(numPoints, 0.0f);
+        for (size_t i = 1; i < numPoints; i++) {
+            arcLengths[i] = arcLengths[i - 1] + glm::length(trajectory.positions[i] - trajectory.positions[i - 1]);
+        }
+
+        for (size_t j = 0; j + 1 < numKeptPoints; j++) {
+            uint32_t startIdx = simplifiedLines.getLinePointIndex(lineIdx, j);
+            uint32_t endIdx = simplifiedLines.getLinePointIndex(lineIdx, j + 1);
+            ASSERT_LT(startIdx, endIdx);
+            ASSERT_TRUE(simplifiedLines.keepLinePoints[lineOffsets[lineIdx] + startIdx]);
+            for (uint32_t i = startIdx + 1; i < endIdx; i++) {
+                ASSERT_FALSE(simplifiedLines.keepLinePoints[lineOffsets[lineIdx] + i]);
+                float distance = getDistanceToSegment(
+                        trajectory.positions[i], trajectory.positions[startIdx], trajectory.positions[endIdx]);
+                ASSERT_LE(distance, settings.maxPositionError * 1.0001f);
+                float arcLength = arcLengths[endIdx] - arcLengths[startIdx];
+                float w = arcLength > 0.0f ? (arcLengths[i] - arcLengths[startIdx]) / arcLength : 0.5f;
+                for (size_t k = 0; k < settings.attributeIndices.size(); k++) {
+                    TrajectorySpan<const float> values = trajectory.attributes[settings.attributeIndices[k]];
+                    float interpolatedValue = values[startIdx] + w * (values[endIdx] - values[startIdx]);
+                    ASSERT_LE(std::abs(values[i] - interpolatedValue), settings.maxAttributeErrors[k] * 1.0001f);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(simplifiedLines.numLineSegmentsOut, numLineSegmentsOut);
+}
+
+TEST(LineSimplificationTest, StraightLine) {
+    TrajectoryStore trajectories;
+    Trajectory trajectory;
+    trajectory.attributes.resize(1);
+    for (int i = 0; i < 1000; i++) {
+        trajectory.positions.emplace_back(float(i) * 0.001f, 0.5f, 0.0f);
+        trajectory.attributes.at(0).push_back(float(i));
+    }
+    trajectories.pushBack(trajectory);
+
+    LineSimplificationSettings settings;
+    settings.maxPositionError = 1e-4f;
+    settings.attributeIndices = { 0 };
+    settings.maxAttributeErrors = { 1e-2f };
+    SimplifiedLines simplifiedLines;
+    simplifyLines(trajectories, settings, simplifiedLines);
+    EXPECT_EQ(simplifiedLines.numLinePointsOut, size_t(2));
+    validateSimplifiedLines(trajectories, settings, simplifiedLines);
+}
+
+TEST(LineSimplificationTest, ErrorBounds) {
+    TrajectoryStore trajectories = createHelixLines(100, 2000, 1e-4f, 3);
+    for (float maxPositionError : { 0.0f, 1e-4f, 1e-3f, 1e-2f }) {
+        for (float maxAttributeError : { 1e-3f, 1e-1f }) {
+            LineSimplificationSettings settings;
+            settings.maxPositionError = maxPositionError;
+            settings.attributeIndices = { 0, 1 };
+            settings.maxAttributeErrors = { maxAttributeError, maxAttributeError };
+            SimplifiedLines simplifiedLines;
+            simplifyLines(trajectories, settings, simplifiedLines);
+            validateSimplifiedLines(trajectories, settings, simplifiedLines);
+            if (maxPositionError > 0.0f) {
+                EXPECT_LT(simplifiedLines.numLinePointsOut, simplifiedLines.numLinePointsIn);
+            }
+        }
+    }
+}
+
+TEST(LineSimplificationTest, ShortLines) {
+    TrajectoryStore trajectories;
+    for (size_t numPoints = 0; numPoints < 4; numPoints++) {
+        Trajectory trajectory;
+        trajectory.attributes.resize(1);
+        for (size_t i = 0; i < numPoints; i++) {
+            trajectory.positions.emplace_back(float(i), 0.0f, 0.0f);
+            trajectory.attributes.at(0).push_back(0.0f);
+        }
+        trajectories.pushBack(trajectory);
+    }
+    LineSimplificationSettings settings;
+    settings.maxPositionError = 0.1f;
+    SimplifiedLines simplifiedLines;
+    simplifyLines(trajectories, settings, simplifiedLines);
+    validateSimplifiedLines(trajectories, settings, simplifiedLines);
+    EXPECT_EQ(simplifiedLines.numLinePointsOut, size_t(0 + 1 + 2 + 2));
+}
+
+TEST(LineSimplificationTest, LinePassLineRanges) {
+    // The line pass renderers only generate the kept points.
+    TrajectoryStore trajectories = createHelixLines(100, 2000, 0.0f, 5);
+    LineSimplificationSettings settings;
+    settings.maxPositionError = 1e-3f;
+    settings.attributeIndices = { 0 };
+    settings.maxAttributeErrors = { 1e-2f };
+    SimplifiedLines simplifiedLines;
+    simplifyLines(trajectories, settings, simplifiedLines);
+
+    LinePassLineRanges lineRanges;
+    computeLinePassLineRanges(trajectories, {}, 0, 0, lineRanges, simplifiedLines.keepLinePoints.data());
+    EXPECT_EQ(size_t(lineRanges.numLinePoints), simplifiedLines.numLinePointsOut);
+    EXPECT_EQ(size_t(lineRanges.numSegments), simplifiedLines.numLineSegmentsOut);
+
+    std::vector<uint32_t> linePointIndices(lineRanges.numLinePoints);
+    generateLinePassLinePoints(
+            trajectories, lineRanges, nullptr,
+            [&](size_t /*lineIdx*/, size_t pointIdx, uint32_t linePointIdx, const LinePassLineRange& /*lineRange*/,
+                    const glm::vec3& /*normal*/, const glm::vec3& /*tangent*/) {
+                linePointIndices.at(linePointIdx) = uint32_t(pointIdx);
+            });
+    EXPECT_EQ(linePointIndices, simplifiedLines.linePointIndices);
+}
+
+TEST(LineSimplificationBenchmark, DISABLED_HelixLines) {
+    TrajectoryStore trajectories = createHelixLines(2000, 5000, 1e-5f, 7);
+    LineSimplificationSettings settings;
+    settings.maxPositionError = 1e-3f;
+    settings.attributeIndices = { 0 };
+    settings.maxAttributeErrors = { 1e-2f };
+    SimplifiedLines simplifiedLines;
+    auto startTime = std::chrono::steady_clock::now();
+    simplifyLines(trajectories, settings, simplifiedLines);
+    auto endTime = std::chrono::steady_clock::now();
+    double elapsedMs = std::chrono::duration<double>(endTime - startTime).count() * 1e3;
+    std::cout << "Simplification time: " << elapsedMs << "ms" << std::endl;
+    std::cout << "Line points: " << simplifiedLines.numLinePointsIn << " -> " << simplifiedLines.numLinePointsOut
+              << std::endl;
+    std::cout << "Line segments: " << simplifiedLines.numLineSegmentsIn << " -> "
+              << simplifiedLines.numLineSegmentsOut << std::endl;
+}
@@ -0,0 +1,324 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <chrono>
+#include <limits>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <gtest/gtest.h>
+
+#include "Renderers/Tubes/Tubes.hpp"
+#include "LineData/TrianglePayload/MeshletBuilder.hpp"
+
+struct MeshletTestMesh {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    std::vector<LinePointDataUnified> linePointDataList;
+};
+
+struct MeshletTaskMeshShaderData {
+    std::vector<MeshletTaskMeskShaderPayloadData> meshlets;
+    std::vector<glm::vec3> dedupVertices;
+    std::vector<uint32_t> dedupVertexIndexToOrigIndexMap;
+    std::vector<uint8_t> dedupTriangleIndices;
+};
+
+template<class T>
+static void expectBitwiseEqual(const std::vector<T>& reference, const std::vector<T>& parallel, const char* name) {
+    ASSERT_EQ(reference.size(), parallel.size()) << "Size mismatch in " << name << ".";
+    for (size_t i = 0; i < reference.size(); i++) {
+        ASSERT_EQ(std::memcmp(&reference[i], &parallel[i], sizeof(T)), 0)
+                << "Mismatch in " << name << " at index " << i << ".";
+    }
+}
+
+static uint32_t getLineIndexReference(const MeshletTestMesh& mesh, const TubeTriangleVertexData& vertex) {
+    if (mesh.linePointDataList.empty()) {
+        return 0;
+    }
+    return mesh.linePointDataList.at(vertex.vertexLinePointIndex & 0x7FFFFFFFu).lineStartIndex;
+}
+
+/// Sequential reference implementation of the meshlet packing of MeshletsDrawIndirectPayload.
+static void buildMeshletsDrawIndirectReference(
+        const MeshletTestMesh& mesh, uint32_t maxNumPrimitivesPerMeshlet,
+        std::vector<MeshletDrawIndirectPayloadData>& meshlets) {
+    MeshletDrawIndirectPayloadData currentMeshlet{};
+    glm::vec3 aabbMin(std::numeric_limits<float>::max()), aabbMax(std::numeric_limits<float>::lowest());
+    uint32_t currentLineIdx = 0;
+    for (size_t primitiveIdx = 0; primitiveIdx < mesh.triangleIndices.size(); primitiveIdx += 3) {
+        uint32_t l0 = getLineIndexReference(
+                mesh, mesh.vertexDataList.at(mesh.triangleIndices.at(primitiveIdx)));
+        if (currentMeshlet.indexCount >= maxNumPrimitivesPerMeshlet * 3
+                || (currentLineIdx != l0 && currentMeshlet.indexCount > 0)) {
+            currentMeshlet.worldSpaceAabbMin = aabbMin;
+            currentMeshlet.worldSpaceAabbMax = aabbMax;
+            meshlets.push_back(currentMeshlet);
+            aabbMin = glm::vec3(std::numeric_limits<float>::max());
+            aabbMax = glm::vec3(std::numeric_limits<float>::lowest());
+            currentMeshlet = {};
+            currentMeshlet.firstIndex = uint32_t(primitiveIdx);
+        }
+        currentLineIdx = l0;
+        for (size_t i = 0; i < 3; i++) {
+            const glm::vec3& position = mesh.vertexDataList.at(mesh.triangleIndices.at(primitiveIdx + i)).vertexPosition;
+            aabbMin = glm::min(aabbMin, position);
+            aabbMax = glm::max(aabbMax, position);
+        }
+        currentMeshlet.indexCount += 3;
+    }
+    if (currentMeshlet.indexCount > 0) {
+        currentMeshlet.worldSpaceAabbMin = aabbMin;
+        currentMeshlet.worldSpaceAabbMax = aabbMax;
+        meshlets.push_back(currentMeshlet);
+    }
+}
+
+/// Sequential reference implementation of the meshlet packing of MeshletsTaskMeshShaderPayload.
+static void buildMeshletsTaskMeshShaderReference(
+        const MeshletTestMesh& mesh, uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet,
+        MeshletTaskMeshShaderData& data) {
+    MeshletTaskMeskShaderPayloadData currentMeshlet{};
+    std::unordered_map<uint32_t, uint8_t> currentMeshletIndices;
+    glm::vec3 aabbMin(std::numeric_limits<float>::max()), aabbMax(std::numeric_limits<float>::lowest());
+    uint32_t currentLineIdx = 0;
+    for (size_t primitiveIdx = 0; primitiveIdx < mesh.triangleIndices.size(); primitiveIdx += 3) {
+        uint32_t indices[3];
+        bool isNew[3];
+        uint32_t currentNumVertices = currentMeshlet.vertexCount;
+        for (size_t i = 0; i < 3; i++) {
+            indices[i] = mesh.triangleIndices.at(primitiveIdx + i);
+            isNew[i] = currentMeshletIndices.find(indices[i]) == currentMeshletIndices.end();
+            if (isNew[i]) {
+                currentNumVertices++;
+            }
+        }
+        uint32_t l0 = getLineIndexReference(mesh, mesh.vertexDataList.at(indices[0]));
+        if (currentMeshlet.primitiveCount + 1 > maxNumPrimitivesPerMeshlet
+                || currentNumVertices > maxNumVerticesPerMeshlet
+                || (currentLineIdx != l0 && currentMeshlet.primitiveCount > 0)) {
+            currentMeshlet.worldSpaceAabbMin = aabbMin;
+            currentMeshlet.worldSpaceAabbMax = aabbMax;
+            data.meshlets.push_back(currentMeshlet);
+            aabbMin = glm::vec3(std::numeric_limits<float>::max());
+            aabbMax = glm::vec3(std::numeric_limits<float>::lowest());
+            currentMeshletIndices.clear();
+            currentMeshlet = {};
+            currentMeshlet.meshletFirstPrimitiveIdx = uint32_t(primitiveIdx / 3);
+            currentMeshlet.vertexStart = uint32_t(data.dedupVertexIndexToOrigIndexMap.size());
+            currentMeshlet.primitiveStart = uint32_t(data.dedupTriangleIndices.size() / 3);
+        }
+        currentLineIdx = l0;
+        for (size_t i = 0; i < 3; i++) {
+            const glm::vec3& position = mesh.vertexDataList.at(indices[i]).vertexPosition;
+            auto it = currentMeshletIndices.find(indices[i]);
+            if (currentMeshlet.primitiveCount == 0 || isNew[i]) {
+                data.dedupVertices.push_back(position);
+                data.dedupVertexIndexToOrigIndexMap.push_back(indices[i]);
+                data.dedupTriangleIndices.push_back(uint8_t(currentMeshlet.vertexCount));
+                currentMeshletIndices.insert(std::make_pair(indices[i], uint8_t(currentMeshlet.vertexCount)));
+                currentMeshlet.vertexCount++;
+            } else {
+                data.dedupTriangleIndices.push_back(it->second);
+            }
+            aabbMin = glm::min(aabbMin, position);
+            aabbMax = glm::max(aabbMax, position);
+        }
+        currentMeshlet.primitiveCount++;
+    }
+    if (currentMeshlet.primitiveCount > 0) {
+        currentMeshlet.worldSpaceAabbMin = aabbMin;
+        currentMeshlet.worldSpaceAabbMax = aabbMax;
+        data.meshlets.push_back(currentMeshlet);
+    }
+}
+
+/**
+ * Compares the parallel meshlet builders with the sequential reference implementations on tube meshes.
+ */
+class MeshletBuilderTest : public ::testing::TestWithParam<bool> {
+protected:
+    /**
+     * Creates a tube mesh of random lines. Empty lines and lines with a single point produce no triangles.
+     */
+    static void createMesh(
+            size_t numLines, int maxNumLinePoints, int numSubdivisions, bool capped, uint32_t seed,
+            MeshletTestMesh& mesh) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> positionDistribution(-1.0f, 1.0f);
+        std::uniform_int_distribution<int> numPointsDistribution(0, maxNumLinePoints);
+        std::vector<std::vector<glm::vec3>> lineCentersList(numLines);
+        for (std::vector<glm::vec3>& lineCenters : lineCentersList) {
+            int numPoints = numPointsDistribution(generator);
+            glm::vec3 position(
+                    positionDistribution(generator), positionDistribution(generator),
+                    positionDistribution(generator));
+            for (int i = 0; i < numPoints; i++) {
+                position += 0.05f * glm::vec3(
+                        positionDistribution(generator), positionDistribution(generator),
+                        positionDistribution(generator));
+                lineCenters.push_back(position);
+            }
+        }
+
+        std::vector<LinePointReference> linePointReferences;
+        std::vector<glm::vec3> lineTangents, lineNormals;
+        if (capped) {
+            createCappedTriangleTubesRenderDataCPUParallel(
+                    lineCentersList, 0.01f, numSubdivisions, false, mesh.triangleIndices, mesh.vertexDataList,
+                    linePointReferences, 0, lineTangents, lineNormals);
+        } else {
+            createTriangleTubesRenderDataCPUParallel(
+                    lineCentersList, 0.01f, numSubdivisions, mesh.triangleIndices, mesh.vertexDataList,
+                    linePointReferences, 0, lineTangents, lineNormals);
+        }
+
+        // Same line start index convention as used by LineDataFlow.
+        mesh.linePointDataList.resize(linePointReferences.size());
+        uint32_t lineStartIndex = 0;
+        for (size_t i = 0; i < linePointReferences.size(); i++) {
+            if (i == 0 || linePointReferences[i].trajectoryIndex != linePointReferences[i - 1].trajectoryIndex) {
+                lineStartIndex = uint32_t(i);
+            }
+            mesh.linePointDataList[i].lineStartIndex = lineStartIndex;
+        }
+    }
+
+    static void compareDrawIndirect(const MeshletTestMesh& mesh, uint32_t maxNumPrimitivesPerMeshlet) {
+        std::vector<MeshletDrawIndirectPayloadData> reference, parallel;
+        buildMeshletsDrawIndirectReference(mesh, maxNumPrimitivesPerMeshlet, reference);
+        buildMeshletsDrawIndirect(
+                mesh.triangleIndices, mesh.vertexDataList, mesh.linePointDataList, maxNumPrimitivesPerMeshlet,
+                parallel);
+        expectBitwiseEqual(reference, parallel, "meshlets");
+    }
+
+    static void compareTaskMeshShader(
+            const MeshletTestMesh& mesh, uint32_t maxNumPrimitivesPerMeshlet, uint32_t maxNumVerticesPerMeshlet) {
+        MeshletTaskMeshShaderData reference, parallel;
+        buildMeshletsTaskMeshShaderReference(mesh, maxNumPrimitivesPerMeshlet, maxNumVerticesPerMeshlet, reference);
+        buildMeshletsTaskMeshShader(
+                mesh.triangleIndices, mesh.vertexDataList, mesh.linePointDataList,
+                maxNumPrimitivesPerMeshlet, maxNumVerticesPerMeshlet, parallel.meshlets, parallel.dedupVertices,
+                parallel.dedupVertexIndexToOrigIndexMap, parallel.dedupTriangleIndices);
+        expectBitwiseEqual(reference.meshlets, parallel.meshlets, "meshlets");
+        expectBitwiseEqual(reference.dedupVertices, parallel.dedupVertices, "dedupVertices");
+        expectBitwiseEqual(
+                reference.dedupVertexIndexToOrigIndexMap, parallel.dedupVertexIndexToOrigIndexMap,
+                "dedupVertexIndexToOrigIndexMap");
+        expectBitwiseEqual(reference.dedupTriangleIndices, parallel.dedupTriangleIndices, "dedupTriangleIndices");
+    }
+};
+
+TEST_P(MeshletBuilderTest, DrawIndirectMatchesSequential) {
+    MeshletTestMesh mesh;
+    createMesh(300, 120, 6, GetParam(), 17, mesh);
+    for (uint32_t maxNumPrimitivesPerMeshlet : { 1u, 32u, 128u, 1000u }) {
+        compareDrawIndirect(mesh, maxNumPrimitivesPerMeshlet);
+    }
+}
+
+TEST_P(MeshletBuilderTest, TaskMeshShaderMatchesSequential) {
+    MeshletTestMesh mesh;
+    createMesh(300, 120, 6, GetParam(), 23, mesh);
+    compareTaskMeshShader(mesh, 126, 64);
+    compareTaskMeshShader(mesh, 24, 18);
+    compareTaskMeshShader(mesh, 512, 256);
+    compareTaskMeshShader(mesh, 1, 3);
+}
+
+TEST_P(MeshletBuilderTest, WithoutLinePointData) {
+    // Without line point data, all triangles belong to the same line.
+    MeshletTestMesh mesh;
+    createMesh(50, 40, 5, GetParam(), 29, mesh);
+    mesh.linePointDataList.clear();
+    compareDrawIndirect(mesh, 128);
+    compareTaskMeshShader(mesh, 126, 64);
+}
+
+TEST_P(MeshletBuilderTest, EmptyInput) {
+    MeshletTestMesh mesh;
+    compareDrawIndirect(mesh, 128);
+    compareTaskMeshShader(mesh, 126, 64);
+}
+
+INSTANTIATE_TEST_SUITE_P(CappedTubes, MeshletBuilderTest, ::testing::Values(false, true));
+
+class MeshletBuilderBenchmark : public MeshletBuilderTest {
+protected:
+    static void runBenchmark(size_t numLines, int numLinePoints, int numSubdivisions) {
+        MeshletTestMesh mesh;
+        createMesh(numLines, numLinePoints, numSubdivisions, false, 5, mesh);
+        std::cout << "Meshlet builder benchmark: " << mesh.triangleIndices.size() / 3 << " triangles" << std::endl;
+
+        double elapsedSeconds[2] = { 0.0, 0.0 };
+        for (int parallel = 0; parallel < 2; parallel++) {
+            MeshletTaskMeshShaderData data;
+            auto startTime = std::chrono::steady_clock::now();
+            if (parallel) {
+                buildMeshletsTaskMeshShader(
+                        mesh.triangleIndices, mesh.vertexDataList, mesh.linePointDataList, 126, 64,
+                        data.meshlets, data.dedupVertices, data.dedupVertexIndexToOrigIndexMap,
+                        data.dedupTriangleIndices);
+            } else {
+                buildMeshletsTaskMeshShaderReference(mesh, 126, 64, data);
+            }
+            auto endTime = std::chrono::steady_clock::now();
+            elapsedSeconds[parallel] = std::chrono::duration<double>(endTime - startTime).count();
+        }
+        std::cout << "Task/mesh shader meshlets (sequential): " << elapsedSeconds[0] * 1e3 << "ms" << std::endl;
+        std::cout << "Task/mesh shader meshlets (parallel): " << elapsedSeconds[1] * 1e3 << "ms" << std::endl;
+
+        for (int parallel = 0; parallel < 2; parallel++) {
+            std::vector<MeshletDrawIndirectPayloadData> meshlets;
+            auto startTime = std::chrono::steady_clock::now();
+            if (parallel) {
+                buildMeshletsDrawIndirect(
+                        mesh.triangleIndices, mesh.vertexDataList, mesh.linePointDataList, 128, meshlets);
+            } else {
+                buildMeshletsDrawIndirectReference(mesh, 128, meshlets);
+            }
+            auto endTime = std::chrono::steady_clock::now();
+            elapsedSeconds[parallel] = std::chrono::duration<double>(endTime - startTime).count();
+        }
+        std::cout << "Draw indirect meshlets (sequential): " << elapsedSeconds[0] * 1e3 << "ms" << std::endl;
+        std::cout << "Draw indirect meshlets (parallel): " << elapsedSeconds[1] * 1e3 << "ms" << std::endl;
+    }
+};
+
+TEST_F(MeshletBuilderBenchmark, DISABLED_SequentialVsParallel) {
+    // Approximately 10M triangles.
+    runBenchmark(5000, 250, 8);
+}
+
+// Approximately 100M triangles (~5GiB of memory).
+TEST_F(MeshletBuilderBenchmark, DISABLED_SequentialVsParallelLarge) {
+    runBenchmark(50000, 250, 8);
+}
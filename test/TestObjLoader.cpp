@@ -0,0 +1,192 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include "Loaders/ObjLoader.hpp"
+
+/**
+ * Writes a synthetic .obj line file with positions, two vertex attributes and "l" commands. Some lines reference a
+ * vertex with a large invalid value, which both loaders need to skip.
+ */
+class ObjLoaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filename = (std::filesystem::temp_directory_path() / "LineVisTestObjLoader.obj").string();
+        std::ofstream file(filename, std::ios::binary);
+        ASSERT_TRUE(file.is_open());
+
+        std::default_random_engine generator(12345);
+        std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+        file << "# Synthetic test data\n";
+        file << "a attribute0 attribute1\n";
+        for (int i = 0; i < numLines * numLinePoints; i++) {
+            file << "v " << distribution(generator) << " " << distribution(generator) << " "
+                 << distribution(generator) * 1e-3f << (i % 2 == 0 ? "\r\n" : "\n");
+            file << "vt " << distribution(generator) << " " << distribution(generator) << "\n";
+        }
+        file << "v 1e20 0 0\n";
+        file << "vt 0 0\n";
+        for (int lineIdx = 0; lineIdx < numLines; lineIdx++) {
+            file << "g line" << lineIdx << "\nl";
+            for (int pointIdx = 0; pointIdx < numLinePoints; pointIdx++) {
+                file << " " << (lineIdx * numLinePoints + pointIdx + 1);
+            }
+            if (lineIdx % 7 == 0) {
+                file << " " << (numLines * numLinePoints + 1);
+            }
+            file << "\n";
+        }
+        file.close();
+        fileSize = std::filesystem::file_size(filename);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(filename);
+    }
+
+    const int numLines = 10000;
+    const int numLinePoints = 32;
+    std::string filename;
+    size_t fileSize = 0;
+};
+
+static void expectTrajectoriesEqual(
+        const Trajectories& trajectoriesSequential, const Trajectories& trajectoriesParallel) {
+    ASSERT_EQ(trajectoriesSequential.size(), trajectoriesParallel.size());
+    for (size_t lineIdx = 0; lineIdx < trajectoriesSequential.size(); lineIdx++) {
+        const Trajectory& trajectorySequential = trajectoriesSequential.at(lineIdx);
+        const Trajectory& trajectoryParallel = trajectoriesParallel.at(lineIdx);
+        ASSERT_EQ(trajectorySequential.positions.size(), trajectoryParallel.positions.size());
+        ASSERT_EQ(trajectorySequential.attributes.size(), trajectoryParallel.attributes.size());
+        for (size_t pointIdx = 0; pointIdx < trajectorySequential.positions.size(); pointIdx++) {
+            for (int c = 0; c < 3; c++) {
+                EXPECT_FLOAT_EQ(
+                        trajectorySequential.positions.at(pointIdx)[c], trajectoryParallel.positions.at(pointIdx)[c]);
+            }
+            for (size_t attrIdx = 0; attrIdx < trajectorySequential.attributes.size(); attrIdx++) {
+                EXPECT_FLOAT_EQ(
+                        trajectorySequential.attributes.at(attrIdx).at(pointIdx),
+                        trajectoryParallel.attributes.at(attrIdx).at(pointIdx));
+            }
+        }
+    }
+}
+
+TEST_F(ObjLoaderTest, ParallelMatchesSequential) {
+    std::vector<std::string> attributeNamesSequential, attributeNamesParallel;
+    Trajectories trajectoriesSequential = loadTrajectoriesFromObjSequential(filename, attributeNamesSequential);
+    Trajectories trajectoriesParallel = loadTrajectoriesFromObj(filename, attributeNamesParallel);
+
+    ASSERT_EQ(attributeNamesSequential, attributeNamesParallel);
+    for (const Trajectory& trajectory : trajectoriesSequential) {
+        ASSERT_EQ(trajectory.positions.size(), size_t(numLinePoints));
+    }
+    expectTrajectoriesEqual(trajectoriesSequential, trajectoriesParallel);
+}
+
+/**
+ * Files with LF, CRLF and CR-only line endings need to give the same lines as the sequential loader. The files span
+ * several chunks, so the chunk boundaries also need to be found at '\r'.
+ */
+TEST(ObjLoaderLineEndingTest, LineEndingsMatchSequential) {
+    const int numLines = 2000;
+    const int numLinePoints = 32;
+    std::string filename = (std::filesystem::temp_directory_path() / "LineVisTestObjLoaderLineEndings.obj").string();
+    for (const std::string lineEnding : { "\n", "\r\n", "\r" }) {
+        {
+            std::ofstream file(filename, std::ios::binary);
+            ASSERT_TRUE(file.is_open());
+            std::default_random_engine generator(54321);
+            std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+            file << "a attribute0" << lineEnding;
+            for (int i = 0; i < numLines * numLinePoints; i++) {
+                file << "v " << distribution(generator) << " " << distribution(generator) << " "
+                     << distribution(generator) << lineEnding;
+                file << "vt " << distribution(generator) << lineEnding;
+            }
+            for (int lineIdx = 0; lineIdx < numLines; lineIdx++) {
+                file << "g line" << lineIdx << lineEnding << "l";
+                for (int pointIdx = 0; pointIdx < numLinePoints; pointIdx++) {
+                    file << " " << (lineIdx * numLinePoints + pointIdx + 1);
+                }
+                file << lineEnding;
+            }
+        }
+        std::vector<std::string> attributeNamesSequential, attributeNamesParallel;
+        Trajectories trajectoriesSequential = loadTrajectoriesFromObjSequential(filename, attributeNamesSequential);
+        Trajectories trajectoriesParallel = loadTrajectoriesFromObj(filename, attributeNamesParallel);
+        std::filesystem::remove(filename);
+
+        SCOPED_TRACE("Line ending " + std::string(lineEnding == "\n" ? "LF" : lineEnding == "\r" ? "CR" : "CRLF"));
+        ASSERT_EQ(attributeNamesSequential, attributeNamesParallel);
+        ASSERT_EQ(trajectoriesSequential.size(), size_t(numLines));
+        expectTrajectoriesEqual(trajectoriesSequential, trajectoriesParallel);
+    }
+}
+
+TEST_F(ObjLoaderTest, DISABLED_Throughput) {
+    typedef std::function<Trajectories(const std::string&, std::vector<std::string>&)> ObjLoaderFunction;
+    auto measureThroughput = [this](const ObjLoaderFunction& loader) {
+        std::vector<std::string> attributeNames;
+        auto startTime = std::chrono::steady_clock::now();
+        Trajectories trajectories = loader(filename, attributeNames);
+        auto endTime = std::chrono::steady_clock::now();
+        EXPECT_EQ(trajectories.size(), size_t(numLines));
+        double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+        return double(fileSize) * 1e-6 / elapsedSeconds;
+    };
+
+    double throughputSequential = measureThroughput(loadTrajectoriesFromObjSequential);
+    double throughputParallel = measureThroughput(loadTrajectoriesFromObj);
+    std::cout << "OBJ loader throughput (sequential): " << throughputSequential << " MB/s" << std::endl;
+    std::cout << "OBJ loader throughput (parallel): " << throughputParallel << " MB/s" << std::endl;
+}
+
+TEST(ObjLoaderIndexTest, OverflowingIndicesAreSkipped) {
+    std::string filename = (std::filesystem::temp_directory_path() / "LineVisTestObjLoaderOverflow.obj").string();
+    {
+        std::ofstream file(filename, std::ios::binary);
+        ASSERT_TRUE(file.is_open());
+        file << "v 0 0 0\nv 1 0 0\nv 2 0 0\n";
+        file << "l 1 2 4294967296 99999999999999999999999999 3\n";
+    }
+    std::vector<std::string> attributeNames;
+    Trajectories trajectories = loadTrajectoriesFromObj(filename, attributeNames);
+    std::filesystem::remove(filename);
+
+    ASSERT_EQ(trajectories.size(), size_t(1));
+    ASSERT_EQ(trajectories.front().positions.size(), size_t(3));
+    EXPECT_FLOAT_EQ(trajectories.front().positions.at(2).x, 2.0f);
+}
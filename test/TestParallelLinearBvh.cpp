@@ -0,0 +1,300 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include <bvh/binned_sah_builder.hpp>
+#include <bvh/sweep_sah_builder.hpp>
+#include <bvh/linear_bvh_builder.hpp>
+
+#include "Renderers/Tubes/Tubes.hpp"
+#include "LineData/TrianglePayload/MeshletBuilder.hpp"
+#include "LineData/TrianglePayload/ParallelLinearBvhBuilder.hpp"
+#include "LineTestData.hpp"
+
+using Scalar = ParallelLinearBvhBuilder::Scalar;
+using Bvh = ParallelLinearBvhBuilder::Bvh;
+using Vector3 = ParallelLinearBvhBuilder::Vector3;
+using BoundingBox = ParallelLinearBvhBuilder::BoundingBox;
+
+struct BvhTestPrimitives {
+    std::vector<BoundingBox> bboxes;
+    std::vector<Vector3> centers;
+};
+
+/// Primitives for BvhBuildGeometryMode::TRIANGLES (triangle bounding boxes and centroids).
+static void createTrianglePrimitives(
+        const std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        BvhTestPrimitives& primitives) {
+    size_t numTriangles = triangleIndices.size() / 3;
+    primitives.bboxes.resize(numTriangles);
+    primitives.centers.resize(numTriangles);
+    for (size_t triangleIdx = 0; triangleIdx < numTriangles; triangleIdx++) {
+        BoundingBox bbox = BoundingBox::empty();
+        glm::vec3 centroid(0.0f);
+        for (size_t i = 0; i < 3; i++) {
+            const glm::vec3& pt = vertexDataList.at(triangleIndices.at(triangleIdx * 3 + i)).vertexPosition;
+            Vector3 ptBvh(pt.x, pt.y, pt.z);
+            bbox.extend(BoundingBox(ptBvh, ptBvh));
+            centroid += pt;
+        }
+        centroid /= 3.0f;
+        primitives.bboxes[triangleIdx] = bbox;
+        primitives.centers[triangleIdx] = Vector3(centroid.x, centroid.y, centroid.z);
+    }
+}
+
+/// Primitives for BvhBuildGeometryMode::MESHLETS (meshlet bounding boxes and their centers).
+static void createMeshletPrimitives(
+        const std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        BvhTestPrimitives& primitives) {
+    std::vector<MeshletDrawIndirectPayloadData> meshlets;
+    buildMeshletsDrawIndirect(triangleIndices, vertexDataList, {}, 128, meshlets);
+    primitives.bboxes.resize(meshlets.size());
+    primitives.centers.resize(meshlets.size());
+    for (size_t meshletIdx = 0; meshletIdx < meshlets.size(); meshletIdx++) {
+        const MeshletDrawIndirectPayloadData& meshlet = meshlets.at(meshletIdx);
+        BoundingBox bbox(
+                Vector3(meshlet.worldSpaceAabbMin.x, meshlet.worldSpaceAabbMin.y, meshlet.worldSpaceAabbMin.z),
+                Vector3(meshlet.worldSpaceAabbMax.x, meshlet.worldSpaceAabbMax.y, meshlet.worldSpaceAabbMax.z));
+        primitives.bboxes[meshletIdx] = bbox;
+        primitives.centers[meshletIdx] = bbox.center();
+    }
+}
+
+static BoundingBox getNodeBbox(const Bvh::Node& node) {
+    return BoundingBox(
+            Vector3(node.bounds[0], node.bounds[2], node.bounds[4]),
+            Vector3(node.bounds[1], node.bounds[3], node.bounds[5]));
+}
+
+static bool bboxesEqual(const BoundingBox& a, const BoundingBox& b) {
+    for (int i = 0; i < 3; i++) {
+        if (a.min[i] != b.min[i] || a.max[i] != b.max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Surface area heuristic cost of the BVH relative to the root node (traversal cost 1, intersection cost 1).
+ */
+static double computeSahCost(const Bvh& bvh) {
+    BoundingBox rootBbox = getNodeBbox(bvh.nodes[0]);
+    double rootArea = computeHalfArea(rootBbox.min, rootBbox.max);
+    double cost = 0.0;
+    for (size_t nodeIdx = 0; nodeIdx < bvh.node_count; nodeIdx++) {
+        const Bvh::Node& node = bvh.nodes[nodeIdx];
+        BoundingBox nodeBbox = getNodeBbox(node);
+        double relativeArea = computeHalfArea(nodeBbox.min, nodeBbox.max) / rootArea;
+        cost += relativeArea * (node.is_leaf() ? double(node.primitive_count) : 1.0);
+    }
+    return cost;
+}
+
+/**
+ * Checks that all nodes are reachable exactly once, that the bounds of each node are the union of the bounds of its
+ * children or primitives, and that the leaves reference each primitive exactly once.
+ */
+static void validateBvh(const Bvh& bvh, const BvhTestPrimitives& primitives, uint32_t maxLeafSize) {
+    size_t numPrimitives = primitives.bboxes.size();
+    ASSERT_GE(bvh.node_count, size_t(1));
+    std::vector<uint32_t> primitiveReferenceCounts(numPrimitives, 0);
+    std::vector<uint32_t> nodeVisitCounts(bvh.node_count, 0);
+    std::vector<size_t> nodeStack;
+    nodeStack.push_back(0);
+    while (!nodeStack.empty()) {
+        size_t nodeIdx = nodeStack.back();
+        nodeStack.pop_back();
+        ASSERT_LT(nodeIdx, bvh.node_count);
+        nodeVisitCounts[nodeIdx]++;
+        const Bvh::Node& node = bvh.nodes[nodeIdx];
+        BoundingBox bbox = BoundingBox::empty();
+        if (node.is_leaf()) {
+            ASSERT_LE(node.primitive_count, maxLeafSize);
+            for (size_t i = 0; i < node.primitive_count; i++) {
+                size_t primitiveIdx = bvh.primitive_indices[node.first_child_or_primitive + i];
+                ASSERT_LT(primitiveIdx, numPrimitives);
+                primitiveReferenceCounts[primitiveIdx]++;
+                bbox.extend(primitives.bboxes[primitiveIdx]);
+            }
+        } else {
+            size_t firstChildIdx = node.first_child_or_primitive;
+            ASSERT_EQ(firstChildIdx % 2, size_t(1)) << "Left children need to be stored at odd indices.";
+            ASSERT_LT(firstChildIdx + 1, bvh.node_count);
+            ASSERT_EQ(Bvh::sibling(firstChildIdx), firstChildIdx + 1);
+            bbox.extend(getNodeBbox(bvh.nodes[firstChildIdx]));
+            bbox.extend(getNodeBbox(bvh.nodes[firstChildIdx + 1]));
+            nodeStack.push_back(firstChildIdx);
+            nodeStack.push_back(firstChildIdx + 1);
+        }
+        ASSERT_TRUE(bboxesEqual(bbox, getNodeBbox(node))) << "Wrong bounds of node " << nodeIdx << ".";
+    }
+    for (size_t nodeIdx = 0; nodeIdx < bvh.node_count; nodeIdx++) {
+        ASSERT_EQ(nodeVisitCounts[nodeIdx], 1u) << "Node " << nodeIdx << " is not referenced exactly once.";
+    }
+    for (size_t primitiveIdx = 0; primitiveIdx < numPrimitives; primitiveIdx++) {
+        ASSERT_EQ(primitiveReferenceCounts[primitiveIdx], 1u)
+                << "Primitive " << primitiveIdx << " is not referenced exactly once.";
+    }
+}
+
+static void buildParallelLinearBvh(const BvhTestPrimitives& primitives, uint32_t maxLeafSize, Bvh& bvh) {
+    BoundingBox globalBbox = bvh::compute_bounding_boxes_union(primitives.bboxes.data(), primitives.bboxes.size());
+    ParallelLinearBvhBuilder builder(bvh);
+    builder.maxLeafSize = maxLeafSize;
+    builder.build(globalBbox, primitives.bboxes.data(), primitives.centers.data(), primitives.bboxes.size());
+}
+
+TEST(ParallelLinearBvhTest, TrianglesSinglePrimitiveLeaves) {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(200, 100, 6, 3, triangleIndices, vertexDataList);
+    BvhTestPrimitives primitives;
+    createTrianglePrimitives(triangleIndices, vertexDataList, primitives);
+    Bvh bvh;
+    buildParallelLinearBvh(primitives, 1, bvh);
+    // A binary tree with one primitive per leaf.
+    EXPECT_EQ(bvh.node_count, 2 * primitives.bboxes.size() - 1);
+    validateBvh(bvh, primitives, 1);
+}
+
+TEST(ParallelLinearBvhTest, TrianglesCollapsedLeaves) {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(200, 100, 6, 5, triangleIndices, vertexDataList);
+    BvhTestPrimitives primitives;
+    createTrianglePrimitives(triangleIndices, vertexDataList, primitives);
+    for (uint32_t maxLeafSize : { 2u, 32u, 128u }) {
+        Bvh bvh;
+        buildParallelLinearBvh(primitives, maxLeafSize, bvh);
+        EXPECT_LT(bvh.node_count, 2 * primitives.bboxes.size() - 1);
+        validateBvh(bvh, primitives, maxLeafSize);
+    }
+}
+
+TEST(ParallelLinearBvhTest, Meshlets) {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(200, 100, 6, 7, triangleIndices, vertexDataList);
+    BvhTestPrimitives primitives;
+    createMeshletPrimitives(triangleIndices, vertexDataList, primitives);
+    Bvh bvh;
+    buildParallelLinearBvh(primitives, 1, bvh);
+    validateBvh(bvh, primitives, 1);
+}
+
+TEST(ParallelLinearBvhTest, DuplicateMortonCodes) {
+    // All primitives share the same center, so the hierarchy is determined by the primitive order alone.
+    BvhTestPrimitives primitives;
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for (int i = 0; i < 1000; i++) {
+        Vector3 extent(distribution(generator), distribution(generator), distribution(generator));
+        primitives.bboxes.emplace_back(Vector3(0.0f) - extent, extent);
+        primitives.centers.emplace_back(0.0f);
+    }
+    for (uint32_t maxLeafSize : { 1u, 7u }) {
+        Bvh bvh;
+        buildParallelLinearBvh(primitives, maxLeafSize, bvh);
+        validateBvh(bvh, primitives, maxLeafSize);
+    }
+}
+
+TEST(ParallelLinearBvhTest, SmallInputs) {
+    BvhTestPrimitives primitives;
+    Bvh bvh;
+    buildParallelLinearBvh(primitives, 1, bvh);
+    EXPECT_EQ(bvh.node_count, size_t(0));
+
+    for (int i = 0; i < 3; i++) {
+        Vector3 position(float(i), 0.0f, 0.0f);
+        primitives.bboxes.emplace_back(position, position + Vector3(0.5f));
+        primitives.centers.push_back(position + Vector3(0.25f));
+        buildParallelLinearBvh(primitives, 1, bvh);
+        validateBvh(bvh, primitives, 1);
+        buildParallelLinearBvh(primitives, 4, bvh);
+        EXPECT_EQ(bvh.node_count, size_t(1));
+        validateBvh(bvh, primitives, 4);
+    }
+}
+
+/**
+ * Compares the build times and SAH costs of the parallel LBVH builder with the builders of the bvh library.
+ */
+static void runBvhBuilderBenchmark(const char* geometryModeName, const BvhTestPrimitives& primitives) {
+    const BoundingBox* bboxes = primitives.bboxes.data();
+    const Vector3* centers = primitives.centers.data();
+    size_t numPrimitives = primitives.bboxes.size();
+    std::cout << geometryModeName << ": " << numPrimitives << " primitives" << std::endl;
+
+    auto runBuilder = [&](const char* builderName, const auto& buildFunctor) {
+        Bvh bvh;
+        auto startTime = std::chrono::steady_clock::now();
+        BoundingBox globalBbox = bvh::compute_bounding_boxes_union(bboxes, numPrimitives);
+        buildFunctor(bvh, globalBbox);
+        auto endTime = std::chrono::steady_clock::now();
+        double elapsedMs = std::chrono::duration<double>(endTime - startTime).count() * 1e3;
+        std::cout << builderName << ": " << elapsedMs << "ms, " << bvh.node_count << " nodes, SAH cost "
+                  << computeSahCost(bvh) << std::endl;
+    };
+    runBuilder("Binned SAH (CPU)", [&](Bvh& bvh, const BoundingBox& globalBbox) {
+        bvh::BinnedSahBuilder<Bvh, 16> builder(bvh);
+        builder.max_leaf_size = 1;
+        builder.build(globalBbox, bboxes, centers, numPrimitives);
+    });
+    runBuilder("Sweep SAH (CPU)", [&](Bvh& bvh, const BoundingBox& globalBbox) {
+        bvh::SweepSahBuilder<Bvh> builder(bvh);
+        builder.max_leaf_size = 1;
+        builder.build(globalBbox, bboxes, centers, numPrimitives);
+    });
+    runBuilder("Linear BVH (CPU)", [&](Bvh& bvh, const BoundingBox& globalBbox) {
+        bvh::LinearBvhBuilder<Bvh, uint32_t> builder(bvh);
+        builder.build(globalBbox, bboxes, centers, numPrimitives);
+    });
+    runBuilder("Linear BVH (Parallel, CPU)", [&](Bvh& bvh, const BoundingBox& globalBbox) {
+        ParallelLinearBvhBuilder builder(bvh);
+        builder.build(globalBbox, bboxes, centers, numPrimitives);
+    });
+}
+
+TEST(ParallelLinearBvhBenchmark, DISABLED_TrianglesAndMeshlets) {
+    // Approximately 8M triangles.
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(2000, 250, 8, 13, triangleIndices, vertexDataList);
+    BvhTestPrimitives primitives;
+    createTrianglePrimitives(triangleIndices, vertexDataList, primitives);
+    runBvhBuilderBenchmark("Triangles", primitives);
+    createMeshletPrimitives(triangleIndices, vertexDataList, primitives);
+    runBvhBuilderBenchmark("Meshlets", primitives);
+}
@@ -0,0 +1,150 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "LineData/RenderDataCache.hpp"
+
+namespace {
+
+class TestPayload : public TubeTriangleRenderDataPayload {
+public:
+    explicit TestPayload(int setting) : setting(setting) {}
+    [[nodiscard]] Type getType() const override { return Type::MESHLETS_DRAW_INDIRECT; }
+    [[nodiscard]] bool settingsEqual(TubeTriangleRenderDataPayload* other) const override {
+        return TubeTriangleRenderDataPayload::settingsEqual(other)
+                && static_cast<TestPayload*>(other)->setting == setting;
+    }
+
+private:
+    int setting;
+};
+
+RenderDataCacheKey makeKey(RenderDataRequestMode requestMode, int tubeNumSubdivisions = 0) {
+    RenderDataCacheKey key;
+    key.requestMode = requestMode;
+    key.tubeNumSubdivisions = tubeNumSubdivisions;
+    return key;
+}
+
+RenderDataCacheEntry makeEntry(const RenderDataCacheKey& key, size_t sizeInBytes) {
+    RenderDataCacheEntry entry;
+    entry.key = key;
+    entry.sizeInBytes = sizeInBytes;
+    return entry;
+}
+
+}
+
+TEST(RenderDataCacheTest, TakeReturnsMatchingEntry) {
+    RenderDataCache cache(1000);
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::PROGRAMMABLE_PULL, 6), 100));
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), 200));
+    EXPECT_EQ(cache.getNumEntries(), 2u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 300u);
+
+    RenderDataCacheEntry entry;
+    EXPECT_FALSE(cache.take(makeKey(RenderDataRequestMode::PROGRAMMABLE_PULL, 8), entry));
+    EXPECT_FALSE(cache.take(makeKey(RenderDataRequestMode::MESH_SHADER, 6), entry));
+    EXPECT_TRUE(cache.take(makeKey(RenderDataRequestMode::PROGRAMMABLE_PULL, 6), entry));
+    EXPECT_EQ(entry.sizeInBytes, 100u);
+    EXPECT_EQ(cache.getNumEntries(), 1u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 200u);
+}
+
+TEST(RenderDataCacheTest, EvictsLeastRecentlyUsed) {
+    RenderDataCache cache(300);
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), 100));
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::PROGRAMMABLE_PULL, 6), 100));
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::MESH_SHADER, 6), 100));
+
+    // Using the geometry shader data makes the programmable pull data the least recently used entry.
+    RenderDataCacheEntry entry;
+    ASSERT_TRUE(cache.take(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), entry));
+    cache.insert(std::move(entry));
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::AABBS), 100));
+
+    EXPECT_EQ(cache.getNumEntries(), 3u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 300u);
+    EXPECT_FALSE(cache.take(makeKey(RenderDataRequestMode::PROGRAMMABLE_PULL, 6), entry));
+    EXPECT_TRUE(cache.take(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), entry));
+    EXPECT_TRUE(cache.take(makeKey(RenderDataRequestMode::MESH_SHADER, 6), entry));
+
+    // Lowering the budget evicts the remaining entries that no longer fit.
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), 100));
+    cache.setBudgetInBytes(150);
+    EXPECT_EQ(cache.getNumEntries(), 1u);
+    EXPECT_EQ(cache.getEntries().front().key.requestMode, RenderDataRequestMode::GEOMETRY_SHADER);
+}
+
+TEST(RenderDataCacheTest, InsertReplacesAndRejectsOversizedEntries) {
+    RenderDataCache cache(1000);
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), 100));
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::GEOMETRY_SHADER), 150));
+    EXPECT_EQ(cache.getNumEntries(), 1u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 150u);
+
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::AABBS), 1001));
+    EXPECT_EQ(cache.getNumEntries(), 1u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 150u);
+
+    cache.insert(makeEntry(makeKey(RenderDataRequestMode::TRIANGLES, 6), 100));
+    cache.remove(RenderDataRequestMode::TRIANGLES);
+    EXPECT_EQ(cache.getNumEntries(), 1u);
+    cache.clear();
+    EXPECT_EQ(cache.getNumEntries(), 0u);
+    EXPECT_EQ(cache.getUsedSizeInBytes(), 0u);
+}
+
+TEST(RenderDataCacheTest, TriangleKeysMatchPayloadSettings) {
+    RenderDataCache cache(1000);
+    RenderDataCacheKey rasterKey = makeKey(RenderDataRequestMode::TRIANGLES, 6);
+    rasterKey.payload = std::make_shared<TestPayload>(1);
+    RenderDataCacheKey rayTracingKey = makeKey(RenderDataRequestMode::TRIANGLES, 6);
+    rayTracingKey.vulkanRayTracing = true;
+    cache.insert(makeEntry(rasterKey, 100));
+    cache.insert(makeEntry(rayTracingKey, 200));
+
+    RenderDataCacheEntry entry;
+    RenderDataCacheKey request = makeKey(RenderDataRequestMode::TRIANGLES, 6);
+    request.payload = std::make_shared<TestPayload>(2);
+    EXPECT_FALSE(cache.take(request, entry));
+
+    // A request without a payload can use data generated with a payload, but not data with other settings.
+    request.payload = {};
+    EXPECT_TRUE(cache.take(request, entry));
+    EXPECT_EQ(entry.key.payload, rasterKey.payload);
+
+    request.payload = std::make_shared<TestPayload>(1);
+    EXPECT_FALSE(cache.take(request, entry));
+    request.payload = {};
+    request.vulkanRayTracing = true;
+    EXPECT_TRUE(cache.take(request, entry));
+    EXPECT_EQ(entry.sizeInBytes, 200u);
+}
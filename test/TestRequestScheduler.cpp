@@ -0,0 +1,182 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include "Utils/RequestScheduler.hpp"
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineSeeder.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+
+template<class Reply>
+static bool waitForReply(RequestScheduler<Reply>& scheduler, Reply& reply) {
+    auto startTime = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+        if (scheduler.getReply(reply)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+TEST(RequestSchedulerTest, PublishesReply) {
+    RequestScheduler<int> scheduler("TestRequestScheduler");
+    scheduler.queueJob([](int& reply, JobToken& jobToken) {
+        jobToken.setProgress(1.0f);
+        reply = 42;
+        return true;
+    });
+    int reply = 0;
+    ASSERT_TRUE(waitForReply(scheduler, reply));
+    EXPECT_EQ(reply, 42);
+    EXPECT_FALSE(scheduler.getReply(reply));
+}
+
+TEST(RequestSchedulerTest, RunsSynchronouslyWithoutWorkerThread) {
+    RequestScheduler<int> scheduler("TestRequestScheduler", false);
+    scheduler.queueJob([](int& reply, JobToken& /*jobToken*/) {
+        reply = 7;
+        return true;
+    });
+    int reply = 0;
+    EXPECT_TRUE(scheduler.getReply(reply));
+    EXPECT_EQ(reply, 7);
+}
+
+/**
+ * A new request needs to stop the stale one quickly, and the stale result must never be published.
+ */
+TEST(RequestSchedulerTest, NewRequestCancelsRunningJob) {
+    RequestScheduler<int> scheduler("TestRequestScheduler");
+    std::atomic<bool> staleJobStarted{false};
+    std::atomic<std::chrono::steady_clock::rep> cancelTime{0};
+    std::atomic<int64_t> cancelLatencyUs{-1};
+    scheduler.queueJob([&](int& reply, JobToken& jobToken) {
+        staleJobStarted = true;
+        while (!jobToken.getIsCancelled()) {
+            std::this_thread::yield();
+        }
+        auto cancelTimePoint = std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(cancelTime.load()));
+        cancelLatencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - cancelTimePoint).count();
+        reply = 1;
+        return true;
+    });
+    while (!staleJobStarted) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(scheduler.getIsProcessingRequest());
+
+    cancelTime = std::chrono::steady_clock::now().time_since_epoch().count();
+    scheduler.queueJob([](int& reply, JobToken& /*jobToken*/) {
+        reply = 2;
+        return true;
+    });
+    int reply = 0;
+    ASSERT_TRUE(waitForReply(scheduler, reply));
+    EXPECT_EQ(reply, 2);
+    EXPECT_FALSE(scheduler.getReply(reply));
+    EXPECT_GE(cancelLatencyUs.load(), 0);
+    EXPECT_LT(cancelLatencyUs.load(), 50000);
+    std::cout << "Cancellation latency: " << cancelLatencyUs.load() << "us" << std::endl;
+}
+
+TEST(RequestSchedulerTest, JoinCancelsRunningJob) {
+    RequestScheduler<int> scheduler("TestRequestScheduler");
+    std::atomic<bool> jobStarted{false};
+    scheduler.queueJob([&](int& /*reply*/, JobToken& jobToken) {
+        jobStarted = true;
+        while (!jobToken.getIsCancelled()) {
+            std::this_thread::yield();
+        }
+        return true;
+    });
+    while (!jobStarted) {
+        std::this_thread::yield();
+    }
+    scheduler.join();
+    int reply = 0;
+    EXPECT_FALSE(scheduler.getReply(reply));
+    EXPECT_FALSE(scheduler.getIsProcessingRequest());
+}
+
+/**
+ * Tests that streamline tracing stops early when the request is cancelled and reports its progress otherwise.
+ */
+class CancelTracingTest : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override {
+        tracingSettings.isAbcDataSet = true;
+        tracingSettings.abcFlowGenerator.load(tracingSettings.gridDataSetMetaData, &grid);
+        tracingSettings.flowPrimitives = FlowPrimitives::STREAMLINES;
+        tracingSettings.streamlineSeedingStrategy = StreamlineSeedingStrategy::VOLUME;
+        tracingSettings.seeder = std::make_shared<StreamlineVolumeSeeder>();
+        tracingSettings.usePacketTracing = GetParam();
+        tracingSettings.numPrimitives = 20000;
+        tracingSettings.maxNumIterations = 2000;
+    }
+
+    StreamlineTracingGrid grid;
+    StreamlineTracingSettings tracingSettings;
+};
+
+TEST_P(CancelTracingTest, ReportsProgress) {
+    JobToken jobToken;
+    tracingSettings.jobToken = &jobToken;
+    tracingSettings.numPrimitives = 100;
+    Trajectories trajectories;
+    grid.traceStreamlines(tracingSettings, trajectories);
+    EXPECT_FALSE(trajectories.empty());
+    EXPECT_FLOAT_EQ(jobToken.getProgress(), 1.0f);
+}
+
+TEST_P(CancelTracingTest, StopsWhenCancelled) {
+    JobToken jobToken;
+    tracingSettings.jobToken = &jobToken;
+    std::thread cancelThread([&jobToken]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        jobToken.cancel();
+    });
+    auto startTime = std::chrono::steady_clock::now();
+    Trajectories trajectories;
+    grid.traceStreamlines(tracingSettings, trajectories);
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    cancelThread.join();
+
+    EXPECT_TRUE(trajectories.empty());
+    EXPECT_LT(jobToken.getProgress(), 1.0f);
+    std::cout << "Tracing returned after " << elapsedMs << "ms (cancelled after 5ms)" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(PacketTracing, CancelTracingTest, ::testing::Values(false, true));
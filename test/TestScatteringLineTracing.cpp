@@ -0,0 +1,720 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#ifdef USE_TBB
+#include <tbb/global_control.h>
+#elif defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "Renderers/Scattering/nanovdb/util/GridBuilder.h"
+#include "LineData/Scattering/DtPathTrace.hpp"
+
+/**
+ * Creates a spherical cloud with a smooth density falloff.
+ */
+static Texture3D createCloudGrid(uint32_t gridSize) {
+    Texture3D grid {};
+    grid.size_x = gridSize;
+    grid.size_y = gridSize;
+    grid.size_z = gridSize;
+    grid.voxel_size_x = 1.0f;
+    grid.voxel_size_y = 1.0f;
+    grid.voxel_size_z = 1.0f;
+    grid.data = new float[size_t(gridSize) * size_t(gridSize) * size_t(gridSize)];
+    for (uint32_t z = 0; z < gridSize; z++) {
+        for (uint32_t y = 0; y < gridSize; y++) {
+            for (uint32_t x = 0; x < gridSize; x++) {
+                glm::vec3 p = glm::vec3(float(x), float(y), float(z)) / float(gridSize - 1) * 2.0f - glm::vec3(1.0f);
+                float density = std::max(0.0f, 1.0f - glm::length(p));
+                grid.data[x + (y + z * gridSize) * gridSize] = density;
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * Creates a sparse cloud consisting of a few small blobs, i.e., the volume is mostly empty.
+ */
+static Texture3D createSparseCloudGrid(uint32_t gridSize) {
+    Texture3D grid {};
+    grid.size_x = gridSize;
+    grid.size_y = gridSize;
+    grid.size_z = gridSize;
+    grid.voxel_size_x = 1.0f;
+    grid.voxel_size_y = 1.0f;
+    grid.voxel_size_z = 1.0f;
+    grid.data = new float[size_t(gridSize) * size_t(gridSize) * size_t(gridSize)];
+    const int numBlobs = 6;
+    const glm::vec3 blobCenters[numBlobs] = {
+            glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.3f, -0.2f), glm::vec3(-0.4f, 0.5f, 0.4f),
+            glm::vec3(-0.5f, -0.5f, -0.3f), glm::vec3(0.4f, -0.4f, 0.5f), glm::vec3(0.1f, 0.6f, -0.6f)
+    };
+    const float blobRadii[numBlobs] = { 0.3f, 0.15f, 0.2f, 0.15f, 0.1f, 0.15f };
+    for (uint32_t z = 0; z < gridSize; z++) {
+        for (uint32_t y = 0; y < gridSize; y++) {
+            for (uint32_t x = 0; x < gridSize; x++) {
+                glm::vec3 p = glm::vec3(float(x), float(y), float(z)) / float(gridSize - 1) * 2.0f - glm::vec3(1.0f);
+                float density = 0.0f;
+                for (int blobIdx = 0; blobIdx < numBlobs; blobIdx++) {
+                    float blobDistance = glm::length(p - blobCenters[blobIdx]) / blobRadii[blobIdx];
+                    density = std::max(density, 1.0f - blobDistance * blobDistance);
+                }
+                grid.data[x + (y + z * gridSize) * gridSize] = density;
+            }
+        }
+    }
+    return grid;
+}
+
+struct ScatteringPaths {
+    ScatteringEventStream events;
+    PathTraceStatistics statistics;
+};
+
+static void traceScatteringPaths(
+        const VolumeInfo& volumeInfo, uint32_t seed, int numThreads, ScatteringPaths& paths,
+        size_t maxPathMemoryBytes = 0, SphericalHistogram* exitDirectionHistogram = nullptr,
+        uint32_t resX = 24, uint32_t resY = 20) {
+#ifdef USE_TBB
+    tbb::global_control globalControl(tbb::global_control::max_allowed_parallelism, size_t(numThreads));
+#elif defined(_OPENMP)
+    int maxNumThreads = omp_get_max_threads();
+    omp_set_num_threads(numThreads);
+#endif
+    bool finished = trace_scattering_paths(
+            volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, resX, resY, 8, seed, maxPathMemoryBytes,
+            paths.events, &paths.statistics, exitDirectionHistogram, {});
+    EXPECT_TRUE(finished);
+#if !defined(USE_TBB) && defined(_OPENMP)
+    omp_set_num_threads(maxNumThreads);
+#endif
+}
+
+static bool getPathsEqual(const ScatteringPaths& paths0, const ScatteringPaths& paths1) {
+    const ScatteringEventStream& events0 = paths0.events;
+    const ScatteringEventStream& events1 = paths1.events;
+    if (events0.get_num_events() != events1.get_num_events() || events0.path_offsets != events1.path_offsets
+            || events0.exit_directions.size() != events1.exit_directions.size()) {
+        return false;
+    }
+    return std::memcmp(
+                    events0.positions.data(), events1.positions.data(),
+                    events0.get_num_events() * sizeof(glm::vec3)) == 0
+            && events0.event_types == events1.event_types
+            && std::memcmp(
+                    events0.exit_directions.data(), events1.exit_directions.data(),
+                    events0.exit_directions.size() * sizeof(glm::vec3)) == 0;
+}
+
+static bool getPathEqual(
+        const ScatteringEventStream& events0, size_t pathIdx0, const ScatteringEventStream& events1, size_t pathIdx1) {
+    TrajectorySpan<const glm::vec3> pathPositions0 = events0.get_path_positions(pathIdx0);
+    TrajectorySpan<const glm::vec3> pathPositions1 = events1.get_path_positions(pathIdx1);
+    TrajectorySpan<const float> pathEventTypes0 = events0.get_path_event_types(pathIdx0);
+    TrajectorySpan<const float> pathEventTypes1 = events1.get_path_event_types(pathIdx1);
+    return pathPositions0.size() == pathPositions1.size()
+            && std::memcmp(pathPositions0.data(), pathPositions1.data(), pathPositions0.size() * sizeof(glm::vec3)) == 0
+            && std::equal(pathEventTypes0.begin(), pathEventTypes0.end(), pathEventTypes1.begin())
+            && std::memcmp(
+                    &events0.exit_directions[pathIdx0], &events1.exit_directions[pathIdx1], sizeof(glm::vec3)) == 0;
+}
+
+TEST(ScatteringLineTracingTest, PathRng) {
+    PathRng rng0(17, 5), rng1(17, 5), rng2(17, 6), rng3(18, 5);
+    double sum = 0.0;
+    int numEqual2 = 0, numEqual3 = 0;
+    const int numSamples = 100000;
+    for (int i = 0; i < numSamples; i++) {
+        float value = rng0.random();
+        ASSERT_GE(value, 0.0f);
+        ASSERT_LT(value, 1.0f);
+        ASSERT_EQ(value, rng1.random());
+        numEqual2 += value == rng2.random() ? 1 : 0;
+        numEqual3 += value == rng3.random() ? 1 : 0;
+        sum += double(value);
+    }
+    EXPECT_NEAR(sum / double(numSamples), 0.5, 0.01);
+    EXPECT_LT(numEqual2, 100);
+    EXPECT_LT(numEqual3, 100);
+}
+
+TEST(ScatteringLineTracingTest, ThreadCountIndependence) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(32);
+    volumeInfo.extinction = glm::vec3(64.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.2f;
+
+    ScatteringPaths pathsSingleThreaded, pathsMultiThreaded, pathsOtherSeed;
+    traceScatteringPaths(volumeInfo, 42, 1, pathsSingleThreaded);
+    traceScatteringPaths(volumeInfo, 42, 4, pathsMultiThreaded);
+    traceScatteringPaths(volumeInfo, 43, 4, pathsOtherSeed);
+    volumeInfo.grid.delete_maybe();
+
+    ASSERT_FALSE(pathsSingleThreaded.events.empty());
+    EXPECT_EQ(pathsSingleThreaded.events.get_num_paths(), pathsSingleThreaded.events.exit_directions.size());
+    EXPECT_TRUE(getPathsEqual(pathsSingleThreaded, pathsMultiThreaded));
+    EXPECT_FALSE(getPathsEqual(pathsSingleThreaded, pathsOtherSeed));
+}
+
+TEST(ScatteringLineTracingTest, Cancellation) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(16);
+    volumeInfo.extinction = glm::vec3(16.0f);
+    volumeInfo.scattering_albedo = glm::vec3(1.0f);
+    volumeInfo.g = 0.0f;
+
+    ScatteringPaths paths;
+    int numCalls = 0;
+    bool finished = trace_scattering_paths(
+            volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, 8, 64, 1, 1, 0,
+            paths.events, nullptr, nullptr, [&numCalls](float progress) {
+                EXPECT_GE(progress, 0.0f);
+                EXPECT_LE(progress, 1.0f);
+                return ++numCalls < 2;
+            });
+    volumeInfo.grid.delete_maybe();
+    EXPECT_FALSE(finished);
+    EXPECT_EQ(numCalls, 2);
+    EXPECT_TRUE(paths.events.empty());
+}
+
+TEST(ScatteringLineTracingBenchmark, DISABLED_TracePaths) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(64);
+    volumeInfo.extinction = glm::vec3(128.0f);
+    volumeInfo.scattering_albedo = glm::vec3(1.0f);
+    volumeInfo.g = 0.2f;
+
+    ScatteringPaths paths;
+    auto startTime = std::chrono::steady_clock::now();
+    trace_scattering_paths(
+            volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, 64, 64, 16, 7, 0,
+            paths.events, nullptr, nullptr, {});
+    auto endTime = std::chrono::steady_clock::now();
+    volumeInfo.grid.delete_maybe();
+    std::cout << "Scattering paths: " << paths.events.get_num_paths() << " paths with " << paths.events.get_num_events()
+              << " points in "
+              << std::chrono::duration<double>(endTime - startTime).count() * 1e3 << "ms" << std::endl;
+}
+
+TEST(ScatteringLineTracingTest, MajorantGridBound) {
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    Texture3D grid {};
+    grid.size_x = 37;
+    grid.size_y = 20;
+    grid.size_z = 1;
+    grid.data = new float[grid.size_x * grid.size_y * grid.size_z];
+    for (uint32_t i = 0; i < grid.size_x * grid.size_y * grid.size_z; i++) {
+        grid.data[i] = distribution(generator) < 0.8f ? 0.0f : distribution(generator);
+    }
+
+    for (uint32_t superVoxelSize : { 1u, 4u, 8u, 64u }) {
+        MajorantGrid majorantGrid;
+        majorantGrid.build(grid, superVoxelSize);
+        ASSERT_EQ(majorantGrid.size_z, 1u);
+        for (int i = 0; i < 100000; i++) {
+            glm::vec3 pos(distribution(generator), distribution(generator), distribution(generator));
+            uint32_t cellCounts[3] = { majorantGrid.size_x, majorantGrid.size_y, majorantGrid.size_z };
+            uint32_t cell[3];
+            for (int a = 0; a < 3; a++) {
+                cell[a] = std::min(uint32_t(pos[a] * majorantGrid.normalized_to_cell_scale[a]), cellCounts[a] - 1);
+            }
+            ASSERT_LE(grid.sample_at(pos), majorantGrid.max_density_at(cell[0], cell[1], cell[2]));
+        }
+    }
+    grid.delete_maybe();
+}
+
+struct ScatteringPathMoments {
+    static const int numBins = 9;
+    double numPaths = 0.0;
+    double realCollisionsMean = 0.0, realCollisionsVariance = 0.0;
+    glm::vec3 exitDirectionMean = glm::vec3(0.0f), exitDirectionVariance = glm::vec3(0.0f);
+    // Histogram of the cosine between the entry and the exit direction. The last bin counts undeflected paths.
+    double deflectionHistogram[numBins] = {};
+};
+
+/**
+ * Traces numPaths paths from the camera towards random points in the volume box and computes the moments of the
+ * number of real (i.e., non-null) collisions and of the exit directions of the paths.
+ */
+static void computeScatteringPathMoments(
+        const VolumeInfo& volumeInfo, glm::vec3 cameraPosition, uint32_t seed, int numPaths,
+        ScatteringPathMoments& moments) {
+    PathRng targetRng(1, 0);
+    double realCollisionsSum = 0.0, realCollisionsSumSquared = 0.0;
+    glm::vec3 exitDirectionSum(0.0f), exitDirectionSumSquared(0.0f);
+    for (int pathIdx = 0; pathIdx < numPaths; pathIdx++) {
+        glm::vec3 target = glm::vec3(targetRng.random(), targetRng.random(), targetRng.random()) * 0.5f
+                - glm::vec3(0.25f);
+        PathInfo pathInfo {};
+        pathInfo.camera_pos = cameraPosition;
+        pathInfo.ray_direction = glm::normalize(target - cameraPosition);
+        PathRng rng(seed, uint64_t(pathIdx));
+        PathTraceStatistics statistics;
+        glm::vec3 exitDirection;
+        if (!dt_path_trace(pathInfo, volumeInfo, rng, nullptr, exitDirection, statistics)) {
+            continue;
+        }
+
+        auto numRealCollisions = double(statistics.num_density_lookups - statistics.num_null_collisions);
+        realCollisionsSum += numRealCollisions;
+        realCollisionsSumSquared += numRealCollisions * numRealCollisions;
+        for (int a = 0; a < 3; a++) {
+            exitDirectionSum[a] += exitDirection[a];
+            exitDirectionSumSquared[a] += exitDirection[a] * exitDirection[a];
+        }
+        float cosTheta = glm::dot(exitDirection, pathInfo.ray_direction);
+        int binIdx = ScatteringPathMoments::numBins - 1;
+        if (cosTheta < 0.9999f) {
+            binIdx = std::clamp(
+                    int((cosTheta * 0.5f + 0.5f) * float(ScatteringPathMoments::numBins - 1)),
+                    0, ScatteringPathMoments::numBins - 2);
+        }
+        moments.deflectionHistogram[binIdx] += 1.0;
+        moments.numPaths += 1.0;
+    }
+
+    double n = moments.numPaths;
+    moments.realCollisionsMean = realCollisionsSum / n;
+    moments.realCollisionsVariance =
+            realCollisionsSumSquared / n - moments.realCollisionsMean * moments.realCollisionsMean;
+    for (int a = 0; a < 3; a++) {
+        double mean = double(exitDirectionSum[a]) / n;
+        moments.exitDirectionMean[a] = float(mean);
+        moments.exitDirectionVariance[a] = float(double(exitDirectionSumSquared[a]) / n - mean * mean);
+    }
+    for (double& count : moments.deflectionHistogram) {
+        count /= n;
+    }
+}
+
+/**
+ * Checks that sampling against the local majorants produces the same distribution of collisions and exit directions
+ * as sampling against the global majorant. Both are unbiased estimators of the same process, but they consume the
+ * random numbers differently, so the paths are compared statistically (within five standard errors).
+ */
+TEST(ScatteringLineTracingTest, LocalMajorantsMatchGlobalMajorant) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createSparseCloudGrid(64);
+    volumeInfo.extinction = glm::vec3(64.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.5f;
+    MajorantGrid majorantGrid;
+    majorantGrid.build(volumeInfo.grid);
+
+    const glm::vec3 cameraPosition(-0.5f, -0.4f, -0.6f);
+    const int numPaths = 100000;
+    ScatteringPathMoments momentsGlobal, momentsLocal;
+    computeScatteringPathMoments(volumeInfo, cameraPosition, 11, numPaths, momentsGlobal);
+    volumeInfo.majorant_grid = &majorantGrid;
+    computeScatteringPathMoments(volumeInfo, cameraPosition, 12, numPaths, momentsLocal);
+    volumeInfo.grid.delete_maybe();
+
+    ASSERT_EQ(momentsGlobal.numPaths, momentsLocal.numPaths);
+    double n = momentsGlobal.numPaths;
+    EXPECT_NEAR(
+            momentsGlobal.realCollisionsMean, momentsLocal.realCollisionsMean,
+            5.0 * std::sqrt((momentsGlobal.realCollisionsVariance + momentsLocal.realCollisionsVariance) / n));
+    for (int a = 0; a < 3; a++) {
+        double standardError = std::sqrt(
+                double(momentsGlobal.exitDirectionVariance[a] + momentsLocal.exitDirectionVariance[a]) / n);
+        EXPECT_NEAR(momentsGlobal.exitDirectionMean[a], momentsLocal.exitDirectionMean[a], 5.0 * standardError + 1e-6);
+    }
+    for (int binIdx = 0; binIdx < ScatteringPathMoments::numBins; binIdx++) {
+        double pGlobal = momentsGlobal.deflectionHistogram[binIdx];
+        double pLocal = momentsLocal.deflectionHistogram[binIdx];
+        double p = 0.5 * (pGlobal + pLocal);
+        EXPECT_NEAR(pGlobal, pLocal, 5.0 * std::sqrt(2.0 * p * (1.0 - p) / n) + 1e-6);
+    }
+}
+
+TEST(ScatteringLineTracingTest, LocalMajorantsReduceNullCollisions) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createSparseCloudGrid(64);
+    volumeInfo.extinction = glm::vec3(256.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.5f;
+    MajorantGrid majorantGrid;
+    majorantGrid.build(volumeInfo.grid);
+
+    ScatteringPaths pathsGlobal, pathsLocal;
+    trace_scattering_paths(
+            volumeInfo, glm::vec3(-0.5f, -0.4f, -0.6f), glm::vec3(0.0f), 25.0f, 32, 32, 4, 11, 0,
+            pathsGlobal.events, &pathsGlobal.statistics, nullptr, {});
+    volumeInfo.majorant_grid = &majorantGrid;
+    trace_scattering_paths(
+            volumeInfo, glm::vec3(-0.5f, -0.4f, -0.6f), glm::vec3(0.0f), 25.0f, 32, 32, 4, 11, 0,
+            pathsLocal.events, &pathsLocal.statistics, nullptr, {});
+    volumeInfo.grid.delete_maybe();
+
+    EXPECT_EQ(pathsGlobal.statistics.num_paths, pathsLocal.statistics.num_paths);
+    EXPECT_EQ(pathsLocal.events.get_num_paths(), pathsLocal.statistics.num_paths);
+    EXPECT_LT(pathsLocal.statistics.num_null_collisions * 4, pathsGlobal.statistics.num_null_collisions);
+}
+
+/**
+ * Compares the global majorant and the local majorants on a sparse cloud. If the environment variable
+ * LINEVIS_SCATTERING_BENCHMARK_FILE points to a .xyz grid file, this file is used instead.
+ */
+TEST(ScatteringLineTracingBenchmark, DISABLED_LocalMajorants) {
+    VolumeInfo volumeInfo {};
+    const char* benchmarkFilename = std::getenv("LINEVIS_SCATTERING_BENCHMARK_FILE");
+    if (benchmarkFilename) {
+        volumeInfo.grid = load_xyz_file(benchmarkFilename);
+        ASSERT_NE(volumeInfo.grid.data, nullptr);
+    } else {
+        volumeInfo.grid = createSparseCloudGrid(128);
+    }
+    volumeInfo.extinction = glm::vec3(1024.0f);
+    volumeInfo.scattering_albedo = glm::vec3(1.0f);
+    volumeInfo.g = 0.2f;
+    MajorantGrid majorantGrid;
+    majorantGrid.build(volumeInfo.grid);
+
+    for (int useMajorantGrid = 0; useMajorantGrid < 2; useMajorantGrid++) {
+        volumeInfo.majorant_grid = useMajorantGrid ? &majorantGrid : nullptr;
+        ScatteringPaths paths;
+        auto startTime = std::chrono::steady_clock::now();
+        trace_scattering_paths(
+                volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, 64, 64, 4, 7, 0,
+                paths.events, &paths.statistics, nullptr, {});
+        auto endTime = std::chrono::steady_clock::now();
+        double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+        std::cout << (useMajorantGrid ? "Local majorants: " : "Global majorant: ")
+                  << paths.statistics.num_paths << " paths, "
+                  << paths.statistics.num_density_lookups << " density lookups, "
+                  << paths.statistics.num_null_collisions << " null collisions, "
+                  << double(paths.statistics.num_paths) / elapsedSeconds << " paths/s" << std::endl;
+    }
+    volumeInfo.grid.delete_maybe();
+}
+
+/**
+ * Converts a dense grid to a NanoVDB grid. Voxel (0, 0, 0) of the dense grid is stored at the passed index offset.
+ * The corner voxels are set to a small non-zero value, so that the index bounding box of the active voxels (which
+ * defines the normalized coordinates of the sparse grid) matches the dense grid.
+ */
+static nanovdb::GridHandle<> createNanoVdbGrid(Texture3D& grid, const nanovdb::Coord& indexOffset) {
+    grid.data[0] = std::max(grid.data[0], 1e-3f);
+    size_t lastIdx = size_t(grid.size_x) * size_t(grid.size_y) * size_t(grid.size_z) - 1;
+    grid.data[lastIdx] = std::max(grid.data[lastIdx], 1e-3f);
+
+    nanovdb::GridBuilder builder(0.0f);
+    builder.setGridClass(nanovdb::GridClass::FogVolume);
+    auto gridSamplingOperation = [&grid, &indexOffset](const nanovdb::Coord& ijk) -> float {
+        auto x = uint32_t(ijk.x() - indexOffset.x());
+        auto y = uint32_t(ijk.y() - indexOffset.y());
+        auto z = uint32_t(ijk.z() - indexOffset.z());
+        return grid.data[x + (y + z * grid.size_y) * grid.size_x];
+    };
+    builder(gridSamplingOperation, nanovdb::CoordBBox(
+            indexOffset, indexOffset + nanovdb::Coord(
+                    int32_t(grid.size_x - 1), int32_t(grid.size_y - 1), int32_t(grid.size_z - 1))));
+    return builder.getHandle<>(1.0, nanovdb::Vec3d(0.0), "density");
+}
+
+TEST(ScatteringLineTracingTest, NanoVdbSampler) {
+    std::mt19937 generator(23);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    Texture3D grid = createSparseCloudGrid(45);
+    for (const nanovdb::Coord& indexOffset : { nanovdb::Coord(0), nanovdb::Coord(3, -13, 21) }) {
+        nanovdb::GridHandle<> gridHandle = createNanoVdbGrid(grid, indexOffset);
+        const nanovdb::FloatGrid* sparseGrid = gridHandle.grid<float>();
+        ASSERT_NE(sparseGrid, nullptr);
+        DenseDensitySampler denseSampler(grid, nullptr);
+        NanoVdbDensitySampler sparseSampler(*sparseGrid);
+        for (int a = 0; a < 3; a++) {
+            ASSERT_EQ(denseSampler.get_grid_size(a), sparseSampler.get_grid_size(a));
+        }
+
+        for (int i = 0; i < 100000; i++) {
+            glm::vec3 pos(distribution(generator), distribution(generator), distribution(generator));
+            float density = sparseSampler.sample_at(pos);
+            ASSERT_EQ(denseSampler.sample_at(pos), density);
+            int cell[3];
+            for (int a = 0; a < 3; a++) {
+                cell[a] = std::min(
+                        int(pos[a] * sparseSampler.get_normalized_to_cell_scale(a)
+                            + sparseSampler.get_normalized_to_cell_offset(a)),
+                        sparseSampler.get_cell_count(a) - 1);
+            }
+            ASSERT_LE(density, sparseSampler.max_density_at(cell[0], cell[1], cell[2]));
+        }
+    }
+    grid.delete_maybe();
+}
+
+/**
+ * Checks that tracing the NanoVDB grid produces the same distribution of collisions and exit directions as tracing the
+ * dense grid (see LocalMajorantsMatchGlobalMajorant).
+ */
+TEST(ScatteringLineTracingTest, NanoVdbMatchesDense) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createSparseCloudGrid(64);
+    volumeInfo.extinction = glm::vec3(64.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.5f;
+    nanovdb::GridHandle<> gridHandle = createNanoVdbGrid(volumeInfo.grid, nanovdb::Coord(0));
+    MajorantGrid majorantGrid;
+    majorantGrid.build(volumeInfo.grid);
+    volumeInfo.majorant_grid = &majorantGrid;
+
+    const glm::vec3 cameraPosition(-0.5f, -0.4f, -0.6f);
+    const int numPaths = 100000;
+    ScatteringPathMoments momentsDense, momentsSparse;
+    computeScatteringPathMoments(volumeInfo, cameraPosition, 11, numPaths, momentsDense);
+    volumeInfo.grid.delete_maybe();
+    volumeInfo.majorant_grid = nullptr;
+    volumeInfo.sparse_grid = gridHandle.grid<float>();
+    computeScatteringPathMoments(volumeInfo, cameraPosition, 12, numPaths, momentsSparse);
+
+    ASSERT_EQ(momentsDense.numPaths, momentsSparse.numPaths);
+    double n = momentsDense.numPaths;
+    EXPECT_NEAR(
+            momentsDense.realCollisionsMean, momentsSparse.realCollisionsMean,
+            5.0 * std::sqrt((momentsDense.realCollisionsVariance + momentsSparse.realCollisionsVariance) / n));
+    for (int a = 0; a < 3; a++) {
+        double standardError = std::sqrt(
+                double(momentsDense.exitDirectionVariance[a] + momentsSparse.exitDirectionVariance[a]) / n);
+        EXPECT_NEAR(momentsDense.exitDirectionMean[a], momentsSparse.exitDirectionMean[a], 5.0 * standardError + 1e-6);
+    }
+    for (int binIdx = 0; binIdx < ScatteringPathMoments::numBins; binIdx++) {
+        double pDense = momentsDense.deflectionHistogram[binIdx];
+        double pSparse = momentsSparse.deflectionHistogram[binIdx];
+        double p = 0.5 * (pDense + pSparse);
+        EXPECT_NEAR(pDense, pSparse, 5.0 * std::sqrt(2.0 * p * (1.0 - p) / n) + 1e-6);
+    }
+}
+
+/**
+ * Compares the memory footprint and the throughput of the dense and the NanoVDB density backends on a sparse cloud.
+ * If the environment variable LINEVIS_SCATTERING_BENCHMARK_FILE points to a .xyz grid file, this file is used instead.
+ */
+TEST(ScatteringLineTracingBenchmark, DISABLED_NanoVdbSampler) {
+    VolumeInfo volumeInfo {};
+    const char* benchmarkFilename = std::getenv("LINEVIS_SCATTERING_BENCHMARK_FILE");
+    if (benchmarkFilename) {
+        volumeInfo.grid = load_xyz_file(benchmarkFilename);
+        ASSERT_NE(volumeInfo.grid.data, nullptr);
+    } else {
+        volumeInfo.grid = createSparseCloudGrid(512);
+    }
+    volumeInfo.extinction = glm::vec3(1024.0f);
+    volumeInfo.scattering_albedo = glm::vec3(1.0f);
+    volumeInfo.g = 0.2f;
+    nanovdb::GridHandle<> gridHandle = createNanoVdbGrid(volumeInfo.grid, nanovdb::Coord(0));
+    MajorantGrid majorantGrid;
+    majorantGrid.build(volumeInfo.grid);
+    size_t denseBytes =
+            size_t(volumeInfo.grid.size_x) * size_t(volumeInfo.grid.size_y) * size_t(volumeInfo.grid.size_z)
+            * sizeof(float) + majorantGrid.max_densities.size() * sizeof(float);
+
+    for (int useSparseGrid = 0; useSparseGrid < 2; useSparseGrid++) {
+        volumeInfo.majorant_grid = useSparseGrid ? nullptr : &majorantGrid;
+        volumeInfo.sparse_grid = useSparseGrid ? gridHandle.grid<float>() : nullptr;
+        ScatteringPaths paths;
+        auto startTime = std::chrono::steady_clock::now();
+        trace_scattering_paths(
+                volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, 64, 64, 4, 7, 0,
+                paths.events, &paths.statistics, nullptr, {});
+        auto endTime = std::chrono::steady_clock::now();
+        double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+        std::cout << (useSparseGrid ? "NanoVDB grid: " : "Dense grid: ")
+                  << double(useSparseGrid ? gridHandle.size() : denseBytes) / (1024.0 * 1024.0) << " MiB, "
+                  << paths.statistics.num_paths << " paths, "
+                  << paths.statistics.num_density_lookups << " density lookups, "
+                  << double(paths.statistics.num_paths) / elapsedSeconds << " paths/s" << std::endl;
+    }
+    volumeInfo.grid.delete_maybe();
+}
+
+TEST(ScatteringLineTracingTest, EventStream) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(32);
+    volumeInfo.extinction = glm::vec3(64.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.2f;
+
+    ScatteringPaths paths;
+    traceScatteringPaths(volumeInfo, 42, 2, paths);
+    volumeInfo.grid.delete_maybe();
+    const ScatteringEventStream& events = paths.events;
+    ASSERT_EQ(events.get_num_paths(), paths.statistics.num_paths);
+    ASSERT_EQ(events.exit_directions.size(), events.get_num_paths());
+    ASSERT_EQ(events.path_offsets.back(), events.get_num_events());
+    ASSERT_EQ(events.event_types.size(), events.get_num_events());
+
+    uint64_t numEventsOfType[6] = {};
+    for (size_t pathIdx = 0; pathIdx < events.get_num_paths(); pathIdx++) {
+        size_t eventStart = events.path_offsets[pathIdx];
+        size_t numPathEvents = events.get_path_num_events(pathIdx);
+        ASSERT_GE(numPathEvents, 3u);
+        EXPECT_EQ(events.get_event_type(eventStart), ScatteringEventType::CAMERA);
+        EXPECT_EQ(events.get_event_type(eventStart + 1), ScatteringEventType::ENTRY);
+        for (size_t i = 2; i < numPathEvents; i++) {
+            ScatteringEventType type = events.get_event_type(eventStart + i);
+            ASSERT_NE(type, ScatteringEventType::CAMERA);
+            ASSERT_NE(type, ScatteringEventType::ENTRY);
+            // Absorption and leaving the volume end the path.
+            if (type == ScatteringEventType::ABSORPTION || type == ScatteringEventType::EXIT) {
+                ASSERT_EQ(i, numPathEvents - 1);
+            }
+            numEventsOfType[int(type)]++;
+        }
+        EXPECT_NEAR(glm::length(events.exit_directions[pathIdx]), 1.0f, 1e-5f);
+    }
+    EXPECT_EQ(numEventsOfType[int(ScatteringEventType::SCATTERING)], paths.statistics.num_scattering_events);
+    EXPECT_EQ(numEventsOfType[int(ScatteringEventType::NULL_COLLISION)], paths.statistics.num_null_collisions);
+    EXPECT_EQ(numEventsOfType[int(ScatteringEventType::ABSORPTION)], paths.statistics.num_absorption_events);
+    EXPECT_GT(paths.statistics.num_absorption_events, 0u);
+    EXPECT_EQ(
+            paths.statistics.num_scattering_events + paths.statistics.num_null_collisions
+            + paths.statistics.num_absorption_events, paths.statistics.num_density_lookups);
+
+    // The store adopts the arrays of the stream instead of copying them.
+    ScatteringEventStream movedEvents = events;
+    const glm::vec3* positionsData = movedEvents.positions.data();
+    const float* eventTypesData = movedEvents.event_types.data();
+    TrajectoryStore trajectories = movedEvents.move_to_trajectory_store();
+    ASSERT_EQ(trajectories.size(), events.get_num_paths());
+    ASSERT_EQ(trajectories.getNumAttributes(), 1u);
+    ASSERT_EQ(trajectories.getLineOffsets(), events.path_offsets);
+    EXPECT_EQ(trajectories.getPositions().data(), positionsData);
+    EXPECT_EQ(trajectories.getAttributeValues(0).data(), eventTypesData);
+    EXPECT_TRUE(movedEvents.empty());
+    EXPECT_EQ(movedEvents.get_num_events(), 0u);
+    EXPECT_EQ(movedEvents.exit_directions, events.exit_directions);
+    TrajectorySpan<const glm::vec3> positions = trajectories.getPositions();
+    TrajectorySpan<const float> eventTypes = trajectories.getAttributeValues(0);
+    for (size_t i = 0; i < events.get_num_events(); i++) {
+        ASSERT_EQ(std::memcmp(&positions[i], &events.positions[i], sizeof(glm::vec3)), 0);
+        ASSERT_EQ(eventTypes[i], events.event_types[i]);
+    }
+}
+
+/**
+ * Checks that the memory-capped paths are a spread-out subset of the uncapped paths that fits into the budget and does
+ * not depend on the number of threads, and that the statistics still cover all paths. The image has several blocks of
+ * rows, so that the kept paths of earlier blocks need to be thinned out.
+ */
+TEST(ScatteringLineTracingTest, SubsampledPaths) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(32);
+    volumeInfo.extinction = glm::vec3(64.0f);
+    volumeInfo.scattering_albedo = glm::vec3(0.9f);
+    volumeInfo.g = 0.2f;
+
+    ScatteringPaths pathsAll, pathsSubsampled, pathsSubsampledMultiThreaded;
+    SphericalHistogram histogramAll, histogramSubsampled;
+    const uint32_t resX = 12, resY = 80;
+    traceScatteringPaths(volumeInfo, 42, 1, pathsAll, 0, &histogramAll, resX, resY);
+    size_t maxPathMemoryBytes = pathsAll.events.get_memory_size() / 5;
+    traceScatteringPaths(
+            volumeInfo, 42, 1, pathsSubsampled, maxPathMemoryBytes, &histogramSubsampled, resX, resY);
+    traceScatteringPaths(
+            volumeInfo, 42, 4, pathsSubsampledMultiThreaded, maxPathMemoryBytes, nullptr, resX, resY);
+    volumeInfo.grid.delete_maybe();
+
+    const ScatteringEventStream& eventsAll = pathsAll.events;
+    const ScatteringEventStream& eventsSubsampled = pathsSubsampled.events;
+    size_t numPathsSubsampled = eventsSubsampled.get_num_paths();
+    EXPECT_LE(eventsSubsampled.get_memory_size() + numPathsSubsampled * sizeof(uint64_t), maxPathMemoryBytes);
+    EXPECT_GT(numPathsSubsampled * 20, eventsAll.get_num_paths());
+    EXPECT_TRUE(getPathsEqual(pathsSubsampled, pathsSubsampledMultiThreaded));
+
+    // The kept paths appear in the same order in the uncapped output.
+    size_t pathIdxAll = 0;
+    size_t numPathsInLastQuarter = 0;
+    for (size_t pathIdx = 0; pathIdx < numPathsSubsampled; pathIdx++) {
+        while (pathIdxAll < eventsAll.get_num_paths()
+                && !getPathEqual(eventsSubsampled, pathIdx, eventsAll, pathIdxAll)) {
+            pathIdxAll++;
+        }
+        ASSERT_LT(pathIdxAll, eventsAll.get_num_paths());
+        if (pathIdxAll * 4 >= eventsAll.get_num_paths() * 3) {
+            numPathsInLastQuarter++;
+        }
+        pathIdxAll++;
+    }
+    EXPECT_GT(numPathsInLastQuarter * 8, numPathsSubsampled);
+
+    EXPECT_EQ(pathsSubsampled.statistics.num_paths, pathsAll.statistics.num_paths);
+    EXPECT_EQ(pathsSubsampled.statistics.num_density_lookups, pathsAll.statistics.num_density_lookups);
+    EXPECT_EQ(pathsSubsampled.statistics.num_scattering_events, pathsAll.statistics.num_scattering_events);
+    EXPECT_EQ(histogramAll.num_directions, pathsAll.statistics.num_paths);
+    EXPECT_EQ(histogramSubsampled.counts, histogramAll.counts);
+}
+
+/**
+ * Compares the memory of one Trajectory per path (as used before the event streams) with the event stream and with a
+ * memory-capped event stream.
+ */
+TEST(ScatteringLineTracingBenchmark, DISABLED_PathMemory) {
+    VolumeInfo volumeInfo {};
+    volumeInfo.grid = createCloudGrid(64);
+    volumeInfo.extinction = glm::vec3(128.0f);
+    volumeInfo.scattering_albedo = glm::vec3(1.0f);
+    volumeInfo.g = 0.2f;
+
+    const size_t maxPathMemoryBytes = size_t(16) << 20;
+    for (int subsample = 0; subsample < 2; subsample++) {
+        ScatteringPaths paths;
+        auto startTime = std::chrono::steady_clock::now();
+        trace_scattering_paths(
+                volumeInfo, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f), 20.0f, 128, 128, 16, 7,
+                subsample ? maxPathMemoryBytes : 0, paths.events, &paths.statistics, nullptr, {});
+        auto endTime = std::chrono::steady_clock::now();
+        const ScatteringEventStream& events = paths.events;
+        if (!subsample) {
+            // Positions and one attribute per point, the vectors of each path and the exit directions.
+            size_t trajectoriesBytes =
+                    events.get_num_events() * (sizeof(glm::vec3) + sizeof(float))
+                    + events.get_num_paths() * (sizeof(Trajectory) + sizeof(std::vector<float>) + sizeof(glm::vec3));
+            std::cout << "Trajectories: " << double(trajectoriesBytes) / (1024.0 * 1024.0) << " MiB" << std::endl;
+        }
+        std::cout << (subsample ? "Capped event stream: " : "Event stream: ")
+                  << double(events.get_memory_size()) / (1024.0 * 1024.0) << " MiB, "
+                  << events.get_num_paths() << " of " << paths.statistics.num_paths << " paths in "
+                  << std::chrono::duration<double>(endTime - startTime).count() * 1e3 << "ms" << std::endl;
+    }
+    volumeInfo.grid.delete_maybe();
+}
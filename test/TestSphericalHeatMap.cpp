@@ -0,0 +1,117 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <utility>
+#include <gtest/gtest.h>
+
+#include "LineData/Scattering/SphericalHeatMap.hpp"
+
+/**
+ * Creates exit directions consisting of a forward lobe, a lobe around the pole of the Mollweide map (i.e., the y axis)
+ * and an isotropic background.
+ */
+static std::vector<glm::vec3> createExitDirections(size_t numDirections, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::normal_distribution<float> normalDistribution(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uniformDistribution(0.0f, 1.0f);
+    const glm::vec3 forwardDirection = glm::normalize(glm::vec3(0.3f, 0.5f, 0.8f));
+    const glm::vec3 poleDirection(0.0f, 1.0f, 0.0f);
+    std::vector<glm::vec3> exitDirections(numDirections);
+    for (glm::vec3& exitDirection : exitDirections) {
+        glm::vec3 offset(normalDistribution(generator), normalDistribution(generator), normalDistribution(generator));
+        float lobeSample = uniformDistribution(generator);
+        if (lobeSample < 0.5f) {
+            exitDirection = glm::normalize(forwardDirection + 0.3f * offset);
+        } else if (lobeSample < 0.7f) {
+            exitDirection = glm::normalize(poleDirection + 0.1f * offset);
+        } else {
+            exitDirection = glm::normalize(offset);
+        }
+    }
+    return exitDirections;
+}
+
+/**
+ * Compares the binned heat map with the k-d tree reference relative to the maximum value. Sparse exit directions are
+ * the worst case, as the interpolation between the bin centers flattens the peaks of isolated directions.
+ */
+TEST(SphericalHeatMapTest, BinnedMatchesKdTree) {
+    const uint32_t imageHeight = 128;
+    for (auto [numDirections, tolerance] : { std::make_pair(200, 0.05f), std::make_pair(20000, 0.01f) }) {
+        std::vector<glm::vec3> exitDirections = createExitDirections(size_t(numDirections), 3);
+        sgl::KdTree<sgl::Empty> kdTree;
+        kdTree.build(exitDirections);
+
+        std::vector<float> valuesReference, valuesBinned;
+        compute_spherical_heatmap_values_kd_tree(&kdTree, imageHeight, valuesReference);
+        compute_spherical_heatmap_values(exitDirections, imageHeight, valuesBinned);
+        ASSERT_EQ(valuesReference.size(), size_t(2 * imageHeight * imageHeight));
+        ASSERT_EQ(valuesReference.size(), valuesBinned.size());
+
+        float maxValue = 0.0f;
+        for (float value : valuesReference) {
+            maxValue = std::max(maxValue, value);
+        }
+        ASSERT_GT(maxValue, 0.0f);
+        float maxDifference = 0.0f;
+        for (size_t i = 0; i < valuesReference.size(); i++) {
+            ASSERT_EQ(valuesReference[i] == -1.0f, valuesBinned[i] == -1.0f);
+            maxDifference = std::max(maxDifference, std::abs(valuesReference[i] - valuesBinned[i]));
+        }
+        EXPECT_LT(maxDifference, tolerance * maxValue) << numDirections << " exit directions";
+    }
+}
+
+/**
+ * Times both paths on the same exit directions and prints the speedup measured in this run. The reference is the real
+ * compute_spherical_heatmap_values_kd_tree on the sgl::KdTree the renderer builds, so the ratio is only valid in a full
+ * build against sgl.
+ */
+TEST(SphericalHeatMapBenchmark, DISABLED_BinnedVsKdTree) {
+    const uint32_t imageHeight = 512;
+    std::vector<glm::vec3> exitDirections = createExitDirections(200000, 5);
+    sgl::KdTree<sgl::Empty> kdTree;
+    kdTree.build(exitDirections);
+
+    std::vector<float> values;
+    auto startTime = std::chrono::steady_clock::now();
+    compute_spherical_heatmap_values_kd_tree(&kdTree, imageHeight, values);
+    auto midTime = std::chrono::steady_clock::now();
+    compute_spherical_heatmap_values(exitDirections, imageHeight, values);
+    auto endTime = std::chrono::steady_clock::now();
+    double timeReference = std::chrono::duration<double>(midTime - startTime).count();
+    double timeBinned = std::chrono::duration<double>(endTime - midTime).count();
+    std::cout << "Spherical heat map (" << exitDirections.size() << " directions, " << 2 * imageHeight << "x"
+              << imageHeight << "): k-d tree " << timeReference * 1e3 << "ms, binned " << timeBinned * 1e3
+              << "ms, speedup " << timeReference / timeBinned << "x (valid only in a full sgl build; reference: "
+              << "compute_spherical_heatmap_values_kd_tree)" << std::endl;
+}
@@ -0,0 +1,184 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+#ifdef USE_TBB
+#include <tbb/task_arena.h>
+#elif defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineSeeder.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+#include "LineData/Flow/KdTreeForest.hpp"
+
+TEST(KdTreeForestTest, MatchesNaiveSearch) {
+    std::default_random_engine generator(12345);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    auto randomPoint = [&]() {
+        return glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    };
+
+    const float searchDistance = 0.05f;
+    KdTreeForest kdTreeForest;
+    std::vector<glm::vec3> insertedPoints;
+    for (int batchIdx = 0; batchIdx < 200; batchIdx++) {
+        // Mix small and large batches to exercise both the point buffer and the tree merging.
+        std::vector<glm::vec3> batchPoints(batchIdx % 5 == 0 ? 100 : 7);
+        for (glm::vec3& point : batchPoints) {
+            point = randomPoint();
+        }
+        kdTreeForest.addPoints(batchPoints);
+        insertedPoints.insert(insertedPoints.end(), batchPoints.begin(), batchPoints.end());
+
+        for (int queryIdx = 0; queryIdx < 16; queryIdx++) {
+            glm::vec3 queryPoint = randomPoint();
+            bool hasPointCloserThanNaive = false;
+            for (const glm::vec3& point : insertedPoints) {
+                if (glm::distance(point, queryPoint) < searchDistance) {
+                    hasPointCloserThanNaive = true;
+                    break;
+                }
+            }
+            EXPECT_EQ(hasPointCloserThanNaive, kdTreeForest.getHasPointCloserThan(queryPoint, searchDistance));
+        }
+    }
+    EXPECT_EQ(kdTreeForest.getNumPoints(), insertedPoints.size());
+    // The tree sizes decrease by more than a factor of two.
+    EXPECT_LE(kdTreeForest.getNumTrees(), size_t(std::log2(double(insertedPoints.size()))) + 1);
+}
+
+/**
+ * Measures the time needed for max. helicity first seeding on an ABC flow with each termination check type. The
+ * separation distance is chosen such that more than 10k lines are traced.
+ */
+class StreamlineSeedingBenchmark : public ::testing::TestWithParam<TerminationCheckType> {
+protected:
+    void SetUp() override {
+        tracingSettings.isAbcDataSet = true;
+        tracingSettings.abcFlowGenerator.load(tracingSettings.gridDataSetMetaData, &grid);
+        tracingSettings.flowPrimitives = FlowPrimitives::STREAMLINES;
+        tracingSettings.streamlineSeedingStrategy = StreamlineSeedingStrategy::MAX_HELICITY_FIRST;
+        tracingSettings.seeder = std::make_shared<StreamlineMaxHelicityFirstSeeder>();
+        tracingSettings.maxNumIterations = 200;
+        tracingSettings.minimumLength = 0.01f;
+        tracingSettings.minimumSeparationDistance = 0.01f;
+        tracingSettings.terminationCheckType = GetParam();
+    }
+
+    StreamlineTracingGrid grid;
+    StreamlineTracingSettings tracingSettings;
+};
+
+TEST_P(StreamlineSeedingBenchmark, DISABLED_SeedingTime) {
+    Trajectories trajectories;
+    auto startTime = std::chrono::steady_clock::now();
+    grid.traceStreamlines(tracingSettings, trajectories);
+    auto endTime = std::chrono::steady_clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    size_t numPoints = 0;
+    for (const Trajectory& trajectory : trajectories) {
+        numPoints += trajectory.positions.size();
+    }
+    EXPECT_GT(trajectories.size(), size_t(0));
+    std::cout
+            << "Max. helicity first seeding (" << TERMINATION_CHECK_TYPE_NAMES[int(GetParam())] << "): "
+            << trajectories.size() << " lines, " << numPoints << " points, " << elapsedSeconds << "s" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(TerminationCheckTypes, StreamlineSeedingBenchmark, ::testing::Values(
+        TerminationCheckType::NAIVE, TerminationCheckType::GRID_BASED,
+        TerminationCheckType::KD_TREE_BASED, TerminationCheckType::HASHED_GRID_BASED));
+
+/**
+ * Max. helicity first seeding traces the seeds of a batch concurrently against the lines committed so far. The
+ * traced lines must not depend on the batch size or on the number of threads querying the seeder concurrently.
+ */
+class StreamlineSeedingDeterminismTest : public ::testing::TestWithParam<TerminationCheckType> {
+protected:
+    Trajectories traceStreamlines(int batchSize) {
+        StreamlineTracingGrid grid;
+        StreamlineTracingSettings tracingSettings;
+        tracingSettings.isAbcDataSet = true;
+        tracingSettings.abcFlowGenerator.load(tracingSettings.gridDataSetMetaData, &grid);
+        tracingSettings.flowPrimitives = FlowPrimitives::STREAMLINES;
+        tracingSettings.streamlineSeedingStrategy = StreamlineSeedingStrategy::MAX_HELICITY_FIRST;
+        tracingSettings.seeder = std::make_shared<StreamlineMaxHelicityFirstSeeder>();
+        tracingSettings.maxNumIterations = 100;
+        tracingSettings.minimumLength = 0.01f;
+        tracingSettings.minimumSeparationDistance = 0.05f;
+        tracingSettings.terminationCheckType = GetParam();
+        tracingSettings.maxHelicityFirstBatchSize = batchSize;
+        Trajectories trajectories;
+        grid.traceStreamlines(tracingSettings, trajectories);
+        return trajectories;
+    }
+
+    static constexpr int numThreads = 8;
+};
+
+TEST_P(StreamlineSeedingDeterminismTest, ParallelMatchesSequential) {
+    Trajectories trajectoriesSequential = traceStreamlines(1);
+    Trajectories trajectoriesParallel;
+    // Use more threads than seeds per batch may need, also on machines with few cores.
+#ifdef USE_TBB
+    tbb::task_arena arena(numThreads);
+    arena.execute([&]() { trajectoriesParallel = traceStreamlines(numThreads); });
+#elif defined(_OPENMP)
+    int numThreadsOld = omp_get_max_threads();
+    omp_set_num_threads(numThreads);
+    trajectoriesParallel = traceStreamlines(numThreads);
+    omp_set_num_threads(numThreadsOld);
+#else
+    trajectoriesParallel = traceStreamlines(numThreads);
+#endif
+
+    ASSERT_GT(trajectoriesSequential.size(), size_t(1));
+    ASSERT_EQ(trajectoriesSequential.size(), trajectoriesParallel.size());
+    for (size_t lineIdx = 0; lineIdx < trajectoriesSequential.size(); lineIdx++) {
+        const Trajectory& trajectorySequential = trajectoriesSequential.at(lineIdx);
+        const Trajectory& trajectoryParallel = trajectoriesParallel.at(lineIdx);
+        ASSERT_EQ(trajectorySequential.positions.size(), trajectoryParallel.positions.size());
+        for (size_t pointIdx = 0; pointIdx < trajectorySequential.positions.size(); pointIdx++) {
+            for (int c = 0; c < 3; c++) {
+                ASSERT_EQ(trajectorySequential.positions.at(pointIdx)[c], trajectoryParallel.positions.at(pointIdx)[c]);
+            }
+        }
+        ASSERT_EQ(trajectorySequential.attributes, trajectoryParallel.attributes);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(TerminationCheckTypes, StreamlineSeedingDeterminismTest, ::testing::Values(
+        TerminationCheckType::NAIVE, TerminationCheckType::GRID_BASED,
+        TerminationCheckType::KD_TREE_BASED, TerminationCheckType::HASHED_GRID_BASED));
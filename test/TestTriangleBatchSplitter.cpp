@@ -0,0 +1,253 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <array>
+#include <limits>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "Renderers/Tubes/Tubes.hpp"
+#include "LineData/TriangleBatchSplitter.hpp"
+#include "LineTestData.hpp"
+
+/**
+ * Serial reference implementation of the midpoint split (the previous implementation of
+ * LineData::splitTriangleIndices, which walks the split tree for each triangle and appends to per-batch lists).
+ */
+static void splitTrianglesIntoBatchesSerial(
+        std::vector<uint32_t>& triangleIndices, const std::vector<TubeTriangleVertexData>& vertexDataList,
+        uint32_t numSubdivisions, std::vector<uint32_t>& numBatchIndices) {
+    glm::vec3 geometryMin(std::numeric_limits<float>::max());
+    glm::vec3 geometryMax(std::numeric_limits<float>::lowest());
+    for (const TubeTriangleVertexData& vertexData : vertexDataList) {
+        geometryMin = glm::min(geometryMin, vertexData.vertexPosition);
+        geometryMax = glm::max(geometryMax, vertexData.vertexPosition);
+    }
+
+    uint32_t numBatches = 1u << numSubdivisions;
+    std::vector<std::vector<uint32_t>> batchIndicesList(numBatches);
+    for (size_t triangleIdx = 0; triangleIdx < triangleIndices.size(); triangleIdx += 3) {
+        uint32_t idx0 = triangleIndices.at(triangleIdx);
+        uint32_t idx1 = triangleIndices.at(triangleIdx + 1);
+        uint32_t idx2 = triangleIndices.at(triangleIdx + 2);
+        glm::vec3 p0 = vertexDataList.at(idx0).vertexPosition;
+        glm::vec3 p1 = vertexDataList.at(idx1).vertexPosition;
+        glm::vec3 p2 = vertexDataList.at(idx2).vertexPosition;
+        glm::vec3 triangleCentroid = (p0 + p1 + p2) / 3.0f;
+
+        glm::vec3 regionMin = geometryMin, regionMax = geometryMax;
+        uint32_t batchIdx = 0;
+        for (uint32_t depth = 0; depth < numSubdivisions; depth++) {
+            glm::vec3 dimensions = regionMax - regionMin;
+            int axis;
+            if (dimensions.x > dimensions.y && dimensions.x > dimensions.z) {
+                axis = 0;
+            } else if (dimensions.y > dimensions.z) {
+                axis = 1;
+            } else {
+                axis = 2;
+            }
+            float splitPosition = (regionMin[axis] + regionMax[axis]) / 2.0f;
+            if (triangleCentroid[axis] <= splitPosition) {
+                regionMax[axis] = splitPosition;
+            } else {
+                regionMin[axis] = splitPosition;
+                batchIdx += 1u << (numSubdivisions - depth - 1);
+            }
+        }
+        std::vector<uint32_t>& batchIndices = batchIndicesList.at(batchIdx);
+        batchIndices.push_back(idx0);
+        batchIndices.push_back(idx1);
+        batchIndices.push_back(idx2);
+    }
+
+    triangleIndices.clear();
+    numBatchIndices.clear();
+    for (std::vector<uint32_t>& batchIndices : batchIndicesList) {
+        numBatchIndices.push_back(uint32_t(batchIndices.size()));
+        triangleIndices.insert(triangleIndices.end(), batchIndices.begin(), batchIndices.end());
+    }
+}
+
+/**
+ * Checks that the split triangles are a permutation of the input triangles, that the batch sizes add up and that the
+ * batch bounds are the bounds of the triangles of the batch.
+ */
+static void validateSplit(
+        const std::vector<uint32_t>& triangleIndicesIn, const std::vector<uint32_t>& triangleIndicesSplit,
+        const std::vector<TubeTriangleVertexData>& vertexDataList, uint32_t numSubdivisions,
+        const TubeTriangleSplitData& splitData) {
+    uint32_t numBatches = 1u << numSubdivisions;
+    ASSERT_EQ(splitData.numBatchIndices.size(), size_t(numBatches));
+    ASSERT_EQ(splitData.batchAabbMin.size(), size_t(numBatches));
+    ASSERT_EQ(splitData.batchAabbMax.size(), size_t(numBatches));
+    ASSERT_EQ(triangleIndicesIn.size(), triangleIndicesSplit.size());
+
+    size_t batchOffset = 0;
+    for (uint32_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+        uint32_t numBatchIndices = splitData.numBatchIndices.at(batchIdx);
+        ASSERT_EQ(numBatchIndices % 3, 0u);
+        if (numBatchIndices == 0) {
+            continue;
+        }
+        glm::vec3 aabbMin(std::numeric_limits<float>::max());
+        glm::vec3 aabbMax(std::numeric_limits<float>::lowest());
+        for (size_t i = batchOffset; i < batchOffset + numBatchIndices; i++) {
+            const glm::vec3& pt = vertexDataList.at(triangleIndicesSplit.at(i)).vertexPosition;
+            aabbMin = glm::min(aabbMin, pt);
+            aabbMax = glm::max(aabbMax, pt);
+        }
+        for (int i = 0; i < 3; i++) {
+            EXPECT_EQ(aabbMin[i], splitData.batchAabbMin.at(batchIdx)[i]) << "Wrong bounds of batch " << batchIdx;
+            EXPECT_EQ(aabbMax[i], splitData.batchAabbMax.at(batchIdx)[i]) << "Wrong bounds of batch " << batchIdx;
+        }
+        batchOffset += numBatchIndices;
+    }
+    ASSERT_EQ(batchOffset, triangleIndicesIn.size());
+
+    auto getSortedTriangles = [](const std::vector<uint32_t>& triangleIndices) {
+        std::vector<std::array<uint32_t, 3>> triangles(triangleIndices.size() / 3);
+        for (size_t triangleIdx = 0; triangleIdx < triangles.size(); triangleIdx++) {
+            triangles[triangleIdx] = {
+                    triangleIndices[triangleIdx * 3], triangleIndices[triangleIdx * 3 + 1],
+                    triangleIndices[triangleIdx * 3 + 2] };
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+    ASSERT_TRUE(getSortedTriangles(triangleIndicesIn) == getSortedTriangles(triangleIndicesSplit))
+            << "The split triangles are no permutation of the input triangles.";
+}
+
+TEST(TriangleBatchSplitterTest, MidpointMatchesSerial) {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(200, 100, 6, 3, triangleIndices, vertexDataList);
+    for (uint32_t numSubdivisions = 0; numSubdivisions <= 5; numSubdivisions++) {
+        std::vector<uint32_t> triangleIndicesSerial = triangleIndices;
+        std::vector<uint32_t> numBatchIndicesSerial;
+        splitTrianglesIntoBatchesSerial(triangleIndicesSerial, vertexDataList, numSubdivisions, numBatchIndicesSerial);
+
+        std::vector<uint32_t> triangleIndicesParallel = triangleIndices;
+        TubeTriangleSplitData splitData;
+        splitTrianglesIntoBatches(
+                triangleIndicesParallel, vertexDataList, numSubdivisions, TriangleSplitMode::MIDPOINT, splitData);
+
+        ASSERT_EQ(numBatchIndicesSerial, splitData.numBatchIndices);
+        ASSERT_EQ(triangleIndicesSerial, triangleIndicesParallel);
+        validateSplit(triangleIndices, triangleIndicesParallel, vertexDataList, numSubdivisions, splitData);
+    }
+}
+
+TEST(TriangleBatchSplitterTest, Sah) {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(200, 100, 6, 5, triangleIndices, vertexDataList);
+    for (uint32_t numSubdivisions = 0; numSubdivisions <= 5; numSubdivisions++) {
+        std::vector<uint32_t> triangleIndicesSplit = triangleIndices;
+        TubeTriangleSplitData splitData;
+        splitTrianglesIntoBatches(
+                triangleIndicesSplit, vertexDataList, numSubdivisions, TriangleSplitMode::SAH, splitData);
+        validateSplit(triangleIndices, triangleIndicesSplit, vertexDataList, numSubdivisions, splitData);
+    }
+}
+
+TEST(TriangleBatchSplitterTest, DegenerateInputs) {
+    for (TriangleSplitMode splitMode : { TriangleSplitMode::MIDPOINT, TriangleSplitMode::SAH }) {
+        // Empty mesh.
+        std::vector<uint32_t> triangleIndices;
+        std::vector<TubeTriangleVertexData> vertexDataList;
+        TubeTriangleSplitData splitData;
+        splitTrianglesIntoBatches(triangleIndices, vertexDataList, 2, splitMode, splitData);
+        validateSplit({}, triangleIndices, vertexDataList, 2, splitData);
+
+        // All triangles share the same centroid.
+        vertexDataList.resize(3);
+        vertexDataList[1].vertexPosition = glm::vec3(1.0f, 0.0f, 0.0f);
+        vertexDataList[2].vertexPosition = glm::vec3(0.0f, 1.0f, 0.0f);
+        for (int i = 0; i < 1000; i++) {
+            triangleIndices.push_back(0);
+            triangleIndices.push_back(1);
+            triangleIndices.push_back(2);
+        }
+        std::vector<uint32_t> triangleIndicesIn = triangleIndices;
+        splitTrianglesIntoBatches(triangleIndices, vertexDataList, 3, splitMode, splitData);
+        validateSplit(triangleIndicesIn, triangleIndices, vertexDataList, 3, splitData);
+    }
+}
+
+/**
+ * Compares the split time of the serial reference implementation with the parallel midpoint and SAH splits and prints
+ * the sum of the batch surface areas relative to the surface area of the mesh bounds.
+ */
+TEST(TriangleBatchSplitterBenchmark, DISABLED_Split) {
+    // Approximately 8M triangles.
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    createTubeMesh(2000, 250, 8, 13, triangleIndices, vertexDataList);
+    const uint32_t numSubdivisions = 4;
+    std::cout << (triangleIndices.size() / 3) << " triangles, " << (1u << numSubdivisions) << " batches" << std::endl;
+
+    {
+        std::vector<uint32_t> triangleIndicesSplit = triangleIndices;
+        std::vector<uint32_t> numBatchIndices;
+        auto startTime = std::chrono::steady_clock::now();
+        splitTrianglesIntoBatchesSerial(triangleIndicesSplit, vertexDataList, numSubdivisions, numBatchIndices);
+        auto endTime = std::chrono::steady_clock::now();
+        double elapsedMs = std::chrono::duration<double>(endTime - startTime).count() * 1e3;
+        std::cout << "Midpoint (serial): " << elapsedMs << "ms" << std::endl;
+    }
+
+    for (TriangleSplitMode splitMode : { TriangleSplitMode::MIDPOINT, TriangleSplitMode::SAH }) {
+        std::vector<uint32_t> triangleIndicesSplit = triangleIndices;
+        TubeTriangleSplitData splitData;
+        auto startTime = std::chrono::steady_clock::now();
+        splitTrianglesIntoBatches(triangleIndicesSplit, vertexDataList, numSubdivisions, splitMode, splitData);
+        auto endTime = std::chrono::steady_clock::now();
+        double elapsedMs = std::chrono::duration<double>(endTime - startTime).count() * 1e3;
+
+        glm::vec3 geometryMin(std::numeric_limits<float>::max());
+        glm::vec3 geometryMax(std::numeric_limits<float>::lowest());
+        float batchAreaSum = 0.0f;
+        uint32_t maxBatchTriangles = 0;
+        for (size_t batchIdx = 0; batchIdx < splitData.numBatchIndices.size(); batchIdx++) {
+            if (splitData.numBatchIndices.at(batchIdx) == 0) {
+                continue;
+            }
+            geometryMin = glm::min(geometryMin, splitData.batchAabbMin.at(batchIdx));
+            geometryMax = glm::max(geometryMax, splitData.batchAabbMax.at(batchIdx));
+            batchAreaSum += computeHalfArea(splitData.batchAabbMin.at(batchIdx), splitData.batchAabbMax.at(batchIdx));
+            maxBatchTriangles = std::max(maxBatchTriangles, splitData.numBatchIndices.at(batchIdx) / 3);
+        }
+        std::cout << triangleSplitModeNames[int(splitMode)] << " (parallel): " << elapsedMs
+                  << "ms, relative batch surface area " << (batchAreaSum / computeHalfArea(geometryMin, geometryMax))
+                  << ", max. batch triangles " << maxBatchTriangles << std::endl;
+    }
+}
@@ -0,0 +1,441 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <gtest/gtest.h>
+
+#include "Renderers/Tubes/Tubes.hpp"
+
+enum class TubeMesherType {
+    CIRCLE, ELLIPSE, CAPPED_CIRCLE, CAPPED_ELLIPSE
+};
+
+struct TubeMeshData {
+    std::vector<uint32_t> triangleIndices;
+    std::vector<TubeTriangleVertexData> vertexDataList;
+    std::vector<LinePointReference> linePointReferenceList;
+    std::vector<glm::vec3> lineTangents;
+    std::vector<glm::vec3> lineNormals;
+};
+
+template<class T>
+static void expectBitwiseEqual(const std::vector<T>& reference, const std::vector<T>& parallel, const char* name) {
+    ASSERT_EQ(reference.size(), parallel.size()) << "Size mismatch in " << name << ".";
+    for (size_t i = 0; i < reference.size(); i++) {
+        ASSERT_EQ(std::memcmp(&reference[i], &parallel[i], sizeof(T)), 0)
+                << "Mismatch in " << name << " at index " << i << ".";
+    }
+}
+
+/**
+ * Compares the output of the parallel two-pass tube mesher with the sequential reference implementation.
+ */
+class TubeMesherTest : public ::testing::TestWithParam<std::tuple<TubeMesherType, bool>> {
+protected:
+    /**
+     * Creates random lines including degenerate cases: empty lines, lines with a single point, lines consisting
+     * only of duplicate points and lines with duplicate points that are skipped by the mesher.
+     */
+    void createLines(size_t numLines, int maxNumLinePoints, uint32_t seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> positionDistribution(-1.0f, 1.0f);
+        std::uniform_int_distribution<int> numPointsDistribution(0, maxNumLinePoints);
+        std::uniform_int_distribution<int> caseDistribution(0, 9);
+        lineCentersList.resize(numLines);
+        lineRightVectorsList.resize(numLines);
+        for (size_t lineId = 0; lineId < numLines; lineId++) {
+            std::vector<glm::vec3>& lineCenters = lineCentersList.at(lineId);
+            std::vector<glm::vec3>& lineRightVectors = lineRightVectorsList.at(lineId);
+            int lineCase = caseDistribution(generator);
+            int numPoints = lineCase == 0 ? int(lineId % 2) : numPointsDistribution(generator);
+            glm::vec3 position(
+                    positionDistribution(generator), positionDistribution(generator),
+                    positionDistribution(generator));
+            for (int i = 0; i < numPoints; i++) {
+                if (lineCase == 1 || (lineCase == 2 && i % 3 == 1)) {
+                    // Duplicate point.
+                } else {
+                    position += 0.05f * glm::vec3(
+                            positionDistribution(generator), positionDistribution(generator),
+                            positionDistribution(generator));
+                }
+                lineCenters.push_back(position);
+                glm::vec3 rightVector(
+                        positionDistribution(generator), positionDistribution(generator),
+                        positionDistribution(generator));
+                lineRightVectors.push_back(glm::normalize(rightVector + glm::vec3(2.0f, 0.0f, 0.0f)));
+            }
+        }
+    }
+
+    static void prefill(TubeMeshData& data) {
+        // The output lists may already contain the data of other line sets.
+        data.triangleIndices.resize(9, 3u);
+        data.vertexDataList.resize(5);
+        data.vertexDataList.back().vertexLinePointIndex = 11;
+        data.linePointReferenceList.resize(4, LinePointReference(1, 2));
+        data.lineTangents.resize(4, glm::vec3(0.0f, 1.0f, 0.0f));
+        data.lineNormals.resize(4, glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    void createMesh(TubeMesherType type, bool tubeClosed, bool parallel, TubeMeshData& data) {
+        const float tubeRadius = 0.01f;
+        const float tubeNormalRadius = 0.02f;
+        const float tubeBinormalRadius = 0.005f;
+        const int numSubdivisions = 7;
+        const uint32_t linePointOffset = 13;
+        if (type == TubeMesherType::CIRCLE) {
+            auto function = parallel ? createTriangleTubesRenderDataCPUParallel : createTriangleTubesRenderDataCPU;
+            function(
+                    lineCentersList, tubeRadius, numSubdivisions, data.triangleIndices, data.vertexDataList,
+                    data.linePointReferenceList, linePointOffset, data.lineTangents, data.lineNormals);
+        } else if (type == TubeMesherType::ELLIPSE) {
+            auto function =
+                    parallel ? createTriangleEllipticTubesRenderDataCPUParallel
+                             : createTriangleEllipticTubesRenderDataCPU;
+            function(
+                    lineCentersList, lineRightVectorsList, tubeNormalRadius, tubeBinormalRadius, numSubdivisions,
+                    data.triangleIndices, data.vertexDataList, data.linePointReferenceList, linePointOffset,
+                    data.lineTangents, data.lineNormals);
+        } else if (type == TubeMesherType::CAPPED_CIRCLE) {
+            auto function =
+                    parallel ? createCappedTriangleTubesRenderDataCPUParallel
+                             : createCappedTriangleTubesRenderDataCPU;
+            function(
+                    lineCentersList, tubeRadius, numSubdivisions, tubeClosed, data.triangleIndices,
+                    data.vertexDataList, data.linePointReferenceList, linePointOffset,
+                    data.lineTangents, data.lineNormals);
+        } else {
+            auto function =
+                    parallel ? createCappedTriangleEllipticTubesRenderDataCPUParallel
+                             : createCappedTriangleEllipticTubesRenderDataCPU;
+            function(
+                    lineCentersList, lineRightVectorsList, tubeNormalRadius, tubeBinormalRadius, numSubdivisions,
+                    tubeClosed, data.triangleIndices, data.vertexDataList, data.linePointReferenceList,
+                    linePointOffset, data.lineTangents, data.lineNormals);
+        }
+    }
+
+    /**
+     * Assembles the mesh from chunks of at most maxChunkSizeInBytes bytes. The lists may be prefilled, in which case
+     * the chunks are appended the same way the monolithic functions append their output.
+     */
+    void createMeshChunked(
+            TubeMesherType type, bool tubeClosed, size_t maxChunkSizeInBytes, TubeMeshData& data,
+            size_t& numChunks) {
+        const float tubeRadius = 0.01f;
+        const float tubeNormalRadius = 0.02f;
+        const float tubeBinormalRadius = 0.005f;
+        const int numSubdivisions = 7;
+        const uint32_t linePointOffset = 13;
+        bool isElliptic = type == TubeMesherType::ELLIPSE || type == TubeMesherType::CAPPED_ELLIPSE;
+        bool hasCaps = type == TubeMesherType::CAPPED_CIRCLE || type == TubeMesherType::CAPPED_ELLIPSE;
+        size_t vertexBase = data.vertexDataList.size();
+        size_t indexBase = data.triangleIndices.size();
+        size_t linePointBase = data.linePointReferenceList.size();
+        TriangleTubeMeshChunkGenerator generator(
+                lineCentersList, isElliptic ? &lineRightVectorsList : nullptr,
+                isElliptic ? tubeNormalRadius : tubeRadius, isElliptic ? tubeBinormalRadius : tubeRadius,
+                numSubdivisions, hasCaps, tubeClosed && hasCaps, vertexBase,
+                linePointOffset + uint32_t(linePointBase), maxChunkSizeInBytes);
+        data.vertexDataList.resize(vertexBase + generator.getNumVertices());
+        data.triangleIndices.resize(indexBase + generator.getNumIndices());
+        data.linePointReferenceList.resize(linePointBase + generator.getNumLinePoints());
+        data.lineTangents.resize(linePointBase + generator.getNumLinePoints());
+        data.lineNormals.resize(linePointBase + generator.getNumLinePoints());
+        numChunks = generator.getNumChunks();
+        for (size_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++) {
+            const TubeTriangleMeshChunk& chunk = generator.generateChunk(chunkIdx);
+            size_t chunkSizeInBytes =
+                    chunk.vertexDataList.size() * sizeof(TubeTriangleVertexData)
+                    + chunk.triangleIndices.size() * sizeof(uint32_t)
+                    + chunk.linePointReferenceList.size() * (sizeof(LinePointReference) + 2 * sizeof(glm::vec3));
+            if (chunk.lineEnd - chunk.lineBegin > 1) {
+                EXPECT_LE(chunkSizeInBytes, maxChunkSizeInBytes);
+            }
+            std::copy(
+                    chunk.vertexDataList.begin(), chunk.vertexDataList.end(),
+                    data.vertexDataList.begin() + ptrdiff_t(vertexBase + chunk.vertexOffset));
+            std::copy(
+                    chunk.triangleIndices.begin(), chunk.triangleIndices.end(),
+                    data.triangleIndices.begin() + ptrdiff_t(indexBase + chunk.indexOffset));
+            std::copy(
+                    chunk.linePointReferenceList.begin(), chunk.linePointReferenceList.end(),
+                    data.linePointReferenceList.begin() + ptrdiff_t(linePointBase + chunk.linePointOffset));
+            std::copy(
+                    chunk.lineTangents.begin(), chunk.lineTangents.end(),
+                    data.lineTangents.begin() + ptrdiff_t(linePointBase + chunk.linePointOffset));
+            std::copy(
+                    chunk.lineNormals.begin(), chunk.lineNormals.end(),
+                    data.lineNormals.begin() + ptrdiff_t(linePointBase + chunk.linePointOffset));
+        }
+    }
+
+    std::vector<std::vector<glm::vec3>> lineCentersList;
+    std::vector<std::vector<glm::vec3>> lineRightVectorsList;
+};
+
+TEST_P(TubeMesherTest, ParallelMatchesSequential) {
+    TubeMesherType type = std::get<0>(GetParam());
+    bool tubeClosed = std::get<1>(GetParam());
+    createLines(2000, 40, 23);
+
+    for (bool prefillLists : { false, true }) {
+        TubeMeshData referenceData, parallelData;
+        if (prefillLists) {
+            prefill(referenceData);
+            prefill(parallelData);
+        }
+        createMesh(type, tubeClosed, false, referenceData);
+        createMesh(type, tubeClosed, true, parallelData);
+        expectBitwiseEqual(referenceData.triangleIndices, parallelData.triangleIndices, "triangleIndices");
+        expectBitwiseEqual(referenceData.vertexDataList, parallelData.vertexDataList, "vertexDataList");
+        expectBitwiseEqual(
+                referenceData.linePointReferenceList, parallelData.linePointReferenceList, "linePointReferenceList");
+        expectBitwiseEqual(referenceData.lineTangents, parallelData.lineTangents, "lineTangents");
+        expectBitwiseEqual(referenceData.lineNormals, parallelData.lineNormals, "lineNormals");
+    }
+}
+
+TEST_P(TubeMesherTest, ChunkedMatchesMonolithic) {
+    TubeMesherType type = std::get<0>(GetParam());
+    bool tubeClosed = std::get<1>(GetParam());
+    createLines(2000, 40, 29);
+
+    for (size_t maxChunkSizeInBytes : { size_t(1), size_t(64 * 1024), size_t(1024 * 1024 * 1024) }) {
+        for (bool prefillLists : { false, true }) {
+            TubeMeshData referenceData, chunkedData;
+            if (prefillLists) {
+                prefill(referenceData);
+                prefill(chunkedData);
+            }
+            size_t numChunks = 0;
+            createMesh(type, tubeClosed, true, referenceData);
+            createMeshChunked(type, tubeClosed, maxChunkSizeInBytes, chunkedData, numChunks);
+            if (maxChunkSizeInBytes < 1024 * 1024 * 1024) {
+                EXPECT_GT(numChunks, size_t(1));
+            } else {
+                EXPECT_EQ(numChunks, size_t(1));
+            }
+            expectBitwiseEqual(referenceData.triangleIndices, chunkedData.triangleIndices, "triangleIndices");
+            expectBitwiseEqual(referenceData.vertexDataList, chunkedData.vertexDataList, "vertexDataList");
+            expectBitwiseEqual(
+                    referenceData.linePointReferenceList, chunkedData.linePointReferenceList,
+                    "linePointReferenceList");
+            expectBitwiseEqual(referenceData.lineTangents, chunkedData.lineTangents, "lineTangents");
+            expectBitwiseEqual(referenceData.lineNormals, chunkedData.lineNormals, "lineNormals");
+        }
+    }
+}
+
+TEST_P(TubeMesherTest, EmptyInput) {
+    TubeMesherType type = std::get<0>(GetParam());
+    bool tubeClosed = std::get<1>(GetParam());
+    TubeMeshData data;
+    createMesh(type, tubeClosed, true, data);
+    EXPECT_TRUE(data.triangleIndices.empty());
+    EXPECT_TRUE(data.vertexDataList.empty());
+    EXPECT_TRUE(data.linePointReferenceList.empty());
+
+    size_t numChunks = 0;
+    TubeMeshData chunkedData;
+    createMeshChunked(type, tubeClosed, 1024, chunkedData, numChunks);
+    EXPECT_EQ(numChunks, size_t(0));
+    EXPECT_TRUE(chunkedData.triangleIndices.empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        TubeMesherTypes, TubeMesherTest, ::testing::Values(
+                std::make_tuple(TubeMesherType::CIRCLE, false),
+                std::make_tuple(TubeMesherType::ELLIPSE, false),
+                std::make_tuple(TubeMesherType::CAPPED_CIRCLE, false),
+                std::make_tuple(TubeMesherType::CAPPED_CIRCLE, true),
+                std::make_tuple(TubeMesherType::CAPPED_ELLIPSE, false),
+                std::make_tuple(TubeMesherType::CAPPED_ELLIPSE, true)));
+
+class TubeMesherBenchmark : public TubeMesherTest {};
+
+TEST_F(TubeMesherBenchmark, DISABLED_SequentialVsParallel) {
+    createLines(5000, 400, 5);
+    const int numIterations = 3;
+    for (TubeMesherType type : { TubeMesherType::CIRCLE, TubeMesherType::CAPPED_ELLIPSE }) {
+        double elapsedSeconds[2] = { 0.0, 0.0 };
+        for (int parallel = 0; parallel < 2; parallel++) {
+            for (int iteration = 0; iteration < numIterations; iteration++) {
+                TubeMeshData data;
+                auto startTime = std::chrono::steady_clock::now();
+                createMesh(type, false, parallel != 0, data);
+                auto endTime = std::chrono::steady_clock::now();
+                elapsedSeconds[parallel] += std::chrono::duration<double>(endTime - startTime).count();
+            }
+        }
+        const char* typeName = type == TubeMesherType::CIRCLE ? "circle" : "capped ellipse";
+        std::cout << "Tube mesher (" << typeName << ", sequential): "
+                  << elapsedSeconds[0] * 1e3 / numIterations << "ms" << std::endl;
+        std::cout << "Tube mesher (" << typeName << ", parallel): "
+                  << elapsedSeconds[1] * 1e3 / numIterations << "ms" << std::endl;
+    }
+}
+
+/**
+ * Creates a random walk with normalized tangents for testing the ring functions directly.
+ */
+static void createRingPoints(
+        size_t numPoints, uint32_t seed, std::vector<glm::vec3>& centers, std::vector<glm::vec3>& tangents,
+        std::vector<glm::vec3>& rightVectors) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    glm::vec3 position(0.0f);
+    for (size_t i = 0; i < numPoints; i++) {
+        glm::vec3 step(distribution(generator), distribution(generator), distribution(generator));
+        if (i % 17 == 5) {
+            // Tangent parallel to the last normal.
+            step = glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+        position += 0.01f * step;
+        centers.push_back(position);
+        tangents.push_back(glm::normalize(step));
+        rightVectors.push_back(glm::normalize(glm::vec3(
+                distribution(generator), distribution(generator), distribution(generator))
+                + glm::vec3(2.0f, 0.0f, 0.0f)));
+    }
+}
+
+TEST(TubeCrossSectionTest, BatchMatchesSinglePoints) {
+    std::vector<glm::vec3> centers, tangents, rightVectors;
+    createRingPoints(1000, 3, centers, tangents, rightVectors);
+    const size_t numPoints = centers.size();
+    for (int numSubdivisions : { 4, 6, 7, 8, 16, 32 }) {
+        for (bool isEllipse : { false, true }) {
+            TubeCrossSection crossSection;
+            if (isEllipse) {
+                crossSection.initEllipse(numSubdivisions, 0.02f, 0.005f);
+            } else {
+                crossSection.initCircle(numSubdivisions, 0.01f);
+            }
+            const size_t numVertices = crossSection.getNumVertices();
+            std::vector<TubeTriangleVertexData> singleVertexData(numPoints * numVertices);
+            std::vector<TubeTriangleVertexData> batchVertexData(numPoints * numVertices);
+            std::vector<glm::vec3> singleNormals(numPoints), batchNormals(numPoints);
+
+            glm::vec3 lastNormal(1.0f, 0.0f, 0.0f);
+            for (size_t i = 0; i < numPoints; i++) {
+                if (isEllipse) {
+                    singleNormals[i] = glm::cross(rightVectors[i], tangents[i]);
+                    insertOrientedEllipsePoints(
+                            crossSection, centers[i], tangents[i], singleNormals[i], uint32_t(i + 3),
+                            singleVertexData.data() + i * numVertices);
+                } else {
+                    insertOrientedCirclePoints(
+                            crossSection, centers[i], tangents[i], lastNormal, uint32_t(i + 3),
+                            singleVertexData.data() + i * numVertices);
+                    singleNormals[i] = lastNormal;
+                }
+            }
+
+            if (isEllipse) {
+                batchNormals = singleNormals;
+                insertOrientedEllipsePointsBatch(
+                        crossSection, numPoints, centers.data(), tangents.data(), batchNormals.data(), 3u,
+                        batchVertexData.data());
+            } else {
+                lastNormal = glm::vec3(1.0f, 0.0f, 0.0f);
+                insertOrientedCirclePointsBatch(
+                        crossSection, numPoints, centers.data(), tangents.data(), lastNormal, 3u,
+                        batchNormals.data(), batchVertexData.data());
+                EXPECT_EQ(std::memcmp(&lastNormal, &singleNormals.back(), sizeof(glm::vec3)), 0);
+            }
+            expectBitwiseEqual(singleNormals, batchNormals, "normals");
+            expectBitwiseEqual(singleVertexData, batchVertexData, "vertexDataList");
+
+            if (!isEllipse) {
+                // The vertex normals of circles point from the center to the vertex.
+                for (size_t i = 0; i < numPoints * numVertices; i++) {
+                    const TubeTriangleVertexData& vertex = batchVertexData[i];
+                    glm::vec3 direction = glm::normalize(vertex.vertexPosition - centers[i / numVertices]);
+                    ASSERT_NEAR(glm::length(vertex.vertexNormal), 1.0f, 1e-5f);
+                    ASSERT_NEAR(glm::dot(direction, vertex.vertexNormal), 1.0f, 1e-3f);
+                }
+            }
+        }
+    }
+}
+
+TEST(TubeCrossSectionBenchmark, DISABLED_SinglePointsVsBatch) {
+    std::vector<glm::vec3> centers, tangents, rightVectors;
+    createRingPoints(100000, 7, centers, tangents, rightVectors);
+    const size_t numPoints = centers.size();
+    const int numIterations = 5;
+    std::vector<glm::vec3> normals(numPoints);
+    for (int numSubdivisions : { 6, 8, 16, 32 }) {
+        TubeCrossSection crossSection;
+        crossSection.initCircle(numSubdivisions, 0.01f);
+        initGlobalCircleVertexPositions(numSubdivisions, 0.01f);
+        const size_t numVertices = crossSection.getNumVertices();
+        std::vector<TubeTriangleVertexData> vertexData(numPoints * numVertices);
+        double elapsedSeconds[3] = { 0.0, 0.0, 0.0 };
+        for (int iteration = 0; iteration < numIterations; iteration++) {
+            // Appending to a list one point at a time (as done by the sequential tube functions).
+            std::vector<TubeTriangleVertexData> vertexDataList;
+            glm::vec3 lastNormal(1.0f, 0.0f, 0.0f);
+            auto startTime = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < numPoints; i++) {
+                insertOrientedCirclePoints(centers[i], tangents[i], lastNormal, uint32_t(i), vertexDataList);
+            }
+            auto endTime = std::chrono::steady_clock::now();
+            elapsedSeconds[0] += std::chrono::duration<double>(endTime - startTime).count();
+
+            // Writing one point at a time into preallocated memory.
+            lastNormal = glm::vec3(1.0f, 0.0f, 0.0f);
+            startTime = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < numPoints; i++) {
+                insertOrientedCirclePoints(
+                        crossSection, centers[i], tangents[i], lastNormal, uint32_t(i),
+                        vertexData.data() + i * numVertices);
+            }
+            endTime = std::chrono::steady_clock::now();
+            elapsedSeconds[1] += std::chrono::duration<double>(endTime - startTime).count();
+
+            lastNormal = glm::vec3(1.0f, 0.0f, 0.0f);
+            startTime = std::chrono::steady_clock::now();
+            insertOrientedCirclePointsBatch(
+                    crossSection, numPoints, centers.data(), tangents.data(), lastNormal, 0u, normals.data(),
+                    vertexData.data());
+            endTime = std::chrono::steady_clock::now();
+            elapsedSeconds[2] += std::chrono::duration<double>(endTime - startTime).count();
+        }
+        std::cout << "Tube rings (" << numSubdivisions << " subdivisions): append "
+                  << elapsedSeconds[0] * 1e3 / numIterations << "ms, single points "
+                  << elapsedSeconds[1] * 1e3 / numIterations << "ms, batch "
+                  << elapsedSeconds[2] * 1e3 / numIterations << "ms" << std::endl;
+    }
+}
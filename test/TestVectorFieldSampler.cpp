@@ -0,0 +1,166 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2024, Christoph Neuhauser
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "LineData/Flow/StreamlineTracingDefines.hpp"
+#include "LineData/Flow/StreamlineSeeder.hpp"
+#include "LineData/Flow/StreamlineTracingGrid.hpp"
+#include "LineData/Flow/VectorFieldSampler.hpp"
+
+/**
+ * Trilinear interpolation with per-corner bounds checks (corners outside of the grid contribute zero). Like the
+ * previous implementation in StreamlineTracingGrid, the grid position is truncated towards zero.
+ */
+static glm::vec3 sampleReference(
+        const std::vector<float>& vectorField, int xs, int ys, int zs,
+        const glm::vec3& boxMin, const glm::vec3& spacing, const glm::vec3& position) {
+    glm::vec3 gridPositionFloat = (position - boxMin) / spacing;
+    auto gridPosition = glm::ivec3(gridPositionFloat);
+    glm::vec3 frac = gridPositionFloat - glm::floor(gridPositionFloat);
+    glm::vec3 result(0.0f);
+    for (int offsetZ = 0; offsetZ < 2; offsetZ++) {
+        for (int offsetY = 0; offsetY < 2; offsetY++) {
+            for (int offsetX = 0; offsetX < 2; offsetX++) {
+                glm::ivec3 idx = gridPosition + glm::ivec3(offsetX, offsetY, offsetZ);
+                if (idx.x < 0 || idx.y < 0 || idx.z < 0 || idx.x >= xs || idx.y >= ys || idx.z >= zs) {
+                    continue;
+                }
+                float weight =
+                        (offsetX ? frac.x : 1.0f - frac.x)
+                        * (offsetY ? frac.y : 1.0f - frac.y)
+                        * (offsetZ ? frac.z : 1.0f - frac.z);
+                size_t linearIdx = size_t(idx.x + (idx.y + idx.z * ys) * xs) * 3;
+                result += weight * glm::vec3(
+                        vectorField[linearIdx], vectorField[linearIdx + 1], vectorField[linearIdx + 2]);
+            }
+        }
+    }
+    return result;
+}
+
+TEST(VectorFieldSamplerTest, MatchesReference) {
+    const int xs = 13, ys = 7, zs = 9;
+    const glm::vec3 boxMin(-1.0f, 0.5f, 2.0f);
+    const glm::vec3 spacing(0.25f, 0.5f, 0.125f);
+    std::default_random_engine generator(4711);
+    std::uniform_real_distribution<float> valueDistribution(-1.0f, 1.0f);
+    std::vector<float> vectorField(size_t(xs) * size_t(ys) * size_t(zs) * 3);
+    for (float& value : vectorField) {
+        value = valueDistribution(generator);
+    }
+
+    VectorFieldSampler sampler;
+    sampler.setVectorField(vectorField.data(), xs, ys, zs, boxMin, spacing);
+
+    // Also sample slightly outside of the grid to test the zero border.
+    const int n = 1001;
+    glm::vec3 boxMax = boxMin + spacing * glm::vec3(xs - 1, ys - 1, zs - 1);
+    std::uniform_real_distribution<float> distX(boxMin.x - spacing.x, boxMax.x + spacing.x);
+    std::uniform_real_distribution<float> distY(boxMin.y - spacing.y, boxMax.y + spacing.y);
+    std::uniform_real_distribution<float> distZ(boxMin.z - spacing.z, boxMax.z + spacing.z);
+    std::vector<float> px(n), py(n), pz(n), vx(n), vy(n), vz(n);
+    std::vector<double> pxd(n), pyd(n), pzd(n), vxd(n), vyd(n), vzd(n);
+    for (int i = 0; i < n; i++) {
+        px[i] = distX(generator);
+        py[i] = distY(generator);
+        pz[i] = distZ(generator);
+        pxd[i] = px[i];
+        pyd[i] = py[i];
+        pzd[i] = pz[i];
+    }
+
+    for (bool forwardMode : { true, false }) {
+        float sign = forwardMode ? 1.0f : -1.0f;
+        sampler.samplePacket(px.data(), py.data(), pz.data(), vx.data(), vy.data(), vz.data(), n, forwardMode);
+        sampler.samplePacketDouble(
+                pxd.data(), pyd.data(), pzd.data(), vxd.data(), vyd.data(), vzd.data(), n, forwardMode);
+        for (int i = 0; i < n; i++) {
+            glm::vec3 position(px[i], py[i], pz[i]);
+            glm::vec3 reference =
+                    sign * sampleReference(vectorField, xs, ys, zs, boxMin, spacing, position);
+            glm::vec3 scalarValue = sampler.sample(position, forwardMode);
+            glm::dvec3 scalarValueDouble = sampler.sampleDouble(glm::dvec3(position), forwardMode);
+            for (int c = 0; c < 3; c++) {
+                EXPECT_NEAR(scalarValue[c], reference[c], 1e-5f);
+                EXPECT_NEAR(scalarValueDouble[c], double(reference[c]), 1e-5);
+            }
+            EXPECT_NEAR(vx[i], scalarValue.x, 1e-6f);
+            EXPECT_NEAR(vy[i], scalarValue.y, 1e-6f);
+            EXPECT_NEAR(vz[i], scalarValue.z, 1e-6f);
+            EXPECT_NEAR(vxd[i], scalarValueDouble.x, 1e-12);
+            EXPECT_NEAR(vyd[i], scalarValueDouble.y, 1e-12);
+            EXPECT_NEAR(vzd[i], scalarValueDouble.z, 1e-12);
+        }
+    }
+}
+
+/**
+ * Tests that tracing lines in packets gives the same results as tracing the lines one by one.
+ */
+class PacketTracingTest : public ::testing::TestWithParam<StreamlineIntegrationMethod> {
+protected:
+    void SetUp() override {
+        tracingSettings.isAbcDataSet = true;
+        tracingSettings.abcFlowGenerator.load(tracingSettings.gridDataSetMetaData, &grid);
+        tracingSettings.flowPrimitives = FlowPrimitives::STREAMLINES;
+        tracingSettings.streamlineSeedingStrategy = StreamlineSeedingStrategy::VOLUME;
+        tracingSettings.seeder = std::make_shared<StreamlineVolumeSeeder>();
+        tracingSettings.integrationMethod = GetParam();
+        tracingSettings.integrationDirection = StreamlineIntegrationDirection::BOTH;
+        tracingSettings.numPrimitives = 100;
+        tracingSettings.maxNumIterations = 500;
+    }
+
+    StreamlineTracingGrid grid;
+    StreamlineTracingSettings tracingSettings;
+};
+
+TEST_P(PacketTracingTest, MatchesScalarTracing) {
+    Trajectories trajectoriesScalar, trajectoriesPacket;
+    tracingSettings.usePacketTracing = false;
+    grid.traceStreamlines(tracingSettings, trajectoriesScalar);
+    tracingSettings.usePacketTracing = true;
+    grid.traceStreamlines(tracingSettings, trajectoriesPacket);
+
+    ASSERT_EQ(trajectoriesScalar.size(), trajectoriesPacket.size());
+    for (size_t lineIdx = 0; lineIdx < trajectoriesScalar.size(); lineIdx++) {
+        const Trajectory& trajectoryScalar = trajectoriesScalar.at(lineIdx);
+        const Trajectory& trajectoryPacket = trajectoriesPacket.at(lineIdx);
+        ASSERT_EQ(trajectoryScalar.positions.size(), trajectoryPacket.positions.size());
+        ASSERT_EQ(trajectoryScalar.attributes.size(), trajectoryPacket.attributes.size());
+        for (size_t i = 0; i < trajectoryScalar.positions.size(); i++) {
+            EXPECT_LT(glm::distance(trajectoryScalar.positions.at(i), trajectoryPacket.positions.at(i)), 1e-3f);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(IntegrationMethods, PacketTracingTest, ::testing::Values(
+        StreamlineIntegrationMethod::RK4, StreamlineIntegrationMethod::RKF45));